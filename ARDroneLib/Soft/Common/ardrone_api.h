@@ -393,6 +393,29 @@ typedef struct _navdata_unpacked_t
 
 } navdata_unpacked_t;
 
+/**
+ * @struct _navdata_option_decoder_t
+ * @brief Where an option is stored inside navdata_unpacked_t.
+ * ardrone_navdata_decoders is generated from navdata_keys.h and indexed by tag.
+ */
+typedef struct _navdata_option_decoder_t
+{
+  uint32_t  offset;   /*! offset of the option structure in navdata_unpacked_t */
+  uint32_t  size;     /*! size of the option structure */
+} navdata_option_decoder_t;
+
+extern const navdata_option_decoder_t ardrone_navdata_decoders[NAVDATA_NUM_TAGS];
+
+/**
+ * @def ARDRONE_NAVDATA_UNPACK_MASK
+ * @brief Options unpacked by the ARDroneTool navdata thread.
+ * Applications reading only a few options may define it at build time, e.g.
+ * -DARDRONE_NAVDATA_UNPACK_MASK="(NAVDATA_OPTION_MASK(NAVDATA_DEMO_TAG)|NAVDATA_OPTION_MASK(NAVDATA_TIME_TAG))"
+ */
+#ifndef ARDRONE_NAVDATA_UNPACK_MASK
+#define ARDRONE_NAVDATA_UNPACK_MASK NAVDATA_OPTION_FULL_MASK
+#endif
+
 /**
  * @def ardrone_navdata_pack
  * @brief Add an 'option' to the navdata network packet to be sent to a client.
@@ -466,6 +489,16 @@ uint32_t ardrone_navdata_compute_cks( uint8_t* nv, int32_t size ) API_WEAK;
  */
 C_RESULT ardrone_navdata_unpack_all(navdata_unpacked_t* navdata_unpacked, navdata_t* navdata, uint32_t* cks) API_WEAK;
 
+/**
+ * @param navdata_unpacked  navdata_unpacked in which to store the navdata.
+ * @param navdata One packet read from the port NAVDATA.
+ * @param Checksum of navdata
+ * @param options_mask Options to copy (NAVDATA_OPTION_MASK of their tags).
+ * @brief Same as ardrone_navdata_unpack_all, but only the options in options_mask are cleared
+ * and copied, and flagged in last_navdata_refresh. Other options are left untouched.
+ */
+C_RESULT ardrone_navdata_unpack_masked(navdata_unpacked_t* navdata_unpacked, navdata_t* navdata, uint32_t* cks, uint32_t options_mask) API_WEAK;
+
 /***
  * @param navdata_options_ptr
  * @param Tag ID of the bloc to search for.
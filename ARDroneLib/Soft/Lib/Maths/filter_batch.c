@@ -0,0 +1,172 @@
+/**
+ *  \file     filter_batch.c
+ *  \brief    Same digital filter applied to N independent signals
+ *  \version  1.0
+ */
+
+#include <VP_Os/vp_os_malloc.h>
+
+#include <Maths/filter_batch.h>
+#include <Maths/matrices_batch.h>
+
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__) && !defined(NO_MATHS_SIMD)
+# define MATHS_SIMD_X86
+# include <immintrin.h>
+#endif
+
+// Signals [first, last) of the batch. The value of delay ii is in slot (head + ii - 1) % n of the rings.
+typedef uint32_t (*filter_batch_kernel_t)(const filter_batch_t *f, const float32_t *b, const float32_t *a,
+                                          const float32_t *input, float32_t *output, uint32_t first, uint32_t last);
+
+static uint32_t filter_batch_c(const filter_batch_t *f, const float32_t *b, const float32_t *a,
+                               const float32_t *input, float32_t *output, uint32_t first, uint32_t last)
+{
+  uint32_t n = f->order, stride = f->stride;
+  uint32_t next = (f->head + n - 1) % n;
+  uint32_t ii, k, slot;
+
+  for (k = first; k < last; k++)
+  {
+    float32_t in = input[k];
+    float32_t inno, past, out;
+
+    // innovation computation
+    inno = b[0] * in;
+    for (ii = 1, slot = f->head; ii < n + 1; ii++, slot = (slot + 1 == n) ? 0 : slot + 1)
+      inno += b[ii] * f->old_inputs[slot * stride + k];
+
+    // past computation
+    past = 0.0f;
+    for (ii = 1, slot = f->head; ii < n + 1; ii++, slot = (slot + 1 == n) ? 0 : slot + 1)
+      past -= a[ii] * f->old_outputs[slot * stride + k];
+
+    out = inno + past;
+
+    // the oldest values are replaced
+    f->old_inputs[next * stride + k]  = in;
+    f->old_outputs[next * stride + k] = out;
+    output[k] = out;
+  }
+
+  return last;
+}
+
+#ifdef MATHS_SIMD_X86
+
+static __attribute__((target("sse"))) uint32_t filter_batch_sse(const filter_batch_t *f, const float32_t *b, const float32_t *a,
+                                                                 const float32_t *input, float32_t *output, uint32_t first, uint32_t last)
+{
+  uint32_t n = f->order, stride = f->stride;
+  uint32_t next = (f->head + n - 1) % n;
+  uint32_t ii, k, slot;
+
+  for (k = first; k + 4 <= last; k += 4)
+  {
+    __m128 in = _mm_loadu_ps(input + k);
+    __m128 inno, past, out;
+
+    inno = _mm_mul_ps(_mm_set1_ps(b[0]), in);
+    for (ii = 1, slot = f->head; ii < n + 1; ii++, slot = (slot + 1 == n) ? 0 : slot + 1)
+      inno = _mm_add_ps(inno, _mm_mul_ps(_mm_set1_ps(b[ii]), _mm_load_ps(f->old_inputs + slot * stride + k)));
+
+    past = _mm_setzero_ps();
+    for (ii = 1, slot = f->head; ii < n + 1; ii++, slot = (slot + 1 == n) ? 0 : slot + 1)
+      past = _mm_sub_ps(past, _mm_mul_ps(_mm_set1_ps(a[ii]), _mm_load_ps(f->old_outputs + slot * stride + k)));
+
+    out = _mm_add_ps(inno, past);
+
+    _mm_store_ps(f->old_inputs + next * stride + k, in);
+    _mm_store_ps(f->old_outputs + next * stride + k, out);
+    _mm_storeu_ps(output + k, out);
+  }
+
+  return k;
+}
+
+static __attribute__((target("avx"))) uint32_t filter_batch_avx(const filter_batch_t *f, const float32_t *b, const float32_t *a,
+                                                                 const float32_t *input, float32_t *output, uint32_t first, uint32_t last)
+{
+  uint32_t n = f->order, stride = f->stride;
+  uint32_t next = (f->head + n - 1) % n;
+  uint32_t ii, k, slot;
+
+  for (k = first; k + 8 <= last; k += 8)
+  {
+    __m256 in = _mm256_loadu_ps(input + k);
+    __m256 inno, past, out;
+
+    inno = _mm256_mul_ps(_mm256_set1_ps(b[0]), in);
+    for (ii = 1, slot = f->head; ii < n + 1; ii++, slot = (slot + 1 == n) ? 0 : slot + 1)
+      inno = _mm256_add_ps(inno, _mm256_mul_ps(_mm256_set1_ps(b[ii]), _mm256_load_ps(f->old_inputs + slot * stride + k)));
+
+    past = _mm256_setzero_ps();
+    for (ii = 1, slot = f->head; ii < n + 1; ii++, slot = (slot + 1 == n) ? 0 : slot + 1)
+      past = _mm256_sub_ps(past, _mm256_mul_ps(_mm256_set1_ps(a[ii]), _mm256_load_ps(f->old_outputs + slot * stride + k)));
+
+    out = _mm256_add_ps(inno, past);
+
+    _mm256_store_ps(f->old_inputs + next * stride + k, in);
+    _mm256_store_ps(f->old_outputs + next * stride + k, out);
+    _mm256_storeu_ps(output + k, out);
+  }
+
+  return k;
+}
+
+#endif // MATHS_SIMD_X86
+
+C_RESULT filter_batch_init(filter_batch_t *f, uint32_t n, uint32_t count, const float32_t *initial_inputs, const float32_t *initial_outputs)
+{
+  uint32_t ii, k;
+
+  f->order  = n;
+  f->count  = count;
+  f->stride = (count + MATRIX_BATCH_LANES - 1) & ~(MATRIX_BATCH_LANES - 1);
+  f->head   = 0;
+
+  f->old_inputs  = (float32_t *) vp_os_aligned_malloc(n * f->stride * sizeof(float32_t), MATRIX_BATCH_ALIGN);
+  f->old_outputs = (float32_t *) vp_os_aligned_malloc(n * f->stride * sizeof(float32_t), MATRIX_BATCH_ALIGN);
+  if (f->old_inputs == NULL || f->old_outputs == NULL)
+  {
+    filter_batch_free(f);
+    return C_FAIL;
+  }
+
+  for (ii = 0; ii < n; ii++)
+  {
+    for (k = 0; k < f->stride; k++)
+    {
+      f->old_inputs[ii * f->stride + k]  = (initial_inputs != NULL && k < count) ? initial_inputs[k] : 0.0f;
+      f->old_outputs[ii * f->stride + k] = (initial_outputs != NULL && k < count) ? initial_outputs[k] : 0.0f;
+    }
+  }
+
+  return C_OK;
+}
+
+void filter_batch_free(filter_batch_t *f)
+{
+  if (f->old_inputs != NULL)
+    vp_os_aligned_free(f->old_inputs);
+  if (f->old_outputs != NULL)
+    vp_os_aligned_free(f->old_outputs);
+
+  f->old_inputs  = NULL;
+  f->old_outputs = NULL;
+}
+
+void filter_batch(filter_batch_t *f, const float32_t *b, const float32_t *a, const float32_t *input, float32_t *output)
+{
+  uint32_t k = 0;
+
+  switch (maths_simd_level_get())
+  {
+#ifdef MATHS_SIMD_X86
+    case MATHS_SIMD_AVX: k = filter_batch_avx(f, b, a, input, output, 0, f->count); // fall through, the end with SSE
+    case MATHS_SIMD_SSE: k = filter_batch_sse(f, b, a, input, output, k, f->count);
+#endif
+    default:             filter_batch_c(f, b, a, input, output, k, f->count);
+  }
+
+  f->head = (f->head + f->order - 1) % f->order;
+}
@@ -0,0 +1,42 @@
+/**
+ *  \file     filter_batch.h
+ *  \brief    Same digital filter applied to N independent signals
+ *  \version  1.0
+ *
+ *  The N signals are filtered together with SSE or AVX (see maths_simd_level_set).
+ *  The histories are ring buffers : a new sample overwrites the oldest one
+ *  instead of shifting the others. Outputs are the same as filter().
+ */
+
+#ifndef _FILTER_BATCH_H_
+#define _FILTER_BATCH_H_
+
+#include <VP_Os/vp_os_types.h>
+#include <Maths/filter.h>
+
+typedef struct _filter_batch_t
+{
+  uint32_t  order;
+  uint32_t  count;          // signals
+  uint32_t  stride;         // count rounded up to MATRIX_BATCH_LANES
+  uint32_t  head;           // x(n-1) of signal k is old_inputs[head * stride + k]
+  float32_t *old_inputs;    // order x stride ring of input history
+  float32_t *old_outputs;   // order x stride ring of output history
+} filter_batch_t;
+
+/**
+ * \fn      Batch filter initialization.
+ * \param   initial_inputs, initial_outputs : one value per signal, NULL for 0.
+ * \return  C_FAIL if the history can't be allocated.
+ */
+C_RESULT filter_batch_init(filter_batch_t *f, uint32_t n, uint32_t count, const float32_t *initial_inputs, const float32_t *initial_outputs);
+void filter_batch_free(filter_batch_t *f);
+
+/**
+ * \fn      Filters one value of each signal.
+ * \brief   Same coefficients as filter(), a[0] is assumed to be 1.
+ * \param   input, output : count values. output can be input.
+ */
+void filter_batch(filter_batch_t *f, const float32_t *b, const float32_t *a, const float32_t *input, float32_t *output);
+
+#endif // _FILTER_BATCH_H_
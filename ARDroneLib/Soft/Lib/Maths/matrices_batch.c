@@ -0,0 +1,489 @@
+/**
+ *  \file     matrices_batch.c
+ *  \brief    Small matrices of N independent instances, computed together
+ *  \version  1.0
+ *
+ *  Every level computes the same operations in the same order, so that
+ *  the results do not depend on the instruction set.
+ */
+
+#include <VP_Os/vp_os_assert.h>
+#include <VP_Os/vp_os_malloc.h>
+
+#include <Maths/matrices_batch.h>
+#include <Maths/maths.h>
+
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__) && !defined(NO_MATHS_SIMD)
+# define MATHS_SIMD_X86
+# include <immintrin.h>
+#endif
+
+#define MATRIX_BATCH_INV_SIZE (MATRIX_BATCH_MAX_INV * MATRIX_BATCH_MAX_INV)
+
+typedef void (*matrix_batch_mul_kernel_t)(float32_t *out, const float32_t *m1, const float32_t *m2,
+                                          uint32_t rows, uint32_t inner, uint32_t cols,
+                                          uint32_t m2_row_step, uint32_t m2_col_step, uint32_t stride);
+typedef void (*matrix_batch_add_kernel_t)(float32_t *out, const float32_t *m1, const float32_t *m2, uint32_t size, bool_t sub);
+typedef void (*matrix_batch_inv_kernel_t)(float32_t *out, const float32_t *m1, uint32_t n, uint32_t stride);
+
+/******************************************************************************/
+/* Scalar kernels                                                             */
+/******************************************************************************/
+
+// Element (k, j) of m2 is m2[(k * m2_row_step + j * m2_col_step) * stride], so that m2 can be read transposed
+static void matrix_batch_mul_c(float32_t *out, const float32_t *m1, const float32_t *m2,
+                               uint32_t rows, uint32_t inner, uint32_t cols,
+                               uint32_t m2_row_step, uint32_t m2_col_step, uint32_t stride)
+{
+  uint32_t i, j, k, l;
+
+  for (i = 0; i < rows; i++)
+  {
+    for (j = 0; j < cols; j++)
+    {
+      float32_t *o = out + (i * cols + j) * stride;
+
+      for (l = 0; l < stride; l++)
+        o[l] = 0.0f;
+
+      for (k = 0; k < inner; k++)
+      {
+        const float32_t *a = m1 + (i * inner + k) * stride;
+        const float32_t *b = m2 + (k * m2_row_step + j * m2_col_step) * stride;
+
+        for (l = 0; l < stride; l++)
+          o[l] += a[l] * b[l];
+      }
+    }
+  }
+}
+
+static void matrix_batch_add_c(float32_t *out, const float32_t *m1, const float32_t *m2, uint32_t size, bool_t sub)
+{
+  uint32_t i;
+
+  if (sub)
+  {
+    for (i = 0; i < size; i++)
+      out[i] = m1[i] - m2[i];
+  }
+  else
+  {
+    for (i = 0; i < size; i++)
+      out[i] = m1[i] + m2[i];
+  }
+}
+
+static void matrix_batch_inv_c(float32_t *out, const float32_t *m1, uint32_t n, uint32_t stride)
+{
+  float32_t a[MATRIX_BATCH_INV_SIZE], inv[MATRIX_BATCH_INV_SIZE];
+  uint32_t l, p, q, c;
+
+  for (l = 0; l < stride; l++)
+  {
+    bool_t singular = FALSE;
+
+    for (c = 0; c < n * n; c++)
+    {
+      a[c]   = m1[c * stride + l];
+      inv[c] = (c % (n + 1) == 0) ? 1.0f : 0.0f;
+    }
+
+    for (p = 0; p < n; p++)
+    {
+      float32_t r;
+
+      if (fabsf(a[p * n + p]) < FLT_EPSILON)
+        singular = TRUE;
+      r = 1.0f / a[p * n + p];
+
+      for (c = p + 1; c < n; c++)
+        a[p * n + c] *= r;
+      for (c = 0; c < n; c++)
+        inv[p * n + c] *= r;
+
+      for (q = 0; q < n; q++)
+      {
+        float32_t f = a[q * n + p];
+
+        if (q == p)
+          continue;
+
+        for (c = p + 1; c < n; c++)
+          a[q * n + c] -= f * a[p * n + c];
+        for (c = 0; c < n; c++)
+          inv[q * n + c] -= f * inv[p * n + c];
+      }
+    }
+
+    for (c = 0; c < n * n; c++)
+      out[c * stride + l] = singular ? 0.0f : inv[c];
+  }
+}
+
+#ifdef MATHS_SIMD_X86
+
+/******************************************************************************/
+/* SSE kernels, 4 instances at a time                                         */
+/******************************************************************************/
+
+static __attribute__((target("sse"))) void matrix_batch_mul_sse(float32_t *out, const float32_t *m1, const float32_t *m2,
+                                                                 uint32_t rows, uint32_t inner, uint32_t cols,
+                                                                 uint32_t m2_row_step, uint32_t m2_col_step, uint32_t stride)
+{
+  uint32_t i, j, k, l;
+
+  for (i = 0; i < rows; i++)
+  {
+    for (j = 0; j < cols; j++)
+    {
+      float32_t *o = out + (i * cols + j) * stride;
+
+      for (l = 0; l < stride; l += 4)
+      {
+        __m128 acc = _mm_setzero_ps();
+
+        for (k = 0; k < inner; k++)
+        {
+          __m128 a = _mm_load_ps(m1 + (i * inner + k) * stride + l);
+          __m128 b = _mm_load_ps(m2 + (k * m2_row_step + j * m2_col_step) * stride + l);
+          acc = _mm_add_ps(acc, _mm_mul_ps(a, b));
+        }
+        _mm_store_ps(o + l, acc);
+      }
+    }
+  }
+}
+
+static __attribute__((target("sse"))) void matrix_batch_add_sse(float32_t *out, const float32_t *m1, const float32_t *m2, uint32_t size, bool_t sub)
+{
+  uint32_t i;
+
+  for (i = 0; i < size; i += 4)
+  {
+    __m128 a = _mm_load_ps(m1 + i);
+    __m128 b = _mm_load_ps(m2 + i);
+    _mm_store_ps(out + i, sub ? _mm_sub_ps(a, b) : _mm_add_ps(a, b));
+  }
+}
+
+static __attribute__((target("sse"))) void matrix_batch_inv_sse(float32_t *out, const float32_t *m1, uint32_t n, uint32_t stride)
+{
+  __m128 a[MATRIX_BATCH_INV_SIZE], inv[MATRIX_BATCH_INV_SIZE];
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  const __m128 epsilon = _mm_set1_ps(FLT_EPSILON);
+  const __m128 one = _mm_set1_ps(1.0f);
+  uint32_t l, p, q, c;
+
+  for (l = 0; l < stride; l += 4)
+  {
+    __m128 singular = _mm_setzero_ps();
+
+    for (c = 0; c < n * n; c++)
+    {
+      a[c]   = _mm_load_ps(m1 + c * stride + l);
+      inv[c] = (c % (n + 1) == 0) ? one : _mm_setzero_ps();
+    }
+
+    for (p = 0; p < n; p++)
+    {
+      __m128 pivot = a[p * n + p];
+      __m128 r;
+
+      singular = _mm_or_ps(singular, _mm_cmplt_ps(_mm_andnot_ps(sign, pivot), epsilon));
+      r = _mm_div_ps(one, pivot);
+
+      for (c = p + 1; c < n; c++)
+        a[p * n + c] = _mm_mul_ps(a[p * n + c], r);
+      for (c = 0; c < n; c++)
+        inv[p * n + c] = _mm_mul_ps(inv[p * n + c], r);
+
+      for (q = 0; q < n; q++)
+      {
+        __m128 f = a[q * n + p];
+
+        if (q == p)
+          continue;
+
+        for (c = p + 1; c < n; c++)
+          a[q * n + c] = _mm_sub_ps(a[q * n + c], _mm_mul_ps(f, a[p * n + c]));
+        for (c = 0; c < n; c++)
+          inv[q * n + c] = _mm_sub_ps(inv[q * n + c], _mm_mul_ps(f, inv[p * n + c]));
+      }
+    }
+
+    for (c = 0; c < n * n; c++)
+      _mm_store_ps(out + c * stride + l, _mm_andnot_ps(singular, inv[c]));
+  }
+}
+
+/******************************************************************************/
+/* AVX kernels, 8 instances at a time                                         */
+/******************************************************************************/
+
+static __attribute__((target("avx"))) void matrix_batch_mul_avx(float32_t *out, const float32_t *m1, const float32_t *m2,
+                                                                 uint32_t rows, uint32_t inner, uint32_t cols,
+                                                                 uint32_t m2_row_step, uint32_t m2_col_step, uint32_t stride)
+{
+  uint32_t i, j, k, l;
+
+  for (i = 0; i < rows; i++)
+  {
+    for (j = 0; j < cols; j++)
+    {
+      float32_t *o = out + (i * cols + j) * stride;
+
+      for (l = 0; l < stride; l += 8)
+      {
+        __m256 acc = _mm256_setzero_ps();
+
+        for (k = 0; k < inner; k++)
+        {
+          __m256 a = _mm256_load_ps(m1 + (i * inner + k) * stride + l);
+          __m256 b = _mm256_load_ps(m2 + (k * m2_row_step + j * m2_col_step) * stride + l);
+          acc = _mm256_add_ps(acc, _mm256_mul_ps(a, b));
+        }
+        _mm256_store_ps(o + l, acc);
+      }
+    }
+  }
+}
+
+static __attribute__((target("avx"))) void matrix_batch_add_avx(float32_t *out, const float32_t *m1, const float32_t *m2, uint32_t size, bool_t sub)
+{
+  uint32_t i;
+
+  for (i = 0; i < size; i += 8)
+  {
+    __m256 a = _mm256_load_ps(m1 + i);
+    __m256 b = _mm256_load_ps(m2 + i);
+    _mm256_store_ps(out + i, sub ? _mm256_sub_ps(a, b) : _mm256_add_ps(a, b));
+  }
+}
+
+static __attribute__((target("avx"))) void matrix_batch_inv_avx(float32_t *out, const float32_t *m1, uint32_t n, uint32_t stride)
+{
+  __m256 a[MATRIX_BATCH_INV_SIZE], inv[MATRIX_BATCH_INV_SIZE];
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256 epsilon = _mm256_set1_ps(FLT_EPSILON);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  uint32_t l, p, q, c;
+
+  for (l = 0; l < stride; l += 8)
+  {
+    __m256 singular = _mm256_setzero_ps();
+
+    for (c = 0; c < n * n; c++)
+    {
+      a[c]   = _mm256_load_ps(m1 + c * stride + l);
+      inv[c] = (c % (n + 1) == 0) ? one : _mm256_setzero_ps();
+    }
+
+    for (p = 0; p < n; p++)
+    {
+      __m256 pivot = a[p * n + p];
+      __m256 r;
+
+      singular = _mm256_or_ps(singular, _mm256_cmp_ps(_mm256_andnot_ps(sign, pivot), epsilon, _CMP_LT_OQ));
+      r = _mm256_div_ps(one, pivot);
+
+      for (c = p + 1; c < n; c++)
+        a[p * n + c] = _mm256_mul_ps(a[p * n + c], r);
+      for (c = 0; c < n; c++)
+        inv[p * n + c] = _mm256_mul_ps(inv[p * n + c], r);
+
+      for (q = 0; q < n; q++)
+      {
+        __m256 f = a[q * n + p];
+
+        if (q == p)
+          continue;
+
+        for (c = p + 1; c < n; c++)
+          a[q * n + c] = _mm256_sub_ps(a[q * n + c], _mm256_mul_ps(f, a[p * n + c]));
+        for (c = 0; c < n; c++)
+          inv[q * n + c] = _mm256_sub_ps(inv[q * n + c], _mm256_mul_ps(f, inv[p * n + c]));
+      }
+    }
+
+    for (c = 0; c < n * n; c++)
+      _mm256_store_ps(out + c * stride + l, _mm256_andnot_ps(singular, inv[c]));
+  }
+}
+
+#endif // MATHS_SIMD_X86
+
+/******************************************************************************/
+/* Dispatch                                                                   */
+/******************************************************************************/
+
+static int32_t maths_simd_level = -1;
+
+static MATHS_SIMD_LEVEL maths_simd_supported(void)
+{
+#ifdef MATHS_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx"))
+    return MATHS_SIMD_AVX;
+  if (__builtin_cpu_supports("sse"))
+    return MATHS_SIMD_SSE;
+#endif
+  return MATHS_SIMD_NONE;
+}
+
+MATHS_SIMD_LEVEL maths_simd_level_set(MATHS_SIMD_LEVEL level)
+{
+  MATHS_SIMD_LEVEL supported = maths_simd_supported();
+
+  maths_simd_level = (level > supported) ? supported : level;
+
+  return (MATHS_SIMD_LEVEL) maths_simd_level;
+}
+
+MATHS_SIMD_LEVEL maths_simd_level_get(void)
+{
+  if (maths_simd_level < 0)
+    maths_simd_level_set(MATHS_SIMD_BEST);
+
+  return (MATHS_SIMD_LEVEL) maths_simd_level;
+}
+
+static matrix_batch_mul_kernel_t matrix_batch_mul_kernel(void)
+{
+  switch (maths_simd_level_get())
+  {
+#ifdef MATHS_SIMD_X86
+    case MATHS_SIMD_AVX: return matrix_batch_mul_avx;
+    case MATHS_SIMD_SSE: return matrix_batch_mul_sse;
+#endif
+    default:             return matrix_batch_mul_c;
+  }
+}
+
+static matrix_batch_add_kernel_t matrix_batch_add_kernel(void)
+{
+  switch (maths_simd_level_get())
+  {
+#ifdef MATHS_SIMD_X86
+    case MATHS_SIMD_AVX: return matrix_batch_add_avx;
+    case MATHS_SIMD_SSE: return matrix_batch_add_sse;
+#endif
+    default:             return matrix_batch_add_c;
+  }
+}
+
+static matrix_batch_inv_kernel_t matrix_batch_inv_kernel(void)
+{
+  switch (maths_simd_level_get())
+  {
+#ifdef MATHS_SIMD_X86
+    case MATHS_SIMD_AVX: return matrix_batch_inv_avx;
+    case MATHS_SIMD_SSE: return matrix_batch_inv_sse;
+#endif
+    default:             return matrix_batch_inv_c;
+  }
+}
+
+/******************************************************************************/
+/* Batches                                                                    */
+/******************************************************************************/
+
+C_RESULT matrix_batch_alloc(matrix_batch_t *mb, uint32_t rows, uint32_t cols, uint32_t count)
+{
+  uint32_t size;
+
+  mb->rows   = rows;
+  mb->cols   = cols;
+  mb->count  = count;
+  mb->stride = (count + MATRIX_BATCH_LANES - 1) & ~(MATRIX_BATCH_LANES - 1);
+
+  size = rows * cols * mb->stride * sizeof(float32_t);
+  mb->data = (float32_t *) vp_os_aligned_malloc(size, MATRIX_BATCH_ALIGN);
+  if (mb->data == NULL)
+    return C_FAIL;
+
+  vp_os_memset(mb->data, 0, size);
+
+  return C_OK;
+}
+
+void matrix_batch_free(matrix_batch_t *mb)
+{
+  if (mb->data != NULL)
+    vp_os_aligned_free(mb->data);
+  mb->data = NULL;
+}
+
+void matrix_batch_set(matrix_batch_t *mb, uint32_t k, const float32_t *m)
+{
+  uint32_t i;
+
+  VP_OS_ASSERT(k < mb->count);
+
+  for (i = 0; i < mb->rows * mb->cols; i++)
+    mb->data[i * mb->stride + k] = m[i];
+}
+
+void matrix_batch_get(const matrix_batch_t *mb, uint32_t k, float32_t *m)
+{
+  uint32_t i;
+
+  VP_OS_ASSERT(k < mb->count);
+
+  for (i = 0; i < mb->rows * mb->cols; i++)
+    m[i] = mb->data[i * mb->stride + k];
+}
+
+void matrix_batch_fill(matrix_batch_t *mb, const float32_t *m)
+{
+  uint32_t i, k;
+
+  for (i = 0; i < mb->rows * mb->cols; i++)
+  {
+    for (k = 0; k < mb->stride; k++)
+      mb->data[i * mb->stride + k] = m[i];
+  }
+}
+
+void matrix_batch_mul(matrix_batch_t *out, const matrix_batch_t *m1, const matrix_batch_t *m2)
+{
+  /// You can't have output & input pointing to the same location
+  VP_OS_ASSERT(out != m1 && out != m2);
+  VP_OS_ASSERT(m1->cols == m2->rows && out->rows == m1->rows && out->cols == m2->cols);
+  VP_OS_ASSERT(m1->stride == m2->stride && out->stride == m1->stride);
+
+  matrix_batch_mul_kernel()(out->data, m1->data, m2->data, m1->rows, m1->cols, m2->cols, m2->cols, 1, m1->stride);
+}
+
+void matrix_batch_mul_transpose(matrix_batch_t *out, const matrix_batch_t *m1, const matrix_batch_t *m2)
+{
+  VP_OS_ASSERT(out != m1 && out != m2);
+  VP_OS_ASSERT(m1->cols == m2->cols && out->rows == m1->rows && out->cols == m2->rows);
+  VP_OS_ASSERT(m1->stride == m2->stride && out->stride == m1->stride);
+
+  matrix_batch_mul_kernel()(out->data, m1->data, m2->data, m1->rows, m1->cols, m2->rows, 1, m2->cols, m1->stride);
+}
+
+void matrix_batch_add(matrix_batch_t *out, const matrix_batch_t *m1, const matrix_batch_t *m2)
+{
+  VP_OS_ASSERT(m1->rows == m2->rows && m1->cols == m2->cols && out->rows == m1->rows && out->cols == m1->cols);
+  VP_OS_ASSERT(m1->stride == m2->stride && out->stride == m1->stride);
+
+  matrix_batch_add_kernel()(out->data, m1->data, m2->data, m1->rows * m1->cols * m1->stride, FALSE);
+}
+
+void matrix_batch_sub(matrix_batch_t *out, const matrix_batch_t *m1, const matrix_batch_t *m2)
+{
+  VP_OS_ASSERT(m1->rows == m2->rows && m1->cols == m2->cols && out->rows == m1->rows && out->cols == m1->cols);
+  VP_OS_ASSERT(m1->stride == m2->stride && out->stride == m1->stride);
+
+  matrix_batch_add_kernel()(out->data, m1->data, m2->data, m1->rows * m1->cols * m1->stride, TRUE);
+}
+
+void matrix_batch_inv(matrix_batch_t *out, const matrix_batch_t *m1)
+{
+  VP_OS_ASSERT(m1->rows == m1->cols && m1->rows <= MATRIX_BATCH_MAX_INV);
+  VP_OS_ASSERT(out->rows == m1->rows && out->cols == m1->cols && out->stride == m1->stride);
+
+  matrix_batch_inv_kernel()(out->data, m1->data, m1->rows, m1->stride);
+}
@@ -0,0 +1,87 @@
+/**
+ *  \file     matrices_batch.h
+ *  \brief    Small matrices of N independent instances, computed together
+ *  \version  1.0
+ *
+ *  A batch holds the same rows x cols matrix for count instances (one state
+ *  estimator per drone for example). Element (r, c) of all the instances is
+ *  stored contiguously, so that each operation runs on MATRIX_BATCH_LANES
+ *  instances at a time with SSE or AVX, chosen at run time.
+ *
+ *  Products and sums are computed in the same order as mul_mat66 and
+ *  add_mat66 : the results are the same. The inverse uses Gauss-Jordan
+ *  elimination without pivoting, for symmetric positive definite matrices
+ *  such as the innovation covariance of a Kalman filter.
+ */
+
+#ifndef _MATRICES_BATCH_H_
+#define _MATRICES_BATCH_H_
+
+#include <VP_Os/vp_os_types.h>
+#include <Maths/matrices.h>
+
+#define MATRIX_BATCH_LANES      8   // instances of a register, stride of the batches is a multiple of it
+#define MATRIX_BATCH_ALIGN      32
+#define MATRIX_BATCH_MAX_INV    8   // largest matrix matrix_batch_inv can invert
+
+typedef enum _MATHS_SIMD_LEVEL
+{
+  MATHS_SIMD_NONE = 0,  //!< Scalar loops
+  MATHS_SIMD_SSE,
+  MATHS_SIMD_AVX,
+  MATHS_SIMD_BEST       //!< Highest level supported by the CPU
+} MATHS_SIMD_LEVEL;
+
+typedef struct _matrix_batch_t
+{
+  float32_t *data;      // element (r, c) of instance k : data[(r * cols + c) * stride + k]
+  uint32_t  rows;
+  uint32_t  cols;
+  uint32_t  count;      // instances
+  uint32_t  stride;     // count rounded up to MATRIX_BATCH_LANES
+} matrix_batch_t;
+
+#define MATRIX_BATCH_ELEMENT(mb, r, c)  ((mb)->data + ((r) * (mb)->cols + (c)) * (mb)->stride)
+
+/**
+ * Selects the instruction set of the batch functions, lowered to what the CPU supports.
+ * \return Level in use
+ */
+MATHS_SIMD_LEVEL maths_simd_level_set(MATHS_SIMD_LEVEL level);
+MATHS_SIMD_LEVEL maths_simd_level_get(void);
+
+/**
+ * Allocates a batch of count rows x cols matrices, set to 0
+ */
+C_RESULT matrix_batch_alloc(matrix_batch_t *mb, uint32_t rows, uint32_t cols, uint32_t count);
+void matrix_batch_free(matrix_batch_t *mb);
+
+/**
+ * Copies instance k from / to a row major matrix : (float32_t *) &matrix66 for example
+ */
+void matrix_batch_set(matrix_batch_t *mb, uint32_t k, const float32_t *m);
+void matrix_batch_get(const matrix_batch_t *mb, uint32_t k, float32_t *m);
+
+/**
+ * Sets all the instances to the same row major matrix
+ */
+void matrix_batch_fill(matrix_batch_t *mb, const float32_t *m);
+
+// out = m1 * m2. out can't be m1 or m2
+void matrix_batch_mul(matrix_batch_t *out, const matrix_batch_t *m1, const matrix_batch_t *m2);
+
+// out = m1 * transpose(m2). out can't be m1 or m2
+void matrix_batch_mul_transpose(matrix_batch_t *out, const matrix_batch_t *m1, const matrix_batch_t *m2);
+
+// out = m1 + m2, out = m1 - m2. out can be m1 or m2
+void matrix_batch_add(matrix_batch_t *out, const matrix_batch_t *m1, const matrix_batch_t *m2);
+void matrix_batch_sub(matrix_batch_t *out, const matrix_batch_t *m1, const matrix_batch_t *m2);
+
+/**
+ * Inverse of square matrices, up to MATRIX_BATCH_MAX_INV x MATRIX_BATCH_MAX_INV.
+ * Like inv_mat44, instances which are not inversible (a pivot below FLT_EPSILON) get the null matrix.
+ * out can be m1.
+ */
+void matrix_batch_inv(matrix_batch_t *out, const matrix_batch_t *m1);
+
+#endif // _MATRICES_BATCH_H_
@@ -140,6 +140,7 @@ AT_CODEC_ERROR_CODE host_open( void )
   {
     COM_CONFIG_SOCKET_AT(&at_socket, VP_COM_CLIENT, AT_PORT, wifi_ardrone_ip);
     at_socket.protocol = VP_COM_UDP;
+    at_socket.reuse_address = ARDRONE_TOOL_IS_SIMULATED_DRONE(wifi_ardrone_ip);
 
     if(VP_FAILED(vp_com_init(COM_AT())))
     {
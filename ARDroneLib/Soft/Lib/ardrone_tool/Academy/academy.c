@@ -8,6 +8,7 @@
 #include <ardrone_tool/Academy/academy.h>
 #include <ardrone_tool/Academy/academy_download.h>
 #include <ardrone_tool/Academy/academy_upload.h>
+#include <ardrone_tool/Academy/academy_index.h>
 #include <utils/ardrone_date.h>
 
 PROTO_THREAD_ROUTINE(academy, data);
@@ -22,8 +23,7 @@ typedef struct _academy_t_
 	vp_os_mutex_t mutex;
 	vp_os_cond_t cond;
 	int16_t  flight_max_storing_size;
-	uint32_t flight_sum;
-	char flight_oldest_date[ARDRONE_DATE_MAXSIZE];
+	academy_index_t index;
 } academy_t;
 
 static academy_t academy;
@@ -106,29 +106,6 @@ int academy_remove(const char* fpath, const struct stat *sb, int typeflag)
 	return 0;
 }
 
-int academy_compute_memory_used(const char* fpath, const struct stat *sb, int typeflag)
-{
-	char prefix[FLIGHT_NAME_SIZE];
-	sprintf(prefix, "%s/flight_", flight_dir);
-
-	if(strncmp(fpath, prefix, strlen(prefix)) == 0)
-	{
-		if(typeflag == FTW_F)
-		{
-			academy.flight_sum += sb->st_size;
-		}
-		else if(typeflag == FTW_D)
-		{
-            if(academy.flight_oldest_date[0] == '\0')
-            {
-                sscanf(fpath + strlen(prefix), "%s", academy.flight_oldest_date);
-            }
-		}
-	}
-
-	return 0;
-}
-
 char *academy_get_next_item_with_prefix(const char *list, char **next_item, const char *prefix, bool_t isDirectory)
 {
 	char *result = NULL;
@@ -169,18 +146,21 @@ char *academy_get_next_item_with_prefix(const char *list, char **next_item, cons
 _ftp_status academy_remove_ftp_directory(_ftp_t *ftp, const char *directory_name)
 {
 	char *list = NULL;
-	char *ptr = NULL;
+	const char *ptr = NULL;
 	_ftp_status academy_status = ftpCd(ftp, directory_name);
 	if(FTP_SUCCEDED(academy_status))
 	{
-		char *next_item = NULL;
+		academy_listing_t listing;
+		int32_t next_item = -1;
 		academy_status = ftpList(ftp, &list, NULL);
 		PA_DEBUG("list file :\n%s\n", list);
-		while(FTP_SUCCEDED(academy_status) && (ptr = academy_get_next_item_with_prefix(list, &next_item, "", FALSE)))
+		academy_listing_parse(&listing, FTP_SUCCEDED(academy_status) ? list : NULL);
+		while(FTP_SUCCEDED(academy_status) && (ptr = academy_listing_next_item(&listing, &next_item, "", FALSE)))
 		{
 			PA_DEBUG("Removing %s...\n", ptr);
 			academy_status = ftpRemove(ftp, ptr);
 		}
+		academy_listing_free(&listing);
 
 		if(list != NULL)
 		{
@@ -202,50 +182,39 @@ _ftp_status academy_remove_ftp_directory(_ftp_t *ftp, const char *directory_name
 DEFINE_THREAD_ROUTINE(academy, data)
 {
 	printf("Start thread %s\n", __FUNCTION__);
-    bool_t needToCheckMemory = TRUE;
-    
+	const academy_index_dir_t *oldest;
+
+	// Kept up to date from the file system events, the memory check does not walk the flights
+	academy_index_open(&academy.index, flight_dir);
+
 	while( academy_started && !ardrone_tool_exit() )
 	{
-        if(!needToCheckMemory)
-        {
-            vp_os_mutex_lock(&academy.mutex);
-            vp_os_cond_wait(&academy.cond);
-            needToCheckMemory = TRUE;
-            vp_os_mutex_unlock(&academy.mutex);
-        }
-        
-        while(needToCheckMemory)
-        {
-            academy.flight_sum = 0;
-            academy.flight_oldest_date[0] = '\0';
-            
-            if(!ftw(flight_dir, &academy_compute_memory_used, ACADEMY_MAX_FD_FOR_FTW))
-            {
-                if(academy.flight_sum > MBYTE_TO_BYTE(academy.flight_max_storing_size))
-                {
-                    char remove_dir[ACADEMY_MAX_FILENAME];
-                    sprintf(remove_dir, "%s/flight_%s", flight_dir, academy.flight_oldest_date);
-                    
-                    // remove oldest flight
-                    PA_WARNING("Too much memory used %d MB > %d MB, removing oldest flight %s...", BYTE_TO_MBYTE(academy.flight_sum), academy.flight_max_storing_size, remove_dir);
-                    
-                    if(!ftw(remove_dir, &academy_remove, ACADEMY_MAX_FD_FOR_FTW))
-                    {
-                        rmdir(remove_dir);
-                        PA_WARNING("OK.\n");
-                    }
-                }
-                else
-                {
-                    needToCheckMemory = FALSE;
-                }
-            }
-            else
-            {
-                needToCheckMemory = FALSE;
-            }
-        }
+		academy_index_update(&academy.index);
+
+		while((academy_index_flight_bytes(&academy.index) > MBYTE_TO_BYTE((uint64_t)academy.flight_max_storing_size)) &&
+		      ((oldest = academy_index_oldest_flight(&academy.index)) != NULL))
+		{
+			char remove_dir[ACADEMY_MAX_FILENAME];
+			strncpy(remove_dir, oldest->name, ACADEMY_MAX_FILENAME - 1);
+			remove_dir[ACADEMY_MAX_FILENAME - 1] = '\0';
+
+			// remove oldest flight
+			PA_WARNING("Too much memory used %d MB > %d MB, removing oldest flight %s/%s...", (int)BYTE_TO_MBYTE(academy_index_flight_bytes(&academy.index)), academy.flight_max_storing_size, flight_dir, remove_dir);
+
+			if(academy_index_remove_dir(&academy.index, remove_dir) != C_OK)
+				break;
+			PA_WARNING("OK.\n");
+		}
+
+		academy_index_save(&academy.index);
+
+		vp_os_mutex_lock(&academy.mutex);
+		if(academy_started)
+			vp_os_cond_wait(&academy.cond);
+		vp_os_mutex_unlock(&academy.mutex);
 	}
 
+	academy_index_close(&academy.index);
+
 	THREAD_RETURN(C_OK);
 }
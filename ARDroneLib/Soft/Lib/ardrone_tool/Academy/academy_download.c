@@ -6,8 +6,15 @@
  *
  */
 #include <ardrone_tool/Academy/academy_download.h>
+#include <ardrone_tool/Academy/academy_index.h>
 
 #define DISPLAY_STRING_LENGTH (128)
+#define ACADEMY_DOWNLOAD_CONNECTIONS (2) // Medias downloaded at once
+
+typedef struct _academy_media_t_
+{
+    char local_filename[ACADEMY_MAX_FILENAME];
+} academy_media_t;
 
 typedef struct _academy_download_t_
 {
@@ -75,6 +82,25 @@ static void academy_download_private_callback(academy_state_t state)
         PA_DEBUG("===========> %s\n", msg);
 }
 
+static void academy_download_media_callback(_ftp_status status, void *arg, _ftp_t *callingFtp)
+{
+    _ftp_get_item *item = (_ftp_get_item *)arg;
+    academy_download_t *academy = (academy_download_t *)item->tag;
+
+    if(FTP_SUCCEDED(status))
+    {
+        PA_DEBUG("Get %s from drone to local directory...OK\n", item->localName);
+        if (NULL != academy->new_media_callback)
+        {
+            academy->new_media_callback(item->localName, TRUE);
+        }
+    }
+    else
+    {
+        PA_DEBUG("Get %s from drone to local directory...ERROR\n", item->localName);
+    }
+}
+
 static void academy_download_resetState(academy_download_t *academy)
 {
     academy_resetState(&academy->state);
@@ -134,7 +160,7 @@ DEFINE_THREAD_ROUTINE(academy_download, data)
     _ftp_t *academy_ftp = NULL;
     _ftp_status academy_status;
     struct stat statbuf;
-    char *ptr = NULL;
+    const char *ptr = NULL;
     academy_download_t academy;
 
     academy.new_media_callback = (academy_download_new_media)data;    
@@ -178,7 +204,8 @@ DEFINE_THREAD_ROUTINE(academy_download, data)
                 academy_status = ftpCd(academy_ftp, "/boxes");
                 if(FTP_SUCCEDED(academy_status))
                 {
-                    char *next_dir = NULL;
+                    int32_t next_dir = -1;
+                    academy_listing_t listing;
                     PA_DEBUG("Enter to boxes directory\n");
                     academy_status = ftpList(academy_ftp, &directoryList, NULL);
 
@@ -191,7 +218,8 @@ DEFINE_THREAD_ROUTINE(academy_download, data)
                         char local_dir[ACADEMY_MAX_FILENAME];
                         // Search if it stay ftpremove_* directories to continue removing
                         PA_DEBUG("Get directory list :\n%s", directoryList);
-                        while(FTP_SUCCEDED(academy_status) && (ptr = academy_get_next_item_with_prefix(directoryList, &next_dir, "ftpremove_downloading_", TRUE)))
+                        academy_listing_parse(&listing, directoryList);
+                        while(FTP_SUCCEDED(academy_status) && (ptr = academy_listing_next_item(&listing, &next_dir, "ftpremove_downloading_", TRUE)))
                         {
                             char remove_dirname[ACADEMY_MAX_FILENAME];
                             strncpy(remove_dirname, ptr, ACADEMY_MAX_FILENAME);
@@ -199,9 +227,9 @@ DEFINE_THREAD_ROUTINE(academy_download, data)
                         }
 
                         academy_status = FTP_FAIL;
-                        next_dir = NULL;
+                        next_dir = -1;
                         // Search if it stay downloading_flight_* file to continue downloading.
-                        ptr = academy_get_next_item_with_prefix(directoryList, &next_dir, "downloading_flight_", TRUE);
+                        ptr = academy_listing_next_item(&listing, &next_dir, "downloading_flight_", TRUE);
                         // Check if transfer was in progress
                         if(ptr != NULL)
                         {
@@ -231,8 +259,9 @@ DEFINE_THREAD_ROUTINE(academy_download, data)
                         {
                             PA_DEBUG(" Transfer was not in progress\n");
                             // Transfer was not in progress => Get oldest flight, rename remote directory and create local directory
-                            next_dir = NULL;
-                            ptr = academy_get_next_item_with_prefix(directoryList, &next_dir, "flight_", TRUE);
+                            // Listing is sorted : oldest flight first
+                            next_dir = -1;
+                            ptr = academy_listing_next_item(&listing, &next_dir, "flight_", TRUE);
                             if(ptr != NULL)
                             {
                                 // Prepare to process new transfer
@@ -254,6 +283,7 @@ DEFINE_THREAD_ROUTINE(academy_download, data)
                             }
                         }
 
+                        academy_listing_free(&listing);
                         if(directoryList != NULL)
                         {
                             vp_os_free(directoryList);
@@ -271,13 +301,15 @@ DEFINE_THREAD_ROUTINE(academy_download, data)
                     academy_status = ftpList(academy_ftp, &fileList, NULL);
                     if(FTP_SUCCEDED(academy_status))
                     {
-                        char *next_file = NULL;
+                        int32_t next_file = -1;
+                        academy_listing_t listing;
                         char media_dirname[ACADEMY_MAX_FILENAME];
                         char local_filename[ACADEMY_MAX_FILENAME];
                         bool_t userbox_ready = FALSE;
 
                         PA_DEBUG("Get file list :\n%s", fileList);
-                        ptr = academy_get_next_item_with_prefix(fileList, &next_file, "userbox_", FALSE);
+                        academy_listing_parse(&listing, fileList);
+                        ptr = academy_listing_next_item(&listing, &next_file, "userbox_", FALSE);
                         if(ptr != NULL)
                         {
                             snprintf(local_filename, ACADEMY_MAX_FILENAME, "%s/%s/%s", flight_dir, process_dirname, ptr);
@@ -294,28 +326,43 @@ DEFINE_THREAD_ROUTINE(academy_download, data)
 
                         snprintf(media_dirname, ACADEMY_MAX_FILENAME, "%s/media_%s", flight_dir, process_dirname + (strlen("downloading_flight_")));
                         //PRINT("medias directory : %s\n", media_dirname);
-                        next_file = NULL;
-                        while(FTP_SUCCEDED(academy_status) && (ptr = academy_get_next_item_with_prefix(fileList, &next_file, "picture_", FALSE)))
-                        {
-                            if((stat(media_dirname, &statbuf) != 0) && (mkdir(media_dirname, 0777) >= 0))
-                                PA_DEBUG("Create local media directory %s if not exist\n", media_dirname);
+                        next_file = -1;
+                        int nb_medias = 0;
+                        while(academy_listing_next_item(&listing, &next_file, "picture_", FALSE))
+                            nb_medias++;
 
-                            sprintf(local_filename, "%s/%s", media_dirname, ptr);
-                            PA_DEBUG("Get %s from drone to local directory...", local_filename);
-                            academy_status = ftpGet (academy_ftp, ptr, local_filename, 1, NULL);
-                            if(FTP_SUCCEDED(academy_status))
+                        if(FTP_SUCCEDED(academy_status) && (nb_medias > 0))
+                        {
+                            // Medias are got several at once, each on its own connection
+                            academy_media_t *medias = (academy_media_t *)vp_os_malloc(nb_medias * sizeof(academy_media_t));
+                            _ftp_get_item *items = (_ftp_get_item *)vp_os_malloc(nb_medias * sizeof(_ftp_get_item));
+                            if((medias != NULL) && (items != NULL))
                             {
-                                    if (NULL != academy.new_media_callback)
-                                    {
-                                academy.new_media_callback((const char *)local_filename, TRUE);
-                                    }
-                                PA_DEBUG("OK\n");
+                                int i;
+                                if((stat(media_dirname, &statbuf) != 0) && (mkdir(media_dirname, 0777) >= 0))
+                                    PA_DEBUG("Create local media directory %s if not exist\n", media_dirname);
+
+                                next_file = -1;
+                                for(i = 0 ; (i < nb_medias) && (ptr = academy_listing_next_item(&listing, &next_file, "picture_", FALSE)) ; i++)
+                                {
+                                    snprintf(medias[i].local_filename, ACADEMY_MAX_FILENAME, "%s/%s", media_dirname, ptr);
+                                    items[i].remoteName = ptr;
+                                    items[i].localName = medias[i].local_filename;
+                                    items[i].tag = &academy;
+                                }
+                                academy_status = ftpGetQueue(academy_ftp, items, i, ACADEMY_DOWNLOAD_CONNECTIONS, 1, academy_download_media_callback);
                             }
                             else
                             {
-                                PA_DEBUG("ERROR\n");
+                                academy_status = FTP_FAIL;
                             }
+
+                            if(medias != NULL)
+                                vp_os_free(medias);
+                            if(items != NULL)
+                                vp_os_free(items);
                         }
+                        academy_listing_free(&listing);
                         if (NULL != academy.new_media_callback)
                         {
                         academy.new_media_callback((const char *)NULL, FALSE);
@@ -0,0 +1,833 @@
+/**
+ *  academy_index.c
+ *
+ *  Index of the flight directory kept up to date with inotify, and sorted
+ *  FTP listings.
+ */
+#include <ardrone_tool/Academy/academy_index.h>
+#include <ardrone_tool/Academy/academy_download.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#define ACADEMY_INDEX_VERSION		1
+#define ACADEMY_INDEX_LINE_SIZE		(ACADEMY_MAX_FILENAME + 64)
+#define ACADEMY_INDEX_EVENTS_SIZE	(16 * 1024)
+
+#ifdef __linux__
+#define ACADEMY_INDEX_ROOT_MASK		(IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+#define ACADEMY_INDEX_DIR_MASK		(IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+#endif
+
+static char *academy_index_strdup(const char *str)
+{
+	char *copy = (char *)vp_os_malloc(strlen(str) + 1);
+	if(copy != NULL)
+		strcpy(copy, str);
+	return copy;
+}
+
+static uint64_t academy_index_mtime(const struct stat *st)
+{
+#if defined(__linux__)
+	return (uint64_t)st->st_mtim.tv_sec * 1000000000ULL + st->st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+	return (uint64_t)st->st_mtimespec.tv_sec * 1000000000ULL + st->st_mtimespec.tv_nsec;
+#else
+	return (uint64_t)st->st_mtime * 1000000000ULL;
+#endif
+}
+
+static ACADEMY_INDEX_DIR_STATE academy_index_state(const char *name)
+{
+	if(strncmp(name, "flight_", strlen("flight_")) == 0)
+		return ACADEMY_INDEX_DIR_FLIGHT;
+	if(strncmp(name, "downloading_flight_", strlen("downloading_flight_")) == 0)
+		return ACADEMY_INDEX_DIR_DOWNLOADING;
+	if(strncmp(name, "media_", strlen("media_")) == 0)
+		return ACADEMY_INDEX_DIR_MEDIA;
+	return ACADEMY_INDEX_DIR_OTHER;
+}
+
+static int academy_index_compare_files(const void *a, const void *b)
+{
+	return strcmp(((const academy_index_file_t *)a)->name, ((const academy_index_file_t *)b)->name);
+}
+
+static int academy_index_compare_entries(const void *a, const void *b)
+{
+	return strcmp(((const academy_listing_entry_t *)a)->name, ((const academy_listing_entry_t *)b)->name);
+}
+
+// First directory whose name is not lower than name
+static uint32_t academy_index_dir_position(const academy_index_t *index, const char *name)
+{
+	uint32_t low = 0, high = index->nb_dirs;
+	while(low < high)
+	{
+		uint32_t middle = (low + high) / 2;
+		if(strcmp(index->dirs[middle]->name, name) < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+static uint32_t academy_index_file_position(const academy_index_dir_t *dir, const char *name)
+{
+	uint32_t low = 0, high = dir->nb_files;
+	while(low < high)
+	{
+		uint32_t middle = (low + high) / 2;
+		if(strcmp(dir->files[middle].name, name) < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+static void academy_index_add_bytes(academy_index_t *index, academy_index_dir_t *dir, int64_t bytes)
+{
+	dir->bytes += bytes;
+	if(dir->state == ACADEMY_INDEX_DIR_FLIGHT)
+		index->flight_bytes += bytes;
+}
+
+// Fails when the path does not fit in ACADEMY_MAX_FILENAME : a truncated path would name another file
+static C_RESULT academy_index_path(const academy_index_t *index, const academy_index_dir_t *dir, const char *name, char *path)
+{
+	int length;
+
+	if(name != NULL)
+		length = snprintf(path, ACADEMY_MAX_FILENAME, "%s/%s/%s", index->root, dir->name, name);
+	else
+		length = snprintf(path, ACADEMY_MAX_FILENAME, "%s/%s", index->root, dir->name);
+
+	return ((length >= 0) && (length < ACADEMY_MAX_FILENAME)) ? C_OK : C_FAIL;
+}
+
+static academy_index_file_t *academy_index_append_file(academy_index_dir_t *dir, const char *name, uint64_t size, uint64_t mtime)
+{
+	academy_index_file_t *file;
+
+	if(dir->nb_files == dir->max_files)
+	{
+		uint32_t max_files = (dir->max_files != 0) ? 2 * dir->max_files : 16;
+		academy_index_file_t *files = (academy_index_file_t *)vp_os_realloc(dir->files, max_files * sizeof(academy_index_file_t));
+		if(files == NULL)
+			return NULL;
+		dir->files = files;
+		dir->max_files = max_files;
+	}
+
+	file = &dir->files[dir->nb_files];
+	file->name = academy_index_strdup(name);
+	if(file->name == NULL)
+		return NULL;
+	file->size = size;
+	file->mtime = mtime;
+	dir->nb_files++;
+
+	return file;
+}
+
+static void academy_index_clear_dir(academy_index_t *index, academy_index_dir_t *dir)
+{
+	uint32_t i;
+
+	for(i = 0 ; i < dir->nb_files ; i++)
+		vp_os_free(dir->files[i].name);
+	dir->nb_files = 0;
+	academy_index_add_bytes(index, dir, -(int64_t)dir->bytes);
+}
+
+static void academy_index_set_file(academy_index_t *index, academy_index_dir_t *dir, const char *name, const struct stat *st)
+{
+	uint32_t position = academy_index_file_position(dir, name);
+	academy_index_file_t *file;
+
+	if((position < dir->nb_files) && (strcmp(dir->files[position].name, name) == 0))
+	{
+		file = &dir->files[position];
+		academy_index_add_bytes(index, dir, (int64_t)st->st_size - (int64_t)file->size);
+		file->size = st->st_size;
+		file->mtime = academy_index_mtime(st);
+	}
+	else if((file = academy_index_append_file(dir, name, st->st_size, academy_index_mtime(st))) != NULL)
+	{
+		// Appended at the end, moves it to its place
+		academy_index_file_t new_file = *file;
+		memmove(&dir->files[position + 1], &dir->files[position], (dir->nb_files - 1 - position) * sizeof(academy_index_file_t));
+		dir->files[position] = new_file;
+		academy_index_add_bytes(index, dir, st->st_size);
+	}
+}
+
+static void academy_index_remove_file(academy_index_t *index, academy_index_dir_t *dir, const char *name)
+{
+	uint32_t position = academy_index_file_position(dir, name);
+
+	if((position < dir->nb_files) && (strcmp(dir->files[position].name, name) == 0))
+	{
+		academy_index_add_bytes(index, dir, -(int64_t)dir->files[position].size);
+		vp_os_free(dir->files[position].name);
+		dir->nb_files--;
+		memmove(&dir->files[position], &dir->files[position + 1], (dir->nb_files - position) * sizeof(academy_index_file_t));
+	}
+}
+
+// Reads the files of dir again
+static void academy_index_scan_dir(academy_index_t *index, academy_index_dir_t *dir)
+{
+	char path[ACADEMY_MAX_FILENAME];
+	char file_path[ACADEMY_MAX_FILENAME];
+	struct dirent *entry;
+	struct stat st;
+	DIR *d;
+	uint32_t i;
+
+	academy_index_clear_dir(index, dir);
+	index->dirty = TRUE;
+	if(C_OK != academy_index_path(index, dir, NULL, path))
+		return;
+
+	if(stat(path, &st) == 0)
+		dir->mtime = academy_index_mtime(&st);
+
+	d = opendir(path);
+	if(d == NULL)
+		return;
+
+	while((entry = readdir(d)) != NULL)
+	{
+		if(entry->d_name[0] == '.' || strchr(entry->d_name, '\n') != NULL)
+			continue;
+		// Files whose path is too long could not be removed
+		if(C_OK != academy_index_path(index, dir, entry->d_name, file_path))
+			continue;
+
+		if(fstatat(dirfd(d), entry->d_name, &st, 0) == 0 && S_ISREG(st.st_mode))
+			academy_index_append_file(dir, entry->d_name, st.st_size, academy_index_mtime(&st));
+	}
+	closedir(d);
+
+	qsort(dir->files, dir->nb_files, sizeof(academy_index_file_t), academy_index_compare_files);
+	for(i = 0 ; i < dir->nb_files ; i++)
+		academy_index_add_bytes(index, dir, dir->files[i].size);
+}
+
+static void academy_index_watch_dir(academy_index_t *index, academy_index_dir_t *dir)
+{
+#ifdef __linux__
+	char path[ACADEMY_MAX_FILENAME];
+
+	if(index->fd >= 0 && dir->wd < 0 && C_OK == academy_index_path(index, dir, NULL, path))
+		dir->wd = inotify_add_watch(index->fd, path, ACADEMY_INDEX_DIR_MASK);
+#endif
+}
+
+static C_RESULT academy_index_insert_dir(academy_index_t *index, academy_index_dir_t *dir)
+{
+	uint32_t position = academy_index_dir_position(index, dir->name);
+
+	if(index->nb_dirs == index->max_dirs)
+	{
+		uint32_t max_dirs = (index->max_dirs != 0) ? 2 * index->max_dirs : 16;
+		academy_index_dir_t **dirs = (academy_index_dir_t **)vp_os_realloc(index->dirs, max_dirs * sizeof(academy_index_dir_t *));
+		if(dirs == NULL)
+			return C_FAIL;
+		index->dirs = dirs;
+		index->max_dirs = max_dirs;
+	}
+
+	memmove(&index->dirs[position + 1], &index->dirs[position], (index->nb_dirs - position) * sizeof(academy_index_dir_t *));
+	index->dirs[position] = dir;
+	index->nb_dirs++;
+
+	return C_OK;
+}
+
+static void academy_index_unlink_dir(academy_index_t *index, academy_index_dir_t *dir)
+{
+	uint32_t position = academy_index_dir_position(index, dir->name);
+
+	if((position < index->nb_dirs) && (index->dirs[position] == dir))
+	{
+		index->nb_dirs--;
+		memmove(&index->dirs[position], &index->dirs[position + 1], (index->nb_dirs - position) * sizeof(academy_index_dir_t *));
+	}
+}
+
+static academy_index_dir_t *academy_index_new_dir(academy_index_t *index, const char *name)
+{
+	academy_index_dir_t *dir;
+
+	// Not indexed when root/name does not fit in a path
+	if(strlen(index->root) + 1 + strlen(name) >= ACADEMY_MAX_FILENAME)
+		return NULL;
+
+	dir = (academy_index_dir_t *)vp_os_calloc(1, sizeof(academy_index_dir_t));
+	if(dir != NULL)
+	{
+		dir->name = academy_index_strdup(name);
+		if(dir->name == NULL)
+		{
+			vp_os_free(dir);
+			return NULL;
+		}
+		dir->state = academy_index_state(name);
+		dir->wd = -1;
+		dir->seen = TRUE;
+		if(C_OK != academy_index_insert_dir(index, dir))
+		{
+			vp_os_free(dir->name);
+			vp_os_free(dir);
+			return NULL;
+		}
+		index->dirty = TRUE;
+	}
+
+	return dir;
+}
+
+// Watched before being read, so that no file is missed
+static academy_index_dir_t *academy_index_add_dir(academy_index_t *index, const char *name)
+{
+	academy_index_dir_t *dir = academy_index_new_dir(index, name);
+
+	if(dir != NULL)
+	{
+		academy_index_watch_dir(index, dir);
+		academy_index_scan_dir(index, dir);
+	}
+
+	return dir;
+}
+
+// Forgets dir, the directory itself is left as is
+static void academy_index_drop_dir(academy_index_t *index, academy_index_dir_t *dir)
+{
+	academy_index_clear_dir(index, dir);
+	academy_index_unlink_dir(index, dir);
+#ifdef __linux__
+	if(index->fd >= 0 && dir->wd >= 0)
+		inotify_rm_watch(index->fd, dir->wd);
+#endif
+	if(index->moved_dir == dir)
+		index->moved_dir = NULL;
+	vp_os_free(dir->files);
+	vp_os_free(dir->name);
+	vp_os_free(dir);
+	index->dirty = TRUE;
+}
+
+static void academy_index_rename_dir(academy_index_t *index, academy_index_dir_t *dir, const char *name)
+{
+	char *new_name = academy_index_strdup(name);
+
+	if(new_name == NULL)
+	{
+		academy_index_drop_dir(index, dir);
+		return;
+	}
+
+	// The bytes count for the flights only in the state they had
+	academy_index_unlink_dir(index, dir);
+	if(dir->state == ACADEMY_INDEX_DIR_FLIGHT)
+		index->flight_bytes -= dir->bytes;
+	vp_os_free(dir->name);
+	dir->name = new_name;
+	dir->state = academy_index_state(name);
+	if(dir->state == ACADEMY_INDEX_DIR_FLIGHT)
+		index->flight_bytes += dir->bytes;
+	index->dirty = TRUE;
+	if(C_OK != academy_index_insert_dir(index, dir))
+		academy_index_drop_dir(index, dir);
+}
+
+// Compares the directories of root with the index, and reads again the ones whose mtime changed
+static void academy_index_check(academy_index_t *index)
+{
+	struct dirent *entry;
+	struct stat st;
+	DIR *d;
+	uint32_t i;
+
+	for(i = 0 ; i < index->nb_dirs ; i++)
+		index->dirs[i]->seen = FALSE;
+
+	d = opendir(index->root);
+	if(d != NULL)
+	{
+		while((entry = readdir(d)) != NULL)
+		{
+			academy_index_dir_t *dir;
+
+			if(entry->d_name[0] == '.' || strchr(entry->d_name, '\n') != NULL)
+				continue;
+			if(fstatat(dirfd(d), entry->d_name, &st, 0) != 0 || !S_ISDIR(st.st_mode))
+				continue;
+
+			dir = academy_index_find_dir(index, entry->d_name);
+			if(dir == NULL)
+			{
+				academy_index_add_dir(index, entry->d_name);
+			}
+			else
+			{
+				dir->seen = TRUE;
+				academy_index_watch_dir(index, dir);
+				// Watched from now on, the mtime tells if it changed before
+				if(fstatat(dirfd(d), entry->d_name, &st, 0) == 0 && academy_index_mtime(&st) != dir->mtime)
+					academy_index_scan_dir(index, dir);
+			}
+		}
+		closedir(d);
+	}
+
+	i = 0;
+	while(i < index->nb_dirs)
+	{
+		if(!index->dirs[i]->seen)
+			academy_index_drop_dir(index, index->dirs[i]);
+		else
+			i++;
+	}
+}
+
+static void academy_index_load(academy_index_t *index)
+{
+	char line[ACADEMY_INDEX_LINE_SIZE];
+	char name[ACADEMY_INDEX_LINE_SIZE];
+	char path[ACADEMY_MAX_FILENAME];
+	academy_index_dir_t *dir = NULL;
+	unsigned long long a, b;
+	uint32_t i;
+	int version = 0;
+	int length;
+	FILE *f;
+
+	length = snprintf(path, sizeof(path), "%s/%s", index->root, ACADEMY_INDEX_FILENAME);
+	if(length < 0 || length >= (int)sizeof(path))
+		return;
+	f = fopen(path, "r");
+	if(f == NULL)
+		return;
+
+	if(fgets(line, sizeof(line), f) != NULL && sscanf(line, "ACADEMY_INDEX %d", &version) == 1 && version == ACADEMY_INDEX_VERSION)
+	{
+		while(fgets(line, sizeof(line), f) != NULL)
+		{
+			if(sscanf(line, "D %llu %[^\n]", &a, name) == 2)
+			{
+				dir = academy_index_new_dir(index, name);
+				if(dir != NULL)
+					dir->mtime = a;
+			}
+			else if(dir != NULL && sscanf(line, "F %llu %llu %[^\n]", &a, &b, name) == 3 &&
+					C_OK == academy_index_path(index, dir, name, path))
+			{
+				if(academy_index_append_file(dir, name, a, b) != NULL)
+					academy_index_add_bytes(index, dir, a);
+			}
+		}
+	}
+	fclose(f);
+
+	for(i = 0 ; i < index->nb_dirs ; i++)
+		qsort(index->dirs[i]->files, index->dirs[i]->nb_files, sizeof(academy_index_file_t), academy_index_compare_files);
+}
+
+C_RESULT academy_index_save(academy_index_t *index)
+{
+	char path[ACADEMY_MAX_FILENAME];
+	char tmp_path[ACADEMY_MAX_FILENAME];
+	uint32_t i, j;
+	int length;
+	FILE *f;
+
+	if(!index->dirty)
+		return C_OK;
+
+	length = snprintf(tmp_path, sizeof(tmp_path), "%s/%s.tmp", index->root, ACADEMY_INDEX_FILENAME);
+	if(length < 0 || length >= (int)sizeof(tmp_path))
+		return C_FAIL;
+	// Same path without ".tmp"
+	length -= 4;
+	vp_os_memcpy(path, tmp_path, length);
+	path[length] = '\0';
+	f = fopen(tmp_path, "w");
+	if(f == NULL)
+		return C_FAIL;
+
+	fprintf(f, "ACADEMY_INDEX %d\n", ACADEMY_INDEX_VERSION);
+	for(i = 0 ; i < index->nb_dirs ; i++)
+	{
+		academy_index_dir_t *dir = index->dirs[i];
+		fprintf(f, "D %llu %s\n", (unsigned long long)dir->mtime, dir->name);
+		for(j = 0 ; j < dir->nb_files ; j++)
+			fprintf(f, "F %llu %llu %s\n", (unsigned long long)dir->files[j].size, (unsigned long long)dir->files[j].mtime, dir->files[j].name);
+	}
+
+	// Replaced at once, a crash leaves the previous index
+	if(fclose(f) != 0 || rename(tmp_path, path) != 0)
+	{
+		remove(tmp_path);
+		return C_FAIL;
+	}
+
+	index->dirty = FALSE;
+	return C_OK;
+}
+
+C_RESULT academy_index_open(academy_index_t *index, const char *root)
+{
+	vp_os_memset(index, 0, sizeof(academy_index_t));
+	strncpy(index->root, root, ROOT_NAME_SIZE - 1);
+	index->fd = -1;
+	index->root_wd = -1;
+
+#ifdef __linux__
+	index->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(index->fd >= 0)
+	{
+		index->root_wd = inotify_add_watch(index->fd, root, ACADEMY_INDEX_ROOT_MASK);
+		if(index->root_wd < 0)
+		{
+			close(index->fd);
+			index->fd = -1;
+		}
+	}
+	if(index->fd < 0)
+		PA_WARNING("Unable to watch %s, directories will be checked at each update\n", root);
+#endif
+
+	academy_index_load(index);
+	academy_index_check(index);
+
+	return C_OK;
+}
+
+void academy_index_close(academy_index_t *index)
+{
+	while(index->nb_dirs > 0)
+		academy_index_drop_dir(index, index->dirs[index->nb_dirs - 1]);
+
+	vp_os_free(index->dirs);
+	index->dirs = NULL;
+	index->max_dirs = 0;
+
+	if(index->fd >= 0)
+	{
+		close(index->fd);
+		index->fd = -1;
+	}
+}
+
+#ifdef __linux__
+// A directory moved from root, without an event for its new name, went out of root
+static void academy_index_end_move(academy_index_t *index)
+{
+	if(index->moved_dir != NULL)
+		academy_index_drop_dir(index, index->moved_dir);
+}
+
+static void academy_index_event(academy_index_t *index, const struct inotify_event *event)
+{
+	academy_index_dir_t *dir;
+	uint32_t i;
+
+	if(event->mask & IN_Q_OVERFLOW)
+	{
+		academy_index_end_move(index);
+		academy_index_check(index);
+		return;
+	}
+
+	if(!((event->mask & IN_MOVED_TO) && (event->wd == index->root_wd) && (event->cookie == index->moved_cookie)))
+		academy_index_end_move(index);
+
+	// Events of the watched directory itself, and of hidden files like the saved index
+	if(event->len == 0 || event->name[0] == '.')
+		return;
+
+	if(event->wd == index->root_wd)
+	{
+		if(!(event->mask & IN_ISDIR))
+			return;
+
+		dir = academy_index_find_dir(index, event->name);
+		if(event->mask & IN_MOVED_FROM)
+		{
+			index->moved_dir = dir;
+			index->moved_cookie = event->cookie;
+		}
+		else if(event->mask & IN_DELETE)
+		{
+			if(dir != NULL)
+				academy_index_drop_dir(index, dir);
+		}
+		else if((event->mask & IN_MOVED_TO) && (index->moved_dir != NULL))
+		{
+			// Renamed in root : the watch and the files stay
+			academy_index_dir_t *moved_dir = index->moved_dir;
+			index->moved_dir = NULL;
+			if(dir != NULL && dir != moved_dir)
+				academy_index_drop_dir(index, dir);
+			academy_index_rename_dir(index, moved_dir, event->name);
+		}
+		else if(dir == NULL)
+		{
+			academy_index_add_dir(index, event->name);
+		}
+		else
+		{
+			academy_index_scan_dir(index, dir);
+		}
+	}
+	else
+	{
+		struct stat st;
+		char path[ACADEMY_MAX_FILENAME];
+
+		dir = NULL;
+		for(i = 0 ; (i < index->nb_dirs) && (dir == NULL) ; i++)
+		{
+			if(index->dirs[i]->wd == event->wd)
+				dir = index->dirs[i];
+		}
+		if(dir == NULL || (event->mask & IN_ISDIR))
+			return;
+
+		// Names too long for a path are not indexed, like in academy_index_scan_dir
+		if((event->mask & (IN_DELETE | IN_MOVED_FROM)) || C_OK != academy_index_path(index, dir, event->name, path) ||
+		   stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+			academy_index_remove_file(index, dir, event->name);
+		else
+			academy_index_set_file(index, dir, event->name, &st);
+
+		if(C_OK == academy_index_path(index, dir, NULL, path) && stat(path, &st) == 0)
+			dir->mtime = academy_index_mtime(&st);
+		index->dirty = TRUE;
+	}
+}
+#endif
+
+void academy_index_update(academy_index_t *index)
+{
+#ifdef __linux__
+	if(index->fd >= 0)
+	{
+		char events[ACADEMY_INDEX_EVENTS_SIZE] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+		ssize_t length;
+
+		while((length = read(index->fd, events, sizeof(events))) > 0)
+		{
+			char *ptr = events;
+			while(ptr < events + length)
+			{
+				const struct inotify_event *event = (const struct inotify_event *)ptr;
+				academy_index_event(index, event);
+				ptr += sizeof(struct inotify_event) + event->len;
+			}
+		}
+		academy_index_end_move(index);
+		return;
+	}
+#endif
+
+	academy_index_check(index);
+}
+
+const academy_index_dir_t *academy_index_oldest_flight(const academy_index_t *index)
+{
+	// Flights names are flight_YYYYMMDD_hhmmss : the first one is the oldest
+	uint32_t position = academy_index_dir_position(index, "flight_");
+
+	if((position < index->nb_dirs) && (index->dirs[position]->state == ACADEMY_INDEX_DIR_FLIGHT))
+		return index->dirs[position];
+
+	return NULL;
+}
+
+academy_index_dir_t *academy_index_find_dir(const academy_index_t *index, const char *name)
+{
+	uint32_t position = academy_index_dir_position(index, name);
+
+	if((position < index->nb_dirs) && (strcmp(index->dirs[position]->name, name) == 0))
+		return index->dirs[position];
+
+	return NULL;
+}
+
+C_RESULT academy_index_remove_dir(academy_index_t *index, const char *name)
+{
+	char path[ACADEMY_MAX_FILENAME];
+	academy_index_dir_t *dir = academy_index_find_dir(index, name);
+	uint32_t i;
+	int length;
+
+	// A truncated path would remove another directory
+	length = snprintf(path, sizeof(path), "%s/%s", index->root, name);
+	if(length < 0 || length >= (int)sizeof(path))
+		return C_FAIL;
+
+	if(dir != NULL)
+	{
+		char file_path[ACADEMY_MAX_FILENAME];
+		for(i = 0 ; i < dir->nb_files ; i++)
+		{
+			// Left to ftw below when the path does not fit
+			if(C_OK == academy_index_path(index, dir, dir->files[i].name, file_path))
+				remove(file_path);
+		}
+	}
+
+	// Not indexed files, in sub directories or not seen yet
+	if(rmdir(path) != 0 && errno != ENOENT)
+	{
+		if(ftw(path, &academy_remove, ACADEMY_MAX_FD_FOR_FTW) != 0 || (rmdir(path) != 0 && errno != ENOENT))
+			return C_FAIL;
+	}
+
+	if(dir != NULL)
+		academy_index_drop_dir(index, dir);
+
+	return C_OK;
+}
+
+/**
+ * Name of a listing line ending at end : files and directories only, the name is the last field
+ */
+static bool_t academy_listing_line_name(const char *line, const char *end, const char **name, const char **name_end)
+{
+	const char *ptr;
+
+	if(line[0] != 'd' && line[0] != '-')
+		return FALSE;
+
+	*name_end = (end > line && end[-1] == '\r') ? end - 1 : end;
+	for(ptr = *name_end ; ptr > line && ptr[-1] != ' ' ; ptr--);
+	*name = ptr;
+
+	return (ptr != line && ptr != *name_end) ? TRUE : FALSE;
+}
+
+C_RESULT academy_listing_parse(academy_listing_t *listing, const char *list)
+{
+	const char *line, *end, *name, *name_end;
+	int32_t max_entries = 0;
+	size_t names_size = 0;
+	bool_t sorted = TRUE, reversed = TRUE;
+	char *names;
+	int32_t i;
+
+	listing->entries = NULL;
+	listing->nb_entries = 0;
+	if(list == NULL)
+		return C_OK;
+
+	for(line = list ; (end = strchr(line, '\n')) != NULL ; line = end + 1)
+	{
+		if(academy_listing_line_name(line, end, &name, &name_end))
+		{
+			max_entries++;
+			names_size += name_end - name + 1;
+		}
+	}
+	if(max_entries == 0)
+		return C_OK;
+
+	// Names are stored after the entries, in the same block
+	listing->entries = (academy_listing_entry_t *)vp_os_malloc(max_entries * sizeof(academy_listing_entry_t) + names_size);
+	if(listing->entries == NULL)
+		return C_FAIL;
+	names = (char *)(listing->entries + max_entries);
+
+	for(line = list ; (end = strchr(line, '\n')) != NULL ; line = end + 1)
+	{
+		academy_listing_entry_t *entry = &listing->entries[listing->nb_entries];
+
+		if(!academy_listing_line_name(line, end, &name, &name_end))
+			continue;
+
+		memcpy(names, name, name_end - name);
+		names[name_end - name] = '\0';
+		entry->name = names;
+		entry->is_directory = (line[0] == 'd') ? TRUE : FALSE;
+		names += name_end - name + 1;
+
+		if(listing->nb_entries > 0)
+		{
+			int compare = strcmp(entry[-1].name, entry->name);
+			sorted = (sorted && compare <= 0) ? TRUE : FALSE;
+			reversed = (reversed && compare >= 0) ? TRUE : FALSE;
+		}
+		listing->nb_entries++;
+	}
+
+	// The drone lists the directories in name order : sort only if needed
+	if(reversed && !sorted)
+	{
+		for(i = 0 ; i < listing->nb_entries / 2 ; i++)
+		{
+			academy_listing_entry_t entry = listing->entries[i];
+			listing->entries[i] = listing->entries[listing->nb_entries - 1 - i];
+			listing->entries[listing->nb_entries - 1 - i] = entry;
+		}
+	}
+	else if(!sorted)
+	{
+		qsort(listing->entries, listing->nb_entries, sizeof(academy_listing_entry_t), academy_index_compare_entries);
+	}
+
+	return C_OK;
+}
+
+void academy_listing_free(academy_listing_t *listing)
+{
+	if(listing->entries != NULL)
+		vp_os_free(listing->entries);
+	listing->entries = NULL;
+	listing->nb_entries = 0;
+}
+
+const char *academy_listing_next_item(const academy_listing_t *listing, int32_t *next_item, const char *prefix, bool_t isDirectory)
+{
+	int32_t i = *next_item;
+	size_t length = strlen(prefix);
+
+	if(i < 0)
+	{
+		int32_t high = listing->nb_entries;
+		i = 0;
+		while(i < high)
+		{
+			int32_t middle = (i + high) / 2;
+			if(strcmp(listing->entries[middle].name, prefix) < 0)
+				i = middle + 1;
+			else
+				high = middle;
+		}
+	}
+
+	// Names with the prefix follow each other
+	for( ; (i < listing->nb_entries) && (strncmp(listing->entries[i].name, prefix, length) == 0) ; i++)
+	{
+		if((listing->entries[i].is_directory ? TRUE : FALSE) == (isDirectory ? TRUE : FALSE))
+		{
+			*next_item = i + 1;
+			return listing->entries[i].name;
+		}
+	}
+
+	*next_item = listing->nb_entries;
+	return NULL;
+}
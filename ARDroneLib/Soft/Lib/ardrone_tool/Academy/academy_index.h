@@ -0,0 +1,126 @@
+/**
+ *  academy_index.h
+ *
+ *  Index of the flight directory kept up to date with inotify, and sorted
+ *  FTP listings.
+ *
+ *  The index holds the directories of flight_dir, with for each one its
+ *  files (name, size, mtime) and its transfer state, from its name prefix.
+ *  It is saved in flight_dir/ACADEMY_INDEX_FILENAME, and when opened again
+ *  only the directories whose mtime changed are read.
+ *  Only the files directly in the directories are indexed.
+ *
+ *  An index is not thread safe, it belongs to the thread which opened it.
+ */
+#ifndef _ACADEMY_INDEX_H_
+#define _ACADEMY_INDEX_H_
+
+#include <ardrone_tool/Academy/academy.h>
+
+#define ACADEMY_INDEX_FILENAME	".academy_index"
+
+typedef enum _ACADEMY_INDEX_DIR_STATE_
+{
+	ACADEMY_INDEX_DIR_FLIGHT = 0,		// flight_* : downloaded flight
+	ACADEMY_INDEX_DIR_DOWNLOADING,		// downloading_flight_* : transfer in progress
+	ACADEMY_INDEX_DIR_MEDIA,			// media_*
+	ACADEMY_INDEX_DIR_OTHER,
+} ACADEMY_INDEX_DIR_STATE;
+
+typedef struct _academy_index_file_t_
+{
+	char		*name;
+	uint64_t	size;
+	uint64_t	mtime;					// ns
+} academy_index_file_t;
+
+typedef struct _academy_index_dir_t_
+{
+	char					*name;
+	ACADEMY_INDEX_DIR_STATE	state;
+	int32_t					wd;			// inotify watch, -1 : none
+	uint64_t				mtime;		// ns, of the directory when the files were last updated
+	uint64_t				bytes;		// sum of the files size
+	academy_index_file_t	*files;		// sorted by name
+	uint32_t				nb_files;
+	uint32_t				max_files;
+	bool_t					seen;		// private, found by the last directory check
+} academy_index_dir_t;
+
+typedef struct _academy_index_t_
+{
+	char					root[ROOT_NAME_SIZE];
+	int32_t					fd;			// inotify, -1 : none (directories are checked from their mtime)
+	int32_t					root_wd;
+	academy_index_dir_t		**dirs;		// sorted by name, so flights are sorted by date
+	uint32_t				nb_dirs;
+	uint32_t				max_dirs;
+	uint64_t				flight_bytes;	// bytes in the ACADEMY_INDEX_DIR_FLIGHT directories
+	bool_t					dirty;		// changed since saved
+
+	// Directory moved out of root, until the event of its new name
+	academy_index_dir_t		*moved_dir;
+	uint32_t				moved_cookie;
+} academy_index_t;
+
+/**
+ * Entries of a FTP listing, sorted by name. The names are in the block of the entries
+ */
+typedef struct _academy_listing_entry_t_
+{
+	char	*name;
+	bool_t	is_directory;
+} academy_listing_entry_t;
+
+typedef struct _academy_listing_t_
+{
+	academy_listing_entry_t	*entries;
+	int32_t					nb_entries;
+} academy_listing_t;
+
+C_RESULT academy_index_open(academy_index_t *index, const char *root);
+void academy_index_close(academy_index_t *index);
+
+/**
+ * Applies the changes made since the last call. Does not block
+ */
+void academy_index_update(academy_index_t *index);
+
+/**
+ * Saves the index if it changed
+ */
+C_RESULT academy_index_save(academy_index_t *index);
+
+static inline uint64_t academy_index_flight_bytes(const academy_index_t *index)
+{
+	return index->flight_bytes;
+}
+
+/**
+ * @return Oldest downloaded flight, NULL if none
+ */
+const academy_index_dir_t *academy_index_oldest_flight(const academy_index_t *index);
+
+/**
+ * @return Directory named name, NULL if none. O(log n)
+ */
+academy_index_dir_t *academy_index_find_dir(const academy_index_t *index, const char *name);
+
+/**
+ * Removes a directory of root with its files
+ */
+C_RESULT academy_index_remove_dir(academy_index_t *index, const char *name);
+
+/**
+ * Parses the answer of ftpList once
+ */
+C_RESULT academy_listing_parse(academy_listing_t *listing, const char *list);
+void academy_listing_free(academy_listing_t *listing);
+
+/**
+ * Like academy_get_next_item_with_prefix, in name order : set *next_item to -1 for the first call.
+ * The first call is O(log n), the next ones go on from the previous item.
+ */
+const char *academy_listing_next_item(const academy_listing_t *listing, int32_t *next_item, const char *prefix, bool_t isDirectory);
+
+#endif // _ACADEMY_INDEX_H_
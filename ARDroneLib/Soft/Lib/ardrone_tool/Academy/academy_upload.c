@@ -6,6 +6,7 @@
  *
  */
 #include <ardrone_tool/Academy/academy_upload.h>
+#include <ardrone_tool/Academy/academy_index.h>
 
 typedef struct _academy_upload_t_
 {
@@ -195,7 +196,7 @@ DEFINE_THREAD_ROUTINE(academy_upload, data)
 	char dirname[ACADEMY_MAX_FILENAME];
 	_ftp_t *academy_ftp = NULL;
 	_ftp_status academy_status;
-	char *ptr = NULL;
+	const char *ptr = NULL;
 	academy_upload_t *academy = (academy_upload_t *)data;
 
 	printf("Start thread %s\n", __FUNCTION__);
@@ -262,9 +263,12 @@ DEFINE_THREAD_ROUTINE(academy_upload, data)
 						if(FTP_SUCCEDED(academy_status))
 						{
 							bool_t found = FALSE;
-							char *next_dir = NULL;
+							int32_t next_dir = -1;
+							academy_listing_t listing;
 
-							while(!found && (ptr = academy_get_next_item_with_prefix(directoryList, &next_dir, "flight_", TRUE)))
+							// Sorted listing : the search starts at dirname
+							academy_listing_parse(&listing, directoryList);
+							while(!found && (ptr = academy_listing_next_item(&listing, &next_dir, dirname, TRUE)))
 							{
 								if(strcmp(ptr, dirname) == 0)
 								{
@@ -272,6 +276,7 @@ DEFINE_THREAD_ROUTINE(academy_upload, data)
 									academy_upload_setState(academy, ACADEMY_STATE_FINISH_PROCESS);
 								}
 							}
+							academy_listing_free(&listing);
 
 							if(directoryList != NULL)
 							{
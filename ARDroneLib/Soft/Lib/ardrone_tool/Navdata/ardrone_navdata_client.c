@@ -3,12 +3,18 @@
 
 #include <config.h>
 
+#include <VP_Os/vp_os_malloc.h>
 #include <VP_Os/vp_os_print.h>
+#include <VP_Os/vp_os_trace.h>
 #include <VP_Com/vp_com.h>
+#ifndef _WIN32
+#include <VP_Com/vp_com_reactor.h>
+#endif
 
 #include <ardrone_api.h>
 #include <ardrone_tool/ardrone_tool.h>
 #include <ardrone_tool/Navdata/ardrone_navdata_client.h>
+#include <ardrone_tool/Navdata/ardrone_navdata_snapshot.h>
 #include <ardrone_tool/Com/config_com.h>
 
 #ifndef _WIN32
@@ -16,9 +22,19 @@
 #include <sys/ioctl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <sys/time.h>
 #include <unistd.h>
 #endif
 
+// A few hundred packets : covers the reader thread being descheduled during WiFi bursts
+#define NAVDATA_SOCKET_BUFFER_SIZE  (256*1024)
+
+#define NAVDATA_TIMEOUT_MS          (1000)  // Without packet, the request is sent again
+#define NAVDATA_CHECK_PERIOD_MS     (100)
+
+// Packets queued for the handlers thread : 320 ms at 200 Hz
+#define NAVDATA_HANDLERS_QUEUE_DEPTH  (64)
+
 static bool_t navdata_thread_in_pause = TRUE;
 static bool_t bContinue = TRUE;
 static uint32_t num_retries = 0; 
@@ -28,6 +44,24 @@ static vp_os_mutex_t navdata_client_mutex;
 static vp_com_socket_t navdata_socket;
 static Read navdata_read      = NULL;
 static Write navdata_write    = NULL;
+static uint32_t navdata_sequence = NAVDATA_SEQUENCE_DEFAULT-1;
+
+// The handlers of ardrone_navdata_handler_table run in their own thread, fed by a snapshot subscriber
+PROTO_THREAD_ROUTINE( navdata_handlers, nomParams );
+
+static THREAD_HANDLE navdata_handlers_thread;
+static vp_os_mutex_t navdata_handlers_mutex;
+static vp_os_cond_t  navdata_handlers_condition;
+static volatile bool_t navdata_handlers_stop = FALSE;  // Set under navdata_handlers_mutex
+static uint32_t navdata_handled_rx_sec = 0;           // Reception time of the packet being handled
+static uint32_t navdata_handled_rx_nsec = 0;
+
+#ifndef _WIN32
+static vp_com_reactor_t navdata_reactor;
+static bool_t navdata_reactor_ready = FALSE;  // Guarded by navdata_client_mutex
+static C_RESULT navdata_res = C_OK;      // Last read, a failure ends the thread
+static uint32_t navdata_rx_time = 0;     // ms
+#endif
 
 uint8_t navdata_buffer[NAVDATA_MAX_SIZE];
 navdata_unpacked_t navdata_unpacked;
@@ -40,9 +74,17 @@ C_RESULT ardrone_navdata_client_init(void)
   navdata_socket.protocol = VP_COM_UDP;
   navdata_socket.is_multicast = 0;      // disable multicast for Navdata
   navdata_socket.multicast_base_addr = MULTICAST_BASE_ADDR;
+  navdata_socket.rcv_buffer_size = NAVDATA_SOCKET_BUFFER_SIZE;
+  navdata_socket.timestamps = 1;
+  navdata_socket.reuse_address = ARDRONE_TOOL_IS_SIMULATED_DRONE(wifi_ardrone_ip);
+#ifndef _WIN32
+  navdata_socket.block = VP_COM_DONTWAIT; // Read by the reactor when readable, never waits
+#endif
 
   vp_os_mutex_init(&navdata_client_mutex);
   vp_os_cond_init(&navdata_client_condition, &navdata_client_mutex);
+  vp_os_mutex_init(&navdata_handlers_mutex);
+  vp_os_cond_init(&navdata_handlers_condition, &navdata_handlers_mutex);
 	
   res = C_OK;
 
@@ -86,30 +128,236 @@ C_RESULT ardrone_navdata_open_server(void)
   return C_OK;
 }
 
+/**
+ * The control handler only wakes the control thread up : it runs in the
+ * navdata thread so that the ACK of the configuration is never delayed by
+ * the other handlers.
+ */
+static bool_t ardrone_navdata_client_is_immediate( int32_t i )
+{
+  return ardrone_navdata_handler_table[i].process == ardrone_navdata_control_process ? TRUE : FALSE;
+}
+
+/**
+ * Unpacks the packet in navdata_buffer and publishes it for the handlers thread
+ */
+static void ardrone_navdata_client_process( int32_t size )
+{
+  navdata_t* navdata = (navdata_t*) &navdata_buffer[0];
+  uint32_t cks, navdata_cks;
+  int32_t i;
+
+  if( navdata->header != NAVDATA_HEADER )
+    return;
+
+  if( ardrone_get_mask_from_state(navdata->ardrone_state, ARDRONE_COM_WATCHDOG_MASK) )
+  {
+    // reset sequence number because of com watchdog
+    // This code is mandatory because we can have a com watchdog without detecting it on mobile side :
+    //        Reconnection is fast enough (less than one second)
+    navdata_sequence = NAVDATA_SEQUENCE_DEFAULT-1;
+
+    if( ardrone_get_mask_from_state(navdata->ardrone_state, ARDRONE_NAVDATA_BOOTSTRAP) == FALSE )
+      ardrone_tool_send_com_watchdog(); // acknowledge
+  }
+
+  if( navdata->sequence > navdata_sequence )
+  {
+    i = 0;
+
+    VP_OS_TRACE_BEGIN_EVENT("navdata process");
+    ardrone_navdata_unpack_masked(&navdata_unpacked, navdata, &navdata_cks, ARDRONE_NAVDATA_UNPACK_MASK);
+    cks = ardrone_navdata_compute_cks( &navdata_buffer[0], size - sizeof(navdata_cks_t) );
+
+    if( cks == navdata_cks )
+    {
+      ardrone_navdata_snapshot_publish( &navdata_unpacked, navdata_socket.rx_timestamp_sec, navdata_socket.rx_timestamp_nsec );
+
+      while( ardrone_navdata_handler_table[i].init != NULL )
+      {
+        if( ardrone_navdata_handler_table[i].process != NULL && ardrone_navdata_client_is_immediate(i) )
+          ardrone_navdata_handler_table[i].process( &navdata_unpacked );
+
+        i++;
+      }
+
+      vp_os_mutex_lock( &navdata_handlers_mutex );
+      vp_os_cond_signal( &navdata_handlers_condition );
+      vp_os_mutex_unlock( &navdata_handlers_mutex );
+    }
+    else
+    {
+      PRINT("[Navdata] Checksum failed : %d (distant) / %d (local)\n", navdata_cks, cks);
+    }
+    VP_OS_TRACE_END_EVENT("navdata process");
+  }
+  else
+  {
+    PRINT("[Navdata] Sequence pb : %d (distant) / %d (local)\n", navdata->sequence, navdata_sequence);
+  }
+
+  navdata_sequence = navdata->sequence;
+}
+
+/**
+ * No packet for NAVDATA_TIMEOUT_MS : resends a request to the drone
+ */
+static void ardrone_navdata_client_timeout( void )
+{
+  PRINT("Timeout when reading navdatas - resending a navdata request on port %i\n",NAVDATA_PORT);
+  /* Resend a request to the drone to get navdatas */
+  ardrone_navdata_open_server();
+  navdata_sequence = NAVDATA_SEQUENCE_DEFAULT-1;
+  num_retries++;
+}
+
+#ifndef _WIN32
+static uint32_t ardrone_navdata_client_time_ms( void )
+{
+  struct timeval tv;
+  gettimeofday( &tv, NULL );
+  return (uint32_t)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+}
+
+/* Reactor handler of the navdata socket : the socket is readable, the read does not wait */
+static C_RESULT ardrone_navdata_client_receive( int32_t fd, uint32_t events, void* data )
+{
+  navdata_t* navdata = (navdata_t*) &navdata_buffer[0];
+  int32_t size = NAVDATA_MAX_SIZE;
+
+  navdata->header = 0; // Soft reset
+  VP_OS_TRACE_BEGIN_EVENT("navdata read");
+  navdata_res = navdata_read( (void*)&navdata_socket, &navdata_buffer[0], &size );
+  VP_OS_TRACE_END_EVENT("navdata read");
+
+  // A read error ends the thread, as with the blocking reads
+  if( VP_FAILED(navdata_res) )
+    return C_FAIL;
+
+  if( size > 0 )
+  {
+    navdata_rx_time = ardrone_navdata_client_time_ms();
+    num_retries = 0;
+    ardrone_navdata_client_process( size );
+  }
+
+  return C_OK;
+}
+
+/* Reactor timer : navdata timeout, same delay as the SO_RCVTIMEO of the blocking reads */
+static C_RESULT ardrone_navdata_client_check( int32_t fd, uint32_t events, void* data )
+{
+  uint32_t now = ardrone_navdata_client_time_ms();
+
+  if( now - navdata_rx_time >= NAVDATA_TIMEOUT_MS )
+  {
+    ardrone_navdata_client_timeout();
+    navdata_rx_time = now;
+  }
+
+  return C_OK;
+}
+#endif // ! _WIN32
+
+/**
+ * Gives every published packet to the handlers, in order : a slow handler
+ * delays neither the reception nor the watchdog and ACK handling.
+ */
+DEFINE_THREAD_ROUTINE( navdata_handlers, nomParams )
+{
+  ardrone_navdata_subscriber_t* subscriber = (ardrone_navdata_subscriber_t*) nomParams;
+  ardrone_navdata_snapshot_t* snapshot;
+  uint32_t sequence = 0, dropped = 0;
+  bool_t stop = FALSE;
+  int32_t i;
+
+  vp_os_trace_set_thread_name("navdata_handlers");
+
+  snapshot = (ardrone_navdata_snapshot_t*) vp_os_malloc( sizeof(ardrone_navdata_snapshot_t) );
+
+  while( snapshot != NULL && !stop )
+  {
+    vp_os_mutex_lock( &navdata_handlers_mutex );
+    while( !navdata_handlers_stop && ardrone_navdata_snapshot_sequence() == sequence )
+      vp_os_cond_wait( &navdata_handlers_condition );
+    stop      = navdata_handlers_stop;
+    sequence  = ardrone_navdata_snapshot_sequence();
+    vp_os_mutex_unlock( &navdata_handlers_mutex );
+
+    // The queued packets are not handled after ardrone_navdata_client_shutdown
+    while( !stop && !navdata_handlers_stop && ardrone_navdata_snapshot_pop( subscriber, snapshot ) )
+    {
+      navdata_handled_rx_sec  = snapshot->rx_sec;
+      navdata_handled_rx_nsec = snapshot->rx_nsec;
+
+      i = 0;
+      while( ardrone_navdata_handler_table[i].init != NULL )
+      {
+        if( ardrone_navdata_handler_table[i].process != NULL && !ardrone_navdata_client_is_immediate(i) )
+          ardrone_navdata_handler_table[i].process( &snapshot->navdata );
+
+        i++;
+      }
+    }
+
+    if( subscriber->dropped != dropped )
+    {
+      PRINT("[Navdata] %d packets not given to the handlers, they are too slow\n", subscriber->dropped - dropped);
+      dropped = subscriber->dropped;
+    }
+  }
+
+  vp_os_free( snapshot );
+
+  return (THREAD_RET)0;
+}
+
 DEFINE_THREAD_ROUTINE( navdata_update, nomParams )
 {
+  ardrone_navdata_subscriber_t* subscriber = NULL;
   C_RESULT res;
-  int32_t  i, size;
-  uint32_t cks, navdata_cks, sequence = NAVDATA_SEQUENCE_DEFAULT-1;
-  struct timeval tv;
+  int32_t  i;
 #ifdef _WIN32
+  int32_t  size;
   int timeout_for_windows=1000/*milliseconds*/;
 #endif
 
-
-  navdata_t* navdata = (navdata_t*) &navdata_buffer[0];
-
-  tv.tv_sec   = 1/*second*/;
-  tv.tv_usec  = 0;
-
   res = C_OK;
 
+  vp_os_trace_set_thread_name("navdata_update");
+
   if( VP_FAILED(vp_com_open(COM_NAVDATA(), &navdata_socket, &navdata_read, &navdata_write)) )
   {
     printf("VP_Com : Failed to open socket for navdata\n");
     res = C_FAIL;
   }
 
+#ifndef _WIN32
+  // The socket and the timeout are waited for by one reactor
+  if( VP_SUCCEEDED(res) && VP_FAILED(vp_com_reactor_init(&navdata_reactor)) )
+  {
+    printf("VP_Com : Failed to create the navdata reactor\n");
+    res = C_FAIL;
+  }
+  else if( VP_SUCCEEDED(res) )
+  {
+    navdata_rx_time = ardrone_navdata_client_time_ms();
+    if( VP_FAILED(vp_com_reactor_add(&navdata_reactor, (int32_t)navdata_socket.priv, VP_COM_REACTOR_READ, ardrone_navdata_client_receive, NULL))
+        || VP_FAILED(vp_com_reactor_add_timer(&navdata_reactor, NAVDATA_CHECK_PERIOD_MS, ardrone_navdata_client_check, NULL, NULL)) )
+    {
+      printf("VP_Com : Failed to register the navdata socket\n");
+      vp_com_reactor_shutdown(&navdata_reactor);
+      res = C_FAIL;
+    }
+    else
+    {
+      vp_os_mutex_lock(&navdata_client_mutex);
+      navdata_reactor_ready = TRUE;
+      vp_os_mutex_unlock(&navdata_client_mutex);
+    }
+  }
+#endif // ! _WIN32
+
   if( VP_SUCCEEDED(res) )
   {
     PRINT("Thread navdata_update in progress...\n");
@@ -119,8 +367,6 @@ DEFINE_THREAD_ROUTINE( navdata_update, nomParams )
 	/* Added by Stephane to force the drone start sending data. */
 	if(navdata_write)
 	{	int sizeinit = 5; navdata_write( (void*)&navdata_socket, (int8_t*)"Init", &sizeinit ); }
-#else
-	setsockopt((int32_t)navdata_socket.priv, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
 #endif
 
 
@@ -135,6 +381,17 @@ DEFINE_THREAD_ROUTINE( navdata_update, nomParams )
       i ++;
     }
 
+    subscriber = ardrone_navdata_snapshot_subscribe( NAVDATA_HANDLERS_QUEUE_DEPTH );
+    if( subscriber == NULL )
+    {
+      res = C_FAIL;
+    }
+    else
+    {
+      navdata_handlers_stop = FALSE;
+      vp_os_thread_create( thread_navdata_handlers, (THREAD_PARAMS)subscriber, &navdata_handlers_thread );
+    }
+
    navdata_thread_in_pause = FALSE;
     while( VP_SUCCEEDED(res) 
            && !ardrone_tool_exit() 
@@ -154,70 +411,36 @@ DEFINE_THREAD_ROUTINE( navdata_update, nomParams )
         continue;
       }
 
+#ifdef _WIN32
       size = NAVDATA_MAX_SIZE;
-      navdata->header = 0; // Soft reset
+      ((navdata_t*) &navdata_buffer[0])->header = 0; // Soft reset
       res = navdata_read( (void*)&navdata_socket, &navdata_buffer[0], &size );
-#ifdef _WIN32	
-	  if( size <= 0 )
-#else
-	  if( size == 0 )
-#endif
-		{
-			// timeout
-			PRINT("Timeout when reading navdatas - resending a navdata request on port %i\n",NAVDATA_PORT);
-			/* Resend a request to the drone to get navdatas */
-			ardrone_navdata_open_server();
-			sequence = NAVDATA_SEQUENCE_DEFAULT-1;
-			num_retries++;
-		} 
-		else
-         num_retries = 0;
-
-      if( VP_SUCCEEDED( res ) )
+      if( size <= 0 )
+      {
+        ardrone_navdata_client_timeout();
+      }
+      else
       {
-        if( navdata->header == NAVDATA_HEADER )
-        {
-          if( ardrone_get_mask_from_state(navdata->ardrone_state, ARDRONE_COM_WATCHDOG_MASK) )
-          {
-            // reset sequence number because of com watchdog
-            // This code is mandatory because we can have a com watchdog without detecting it on mobile side :
-            //        Reconnection is fast enough (less than one second)
-            sequence = NAVDATA_SEQUENCE_DEFAULT-1;
-
-            if( ardrone_get_mask_from_state(navdata->ardrone_state, ARDRONE_NAVDATA_BOOTSTRAP) == FALSE )
-              ardrone_tool_send_com_watchdog(); // acknowledge
-          }
-
-          if( navdata->sequence > sequence )
-          {
-            i = 0;
-
-            ardrone_navdata_unpack_all(&navdata_unpacked, navdata, &navdata_cks);
-            cks = ardrone_navdata_compute_cks( &navdata_buffer[0], size - sizeof(navdata_cks_t) );
-
-            if( cks == navdata_cks )
-            {
-              while( ardrone_navdata_handler_table[i].init != NULL )
-              {
-                if( ardrone_navdata_handler_table[i].process != NULL )
-                  ardrone_navdata_handler_table[i].process( &navdata_unpacked );
-
-                i++;
-              }
-            }
-            else
-            {
-              PRINT("[Navdata] Checksum failed : %d (distant) / %d (local)\n", navdata_cks, cks);
-            }
-          }
-          else
-          {
-            PRINT("[Navdata] Sequence pb : %d (distant) / %d (local)\n", navdata->sequence, sequence);
-          }
-
-          sequence = navdata->sequence;
-        }
+        num_retries = 0;
+        if( VP_SUCCEEDED( res ) )
+          ardrone_navdata_client_process( size );
       }
+#else
+      // Returns after a packet, the timeout check or ardrone_navdata_client_shutdown
+      vp_com_reactor_run_once( &navdata_reactor, -1 );
+      res = navdata_res;
+#endif // _WIN32
+    }
+
+    if( subscriber != NULL )
+    {
+      vp_os_mutex_lock( &navdata_handlers_mutex );
+      navdata_handlers_stop = TRUE;
+      vp_os_cond_signal( &navdata_handlers_condition );
+      vp_os_mutex_unlock( &navdata_handlers_mutex );
+
+      vp_os_thread_join( navdata_handlers_thread );
+      ardrone_navdata_snapshot_unsubscribe( subscriber );
     }
 
     // Release resources alllocated by handlers
@@ -228,6 +451,13 @@ DEFINE_THREAD_ROUTINE( navdata_update, nomParams )
 
       i ++;
     }
+
+#ifndef _WIN32
+    vp_os_mutex_lock(&navdata_client_mutex);
+    navdata_reactor_ready = FALSE;
+    vp_os_mutex_unlock(&navdata_client_mutex);
+    vp_com_reactor_shutdown( &navdata_reactor );
+#endif
   }
 
   vp_com_close(COM_NAVDATA(), &navdata_socket);
@@ -237,6 +467,12 @@ DEFINE_THREAD_ROUTINE( navdata_update, nomParams )
   return (THREAD_RET)res;
 }
 
+void ardrone_navdata_client_get_rx_timestamp(uint32_t* sec, uint32_t* nsec)
+{
+  *sec  = navdata_handled_rx_sec;
+  *nsec = navdata_handled_rx_nsec;
+}
+
 uint32_t ardrone_navdata_client_get_num_retries(void)
 {
   return num_retries;
@@ -247,6 +483,11 @@ C_RESULT ardrone_navdata_client_shutdown(void)
    bContinue = FALSE;
 
    vp_os_mutex_lock(&navdata_client_mutex);
+#ifndef _WIN32
+   // Wakes the thread up if it waits for a packet
+   if( navdata_reactor_ready )
+     vp_com_reactor_stop(&navdata_reactor);
+#endif
    vp_os_cond_signal(&navdata_client_condition);
    vp_os_mutex_unlock(&navdata_client_mutex);
    
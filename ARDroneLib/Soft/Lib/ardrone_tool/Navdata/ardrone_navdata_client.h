@@ -16,6 +16,8 @@
 
 // Facility to declare a set of navdata handler
 // Handler to resume control thread is mandatory
+// Handlers get every packet from a thread of their own (navdata_handlers),
+// except the control handler which is called from navdata_update
 #define BEGIN_NAVDATA_HANDLER_TABLE                                 \
     ardrone_navdata_handler_t ardrone_navdata_handler_table[] = { \
   { ardrone_navdata_control_init, ardrone_navdata_control_process, ardrone_navdata_control_release, NULL }, \
@@ -52,6 +54,9 @@ typedef enum
 extern ardrone_navdata_handler_t ardrone_navdata_handler_table[] WEAK;
 
 uint32_t ardrone_navdata_client_get_num_retries(void);
+// Kernel reception time of the navdata being processed (0 if not supported).
+// Only meaningful from the navdata handlers.
+void ardrone_navdata_client_get_rx_timestamp(uint32_t* sec, uint32_t* nsec);
 C_RESULT ardrone_navdata_client_init(void);
 C_RESULT ardrone_navdata_client_suspend(void);
 C_RESULT ardrone_navdata_client_resume(void);
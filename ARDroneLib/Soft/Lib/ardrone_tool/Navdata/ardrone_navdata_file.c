@@ -20,10 +20,14 @@
 
 #include <VP_Os/vp_os_malloc.h>
 #include <VP_Os/vp_os_print.h>
+#include <VP_Os/vp_os_thread.h>
+#include <VP_Os/vp_os_delay.h>
+#include <VP_Api/vp_api_thread_helper.h>
 
 #include <ardrone_tool/ardrone_tool.h>
 #include <ardrone_tool/Navdata/ardrone_navdata_file.h>
 #include <ardrone_tool/UI/ardrone_input.h>
+#include <utils/ardrone_spsc_ring.h>
 
 uint32_t num_picture_decoded = 0;
 
@@ -43,11 +47,11 @@ FILE* navdata_file = NULL;
 static FILE* navdata_file_private = NULL;
 static ardrone_navdata_file_data *navdata_file_data = NULL;
 
-static void ardrone_navdata_file_print_version( void )
+static void ardrone_navdata_file_print_version( FILE* file )
 {
   unsigned int i;
-  fprintf(navdata_file,"VERSION 19c\n");  // TODO : CHANGE VERSION NUMBER EVERY TIME THE FILE STRUCTURE CHANGES
-  fprintf(navdata_file,
+  fprintf(file,"VERSION 19c\n");  // TODO : CHANGE VERSION NUMBER EVERY TIME THE FILE STRUCTURE CHANGES
+  fprintf(file,
   "Control_state [-]; ARDrone_state [-]; Time [s]; nd_seq_num [-]; \
     AccX_raw [LSB]; AccY_raw [LSB]; AccZ_raw [LSB]; \
     GyroX_raw [LSB]; GyroY_raw [LSB]; GyroZ_raw [LSB]; GyroZIMMU3000 [LSB]; GyroX_110_raw [LSB]; GyroY_110_raw [LSB];Battery_Voltage_raw [mV]; \
@@ -115,40 +119,152 @@ static void ardrone_navdata_file_print_version( void )
     hdvideo_frame_number [-];");
 
 /*  for(i = 0 ; i < DEFAULT_NB_TRACKERS_WIDTH*DEFAULT_NB_TRACKERS_HEIGHT ; i++)
-    fprintf(navdata_file, "Locked_%u; X_%u; Y_%u; ", i, i, i);
+    fprintf(file, "Locked_%u; X_%u; Y_%u; ", i, i, i);
 */
-  fprintf(navdata_file, "Nb_detected; ");
+  fprintf(file, "Nb_detected; ");
 
   for(i = 0 ; i < 4 ; i++)
-    fprintf(navdata_file, "Type_%u; Xd_%u; Yd_%u; W_%u; H_%u; D_%u; O_%u; ", i, i, i, i, i, i, i);
+    fprintf(file, "Type_%u; Xd_%u; Yd_%u; W_%u; H_%u; D_%u; O_%u; ", i, i, i, i, i, i, i);
 
-  fprintf(navdata_file, "Perf_szo [ms]; Perf_corners [ms]; Perf_compute [ms]; Perf_tracking [ms]; Perf_trans [ms]; Perf_update [ms]; ");
+  fprintf(file, "Perf_szo [ms]; Perf_corners [ms]; Perf_compute [ms]; Perf_tracking [ms]; Perf_trans [ms]; Perf_update [ms]; ");
 
 	for(i=0; i<NAVDATA_MAX_CUSTOM_TIME_SAVE; i++)
-		fprintf(navdata_file, "Perf_Custom_%u; ", i);
+		fprintf(file, "Perf_Custom_%u; ", i);
 
   // tags after "flag_new_picture" will be written on the IHM side
-  fprintf(navdata_file, "Watchdog Control [-]; flag_new_picture [-]; Sample time [s]; ");
+  fprintf(file, "Watchdog Control [-]; flag_new_picture [-]; Sample time [s]; ");
 
-  fprintf(navdata_file, "Vx_Ref_[mm/s]; Vy_Ref_[mm/s]; Theta_modele [rad]; Phi_modele [rad]; k_v_x [-]; k_v_y [-]; k_mode [-];UI Time [-]; Theta UI [-]; Phi UI [-];Psi UI [-];Psi_accuracy UI [-]; UI_Seq;");
+  fprintf(file, "Vx_Ref_[mm/s]; Vy_Ref_[mm/s]; Theta_modele [rad]; Phi_modele [rad]; k_v_x [-]; k_v_y [-]; k_mode [-];UI Time [-]; Theta UI [-]; Phi UI [-];Psi UI [-];Psi_accuracy UI [-]; UI_Seq;");
 
   #ifdef PC_USE_POLARIS
-    fprintf( navdata_file,
+    fprintf( file,
     "POLARIS_X [mm]; POLARIS_Y [mm]; POLARIS_Z [mm]; \
   POLARIS_QX [deg]; POLARIS_QY [deg]; POLARIS_QZ [deg];\
   POLARIS_Q0 [deg]; Time s [s]; Time us [us]; ");
   #endif
 
   #ifdef USE_TABLE_PILOTAGE
-      fprintf( navdata_file, " Table_Pilotage_position [mdeg]; Table_Pilotage_vitesse [deg/s]; ");
+      fprintf( file, " Table_Pilotage_position [mdeg]; Table_Pilotage_vitesse [deg/s]; ");
   #endif
 
 	if((navdata_file_data != NULL) && (navdata_file_data->print_header != NULL))
-		navdata_file_data->print_header(navdata_file);
+		navdata_file_data->print_header(file);
 }
 
 struct tm *navdata_atm = NULL;
 
+/********************************************************************
+ * Binary format : the navdata thread only copies the received options
+ * in a lock-free ring, a background thread writes them to the file.
+ *******************************************************************/
+#define NAVDATA_FILE_RING_SIZE        (1024 * 1024)
+#define NAVDATA_FILE_WRITER_PERIOD_MS (20)
+
+static ardrone_spsc_ring_t navdata_file_ring;
+static THREAD_HANDLE navdata_file_writer_thread;
+static volatile bool_t navdata_file_writer_running = FALSE;
+static bool_t navdata_file_writer_started = FALSE;   // Only used by the navdata thread
+static uint32_t navdata_file_dropped_records = 0;
+static uint8_t navdata_file_record_buffer[sizeof(ardrone_navdata_file_record_t) + sizeof(navdata_unpacked_t)];
+
+DEFINE_THREAD_ROUTINE(ardrone_navdata_file_writer, data)
+{
+  const uint8_t* ptr;
+  uint32_t size;
+  bool_t running = TRUE;
+
+  while( running )
+  {
+    // Read the flag before draining the ring so that nothing pushed before the stop is lost
+    running = navdata_file_writer_running;
+
+    while( (size = ardrone_spsc_ring_peek(&navdata_file_ring, &ptr)) > 0 )
+    {
+      fwrite(ptr, 1, size, navdata_file);
+      ardrone_spsc_ring_consume(&navdata_file_ring, size);
+    }
+
+    if( running )
+      vp_os_delay(NAVDATA_FILE_WRITER_PERIOD_MS);
+  }
+
+  THREAD_RETURN(0);
+}
+
+static C_RESULT ardrone_navdata_file_binary_header( FILE* file )
+{
+  ardrone_navdata_file_header_t header;
+
+  header.magic              = NAVDATA_FILE_BINARY_MAGIC;
+  header.version            = NAVDATA_FILE_BINARY_VERSION;
+  header.header_size        = sizeof(ardrone_navdata_file_header_t);
+  header.record_header_size = sizeof(ardrone_navdata_file_record_t);
+
+  return fwrite(&header, sizeof(header), 1, file) == 1 ? C_OK : C_FAIL;
+}
+
+/* The writer thread writes into navdata_file, which has to stay the same until it is stopped */
+static C_RESULT ardrone_navdata_file_binary_open( void )
+{
+  if( VP_FAILED(ardrone_spsc_ring_init(&navdata_file_ring, NAVDATA_FILE_RING_SIZE)) )
+    return C_FAIL;
+
+  navdata_file_dropped_records = 0;
+  navdata_file_writer_running = TRUE;
+  navdata_file_writer_started = TRUE;
+  vp_os_thread_create(thread_ardrone_navdata_file_writer, (THREAD_PARAMS)NULL, &navdata_file_writer_thread);
+
+  return C_OK;
+}
+
+/* Stops the writer thread, if any, once every queued record is in navdata_file */
+static void ardrone_navdata_file_binary_close( void )
+{
+  if( !navdata_file_writer_started )
+    return;
+
+  navdata_file_writer_started = FALSE;
+  navdata_file_writer_running = FALSE;
+  vp_os_thread_join(navdata_file_writer_thread);
+  ardrone_spsc_ring_release(&navdata_file_ring);
+
+  if( navdata_file_dropped_records > 0 )
+    PRINT("[Navdata file] %u records dropped, disk too slow\n", (unsigned int)navdata_file_dropped_records);
+}
+
+static void ardrone_navdata_file_binary_write( const navdata_unpacked_t* const pnd, const ardrone_navdata_file_record_t* record )
+{
+  ardrone_navdata_file_record_t* out = (ardrone_navdata_file_record_t*) &navdata_file_record_buffer[0];
+  uint8_t* ptr = &navdata_file_record_buffer[sizeof(ardrone_navdata_file_record_t)];
+  navdata_option_t* option;
+
+  *out = *record;
+
+  // Options are stored as on the network, with their tag and size
+#define NAVDATA_OPTION_DEMO(STRUCTURE,NAME,TAG)  NAVDATA_OPTION(STRUCTURE,NAME,TAG)
+#define NAVDATA_OPTION(STRUCTURE,NAME,TAG)                  \
+  if( record->options_mask & NAVDATA_OPTION_MASK(TAG) )     \
+  {                                                         \
+    vp_os_memcpy(ptr, &pnd->NAME, sizeof(STRUCTURE));       \
+    option = (navdata_option_t*) ptr;                       \
+    option->tag  = TAG;                                     \
+    option->size = sizeof(STRUCTURE);                       \
+    ptr += sizeof(STRUCTURE);                               \
+  }
+#define NAVDATA_OPTION_CKS(STRUCTURE,NAME,TAG)
+#include <navdata_keys.h>
+
+  out->size = (uint32_t)(ptr - &navdata_file_record_buffer[0]);
+
+  if( !ardrone_spsc_ring_push(&navdata_file_ring, &navdata_file_record_buffer[0], out->size) )
+    navdata_file_dropped_records++;
+}
+
+static bool_t ardrone_navdata_file_is_binary( void )
+{
+  return (navdata_file_data != NULL) && (navdata_file_data->format == NAVDATA_FILE_FORMAT_BINARY);
+}
+
 C_RESULT ardrone_navdata_file_init( void* data )
 {
   char filename[1024];
@@ -169,77 +285,46 @@ C_RESULT ardrone_navdata_file_init( void* data )
   }
   else
   {
-      sprintf(filename, "%s/mesures_%04d%02d%02d_%02d%02d%02d.txt",
+      sprintf(filename, "%s/mesures_%04d%02d%02d_%02d%02d%02d.%s",
         filename,
         navdata_atm->tm_year+1900, navdata_atm->tm_mon+1, navdata_atm->tm_mday,
-        navdata_atm->tm_hour, navdata_atm->tm_min, navdata_atm->tm_sec);
+        navdata_atm->tm_hour, navdata_atm->tm_min, navdata_atm->tm_sec,
+        ardrone_navdata_file_is_binary() ? "bin" : "txt");
   }
 
   // private for instance
+  // A call while navdata_file is open asks for a new file, navdata_file_process switches to it
   navdata_file_private = fopen(filename, "wb");
 
+  if( navdata_file_private != NULL && ardrone_navdata_file_is_binary() )
+  {
+    if( VP_FAILED(ardrone_navdata_file_binary_header(navdata_file_private)) )
+    {
+      fclose(navdata_file_private);
+      navdata_file_private = NULL;
+    }
+  }
+
   return navdata_file_private != NULL ? C_OK : C_FAIL;
 }
 
-C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
+/* Writes one CSV line. Values which are not navdata options come from the record. */
+static void ardrone_navdata_file_print_csv( FILE* file, const navdata_unpacked_t* const pnd, const ardrone_navdata_file_record_t* record )
 {
 	uint32_t i;
 	char str[50];
 	int32_t* locked_ptr;
 	screen_point_t* point_ptr;
-	struct timeval time;
-	input_state_t *input_state = NULL;
-
-	gettimeofday(&time,NULL);
-
-	if( navdata_file_private == NULL )
-		return C_FAIL;
-
-	if( ardrone_get_mask_from_state(pnd->ardrone_state, ARDRONE_NAVDATA_BOOTSTRAP) )
-		return C_OK;
-
-	if( navdata_file == NULL )
-	{
-		navdata_file = navdata_file_private;
-
-		if( ardrone_get_mask_from_state(pnd->ardrone_state, ARDRONE_NAVDATA_DEMO_MASK) )
-		{
-			printf("Receiving navdata demo\n");
-		}
-		else
-		{
-			printf("Receiving all navdata\n");
-		}
-		ardrone_navdata_file_print_version();
-	}
-
-	// Handle the case where user asked for a new navdata file
-	if( navdata_file != navdata_file_private )
-	{
-		fclose(navdata_file);
-		navdata_file = navdata_file_private;
-
-		if( ardrone_get_mask_from_state(pnd->ardrone_state, ARDRONE_NAVDATA_DEMO_MASK) )
-		{
-			printf("Receiving navdata demo\n");
-		}
-		else
-		{
-			printf("Receiving all navdata\n");
-		}
-		ardrone_navdata_file_print_version();
-	}
 
 	vp_os_memset(&str[0], 0, sizeof(str));
-	input_state = ardrone_tool_input_get_state();
-	fprintf( navdata_file,"\n" );
-	fprintf( navdata_file, "%u; %u", (unsigned int) pnd->navdata_demo.ctrl_state, (unsigned int) pnd->ardrone_state );
+	fprintf( file,"\n" );
+	fprintf( file, "%u; %u", (unsigned int) pnd->navdata_demo.ctrl_state, (unsigned int) pnd->ardrone_state );
 
 	sprintf( str, "%d.%06d", (int)((pnd->navdata_time.time & TSECMASK) >> TSECDEC), (int)(pnd->navdata_time.time & TUSECMASK) );
-	fprintf( navdata_file, ";%s", str );
-	fprintf( navdata_file, "; %u", (unsigned int) pnd->nd_seq);
+	fprintf( file, ";%s", str );
+	fprintf( file, "; %u", (unsigned int) pnd->nd_seq);
 
-	fprintf( navdata_file, "; %04u; %04u; %04u; %04d; %04d; %04d; %04d; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04d; %04d",
+	fprintf( file, "; %04u; %04u; %04u; %04d; %04d; %04d; %04d; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04u; %04d; %04d",
 			(unsigned int) pnd->navdata_raw_measures.raw_accs[ACC_X],
 			(unsigned int) pnd->navdata_raw_measures.raw_accs[ACC_Y],
 			(unsigned int) pnd->navdata_raw_measures.raw_accs[ACC_Z],
@@ -269,19 +354,19 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 	        );
 
 
-	fprintf( navdata_file, "; %10u; %10u; %10u; %10u",
+	fprintf( file, "; %10u; %10u; %10u; %10u",
 			(signed int) pnd->navdata_pressure_raw.up,
 			(signed int) pnd->navdata_pressure_raw.ut,
 			(signed int) pnd->navdata_pressure_raw.Temperature_meas,
 			(signed int) pnd->navdata_pressure_raw.Pression_meas );
 
 
-	fprintf( navdata_file, "; %6f; %6f; %6f",
+	fprintf( file, "; %6f; %6f; %6f",
 			pnd->navdata_kalman_pressure.prediction_US,
 			pnd->navdata_kalman_pressure.somme_inno,
 			pnd->navdata_kalman_pressure.offset_pressure);
 
-	fprintf( navdata_file, "; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6d; %6d; %6f",
+	fprintf( file, "; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6d; %6d; %6f",
 			pnd->navdata_kalman_pressure.est_z,
 			pnd->navdata_kalman_pressure.est_zdot,
 			pnd->navdata_kalman_pressure.est_bias_PWM,
@@ -293,7 +378,7 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			pnd->navdata_kalman_pressure.flag_rejet_US,
 			pnd->navdata_kalman_pressure.cov_vitesse);
 
-	fprintf( navdata_file, "; %5d; %5d; %5d; %6f; %6f; %6f; %6f; %6f; %6f",
+	fprintf( file, "; %5d; %5d; %5d; %6f; %6f; %6f; %6f; %6f; %6f",
 			(signed int) pnd->navdata_magneto.mx,
 			(signed int) pnd->navdata_magneto.my,
 			(signed int) pnd->navdata_magneto.mz,
@@ -304,7 +389,7 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			pnd->navdata_magneto.magneto_rectified.y,
 			pnd->navdata_magneto.magneto_rectified.z);
 
-	fprintf( navdata_file, "; %6f; %6f; %6f; %6f; %6f; %6f",
+	fprintf( file, "; %6f; %6f; %6f; %6f; %6f; %6f",
 			pnd->navdata_magneto.magneto_offset.x,
 			pnd->navdata_magneto.magneto_offset.y,
 			pnd->navdata_magneto.magneto_offset.z,
@@ -312,7 +397,7 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			pnd->navdata_magneto.heading_gyro_unwrapped,
 			pnd->navdata_magneto.heading_fusion_unwrapped);
 
-	fprintf( navdata_file, "; %d; %d; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f",
+	fprintf( file, "; %d; %d; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f; %6f",
 			pnd->navdata_magneto.magneto_calibration_ok,
 			pnd->navdata_magneto.magneto_state,
 			pnd->navdata_wind_speed.wind_speed,
@@ -332,7 +417,7 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			pnd->navdata_wind_speed.magneto_debug2,
 			pnd->navdata_wind_speed.magneto_debug3);
 
-	fprintf( navdata_file, "; %f; %04u; % 5f; % 5f; % 5f; % 6f; % 6f; % 6f; %6f",
+	fprintf( file, "; %f; %04u; % 5f; % 5f; % 5f; % 6f; % 6f; % 6f; %6f",
 			pnd->navdata_phys_measures.accs_temp,
 			(unsigned int)pnd->navdata_phys_measures.gyro_temp,
 			pnd->navdata_phys_measures.phys_accs[ACC_X],
@@ -343,16 +428,16 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			pnd->navdata_phys_measures.phys_gyros[GYRO_Z],
 			pnd->navdata_zimmu_3000.vzfind                );
 
-	fprintf( navdata_file, "; % f; % f; % f",
+	fprintf( file, "; % f; % f; % f",
 			pnd->navdata_gyros_offsets.offset_g[GYRO_X],
 			pnd->navdata_gyros_offsets.offset_g[GYRO_Y],
 			pnd->navdata_gyros_offsets.offset_g[GYRO_Z] );
 
-	fprintf( navdata_file, "; % f; % f",
+	fprintf( file, "; % f; % f",
 			pnd->navdata_euler_angles.theta_a,
 			pnd->navdata_euler_angles.phi_a);
 
-	fprintf( navdata_file, ";  %04d; %04d; %04d; %04d; %04d; %06d; %06d; %06d",
+	fprintf( file, ";  %04d; %04d; %04d; %04d; %04d; %06d; %06d; %06d",
 			(int) pnd->navdata_references.ref_theta,
 			(int) pnd->navdata_references.ref_phi,
 			(int) pnd->navdata_references.ref_psi,
@@ -362,20 +447,20 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			(int) pnd->navdata_references.ref_roll,
 			(int) pnd->navdata_references.ref_yaw );
 
-	fprintf( navdata_file, "; % 8.6f; % 8.6f; % 8.6f",
+	fprintf( file, "; % 8.6f; % 8.6f; % 8.6f",
 			pnd->navdata_trims.euler_angles_trim_theta,
 			pnd->navdata_trims.euler_angles_trim_phi,
 			pnd->navdata_trims.angular_rates_trim_r );
 
-	fprintf( navdata_file, "; %04d; %04d; %04d; %04d; %04d; %04u",
+	fprintf( file, "; %04d; %04d; %04d; %04d; %04d; %04u",
 			(int) pnd->navdata_rc_references.rc_ref_pitch,
 			(int) pnd->navdata_rc_references.rc_ref_roll,
 			(int) pnd->navdata_rc_references.rc_ref_yaw,
 			(int) pnd->navdata_rc_references.rc_ref_gaz,
 			(int) pnd->navdata_rc_references.rc_ref_ag,
-			(unsigned int) input_state->user_input );
+			(unsigned int) record->user_input );
 
-	fprintf( navdata_file, "; %03u; %03u; %03u; %03u; %03u; %03u; %03u; %03u",
+	fprintf( file, "; %03u; %03u; %03u; %03u; %03u; %03u; %03u; %03u",
 			(unsigned int) pnd->navdata_pwm.motor1,
 			(unsigned int) pnd->navdata_pwm.motor2,
 			(unsigned int) pnd->navdata_pwm.motor3,
@@ -385,7 +470,7 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			(unsigned int) pnd->navdata_pwm.sat_motor3,
 			(unsigned int) pnd->navdata_pwm.sat_motor4);
 
-	fprintf( navdata_file, "; %6f; %6f;%6f; %6f;%6f; %6f",
+	fprintf( file, "; %6f; %6f;%6f; %6f;%6f; %6f",
 			pnd->navdata_pwm.gaz_feed_forward,
 			pnd->navdata_pwm.gaz_altitude,
 			pnd->navdata_pwm.altitude_integral,
@@ -393,31 +478,31 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			pnd->navdata_pwm.altitude_prop,
 			pnd->navdata_pwm.altitude_der);
 
-	fprintf( navdata_file, "; %03d; %03d; %03d; %f",
+	fprintf( file, "; %03d; %03d; %03d; %f",
 			(int) pnd->navdata_pwm.u_pitch,
 			(int) pnd->navdata_pwm.u_roll,
 			(int) pnd->navdata_pwm.u_yaw,
 			pnd->navdata_pwm.yaw_u_I);
 
-	fprintf( navdata_file, "; %03d; %03d; %03d; %f",
+	fprintf( file, "; %03d; %03d; %03d; %f",
 			(int) pnd->navdata_pwm.u_pitch_planif,
 			(int) pnd->navdata_pwm.u_roll_planif,
 			(int) pnd->navdata_pwm.u_yaw_planif,
 			pnd->navdata_pwm.u_gaz_planif);
 
-	fprintf(navdata_file, "; %04d; %04d; %04d; %04d",
+	fprintf(file, "; %04d; %04d; %04d; %04d",
 			(int) pnd->navdata_pwm.current_motor1,
 			(int) pnd->navdata_pwm.current_motor2,
 			(int) pnd->navdata_pwm.current_motor3,
 			(int) pnd->navdata_pwm.current_motor4 );
 
-	fprintf( navdata_file, "; %04d; %f; %04d;%04u",
+	fprintf( file, "; %04d; %f; %04d;%04u",
 			(int) pnd->navdata_altitude.altitude_vision,
 			pnd->navdata_altitude.altitude_vz,
 			(int) pnd->navdata_altitude.altitude_ref,
 			(unsigned int) pnd->navdata_altitude.altitude_raw );
 
-	fprintf( navdata_file, "; %f; %f; %f; %f; %f; %04u; %f; %f; %04u",
+	fprintf( file, "; %f; %f; %f; %f; %f; %04u; %f; %f; %04u",
 			pnd->navdata_altitude.obs_accZ,
 			pnd->navdata_altitude.obs_alt,
 			pnd->navdata_altitude.obs_x.v[0],
@@ -431,7 +516,7 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 	vp_os_memset(&str[0], 0, sizeof(str));
 	sprintf( str, "%d.%06d", (int)((pnd->navdata_vision.time_capture & TSECMASK) >> TSECDEC), (int)(pnd->navdata_vision.time_capture & TUSECMASK) );
 
-	fprintf( navdata_file, "; % 8.6f; % 8.6f; % 8.6f; %u; %u; % f;% f;% f;% f; % f; % f; % f; %u; % f; % f; % f; % f; % f; % f; % d; %s",
+	fprintf( file, "; % 8.6f; % 8.6f; % 8.6f; %u; %u; % f;% f;% f;% f; % f; % f; % f; %u; % f; % f; % f; % f; % f; % f; % d; %s",
 			pnd->navdata_vision_raw.vision_tx_raw,
 			pnd->navdata_vision_raw.vision_ty_raw,
 			pnd->navdata_vision_raw.vision_tz_raw,
@@ -454,25 +539,25 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			(int)pnd->navdata_vision.altitude_capture,
 			str );
 
-	fprintf( navdata_file, "; %04u",
+	fprintf( file, "; %04u",
 			(unsigned int) pnd->navdata_demo.vbat_flying_percentage );
 
-	fprintf( navdata_file, "; % f; % f; % f",
+	fprintf( file, "; % f; % f; % f",
 			pnd->navdata_demo.theta,
 			pnd->navdata_demo.phi,
 			pnd->navdata_demo.psi );
 
-	fprintf( navdata_file, "; %04d",
+	fprintf( file, "; %04d",
 			(int) pnd->navdata_demo.altitude );
 
-	fprintf( navdata_file, "; %f; %f; %f ",
+	fprintf( file, "; %f; %f; %f ",
 			pnd->navdata_demo.vx,
 			pnd->navdata_demo.vy,
 			pnd->navdata_demo.vz );
 
-	fprintf( navdata_file, "; %04u", (unsigned int) pnd->navdata_demo.num_frames );
+	fprintf( file, "; %04u", (unsigned int) pnd->navdata_demo.num_frames );
 
-	fprintf( navdata_file, "; %f; %f; %f; %f; %f; %f; %f; %f; %f", pnd->navdata_demo.detection_camera_rot.m11,
+	fprintf( file, "; %f; %f; %f; %f; %f; %f; %f; %f; %f", pnd->navdata_demo.detection_camera_rot.m11,
 			pnd->navdata_demo.detection_camera_rot.m12,
 			pnd->navdata_demo.detection_camera_rot.m13,
 			pnd->navdata_demo.detection_camera_rot.m21,
@@ -482,15 +567,15 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			pnd->navdata_demo.detection_camera_rot.m32,
 			pnd->navdata_demo.detection_camera_rot.m33);
 
-	fprintf( navdata_file, "; %f; %f; %f", pnd->navdata_demo.detection_camera_trans.x,
+	fprintf( file, "; %f; %f; %f", pnd->navdata_demo.detection_camera_trans.x,
 			pnd->navdata_demo.detection_camera_trans.y,
 			pnd->navdata_demo.detection_camera_trans.z);
 
-	fprintf( navdata_file, "; %04u; %04u",
+	fprintf( file, "; %04u; %04u",
 			(unsigned int) pnd->navdata_demo.detection_tag_index,
 			(unsigned int) pnd->navdata_demo.detection_camera_type);
 
-	fprintf( navdata_file, "; %f; %f; %f; %f; %f; %f; %f; %f; %f", pnd->navdata_demo.drone_camera_rot.m11,
+	fprintf( file, "; %f; %f; %f; %f; %f; %f; %f; %f; %f", pnd->navdata_demo.drone_camera_rot.m11,
 			pnd->navdata_demo.drone_camera_rot.m12,
 			pnd->navdata_demo.drone_camera_rot.m13,
 			pnd->navdata_demo.drone_camera_rot.m21,
@@ -500,19 +585,19 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 			pnd->navdata_demo.drone_camera_rot.m32,
 			pnd->navdata_demo.drone_camera_rot.m33);
 
-	fprintf( navdata_file, "; %f; %f; %f", pnd->navdata_demo.drone_camera_trans.x,
+	fprintf( file, "; %f; %f; %f", pnd->navdata_demo.drone_camera_trans.x,
 			pnd->navdata_demo.drone_camera_trans.y,
 			pnd->navdata_demo.drone_camera_trans.z);
 
-	fprintf( navdata_file, "; %d; %f; %f; %f; %f",
-			(int)nd_iphone_flag,
-			nd_iphone_phi,
-			nd_iphone_theta,
-			nd_iphone_gaz,
-			nd_iphone_yaw);
+	fprintf( file, "; %d; %f; %f; %f; %f",
+			(int)record->iphone_flag,
+			record->iphone_phi,
+			record->iphone_theta,
+			record->iphone_gaz,
+			record->iphone_yaw);
 
 	/* Store information regarding the live video stream and the associated rate control */
-	fprintf( navdata_file, "; %d; %d; %d; %d; %d; %f; %d; %d; %d; %d; %d",
+	fprintf( file, "; %d; %d; %d; %d; %d; %f; %d; %d; %d; %d; %d",
 			pnd->navdata_video_stream.quant,
 			pnd->navdata_video_stream.frame_size,
 			pnd->navdata_video_stream.frame_number,
@@ -527,7 +612,7 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 	);
 
 	/* Store information regarding the HD storage stream */
-	fprintf( navdata_file, "; %d",
+	fprintf( file, "; %d",
 			pnd->navdata_hdvideo_stream.frame_number
 			);
 
@@ -539,17 +624,17 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 /*
 	for(i = 0; i < DEFAULT_NB_TRACKERS_WIDTH*DEFAULT_NB_TRACKERS_HEIGHT; i++)
 	{
-		fprintf( navdata_file, "; %d; %u; %u",
+		fprintf( file, "; %d; %u; %u",
 				(int) *locked_ptr++,
 				(unsigned int) point_ptr->x,
 				(unsigned int) point_ptr->y );
 		point_ptr++;
 	}
 */
-	fprintf( navdata_file, "; %u", (unsigned int) pnd->navdata_vision_detect.nb_detected );
+	fprintf( file, "; %u", (unsigned int) pnd->navdata_vision_detect.nb_detected );
 	for(i = 0 ; i < 4 ; i++)
 	{
-		fprintf( navdata_file, "; %u; %u; %u; %u; %u; %u; %f",
+		fprintf( file, "; %u; %u; %u; %u; %u; %u; %f",
 				(unsigned int) pnd->navdata_vision_detect.type[i],
 				(unsigned int) pnd->navdata_vision_detect.xc[i],
 				(unsigned int) pnd->navdata_vision_detect.yc[i],
@@ -559,7 +644,7 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 				pnd->navdata_vision_detect.orientation_angle[i]);
 	}
 
-	fprintf( navdata_file, "; %f; %f; %f; %f; %f; %f",
+	fprintf( file, "; %f; %f; %f; %f; %f; %f",
 			pnd->navdata_vision_perf.time_szo,
 			pnd->navdata_vision_perf.time_corners,
 			pnd->navdata_vision_perf.time_compute,
@@ -569,17 +654,17 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
 
 	for(i = 0 ; i < NAVDATA_MAX_CUSTOM_TIME_SAVE ; i++)
 	{
-		fprintf( navdata_file, "; %f", pnd->navdata_vision_perf.time_custom[i]);
+		fprintf( file, "; %f", pnd->navdata_vision_perf.time_custom[i]);
 	}
 
-	fprintf( navdata_file, "; %d", (int) pnd->navdata_watchdog.watchdog );
+	fprintf( file, "; %d", (int) pnd->navdata_watchdog.watchdog );
 
-	fprintf( navdata_file, "; %u", (unsigned int) num_picture_decoded );
+	fprintf( file, "; %u", (unsigned int) record->num_picture_decoded );
 
-	sprintf( str, "%d.%06d", (int)time.tv_sec, (int)time.tv_usec);
-	fprintf( navdata_file, "; %s", str );
+	sprintf( str, "%d.%06d", (int)record->tv_sec, (int)record->tv_usec);
+	fprintf( file, "; %s", str );
 
-    fprintf( navdata_file, ";%f;%f;%f;%f;%f;%f;%d;%f;%f;%f;%f;%f;%d",
+    fprintf( file, ";%f;%f;%f;%f;%f;%f;%d;%f;%f;%f;%f;%f;%d",
       (float) pnd->navdata_references.vx_ref,
       (float) pnd->navdata_references.vy_ref,
       (float) pnd->navdata_references.theta_mod,
@@ -593,6 +678,83 @@ C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
       (float) pnd->navdata_references.ui_psi,
       (float) pnd->navdata_references.ui_psi_accuracy,
       (int) pnd->navdata_references.ui_seq);
+}
+
+C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const pnd )
+{
+	struct timeval time;
+	input_state_t *input_state = NULL;
+	ardrone_navdata_file_record_t record;
+
+	gettimeofday(&time,NULL);
+
+	if( navdata_file_private == NULL )
+		return C_FAIL;
+
+	if( ardrone_get_mask_from_state(pnd->ardrone_state, ARDRONE_NAVDATA_BOOTSTRAP) )
+		return C_OK;
+
+	input_state = ardrone_tool_input_get_state();
+
+	record.size                = sizeof(record);
+	record.nd_seq              = pnd->nd_seq;
+	record.ardrone_state       = pnd->ardrone_state;
+	record.vision_defined      = pnd->vision_defined;
+	record.options_mask        = pnd->last_navdata_refresh;
+	record.tv_sec              = (int32_t)time.tv_sec;
+	record.tv_usec             = (int32_t)time.tv_usec;
+	record.user_input          = input_state->user_input;
+	record.num_picture_decoded = num_picture_decoded;
+	record.iphone_flag         = nd_iphone_flag;
+	record.iphone_phi          = nd_iphone_phi;
+	record.iphone_theta        = nd_iphone_theta;
+	record.iphone_gaz          = nd_iphone_gaz;
+	record.iphone_yaw          = nd_iphone_yaw;
+
+	// First navdata, or the user asked for a new navdata file
+	if( navdata_file != navdata_file_private )
+	{
+		if( navdata_file != NULL )
+		{
+			// Records queued for the previous file are written before it is closed
+			ardrone_navdata_file_binary_close();
+
+			fclose(navdata_file);
+		}
+
+		navdata_file = navdata_file_private;
+
+		if( ardrone_get_mask_from_state(pnd->ardrone_state, ARDRONE_NAVDATA_DEMO_MASK) )
+		{
+			printf("Receiving navdata demo\n");
+		}
+		else
+		{
+			printf("Receiving all navdata\n");
+		}
+
+		if( ardrone_navdata_file_is_binary() )
+		{
+			if( VP_FAILED(ardrone_navdata_file_binary_open()) )
+			{
+				fclose(navdata_file);
+				navdata_file = navdata_file_private = NULL;
+				return C_FAIL;
+			}
+		}
+		else
+		{
+			ardrone_navdata_file_print_version(navdata_file);
+		}
+	}
+
+	if( ardrone_navdata_file_is_binary() )
+	{
+		ardrone_navdata_file_binary_write(pnd, &record);
+		return C_OK;
+	}
+
+	ardrone_navdata_file_print_csv(navdata_file, pnd, &record);
 
     if((navdata_file_data != NULL) && (navdata_file_data->print != NULL))
   	  navdata_file_data->print(navdata_file);
@@ -604,16 +766,100 @@ C_RESULT ardrone_navdata_file_release( void )
 {
   if( navdata_file != NULL )
   {
-    navdata_file = NULL;
+    if( navdata_file_writer_started )
+      ardrone_navdata_file_binary_close();
+    else
+      fprintf(navdata_file,"\n");
 
-    fprintf(navdata_file_private,"\n");
+    // A new file asked after the last navdata is still empty
+    if( navdata_file != navdata_file_private )
+      fclose( navdata_file );
 
+    navdata_file = NULL;
+  }
+
+  if( navdata_file_private != NULL )
+  {
     fclose( navdata_file_private );
 
     navdata_file_private = NULL;
-
-    navdata_file_data = NULL;
   }
 
+  navdata_file_data = NULL;
+
   return C_OK;
 }
+
+C_RESULT ardrone_navdata_file_convert( const char* binary_filename, const char* csv_filename )
+{
+  C_RESULT res = C_OK;
+  FILE* in = NULL;
+  FILE* out = NULL;
+  ardrone_navdata_file_header_t header;
+  ardrone_navdata_file_record_t record;
+  navdata_unpacked_t* pnd = NULL;
+  uint8_t* packet = NULL;
+  navdata_t* navdata;
+  navdata_cks_t* cks;
+  uint32_t options_size, cks_value, num_records = 0;
+
+  in  = fopen(binary_filename, "rb");
+  out = fopen(csv_filename, "wb");
+  pnd = (navdata_unpacked_t*) vp_os_malloc(sizeof(navdata_unpacked_t));
+  packet = (uint8_t*) vp_os_malloc(sizeof(navdata_t) + sizeof(navdata_unpacked_t) + sizeof(navdata_cks_t));
+
+  if( in == NULL || out == NULL || pnd == NULL || packet == NULL ||
+      fread(&header, sizeof(header), 1, in) != 1 ||
+      header.magic != NAVDATA_FILE_BINARY_MAGIC ||
+      header.version != NAVDATA_FILE_BINARY_VERSION ||
+      header.record_header_size != sizeof(ardrone_navdata_file_record_t) )
+  {
+    PRINT("[Navdata file] %s is not a binary navdata file\n", binary_filename);
+    res = C_FAIL;
+  }
+  else
+  {
+    fseek(in, header.header_size, SEEK_SET);
+    ardrone_navdata_file_print_version(out);
+  }
+
+  // Rebuild each navdata packet and decode it as the navdata client does
+  navdata = (navdata_t*) packet;
+  while( VP_SUCCEEDED(res) && fread(&record, sizeof(record), 1, in) == 1 )
+  {
+    options_size = record.size - sizeof(record);
+    if( record.size < sizeof(record) || options_size > sizeof(navdata_unpacked_t) ||
+        fread(&navdata->options[0], 1, options_size, in) != options_size )
+    {
+      PRINT("[Navdata file] Truncated record after %u records\n", (unsigned int)num_records);
+      break;
+    }
+
+    navdata->header         = NAVDATA_HEADER;
+    navdata->ardrone_state  = record.ardrone_state;
+    navdata->sequence       = record.nd_seq;
+    navdata->vision_defined = record.vision_defined;
+    cks = (navdata_cks_t*) ((uint8_t*)&navdata->options[0] + options_size);
+    cks->tag  = NAVDATA_CKS_TAG;
+    cks->size = sizeof(navdata_cks_t);
+
+    ardrone_navdata_unpack_all(pnd, navdata, &cks_value);
+    pnd->last_navdata_refresh = record.options_mask;
+
+    ardrone_navdata_file_print_csv(out, pnd, &record);
+    num_records++;
+  }
+
+  if( out != NULL )
+  {
+    fprintf(out, "\n");
+    fclose(out);
+  }
+  if( in != NULL )
+    fclose(in);
+
+  vp_os_free(pnd);
+  vp_os_free(packet);
+
+  return res;
+}
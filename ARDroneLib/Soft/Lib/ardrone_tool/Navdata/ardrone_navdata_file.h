@@ -6,22 +6,71 @@
 
 #include <ardrone_tool/Navdata/ardrone_navdata_client.h>
 
+// File written by the handler in both formats. In binary format only its writer thread writes into it.
 extern FILE* navdata_file;
 
 typedef void (*ardrone_navdata_custom_print_header)(FILE *navdata_file);
 typedef void (*ardrone_navdata_custom_print)(FILE *navdata_file);
 
+typedef enum _ardrone_navdata_file_format_
+{
+	NAVDATA_FILE_FORMAT_CSV = 0,	// "VERSION 19c" text file, written by the navdata thread
+	NAVDATA_FILE_FORMAT_BINARY		// Raw navdata options, written by a background thread
+} ardrone_navdata_file_format;
+
 typedef struct _ardrone_navdata_file_data_
 {
 	const char *filename;
-	ardrone_navdata_custom_print_header print_header;
-	ardrone_navdata_custom_print 		print;
+	ardrone_navdata_custom_print_header print_header;	// CSV format only
+	ardrone_navdata_custom_print 		print;			// CSV format only
+	ardrone_navdata_file_format		format;
 } ardrone_navdata_file_data;
 
+/*
+ * Binary format : one ardrone_navdata_file_header_t, then for each navdata packet
+ * one ardrone_navdata_file_record_t followed by the received options, each one
+ * starting with its navdata_option_t tag and size as sent by the drone.
+ * All fields are in the host byte order.
+ */
+#define NAVDATA_FILE_BINARY_MAGIC   (0x3142444E) // "NDB1"
+#define NAVDATA_FILE_BINARY_VERSION (1)
+
+typedef struct _ardrone_navdata_file_header_t
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t header_size;			// sizeof(ardrone_navdata_file_header_t)
+	uint32_t record_header_size;	// sizeof(ardrone_navdata_file_record_t)
+} ardrone_navdata_file_header_t;
+
+typedef struct _ardrone_navdata_file_record_t
+{
+	uint32_t  size;					// Size of the record, options included
+	uint32_t  nd_seq;
+	uint32_t  ardrone_state;
+	uint32_t  vision_defined;
+	uint32_t  options_mask;			// last_navdata_refresh of the packet
+	int32_t   tv_sec;				// Local time of reception
+	int32_t   tv_usec;
+	uint32_t  user_input;
+	uint32_t  num_picture_decoded;
+	int32_t   iphone_flag;
+	float32_t iphone_phi;
+	float32_t iphone_theta;
+	float32_t iphone_gaz;
+	float32_t iphone_yaw;
+} ardrone_navdata_file_record_t;
+
 // For this handler, data is the path where the file will be created
 // If data is NULL then the file is created in current directory
 C_RESULT ardrone_navdata_file_init( void* data );
 C_RESULT ardrone_navdata_file_process( const navdata_unpacked_t* const navdata );
 C_RESULT ardrone_navdata_file_release( void );
 
+/**
+ * Convert a binary navdata file to the CSV format written by NAVDATA_FILE_FORMAT_CSV.
+ * Columns written by custom print callbacks are not available.
+ */
+C_RESULT ardrone_navdata_file_convert( const char* binary_filename, const char* csv_filename );
+
 #endif // _ARDRONE_NAVDATA_FILE_H_
@@ -0,0 +1,168 @@
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_signal.h>
+#include <VP_Os/vp_os_print.h>
+
+#include <ardrone_tool/Navdata/ardrone_navdata_snapshot.h>
+
+typedef struct _ardrone_navdata_snapshot_slot_t
+{
+  volatile uint32_t           seq;    /* Odd while the slot is being written */
+  ardrone_navdata_snapshot_t  data;
+} ardrone_navdata_snapshot_slot_t;
+
+static ardrone_navdata_snapshot_slot_t navdata_snapshot_slots[2];
+static volatile uint32_t navdata_snapshot_published = 0;
+
+static ardrone_navdata_subscriber_t navdata_subscribers[ARDRONE_NAVDATA_SNAPSHOT_MAX_SUBSCRIBERS];
+
+// Only taken to add or remove subscribers, and by the publisher to walk them
+#ifdef PTHREAD_MUTEX_INITIALIZER
+static vp_os_mutex_t navdata_subscribers_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define navdata_subscribers_mutex_init()
+#else
+static vp_os_mutex_t navdata_subscribers_mutex;
+static bool_t navdata_subscribers_mutex_done = FALSE;
+static void navdata_subscribers_mutex_init(void)
+{
+  if( navdata_subscribers_mutex_done == FALSE )
+  {
+    vp_os_mutex_init( &navdata_subscribers_mutex );
+    navdata_subscribers_mutex_done = TRUE;
+  }
+}
+#endif
+
+void ardrone_navdata_snapshot_publish(const navdata_unpacked_t* navdata, uint32_t rx_sec, uint32_t rx_nsec)
+{
+  uint32_t sequence = navdata_snapshot_published + 1;
+  ardrone_navdata_snapshot_slot_t* slot = &navdata_snapshot_slots[sequence & 1];
+  int32_t i;
+
+  // Readers of the latest snapshot use the other slot
+  slot->seq++;
+  ARDRONE_SPSC_BARRIER();
+
+  slot->data.sequence = sequence;
+  slot->data.rx_sec   = rx_sec;
+  slot->data.rx_nsec  = rx_nsec;
+  vp_os_memcpy( &slot->data.navdata, navdata, sizeof(navdata_unpacked_t) );
+
+  ARDRONE_SPSC_BARRIER();
+  slot->seq++;
+  ARDRONE_SPSC_BARRIER();
+  navdata_snapshot_published = sequence;
+
+  navdata_subscribers_mutex_init();
+  vp_os_mutex_lock( &navdata_subscribers_mutex );
+  for( i = 0; i < ARDRONE_NAVDATA_SNAPSHOT_MAX_SUBSCRIBERS; i++ )
+  {
+    ardrone_navdata_subscriber_t* subscriber = &navdata_subscribers[i];
+
+    if( subscriber->used && !ardrone_spsc_ring_push( &subscriber->ring, &slot->data, sizeof(ardrone_navdata_snapshot_t) ) )
+      subscriber->dropped++;
+  }
+  vp_os_mutex_unlock( &navdata_subscribers_mutex );
+}
+
+bool_t ardrone_navdata_snapshot_get(ardrone_navdata_snapshot_t* snapshot)
+{
+  ardrone_navdata_snapshot_slot_t* slot;
+  uint32_t sequence, seq;
+
+  do
+  {
+    sequence = navdata_snapshot_published;
+    if( sequence == 0 )
+      return FALSE;
+
+    ARDRONE_SPSC_BARRIER();
+    slot = &navdata_snapshot_slots[sequence & 1];
+    seq  = slot->seq;
+    ARDRONE_SPSC_BARRIER();
+
+    vp_os_memcpy( snapshot, &slot->data, sizeof(ardrone_navdata_snapshot_t) );
+
+    ARDRONE_SPSC_BARRIER();
+  }
+  while( (seq & 1) != 0 || seq != slot->seq );
+
+  return TRUE;
+}
+
+uint32_t ardrone_navdata_snapshot_sequence(void)
+{
+  return navdata_snapshot_published;
+}
+
+ardrone_navdata_subscriber_t* ardrone_navdata_snapshot_subscribe(uint32_t depth)
+{
+  ardrone_navdata_subscriber_t* subscriber = NULL;
+  int32_t i;
+
+  if( depth == 0 )
+    depth = 1;
+
+  navdata_subscribers_mutex_init();
+  vp_os_mutex_lock( &navdata_subscribers_mutex );
+  for( i = 0; i < ARDRONE_NAVDATA_SNAPSHOT_MAX_SUBSCRIBERS && subscriber == NULL; i++ )
+  {
+    if( !navdata_subscribers[i].used )
+      subscriber = &navdata_subscribers[i];
+  }
+
+  if( subscriber != NULL )
+  {
+    if( C_OK == ardrone_spsc_ring_init( &subscriber->ring, depth * sizeof(ardrone_navdata_snapshot_t) ) )
+    {
+      subscriber->dropped = 0;
+      subscriber->used = TRUE;
+    }
+    else
+    {
+      subscriber = NULL;
+    }
+  }
+  vp_os_mutex_unlock( &navdata_subscribers_mutex );
+
+  if( subscriber == NULL )
+    PRINT("Unable to add a navdata subscriber\n");
+
+  return subscriber;
+}
+
+void ardrone_navdata_snapshot_unsubscribe(ardrone_navdata_subscriber_t* subscriber)
+{
+  if( subscriber == NULL )
+    return;
+
+  navdata_subscribers_mutex_init();
+  vp_os_mutex_lock( &navdata_subscribers_mutex );
+  subscriber->used = FALSE;
+  ardrone_spsc_ring_release( &subscriber->ring );
+  vp_os_mutex_unlock( &navdata_subscribers_mutex );
+}
+
+bool_t ardrone_navdata_snapshot_pop(ardrone_navdata_subscriber_t* subscriber, ardrone_navdata_snapshot_t* snapshot)
+{
+  uint8_t* dst = (uint8_t*) snapshot;
+  uint32_t copied = 0;
+
+  if( ardrone_spsc_ring_used( &subscriber->ring ) < sizeof(ardrone_navdata_snapshot_t) )
+    return FALSE;
+
+  // A snapshot may wrap around the end of the ring
+  while( copied < sizeof(ardrone_navdata_snapshot_t) )
+  {
+    const uint8_t* data;
+    uint32_t size = ardrone_spsc_ring_peek( &subscriber->ring, &data );
+
+    if( size > sizeof(ardrone_navdata_snapshot_t) - copied )
+      size = sizeof(ardrone_navdata_snapshot_t) - copied;
+
+    vp_os_memcpy( dst + copied, data, size );
+    ardrone_spsc_ring_consume( &subscriber->ring, size );
+    copied += size;
+  }
+
+  return TRUE;
+}
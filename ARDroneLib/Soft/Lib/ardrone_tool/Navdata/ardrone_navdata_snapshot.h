@@ -0,0 +1,69 @@
+/**
+ * @file ardrone_navdata_snapshot.h
+ * @brief Latest navdata for threads other than the navdata thread.
+ *
+ * The navdata thread publishes each valid packet once unpacked. Any number of
+ * readers can copy the latest one at any time : publication alternates between
+ * two slots guarded by a sequence counter (seqlock), so neither side ever waits
+ * for the other. A reader only retries when two packets were published while
+ * it was copying.
+ *
+ * Consumers which need every packet subscribe instead and get their own
+ * single producer / single consumer queue. Packets are dropped (and counted)
+ * when a subscriber falls behind, the navdata thread never waits for it.
+ */
+
+#ifndef _ARDRONE_NAVDATA_SNAPSHOT_H_
+#define _ARDRONE_NAVDATA_SNAPSHOT_H_
+
+#include <VP_Os/vp_os_types.h>
+#include <ardrone_api.h>
+#include <utils/ardrone_spsc_ring.h>
+
+#define ARDRONE_NAVDATA_SNAPSHOT_MAX_SUBSCRIBERS  4
+
+typedef struct _ardrone_navdata_snapshot_t
+{
+  uint32_t            sequence;   /* Publication counter, starts at 1 */
+  uint32_t            rx_sec;     /* Kernel reception time (CLOCK_REALTIME), 0 if not supported */
+  uint32_t            rx_nsec;
+  navdata_unpacked_t  navdata;
+} ardrone_navdata_snapshot_t;
+
+typedef struct _ardrone_navdata_subscriber_t
+{
+  bool_t              used;
+  ardrone_spsc_ring_t ring;
+  volatile uint32_t   dropped;    /* Packets not queued because the ring was full */
+} ardrone_navdata_subscriber_t;
+
+/**
+ * Navdata thread side : makes navdata the latest snapshot and queues it to every subscriber.
+ */
+void ardrone_navdata_snapshot_publish(const navdata_unpacked_t* navdata, uint32_t rx_sec, uint32_t rx_nsec);
+
+/**
+ * Copies the latest snapshot, from any thread.
+ * @return FALSE if nothing was published yet
+ */
+bool_t ardrone_navdata_snapshot_get(ardrone_navdata_snapshot_t* snapshot);
+
+/**
+ * Sequence number of the latest snapshot (0 if none), to poll for new data without copying.
+ */
+uint32_t ardrone_navdata_snapshot_sequence(void);
+
+/**
+ * Gets a queue receiving every published packet, depth packets deep.
+ * @return NULL if all subscriber slots are taken or on allocation failure
+ */
+ardrone_navdata_subscriber_t* ardrone_navdata_snapshot_subscribe(uint32_t depth);
+void ardrone_navdata_snapshot_unsubscribe(ardrone_navdata_subscriber_t* subscriber);
+
+/**
+ * Subscriber side : oldest queued packet.
+ * @return FALSE if the queue is empty
+ */
+bool_t ardrone_navdata_snapshot_pop(ardrone_navdata_subscriber_t* subscriber, ardrone_navdata_snapshot_t* snapshot);
+
+#endif // _ARDRONE_NAVDATA_SNAPSHOT_H_
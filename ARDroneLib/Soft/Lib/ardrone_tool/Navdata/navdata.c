@@ -5,6 +5,8 @@
 
 #include <ardrone_api.h>
 
+#include <stddef.h>
+
 /* Uncomment to activate interesting printf's */
 //#define DEBUG_NAVDATA_C
 
@@ -62,6 +64,21 @@ navdata_option_t* ardrone_navdata_search_option( navdata_option_t* navdata_optio
 }
 
 
+/********************************************************************
+ * ardrone_navdata_decoders:
+ * @brief Offset and size of each option inside navdata_unpacked_t,
+ * generated from navdata_keys.h in tag order.
+ *******************************************************************/
+const navdata_option_decoder_t ardrone_navdata_decoders[NAVDATA_NUM_TAGS] =
+{
+#define NAVDATA_OPTION(STRUCTURE,NAME,TAG) \
+  { offsetof(navdata_unpacked_t, NAME), sizeof(STRUCTURE) },
+#define NAVDATA_OPTION_DEMO(STRUCTURE,NAME,TAG)  NAVDATA_OPTION(STRUCTURE,NAME,TAG)
+#define NAVDATA_OPTION_CKS(STRUCTURE,NAME,TAG)
+#include <navdata_keys.h>
+};
+
+
 /********************************************************************
  * ardrone_navdata_unpack_all:
  * @param navdata_unpacked  navdata_unpacked in which to store the navdata.
@@ -73,14 +90,46 @@ navdata_option_t* ardrone_navdata_search_option( navdata_option_t* navdata_optio
  *
  *******************************************************************/
 C_RESULT ardrone_navdata_unpack_all(navdata_unpacked_t* navdata_unpacked, navdata_t* navdata, uint32_t* cks)
+{
+  return ardrone_navdata_unpack_masked( navdata_unpacked, navdata, cks, NAVDATA_OPTION_FULL_MASK );
+}
+
+
+/********************************************************************
+ * ardrone_navdata_unpack_masked:
+ * @param navdata_unpacked  navdata_unpacked in which to store the navdata.
+ * @param navdata One packet read from the port NAVDATA.
+ * @param Checksum of navdata
+ * @param options_mask Options to copy.
+ * @brief Disassembles the options of options_mask only, through
+ * ardrone_navdata_decoders. Other options are skipped and left
+ * untouched in 'navdata_unpacked'.
+ *******************************************************************/
+C_RESULT ardrone_navdata_unpack_masked(navdata_unpacked_t* navdata_unpacked, navdata_t* navdata, uint32_t* cks, uint32_t options_mask)
 {
   C_RESULT res;
   navdata_cks_t navdata_cks = { 0 };
   navdata_option_t* navdata_option_ptr;
+  uint8_t* unpacked = (uint8_t*) navdata_unpacked;
+  uint32_t tag;
 
   navdata_option_ptr = (navdata_option_t*) &navdata->options[0];
+  options_mask &= NAVDATA_OPTION_FULL_MASK;
 
-  vp_os_memset( navdata_unpacked, 0, sizeof(*navdata_unpacked) );
+  if( options_mask == NAVDATA_OPTION_FULL_MASK )
+  {
+    vp_os_memset( navdata_unpacked, 0, sizeof(*navdata_unpacked) );
+  }
+  else
+  {
+    uint32_t mask = options_mask;
+    for( tag = 0; mask != 0; tag++, mask >>= 1 )
+    {
+      if( mask & 1 )
+        vp_os_memset( unpacked + ardrone_navdata_decoders[tag].offset, 0, ardrone_navdata_decoders[tag].size );
+    }
+    navdata_unpacked->last_navdata_refresh = 0;
+  }
 
   navdata_unpacked->nd_seq   = navdata->sequence;
   navdata_unpacked->ardrone_state   = navdata->ardrone_state;
@@ -105,40 +154,31 @@ C_RESULT ardrone_navdata_unpack_all(navdata_unpacked_t* navdata_unpacked, navdat
     }
     else
     {
+      tag = navdata_option_ptr->tag;
 
-      if( navdata_option_ptr->tag <= NAVDATA_NUM_TAGS){
+      if( tag < NAVDATA_NUM_TAGS )
+      {
 			#ifdef DEBUG_NAVDATA_C
-    	  	 printf("[%d]",navdata_option_ptr->tag);
+    	  	 printf("[%d]",tag);
 			#endif
-    	  navdata_unpacked->last_navdata_refresh |= NAVDATA_OPTION_MASK(navdata_option_ptr->tag);
+        if( options_mask & NAVDATA_OPTION_MASK(tag) )
+        {
+          const navdata_option_decoder_t* decoder = &ardrone_navdata_decoders[tag];
+          navdata_unpacked->last_navdata_refresh |= NAVDATA_OPTION_MASK(tag);
+          navdata_unpack_option( (uint8_t*) navdata_option_ptr, navdata_option_ptr->size, unpacked + decoder->offset, decoder->size );
+        }
+        navdata_option_ptr = navdata_next_option( navdata_option_ptr );
       }
-
-
-
-      switch( navdata_option_ptr->tag )
+      else if( tag == NAVDATA_CKS_TAG )
       {
-
-		  #define NAVDATA_OPTION(STRUCTURE,NAME,TAG) \
-			case TAG: \
-			navdata_option_ptr = ardrone_navdata_unpack( navdata_option_ptr, navdata_unpacked->NAME); \
-			break;
-
-			#define NAVDATA_OPTION_DEMO(STRUCTURE,NAME,TAG)  NAVDATA_OPTION(STRUCTURE,NAME,TAG)
-			#define NAVDATA_OPTION_CKS(STRUCTURE,NAME,TAG) {}
-
-			#include <navdata_keys.h>
-
-        case NAVDATA_CKS_TAG:
-          navdata_option_ptr = ardrone_navdata_unpack( navdata_option_ptr, navdata_cks );
-          *cks = navdata_cks.cks;
-          navdata_option_ptr = NULL; // End of structure
-          break;
-
-
-        default:
-          PRINT("Tag %d is an unknown navdata option tag\n", (int) navdata_option_ptr->tag);
-          navdata_option_ptr = (navdata_option_t *)(((uint32_t)navdata_option_ptr) + navdata_option_ptr->size);
-          break;
+        navdata_option_ptr = ardrone_navdata_unpack( navdata_option_ptr, navdata_cks );
+        *cks = navdata_cks.cks;
+        navdata_option_ptr = NULL; // End of structure
+      }
+      else
+      {
+        PRINT("Tag %d is an unknown navdata option tag\n", (int) tag);
+        navdata_option_ptr = navdata_next_option( navdata_option_ptr );
       }
     }
   }
@@ -0,0 +1,276 @@
+/*
+ * video_bitrate_controller.c
+ *
+ * Host side video bitrate and resolution control, see video_bitrate_controller.h
+ */
+
+#include <ardrone_api.h>
+#include <ardrone_tool/ardrone_tool_configuration.h>
+#include <ardrone_tool/Video/video_bitrate_controller.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_signal.h>
+#include <VP_Os/vp_os_print.h>
+
+#include <sys/time.h>
+
+#define VIDEO_BITRATE_PERIOD_US         500000    // Measurement period
+#define VIDEO_BITRATE_HOLD_US           1000000   // Minimum time between two decreases
+#define VIDEO_BITRATE_INCREASE_US       2000000   // Healthy time before each increase
+#define VIDEO_BITRATE_CODEC_DOWN_US     3000000   // Congested time at min bitrate before going to 360p
+#define VIDEO_BITRATE_CODEC_UP_US       10000000  // Healthy time at max bitrate before going back to 720p
+
+typedef struct _video_bitrate_controller_t
+{
+  video_bitrate_controller_config_t config;
+  video_bitrate_controller_state_t  state;
+
+  bool_t    started;
+  bool_t    manual_mode;        // bitrate_ctrl_mode already sent
+  bool_t    codec_lowered;      // 360p was chosen by the controller
+  int64_t   period_start_us;
+  int64_t   last_change_us;
+  int64_t   congested_since_us; // 0 when not congested
+  int64_t   healthy_since_us;   // 0 when not healthy
+  uint32_t  last_dropped;
+  uint32_t  best_link_quality;
+} video_bitrate_controller_t;
+
+static video_bitrate_controller_t controller;
+
+#ifdef PTHREAD_MUTEX_INITIALIZER
+static vp_os_mutex_t controller_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define video_bitrate_mutex_init()
+#else
+static vp_os_mutex_t controller_mutex;
+static bool_t controller_mutex_init = FALSE;
+static void video_bitrate_mutex_init( void )
+{
+  if( controller_mutex_init == FALSE )
+  {
+    vp_os_mutex_init( &controller_mutex );
+    controller_mutex_init = TRUE;
+  }
+}
+#endif
+
+static int64_t video_bitrate_now_us( void )
+{
+  struct timeval tv;
+  gettimeofday( &tv, NULL );
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static uint32_t video_bitrate_max( void )
+{
+  if( controller.config.max_bitrate != 0 )
+    return controller.config.max_bitrate;
+  if( ardrone_control_config.max_bitrate > 0 )
+    return ardrone_control_config.max_bitrate;
+  return VIDEO_BITRATE_DEFAULT_MAX_KBPS;
+}
+
+static bool_t video_bitrate_request( uint32_t bitrate )
+{
+  int32_t value = bitrate;
+
+  if( controller.manual_mode == FALSE )
+  {
+    int32_t mode = VBC_MANUAL;
+    if( FALSE == ARDRONE_TOOL_CONFIGURATION_ADDEVENT( bitrate_ctrl_mode, &mode, NULL ) )
+      return FALSE;
+    ardrone_control_config.bitrate_ctrl_mode = mode;
+    controller.manual_mode = TRUE;
+  }
+
+  if( FALSE == ARDRONE_TOOL_CONFIGURATION_ADDEVENT( bitrate, &value, NULL ) )
+  {
+    PRINT( "Unable to send bitrate %d ... retry later\n", bitrate );
+    return FALSE;
+  }
+
+  ardrone_control_config.bitrate = value;
+  controller.state.bitrate = bitrate;
+  return TRUE;
+}
+
+static bool_t video_bitrate_request_codec( int32_t codec )
+{
+  int32_t previous = ardrone_control_config.video_codec;
+
+  if( FALSE == ARDRONE_TOOL_CONFIGURATION_ADDEVENT( video_codec, &codec, NULL ) )
+  {
+    PRINT( "Unable to send codec %d ... retry later\n", codec );
+    return FALSE;
+  }
+
+  ardrone_control_config.video_codec = codec;
+
+  PRINT( "Video bitrate controller : codec %d -> %d\n", previous, codec );
+  controller.state.codec = codec;
+  controller.state.codec_switches++;
+  return TRUE;
+}
+
+C_RESULT video_bitrate_controller_init( const video_bitrate_controller_config_t* cfg )
+{
+  video_bitrate_mutex_init();
+  vp_os_mutex_lock( &controller_mutex );
+
+  vp_os_memset( &controller, 0, sizeof(controller) );
+  if( cfg != NULL )
+  {
+    controller.config = *cfg;
+  }
+  else
+  {
+    controller.config.target_latency_ms   = VIDEO_BITRATE_DEFAULT_TARGET_MS;
+    controller.config.min_bitrate         = VIDEO_BITRATE_DEFAULT_MIN_KBPS;
+    controller.config.step_bitrate        = VIDEO_BITRATE_DEFAULT_STEP_KBPS;
+    controller.config.allow_codec_switch  = TRUE;
+  }
+
+  if( controller.config.target_latency_ms == 0 )
+    controller.config.target_latency_ms = VIDEO_BITRATE_DEFAULT_TARGET_MS;
+  if( controller.config.min_bitrate == 0 )
+    controller.config.min_bitrate = VIDEO_BITRATE_DEFAULT_MIN_KBPS;
+  if( controller.config.step_bitrate == 0 )
+    controller.config.step_bitrate = VIDEO_BITRATE_DEFAULT_STEP_KBPS;
+
+  vp_os_mutex_unlock( &controller_mutex );
+
+  return C_OK;
+}
+
+void video_bitrate_controller_set_link_quality( uint32_t link_quality )
+{
+  video_bitrate_mutex_init();
+  vp_os_mutex_lock( &controller_mutex );
+  controller.state.link_quality = link_quality;
+  if( link_quality > controller.best_link_quality )
+    controller.best_link_quality = link_quality;
+  vp_os_mutex_unlock( &controller_mutex );
+}
+
+void video_bitrate_controller_step( const video_stage_tcp_config_t* tcp, float decoding_time_us )
+{
+  int64_t now = video_bitrate_now_us();
+  uint32_t bitrate, max_bitrate, decode_ms, latency_ms, dropped;
+  int32_t codec;
+  bool_t congested, healthy, degraded_link;
+
+  video_bitrate_mutex_init();
+  vp_os_mutex_lock( &controller_mutex );
+
+  if( controller.started == FALSE )
+  {
+    controller.started = TRUE;
+    controller.period_start_us = now;
+    controller.last_change_us = now;
+    controller.last_dropped = tcp->droppedFrames;
+  }
+
+  if( now - controller.period_start_us < VIDEO_BITRATE_PERIOD_US )
+  {
+    vp_os_mutex_unlock( &controller_mutex );
+    return;
+  }
+  controller.period_start_us = now;
+
+  // Drone bitrate is not known until the first request, start from the configured one
+  bitrate = controller.state.bitrate;
+  if( bitrate == 0 )
+    bitrate = (ardrone_control_config.bitrate > 0) ? ardrone_control_config.bitrate : controller.config.min_bitrate;
+  max_bitrate = video_bitrate_max();
+  codec = ardrone_control_config.video_codec;
+
+  decode_ms = (uint32_t)(decoding_time_us / 1000.0);
+
+  // Time needed to receive what is already buffered at the current bitrate (kbps = bits per ms)
+  latency_ms = (uint32_t)((uint64_t)tcp->currentSize * 8 / bitrate) + decode_ms;
+  dropped = tcp->droppedFrames - controller.last_dropped;
+  controller.last_dropped = tcp->droppedFrames;
+
+  // Link quality scale is firmware dependent, only compare with the best value seen
+  degraded_link = (controller.best_link_quality > 0) &&
+                  (controller.state.link_quality * 4 < controller.best_link_quality * 3);
+
+  congested = (dropped > 0) || (latency_ms > controller.config.target_latency_ms) || degraded_link;
+  healthy = !congested && (latency_ms < controller.config.target_latency_ms / 2);
+
+  controller.state.estimated_latency_ms = latency_ms;
+  controller.state.dropped_frames = dropped;
+
+  if( congested )
+  {
+    controller.healthy_since_us = 0;
+    if( controller.congested_since_us == 0 )
+      controller.congested_since_us = now;
+  }
+  else
+  {
+    controller.congested_since_us = 0;
+    if( healthy && controller.healthy_since_us == 0 )
+      controller.healthy_since_us = now;
+    else if( !healthy )
+      controller.healthy_since_us = 0;
+  }
+
+  if( congested && now - controller.last_change_us >= VIDEO_BITRATE_HOLD_US )
+  {
+    if( bitrate > controller.config.min_bitrate )
+    {
+      uint32_t lower = bitrate * 3 / 4;
+      if( lower < controller.config.min_bitrate )
+        lower = controller.config.min_bitrate;
+      if( video_bitrate_request( lower ) )
+      {
+        controller.state.decreases++;
+        controller.last_change_us = now;
+      }
+    }
+    else if( controller.config.allow_codec_switch && codec == H264_720P_CODEC &&
+             now - controller.congested_since_us >= VIDEO_BITRATE_CODEC_DOWN_US )
+    {
+      if( video_bitrate_request_codec( H264_360P_CODEC ) )
+      {
+        controller.codec_lowered = TRUE;
+        controller.last_change_us = now;
+        controller.congested_since_us = 0;
+      }
+    }
+  }
+  else if( healthy && now - controller.last_change_us >= VIDEO_BITRATE_INCREASE_US )
+  {
+    if( bitrate < max_bitrate )
+    {
+      uint32_t higher = bitrate + controller.config.step_bitrate;
+      if( higher > max_bitrate )
+        higher = max_bitrate;
+      if( video_bitrate_request( higher ) )
+      {
+        controller.state.increases++;
+        controller.last_change_us = now;
+      }
+    }
+    else if( controller.codec_lowered && codec == H264_360P_CODEC &&
+             now - controller.healthy_since_us >= VIDEO_BITRATE_CODEC_UP_US )
+    {
+      if( video_bitrate_request_codec( H264_720P_CODEC ) )
+      {
+        controller.codec_lowered = FALSE;
+        controller.last_change_us = now;
+        controller.healthy_since_us = 0;
+      }
+    }
+  }
+
+  vp_os_mutex_unlock( &controller_mutex );
+}
+
+void video_bitrate_controller_get_state( video_bitrate_controller_state_t* state )
+{
+  video_bitrate_mutex_init();
+  vp_os_mutex_lock( &controller_mutex );
+  *state = controller.state;
+  vp_os_mutex_unlock( &controller_mutex );
+}
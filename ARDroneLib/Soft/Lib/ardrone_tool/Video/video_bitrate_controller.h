@@ -0,0 +1,64 @@
+/*
+ * video_bitrate_controller.h
+ *
+ * Host side video bitrate and resolution control.
+ *
+ * The drone own bitrate control only sees its WiFi queue. This controller
+ * looks at what the host gets: bytes waiting in the TCP reassembly buffer,
+ * frames skipped by the latencyDrop logic, decoding time and the WiFi link
+ * quality reported in navdata. From these it estimates the latency added on
+ * the host side and lowers the bitrate (then the resolution) when it goes over
+ * the target, raising them again once the stream stays healthy.
+ *
+ * Bitrate changes put the drone in VBC_MANUAL mode. Resolution changes only
+ * happen between H264_360P_CODEC and H264_720P_CODEC, so that recording codecs
+ * selected by the application are never overridden.
+ */
+
+#ifndef _VIDEO_BITRATE_CONTROLLER_H_
+#define _VIDEO_BITRATE_CONTROLLER_H_
+
+#include <VP_Os/vp_os_types.h>
+#include <ardrone_tool/Video/video_stage_tcp.h>
+
+#define VIDEO_BITRATE_DEFAULT_TARGET_MS     100
+#define VIDEO_BITRATE_DEFAULT_MIN_KBPS      250
+#define VIDEO_BITRATE_DEFAULT_STEP_KBPS     100
+#define VIDEO_BITRATE_DEFAULT_MAX_KBPS      4000    // Used when max_bitrate is not configured
+
+typedef struct _video_bitrate_controller_config_t
+{
+  uint32_t  target_latency_ms;      // Host side latency to hold
+  uint32_t  min_bitrate;            // kbps
+  uint32_t  max_bitrate;            // kbps, 0 : use ardrone_control_config.max_bitrate
+  uint32_t  step_bitrate;           // kbps added per healthy period
+  bool_t    allow_codec_switch;     // Drop to 360p when min_bitrate is not enough
+} video_bitrate_controller_config_t;
+
+typedef struct _video_bitrate_controller_state_t
+{
+  uint32_t  bitrate;                // Last requested bitrate (kbps), 0 before the first request
+  int32_t   codec;                  // Last requested codec, 0 before the first request
+  uint32_t  estimated_latency_ms;   // Backlog transmit time + decoding time, last period
+  uint32_t  dropped_frames;         // Frames dropped by the TCP stage, last period
+  uint32_t  link_quality;           // Last navdata value
+  uint32_t  decreases;
+  uint32_t  increases;
+  uint32_t  codec_switches;
+} video_bitrate_controller_state_t;
+
+/** cfg may be NULL for default values */
+C_RESULT video_bitrate_controller_init( const video_bitrate_controller_config_t* cfg );
+
+/** Called by the navdata handler when the WiFi option is received */
+void video_bitrate_controller_set_link_quality( uint32_t link_quality );
+
+/**
+ * Called by the video thread after each pipeline run, issues config events when needed
+ * decoding_time_us : smoothed decoding time of the pipeline (video_stage_decoder_get_decoding_time_usec)
+ */
+void video_bitrate_controller_step( const video_stage_tcp_config_t* tcp, float decoding_time_us );
+
+void video_bitrate_controller_get_state( video_bitrate_controller_state_t* state );
+
+#endif // _VIDEO_BITRATE_CONTROLLER_H_
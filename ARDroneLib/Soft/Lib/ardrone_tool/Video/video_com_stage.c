@@ -4,6 +4,7 @@
 #include <VP_Os/vp_os_malloc.h>
 #include <VP_Os/vp_os_delay.h>
 #include <VP_Os/vp_os_assert.h>
+#include <VP_Os/vp_os_trace.h>
 #include <ardrone_tool/Video/video_com_stage.h>
 
 #include <VP_Com/vp_com_socket.h>
@@ -141,37 +142,29 @@ C_RESULT video_com_stage_connect (video_com_config_t *cfg)
       cfg->socket.is_multicast = 0; // disable multicast for video
       cfg->socket.multicast_base_addr = MULTICAST_BASE_ADDR;
 
+      // Large enough to absorb WiFi bursts while the stage thread is descheduled
+      cfg->socket.rcv_buffer_size = SOCKET_BUFFER_SIZE;
+
       res = vp_com_open(cfg->com, &cfg->socket, &cfg->read, &cfg->write);
 
       if( VP_SUCCEEDED(res) )
     	{
-          int numi= 1;
-          socklen_t numi1= sizeof(int);
 #ifdef _WIN32
           setsockopt((int32_t)cfg->socket.priv, SOL_SOCKET, SO_RCVTIMEO, SSOPTCAST_RO(&timeout_for_windows), sizeof(timeout_for_windows));
 #else
           setsockopt((int32_t)cfg->socket.priv, SOL_SOCKET, SO_RCVTIMEO, SSOPTCAST_RO(&tv), sizeof(tv));
 #endif		
-          // Increase buffer for receiving datas.
-          setsockopt( (int32_t)cfg->socket.priv, SOL_SOCKET, SO_DEBUG, SSOPTCAST_RO(&numi), sizeof(numi));
-          numi = SOCKET_BUFFER_SIZE;
-          setsockopt( (int32_t)cfg->socket.priv, SOL_SOCKET, SO_RCVBUF, SSOPTCAST_RO(&numi),numi1);
-          getsockopt( (int32_t)cfg->socket.priv, SOL_SOCKET, SO_RCVBUF, SSOPTCAST_RW(&numi),&numi1);
-          PDBG ("New buffer size : %d", numi);
-          numi1 = 0;
-          setsockopt( (int32_t)cfg->socket.priv, SOL_SOCKET, SO_DEBUG, SSOPTCAST_RO(&numi1), sizeof(numi1));
           cfg->connected = TRUE;
     	}
     }
   else if( cfg->protocol == VP_COM_TCP )
     {
       PDBG ("Will open TCP");
+      cfg->socket.rcv_buffer_size = SOCKET_BUFFER_SIZE;
       res = vp_com_open(cfg->com, &cfg->socket, &cfg->read, &cfg->write);
 
       if( VP_SUCCEEDED(res) )
     	{
-          int numi= 1;
-          socklen_t numi1= sizeof(int);
           PDBG ("Success open");
           vp_com_sockopt(cfg->com, &cfg->socket, cfg->sockopt);
 #ifdef _WIN32
@@ -179,14 +172,6 @@ C_RESULT video_com_stage_connect (video_com_config_t *cfg)
 #else
           setsockopt((int32_t)cfg->socket.priv, SOL_SOCKET, SO_RCVTIMEO, SSOPTCAST_RO(&tv), sizeof(tv));
 #endif		
-          // Increase buffer for receiving datas.
-          setsockopt( (int32_t)cfg->socket.priv, SOL_SOCKET, SO_DEBUG, SSOPTCAST_RO(&numi), sizeof(numi));
-          numi = SOCKET_BUFFER_SIZE;
-          setsockopt( (int32_t)cfg->socket.priv, SOL_SOCKET, SO_RCVBUF, SSOPTCAST_RO(&numi),numi1);
-          getsockopt( (int32_t)cfg->socket.priv, SOL_SOCKET, SO_RCVBUF, SSOPTCAST_RW(&numi),&numi1);
-          PDBG ("NEW buffer size : %d", numi);
-          numi1 = 0;
-          setsockopt( (int32_t)cfg->socket.priv, SOL_SOCKET, SO_DEBUG, SSOPTCAST_RO(&numi1), sizeof(numi1));
           cfg->connected = TRUE;
     	}
     }
@@ -257,6 +242,58 @@ C_RESULT video_com_multisocket_stage_open(video_com_multisocket_config_t *cfg)
 }
 
 
+#ifndef _WIN32
+#define VIDEO_COM_DATAGRAM_MAX_SIZE (64*1024)
+
+/**
+ * Appends all the queued UDP datagrams to out, several of them per syscall.
+ * Each datagram is received in a 64KB slot after the data already read (the
+ * last slot being what remains of the buffer), then moved right after the
+ * previous one.
+ */
+static C_RESULT video_com_stage_read_datagrams (video_com_config_t *cfg, vp_api_io_data_t *out)
+{
+  vp_com_datagram_t datagrams[VP_COM_UDP_BATCH_MAX];
+  int32_t i, count, maxCount, offset;
+  C_RESULT res = C_OK;
+
+  cfg->socket.block = VP_COM_DONTWAIT;
+  do
+    {
+      // The last slot gets what remains of the buffer, even less than 64KB
+      offset = out->size;
+      for (maxCount = 0; maxCount < VP_COM_UDP_BATCH_MAX && offset < cfg->buffer_size; maxCount++)
+        {
+          datagrams[maxCount].buffer = (int8_t *)&out->buffers[0][offset];
+          datagrams[maxCount].size = cfg->buffer_size - offset;
+          if (VIDEO_COM_DATAGRAM_MAX_SIZE < datagrams[maxCount].size)
+            {
+              datagrams[maxCount].size = VIDEO_COM_DATAGRAM_MAX_SIZE;
+            }
+          offset += datagrams[maxCount].size;
+        }
+
+      count = maxCount;
+      if (0 < maxCount)
+        {
+          res = vp_com_read_udp_socket_batch (&cfg->socket, datagrams, &count);
+        }
+
+      for (i = 0; VP_SUCCEEDED (res) && i < count; i++)
+        {
+          if ((uint8_t *)datagrams[i].buffer != &out->buffers[0][out->size])
+            {
+              memmove (&out->buffers[0][out->size], datagrams[i].buffer, datagrams[i].size);
+            }
+          out->size += datagrams[i].size;
+        }
+    }
+  while (VP_SUCCEEDED (res) && 0 < count && count == maxCount);
+  cfg->socket.block = VP_COM_DEFAULT;
+
+  return res;
+}
+#endif
 
 C_RESULT video_com_stage_transform(video_com_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out)
 {
@@ -334,6 +371,22 @@ C_RESULT video_com_stage_transform(video_com_config_t *cfg, vp_api_io_data_t *in
         {
           cfg->num_retries = 0;
         }
+
+#ifndef _WIN32
+      if (TRUE == bContinue && cfg->protocol == VP_COM_UDP)
+        {
+          bContinue = FALSE;
+          if (VP_FAILED (video_com_stage_read_datagrams (cfg, out)))
+            {
+              PDBG ("%s [%d] : status set to error !\n", __FUNCTION__, __LINE__);
+              perror ("Video_com_stage");
+              cfg->mustReconnect = 1;
+              out->size = 0;
+              vp_os_mutex_unlock (&out->lock);
+              return C_OK;
+            }
+        }
+#endif
  
       cfg->socket.block = VP_COM_DONTWAIT;
       int32_t readSize = cfg->buffer_size - out->size;
@@ -495,7 +548,10 @@ C_RESULT video_com_multisocket_stage_transform(video_com_multisocket_config_t *c
         {
        //   DEBUG_PRINT_SDK ("Will read on socket %d\n", i);
           // Actual first time read
+          VP_OS_TRACE_BEGIN_EVENT("video socket read");
           res = cfg->configs[i]->read(&cfg->configs[i]->socket, out->buffers[0], &out->size);
+          VP_OS_TRACE_END_EVENT("video socket read");
+          VP_OS_TRACE_COUNTER_EVENT("video read bytes", out->size);
           if (VP_FAILED (res))
             {
 	      PDBG ("%s [%d] : status set to error !\n", __FUNCTION__, __LINE__);
@@ -0,0 +1,428 @@
+/*
+ * video_latency_tracker.c
+ *
+ * Per hop latency of the video pipeline, see video_latency_tracker.h
+ */
+
+#include <ardrone_tool/Video/video_latency_tracker.h>
+#include <video_encapsulation.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_signal.h>
+#include <VP_Os/vp_os_print.h>
+#include <config.h>
+
+#include <string.h>
+#include <sys/time.h>
+
+// Navdata time keeps 11 bits of seconds
+#define VIDEO_LATENCY_DRONE_PERIOD_US   ((int64_t)(1 << (32 - TSECDEC)) * 1000000)
+
+typedef struct _video_latency_frame_t
+{
+  bool_t    used;
+  uint32_t  frame_number;
+  uint32_t  drone_timestamp;
+  int64_t   points[VIDEO_LATENCY_MAX_POINTS];   // Host time (us), 0 when not stamped
+} video_latency_frame_t;
+
+typedef struct _video_latency_tracker_t
+{
+  uint32_t                  num_points;
+  video_latency_frame_t     frames[VIDEO_LATENCY_MAX_FRAMES];
+  int64_t                   pending_receive_us;
+  bool_t                    has_current;
+  uint32_t                  current_frame;
+
+  // Drone to host clock offset, minimum of the current and previous windows
+  bool_t                    synced;
+  bool_t                    navdata_sync;
+  int64_t                   offset_us;
+  int64_t                   window_min_us;
+  int64_t                   previous_min_us;
+  int64_t                   window_start_us;
+
+  uint32_t                  frames_completed;
+  uint32_t                  frames_lost;
+  video_latency_hop_stats_t hops[VIDEO_LATENCY_MAX_POINTS + 1];
+} video_latency_tracker_t;
+
+static video_latency_tracker_t tracker;
+
+static const uint32_t video_latency_buckets_ms[VIDEO_LATENCY_NUM_BUCKETS] =
+  { 1, 2, 3, 4, 6, 8, 10, 13, 16, 20, 25, 33, 40, 50, 66, 83, 100, 133, 166, 250, 0 };
+
+static const char* video_latency_hop_names[VIDEO_LATENCY_POST_STAGE] =
+  { "network", "reassembly", "merge", "decode" };
+
+// Initialized by the first video_latency_tracker_init. The other functions do
+// nothing before it, tracker.num_points being 0, so they never lock it uninitialized.
+static vp_os_mutex_t tracker_mutex;
+static bool_t tracker_mutex_init = FALSE;
+
+const vp_api_stage_funcs_t video_latency_probe_funcs = {
+  (vp_api_stage_handle_msg_t) NULL,
+  (vp_api_stage_open_t) video_latency_probe_open,
+  (vp_api_stage_transform_t) video_latency_probe_transform,
+  (vp_api_stage_close_t) video_latency_probe_close
+};
+
+static int64_t video_latency_now_us( void )
+{
+  struct timeval tv;
+  gettimeofday( &tv, NULL );
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// Brings a difference of drone times back in ]-period/2, period/2]
+static int64_t video_latency_unwrap( int64_t delta )
+{
+  while( delta > VIDEO_LATENCY_DRONE_PERIOD_US / 2 )
+    delta -= VIDEO_LATENCY_DRONE_PERIOD_US;
+  while( delta <= -VIDEO_LATENCY_DRONE_PERIOD_US / 2 )
+    delta += VIDEO_LATENCY_DRONE_PERIOD_US;
+  return delta;
+}
+
+// Called with tracker_mutex locked
+static void video_latency_clock_sample( int64_t host_us, int64_t drone_us, bool_t from_navdata )
+{
+  int64_t offset = host_us - drone_us;
+
+  if( from_navdata == FALSE && tracker.navdata_sync == TRUE )
+    return;
+
+  if( from_navdata == TRUE && tracker.navdata_sync == FALSE )
+  {
+    // Navdata are a better reference than video frames, restart with them
+    tracker.navdata_sync = TRUE;
+    tracker.synced = FALSE;
+  }
+
+  if( tracker.synced == FALSE )
+  {
+    tracker.offset_us       = offset;
+    tracker.window_min_us   = offset;
+    tracker.previous_min_us = offset;
+    tracker.window_start_us = host_us;
+    tracker.synced          = TRUE;
+    return;
+  }
+
+  // Drone clock wraps, keep offsets continuous
+  offset = tracker.window_min_us + video_latency_unwrap( offset - tracker.window_min_us );
+
+  if( host_us - tracker.window_start_us > VIDEO_LATENCY_SYNC_WINDOW_US )
+  {
+    tracker.previous_min_us = tracker.window_min_us;
+    tracker.window_min_us   = offset;
+    tracker.window_start_us = host_us;
+  }
+  else if( offset < tracker.window_min_us )
+  {
+    tracker.window_min_us = offset;
+  }
+
+  tracker.offset_us = (tracker.window_min_us < tracker.previous_min_us) ? tracker.window_min_us : tracker.previous_min_us;
+}
+
+static int64_t video_latency_drone_ms_to_us( uint32_t drone_timestamp )
+{
+  return (int64_t)(drone_timestamp % (uint32_t)(VIDEO_LATENCY_DRONE_PERIOD_US / 1000)) * 1000;
+}
+
+static void video_latency_add_sample( video_latency_hop_stats_t* stats, int64_t latency_us )
+{
+  uint32_t us, b;
+
+  us = (latency_us < 0) ? 0 : (latency_us > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)latency_us;
+
+  if( stats->count == 0 || us < stats->min_us )
+    stats->min_us = us;
+  if( us > stats->max_us )
+    stats->max_us = us;
+  stats->sum_us += us;
+  stats->count++;
+
+  for( b = 0; b < VIDEO_LATENCY_NUM_BUCKETS - 1 && us >= video_latency_buckets_ms[b] * 1000; b++ );
+  stats->histogram[b]++;
+}
+
+// Called with tracker_mutex locked, frame went through its last point
+static void video_latency_complete( video_latency_frame_t* frame, int64_t now_us )
+{
+  int64_t capture = 0, previous = 0;
+  uint32_t p;
+
+  if( tracker.synced == TRUE )
+  {
+    capture  = video_latency_drone_ms_to_us( frame->drone_timestamp ) + tracker.offset_us;
+    capture  = now_us + video_latency_unwrap( capture - now_us );
+    previous = capture;
+  }
+
+  for( p = 0; p < tracker.num_points; p++ )
+  {
+    if( frame->points[p] != 0 )
+    {
+      if( previous != 0 )
+        video_latency_add_sample( &tracker.hops[p], frame->points[p] - previous );
+      previous = frame->points[p];
+    }
+  }
+
+  if( capture != 0 )
+    video_latency_add_sample( &tracker.hops[tracker.num_points], frame->points[tracker.num_points - 1] - capture );
+
+  tracker.frames_completed++;
+  frame->used = FALSE;
+}
+
+C_RESULT video_latency_tracker_init( uint32_t num_post_stages )
+{
+  uint32_t p;
+
+  if( num_post_stages > VIDEO_LATENCY_MAX_POST_STAGES )
+    num_post_stages = VIDEO_LATENCY_MAX_POST_STAGES;
+
+  if( tracker_mutex_init == FALSE )
+  {
+    vp_os_mutex_init( &tracker_mutex );
+    tracker_mutex_init = TRUE;
+  }
+
+  vp_os_mutex_lock( &tracker_mutex );
+
+  vp_os_memset( &tracker, 0, sizeof(tracker) );
+  tracker.num_points = VIDEO_LATENCY_POST_STAGE + num_post_stages;
+
+  for( p = 0; p < tracker.num_points; p++ )
+  {
+    if( p < VIDEO_LATENCY_POST_STAGE )
+      strncpy( tracker.hops[p].name, video_latency_hop_names[p], sizeof(tracker.hops[p].name) - 1 );
+    else
+      snprintf( tracker.hops[p].name, sizeof(tracker.hops[p].name), "post%d", p - VIDEO_LATENCY_POST_STAGE );
+  }
+  strncpy( tracker.hops[tracker.num_points].name, "total", sizeof(tracker.hops[p].name) - 1 );
+
+  vp_os_mutex_unlock( &tracker_mutex );
+
+  return C_OK;
+}
+
+void video_latency_tracker_clock_sync( uint32_t drone_time, uint32_t rx_sec, uint32_t rx_nsec )
+{
+  int64_t host_us, drone_us;
+
+  if( tracker.num_points == 0 )
+    return;
+
+  // Reception time is not available on every socket
+  host_us  = (rx_sec != 0) ? (int64_t)rx_sec * 1000000 + rx_nsec / 1000 : video_latency_now_us();
+  drone_us = (int64_t)(drone_time >> TSECDEC) * 1000000 + (drone_time & TUSECMASK);
+
+  vp_os_mutex_lock( &tracker_mutex );
+  video_latency_clock_sample( host_us, drone_us, TRUE );
+  vp_os_mutex_unlock( &tracker_mutex );
+}
+
+void video_latency_tracker_stamp( video_latency_point_t point, uint32_t frame_number, uint32_t drone_timestamp )
+{
+  video_latency_frame_t* frame;
+  int64_t now = video_latency_now_us();
+
+  if( point >= tracker.num_points )
+    return;
+
+  vp_os_mutex_lock( &tracker_mutex );
+
+  if( point == VIDEO_LATENCY_RECEIVED )
+  {
+    // Frame number is not known before reassembly
+    if( tracker.pending_receive_us == 0 )
+      tracker.pending_receive_us = now;
+  }
+  else if( point <= VIDEO_LATENCY_MERGED )
+  {
+    frame = &tracker.frames[frame_number % VIDEO_LATENCY_MAX_FRAMES];
+
+    if( frame->used == FALSE || frame->frame_number != frame_number )
+    {
+      if( frame->used == TRUE )
+        tracker.frames_lost++;
+
+      vp_os_memset( frame, 0, sizeof(*frame) );
+      frame->used            = TRUE;
+      frame->frame_number    = frame_number;
+      frame->drone_timestamp = drone_timestamp;
+    }
+
+    if( point == VIDEO_LATENCY_REASSEMBLED )
+    {
+      // First slice of the frame gives its reception time
+      if( frame->points[VIDEO_LATENCY_RECEIVED] == 0 )
+      {
+        frame->points[VIDEO_LATENCY_RECEIVED] = (tracker.pending_receive_us != 0) ? tracker.pending_receive_us : now;
+        video_latency_clock_sample( frame->points[VIDEO_LATENCY_RECEIVED], video_latency_drone_ms_to_us( drone_timestamp ), FALSE );
+      }
+      tracker.pending_receive_us = 0;
+    }
+
+    frame->points[point]  = now;
+    tracker.current_frame = frame_number;
+    tracker.has_current   = TRUE;
+  }
+  else if( tracker.has_current == TRUE )
+  {
+    // Pictures are not tagged, they come from the last frame given to the decoder
+    frame = &tracker.frames[tracker.current_frame % VIDEO_LATENCY_MAX_FRAMES];
+
+    if( frame->used == TRUE && frame->frame_number == tracker.current_frame )
+    {
+      frame->points[point] = now;
+      if( point == tracker.num_points - 1 )
+        video_latency_complete( frame, now );
+    }
+  }
+
+  vp_os_mutex_unlock( &tracker_mutex );
+}
+
+C_RESULT video_latency_tracker_get_hop( uint32_t hop, video_latency_hop_stats_t* stats )
+{
+  C_RESULT res = C_FAIL;
+
+  if( tracker.num_points == 0 )
+    return C_FAIL;
+
+  vp_os_mutex_lock( &tracker_mutex );
+  if( hop <= tracker.num_points )
+  {
+    vp_os_memcpy( stats, &tracker.hops[hop], sizeof(*stats) );
+    res = C_OK;
+  }
+  vp_os_mutex_unlock( &tracker_mutex );
+
+  return res;
+}
+
+uint32_t video_latency_tracker_bucket_ms( uint32_t bucket )
+{
+  return (bucket < VIDEO_LATENCY_NUM_BUCKETS) ? video_latency_buckets_ms[bucket] : 0;
+}
+
+uint32_t video_latency_tracker_percentile( const video_latency_hop_stats_t* stats, uint32_t percent )
+{
+  uint32_t b, total = 0, target;
+
+  if( stats->count == 0 )
+    return 0;
+
+  target = (stats->count * percent + 99) / 100;
+
+  for( b = 0; b < VIDEO_LATENCY_NUM_BUCKETS - 1; b++ )
+  {
+    total += stats->histogram[b];
+    if( total >= target )
+      return (video_latency_buckets_ms[b] * 1000 < stats->max_us) ? video_latency_buckets_ms[b] * 1000 : stats->max_us;
+  }
+
+  return stats->max_us;
+}
+
+C_RESULT video_latency_tracker_dump_json( FILE* f )
+{
+  video_latency_hop_stats_t stats;
+  uint32_t hop, b;
+
+  if( f == NULL || tracker.num_points == 0 )
+    return C_FAIL;
+
+  vp_os_mutex_lock( &tracker_mutex );
+  fprintf( f, "{\"clock\":\"%s\",\"offset_us\":%lld,\"frames\":%u,\"lost\":%u,\"buckets_ms\":[",
+           tracker.synced ? (tracker.navdata_sync ? "navdata" : "video") : "none",
+           (long long)tracker.offset_us, tracker.frames_completed, tracker.frames_lost );
+  vp_os_mutex_unlock( &tracker_mutex );
+
+  for( b = 0; b < VIDEO_LATENCY_NUM_BUCKETS - 1; b++ )
+    fprintf( f, "%s%u", (b == 0) ? "" : ",", video_latency_buckets_ms[b] );
+  fprintf( f, "],\"hops\":[" );
+
+  for( hop = 0; VP_SUCCEEDED( video_latency_tracker_get_hop( hop, &stats ) ); hop++ )
+  {
+    fprintf( f, "%s{\"name\":\"%s\",\"count\":%u,\"min_ms\":%.2f,\"mean_ms\":%.2f,\"p50_ms\":%.2f,\"p95_ms\":%.2f,\"p99_ms\":%.2f,\"max_ms\":%.2f,\"histogram\":[",
+             (hop == 0) ? "" : ",", stats.name, stats.count,
+             stats.min_us / 1000.0f,
+             (stats.count != 0) ? (float)stats.sum_us / stats.count / 1000.0f : 0.0f,
+             video_latency_tracker_percentile( &stats, 50 ) / 1000.0f,
+             video_latency_tracker_percentile( &stats, 95 ) / 1000.0f,
+             video_latency_tracker_percentile( &stats, 99 ) / 1000.0f,
+             stats.max_us / 1000.0f );
+
+    for( b = 0; b < VIDEO_LATENCY_NUM_BUCKETS; b++ )
+      fprintf( f, "%s%u", (b == 0) ? "" : ",", stats.histogram[b] );
+    fprintf( f, "]}" );
+  }
+
+  fprintf( f, "]}\n" );
+  fflush( f );
+
+  return C_OK;
+}
+
+void video_latency_tracker_print( void )
+{
+  video_latency_hop_stats_t stats;
+  uint32_t hop;
+
+  PRINT("Video latency (%u frames, %u lost) :\n", tracker.frames_completed, tracker.frames_lost);
+  for( hop = 0; VP_SUCCEEDED( video_latency_tracker_get_hop( hop, &stats ) ); hop++ )
+  {
+    PRINT("  %-12s mean %6.1f ms  p50 %6.1f ms  p95 %6.1f ms  max %6.1f ms\n", stats.name,
+          (stats.count != 0) ? (float)stats.sum_us / stats.count / 1000.0f : 0.0f,
+          video_latency_tracker_percentile( &stats, 50 ) / 1000.0f,
+          video_latency_tracker_percentile( &stats, 95 ) / 1000.0f,
+          stats.max_us / 1000.0f);
+  }
+}
+
+C_RESULT video_latency_probe_open( video_latency_probe_config_t* cfg )
+{
+  return C_OK;
+}
+
+C_RESULT video_latency_probe_transform( video_latency_probe_config_t* cfg, vp_api_io_data_t* in, vp_api_io_data_t* out )
+{
+  parrot_video_encapsulation_t* PaVE;
+
+  vp_os_mutex_lock( &out->lock );
+
+  out->numBuffers  = in->numBuffers;
+  out->buffers     = in->buffers;
+  out->indexBuffer = in->indexBuffer;
+  out->lineSize    = in->lineSize;
+  out->size        = in->size;
+  out->status      = in->status;
+
+  if( in->size > 0 && in->status != VP_API_STATUS_ERROR && in->buffers != NULL )
+  {
+    if( cfg->point == VIDEO_LATENCY_REASSEMBLED || cfg->point == VIDEO_LATENCY_MERGED )
+    {
+      PaVE = (parrot_video_encapsulation_t*) in->buffers[in->indexBuffer];
+      if( PaVE != NULL && PAVE_CHECK( PaVE ) )
+        video_latency_tracker_stamp( cfg->point, PaVE->frame_number, PaVE->timestamp );
+    }
+    else
+    {
+      video_latency_tracker_stamp( cfg->point, 0, 0 );
+    }
+  }
+
+  vp_os_mutex_unlock( &out->lock );
+
+  return C_OK;
+}
+
+C_RESULT video_latency_probe_close( video_latency_probe_config_t* cfg )
+{
+  return C_OK;
+}
@@ -0,0 +1,83 @@
+/*
+ * video_latency_tracker.h
+ *
+ * Per hop latency of the video pipeline, from the drone timestamp found in
+ * the PaVE of each frame to the last post decoding stage.
+ *
+ * Probe stages inserted by video_stage stamp frames on the host when they
+ * leave the socket, the TCP reassembly, the slice merger, the decoder and each
+ * post decoding stage. Drone and host clocks are aligned with the navdata time
+ * option (reception time minus drone time, minimum over a sliding window),
+ * or with the video itself when navdata do not carry time, in which case the
+ * "network" hop is only relative to the fastest frame.
+ */
+
+#ifndef _VIDEO_LATENCY_TRACKER_H_
+#define _VIDEO_LATENCY_TRACKER_H_
+
+#include <stdio.h>
+#include <VP_Api/vp_api.h>
+
+#define VIDEO_LATENCY_MAX_POST_STAGES   8
+#define VIDEO_LATENCY_MAX_FRAMES        32      // Frames in flight
+#define VIDEO_LATENCY_NUM_BUCKETS       21
+#define VIDEO_LATENCY_SYNC_WINDOW_US    10000000
+
+typedef enum
+{
+  VIDEO_LATENCY_RECEIVED = 0,   // First data of the frame read from the socket
+  VIDEO_LATENCY_REASSEMBLED,    // Complete frame out of the TCP stage
+  VIDEO_LATENCY_MERGED,         // Frame (or its last slice) given to the decoder
+  VIDEO_LATENCY_DECODED,        // Picture out of the decoder
+  VIDEO_LATENCY_POST_STAGE,     // + index of the post decoding stage
+  VIDEO_LATENCY_MAX_POINTS = VIDEO_LATENCY_POST_STAGE + VIDEO_LATENCY_MAX_POST_STAGES
+} video_latency_point_t;
+
+typedef struct _video_latency_hop_stats_t
+{
+  char      name[16];
+  uint32_t  count;
+  uint32_t  min_us;
+  uint32_t  max_us;
+  uint64_t  sum_us;
+  uint32_t  histogram[VIDEO_LATENCY_NUM_BUCKETS];  // Upper bounds in video_latency_tracker_bucket_ms
+} video_latency_hop_stats_t;
+
+typedef struct _video_latency_probe_config_t
+{
+  video_latency_point_t point;
+} video_latency_probe_config_t;
+
+/** Clears statistics, num_post_stages probes follow the decoder. Called before the other functions. */
+C_RESULT video_latency_tracker_init( uint32_t num_post_stages );
+
+/** Navdata time (TSECDEC format) received at host time rx_sec / rx_nsec (CLOCK_REALTIME) */
+void video_latency_tracker_clock_sync( uint32_t drone_time, uint32_t rx_sec, uint32_t rx_nsec );
+
+/** Stamps point for frame_number, drone_timestamp is the PaVE timestamp (ms) */
+void video_latency_tracker_stamp( video_latency_point_t point, uint32_t frame_number, uint32_t drone_timestamp );
+
+/**
+ * Hop index goes from 0 (drone to host) to the number of points in use,
+ * the last one being the total. Returns C_FAIL past the last hop.
+ */
+C_RESULT video_latency_tracker_get_hop( uint32_t hop, video_latency_hop_stats_t* stats );
+
+/** Upper bound of a histogram bucket, 0 for the last (unbounded) one */
+uint32_t video_latency_tracker_bucket_ms( uint32_t bucket );
+
+/** Latency in us below which percent % of the hop samples are */
+uint32_t video_latency_tracker_percentile( const video_latency_hop_stats_t* stats, uint32_t percent );
+
+/** Writes all hops as one JSON object */
+C_RESULT video_latency_tracker_dump_json( FILE* f );
+
+void video_latency_tracker_print( void );
+
+C_RESULT video_latency_probe_open( video_latency_probe_config_t* cfg );
+C_RESULT video_latency_probe_transform( video_latency_probe_config_t* cfg, vp_api_io_data_t* in, vp_api_io_data_t* out );
+C_RESULT video_latency_probe_close( video_latency_probe_config_t* cfg );
+
+extern const vp_api_stage_funcs_t video_latency_probe_funcs;
+
+#endif // _VIDEO_LATENCY_TRACKER_H_
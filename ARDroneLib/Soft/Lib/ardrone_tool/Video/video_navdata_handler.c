@@ -1,5 +1,8 @@
 #include <ardrone_tool/Video/video_navdata_handler.h>
 #include <ardrone_tool/Video/video_com_stage.h>
+#include <ardrone_tool/Video/video_latency_tracker.h>
+#include <ardrone_tool/Video/video_bitrate_controller.h>
+#include <ardrone_tool/Video/video_navdata_sync.h>
 #include <ardrone_tool/ardrone_tool_configuration.h>
 
 
@@ -80,6 +83,27 @@ C_RESULT video_navdata_handler_process( const navdata_unpacked_t* const navdata
     }
   }
 
+  /* Drone clock, for video latency measurement */
+  if (navdata->last_navdata_refresh & NAVDATA_OPTION_MASK(NAVDATA_TIME_TAG))
+  {
+    uint32_t rx_sec, rx_nsec;
+    ardrone_navdata_client_get_rx_timestamp (&rx_sec, &rx_nsec);
+    video_latency_tracker_clock_sync (navdata->navdata_time.time, rx_sec, rx_nsec);
+  }
+
+  /* Drone state history, for frame / navdata matching */
+  if ((navdata->last_navdata_refresh & NAVDATA_OPTION_MASK(NAVDATA_TIME_TAG)) &&
+      (navdata->last_navdata_refresh & NAVDATA_OPTION_MASK(NAVDATA_DEMO_TAG)))
+  {
+    video_navdata_sync_push (navdata);
+  }
+
+  /* Link quality, for the host bitrate controller */
+  if (navdata->last_navdata_refresh & NAVDATA_OPTION_MASK(NAVDATA_WIFI_TAG))
+  {
+    video_bitrate_controller_set_link_quality (navdata->navdata_wifi.link_quality);
+  }
+
   /* Video storage navdatas */
   hdvideo_remaining_frames = navdata->navdata_hdvideo_stream.storage_fifo_nb_packets;
   hdvideo_remaining_kilobytes = navdata->navdata_hdvideo_stream.storage_fifo_size;
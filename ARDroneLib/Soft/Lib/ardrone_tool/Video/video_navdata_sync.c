@@ -0,0 +1,244 @@
+/*
+ * video_navdata_sync.c
+ *
+ * Drone state at the time a video frame was taken, see video_navdata_sync.h
+ */
+
+#include <ardrone_tool/Video/video_navdata_sync.h>
+#include <video_encapsulation.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_signal.h>
+#include <config.h>
+
+// Navdata time keeps 11 bits of seconds
+#define VIDEO_NAVDATA_SYNC_PERIOD_US  ((int32_t)(1 << (32 - TSECDEC)) * 1000000)
+
+typedef struct _video_navdata_sample_t
+{
+  int32_t     time_us;    // Drone time modulo VIDEO_NAVDATA_SYNC_PERIOD_US
+  uint32_t    ctrl_state;
+  float32_t   theta;
+  float32_t   phi;
+  float32_t   psi;
+  int32_t     altitude;
+  float32_t   vx;
+  float32_t   vy;
+  float32_t   vz;
+} video_navdata_sample_t;
+
+static video_navdata_sample_t sync_samples[VIDEO_NAVDATA_SYNC_SAMPLES];
+static uint32_t sync_count = 0;   // Samples pushed, the last one is at (sync_count - 1) % VIDEO_NAVDATA_SYNC_SAMPLES
+static video_navdata_state_t sync_frame;
+
+#ifdef PTHREAD_MUTEX_INITIALIZER
+static vp_os_mutex_t sync_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define video_navdata_sync_mutex_init()
+#else
+static vp_os_mutex_t sync_mutex;
+static bool_t sync_mutex_init = FALSE;
+static void video_navdata_sync_mutex_init( void )
+{
+  if( sync_mutex_init == FALSE )
+  {
+    vp_os_mutex_init( &sync_mutex );
+    sync_mutex_init = TRUE;
+  }
+}
+#endif
+
+const vp_api_stage_funcs_t video_navdata_sync_funcs = {
+  (vp_api_stage_handle_msg_t) NULL,
+  (vp_api_stage_open_t) video_navdata_sync_open,
+  (vp_api_stage_transform_t) video_navdata_sync_transform,
+  (vp_api_stage_close_t) video_navdata_sync_close
+};
+
+// Drone clock wraps, differences are brought back to half a period
+static int32_t video_navdata_sync_unwrap( int32_t delta )
+{
+  if( delta > VIDEO_NAVDATA_SYNC_PERIOD_US / 2 )
+    delta -= VIDEO_NAVDATA_SYNC_PERIOD_US;
+  else if( delta <= -VIDEO_NAVDATA_SYNC_PERIOD_US / 2 )
+    delta += VIDEO_NAVDATA_SYNC_PERIOD_US;
+  return delta;
+}
+
+static float32_t video_navdata_sync_lerp( float32_t a, float32_t b, float32_t t )
+{
+  return a + (b - a) * t;
+}
+
+// Yaw goes the short way around
+static float32_t video_navdata_sync_lerp_psi( float32_t a, float32_t b, float32_t t )
+{
+  float32_t diff = b - a;
+  float32_t psi;
+
+  if( diff > 180000.0f )
+    diff -= 360000.0f;
+  else if( diff < -180000.0f )
+    diff += 360000.0f;
+
+  psi = a + diff * t;
+  if( psi > 180000.0f )
+    psi -= 360000.0f;
+  else if( psi <= -180000.0f )
+    psi += 360000.0f;
+  return psi;
+}
+
+static void video_navdata_sync_fill( video_navdata_state_t* state, const video_navdata_sample_t* sample )
+{
+  state->ctrl_state = sample->ctrl_state;
+  state->theta      = sample->theta;
+  state->phi        = sample->phi;
+  state->psi        = sample->psi;
+  state->altitude   = sample->altitude;
+  state->vx         = sample->vx;
+  state->vy         = sample->vy;
+  state->vz         = sample->vz;
+}
+
+void video_navdata_sync_push( const navdata_unpacked_t* navdata )
+{
+  uint32_t time = navdata->navdata_time.time;
+  int32_t time_us = (int32_t)((time >> TSECDEC) * 1000000 + (time & TUSECMASK));
+  video_navdata_sample_t* sample;
+
+  video_navdata_sync_mutex_init();
+  vp_os_mutex_lock( &sync_mutex );
+
+  // Keep samples ordered, a repeated or late packet is ignored
+  if( sync_count > 0 &&
+      video_navdata_sync_unwrap( time_us - sync_samples[(sync_count - 1) % VIDEO_NAVDATA_SYNC_SAMPLES].time_us ) <= 0 )
+  {
+    vp_os_mutex_unlock( &sync_mutex );
+    return;
+  }
+
+  sample = &sync_samples[sync_count % VIDEO_NAVDATA_SYNC_SAMPLES];
+  sample->time_us    = time_us;
+  sample->ctrl_state = navdata->navdata_demo.ctrl_state;
+  sample->theta      = navdata->navdata_demo.theta;
+  sample->phi        = navdata->navdata_demo.phi;
+  sample->psi        = navdata->navdata_demo.psi;
+  sample->altitude   = navdata->navdata_demo.altitude;
+  sample->vx         = navdata->navdata_demo.vx;
+  sample->vy         = navdata->navdata_demo.vy;
+  sample->vz         = navdata->navdata_demo.vz;
+  sync_count++;
+
+  vp_os_mutex_unlock( &sync_mutex );
+}
+
+C_RESULT video_navdata_sync_lookup( uint32_t timestamp, video_navdata_state_t* state )
+{
+  int32_t frame_us = (int32_t)((timestamp % (uint32_t)(VIDEO_NAVDATA_SYNC_PERIOD_US / 1000)) * 1000);
+  const video_navdata_sample_t* before = NULL;
+  const video_navdata_sample_t* after = NULL;
+  int32_t before_delta = 0, after_delta = 0;
+  uint32_t stored, i;
+
+  vp_os_memset( state, 0, sizeof(*state) );
+  state->timestamp = timestamp;
+
+  video_navdata_sync_mutex_init();
+  vp_os_mutex_lock( &sync_mutex );
+
+  stored = (sync_count < VIDEO_NAVDATA_SYNC_SAMPLES) ? sync_count : VIDEO_NAVDATA_SYNC_SAMPLES;
+
+  // Walk from the newest sample to the first one taken before the frame
+  for( i = 0; i < stored && before == NULL; i++ )
+  {
+    const video_navdata_sample_t* sample = &sync_samples[(sync_count - 1 - i) % VIDEO_NAVDATA_SYNC_SAMPLES];
+    int32_t delta = video_navdata_sync_unwrap( sample->time_us - frame_us );
+
+    if( delta <= 0 )
+    {
+      before = sample;
+      before_delta = delta;
+    }
+    else
+    {
+      after = sample;
+      after_delta = delta;
+    }
+  }
+
+  if( before != NULL && after != NULL )
+  {
+    float32_t t = (float32_t)(-before_delta) / (float32_t)(after_delta - before_delta);
+
+    state->valid        = TRUE;
+    state->interpolated = TRUE;
+    state->delta_us     = (-before_delta < after_delta) ? before_delta : after_delta;
+    video_navdata_sync_fill( state, (-before_delta < after_delta) ? before : after );
+    state->theta    = video_navdata_sync_lerp( before->theta, after->theta, t );
+    state->phi      = video_navdata_sync_lerp( before->phi, after->phi, t );
+    state->psi      = video_navdata_sync_lerp_psi( before->psi, after->psi, t );
+    state->altitude = (int32_t)video_navdata_sync_lerp( (float32_t)before->altitude, (float32_t)after->altitude, t );
+    state->vx       = video_navdata_sync_lerp( before->vx, after->vx, t );
+    state->vy       = video_navdata_sync_lerp( before->vy, after->vy, t );
+    state->vz       = video_navdata_sync_lerp( before->vz, after->vz, t );
+  }
+  else if( before != NULL || after != NULL )
+  {
+    state->valid    = TRUE;
+    state->delta_us = (before != NULL) ? before_delta : after_delta;
+    video_navdata_sync_fill( state, (before != NULL) ? before : after );
+  }
+
+  vp_os_mutex_unlock( &sync_mutex );
+
+  return (state->valid == TRUE) ? C_OK : C_FAIL;
+}
+
+C_RESULT video_navdata_sync_get_frame_state( video_navdata_state_t* state )
+{
+  *state = sync_frame;
+  return (sync_frame.valid == TRUE) ? C_OK : C_FAIL;
+}
+
+C_RESULT video_navdata_sync_open( video_navdata_sync_config_t* cfg )
+{
+  vp_os_memset( &cfg->frame, 0, sizeof(cfg->frame) );
+  vp_os_memset( &sync_frame, 0, sizeof(sync_frame) );
+  return C_OK;
+}
+
+C_RESULT video_navdata_sync_transform( video_navdata_sync_config_t* cfg, vp_api_io_data_t* in, vp_api_io_data_t* out )
+{
+  parrot_video_encapsulation_t* PaVE;
+
+  vp_os_mutex_lock( &out->lock );
+
+  out->numBuffers  = in->numBuffers;
+  out->buffers     = in->buffers;
+  out->indexBuffer = in->indexBuffer;
+  out->lineSize    = in->lineSize;
+  out->size        = in->size;
+  out->status      = in->status;
+
+  if( in->size > 0 && in->status != VP_API_STATUS_ERROR && in->buffers != NULL )
+  {
+    PaVE = (parrot_video_encapsulation_t*) in->buffers[in->indexBuffer];
+
+    // Slices of the same frame share the lookup
+    if( PaVE != NULL && PAVE_CHECK( PaVE ) &&
+        (cfg->frame.frame_number != PaVE->frame_number || cfg->frame.timestamp != PaVE->timestamp || !cfg->frame.valid) )
+    {
+      video_navdata_sync_lookup( PaVE->timestamp, &cfg->frame );
+      cfg->frame.frame_number = PaVE->frame_number;
+      sync_frame = cfg->frame;
+    }
+  }
+
+  vp_os_mutex_unlock( &out->lock );
+
+  return C_OK;
+}
+
+C_RESULT video_navdata_sync_close( video_navdata_sync_config_t* cfg )
+{
+  return C_OK;
+}
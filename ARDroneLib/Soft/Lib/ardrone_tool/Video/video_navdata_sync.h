@@ -0,0 +1,63 @@
+/*
+ * video_navdata_sync.h
+ *
+ * Drone state at the time a video frame was taken.
+ *
+ * The navdata handler keeps the last samples of navdata_demo indexed by the
+ * navdata time option. Navdata time and the PaVE timestamp both come from the
+ * drone clock, so each frame is matched without any host clock involved : the
+ * state is interpolated between the two samples around the frame, or taken
+ * from the nearest one when the frame is outside the stored range.
+ *
+ * The sync stage, inserted by video_stage before the decoder, looks up the
+ * state of the frame being decoded. Post decoding stages run in the same
+ * thread and read it with video_navdata_sync_get_frame_state.
+ */
+
+#ifndef _VIDEO_NAVDATA_SYNC_H_
+#define _VIDEO_NAVDATA_SYNC_H_
+
+#include <VP_Api/vp_api.h>
+#include <ardrone_api.h>
+
+#define VIDEO_NAVDATA_SYNC_SAMPLES  128     // 0.6 s of full navdata, 8 s of demo navdata
+
+typedef struct _video_navdata_state_t
+{
+  bool_t      valid;          // FALSE when no navdata sample is stored
+  bool_t      interpolated;   // TRUE when the frame is between two samples
+  uint32_t    timestamp;      // Frame drone time (ms)
+  int32_t     delta_us;       // Nearest sample time minus frame time
+  uint32_t    frame_number;
+
+  uint32_t    ctrl_state;     // From the nearest sample
+  float32_t   theta;          // milli-degrees
+  float32_t   phi;            // milli-degrees
+  float32_t   psi;            // milli-degrees, in ]-180000, 180000]
+  int32_t     altitude;       // cm
+  float32_t   vx;
+  float32_t   vy;
+  float32_t   vz;
+} video_navdata_state_t;
+
+typedef struct _video_navdata_sync_config_t
+{
+  video_navdata_state_t frame;  // State of the last frame seen by the stage
+} video_navdata_sync_config_t;
+
+/** Stores a sample, called by the navdata handler when demo and time options are received */
+void video_navdata_sync_push( const navdata_unpacked_t* navdata );
+
+/** State at drone time timestamp (ms, PaVE timestamp), returns C_FAIL if no sample is stored */
+C_RESULT video_navdata_sync_lookup( uint32_t timestamp, video_navdata_state_t* state );
+
+/** State of the frame in the video pipeline, from the video thread only */
+C_RESULT video_navdata_sync_get_frame_state( video_navdata_state_t* state );
+
+C_RESULT video_navdata_sync_open( video_navdata_sync_config_t* cfg );
+C_RESULT video_navdata_sync_transform( video_navdata_sync_config_t* cfg, vp_api_io_data_t* in, vp_api_io_data_t* out );
+C_RESULT video_navdata_sync_close( video_navdata_sync_config_t* cfg );
+
+extern const vp_api_stage_funcs_t video_navdata_sync_funcs;
+
+#endif // _VIDEO_NAVDATA_SYNC_H_
@@ -9,6 +9,7 @@
 
 #include <VP_Api/vp_api.h>
 #include <VP_Api/vp_api_error.h>
+#include <VP_Os/vp_os_trace.h>
 
 #include <ardrone_tool/ardrone_tool.h>
 #include <ardrone_tool/Com/config_com.h>
@@ -46,6 +47,17 @@ static video_stage_tcp_config_t tcpConf;
 
 video_decoder_config_t vec;
 
+static video_latency_probe_config_t latency_probes[VIDEO_LATENCY_MAX_POINTS];
+static video_navdata_sync_config_t navdata_sync_cfg;
+
+static void video_stage_add_latency_probe(vp_api_io_pipeline_t *pipeline, video_latency_point_t point)
+{
+    latency_probes[point].point = point;
+    pipeline->stages[pipeline->nb_stages].type    = VP_API_FILTER_DECODER;
+    pipeline->stages[pipeline->nb_stages].cfg     = (void *) &latency_probes[point];
+    pipeline->stages[pipeline->nb_stages++].funcs = video_latency_probe_funcs;
+}
+
 
 void video_stage_init(void) {
     vp_os_mutex_init(&video_stage_mutex);
@@ -82,6 +94,8 @@ DEFINE_THREAD_ROUTINE(video_stage, data) {
     {
       CHANGE_THREAD_PRIO (video_stage, params->priority);
     }
+
+    vp_os_trace_set_thread_name("video_stage");
     
     vp_os_memset(&icc_tcp, 0, sizeof ( icc_tcp));
     vp_os_memset(&icc_udp, 0, sizeof ( icc_udp));
@@ -109,7 +123,9 @@ DEFINE_THREAD_ROUTINE(video_stage, data) {
      vp_os_memset(&vec, 0, sizeof ( vec));
 
      stages = (vp_api_io_stage_t*) (vp_os_calloc(
-        NB_STAGES + params->pre_processing_stages_list->length + params->post_processing_stages_list->length,
+        NB_STAGES + params->pre_processing_stages_list->length + params->post_processing_stages_list->length +
+        ((1 == params->latencyTracking) ? VIDEO_LATENCY_MAX_POINTS : 0) +
+        ((1 == params->navdataSync) ? 1 : 0),
         sizeof (vp_api_io_stage_t)
     ));
     
@@ -122,6 +138,11 @@ DEFINE_THREAD_ROUTINE(video_stage, data) {
     tcpConf.tcpStageHasMoreData = FALSE;
     tcpConf.latencyDrop = 1;
 
+    if (1 == params->adaptiveBitrate)
+    {
+        video_bitrate_controller_init(NULL);
+    }
+
     pipeline.nb_stages = 0;
     pipeline.stages = &stages[0];
 
@@ -130,9 +151,18 @@ DEFINE_THREAD_ROUTINE(video_stage, data) {
     stages[pipeline.nb_stages].cfg     = (void *) &icc;
     stages[pipeline.nb_stages++].funcs = video_com_multisocket_funcs;
 
+    if (1 == params->latencyTracking)
+    {
+        video_latency_tracker_init(params->post_processing_stages_list->length);
+        video_stage_add_latency_probe(&pipeline, VIDEO_LATENCY_RECEIVED);
+    }
+
     stages[pipeline.nb_stages].type    = VP_API_FILTER_DECODER;
     stages[pipeline.nb_stages].cfg     = (void *) &tcpConf;
     stages[pipeline.nb_stages++].funcs = video_stage_tcp_funcs;
+
+    if (1 == params->latencyTracking)
+        video_stage_add_latency_probe(&pipeline, VIDEO_LATENCY_REASSEMBLED);
     
     // Record Encoded video
     if(1 == ARDRONE_VERSION())
@@ -155,20 +185,42 @@ DEFINE_THREAD_ROUTINE(video_stage, data) {
         stages[pipeline.nb_stages++].funcs = params->pre_processing_stages_list->stages_list[i].funcs;
     }
 
+    vp_os_memset(&merge_slices_cfg, 0, sizeof (merge_slices_cfg));
+#if defined (FFMPEG_SUPPORT) && !defined (ITTIAM_SUPPORT)
+    // Only the FFMPEG decoder is able to decode slices one by one
+    merge_slices_cfg.low_latency = (1 == params->lowLatencyDecoding) ? TRUE : FALSE;
+#endif
+
     stages[pipeline.nb_stages].type    = VP_API_FILTER_DECODER;
     stages[pipeline.nb_stages].cfg     = (void *)&merge_slices_cfg;
     stages[pipeline.nb_stages++].funcs = video_stage_merge_slices_funcs;
 
+    if (1 == params->latencyTracking)
+        video_stage_add_latency_probe(&pipeline, VIDEO_LATENCY_MERGED);
+
+    if (1 == params->navdataSync)
+    {
+        stages[pipeline.nb_stages].type    = VP_API_FILTER_DECODER;
+        stages[pipeline.nb_stages].cfg     = (void *)&navdata_sync_cfg;
+        stages[pipeline.nb_stages++].funcs = video_navdata_sync_funcs;
+    }
+
     //DECODING STAGES
     stages[pipeline.nb_stages].type    = VP_API_FILTER_DECODER;
     stages[pipeline.nb_stages].cfg     = (void*) &vec;
     stages[pipeline.nb_stages++].funcs = video_decoding_funcs;
 
+    if (1 == params->latencyTracking)
+        video_stage_add_latency_probe(&pipeline, VIDEO_LATENCY_DECODED);
+
     //POST-DECODING STAGES ==> transformation, display, ...
     for(i=0;i<params->post_processing_stages_list->length;i++){
         stages[pipeline.nb_stages].type    = params->post_processing_stages_list->stages_list[i].type;
         stages[pipeline.nb_stages].cfg     = params->post_processing_stages_list->stages_list[i].cfg;
         stages[pipeline.nb_stages++].funcs = params->post_processing_stages_list->stages_list[i].funcs;
+
+        if (1 == params->latencyTracking && i < VIDEO_LATENCY_MAX_POST_STAGES)
+            video_stage_add_latency_probe(&pipeline, VIDEO_LATENCY_POST_STAGE + i);
     }
 
 
@@ -194,6 +246,10 @@ DEFINE_THREAD_ROUTINE(video_stage, data) {
                         loop = SUCCESS;
                     }
                 } else loop = -1; // Finish this thread
+
+                if (1 == params->adaptiveBitrate) {
+                    video_bitrate_controller_step(&tcpConf, video_stage_decoder_get_decoding_time_usec(&vec));
+                }
             }
             
             vp_os_free(params->pre_processing_stages_list->stages_list);
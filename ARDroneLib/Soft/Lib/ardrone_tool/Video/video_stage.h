@@ -27,6 +27,9 @@
 #include <ardrone_tool/Video/video_stage_decoder.h>
 #include <ardrone_tool/Video/video_stage_merge_slices.h>
 #include <ardrone_tool/Video/video_stage_latency_estimation.h>
+#include <ardrone_tool/Video/video_latency_tracker.h>
+#include <ardrone_tool/Video/video_bitrate_controller.h>
+#include <ardrone_tool/Video/video_navdata_sync.h>
 
 typedef struct _specific_stages_t_
 {
@@ -42,6 +45,10 @@ typedef struct _specific_parameters_t_
     vp_api_picture_t * out_pic;
     int needSetPriority;
     int priority;
+    int lowLatencyDecoding; // 1 : decode H264 slices as they arrive instead of waiting for the whole frame
+    int latencyTracking;    // 1 : measure per stage latency, see video_latency_tracker.h
+    int adaptiveBitrate;    // 1 : adapt drone bitrate and resolution to the host, see video_bitrate_controller.h
+    int navdataSync;        // 1 : match each frame with the drone state, see video_navdata_sync.h
 } specific_parameters_t;
 
 extern video_decoder_config_t vec;
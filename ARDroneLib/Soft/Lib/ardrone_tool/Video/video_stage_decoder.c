@@ -12,6 +12,7 @@
 #include <video_encapsulation.h>
 #include <VP_Os/vp_os_malloc.h>
 #include <VP_Os/vp_os_print.h>
+#include <VP_Os/vp_os_trace.h>
 #include <stdio.h>
 
 #ifndef USE_ANDROID
@@ -49,6 +50,8 @@ C_RESULT mp4h264_close (mp4h264_config_t *cfg);
  */
 #if defined(TARGET_OS_IPHONE) || defined (TARGET_OS_IPHONE_SIMULATOR)
 #include <mach/mach_time.h>
+#elif !defined (_WIN32)
+#include <sys/time.h>
 #endif
 float DEBUG_decodingTimeUsec = 0.0;
 
@@ -100,6 +103,7 @@ C_RESULT video_stage_decoder_open (video_decoder_config_t *cfg)
     ALLOC_CHECK (cfg->vlibOut, sizeof (vp_api_io_data_t));
     ALLOC_CHECK (cfg->mp4h264Conf, sizeof (mp4h264_config_t));
     ALLOC_CHECK (cfg->mp4h264Out, sizeof (vp_api_io_data_t));
+    cfg->decodingTimeUsec = 0.0;
 
     // Fill alloc'd structs with data from cfg
     // --> MPEG4 / H264
@@ -159,12 +163,17 @@ C_RESULT video_stage_decoder_transform (video_decoder_config_t *cfg, vp_api_io_d
     uint64_t startTime = 0;
     uint64_t stopTime = 0;
     uint64_t elapsedNano = 0;
+    float elapsedUsec;
     static mach_timebase_info_data_t sTimebaseInfo;
     if (0 == sTimebaseInfo.denom)
     {
         mach_timebase_info (&sTimebaseInfo);
     }
     startTime = mach_absolute_time ();
+#elif !defined (_WIN32)
+    struct timeval startTime, stopTime;
+    float elapsedUsec;
+    gettimeofday (&startTime, NULL);
 #endif
 
 
@@ -241,7 +250,9 @@ C_RESULT video_stage_decoder_transform (video_decoder_config_t *cfg, vp_api_io_d
 
         cfg->mp4h264Conf->num_picture_decoded = cfg->num_picture_decoded;
 
+        VP_OS_TRACE_BEGIN_EVENT ("video decode");
         retVal = mp4h264_transform (cfg->mp4h264Conf, in, cfg->mp4h264Out);
+        VP_OS_TRACE_END_EVENT ("video decode");
         if (C_FAIL == retVal)
         {
             return retVal;
@@ -276,14 +287,21 @@ C_RESULT video_stage_decoder_transform (video_decoder_config_t *cfg, vp_api_io_d
 #if defined(TARGET_OS_IPHONE) || defined (TARGET_OS_IPHONE_SIMULATOR)
     stopTime = mach_absolute_time ();
     elapsedNano = (stopTime - startTime) * sTimebaseInfo.numer / sTimebaseInfo.denom;
-    if (0.0 == DEBUG_decodingTimeUsec)
+    elapsedUsec = elapsedNano / 1000.0;
+#elif !defined (_WIN32)
+    gettimeofday (&stopTime, NULL);
+    elapsedUsec = (stopTime.tv_sec - startTime.tv_sec) * 1000000.0 + (stopTime.tv_usec - startTime.tv_usec);
+#endif
+#if !defined (_WIN32)
+    if (0.0 == cfg->decodingTimeUsec)
     {
-        DEBUG_decodingTimeUsec = elapsedNano / 1000.0;
+        cfg->decodingTimeUsec = elapsedUsec;
     }
     else
     {
-        DEBUG_decodingTimeUsec = 0.9 * DEBUG_decodingTimeUsec + (0.1 * elapsedNano / 1000.0);
+        cfg->decodingTimeUsec = 0.9 * cfg->decodingTimeUsec + 0.1 * elapsedUsec;
     }
+    DEBUG_decodingTimeUsec = cfg->decodingTimeUsec;
 #endif
 
 
@@ -296,6 +314,11 @@ C_RESULT video_stage_decoder_transform (video_decoder_config_t *cfg, vp_api_io_d
 }
 
 
+float video_stage_decoder_get_decoding_time_usec (const video_decoder_config_t *cfg)
+{
+    return cfg->decodingTimeUsec;
+}
+
 C_RESULT video_stage_decoder_close (video_decoder_config_t *cfg)
 {
     C_RESULT res, resVlib, resMp4h264;
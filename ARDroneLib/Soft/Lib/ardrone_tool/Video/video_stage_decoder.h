@@ -39,6 +39,7 @@ typedef struct _video_decoder_config_t
   uint32_t num_picture_decoded;
   uint32_t rowstride;
   uint32_t bpp;
+  float decodingTimeUsec; // Smoothed time spent in video_stage_decoder_transform
 
   // Internal datas
   bool_t vlibMustChangeFormat;
@@ -52,6 +53,9 @@ C_RESULT video_stage_decoder_open (video_decoder_config_t *cfg);
 C_RESULT video_stage_decoder_transform (video_decoder_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out);
 C_RESULT video_stage_decoder_close (video_decoder_config_t *cfg);
 
+/** Smoothed decoding time of the stage using cfg, 0 before the first frame */
+float video_stage_decoder_get_decoding_time_usec (const video_decoder_config_t *cfg);
+
 extern const vp_api_stage_funcs_t video_decoding_funcs;
 
 #endif // __VIDEO_STAGE_DECODER_H__
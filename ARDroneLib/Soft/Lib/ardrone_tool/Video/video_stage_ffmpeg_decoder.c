@@ -412,6 +412,16 @@ C_RESULT ffmpeg_stage_decoding_transform(ffmpeg_stage_decoding_config_t *cfg, vp
             }
           else if (PaVE.video_codec == CODEC_MPEG4_AVC)
             {
+              /* Slices which were not merged (low latency mode) are decoded one by one,
+               * the picture is finished as soon as its last macroblock row is decoded */
+              if (PaVE.total_slices > 1)
+                {
+                  pCodecCtxH264->flags2 |= CODEC_FLAG2_CHUNKS;
+                }
+              else
+                {
+                  pCodecCtxH264->flags2 &= ~CODEC_FLAG2_CHUNKS;
+                }
               avcodec_decode_video2 (pCodecCtxH264, pFrame, &frameFinished, &packet);
             }
         
@@ -425,6 +435,7 @@ C_RESULT ffmpeg_stage_decoding_transform(ffmpeg_stage_decoding_config_t *cfg, vp
                         pFrameOutput->data, pFrameOutput->linesize);
 				
               cfg->num_picture_decoded++;
+              out->size = avpicture_get_size(cfg->dst_picture.format, cfg->dst_picture.width, cfg->dst_picture.height);
 
 #ifdef NUM_SAMPLES
               gettimeofday(&end_time, NULL);
@@ -441,6 +452,11 @@ C_RESULT ffmpeg_stage_decoding_transform(ffmpeg_stage_decoding_config_t *cfg, vp
                 }					
 #endif
             }
+          else if (PaVE.slice_index + 1 < PaVE.total_slices)
+            {
+              /* Picture is not complete yet, don't give it to the next stages */
+              out->size = 0;
+            }
           else
             {
         	  /* Skip frames are usually 7 bytes long
@@ -62,7 +62,10 @@
 #endif
 
 #include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_signal.h>
+#include <VP_Os/vp_os_thread.h>
 #include <VP_Api/vp_api_picture.h>
+#include <VP_Api/vp_api_thread_helper.h>
 
 #include <config.h>
 #include <ardrone_tool/Video/video_stage_ffmpeg_recorder.h>
@@ -79,7 +82,8 @@ double video_pts;
 int i;
 
 #define STREAM_BIT_RATE_KBITS 1600
-static const int sws_flags = SWS_BICUBIC;
+static int sws_flags = SWS_FAST_BILINEAR;
+static struct SwsContext *img_convert_ctx = NULL;
 
 AVFrame *picture_to_encode=NULL, *tmp_picture=NULL;
 uint8_t *video_outbuf=NULL;
@@ -93,12 +97,165 @@ const vp_api_stage_funcs_t video_ffmpeg_recorder_funcs = {
   (vp_api_stage_close_t) video_stage_ffmpeg_recorder_close
 };
 
-struct
+/*- Recorder thread : the only user of the libavformat variables above */
+typedef enum
 {
-	int width,height;
-	char* buffer;
-	int frame_number;
-}previous_frame;
+	RECORDER_JOB_OPEN,
+	RECORDER_JOB_FRAME,
+	RECORDER_JOB_CLOSE,
+	RECORDER_JOB_EXIT
+} recorder_job_type;
+
+typedef struct
+{
+	recorder_job_type type;
+	vp_api_frame_t *frame;                  // RECORDER_JOB_FRAME, holds a reference
+	int repeat;                             // RECORDER_JOB_FRAME, times the frame is encoded
+	char *filename;                         // RECORDER_JOB_OPEN
+	int width, height, frame_rate;          // RECORDER_JOB_OPEN
+	enum PixelFormat pix_fmt;               // RECORDER_JOB_OPEN
+} recorder_job_t;
+
+static struct
+{
+	vp_os_mutex_t mutex;
+	vp_os_cond_t cond;          // Signaled on every push and pop
+	THREAD_HANDLE thread;
+	bool_t running;
+
+	recorder_job_t *jobs;
+	uint32_t size;
+	uint32_t first;
+	uint32_t count;
+} recorder;
+
+PROTO_THREAD_ROUTINE(ffmpeg_recorder, data);
+
+/* Drops the oldest queued frame, returns FALSE if the queue only holds control jobs */
+static bool_t recorder_drop_oldest_frame_locked(void)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < recorder.count; i++)
+	{
+		recorder_job_t *job = &recorder.jobs[(recorder.first + i) % recorder.size];
+
+		if (job->type == RECORDER_JOB_FRAME)
+		{
+			vp_api_frame_unref(job->frame);
+
+			// Keep the order of the jobs queued after it
+			for (j = i; j + 1 < recorder.count; j++)
+				recorder.jobs[(recorder.first + j) % recorder.size] = recorder.jobs[(recorder.first + j + 1) % recorder.size];
+			recorder.count--;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static void recorder_push(video_stage_ffmpeg_recorder_config_t *cfg, const recorder_job_t *job)
+{
+	vp_os_mutex_lock(&recorder.mutex);
+
+	while (recorder.count == recorder.size)
+	{
+		// Control jobs are never dropped
+		if (job->type == RECORDER_JOB_FRAME &&
+		    cfg->queue_policy == VIDEO_FFMPEG_RECORDER_DROP_OLDEST &&
+		    recorder_drop_oldest_frame_locked() == TRUE)
+		{
+			cfg->dropped_frames++;
+		}
+		else
+		{
+			vp_os_cond_wait(&recorder.cond);
+		}
+	}
+
+	recorder.jobs[(recorder.first + recorder.count) % recorder.size] = *job;
+	recorder.count++;
+	if (job->type == RECORDER_JOB_FRAME)
+		cfg->queued_frames++;
+
+	vp_os_cond_broadcast(&recorder.cond);
+	vp_os_mutex_unlock(&recorder.mutex);
+}
+
+static void recorder_pop(recorder_job_t *job)
+{
+	vp_os_mutex_lock(&recorder.mutex);
+
+	while (recorder.count == 0)
+		vp_os_cond_wait(&recorder.cond);
+
+	*job = recorder.jobs[recorder.first];
+	recorder.first = (recorder.first + 1) % recorder.size;
+	recorder.count--;
+
+	vp_os_cond_broadcast(&recorder.cond);
+	vp_os_mutex_unlock(&recorder.mutex);
+}
+
+DEFINE_THREAD_ROUTINE(ffmpeg_recorder, data)
+{
+	video_stage_ffmpeg_recorder_config_t *cfg = (video_stage_ffmpeg_recorder_config_t *) data;
+	bool_t file_open = FALSE;
+	recorder_job_t job;
+	int n;
+
+	do
+	{
+		recorder_pop(&job);
+
+		switch (job.type)
+		{
+			case RECORDER_JOB_OPEN:
+				if (file_open)
+					close_video_file();
+				create_video_file(job.filename, job.width, job.height, job.frame_rate, job.pix_fmt);
+				vp_os_free(job.filename);
+				file_open = TRUE;
+				break;
+
+			case RECORDER_JOB_FRAME:
+				if (file_open && picture_to_encode != NULL)
+				{
+					AVFrame *src = (tmp_picture != NULL) ? tmp_picture : picture_to_encode;
+					vp_api_picture_t *picture = &job.frame->picture;
+
+					src->data[0] = src->base[0] = picture->y_buf;
+					src->data[1] = src->base[1] = picture->cb_buf;
+					src->data[2] = src->base[2] = picture->cr_buf;
+
+					src->linesize[0] = picture->y_line_size;
+					src->linesize[1] = picture->cb_line_size;
+					src->linesize[2] = picture->cr_line_size;
+
+					for (n = 0 ; n < job.repeat ; n++)
+					{
+						write_video_frame(oc, video_st);
+					}
+					cfg->encoded_frames += job.repeat;
+				}
+				vp_api_frame_unref(job.frame);
+				break;
+
+			case RECORDER_JOB_CLOSE:
+			case RECORDER_JOB_EXIT:
+				if (file_open)
+				{
+					close_video_file();
+					file_open = FALSE;
+				}
+				break;
+		}
+	}
+	while (job.type != RECORDER_JOB_EXIT);
+
+	return (THREAD_RET)0;
+}
 
 
 /******************************************************************************************************************************************/
@@ -288,19 +445,20 @@ AVStream *add_video_stream(AVFormatContext *oc, enum CodecID codec_id, int width
         video_outbuf = av_malloc(video_outbuf_size);
     }
 
-    /* allocate the encoded raw picture */
-    picture_to_encode =  avcodec_alloc_frame();
-
-    /* if the output format is not YUV420P, then a temporary YUV420P
-       picture is needed too. It is then converted to the required
-       output format */
+    /* if the output format is not YUV420P, the queued YUV420P frames
+       are pointed by a temporary picture and converted to the encoded
+       picture, which then holds its own buffer. Otherwise the queued
+       frames are encoded in place */
     tmp_picture = NULL;
     if (c->pix_fmt != PIX_FMT_YUV420P) {
-        tmp_picture = alloc_picture(PIX_FMT_YUV420P, c->width, c->height);
-        if (!tmp_picture) {
+        picture_to_encode = alloc_picture(c->pix_fmt, c->width, c->height);
+        tmp_picture = avcodec_alloc_frame();
+        if (!picture_to_encode || !tmp_picture) {
             fprintf(stderr, "Could not allocate temporary picture\n");
             exit(1);
         }
+    } else {
+        picture_to_encode = avcodec_alloc_frame();
     }
 }
 
@@ -309,9 +467,6 @@ AVStream *add_video_stream(AVFormatContext *oc, enum CodecID codec_id, int width
 {
     int out_size, ret;
     AVCodecContext *c;
-    static struct SwsContext *img_convert_ctx;
-
-    //printf("Here0 \n");
 
     c = st->codec;
 
@@ -407,14 +562,21 @@ AVStream *add_video_stream(AVFormatContext *oc, enum CodecID codec_id, int width
  void close_video(AVFormatContext *oc, AVStream *st)
 {
     avcodec_close(st->codec);
-    av_free(picture_to_encode);
-    picture_to_encode = NULL;
     if (tmp_picture) {
-        av_free(tmp_picture->data[0]);
+        av_free(picture_to_encode->data[0]);
         av_free(tmp_picture);
         tmp_picture=NULL;
     }
+    av_free(picture_to_encode);
+    picture_to_encode = NULL;
     av_free(video_outbuf);
+    video_outbuf = NULL;
+
+    /* next file may have another size */
+    if (img_convert_ctx) {
+        sws_freeContext(img_convert_ctx);
+        img_convert_ctx = NULL;
+    }
 }
 
 
@@ -442,16 +604,30 @@ video_stage_ffmpeg_recorder_handle (video_stage_ffmpeg_recorder_config_t * cfg,
 /******************************************************************************************************************************************/
 C_RESULT video_stage_ffmpeg_recorder_open(video_stage_ffmpeg_recorder_config_t *cfg)
 {
-	//return C_OK;
-
-	previous_frame.width = previous_frame.frame_number = previous_frame.height = 0;
-	previous_frame.buffer = NULL;
 	cfg->flag_video_file_open = 0;
 	cfg->startRec=VIDEO_RECORD_STOP;
+	cfg->previous_frame = NULL;
+	cfg->previous_frame_number = 0;
+	cfg->queued_frames = cfg->encoded_frames = cfg->dropped_frames = 0;
+
+	if (cfg->queue_size == 0)
+		cfg->queue_size = VIDEO_FFMPEG_RECORDER_DEFAULT_QUEUE_SIZE;
+	sws_flags = (cfg->sws_flags != 0) ? cfg->sws_flags : SWS_FAST_BILINEAR;
 
 	/* initialize libavcodec, and register all codecs and formats */
 	av_register_all();
 
+	vp_os_memset(&recorder, 0, sizeof(recorder));
+	recorder.size = cfg->queue_size;
+	recorder.jobs = (recorder_job_t *) vp_os_calloc(recorder.size, sizeof(recorder_job_t));
+	if (recorder.jobs == NULL)
+		return C_FAIL;
+
+	vp_os_mutex_init(&recorder.mutex);
+	vp_os_cond_init(&recorder.cond, &recorder.mutex);
+	vp_os_thread_create(thread_ffmpeg_recorder, (THREAD_PARAMS)cfg, &recorder.thread);
+	recorder.running = TRUE;
+
 	return C_OK;
 }
 
@@ -462,8 +638,7 @@ C_RESULT video_stage_ffmpeg_recorder_transform(video_stage_ffmpeg_recorder_confi
 	time_t temptime;
 	struct timeval tv;
 	struct tm *atm;
-	int i;
-	int frame_size;
+	recorder_job_t job;
 	vp_os_mutex_lock( &out->lock );
 	vp_api_picture_t* picture = (vp_api_picture_t *) in->buffers;
 
@@ -486,7 +661,7 @@ C_RESULT video_stage_ffmpeg_recorder_transform(video_stage_ffmpeg_recorder_confi
 	out->size     = in->size;
 	out->buffers  = in->buffers;
 
-	if( out->status == VP_API_STATUS_PROCESSING)
+	if( out->status == VP_API_STATUS_PROCESSING && recorder.running )
 	{
 		if(cfg->startRec==VIDEO_RECORD_HOLD)
 		{
@@ -499,22 +674,31 @@ C_RESULT video_stage_ffmpeg_recorder_transform(video_stage_ffmpeg_recorder_confi
 					picture->width,
 					picture->height);
 
-			create_video_file(cfg->video_filename, picture->width, picture->height, picture->framerate, picture->format);
-			cfg->flag_video_file_open = 1;
+			vp_os_memset(&job, 0, sizeof(job));
+			job.type = RECORDER_JOB_OPEN;
+			job.filename = (char *) vp_os_malloc(strlen(cfg->video_filename) + 1);
+			if (job.filename != NULL)
+			{
+				strcpy(job.filename, cfg->video_filename);
+				job.width = picture->width;
+				job.height = picture->height;
+				job.frame_rate = picture->framerate;
+				job.pix_fmt = picture->format;
+				recorder_push(cfg, &job);
+				cfg->flag_video_file_open = 1;
+			}
 			strcpy(cfg->video_filename, "");
 
 			if(cfg->numframes != NULL)
-				previous_frame.frame_number = *cfg->numframes;
+				cfg->previous_frame_number = *cfg->numframes;
 
 			cfg->startRec=VIDEO_RECORD_START;
 		}
 
 		if( out->size > 0 && cfg->startRec == VIDEO_RECORD_START)
 		{
-			frame_size = ( previous_frame.width * previous_frame.height ) * 3 / 2;
-
-			/* Send the previous frame to FFMPEG */
-			if (previous_frame.buffer != NULL)
+			/* Send the previous frame to the recorder thread */
+			if (cfg->previous_frame != NULL)
 			{
 				/* Compute the number of frames to store to achieve 60 FPS
 				* This should be computed using the timestamp of the first frame
@@ -524,64 +708,47 @@ C_RESULT video_stage_ffmpeg_recorder_transform(video_stage_ffmpeg_recorder_confi
 
 				if(cfg->numframes != NULL)
 				{
-					nb_frames_to_write = *cfg->numframes - previous_frame.frame_number;
-					previous_frame.frame_number = *cfg->numframes;
-				}
-
-				if (picture_to_encode!=NULL)
-				{
-					picture_to_encode->data[0] = picture_to_encode->base[0] = picture->y_buf;
-					picture_to_encode->data[1] = picture_to_encode->base[1] = picture->cb_buf;
-					picture_to_encode->data[2] = picture_to_encode->base[2] = picture->cr_buf;
-
-					picture_to_encode->linesize[0] = picture->width;
-					picture_to_encode->linesize[1] = picture->width/2;
-					picture_to_encode->linesize[2] = picture->width/2;
+					nb_frames_to_write = *cfg->numframes - cfg->previous_frame_number;
+					cfg->previous_frame_number = *cfg->numframes;
 				}
 
-				printf("Storing %i frames\n",nb_frames_to_write);
-				for (i = 0 ; i < nb_frames_to_write ; i++)
+				if (nb_frames_to_write > 0)
 				{
-					write_video_frame(oc, video_st);
+					vp_os_memset(&job, 0, sizeof(job));
+					job.type = RECORDER_JOB_FRAME;
+					job.frame = cfg->previous_frame;
+					job.repeat = nb_frames_to_write;
+					vp_api_frame_ref(job.frame);
+					recorder_push(cfg, &job);
 				}
-			}
-
-			/* Create a buffer to hold the current frame */
-			if (previous_frame.buffer!=NULL && (previous_frame.width!=picture->width || previous_frame.height!=picture->height))
-			{
-				vp_os_free(previous_frame.buffer);
-				previous_frame.buffer=NULL;
-			}
 
-			if (previous_frame.buffer==NULL)
-			{
-				previous_frame.width = picture->width;
-				previous_frame.height = picture->height;
-				frame_size = ( previous_frame.width * previous_frame.height )*3/2;
-				printf("Allocating previous frame.\n");
-				previous_frame.buffer=vp_os_malloc( frame_size );
+				vp_api_frame_unref(cfg->previous_frame);
+				cfg->previous_frame = NULL;
 			}
 
-			/* Copy the current frame in a buffer so it can be encoded at next stage call */
-			if (previous_frame.buffer!=NULL)
+			/* Copy the current frame so it can be encoded at next stage call */
+			cfg->previous_frame = vp_api_frame_acquire(picture->width, picture->height, PIX_FMT_YUV420P, "video_stage_ffmpeg_recorder");
+			if (cfg->previous_frame != NULL)
 			{
-				char * dest = previous_frame.buffer;
+				vp_api_picture_t *copy = &cfg->previous_frame->picture;
 				int size = picture->width*picture->height;
-				vp_os_memcpy(dest,picture->y_buf,size);
+				vp_os_memcpy(copy->y_buf,picture->y_buf,size);
 
-				dest+=size;
 				size /= 4;
-				vp_os_memcpy(dest,picture->cb_buf,size);
-
-				dest+=size;
-				vp_os_memcpy(dest,picture->cr_buf,size);
+				vp_os_memcpy(copy->cb_buf,picture->cb_buf,size);
+				vp_os_memcpy(copy->cr_buf,picture->cr_buf,size);
 			}
 		}
 		else
 		{
 			if(cfg->flag_video_file_open && cfg->startRec == VIDEO_RECORD_STOP)
 			{
-				close_video_file();
+				vp_api_frame_unref(cfg->previous_frame);
+				cfg->previous_frame = NULL;
+
+				vp_os_memset(&job, 0, sizeof(job));
+				job.type = RECORDER_JOB_CLOSE;
+				recorder_push(cfg, &job);
 				cfg->flag_video_file_open=0;
 			}
 		}
@@ -597,11 +764,26 @@ C_RESULT video_stage_ffmpeg_recorder_transform(video_stage_ffmpeg_recorder_confi
 
 C_RESULT video_stage_ffmpeg_recorder_close(video_stage_ffmpeg_recorder_config_t *cfg)
 {
-	if(cfg->flag_video_file_open)
-	{
-		close_video_file();
-		cfg->flag_video_file_open=0;
-	}
+	recorder_job_t job;
+
+	if (!recorder.running)
+		return C_OK;
+
+	vp_api_frame_unref(cfg->previous_frame);
+	cfg->previous_frame = NULL;
+
+	/* Queued frames are still written, the thread closes the file */
+	vp_os_memset(&job, 0, sizeof(job));
+	job.type = RECORDER_JOB_EXIT;
+	recorder_push(cfg, &job);
+	vp_os_thread_join(recorder.thread);
+	recorder.running = FALSE;
+	cfg->flag_video_file_open=0;
+
+	vp_os_free(recorder.jobs);
+	recorder.jobs = NULL;
+	vp_os_cond_destroy(&recorder.cond);
+	vp_os_mutex_destroy(&recorder.mutex);
 
 	return C_OK;
 }
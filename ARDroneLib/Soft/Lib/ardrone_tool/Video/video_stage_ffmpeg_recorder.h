@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <VP_Api/vp_api.h>
+#include <VP_Api/vp_api_frame_pool.h>
 
 #include <ardrone_tool/Video/video_stage_recorder.h>
 
@@ -25,16 +26,39 @@
 #define _VIDEO_RECORD_STATE_ENUM_
 #endif
 
+/*
+ * Conversion, encoding and file writes run in a recorder thread. The stage
+ * only copies each decoded frame and queues it, so a slow encode or disk
+ * no longer stalls decoding and display.
+ */
+#define VIDEO_FFMPEG_RECORDER_DEFAULT_QUEUE_SIZE  8
+
+typedef enum _video_ffmpeg_recorder_queue_policy_
+{
+	VIDEO_FFMPEG_RECORDER_DROP_OLDEST = 0,  // Queue full : the oldest queued frame is dropped, the pipeline never waits
+	VIDEO_FFMPEG_RECORDER_BLOCK             // Queue full : the pipeline waits for the recorder thread
+} video_ffmpeg_recorder_queue_policy;
+
 typedef struct _video_stage_ffmpeg_recorder_config_t
 {
 	// Public
 	char video_filename[1024];
 	uint32_t *numframes;
 	int stage;
+	uint32_t queue_size;                               // Frames waiting for the recorder thread, 0 for the default
+	video_ffmpeg_recorder_queue_policy queue_policy;
+	int sws_flags;                                     // Scaler flags, 0 for SWS_FAST_BILINEAR
+
+	// Statistics, read only
+	uint32_t queued_frames;
+	uint32_t encoded_frames;
+	uint32_t dropped_frames;
 
 	// Private
 	video_record_state startRec;
 	int flag_video_file_open;
+	vp_api_frame_t *previous_frame;    // YUV420P copy of the last picture, from the frame pool
+	uint32_t previous_frame_number;
 } video_stage_ffmpeg_recorder_config_t;
 
 C_RESULT video_stage_ffmpeg_recorder_handle (video_stage_ffmpeg_recorder_config_t * cfg, PIPELINE_MSG msg_id, void *callback, void *param);
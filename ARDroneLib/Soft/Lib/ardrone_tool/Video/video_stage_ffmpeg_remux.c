@@ -0,0 +1,383 @@
+/*
+ * video_stage_ffmpeg_remux.c
+ *
+ * Stream copy recorder, see video_stage_ffmpeg_remux.h
+ */
+#if defined (FFMPEG_SUPPORT) && defined (RECORD_FFMPEG_VIDEO)
+#include <generated_custom.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+
+#include <config.h>
+#include <ardrone_tool/Video/video_stage_ffmpeg_remux.h>
+
+#define VIDEO_FILE_DEFAULT_PATH root_dir
+extern char root_dir[];
+
+const vp_api_stage_funcs_t video_ffmpeg_remux_funcs = {
+  (vp_api_stage_handle_msg_t) video_stage_ffmpeg_remux_handle,
+  (vp_api_stage_open_t) video_stage_ffmpeg_remux_open,
+  (vp_api_stage_transform_t) video_stage_ffmpeg_remux_transform,
+  (vp_api_stage_close_t) video_stage_ffmpeg_remux_close
+};
+
+static void video_stage_ffmpeg_remux_finish( video_stage_ffmpeg_remux_config_t *cfg, bool_t write_trailer )
+{
+  if( cfg->oc == NULL )
+    return;
+
+  if( write_trailer )
+    av_write_trailer( cfg->oc );
+
+  if( !(cfg->oc->oformat->flags & AVFMT_NOFILE) && cfg->oc->pb != NULL )
+    avio_close( cfg->oc->pb );
+
+  // Streams with their codec context, extradata and metadata
+  avformat_free_context( cfg->oc );
+
+  cfg->oc = NULL;
+  cfg->st = NULL;
+
+  PRINT("Remux recording done : %u frames, %llu bytes\n", cfg->written_frames, (unsigned long long) cfg->written_bytes);
+}
+
+/* Opens the file on an IDR frame, data is its payload */
+static C_RESULT video_stage_ffmpeg_remux_start( video_stage_ffmpeg_remux_config_t *cfg, const parrot_video_encapsulation_t *PaVE, const uint8_t *data )
+{
+  // IDR frames start with 00 00 00 01 SPS 00 00 00 01 PPS, which is the extradata libavformat expects
+  uint32_t headers_size = PaVE->header1_size + PaVE->header2_size;
+  AVOutputFormat *fmt;
+  AVCodecContext *c;
+  AVDictionary *options = NULL;
+  struct tm *atm;
+  int res;
+  time_t now;
+
+  if( PaVE->header1_size == 0 || headers_size > PaVE->payload_size )
+  {
+    PRINT("IDR frame without SPS/PPS, remux recording not started\n");
+    return C_FAIL;
+  }
+
+  if( strlen( cfg->video_filename ) == 0 )
+  {
+    now = time( NULL );
+    atm = localtime( &now );
+    snprintf( cfg->video_filename, VIDEO_FFMPEG_REMUX_FILENAME_LENGTH, "%s/video_%04d%02d%02d_%02d%02d%02d_w%i_h%i.%s",
+              VIDEO_FILE_DEFAULT_PATH,
+              atm->tm_year+1900, atm->tm_mon+1, atm->tm_mday,
+              atm->tm_hour, atm->tm_min, atm->tm_sec,
+              PaVE->display_width, PaVE->display_height,
+              (cfg->container != NULL && strcmp( cfg->container, "matroska" ) == 0) ? "mkv" : "mp4" );
+  }
+
+  fmt = av_guess_format( cfg->container, cfg->video_filename, NULL );
+  if( fmt == NULL )
+    fmt = av_guess_format( "mp4", NULL, NULL );
+
+  cfg->oc = (fmt != NULL) ? avformat_alloc_context() : NULL;
+  if( cfg->oc == NULL )
+  {
+    PRINT("Unable to allocate remux output for %s\n", cfg->video_filename);
+    return C_FAIL;
+  }
+  cfg->oc->oformat = fmt;
+  snprintf( cfg->oc->filename, sizeof(cfg->oc->filename), "%s", cfg->video_filename );
+
+  cfg->st = av_new_stream( cfg->oc, 0 );
+  if( cfg->st == NULL )
+  {
+    video_stage_ffmpeg_remux_finish( cfg, FALSE );
+    return C_FAIL;
+  }
+
+  c = cfg->st->codec;
+  c->codec_id        = CODEC_ID_H264;
+  c->codec_type      = AVMEDIA_TYPE_VIDEO;
+  c->width           = PaVE->display_width;
+  c->height          = PaVE->display_height;
+  c->pix_fmt         = PIX_FMT_YUV420P;
+  c->time_base.num   = 1;
+  c->time_base.den   = 1000;    // PaVE timestamps are in ms
+  if( fmt->flags & AVFMT_GLOBALHEADER )
+    c->flags |= CODEC_FLAG_GLOBAL_HEADER;
+
+  c->extradata = av_mallocz( headers_size + FF_INPUT_BUFFER_PADDING_SIZE );
+  if( c->extradata == NULL )
+  {
+    video_stage_ffmpeg_remux_finish( cfg, FALSE );
+    return C_FAIL;
+  }
+  vp_os_memcpy( c->extradata, data, headers_size );
+  c->extradata_size = headers_size;
+
+  if( !(fmt->flags & AVFMT_NOFILE) && avio_open( &cfg->oc->pb, cfg->video_filename, URL_WRONLY ) < 0 )
+  {
+    PRINT("Unable to open %s\n", cfg->video_filename);
+    video_stage_ffmpeg_remux_finish( cfg, FALSE );
+    return C_FAIL;
+  }
+
+  // Stream parameters are all in the codec context, no muxer option is needed
+  res = avformat_write_header( cfg->oc, &options );
+  av_dict_free( &options );
+  if( res < 0 )
+  {
+    PRINT("Unable to write %s header\n", cfg->video_filename);
+    video_stage_ffmpeg_remux_finish( cfg, FALSE );
+    return C_FAIL;
+  }
+
+  PRINT("Remux recording to %s\n", cfg->video_filename);
+  av_dump_format( cfg->oc, 0, cfg->video_filename, 1 );
+  vp_os_memset( cfg->video_filename, 0, VIDEO_FFMPEG_REMUX_FILENAME_LENGTH );
+
+  cfg->width          = PaVE->display_width;
+  cfg->height         = PaVE->display_height;
+  cfg->last_timestamp = PaVE->timestamp;
+  cfg->pts            = 0;
+  cfg->written_frames = 0;
+  cfg->skipped_frames = 0;
+  cfg->written_bytes  = 0;
+
+  return C_OK;
+}
+
+static void video_stage_ffmpeg_remux_write( video_stage_ffmpeg_remux_config_t *cfg, const parrot_video_encapsulation_t *PaVE, uint8_t *data, uint32_t size )
+{
+  bool_t idr = (PaVE->frame_type == FRAME_TYPE_IDR_FRAME) ? TRUE : FALSE;
+  AVRational ms = { 1, 1000 };
+  int32_t delta;
+  AVPacket pkt;
+
+  if( PaVE->video_codec != CODEC_MPEG4_AVC || size == 0 )
+  {
+    cfg->skipped_frames++;
+    return;
+  }
+
+  // A new resolution needs a new file
+  if( cfg->oc != NULL && idr && (PaVE->display_width != cfg->width || PaVE->display_height != cfg->height) )
+    video_stage_ffmpeg_remux_finish( cfg, TRUE );
+
+  if( cfg->oc == NULL )
+  {
+    if( !idr || C_OK != video_stage_ffmpeg_remux_start( cfg, PaVE, data ) )
+    {
+      cfg->skipped_frames++;
+      return;
+    }
+    cfg->waiting_idr = FALSE;
+  }
+
+  if( cfg->waiting_idr )
+  {
+    if( !idr )
+    {
+      cfg->skipped_frames++;
+      return;
+    }
+    cfg->waiting_idr = FALSE;
+  }
+
+  // SPS/PPS are already in the extradata
+  if( idr && (uint32_t)(PaVE->header1_size + PaVE->header2_size) < size )
+  {
+    data += PaVE->header1_size + PaVE->header2_size;
+    size -= PaVE->header1_size + PaVE->header2_size;
+  }
+
+  // Drone clock wraps around 2^32 ms, timestamps must keep increasing
+  if( cfg->written_frames > 0 )
+  {
+    delta = (int32_t)(PaVE->timestamp - cfg->last_timestamp);
+    cfg->pts += (delta > 0) ? delta : 1;
+  }
+  cfg->last_timestamp = PaVE->timestamp;
+
+  av_init_packet( &pkt );
+  pkt.stream_index = cfg->st->index;
+  pkt.data         = data;
+  pkt.size         = size;
+  pkt.pts          = av_rescale_q( cfg->pts, ms, cfg->st->time_base );
+  pkt.dts          = pkt.pts;     // No B frames
+  if( idr || PaVE->frame_type == FRAME_TYPE_I_FRAME )
+    pkt.flags |= AV_PKT_FLAG_KEY;
+
+  if( av_interleaved_write_frame( cfg->oc, &pkt ) != 0 )
+  {
+    PRINT("Error while writing remuxed frame, recording stopped\n");
+    video_stage_ffmpeg_remux_finish( cfg, FALSE );
+    cfg->startRec = VIDEO_RECORD_STOP;
+    return;
+  }
+
+  cfg->written_frames++;
+  cfg->written_bytes += size;
+}
+
+/* Gathers slices, returns TRUE when frame holds a complete frame */
+static bool_t video_stage_ffmpeg_remux_gather( video_stage_ffmpeg_remux_config_t *cfg, const parrot_video_encapsulation_t *PaVE, const uint8_t *data, uint32_t size )
+{
+  if( PaVE->slice_index == 0 )
+  {
+    if( cfg->next_slice != 0 )
+    {
+      cfg->skipped_frames++;
+      cfg->waiting_idr = TRUE;
+    }
+    cfg->frame_PaVE = *PaVE;
+    cfg->frame_size = 0;
+    cfg->next_slice = 0;
+  }
+  else if( PaVE->frame_number != cfg->frame_PaVE.frame_number || PaVE->slice_index != cfg->next_slice )
+  {
+    // Lost slice : the frame and the ones referencing it are dropped
+    if( cfg->next_slice != 0 )
+    {
+      cfg->skipped_frames++;
+      cfg->waiting_idr = TRUE;
+    }
+    cfg->next_slice = 0;
+    return FALSE;
+  }
+
+  if( cfg->frame_size + size > cfg->frame_capacity )
+  {
+    uint8_t *frame = (uint8_t *) vp_os_realloc( cfg->frame, cfg->frame_size + size );
+    if( frame == NULL )
+    {
+      cfg->next_slice = 0;
+      return FALSE;
+    }
+    cfg->frame = frame;
+    cfg->frame_capacity = cfg->frame_size + size;
+  }
+
+  vp_os_memcpy( cfg->frame + cfg->frame_size, data, size );
+  cfg->frame_size += size;
+  cfg->next_slice = PaVE->slice_index + 1;
+
+  if( PaVE->slice_index + 1 < PaVE->total_slices )
+    return FALSE;
+
+  cfg->frame_PaVE.payload_size = cfg->frame_size;
+  cfg->next_slice = 0;
+  return TRUE;
+}
+
+C_RESULT video_stage_ffmpeg_remux_handle( video_stage_ffmpeg_remux_config_t *cfg, PIPELINE_MSG msg_id, void *callback, void *param )
+{
+  switch( msg_id )
+  {
+    case PIPELINE_MSG_START:
+      if( cfg->startRec == VIDEO_RECORD_STOP )
+        cfg->startRec = VIDEO_RECORD_HOLD;
+      else
+        cfg->startRec = VIDEO_RECORD_STOP;
+      break;
+
+    default:
+      break;
+  }
+
+  return (VP_SUCCESS);
+}
+
+C_RESULT video_stage_ffmpeg_remux_open( video_stage_ffmpeg_remux_config_t *cfg )
+{
+  cfg->startRec       = VIDEO_RECORD_STOP;
+  cfg->oc             = NULL;
+  cfg->st             = NULL;
+  cfg->waiting_idr    = TRUE;
+  cfg->frame          = NULL;
+  cfg->frame_size     = 0;
+  cfg->frame_capacity = 0;
+  cfg->next_slice     = 0;
+  cfg->written_frames = 0;
+  cfg->skipped_frames = 0;
+  cfg->written_bytes  = 0;
+
+  av_register_all();
+
+  return C_OK;
+}
+
+C_RESULT video_stage_ffmpeg_remux_transform( video_stage_ffmpeg_remux_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out )
+{
+  parrot_video_encapsulation_t *PaVE;
+  uint8_t *data;
+  uint32_t size;
+
+  vp_os_mutex_lock( &out->lock );
+
+  // Data goes through untouched
+  out->numBuffers  = in->numBuffers;
+  out->indexBuffer = in->indexBuffer;
+  out->lineSize    = in->lineSize;
+  out->size        = in->size;
+  out->status      = in->status;
+  out->buffers     = in->buffers;
+
+  if( cfg->startRec == VIDEO_RECORD_HOLD )
+  {
+    // Recording starts on the next IDR frame
+    cfg->waiting_idr = TRUE;
+    cfg->startRec = VIDEO_RECORD_START;
+  }
+  else if( cfg->startRec == VIDEO_RECORD_STOP && cfg->oc != NULL )
+  {
+    video_stage_ffmpeg_remux_finish( cfg, TRUE );
+  }
+
+  if( cfg->startRec == VIDEO_RECORD_START && in->size > 0 && in->buffers != NULL &&
+      in->status != VP_API_STATUS_ERROR && PAVE_CHECK( in->buffers[in->indexBuffer] ) )
+  {
+    PaVE = (parrot_video_encapsulation_t *) in->buffers[in->indexBuffer];
+    data = in->buffers[in->indexBuffer] + PaVE->header_size;
+    size = PaVE->payload_size;
+    if( PaVE->header_size + size > in->size )
+      size = (in->size > PaVE->header_size) ? in->size - PaVE->header_size : 0;    // Corrupted PaVE
+
+    if( PaVE->total_slices <= 1 )
+    {
+      if( cfg->next_slice != 0 )
+      {
+        // Last slices of the gathered frame were lost
+        cfg->skipped_frames++;
+        cfg->waiting_idr = TRUE;
+        cfg->next_slice = 0;
+      }
+      video_stage_ffmpeg_remux_write( cfg, PaVE, data, size );
+    }
+    else if( video_stage_ffmpeg_remux_gather( cfg, PaVE, data, size ) )
+    {
+      video_stage_ffmpeg_remux_write( cfg, &cfg->frame_PaVE, cfg->frame, cfg->frame_size );
+    }
+  }
+
+  vp_os_mutex_unlock( &out->lock );
+
+  return C_OK;
+}
+
+C_RESULT video_stage_ffmpeg_remux_close( video_stage_ffmpeg_remux_config_t *cfg )
+{
+  video_stage_ffmpeg_remux_finish( cfg, TRUE );
+
+  if( cfg->frame != NULL )
+  {
+    vp_os_free( cfg->frame );
+    cfg->frame = NULL;
+  }
+  cfg->frame_capacity = 0;
+
+  return C_OK;
+}
+
+#endif
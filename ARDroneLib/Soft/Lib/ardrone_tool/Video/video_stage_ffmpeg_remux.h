@@ -0,0 +1,67 @@
+#ifdef FFMPEG_SUPPORT
+
+#ifndef _VIDEO_STAGE_FFMPEG_REMUX_H_
+#define _VIDEO_STAGE_FFMPEG_REMUX_H_
+
+/*
+ * Stream copy recorder : H.264 frames received from the drone are written
+ * as they are to a MP4 or Matroska file through libavformat, without being
+ * decoded and encoded again like in video_stage_ffmpeg_recorder.
+ *
+ * The stage takes PaVE encapsulated data, either merged frames (after
+ * video_stage_merge_slices) or single slices, which are gathered back into
+ * frames. SPS and PPS are taken from the first IDR frame thanks to the PaVE
+ * header sizes, and the packet timestamps are the PaVE timestamps. Other
+ * codecs are not recorded.
+ *
+ * PIPELINE_MSG_START toggles recording, like the ffmpeg recorder.
+ */
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+
+#include <VP_Api/vp_api.h>
+#include <video_encapsulation.h>
+
+#include <ardrone_tool/Video/video_stage_recorder.h>
+
+#define VIDEO_FFMPEG_REMUX_FILENAME_LENGTH  1024
+
+typedef struct _video_stage_ffmpeg_remux_config_t
+{
+  // Public
+  char video_filename[VIDEO_FFMPEG_REMUX_FILENAME_LENGTH];  // Empty : a dated name is made in root_dir
+  const char *container;        // libavformat short name, "mp4" or "matroska". NULL : from the filename, mp4 by default
+
+  // Statistics, read only
+  uint32_t written_frames;
+  uint32_t skipped_frames;      // Incomplete frames, and frames waiting for an IDR frame
+  uint64_t written_bytes;
+
+  // Private
+  video_record_state startRec;
+  AVFormatContext *oc;
+  AVStream *st;
+  uint16_t width;
+  uint16_t height;
+  uint32_t last_timestamp;      // PaVE time of the last written frame (ms)
+  int64_t  pts;                 // Time of the last written frame from the start of the file (ms)
+  bool_t   waiting_idr;
+
+  uint8_t *frame;               // Slices of the frame being gathered
+  uint32_t frame_size;
+  uint32_t frame_capacity;
+  parrot_video_encapsulation_t frame_PaVE;  // PaVE of the first slice
+  uint8_t  next_slice;
+} video_stage_ffmpeg_remux_config_t;
+
+C_RESULT video_stage_ffmpeg_remux_handle (video_stage_ffmpeg_remux_config_t *cfg, PIPELINE_MSG msg_id, void *callback, void *param);
+C_RESULT video_stage_ffmpeg_remux_open(video_stage_ffmpeg_remux_config_t *cfg);
+C_RESULT video_stage_ffmpeg_remux_transform(video_stage_ffmpeg_remux_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out);
+C_RESULT video_stage_ffmpeg_remux_close(video_stage_ffmpeg_remux_config_t *cfg);
+
+extern const vp_api_stage_funcs_t video_ffmpeg_remux_funcs;
+
+#endif // _VIDEO_STAGE_FFMPEG_REMUX_H_
+
+#endif // FFMPEG_SUPPORT
@@ -74,6 +74,8 @@ C_RESULT video_stage_merge_slices_open(video_stage_merge_slices_config_t *cfg)
   
   cfg->mergingBuffer = 0;
   cfg->readyBuffer   = 0;
+  cfg->lastFrameNumber = 0;
+  cfg->lastSliceIndex  = 0;
   
   return C_OK;
 }
@@ -97,6 +99,21 @@ C_RESULT video_stage_merge_slices_reset(video_stage_merge_slices_config_t *cfg)
 }
 
 
+/* Feed the next stage with the previous stage's output */
+static void video_stage_merge_slices_forward(video_stage_merge_slices_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out)
+{
+  out->buffers     = in->buffers;
+  out->indexBuffer = in->indexBuffer;
+  out->lineSize    = in->lineSize;
+  out->numBuffers  = in->numBuffers;
+  out->size        = in->size;
+  out->status      = VP_API_STATUS_PROCESSING;
+
+  /* Get rid of previously accumulated data */
+  video_stage_merge_slices_reset(cfg);
+}
+
+
 C_RESULT video_stage_merge_slices_transform(video_stage_merge_slices_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out)
 {
   bool_t switchBuffers;
@@ -131,18 +148,7 @@ C_RESULT video_stage_merge_slices_transform(video_stage_merge_slices_config_t *c
   if ( (PaVE==NULL) || (!PAVE_CHECK(PaVE)) || (PaVE->total_slices == 1) )
     {
       // No slices, just send the data to the next stage
-
-      /* Feed the next stage with the previous stage's output */
-      out->buffers     = in->buffers;
-      out->indexBuffer = in->indexBuffer;
-      out->lineSize    = in->lineSize;
-      out->numBuffers  = in->numBuffers;
-      out->status      = in->status;
-      out->size        = in->size;
-      out->status      = VP_API_STATUS_PROCESSING;
-    
-      /* Get rid of previously accumulated data */
-      video_stage_merge_slices_reset(cfg);
+      video_stage_merge_slices_forward(cfg, in, out);
 
       /* IPHONE DEBUG : set slices miss to 0/1 (to avoid keeping old/fake slice datas) */
       DEBUG_totalSlices = 1;
@@ -150,6 +156,21 @@ C_RESULT video_stage_merge_slices_transform(video_stage_merge_slices_config_t *c
     
       return C_OK;
     }
+
+  if (cfg->low_latency && (PaVE->video_codec == CODEC_MPEG4_AVC))
+    {
+      /* Each slice is decoded as soon as it arrives */
+      if (PaVE->slice_index != 0 && (PaVE->frame_number != cfg->lastFrameNumber || PaVE->slice_index != cfg->lastSliceIndex+1))
+        {
+          printf("Missing slices (%d)\n", (PaVE->frame_number != cfg->lastFrameNumber) ? PaVE->slice_index : PaVE->slice_index - cfg->lastSliceIndex - 1);
+        }
+      cfg->lastFrameNumber = PaVE->frame_number;
+      cfg->lastSliceIndex  = PaVE->slice_index;
+
+      video_stage_merge_slices_forward(cfg, in, out);
+
+      return C_OK;
+    }
   
   /*
    * Check if the incoming PaVE belongs to the same frame.
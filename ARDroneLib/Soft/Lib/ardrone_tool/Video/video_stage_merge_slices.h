@@ -14,9 +14,16 @@ typedef struct {
  
 typedef struct _video_stage_merge_slices_config_t
 {
+ /* Set before opening the stage : forward H264 slices as they arrive instead of
+    merging them, the decoder outputs the picture when the last slice is decoded */
+ bool_t low_latency;
+
  int mergingBuffer;
  int readyBuffer;
  video_stage_merge_slices_buffer_t bufs[2];
+
+ uint32_t lastFrameNumber; // last forwarded slice, in low latency mode
+ uint32_t lastSliceIndex;
 }
 video_stage_merge_slices_config_t;
 
@@ -149,6 +149,7 @@ C_RESULT video_stage_tcp_open(video_stage_tcp_config_t *cfg)
       return C_FAIL;
     }
   cfg->currentSize = 0;
+  cfg->droppedFrames = 0;
   return C_OK;
 }
 
@@ -283,9 +284,9 @@ C_RESULT video_stage_tcp_transform(video_stage_tcp_config_t *cfg, vp_api_io_data
           // Iterate through all frames to find last available I Frame
           int fIndex = 0;
           
-#if __VIDEO_TCP_DEBUG_ENABLED
           int fDropped = 0;
           int fTested = 0;
+#if __VIDEO_TCP_DEBUG_ENABLED
           static int totalDrop = 0;
 #endif
           while (fIndex < maxIndex)
@@ -314,14 +315,10 @@ C_RESULT video_stage_tcp_transform(video_stage_tcp_config_t *cfg, vp_api_io_data
                 {
                   VIDEO_TCP_DEBUG ("Jumping to I-frame\n");
                   lastIFrameStart = fIndex;
-#if __VIDEO_TCP_DEBUG_ENABLED
                   fDropped = fTested;
-#endif
                 }
               fIndex += packetSize;
-#if __VIDEO_TCP_DEBUG_ENABLED
               fTested++;
-#endif
             }
           
           if (0 < lastIFrameStart)
@@ -330,6 +327,7 @@ C_RESULT video_stage_tcp_transform(video_stage_tcp_config_t *cfg, vp_api_io_data
               totalDrop += fDropped;
               VIDEO_TCP_DEBUG ("I-frame found - dumping %3d frames --> total : %5d\n", fDropped, totalDrop);
 #endif
+              cfg->droppedFrames += fDropped;
               // Dump all frames before last I frame
               cfg->currentSize -= lastIFrameStart;
               memmove (cfg->globalBuffer, &(cfg->globalBuffer[lastIFrameStart]), cfg->currentSize);
@@ -17,6 +17,7 @@ typedef struct _video_stage_tcp_config_t
     int latencyDrop;
 
     int currentSize;
+    uint32_t droppedFrames; // Frames skipped by latencyDrop since open
     
     uint8_t **bufferPointer;
     uint8_t *globalBuffer;
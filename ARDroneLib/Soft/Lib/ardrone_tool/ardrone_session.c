@@ -0,0 +1,738 @@
+/**
+ * @file ardrone_session.c
+ * @date 2026/10/18
+ *
+ * Multi-drone sessions, see ardrone_session.h
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <config.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+
+#include <Maths/maths.h>
+#include <ardrone_tool/ardrone_session.h>
+
+#define ARDRONE_SESSION_CYCLE_MS            (30)
+#define ARDRONE_SESSION_NAVDATA_TIMEOUT_MS  (1000)
+#define ARDRONE_SESSION_CONTROL_TIMEOUT_MS  (1000)
+#define ARDRONE_SESSION_VIDEO_RETRY_MS      (1000)
+#define ARDRONE_SESSION_REF_DEFAULT         (0x11540000)
+
+// AT format strings, shared with the ATcodec declarations
+#undef ATCODEC_DEFINE_AT_CMD
+#define ATCODEC_DEFINE_AT_CMD(ID,Str,From,Cb,Prio) static const char ardrone_session_fmt_##ID[] = Str;
+#undef ATCODEC_DEFINE_AT_RESU
+#define ATCODEC_DEFINE_AT_RESU(ID,Str,From,Cb)
+#include <at_msgs.h>
+
+static uint32_t ardrone_session_time_ms( void )
+{
+  struct timeval tv;
+  gettimeofday( &tv, NULL );
+  return (uint32_t)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+}
+
+static void ardrone_session_close_socket( int *s )
+{
+  if( *s >= 0 )
+  {
+    close( *s );
+    *s = -1;
+  }
+}
+
+/**
+ * Open an UDP socket on an ephemeral port, connected to the drone port :
+ * several sessions can run in the same process without port conflict.
+ */
+static int ardrone_session_open_udp( const char *ip, int32_t port )
+{
+  struct sockaddr_in addr;
+  int s = socket( AF_INET, SOCK_DGRAM, 0 );
+
+  if( s < 0 )
+    return -1;
+
+  vp_os_memset( &addr, 0, sizeof(addr) );
+  addr.sin_family       = AF_INET;
+  addr.sin_addr.s_addr  = inet_addr( ip );
+  addr.sin_port         = htons( port );
+
+  if( connect( s, (struct sockaddr*)&addr, sizeof(addr) ) < 0 )
+  {
+    close( s );
+    return -1;
+  }
+
+  fcntl( s, F_SETFL, fcntl( s, F_GETFL, 0 ) | O_NONBLOCK );
+
+  return s;
+}
+
+/**
+ * Appends an AT command to the session buffer. at_mutex must be locked.
+ * The sequence number is always the first argument of the format.
+ */
+static void ardrone_session_at_queue( ardrone_session_t *session, const char *format, ... )
+{
+  va_list args;
+  char command[ARDRONE_SESSION_AT_BUFFER_SIZE];
+  int32_t len;
+
+  va_start( args, format );
+  len = vsnprintf( command, sizeof(command), format, args );
+  va_end( args );
+
+  if( len <= 0 || len >= (int32_t)sizeof(command) )
+    return;
+
+  if( session->at_len + len > ARDRONE_SESSION_AT_BUFFER_SIZE )
+  {
+    // The drone ignores datagrams larger than 1024 bytes : flush first
+    if( session->at_len > 0 && session->at_socket >= 0 )
+      send( session->at_socket, session->at_buffer, session->at_len, 0 );
+    session->at_len = 0;
+  }
+
+  vp_os_memcpy( &session->at_buffer[session->at_len], command, len );
+  session->at_len += len;
+}
+
+static void ardrone_session_at_flush( ardrone_session_t *session )
+{
+  if( session->at_len > 0 && session->at_socket >= 0 )
+  {
+    if( send( session->at_socket, session->at_buffer, session->at_len, 0 ) < 0 )
+      DEBUG_PRINT_SDK( "[SESSION %d] AT send failed (%s)\n", session->index, strerror( errno ) );
+  }
+  session->at_len = 0;
+}
+
+/***************************************************************************************************
+ * Navdata
+ */
+
+static void ardrone_session_navdata_request( ardrone_session_t *session )
+{
+  int32_t flag = 1;
+
+  send( session->navdata_socket, &flag, sizeof(flag), 0 );
+  session->navdata_sequence = NAVDATA_SEQUENCE_DEFAULT - 1;
+  session->navdata_time     = ardrone_session_time_ms();
+}
+
+static void ardrone_session_navdata_receive( ardrone_session_t *session )
+{
+  navdata_t* navdata = (navdata_t*) &session->navdata_buffer[0];
+  uint32_t cks, navdata_cks;
+  ssize_t size;
+
+  while( (size = recv( session->navdata_socket, session->navdata_buffer, NAVDATA_MAX_SIZE, 0 )) > 0 )
+  {
+    if( navdata->header != NAVDATA_HEADER || size < (ssize_t)sizeof(navdata_t) )
+      continue;
+
+    session->navdata_time   = ardrone_session_time_ms();
+    session->ardrone_state  = navdata->ardrone_state;
+
+    if( ardrone_get_mask_from_state( navdata->ardrone_state, ARDRONE_COM_WATCHDOG_MASK ) )
+    {
+      session->navdata_sequence = NAVDATA_SEQUENCE_DEFAULT - 1;
+
+      if( ardrone_get_mask_from_state( navdata->ardrone_state, ARDRONE_NAVDATA_BOOTSTRAP ) == FALSE )
+      {
+        vp_os_mutex_lock( &session->at_mutex );
+        ardrone_session_at_queue( session, ardrone_session_fmt_AT_MSG_ATCMD_RESET_COM_WATCHDOG, ++session->at_sequence );
+        vp_os_mutex_unlock( &session->at_mutex );
+      }
+    }
+
+    if( ardrone_get_mask_from_state( navdata->ardrone_state, ARDRONE_NAVDATA_BOOTSTRAP ) && !session->bootstrap_done )
+    {
+      ardrone_session_at_config( session, "general:navdata_demo", session->config.navdata_demo ? "TRUE" : "FALSE" );
+      session->bootstrap_done = TRUE;
+    }
+
+    if( navdata->sequence > session->navdata_sequence )
+    {
+      vp_os_mutex_lock( &session->navdata_mutex );
+      ardrone_navdata_unpack_masked( &session->navdata_unpacked, navdata, &navdata_cks,
+                                     (session->config.navdata_options != 0) ? session->config.navdata_options : ARDRONE_NAVDATA_UNPACK_MASK );
+      vp_os_mutex_unlock( &session->navdata_mutex );
+      cks = ardrone_navdata_compute_cks( &session->navdata_buffer[0], size - sizeof(navdata_cks_t) );
+
+      if( cks == navdata_cks )
+      {
+        session->stats.navdata_packets++;
+        if( session->config.navdata_cb != NULL )
+          session->config.navdata_cb( session, &session->navdata_unpacked, session->config.custom );
+      }
+      else
+      {
+        PRINT( "[SESSION %d] Navdata checksum failed : %d (distant) / %d (local)\n", session->index, navdata_cks, cks );
+      }
+    }
+
+    session->navdata_sequence = navdata->sequence;
+  }
+}
+
+/***************************************************************************************************
+ * Control : one AT*CONFIG at a time, acknowledged through ARDRONE_COMMAND_MASK
+ */
+
+static void ardrone_session_control_update( ardrone_session_t *session, uint32_t now )
+{
+  bool_t ack = ardrone_get_mask_from_state( session->ardrone_state, ARDRONE_COMMAND_MASK ) ? TRUE : FALSE;
+  ardrone_session_config_entry_t *entry;
+
+  switch( session->control_state )
+  {
+    case ARDRONE_SESSION_CONTROL_IDLE:
+      if( session->config_count > 0 )
+      {
+        entry = &session->config_queue[session->config_first];
+        ardrone_session_at_queue( session, ardrone_session_fmt_AT_MSG_ATCMD_CONFIG_EXE, ++session->at_sequence, entry->key, entry->value );
+        session->control_state  = ARDRONE_SESSION_CONTROL_WAIT_ACK;
+        session->control_time   = now;
+      }
+      break;
+
+    case ARDRONE_SESSION_CONTROL_WAIT_ACK:
+      if( ack )
+      {
+        session->config_first = (session->config_first + 1) % ARDRONE_SESSION_CONFIG_QUEUE_SIZE;
+        session->config_count--;
+        session->stats.config_acks++;
+        ardrone_session_at_queue( session, ardrone_session_fmt_AT_MSG_ATCMD_CTRL_EXE, ++session->at_sequence, ACK_CONTROL_MODE, 0 );
+        session->control_state  = ARDRONE_SESSION_CONTROL_WAIT_CLEAR;
+        session->control_time   = now;
+      }
+      else if( now - session->control_time > ARDRONE_SESSION_CONTROL_TIMEOUT_MS )
+      {
+        // Not acknowledged : send it again
+        session->control_state = ARDRONE_SESSION_CONTROL_IDLE;
+      }
+      break;
+
+    case ARDRONE_SESSION_CONTROL_WAIT_CLEAR:
+      if( !ack )
+      {
+        session->control_state = ARDRONE_SESSION_CONTROL_IDLE;
+      }
+      else if( now - session->control_time > ARDRONE_SESSION_CONTROL_TIMEOUT_MS )
+      {
+        ardrone_session_at_queue( session, ardrone_session_fmt_AT_MSG_ATCMD_CTRL_EXE, ++session->at_sequence, ACK_CONTROL_MODE, 0 );
+        session->control_time = now;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+/***************************************************************************************************
+ * Video : PaVE frames are reassembled by the communication thread then given to the worker pool
+ */
+
+static C_RESULT ardrone_session_video_handler( int32_t fd, uint32_t events, void *data );
+
+static void ardrone_session_video_close( ardrone_session_t *session )
+{
+  vp_com_reactor_remove( &session->manager->reactor, session->video_socket );
+  ardrone_session_close_socket( &session->video_socket );
+  session->video_state = ARDRONE_SESSION_VIDEO_CLOSED;
+}
+
+static void ardrone_session_video_connect( ardrone_session_t *session, uint32_t now )
+{
+  struct sockaddr_in addr;
+  int s;
+
+  session->video_time = now;
+  session->video_len  = 0;
+
+  s = socket( AF_INET, SOCK_STREAM, 0 );
+  if( s < 0 )
+    return;
+
+  fcntl( s, F_SETFL, fcntl( s, F_GETFL, 0 ) | O_NONBLOCK );
+
+  vp_os_memset( &addr, 0, sizeof(addr) );
+  addr.sin_family       = AF_INET;
+  addr.sin_addr.s_addr  = inet_addr( session->ip );
+  addr.sin_port         = htons( VIDEO_PORT );
+
+  if( connect( s, (struct sockaddr*)&addr, sizeof(addr) ) < 0 && errno != EINPROGRESS )
+  {
+    close( s );
+    return;
+  }
+
+  session->video_socket = s;
+  session->video_state  = ARDRONE_SESSION_VIDEO_CONNECTING;
+
+  if( VP_FAILED( vp_com_reactor_add( &session->manager->reactor, s, VP_COM_REACTOR_WRITE, ardrone_session_video_handler, session ) ) )
+    ardrone_session_video_close( session );
+}
+
+static void ardrone_session_video_connected( ardrone_session_t *session )
+{
+  int error = 0;
+  socklen_t len = sizeof(error);
+
+  if( getsockopt( session->video_socket, SOL_SOCKET, SO_ERROR, &error, &len ) < 0 || error != 0 )
+  {
+    ardrone_session_video_close( session );
+    return;
+  }
+
+  vp_com_reactor_modify( &session->manager->reactor, session->video_socket, VP_COM_REACTOR_READ );
+  session->video_state    = ARDRONE_SESSION_VIDEO_CONNECTED;
+  session->video_wait_key = TRUE;
+  session->stats.video_connections++;
+}
+
+static void ardrone_session_video_post( ardrone_session_t *session, const parrot_video_encapsulation_t *pave, int32_t frame_size )
+{
+  ardrone_session_manager_t *manager = session->manager;
+  bool_t key_frame = (pave->frame_type == FRAME_TYPE_IDR_FRAME || pave->frame_type == FRAME_TYPE_I_FRAME) ? TRUE : FALSE;
+
+  if( session->config.video_cb == NULL )
+    return;
+
+  if( session->video_wait_key && !key_frame )
+  {
+    session->stats.video_dropped++;
+    return;
+  }
+
+  vp_os_mutex_lock( &manager->jobs_mutex );
+  if( session->video_busy )
+  {
+    // The previous frame of this drone is still being processed
+    session->video_wait_key = TRUE;
+    session->stats.video_dropped++;
+  }
+  else
+  {
+    vp_os_memcpy( session->video_frame, session->video_rx, frame_size );
+    session->video_busy     = TRUE;
+    session->video_wait_key = FALSE;
+    manager->jobs[(manager->jobs_first + manager->jobs_count) % ARDRONE_SESSION_MAX] = session;
+    manager->jobs_count++;
+    vp_os_cond_signal( &manager->jobs_cond );
+  }
+  vp_os_mutex_unlock( &manager->jobs_mutex );
+}
+
+static void ardrone_session_video_receive( ardrone_session_t *session )
+{
+  parrot_video_encapsulation_t *pave = (parrot_video_encapsulation_t*) session->video_rx;
+  int32_t frame_size;
+  ssize_t size;
+
+  size = recv( session->video_socket, &session->video_rx[session->video_len], ARDRONE_SESSION_VIDEO_BUFFER_SIZE - session->video_len, 0 );
+  if( size == 0 || (size < 0 && errno != EAGAIN && errno != EINTR) )
+  {
+    ardrone_session_video_close( session );
+    return;
+  }
+  if( size < 0 )
+    return;
+
+  session->video_len += size;
+
+  while( session->video_len >= (int32_t)sizeof(parrot_video_encapsulation_t) )
+  {
+    if( !PAVE_CHECK( pave->signature ) )
+    {
+      // Resynchronize on the next PaVE signature
+      int32_t i = 1;
+      while( i + 4 <= session->video_len && !PAVE_CHECK( &session->video_rx[i] ) )
+        i++;
+      memmove( session->video_rx, &session->video_rx[i], session->video_len - i );
+      session->video_len     -= i;
+      session->video_wait_key = TRUE;
+      continue;
+    }
+
+    frame_size = pave->header_size + pave->payload_size;
+    if( frame_size > ARDRONE_SESSION_VIDEO_BUFFER_SIZE )
+    {
+      PRINT( "[SESSION %d] Video frame too large (%d bytes)\n", session->index, frame_size );
+      session->video_len      = 0;
+      session->video_wait_key = TRUE;
+      break;
+    }
+    if( session->video_len < frame_size )
+      break;
+
+    session->stats.video_frames++;
+    ardrone_session_video_post( session, pave, frame_size );
+
+    memmove( session->video_rx, &session->video_rx[frame_size], session->video_len - frame_size );
+    session->video_len -= frame_size;
+  }
+}
+
+DEFINE_THREAD_ROUTINE( ardrone_session_worker, data )
+{
+  ardrone_session_manager_t *manager = (ardrone_session_manager_t*) data;
+  ardrone_session_t *session;
+  parrot_video_encapsulation_t *pave;
+
+  vp_os_mutex_lock( &manager->jobs_mutex );
+  while( manager->running )
+  {
+    if( manager->jobs_count == 0 )
+    {
+      vp_os_cond_wait( &manager->jobs_cond );
+      continue;
+    }
+
+    session = manager->jobs[manager->jobs_first];
+    manager->jobs_first = (manager->jobs_first + 1) % ARDRONE_SESSION_MAX;
+    manager->jobs_count--;
+    vp_os_mutex_unlock( &manager->jobs_mutex );
+
+    pave = (parrot_video_encapsulation_t*) session->video_frame;
+    session->config.video_cb( session, pave, &session->video_frame[pave->header_size], session->config.custom );
+
+    vp_os_mutex_lock( &manager->jobs_mutex );
+    session->video_busy = FALSE;
+  }
+  vp_os_mutex_unlock( &manager->jobs_mutex );
+
+  THREAD_RETURN( 0 );
+}
+
+/***************************************************************************************************
+ * Communication thread
+ */
+
+static void ardrone_session_cycle( ardrone_session_t *session, uint32_t now )
+{
+  float_or_int_t _phi, _theta, _gaz, _yaw;
+
+  if( now - session->navdata_time > ARDRONE_SESSION_NAVDATA_TIMEOUT_MS )
+  {
+    PRINT( "[SESSION %d] Navdata timeout - resending a navdata request to %s\n", session->index, session->ip );
+    session->stats.navdata_timeouts++;
+    session->bootstrap_done = FALSE;
+    ardrone_session_navdata_request( session );
+  }
+
+  if( session->config.video_enable && session->video_state == ARDRONE_SESSION_VIDEO_CLOSED
+      && now - session->video_time > ARDRONE_SESSION_VIDEO_RETRY_MS )
+  {
+    ardrone_session_video_connect( session, now );
+  }
+
+  vp_os_mutex_lock( &session->at_mutex );
+
+  ardrone_session_control_update( session, now );
+
+  _phi.f    = session->pcmd_phi;
+  _theta.f  = session->pcmd_theta;
+  _gaz.f    = session->pcmd_gaz;
+  _yaw.f    = session->pcmd_yaw;
+
+  ardrone_session_at_queue( session, ardrone_session_fmt_AT_MSG_ATCMD_RC_REF_EXE, ++session->at_sequence, session->ref_value );
+  ardrone_session_at_queue( session, ardrone_session_fmt_AT_MSG_ATCMD_PCMD_EXE, ++session->at_sequence,
+                            session->pcmd_flag, _phi.i, _theta.i, _gaz.i, _yaw.i );
+  ardrone_session_at_flush( session );
+
+  vp_os_mutex_unlock( &session->at_mutex );
+}
+
+static C_RESULT ardrone_session_navdata_handler( int32_t fd, uint32_t events, void *data )
+{
+  ardrone_session_navdata_receive( (ardrone_session_t*) data );
+
+  return C_OK;
+}
+
+static C_RESULT ardrone_session_video_handler( int32_t fd, uint32_t events, void *data )
+{
+  ardrone_session_t *session = (ardrone_session_t*) data;
+
+  if( session->video_state == ARDRONE_SESSION_VIDEO_CONNECTING )
+    ardrone_session_video_connected( session );
+  else if( events & (VP_COM_REACTOR_READ | VP_COM_REACTOR_ERROR) )
+    ardrone_session_video_receive( session );
+
+  return C_OK;
+}
+
+static C_RESULT ardrone_session_cycle_handler( int32_t fd, uint32_t events, void *data )
+{
+  ardrone_session_manager_t *manager = (ardrone_session_manager_t*) data;
+  uint32_t now = ardrone_session_time_ms();
+  int32_t i;
+
+  for( i = 0; i < manager->num_sessions; i++ )
+    ardrone_session_cycle( manager->sessions[i], now );
+
+  return C_OK;
+}
+
+DEFINE_THREAD_ROUTINE( ardrone_session_com, data )
+{
+  ardrone_session_manager_t *manager = (ardrone_session_manager_t*) data;
+
+  PRINT( "Thread ardrone_session_com in progress (%d sessions)...\n", manager->num_sessions );
+
+  vp_com_reactor_run( &manager->reactor );
+
+  THREAD_RETURN( 0 );
+}
+
+/***************************************************************************************************
+ * Public API
+ */
+
+C_RESULT ardrone_session_manager_init( ardrone_session_manager_t *manager, int32_t num_workers )
+{
+  vp_os_memset( manager, 0, sizeof(ardrone_session_manager_t) );
+
+  if( num_workers <= 0 )
+    num_workers = 1;
+  if( num_workers > ARDRONE_SESSION_MAX_WORKERS )
+    num_workers = ARDRONE_SESSION_MAX_WORKERS;
+
+  manager->num_workers = num_workers;
+  vp_os_mutex_init( &manager->jobs_mutex );
+  vp_os_cond_init( &manager->jobs_cond, &manager->jobs_mutex );
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_manager_add( ardrone_session_manager_t *manager, ardrone_session_t *session, const ardrone_session_config_t *config )
+{
+  if( manager->running || manager->num_sessions >= ARDRONE_SESSION_MAX
+      || config->ip == NULL || strlen( config->ip ) >= ARDRONE_IPADDRESS_SIZE )
+    return C_FAIL;
+
+  vp_os_memset( session, 0, sizeof(ardrone_session_t) );
+  vp_os_memcpy( &session->config, config, sizeof(ardrone_session_config_t) );
+  strcpy( session->ip, config->ip );
+  session->config.ip    = session->ip;
+  session->index        = manager->num_sessions;
+  session->manager      = manager;
+  session->ref_value    = ARDRONE_SESSION_REF_DEFAULT;
+  session->video_socket = -1;
+
+  session->at_socket      = ardrone_session_open_udp( session->ip, AT_PORT );
+  session->navdata_socket = ardrone_session_open_udp( session->ip, NAVDATA_PORT );
+  if( session->at_socket < 0 || session->navdata_socket < 0 )
+  {
+    PRINT( "[SESSION] Unable to open sockets for %s\n", session->ip );
+    ardrone_session_close_socket( &session->at_socket );
+    ardrone_session_close_socket( &session->navdata_socket );
+    return C_FAIL;
+  }
+
+  if( session->config.video_enable )
+  {
+    session->video_rx     = vp_os_malloc( ARDRONE_SESSION_VIDEO_BUFFER_SIZE );
+    session->video_frame  = vp_os_malloc( ARDRONE_SESSION_VIDEO_BUFFER_SIZE );
+    if( session->video_rx == NULL || session->video_frame == NULL )
+    {
+      vp_os_free( session->video_rx );
+      vp_os_free( session->video_frame );
+      ardrone_session_close_socket( &session->at_socket );
+      ardrone_session_close_socket( &session->navdata_socket );
+      return C_FAIL;
+    }
+  }
+
+  vp_os_mutex_init( &session->at_mutex );
+  vp_os_mutex_init( &session->navdata_mutex );
+
+  manager->sessions[manager->num_sessions++] = session;
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_manager_start( ardrone_session_manager_t *manager )
+{
+  int32_t i;
+
+  if( manager->running || manager->num_sessions == 0 )
+    return C_FAIL;
+
+  if( VP_FAILED( vp_com_reactor_init( &manager->reactor ) ) )
+    return C_FAIL;
+
+  for( i = 0; i < manager->num_sessions; i++ )
+  {
+    vp_com_reactor_add( &manager->reactor, manager->sessions[i]->navdata_socket, VP_COM_REACTOR_READ,
+                        ardrone_session_navdata_handler, manager->sessions[i] );
+    ardrone_session_navdata_request( manager->sessions[i] );
+  }
+  vp_com_reactor_add_timer( &manager->reactor, ARDRONE_SESSION_CYCLE_MS, ardrone_session_cycle_handler, manager, NULL );
+
+  manager->running = TRUE;
+  for( i = 0; i < manager->num_workers; i++ )
+    vp_os_thread_create( thread_ardrone_session_worker, (THREAD_PARAMS)manager, &manager->workers[i] );
+  vp_os_thread_create( thread_ardrone_session_com, (THREAD_PARAMS)manager, &manager->com_thread );
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_manager_stop( ardrone_session_manager_t *manager )
+{
+  ardrone_session_t *session;
+  int32_t i;
+
+  if( !manager->running )
+    return C_FAIL;
+
+  vp_os_mutex_lock( &manager->jobs_mutex );
+  manager->running = FALSE;
+  vp_os_cond_broadcast( &manager->jobs_cond );
+  vp_os_mutex_unlock( &manager->jobs_mutex );
+
+  vp_com_reactor_stop( &manager->reactor );
+  vp_os_thread_join( manager->com_thread );
+  vp_com_reactor_shutdown( &manager->reactor );
+  for( i = 0; i < manager->num_workers; i++ )
+    vp_os_thread_join( manager->workers[i] );
+
+  for( i = 0; i < manager->num_sessions; i++ )
+  {
+    session = manager->sessions[i];
+    ardrone_session_close_socket( &session->at_socket );
+    ardrone_session_close_socket( &session->navdata_socket );
+    ardrone_session_close_socket( &session->video_socket );
+    vp_os_free( session->video_rx );
+    vp_os_free( session->video_frame );
+    session->video_rx     = NULL;
+    session->video_frame  = NULL;
+    vp_os_mutex_destroy( &session->at_mutex );
+    vp_os_mutex_destroy( &session->navdata_mutex );
+  }
+  manager->num_sessions = 0;
+
+  vp_os_cond_destroy( &manager->jobs_cond );
+  vp_os_mutex_destroy( &manager->jobs_mutex );
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_at_set_ref( ardrone_session_t *session, uint32_t value )
+{
+  vp_os_mutex_lock( &session->at_mutex );
+  session->ref_value = value;
+  vp_os_mutex_unlock( &session->at_mutex );
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_at_takeoff( ardrone_session_t *session, bool_t takeoff )
+{
+  vp_os_mutex_lock( &session->at_mutex );
+  if( takeoff )
+    session->ref_value |= (1 << ARDRONE_UI_BIT_START);
+  else
+    session->ref_value &= ~(1 << ARDRONE_UI_BIT_START);
+  vp_os_mutex_unlock( &session->at_mutex );
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_at_emergency( ardrone_session_t *session, bool_t emergency )
+{
+  vp_os_mutex_lock( &session->at_mutex );
+  if( emergency )
+    session->ref_value |= (1 << ARDRONE_UI_BIT_SELECT);
+  else
+    session->ref_value &= ~(1 << ARDRONE_UI_BIT_SELECT);
+  vp_os_mutex_unlock( &session->at_mutex );
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_at_set_progress_cmd( ardrone_session_t *session, int32_t flag, float32_t phi, float32_t theta, float32_t gaz, float32_t yaw )
+{
+  vp_os_mutex_lock( &session->at_mutex );
+  session->pcmd_flag  = flag;
+  session->pcmd_phi   = phi;
+  session->pcmd_theta = theta;
+  session->pcmd_gaz   = gaz;
+  session->pcmd_yaw   = yaw;
+  vp_os_mutex_unlock( &session->at_mutex );
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_at_flat_trim( ardrone_session_t *session )
+{
+  vp_os_mutex_lock( &session->at_mutex );
+  ardrone_session_at_queue( session, ardrone_session_fmt_AT_MSG_ATCMD_FTRIM_EXE, ++session->at_sequence );
+  vp_os_mutex_unlock( &session->at_mutex );
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_at_led( ardrone_session_t *session, int32_t anim, float32_t freq, uint32_t duration )
+{
+  float_or_int_t _freq;
+
+  _freq.f = freq;
+
+  vp_os_mutex_lock( &session->at_mutex );
+  ardrone_session_at_queue( session, ardrone_session_fmt_AT_MSG_ATCMD_LED_EXE, ++session->at_sequence, anim, _freq.i, duration );
+  vp_os_mutex_unlock( &session->at_mutex );
+
+  return C_OK;
+}
+
+C_RESULT ardrone_session_at_config( ardrone_session_t *session, const char *key, const char *value )
+{
+  ardrone_session_config_entry_t *entry;
+  C_RESULT res = C_OK;
+
+  if( strlen( key ) >= ARDRONE_SESSION_CONFIG_STRING_SIZE || strlen( value ) >= ARDRONE_SESSION_CONFIG_STRING_SIZE )
+    return C_FAIL;
+
+  vp_os_mutex_lock( &session->at_mutex );
+  if( session->config_count < ARDRONE_SESSION_CONFIG_QUEUE_SIZE )
+  {
+    entry = &session->config_queue[(session->config_first + session->config_count) % ARDRONE_SESSION_CONFIG_QUEUE_SIZE];
+    strcpy( entry->key, key );
+    strcpy( entry->value, value );
+    session->config_count++;
+  }
+  else
+  {
+    res = C_FAIL;
+  }
+  vp_os_mutex_unlock( &session->at_mutex );
+
+  return res;
+}
+
+C_RESULT ardrone_session_get_navdata( ardrone_session_t *session, navdata_unpacked_t *navdata )
+{
+  vp_os_mutex_lock( &session->navdata_mutex );
+  vp_os_memcpy( navdata, &session->navdata_unpacked, sizeof(navdata_unpacked_t) );
+  vp_os_mutex_unlock( &session->navdata_mutex );
+
+  return C_OK;
+}
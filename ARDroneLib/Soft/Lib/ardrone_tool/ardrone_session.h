@@ -0,0 +1,180 @@
+/**
+ * @file ardrone_session.h
+ * @date 2026/10/18
+ *
+ * Multi-drone sessions : each ardrone_session_t owns the AT, navdata, control
+ * and video links of one drone, so that a single process can drive several
+ * drones at once (King of the Hill arena).
+ *
+ * All sessions of a manager share one communication thread (vp_com_reactor
+ * over every socket) and one pool of worker threads used for the video callbacks,
+ * so decoding and vision processing are not duplicated per drone.
+ *
+ * The process-wide ardrone_tool singletons (wifi_ardrone_ip, at_socket,
+ * navdata_unpacked, ardrone_control ...) are not used by sessions : single
+ * drone applications keep working unchanged.
+ */
+
+#ifndef _ARDRONE_SESSION_H_
+#define _ARDRONE_SESSION_H_
+
+#include <VP_Os/vp_os_types.h>
+#include <VP_Os/vp_os_signal.h>
+#include <VP_Os/vp_os_thread.h>
+#include <VP_Com/vp_com_reactor.h>
+
+#include <ardrone_api.h>
+#include <ardrone_tool/ardrone_tool.h>
+#include <video_encapsulation.h>
+
+#define ARDRONE_SESSION_MAX                 (8)
+#define ARDRONE_SESSION_MAX_WORKERS         (4)
+#define ARDRONE_SESSION_AT_BUFFER_SIZE      (1024)
+#define ARDRONE_SESSION_CONFIG_QUEUE_SIZE   (16)
+#define ARDRONE_SESSION_CONFIG_STRING_SIZE  (64)
+#define ARDRONE_SESSION_VIDEO_BUFFER_SIZE   (1024 * 1024)
+
+struct _ardrone_session_t;
+
+/**
+ * Called from the communication thread for each valid navdata packet.
+ * Must return quickly : all sessions share this thread.
+ */
+typedef void (*ardrone_session_navdata_cb_t)( struct _ardrone_session_t *session, const navdata_unpacked_t *navdata, void *custom );
+
+/**
+ * Called from a worker thread for each complete video frame (PaVE header
+ * followed by header->payload_size bytes). At most one frame per session is
+ * processed at a time ; frames received meanwhile are dropped up to the next
+ * I/IDR frame.
+ */
+typedef void (*ardrone_session_video_cb_t)( struct _ardrone_session_t *session, const parrot_video_encapsulation_t *pave, const uint8_t *frame, void *custom );
+
+typedef struct _ardrone_session_config_t
+{
+  const char*                   ip;
+  bool_t                        navdata_demo;   // general:navdata_demo sent at bootstrap
+  uint32_t                      navdata_options;// Options unpacked for navdata_cb (NAVDATA_OPTION_MASK), 0 : ARDRONE_NAVDATA_UNPACK_MASK
+  bool_t                        video_enable;   // Connect to the video port
+  ardrone_session_navdata_cb_t  navdata_cb;
+  ardrone_session_video_cb_t    video_cb;
+  void*                         custom;         // Given back to the callbacks
+} ardrone_session_config_t;
+
+typedef enum _ardrone_session_control_state_t
+{
+  ARDRONE_SESSION_CONTROL_IDLE = 0,
+  ARDRONE_SESSION_CONTROL_WAIT_ACK,     // AT*CONFIG sent, waiting for ARDRONE_COMMAND_MASK
+  ARDRONE_SESSION_CONTROL_WAIT_CLEAR    // AT*CTRL=ACK sent, waiting for ARDRONE_COMMAND_MASK to clear
+} ardrone_session_control_state_t;
+
+typedef enum _ardrone_session_video_state_t
+{
+  ARDRONE_SESSION_VIDEO_CLOSED = 0,
+  ARDRONE_SESSION_VIDEO_CONNECTING,
+  ARDRONE_SESSION_VIDEO_CONNECTED
+} ardrone_session_video_state_t;
+
+typedef struct _ardrone_session_config_entry_t
+{
+  char key[ARDRONE_SESSION_CONFIG_STRING_SIZE];
+  char value[ARDRONE_SESSION_CONFIG_STRING_SIZE];
+} ardrone_session_config_entry_t;
+
+typedef struct _ardrone_session_stats_t
+{
+  uint32_t navdata_packets;
+  uint32_t navdata_timeouts;
+  uint32_t config_acks;
+  uint32_t video_frames;
+  uint32_t video_dropped;
+  uint32_t video_connections;
+} ardrone_session_stats_t;
+
+typedef struct _ardrone_session_t
+{
+  int32_t                         index;
+  char                            ip[ARDRONE_IPADDRESS_SIZE];
+  ardrone_session_config_t        config;
+  struct _ardrone_session_manager_t *manager;
+  ardrone_session_stats_t         stats;
+
+  // AT link
+  int                             at_socket;
+  vp_os_mutex_t                   at_mutex;
+  int32_t                         at_sequence;
+  int32_t                         at_len;
+  char                            at_buffer[ARDRONE_SESSION_AT_BUFFER_SIZE];
+  uint32_t                        ref_value;
+  int32_t                         pcmd_flag;
+  float32_t                       pcmd_phi;
+  float32_t                       pcmd_theta;
+  float32_t                       pcmd_gaz;
+  float32_t                       pcmd_yaw;
+
+  // Navdata link
+  int                             navdata_socket;
+  uint32_t                        navdata_sequence;
+  uint32_t                        navdata_time;       // Last reception (ms)
+  uint32_t                        ardrone_state;
+  bool_t                          bootstrap_done;
+  vp_os_mutex_t                   navdata_mutex;
+  navdata_unpacked_t              navdata_unpacked;
+  uint8_t                         navdata_buffer[NAVDATA_MAX_SIZE];
+
+  // Control (configuration acknowledge protocol)
+  ardrone_session_control_state_t control_state;
+  uint32_t                        control_time;
+  int32_t                         config_first;
+  int32_t                         config_count;
+  ardrone_session_config_entry_t  config_queue[ARDRONE_SESSION_CONFIG_QUEUE_SIZE];
+
+  // Video link
+  int                             video_socket;
+  ardrone_session_video_state_t   video_state;
+  uint32_t                        video_time;         // Last connection attempt (ms)
+  bool_t                          video_wait_key;     // Drop frames up to the next I/IDR frame
+  volatile bool_t                 video_busy;         // A worker owns video_frame
+  int32_t                         video_len;
+  uint8_t*                        video_rx;
+  uint8_t*                        video_frame;
+} ardrone_session_t;
+
+typedef struct _ardrone_session_manager_t
+{
+  ardrone_session_t*  sessions[ARDRONE_SESSION_MAX];
+  int32_t             num_sessions;
+  volatile bool_t     running;
+  THREAD_HANDLE       com_thread;
+  vp_com_reactor_t    reactor;
+
+  // Worker pool
+  int32_t             num_workers;
+  THREAD_HANDLE       workers[ARDRONE_SESSION_MAX_WORKERS];
+  vp_os_mutex_t       jobs_mutex;
+  vp_os_cond_t        jobs_cond;
+  ardrone_session_t*  jobs[ARDRONE_SESSION_MAX];
+  int32_t             jobs_first;
+  int32_t             jobs_count;
+} ardrone_session_manager_t;
+
+C_RESULT ardrone_session_manager_init( ardrone_session_manager_t *manager, int32_t num_workers );
+C_RESULT ardrone_session_manager_add( ardrone_session_manager_t *manager, ardrone_session_t *session, const ardrone_session_config_t *config );
+C_RESULT ardrone_session_manager_start( ardrone_session_manager_t *manager );
+C_RESULT ardrone_session_manager_stop( ardrone_session_manager_t *manager );
+
+// AT commands : REF and PCMD values are resent on each communication cycle
+C_RESULT ardrone_session_at_set_ref( ardrone_session_t *session, uint32_t value );
+C_RESULT ardrone_session_at_takeoff( ardrone_session_t *session, bool_t takeoff );
+C_RESULT ardrone_session_at_emergency( ardrone_session_t *session, bool_t emergency );
+C_RESULT ardrone_session_at_set_progress_cmd( ardrone_session_t *session, int32_t flag, float32_t phi, float32_t theta, float32_t gaz, float32_t yaw );
+C_RESULT ardrone_session_at_flat_trim( ardrone_session_t *session );
+C_RESULT ardrone_session_at_led( ardrone_session_t *session, int32_t anim, float32_t freq, uint32_t duration );
+
+// Configuration : queued and sent one at a time with the control acknowledge protocol
+C_RESULT ardrone_session_at_config( ardrone_session_t *session, const char *key, const char *value );
+
+// Copy of the last navdata received by the session
+C_RESULT ardrone_session_get_navdata( ardrone_session_t *session, navdata_unpacked_t *navdata );
+
+#endif // _ARDRONE_SESSION_H_
@@ -1,6 +1,7 @@
 #include "VP_Os/vp_os_delay.h"
 #include <VP_Os/vp_os_malloc.h>
 #include <VP_Os/vp_os_print.h>
+#include <VP_Os/vp_os_trace.h>
 #include <VP_Api/vp_api_thread_helper.h>
 
 #include <ardrone_tool/ardrone_tool.h>
@@ -402,6 +403,15 @@ int ardrone_tool_main(int argc, char **argv)
 		for (lastSlashPos = strlen (argv[0])-1; lastSlashPos > 0 && argv[0][lastSlashPos] != '/' && argv[0][lastSlashPos] != '\\'; lastSlashPos--);
 		appname = &argv[0][lastSlashPos+1];
 		ardrone_gen_appid (appname, __SDK_VERSION__, app_id, app_name, sizeof (app_name));
+#ifdef VP_OS_TRACE_SUPPORTED
+		// ARDRONE_TRACE=file.json records a trace of the whole session
+		const char *trace_path = getenv("ARDRONE_TRACE");
+		if( trace_path != NULL )
+		{
+			vp_os_trace_set_thread_name("ardrone_tool");
+			vp_os_trace_enable(TRUE);
+		}
+#endif
 		res = ardrone_tool_init(wifi_ardrone_ip, strlen(wifi_ardrone_ip), NULL, appname, NULL, NULL, NULL, MAX_FLIGHT_STORING_SIZE, NULL);
 
       while( SUCCEED(res) && ardrone_tool_exit() == FALSE )
@@ -410,6 +420,15 @@ int ardrone_tool_main(int argc, char **argv)
       }
 
       res = ardrone_tool_shutdown();
+
+#ifdef VP_OS_TRACE_SUPPORTED
+      if( trace_path != NULL )
+      {
+        vp_os_trace_enable(FALSE);
+        if( SUCCEED(vp_os_trace_dump(trace_path)) )
+          PRINT("Trace written to %s\n", trace_path);
+      }
+#endif
     }
 
   if( old_locale != NULL )
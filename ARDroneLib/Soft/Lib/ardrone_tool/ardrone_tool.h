@@ -15,6 +15,10 @@
 #define MAX_NUM_INPUT_EVENTS      16
 #define MAX_FLIGHT_STORING_SIZE	  40
 
+// Drones on a loopback address are the ones of Examples/Linux/drone_simulator, which binds
+// the AT and navdata ports too : the tool then opens them with SO_REUSEADDR
+#define ARDRONE_TOOL_IS_SIMULATED_DRONE(ip)  (0 == strncmp((ip), "127.", 4))
+
 #ifdef ND_WRITE_TO_FILE
 extern uint32_t num_picture_decoded;
 extern uint32_t wiimote_enable;
@@ -20,6 +20,7 @@
 #include <VP_Os/vp_os_signal.h>
 
 #include <errno.h>
+#include <sys/socket.h>
 
 #include <VP_Os/vp_os_print.h>
 
@@ -114,6 +115,13 @@
 #define IP_STRING_SIZE 16 // IP strings goes from 8 ("w.x.y.z\0") to 16 ("www.xxx.yyy.zzz\0") chars
 #define LIST_BUFFER_BLOCKSIZE 1024
 #define FILE_NAME_MAX_SIZE 512
+#ifndef FTP_DATA_BUFFER_SIZE
+#define FTP_DATA_BUFFER_SIZE (256*1024) // Data socket receive buffer, pipe and read() size of ftpGet
+#endif
+
+/* PROGRESS MACROS */
+
+#define FTP_PROGRESS_STEP (1.0) // Minimum progression (percent) between two FTP_PROGRESS callbacks of ftpGet
 
 /* TIMEOUT MACROS */
 
@@ -128,6 +136,8 @@ int FTPlastErrorMessageSize = 0;
 /* THREAD STRUCTURES */
 
 typedef struct _ftp_list_param_s _ftp_list_param;
+typedef struct _ftp_queue_s _ftp_queue;
+typedef struct _ftp_queue_worker_s _ftp_queue_worker;
 typedef struct _ftp_get_param_s _ftp_get_param;
 typedef struct _ftp_put_param_s _ftp_put_param;
 
@@ -151,6 +161,26 @@ struct _ftp_get_param_s
     char *fileList;
 };
 
+struct _ftp_queue_worker_s
+{
+    _ftp_queue *queue;
+    _ftp_t *ftp;
+    THREAD_HANDLE thread;
+};
+
+struct _ftp_queue_s
+{
+    vp_os_mutex_t mutex; // Protects nextItem, aborted and the callback calls
+    _ftp_get_item *items;
+    int nbItems;
+    int nextItem;
+    int aborted;
+    int useResume;
+    ftp_callback callback;
+    _ftp_queue_worker workers [FTP_QUEUE_MAX_CONNECTIONS];
+    int nbWorkers;
+};
+
 struct _ftp_list_param_s
 {
     _ftp_t *ftp;
@@ -173,7 +203,10 @@ _ftp_status getPassiveIpAndPort (_ftp_t *ftp, const char *response, char *ip, in
 _ftp_status ftpTransfert (_ftp_t *ftp, const char *message, char *answer, int answSize);
 _ftp_status ftpSend (_ftp_t *ftp, const char *message);
 _ftp_status ftpRecv (_ftp_t *ftp, char *answer, int answSize);
+int ftpRecvData (_ftp_t *ftp, int dataFd, int fileFd, char *buffer, int size);
+_ftp_get_param *newGetParam (_ftp_t *ftp, const char *remoteName, const char *localName, int useResume, ftp_callback callback);
 DEFINE_THREAD_ROUTINE (ftpGet, param);
+DEFINE_THREAD_ROUTINE (ftpGetQueue, param);
 DEFINE_THREAD_ROUTINE (ftpPut, param);
 DEFINE_THREAD_ROUTINE (ftpList, param);
 
@@ -495,6 +528,135 @@ ftpRecv (_ftp_t *ftp, char *answer, int answSize)
     return FTP_SUCCESS;
 }
 
+static int
+ftpWriteAll (int fileFd, const char *buffer, int size)
+{
+    while (0 < size)
+    {
+        int written = write (fileFd, buffer, size);
+        if (0 > written)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return -1;
+        }
+        buffer += written;
+        size -= written;
+    }
+    return 0;
+}
+
+/* Moves at most size bytes from the data socket to the local file
+ * Returns the number of bytes written, 0 on timeout or end of data, -1 on error */
+int
+ftpRecvData (_ftp_t *ftp, int dataFd, int fileFd, char *buffer, int size)
+{
+    int bytes;
+#if defined (__linux__) && defined (SPLICE_F_MOVE)
+    // Data goes socket -> pipe -> file in the kernel. dataPipe [0] is -1 when the pipe is not created, -2 when splice is not usable
+    if (-1 == ftp->dataPipe [0] && 0 == pipe (ftp->dataPipe))
+    {
+#ifdef F_SETPIPE_SZ
+        fcntl (ftp->dataPipe [1], F_SETPIPE_SZ, FTP_DATA_BUFFER_SIZE);
+#endif
+    }
+    if (0 <= ftp->dataPipe [0])
+    {
+        do
+        {
+            bytes = splice (dataFd, NULL, ftp->dataPipe [1], NULL, size, SPLICE_F_MOVE | SPLICE_F_MORE);
+        } while (0 > bytes && EINTR == errno);
+
+        if (0 < bytes)
+        {
+            int left = bytes;
+            while (0 < left)
+            {
+                int moved = splice (ftp->dataPipe [0], NULL, fileFd, NULL, left, SPLICE_F_MOVE);
+                if (0 < moved)
+                {
+                    left -= moved;
+                }
+                else if (0 > moved && EINTR == errno)
+                {
+                    continue;
+                }
+                else
+                {
+                    // File can't be spliced to, empty the pipe with read/write and stop using it
+                    FTP_DEBUG ("Unable to splice to file (%s), using read/write\n", strerror (errno));
+                    while (0 < left)
+                    {
+                        int got = read (ftp->dataPipe [0], buffer, (left < size) ? left : size);
+                        if (0 >= got || 0 > ftpWriteAll (fileFd, buffer, got))
+                        {
+                            break;
+                        }
+                        left -= got;
+                    }
+                    close (ftp->dataPipe [0]);
+                    close (ftp->dataPipe [1]);
+                    ftp->dataPipe [0] = -2;
+                    ftp->dataPipe [1] = -2;
+                    if (0 < left)
+                    {
+                        return -1;
+                    }
+                }
+            }
+            return bytes;
+        }
+        else if (0 == bytes || EAGAIN == errno || EWOULDBLOCK == errno)
+        {
+            return 0;
+        }
+        else if (EINVAL != errno && ENOSYS != errno)
+        {
+            return -1;
+        }
+        // Socket can't be spliced from, nothing was moved
+        close (ftp->dataPipe [0]);
+        close (ftp->dataPipe [1]);
+        ftp->dataPipe [0] = -2;
+        ftp->dataPipe [1] = -2;
+    }
+#endif
+    do
+    {
+        bytes = recv (dataFd, buffer, size, 0);
+    } while (0 > bytes && EINTR == errno);
+
+    if (0 > bytes)
+    {
+        return (EAGAIN == errno || EWOULDBLOCK == errno) ? 0 : -1;
+    }
+    if (0 > ftpWriteAll (fileFd, buffer, bytes))
+    {
+        return -1;
+    }
+    return bytes;
+}
+
+_ftp_get_param *
+newGetParam (_ftp_t *ftp, const char *remoteName, const char *localName, int useResume, ftp_callback callback)
+{
+    _ftp_get_param *param = vp_os_malloc (sizeof (_ftp_get_param));
+    if (NULL != param)
+    {
+        param->ftp = ftp;
+        strncpy (param->localName, localName, FILE_NAME_MAX_SIZE);
+        param->localName [FILE_NAME_MAX_SIZE-1] = '\0';
+        strncpy (param->remoteName, remoteName, FILE_NAME_MAX_SIZE);
+        param->remoteName [FILE_NAME_MAX_SIZE-1] = '\0';
+        param->useResume = useResume;
+        param->callback = callback;
+        param->fileList = NULL;
+    }
+    return param;
+}
+
 _ftp_status
 ftpClose (_ftp_t **ftp)
 {
@@ -520,6 +682,11 @@ ftpClose (_ftp_t **ftp)
             (*ftp)->socket = NULL;
             retVal = FTP_SUCCESS;
         }
+        if (0 <= (*ftp)->dataPipe [0])
+        {
+            close ((*ftp)->dataPipe [0]);
+            close ((*ftp)->dataPipe [1]);
+        }
         vp_os_free (*ftp);
         *ftp = NULL;
     }
@@ -564,8 +731,12 @@ ftpConnect (const char *ip, int port, const char *username, const char *password
     }
     retFtp->lastStatus = FTP_SUCCESS;
     retFtp->lastFileList = NULL;
+    retFtp->dataPipe [0] = -1;
+    retFtp->dataPipe [1] = -1;
+    snprintf (retFtp->username, sizeof (retFtp->username), "%s", username);
+    snprintf (retFtp->password, sizeof (retFtp->password), "%s", password);
 
-    retFtp->socket = vp_os_malloc (sizeof (vp_com_socket_t));
+    retFtp->socket = vp_os_calloc (1, sizeof (vp_com_socket_t));
     if (NULL == retFtp->socket)
     {
         FTP_ERROR ("Unable to allocate socket filed of the ftp structure\n");
@@ -590,7 +761,7 @@ ftpConnect (const char *ip, int port, const char *username, const char *password
         return NULL;
     }
 
-    int result = setSockTimeout ((int)retFtp->socket->priv, SOCK_TO_SEC, SOCK_TO_USEC);
+    int result = setSockTimeout ((int)(intptr_t)retFtp->socket->priv, SOCK_TO_SEC, SOCK_TO_USEC);
     if (0 > result)
     {
         FTP_ERROR ("Unable to set socket timeout\n");
@@ -796,7 +967,7 @@ DEFINE_THREAD_ROUTINE (ftpList, param)
     getPassiveIpAndPort (params->ftp, srvMsg, dataIp, &dataPort, IP_STRING_SIZE);
 
     FTP_DEBUG ("Thread will connect to %s:%d\n", dataIp, dataPort);
-    dataSocket = vp_os_malloc (sizeof (vp_com_socket_t));
+    dataSocket = vp_os_calloc (1, sizeof (vp_com_socket_t));
     if (NULL == dataSocket)
     {
         FTP_ERROR ("Unable to allocate socket structure\n");
@@ -816,7 +987,7 @@ DEFINE_THREAD_ROUTINE (ftpList, param)
         CLEAN_PARAMS (FTP_FAIL);
     }
 
-    int result = setSockTimeout ((int)dataSocket->priv, SOCK_TO_SEC, SOCK_TO_USEC);
+    int result = setSockTimeout ((int)(intptr_t)dataSocket->priv, SOCK_TO_SEC, SOCK_TO_USEC);
     if (0 > result)
     {
         FTP_ERROR ("Unable to set data socket timeout\n");
@@ -1035,7 +1206,7 @@ DEFINE_THREAD_ROUTINE (ftpGet, param)
     }
 
     FTP_DEBUG ("Thread will connect to %s:%d\n", dataIp, dataPort);
-    dataSocket = vp_os_malloc (sizeof (vp_com_socket_t));
+    dataSocket = vp_os_calloc (1, sizeof (vp_com_socket_t));
     if (NULL == dataSocket)
     {
         FTP_ERROR ("Unable to allocate socket structure\n");
@@ -1055,7 +1226,7 @@ DEFINE_THREAD_ROUTINE (ftpGet, param)
         CLEAN_PARAMS (FTP_FAIL);
     }
 
-    int result = setSockTimeout ((int)dataSocket->priv, SOCK_TO_SEC, SOCK_TO_USEC);
+    int result = setSockTimeout ((int)(intptr_t)dataSocket->priv, SOCK_TO_SEC, SOCK_TO_USEC);
     if (0 > result)
     {
         FTP_ERROR ("Unable to set data socket timeout\n");
@@ -1075,51 +1246,66 @@ DEFINE_THREAD_ROUTINE (ftpGet, param)
 
     int sizeGot = appendOffset;
     float percentGot = (sizeGot * 100.0) / (fileSize *1.0);
+    float percentCalled = percentGot;
     params->callback (FTP_PROGRESS, (void *)&percentGot, params->ftp);
 
-    filePart = vp_os_calloc (MAX_SIZE_MSG, 1);
+    filePart = vp_os_malloc (FTP_DATA_BUFFER_SIZE);
     if (NULL == filePart)
     {
         FTP_ERROR ("Unable to alloc buffer\n");
         CLEAN_PARAMS (FTP_FAIL);
     }
 
-    if (1 == appendToFile)
-    {
-        localFile = fopen (params->localName, "ab");
-    }
-    else
+    // No O_APPEND : splice can't write to a file in append mode
+    int localFd = open (params->localName, O_WRONLY | O_CREAT | ((1 == appendToFile) ? 0 : O_TRUNC), 0666);
+    if (0 <= localFd)
     {
-        localFile = fopen (params->localName, "wb");
+        localFile = fdopen (localFd, "wb");
+        if (NULL == localFile)
+        {
+            close (localFd);
+        }
     }
     if (NULL == localFile)
     {
         FTP_ERROR ("Unable to open dest file %s\n", params->localName);
         CLEAN_PARAMS (FTP_FAIL);
     }
+    if (appendOffset != lseek (localFd, appendOffset, SEEK_SET))
+    {
+        FTP_ERROR ("Unable to seek in dest file %.400s\n", params->localName);
+        CLEAN_PARAMS (FTP_FAIL);
+    }
+#if defined (__linux__) && defined (FALLOC_FL_KEEP_SIZE)
+    // File size stays the size got, so that an interrupted transfert is resumed from the right offset
+    fallocate (localFd, FALLOC_FL_KEEP_SIZE, appendOffset, sizeToGet);
+#endif
     while (sizeGot < fileSize)
     {
         CHECK_ABORT;
-        int bytes = MAX_SIZE_MSG-1;
-        C_RESULT vp_result = dataRead (dataSocket, (uint8_t *)filePart, &bytes);
-        if (VP_FAILED (vp_result))
+        int bytes = fileSize - sizeGot;
+        if (FTP_DATA_BUFFER_SIZE < bytes)
         {
-            FTP_ERROR ("Error while receiving data\n");
+            bytes = FTP_DATA_BUFFER_SIZE;
+        }
+        bytes = ftpRecvData (params->ftp, (int)(intptr_t)dataSocket->priv, localFd, filePart, bytes);
+        if (0 > bytes)
+        {
+            FTP_ERROR ("Error while receiving data to file (%s)\n", strerror (errno));
             CLEAN_PARAMS (FTP_FAIL);
         }
-        if (0 >= bytes)
+        if (0 == bytes)
         {
             FTP_ERROR ("Recv timeout\n");
             CLEAN_PARAMS (FTP_TIMEOUT);
         }
-        if (0 > fwrite (filePart, 1, bytes, localFile))
-        {
-            FTP_ERROR ("Unable to write to file\n");
-            CLEAN_PARAMS (FTP_FAIL);
-        }
         sizeGot += bytes;
         percentGot = (sizeGot * 100.0) / (fileSize * 1.0);
-        params->callback (FTP_PROGRESS, (void *)&percentGot, params->ftp);
+        if (FTP_PROGRESS_STEP <= percentGot - percentCalled || sizeGot == fileSize)
+        {
+            percentCalled = percentGot;
+            params->callback (FTP_PROGRESS, (void *)&percentGot, params->ftp);
+        }
     }
     ftp_result = ftpRecv (params->ftp, srvMsg, MAX_SIZE_MSG-1);
     if (FTP_FAILED (ftp_result))
@@ -1243,7 +1429,7 @@ DEFINE_THREAD_ROUTINE (ftpPut, param)
     }
 
     FTP_DEBUG ("Thread will connect to %s:%d\n", dataIp, dataPort);
-    dataSocket = vp_os_malloc (sizeof (vp_com_socket_t));
+    dataSocket = vp_os_calloc (1, sizeof (vp_com_socket_t));
     if (NULL == dataSocket)
     {
         FTP_ERROR ("Unable to allocate socket structure\n");
@@ -1263,7 +1449,7 @@ DEFINE_THREAD_ROUTINE (ftpPut, param)
         CLEAN_PARAMS (FTP_FAIL);
     }
 
-    int result = setSockTimeout ((int)dataSocket->priv, SOCK_TO_SEC, SOCK_TO_USEC);
+    int result = setSockTimeout ((int)(intptr_t)dataSocket->priv, SOCK_TO_SEC, SOCK_TO_USEC);
     if (0 > result)
     {
         FTP_ERROR ("Unable to set data socket timeout\n");
@@ -1377,6 +1563,56 @@ DEFINE_THREAD_ROUTINE (ftpPut, param)
 }
 
 
+/* Each worker gets the next file of the queue on its own connection, until the queue is empty */
+DEFINE_THREAD_ROUTINE (ftpGetQueue, param)
+{
+    _ftp_queue_worker *worker = (_ftp_queue_worker *)param;
+    _ftp_queue *queue = worker->queue;
+    while (1) // Loop is killed by a break statement
+    {
+        vp_os_mutex_lock (&queue->mutex);
+        int index = (0 == queue->aborted) ? queue->nextItem++ : queue->nbItems;
+        vp_os_mutex_unlock (&queue->mutex);
+        if (index >= queue->nbItems)
+        {
+            break;
+        }
+
+        _ftp_get_item *item = &queue->items [index];
+        _ftp_status status = FTP_FAIL;
+        _ftp_get_param *getParam = newGetParam (worker->ftp, item->remoteName, item->localName, queue->useResume, emptyCallback);
+        if (NULL != getParam)
+        {
+            // The get routine runs in this thread : vp_os_thread_create would wait for the vp_os_thread_join of this thread
+            worker->ftp->opInProgress = 1;
+            thread_ftpGet ((THREAD_PARAMS)getParam);
+            status = worker->ftp->lastStatus;
+        }
+
+        vp_os_mutex_lock (&queue->mutex);
+        item->status = status;
+        if (FTP_ABORT == status && 0 == queue->aborted)
+        {
+            int i;
+            queue->aborted = 1;
+            for (i = 0; i < queue->nbWorkers; i++)
+            {
+                if (worker != &queue->workers [i])
+                {
+                    ftpAbort (queue->workers [i].ftp);
+                }
+            }
+        }
+        if (NULL != queue->callback)
+        {
+            queue->callback (status, (void *)item, worker->ftp);
+        }
+        vp_os_mutex_unlock (&queue->mutex);
+    }
+    FTP_DEBUG ("Returning from thread %s\n", __FUNCTION__);
+    THREAD_RETURN (0);
+}
+
 _ftp_status
 ftpPut (_ftp_t *ftp, const char *localName, const char *remoteName, int useResume, ftp_callback callback)
 {
@@ -1442,7 +1678,7 @@ ftpGet (_ftp_t *ftp, const char *remoteName, const char *localName, int useResum
     }
     ftp->opInProgress = 1;
 
-    _ftp_get_param *param = vp_os_malloc (sizeof (_ftp_get_param));
+    _ftp_get_param *param = newGetParam (ftp, remoteName, localName, useResume, actualCallback);
 
     if (NULL == param)
     {
@@ -1452,14 +1688,6 @@ ftpGet (_ftp_t *ftp, const char *remoteName, const char *localName, int useResum
         return FTP_FAIL;
     }
 
-    param->ftp = ftp;
-    strncpy (param->localName, localName, FILE_NAME_MAX_SIZE);
-    param->localName [FILE_NAME_MAX_SIZE-1] = '\0';
-    strncpy (param->remoteName, remoteName, FILE_NAME_MAX_SIZE);
-    param->remoteName [FILE_NAME_MAX_SIZE-1] = '\0';
-    param->useResume = useResume;
-    param->callback = actualCallback;
-    param->fileList = NULL;
     _ftp_status threadReturn = FTP_SUCCESS;
 
     vp_os_thread_create (thread_ftpGet, (THREAD_PARAMS)param, &getThread);
@@ -1473,6 +1701,102 @@ ftpGet (_ftp_t *ftp, const char *remoteName, const char *localName, int useResum
     return threadReturn;
 }
 
+_ftp_status
+ftpGetQueue (_ftp_t *ftp, _ftp_get_item *items, int nbItems, int nbConnections, int useResume, ftp_callback callback)
+{
+    if (NULL == ftp || NULL == items)
+    {
+        FTP_ERROR ("FTP not open or no items\n");
+        return FTP_FAIL;
+    }
+    if (1 == ftp->opInProgress)
+    {
+        return FTP_BUSY;
+    }
+
+    int i;
+    for (i = 0; i < nbItems; i++)
+    {
+        items [i].status = FTP_ABORT; // Until started
+    }
+    if (nbConnections > nbItems)
+    {
+        nbConnections = nbItems;
+    }
+    if (nbConnections > FTP_QUEUE_MAX_CONNECTIONS)
+    {
+        nbConnections = FTP_QUEUE_MAX_CONNECTIONS;
+    }
+
+    _ftp_queue *queue = vp_os_calloc (1, sizeof (_ftp_queue));
+    if (NULL == queue)
+    {
+        FTP_ERROR ("Unable to allocate queue\n");
+        return FTP_FAIL;
+    }
+    vp_os_mutex_init (&queue->mutex);
+    queue->items = items;
+    queue->nbItems = nbItems;
+    queue->useResume = useResume;
+    queue->callback = callback;
+    queue->workers [0].queue = queue;
+    queue->workers [0].ftp = ftp;
+    queue->nbWorkers = 1;
+
+    if (1 < nbConnections)
+    {
+        // Other connections go to the PWD of ftp
+        char workingDir [FILE_NAME_MAX_SIZE] = {0};
+        if (FTP_SUCCEDED (ftpPwd (ftp, workingDir, FILE_NAME_MAX_SIZE-1)))
+        {
+            while (queue->nbWorkers < nbConnections)
+            {
+                _ftp_status status;
+                _ftp_t *other = ftpConnect (ftp->socket->serverHost, ftp->socket->port, ftp->username, ftp->password, &status);
+                if (NULL == other)
+                {
+                    break;
+                }
+                if (FTP_FAILED (ftpCd (other, workingDir)))
+                {
+                    ftpClose (&other);
+                    break;
+                }
+                queue->workers [queue->nbWorkers].queue = queue;
+                queue->workers [queue->nbWorkers].ftp = other;
+                queue->nbWorkers++;
+            }
+        }
+    }
+    FTP_DEBUG ("Getting %d files with %d connections\n", nbItems, queue->nbWorkers);
+
+    for (i = 0; i < queue->nbWorkers; i++)
+    {
+        vp_os_thread_create (thread_ftpGetQueue, (THREAD_PARAMS)&queue->workers [i], &queue->workers [i].thread);
+    }
+    for (i = 0; i < queue->nbWorkers; i++)
+    {
+        vp_os_thread_join (queue->workers [i].thread);
+    }
+    for (i = 1; i < queue->nbWorkers; i++)
+    {
+        ftpClose (&queue->workers [i].ftp);
+    }
+
+    _ftp_status retVal = (0 == queue->aborted) ? FTP_SUCCESS : FTP_ABORT;
+    for (i = 0; i < nbItems && FTP_SUCCESS == retVal; i++)
+    {
+        if (! FTP_SUCCEDED (items [i].status))
+        {
+            retVal = items [i].status;
+        }
+    }
+
+    vp_os_mutex_destroy (&queue->mutex);
+    vp_os_free (queue);
+    return retVal;
+}
+
 _ftp_status
 ftpList (_ftp_t *ftp, char **fileList,  ftp_callback callback)
 {
@@ -10,6 +10,16 @@
 
 #include <VP_Com/vp_com_socket.h>
 
+/**
+ * Size of the login strings kept by a FTP structure
+ */
+#define FTP_LOGIN_MAX_SIZE 64
+
+/**
+ * Maximum number of connections used by ftpGetQueue
+ */
+#define FTP_QUEUE_MAX_CONNECTIONS 4
+
 /**
  * Enum type for ftp function return/error codes
  */
@@ -62,8 +72,22 @@ typedef struct _ftp_s
   _ftp_status lastStatus;
   char *lastFileList;
   void * tag; // Allows to put any pointer to some useful data that is associated with this ftp connectionS
+  char username[FTP_LOGIN_MAX_SIZE]; // Login, used to open other connections to the same server (ftpGetQueue)
+  char password[FTP_LOGIN_MAX_SIZE];
+  int dataPipe[2]; // Pipe used to splice the data socket into the local file, kept from one ftpGet to the next
 } _ftp_t;
 
+/**
+ * File of a ftpGetQueue call
+ */
+typedef struct _ftp_get_item_s
+{
+  const char *remoteName; // Name of the file on the server (in PWD of the ftp passed to ftpGetQueue)
+  const char *localName; // Name of the file on the local filesystem
+  _ftp_status status; // Result of the transfert, set by ftpGetQueue
+  void *tag; // Free for the caller
+} _ftp_get_item;
+
 /**
  * Last error message from ardrone_ftp lib
  * (Useful when FTP_PRINT_ERROR is defined to 0 in ardrone_ftp.c)
@@ -75,6 +99,7 @@ extern char *FTPlastErrorMessage;
  * The callback may be called several times with "FTP_PROGRESS" as the status
  * But only once with any other status.
  * @param arg for ftpList : char *pointer to list string (or NULL in case of failure), for ftpGet/ftpPut, float *pointer to progression if status is FTP_PROGRESS, NULL otherwise
+ * For ftpGetQueue, arg is a _ftp_get_item *pointer to the item which is over, and callingFtp the connection used for it
  */
 typedef void (*ftp_callback)(_ftp_status status, void *arg, _ftp_t *callingFtp);
 
@@ -149,6 +174,22 @@ _ftp_status ftpPut (_ftp_t *ftp, const char *localName, const char *remoteName,
  */
 _ftp_status ftpGet (_ftp_t *ftp, const char *remoteName, const char *localName, int useResume, ftp_callback callback);
 
+/**
+ * @brief Get a queue of files from a connected FTP server, several files at once
+ * @param ftp A pointer to a connected (created by ftpConnect) FTP server. Files are downloaded from its PWD.
+ * @param items Files to get. The status of each item is set when its transfert is over. Must not be NULL.
+ * @param nbItems Number of items
+ * @param nbConnections Number of files transfered at once (1 to FTP_QUEUE_MAX_CONNECTIONS). The control connection of ftp is one of them, the others are opened with the same login and PWD, and closed before return. If one of them can't be opened, less connections are used.
+ * @param useResume Flag for using or not the transfert resume function (see ftpGet).
+ * @param callback Called once for each item, when its transfert is over, with the item status and a pointer to the item as arg. Calls are not concurrent, but they are done from the transfert threads. May be NULL.
+ * @return This function does not return before all items are done. The return values can be :
+ * @return  - FTP_SUCCESS : All items succeeded (FTP_SUCCESS or FTP_SAMESIZE)
+ * @return  - FTP_BUSY : An operation is already in progress for this FTP connexion.
+ * @return  - FTP_ABORT : ftpAbort was called on ftp during the transfert of an item. Items not started are left with FTP_ABORT.
+ * @return  - Other : Status of the first item which failed (see ftpGet). The other items are still transfered.
+ */
+_ftp_status ftpGetQueue (_ftp_t *ftp, _ftp_get_item *items, int nbItems, int nbConnections, int useResume, ftp_callback callback);
+
 /**
  * @brief Get a list of the current directory on a connected FTP server
  * @param ftp A pointer to a connected (created by ftpConnect) FTP server.
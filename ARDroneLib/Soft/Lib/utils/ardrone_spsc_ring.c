@@ -0,0 +1,81 @@
+#include <VP_Os/vp_os_malloc.h>
+
+#include <utils/ardrone_spsc_ring.h>
+
+C_RESULT ardrone_spsc_ring_init(ardrone_spsc_ring_t* ring, uint32_t size)
+{
+  uint32_t real_size = 1;
+
+  while( real_size < size )
+    real_size <<= 1;
+
+  ring->buffer = (uint8_t*) vp_os_malloc( real_size );
+  ring->size   = (ring->buffer != NULL) ? real_size : 0;
+  ring->head   = 0;
+  ring->tail   = 0;
+
+  return (ring->buffer != NULL) ? C_OK : C_FAIL;
+}
+
+void ardrone_spsc_ring_release(ardrone_spsc_ring_t* ring)
+{
+  vp_os_free( ring->buffer );
+  ring->buffer = NULL;
+  ring->size   = 0;
+  ring->head   = 0;
+  ring->tail   = 0;
+}
+
+bool_t ardrone_spsc_ring_push(ardrone_spsc_ring_t* ring, const void* data, uint32_t size)
+{
+  uint32_t head  = ring->head;
+  uint32_t tail  = ring->tail;
+  uint32_t index = head & (ring->size - 1);
+  uint32_t first;
+
+  if( size > ring->size - (head - tail) )
+    return FALSE;
+
+  // Copy up to the end of the buffer, then wrap
+  first = ring->size - index;
+  if( first > size )
+    first = size;
+  vp_os_memcpy( &ring->buffer[index], data, first );
+  vp_os_memcpy( &ring->buffer[0], (const uint8_t*)data + first, size - first );
+
+  // Data must be visible before the consumer sees the new head
+  ARDRONE_SPSC_BARRIER();
+  ring->head = head + size;
+
+  return TRUE;
+}
+
+uint32_t ardrone_spsc_ring_peek(ardrone_spsc_ring_t* ring, const uint8_t** data)
+{
+  uint32_t head  = ring->head;
+  uint32_t tail  = ring->tail;
+  uint32_t index = tail & (ring->size - 1);
+  uint32_t available = head - tail;
+
+  // Do not read the data before the head which published them
+  ARDRONE_SPSC_BARRIER();
+
+  if( available > ring->size - index )
+    available = ring->size - index;
+
+  *data = &ring->buffer[index];
+
+  return available;
+}
+
+void ardrone_spsc_ring_consume(ardrone_spsc_ring_t* ring, uint32_t size)
+{
+  // Data must be read before the producer can overwrite them
+  ARDRONE_SPSC_BARRIER();
+  ring->tail += size;
+}
+
+uint32_t ardrone_spsc_ring_used(const ardrone_spsc_ring_t* ring)
+{
+  return ring->head - ring->tail;
+}
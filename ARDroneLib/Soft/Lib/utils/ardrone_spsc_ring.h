@@ -0,0 +1,58 @@
+/**
+ * @file ardrone_spsc_ring.h
+ * @brief Lock-free byte ring buffer for one producer thread and one consumer thread.
+ *
+ * The producer only writes the head index and the consumer only writes the
+ * tail index, so no mutex is needed : a memory barrier orders the data copy
+ * with the publication of the index.
+ */
+
+#ifndef _ARDRONE_SPSC_RING_H_
+#define _ARDRONE_SPSC_RING_H_
+
+#include <VP_Os/vp_os_types.h>
+
+#if defined(_WIN32)
+  #include <windows.h>
+  #define ARDRONE_SPSC_BARRIER() MemoryBarrier()
+#else
+  #define ARDRONE_SPSC_BARRIER() __sync_synchronize()
+#endif
+
+typedef struct _ardrone_spsc_ring_t
+{
+  uint8_t*          buffer;
+  uint32_t          size;     /* Power of two */
+  volatile uint32_t head;     /* Free running write index, written by the producer only */
+  volatile uint32_t tail;     /* Free running read index, written by the consumer only */
+} ardrone_spsc_ring_t;
+
+/**
+ * Allocate the ring. size is rounded up to the next power of two.
+ */
+C_RESULT ardrone_spsc_ring_init(ardrone_spsc_ring_t* ring, uint32_t size);
+void     ardrone_spsc_ring_release(ardrone_spsc_ring_t* ring);
+
+/**
+ * Producer side : copy size bytes in the ring.
+ * @return FALSE (and copy nothing) if there is not enough free space
+ */
+bool_t   ardrone_spsc_ring_push(ardrone_spsc_ring_t* ring, const void* data, uint32_t size);
+
+/**
+ * Consumer side : get the contiguous readable bytes at the tail of the ring.
+ * @return Number of bytes available at *data (0 if the ring is empty)
+ */
+uint32_t ardrone_spsc_ring_peek(ardrone_spsc_ring_t* ring, const uint8_t** data);
+
+/**
+ * Consumer side : release size bytes previously returned by ardrone_spsc_ring_peek
+ */
+void     ardrone_spsc_ring_consume(ardrone_spsc_ring_t* ring, uint32_t size);
+
+/**
+ * Number of bytes waiting in the ring. Exact only when called from the producer or the consumer.
+ */
+uint32_t ardrone_spsc_ring_used(const ardrone_spsc_ring_t* ring);
+
+#endif // _ARDRONE_SPSC_RING_H_
@@ -307,8 +307,9 @@ C_RESULT p264_unpack_controller( video_controller_t* controller )
         // new picture
         p264_read_picture_layer( controller, stream );
 
+            // controller->picture_type is still the one of the previous picture
             if (((controller->num_frames == (last_frame_decoded + 1)) && (controller->last_frame_decoded == TRUE))
-                || (controller->picture_type == VIDEO_PICTURE_INTRA))
+                || (picture_layer->picture_type == VIDEO_PICTURE_INTRA))
             {
                 // new picture is decodable because it's an I frame or previous frame was decodable
                 controller->last_frame_decoded = TRUE;
@@ -350,7 +351,8 @@ C_RESULT p264_encode_blockline( video_controller_t* controller, const vp_api_pic
 
   if( stream->used*2 >= stream->size )
   {
-    uint32_t add = 32 - clz(stream->used/controller->blockline);      // estimate the log2 size of a blockline in the stream
+    // controller->blockline is still the last blockline written : 0 when the first one filled half of the stream
+    uint32_t add = 32 - clz(stream->used/(controller->blockline+1));  // estimate the log2 size of a blockline in the stream
     add = 1<<(add+1);                           // major and compute addition buffer size
     stream->bytes = vp_os_realloc( stream->bytes, stream->size + add ); // Add some byte to internal stream
     stream->size += add;
@@ -404,11 +406,11 @@ C_RESULT p264_encode_blockline( video_controller_t* controller, const vp_api_pic
 
   if (blockline->blockline == 0)
     // TODO: next line is possible only when full frame is available (i.e. blokline mode not enabled). should not assume that.
-    video_p264_encode_MB(controller->mb_blockline*controller->num_blockline,macroblock, gobs->quant);
+    video_p264_encode_MB(controller,controller->mb_blockline*controller->num_blockline,macroblock, gobs->quant);
 
   while (num_macro_blocks)
   {
-    int32_t num_mb_ready = video_p264_get_encoded_MB(num_macro_blocks,macroblock);
+    int32_t num_mb_ready = video_p264_get_encoded_MB(controller,num_macro_blocks,macroblock);
     if (num_mb_ready>0)
     {
       num_macro_blocks -= num_mb_ready;
@@ -464,8 +466,14 @@ C_RESULT p264_encode_blockline( video_controller_t* controller, const vp_api_pic
       }
     }
   }
+#ifdef HAS_P264_X86_ENCODER
+  else if ((controller->blockline+1) == controller->num_blockline)
+    // whole frame is encoded by video_p264_encode_MB with the quant of the first blockline, only change it between frames
+    controller->quant= P264_DEFAULT_QUANTIZATION;
+#else
   else
     controller->quant= P264_DEFAULT_QUANTIZATION;
+#endif
 
   RTMON_USTOP(VIDEO_VLIB_PACKET);
   ///<
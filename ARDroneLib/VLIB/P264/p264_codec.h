@@ -18,6 +18,7 @@ typedef struct _p264_codec_t {
   uint32_t         ip_counter;       // counter used to switch between P&I frames
   uint32_t         last_I_size;
   uint32_t         last_P_size;
+  void*            encoder;          // software encoder state of the platform (see video_p264_x86_init), NULL otherwise
 } p264_codec_t;
 
 void p264_codec_alloc( video_controller_t* controller );
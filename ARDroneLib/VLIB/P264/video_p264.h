@@ -7,10 +7,10 @@
 C_RESULT video_p264_prepare_slice ( video_controller_t* controller, const vp_api_picture_t* blockline);
 
 // encode num_macro_blocks MB
-C_RESULT video_p264_encode_MB(uint32_t num_macro_blocks, video_macroblock_t* next_macroblock ,int32_t qp);
+C_RESULT video_p264_encode_MB(video_controller_t* controller, uint32_t num_macro_blocks, video_macroblock_t* next_macroblock ,int32_t qp);
 
 // get encoded num_macro_blocks MB
-int32_t video_p264_get_encoded_MB(uint32_t num_macro_blocks, video_macroblock_t* next_macroblock);
+int32_t video_p264_get_encoded_MB(video_controller_t* controller, uint32_t num_macro_blocks, video_macroblock_t* next_macroblock);
 
 
 // inter decoding functions
@@ -167,7 +167,7 @@ void P6_get_MV (MV_XY_t *mv,uint32_t num_mv, uint32_t* raw_mv_tab)
 
 
 // encode num_macro_blocks MB
-C_RESULT video_p264_encode_MB(uint32_t num_macro_blocks, video_macroblock_t* macroblock ,int32_t qp)
+C_RESULT video_p264_encode_MB(video_controller_t* controller, uint32_t num_macro_blocks, video_macroblock_t* macroblock ,int32_t qp)
 {
   if (num_macro_blocks > 0)
   {
@@ -193,7 +193,7 @@ C_RESULT video_p264_encode_MB(uint32_t num_macro_blocks, video_macroblock_t* mac
 }
 
 // get encoded num_macro_blocks MB
-int32_t video_p264_get_encoded_MB(uint32_t num_macro_blocks, video_macroblock_t* macroblock)
+int32_t video_p264_get_encoded_MB(video_controller_t* controller, uint32_t num_macro_blocks, video_macroblock_t* macroblock)
 {
   // retrieve and process available MBs
   if (num_macro_blocks > 0)
@@ -0,0 +1,1068 @@
+#include <VLIB/Platform/video_utils.h>
+
+#ifdef HAS_P264_FTRANSFORM
+
+#include "video_p264_x86.h"
+#include <VLIB/P264/video_p264.h>
+#include <VLIB/P264/p264_codec.h>
+#include <VLIB/P264/p264_common.h>
+#include <VLIB/P264/p264_intra_pred.h>
+#include <VLIB/P264/p264_inter_mc.h>
+#include <VLIB/P264/p264_transform.h>
+#include <VLIB/P264/p264_Qp.h>
+#include <VLIB/P264/p264_zigzag.h>
+#include <VLIB/P264/p264_merge.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_signal.h>
+#include <VP_Os/vp_os_thread.h>
+#include <VP_Os/vp_os_print.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//#define H264_X86_DEBUG
+
+// motion vectors are kept in [-P264_X86_MV_MAX, P264_X86_MV_MAX] so that their difference to the prediction fits on 8 bits
+#define P264_X86_MV_MAX 63
+
+// real modes and vector of a macroblock. video_macroblock_t holds the coded ones (see p264_write_mb_layer)
+typedef struct _video_p264_x86_mb_t {
+  intra_4x4_mode_t intra_4x4_mode[BLOCK_SIZE2];
+  MV_XY_t mv;
+} video_p264_x86_mb_t;
+
+// encoder of one P264 controller, kept in p264_codec_t.encoder
+typedef struct _video_p264_x86_t {
+  // h264 picture parameters
+  uint32_t width;
+  uint32_t height;
+  uint32_t mb_width;
+  uint32_t mb_height;
+  const uint8_t* src_Y;
+  const uint8_t* src_Cb;
+  const uint8_t* src_Cr;
+  int32_t src_Y_linesize;
+  int32_t src_C_linesize;
+  bool_t I_encoding;
+  uint32_t qp;
+  uint32_t lambda;
+
+  uint8_t* rec_frame; // frame decoded by encoder, YUV 4:2:0 with linesize = width
+  uint8_t* ref_frame; // previous rec_frame
+  video_macroblock_t* macroblocks;
+  video_p264_x86_mb_t* mbs;
+
+  // macroblock rows of the frame being encoded
+  int32_t* row_progress; // number of encoded MB per row
+  int32_t num_rows;
+  int32_t next_row;
+  int32_t rows_done;
+
+  // encoding threads
+  volatile bool_t running;
+  THREAD_HANDLE threads[P264_X86_NUM_THREADS];
+  vp_os_mutex_t mutex;
+  vp_os_cond_t cond;
+} video_p264_x86_t;
+
+// forward quantization multipliers (2^15 / (Qstep * Si)), positions (0,0) (1,1) others
+static const int32_t quant_mf[6][3] = {
+  {13107, 5243, 8066},
+  {11916, 4660, 7490},
+  {10082, 4194, 6554},
+  { 9362, 3647, 5825},
+  { 8192, 3355, 5243},
+  { 7282, 2893, 4559}
+};
+
+// quant_mf column of each raster position of a 4x4 block
+static const uint8_t quant_pos[BLOCK_SIZE2] = {
+  0, 2, 0, 2,
+  2, 1, 2, 1,
+  0, 2, 0, 2,
+  2, 1, 2, 1
+};
+
+// mode decision lagrangian (0.85 * 2^((qp-12)/6))
+static const uint8_t lambda_table[52] = {
+   1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+   1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  3,  3,
+   3,  4,  4,  5,  5,  6,  7,  8,  9, 10, 11, 12,
+  14, 15, 17, 19, 22, 24, 27, 31, 34, 38, 43, 48,
+  54, 61, 69, 77
+};
+
+// block_4x4 decoding order (pixels)
+static const uint8_t block_4x4_order[BLOCK_SIZE2][2] = {
+{0,0},{4,0},{0,4},{4,4},
+{8,0},{12,0},{8,4},{12,4},
+{0,8},{4,8},{0,12},{4,12},
+{8,8},{12,8},{8,12},{12,12}
+};
+
+// block_4x4 decoding index of block (x/4,y/4)
+static const uint8_t block_4x4_index[4][4] = {
+{ 0, 1, 4, 5},
+{ 2, 3, 6, 7},
+{ 8, 9,12,13},
+{10,11,14,15}
+};
+
+#define P264_X86_ABS(a) ((a)<0?-(a):(a))
+#define P264_X86_MIN(a,b) ((a)<(b)?(a):(b))
+#define P264_X86_MAX(a,b) ((a)>(b)?(a):(b))
+
+////////////// SAD ////////////////
+
+uint32_t video_p264_x86_sad_16x16(const uint8_t* a, int32_t a_stride, const uint8_t* b, int32_t b_stride)
+{
+#if defined(__AVX2__)
+  // two lines per iteration
+  __m256i sum = _mm256_setzero_si256();
+  __m256i va, vb;
+  __m128i s;
+  uint32_t i;
+  for (i=0;i<8;i++)
+  {
+    va = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)a)), _mm_loadu_si128((const __m128i*)(a+a_stride)), 1);
+    vb = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)b)), _mm_loadu_si128((const __m128i*)(b+b_stride)), 1);
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(va, vb));
+    a += a_stride<<1;
+    b += b_stride<<1;
+  }
+  s = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  s = _mm_add_epi64(s, _mm_unpackhi_epi64(s, s));
+  return (uint32_t)_mm_cvtsi128_si32(s);
+#elif defined(__SSE2__)
+  __m128i sum = _mm_setzero_si128();
+  uint32_t i;
+  for (i=0;i<16;i++)
+  {
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)a), _mm_loadu_si128((const __m128i*)b)));
+    a += a_stride;
+    b += b_stride;
+  }
+  sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+  return (uint32_t)_mm_cvtsi128_si32(sum);
+#else
+  uint32_t sad = 0;
+  uint32_t i,j;
+  for (j=0;j<16;j++)
+  {
+    for (i=0;i<16;i++)
+      sad += P264_X86_ABS((int32_t)a[i]-(int32_t)b[i]);
+    a += a_stride;
+    b += b_stride;
+  }
+  return sad;
+#endif
+}
+
+uint32_t video_p264_x86_sad_8x8(const uint8_t* a, int32_t a_stride, const uint8_t* b, int32_t b_stride)
+{
+#if defined(__SSE2__)
+  // two lines per iteration
+  __m128i sum = _mm_setzero_si128();
+  __m128i va, vb;
+  uint32_t i;
+  for (i=0;i<4;i++)
+  {
+    va = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)a), _mm_loadl_epi64((const __m128i*)(a+a_stride)));
+    vb = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)b), _mm_loadl_epi64((const __m128i*)(b+b_stride)));
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(va, vb));
+    a += a_stride<<1;
+    b += b_stride<<1;
+  }
+  sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+  return (uint32_t)_mm_cvtsi128_si32(sum);
+#else
+  uint32_t sad = 0;
+  uint32_t i,j;
+  for (j=0;j<8;j++)
+  {
+    for (i=0;i<8;i++)
+      sad += P264_X86_ABS((int32_t)a[i]-(int32_t)b[i]);
+    a += a_stride;
+    b += b_stride;
+  }
+  return sad;
+#endif
+}
+
+uint32_t video_p264_x86_sad_4x4(const uint8_t* a, int32_t a_stride, const uint8_t* b, int32_t b_stride)
+{
+  uint32_t sad = 0;
+  uint32_t j;
+  for (j=0;j<4;j++)
+  {
+    sad += P264_X86_ABS((int32_t)a[0]-(int32_t)b[0]);
+    sad += P264_X86_ABS((int32_t)a[1]-(int32_t)b[1]);
+    sad += P264_X86_ABS((int32_t)a[2]-(int32_t)b[2]);
+    sad += P264_X86_ABS((int32_t)a[3]-(int32_t)b[3]);
+    a += a_stride;
+    b += b_stride;
+  }
+  return sad;
+}
+
+////////////// transform and quantization ////////////////
+
+// forward core transform of the (src - pred) 4x4 residual, raster order output
+static void p264_x86_forward_4x4(const uint8_t* src, int32_t src_stride, const uint8_t* pred, int32_t pred_stride, int32_t* out)
+{
+  int32_t tmp[BLOCK_SIZE2];
+  int32_t d0,d1,d2,d3;
+  int32_t s03,d03,s12,d12;
+  uint32_t i;
+
+  // Horizontal
+  for (i=0;i<4;i++)
+  {
+    d0 = (int32_t)src[0] - (int32_t)pred[0];
+    d1 = (int32_t)src[1] - (int32_t)pred[1];
+    d2 = (int32_t)src[2] - (int32_t)pred[2];
+    d3 = (int32_t)src[3] - (int32_t)pred[3];
+
+    s03 = d0 + d3;
+    d03 = d0 - d3;
+    s12 = d1 + d2;
+    d12 = d1 - d2;
+
+    tmp[(i<<2)]   = s03 + s12;
+    tmp[(i<<2)+1] = (d03<<1) + d12;
+    tmp[(i<<2)+2] = s03 - s12;
+    tmp[(i<<2)+3] = d03 - (d12<<1);
+
+    src += src_stride;
+    pred += pred_stride;
+  }
+
+  // Vertical
+  for (i=0;i<4;i++)
+  {
+    s03 = tmp[i] + tmp[12+i];
+    d03 = tmp[i] - tmp[12+i];
+    s12 = tmp[4+i] + tmp[8+i];
+    d12 = tmp[4+i] - tmp[8+i];
+
+    out[i]    = s03 + s12;
+    out[4+i]  = (d03<<1) + d12;
+    out[8+i]  = s03 - s12;
+    out[12+i] = d03 - (d12<<1);
+  }
+}
+
+// quantize a transformed block, zigzag order output (the layout read by zagzig_4x4)
+static void p264_x86_quant_4x4(const int32_t* coeff, int16_t* AC, uint32_t qp, bool_t intra)
+{
+  const int32_t* mf = quant_mf[qp%6];
+  uint32_t qbits = 15 + qp/6;
+  int32_t f = (1<<qbits) / (intra == TRUE ? 3 : 6);
+  int32_t c, level;
+  uint32_t i;
+
+  for (i=0;i<BLOCK_SIZE2;i++)
+  {
+    c = coeff[video_zztable_t41[i]];
+    level = (P264_X86_ABS(c)*mf[quant_pos[video_zztable_t41[i]]] + f) >> qbits;
+    AC[i] = (int16_t)(c < 0 ? -level : level);
+  }
+}
+
+// quantize a hadamard transformed DC coefficient, extra_shift is 1 for chroma DC, 2 for luma DC (hadamard output halved)
+static int16_t p264_x86_quant_dc(int32_t coeff, uint32_t qp, bool_t intra, uint32_t extra_shift)
+{
+  uint32_t qbits = 15 + qp/6;
+  int32_t f = (1<<qbits) / (intra == TRUE ? 3 : 6);
+  int32_t level;
+
+  level = (P264_X86_ABS(coeff)*quant_mf[qp%6][0] + (f<<extra_shift)) >> (qbits+extra_shift);
+  return (int16_t)(coeff < 0 ? -level : level);
+}
+
+// p264_ihadamard_4x4 on 32 bits (16 luma DC of a MB overflow int16_t)
+static void p264_x86_hadamard_4x4(const int32_t* in, int32_t* out)
+{
+  int32_t tmp[BLOCK_SIZE2];
+  int32_t p0,p1,p2,p3;
+  uint32_t i;
+
+  for (i=0;i<4;i++)
+  {
+    p0 = in[(i<<2)] + in[(i<<2)+2];
+    p1 = in[(i<<2)] - in[(i<<2)+2];
+    p2 = in[(i<<2)+1] - in[(i<<2)+3];
+    p3 = in[(i<<2)+1] + in[(i<<2)+3];
+
+    tmp[(i<<2)]   = p0 + p3;
+    tmp[(i<<2)+1] = p1 + p2;
+    tmp[(i<<2)+2] = p1 - p2;
+    tmp[(i<<2)+3] = p0 - p3;
+  }
+
+  for (i=0;i<4;i++)
+  {
+    p0 = tmp[i] + tmp[8+i];
+    p1 = tmp[i] - tmp[8+i];
+    p2 = tmp[4+i] - tmp[12+i];
+    p3 = tmp[4+i] + tmp[12+i];
+
+    out[i]    = p0 + p3;
+    out[4+i]  = p1 + p2;
+    out[8+i]  = p1 - p2;
+    out[12+i] = p0 - p3;
+  }
+}
+
+// 16 luma 4x4 blocks of an intra 16x16 MB, prediction is already in pred
+static void p264_x86_encode_luma_16x16(const uint8_t* src, int32_t src_stride, const uint8_t* pred, int32_t pred_stride, int16_t* DC, int16_t* AC, uint32_t qp)
+{
+  int32_t coeff[BLOCK_SIZE2];
+  int32_t dc[BLOCK_SIZE2];
+  int32_t hadamard_dc[BLOCK_SIZE2];
+  uint32_t x,y,i;
+
+  for (i=0;i<BLOCK_SIZE2;i++)
+  {
+    x = block_4x4_order[i][0];
+    y = block_4x4_order[i][1];
+    p264_x86_forward_4x4(src+y*src_stride+x, src_stride, pred+y*pred_stride+x, pred_stride, coeff);
+    dc[y + (x>>2)] = coeff[0];
+    p264_x86_quant_4x4(coeff, AC, qp, TRUE);
+    AC[0] = 0;
+    AC += BLOCK_SIZE2;
+  }
+
+  p264_x86_hadamard_4x4(dc, hadamard_dc);
+  for (i=0;i<BLOCK_SIZE2;i++)
+    DC[i] = p264_x86_quant_dc(hadamard_dc[i], qp, TRUE, 2);
+}
+
+// 4 chroma 4x4 blocks of a MB, prediction is already in pred
+static void p264_x86_encode_chroma_8x8(const uint8_t* src, int32_t src_stride, const uint8_t* pred, int32_t pred_stride, int16_t* DC, int16_t* AC, uint32_t qp, bool_t intra)
+{
+  int32_t coeff[BLOCK_SIZE2];
+  int32_t dc[4];
+  uint32_t x,y,i;
+
+  for (i=0;i<4;i++)
+  {
+    x = (i&1)<<2;
+    y = (i&2)<<1;
+    p264_x86_forward_4x4(src+y*src_stride+x, src_stride, pred+y*pred_stride+x, pred_stride, coeff);
+    dc[i] = coeff[0];
+    p264_x86_quant_4x4(coeff, AC, qp, intra);
+    AC[0] = 0;
+    AC += BLOCK_SIZE2;
+  }
+
+  // same layout as p264_hadamard_2x2
+  DC[0] = p264_x86_quant_dc(dc[0] + dc[1] + dc[2] + dc[3], qp, intra, 1);
+  DC[1] = p264_x86_quant_dc(dc[0] - dc[1] + dc[2] - dc[3], qp, intra, 1);
+  DC[2] = p264_x86_quant_dc(dc[0] + dc[1] - dc[2] - dc[3], qp, intra, 1);
+  DC[3] = p264_x86_quant_dc(dc[0] - dc[1] - dc[2] + dc[3], qp, intra, 1);
+}
+
+////////////// mode prediction ////////////////
+
+// intra 4x4 mode prediction of p264_read_intra_4x4 computed on the real modes
+static intra_4x4_mode_t p264_x86_predicted_4x4_mode(video_p264_x86_t* enc, uint32_t mb_index, uint32_t block, const intra_4x4_mode_t* current)
+{
+  uint32_t bx = block_4x4_order[block][0]>>2;
+  uint32_t by = block_4x4_order[block][1]>>2;
+  uint32_t mb_x = mb_index % enc->mb_width;
+  uint32_t mb_y = mb_index / enc->mb_width;
+  intra_4x4_mode_t left_mode, up_mode;
+  uint32_t neighbour;
+
+  if ((bx == 0 && mb_x == 0) || (by == 0 && mb_y == 0))
+    return DC_4x4_MODE;
+
+  if (bx > 0)
+    left_mode = current[block_4x4_index[by][bx-1]];
+  else
+  {
+    neighbour = mb_index - 1;
+    if (enc->macroblocks[neighbour].intra_type == INTRA_4x4)
+      left_mode = enc->mbs[neighbour].intra_4x4_mode[block_4x4_index[by][3]];
+    else
+      left_mode = DC_4x4_MODE;
+  }
+
+  if (by > 0)
+    up_mode = current[block_4x4_index[by-1][bx]];
+  else
+  {
+    neighbour = mb_index - enc->mb_width;
+    if (enc->macroblocks[neighbour].intra_type == INTRA_4x4)
+      up_mode = enc->mbs[neighbour].intra_4x4_mode[block_4x4_index[3][bx]];
+    else
+      up_mode = DC_4x4_MODE;
+  }
+
+  return P264_X86_MIN(left_mode, up_mode);
+}
+
+// motion vector prediction of p264_read_mv computed on the real vectors
+static void p264_x86_predicted_mv(video_p264_x86_t* enc, uint32_t mb_index, int32_t* pred_x, int32_t* pred_y)
+{
+  uint32_t mb_x = mb_index % enc->mb_width;
+  uint32_t mb_y = mb_index / enc->mb_width;
+  video_p264_x86_mb_t* mbs = enc->mbs;
+  int32_t ax,ay,bx,by,cx,cy;
+
+  if (mb_y == 0)
+  {
+    *pred_x = (mb_x == 0) ? 0 : mbs[mb_index-1].mv.x;
+    *pred_y = (mb_x == 0) ? 0 : mbs[mb_index-1].mv.y;
+    return;
+  }
+
+  bx = mbs[mb_index-enc->mb_width].mv.x;
+  by = mbs[mb_index-enc->mb_width].mv.y;
+  if (mb_x == 0)
+  {
+    ax = 0;
+    ay = 0;
+    cx = mbs[mb_index-enc->mb_width+1].mv.x;
+    cy = mbs[mb_index-enc->mb_width+1].mv.y;
+  }
+  else if (mb_x == enc->mb_width-1)
+  {
+    ax = mbs[mb_index-1].mv.x;
+    ay = mbs[mb_index-1].mv.y;
+    cx = mbs[mb_index-enc->mb_width-1].mv.x; // in fact D
+    cy = mbs[mb_index-enc->mb_width-1].mv.y; // in fact D
+  }
+  else
+  {
+    ax = mbs[mb_index-1].mv.x;
+    ay = mbs[mb_index-1].mv.y;
+    cx = mbs[mb_index-enc->mb_width+1].mv.x;
+    cy = mbs[mb_index-enc->mb_width+1].mv.y;
+  }
+  *pred_x = ax + bx + cx - P264_X86_MIN(ax,P264_X86_MIN(bx,cx)) - P264_X86_MAX(ax,P264_X86_MAX(bx,cx));
+  *pred_y = ay + by + cy - P264_X86_MIN(ay,P264_X86_MIN(by,cy)) - P264_X86_MAX(ay,P264_X86_MAX(by,cy));
+}
+
+// write the coded modes/vector expected by p264_write_mb_layer
+static void p264_x86_code_MB(video_p264_x86_t* enc, uint32_t mb_index)
+{
+  video_macroblock_t* mb = &enc->macroblocks[mb_index];
+  video_p264_x86_mb_t* state = &enc->mbs[mb_index];
+  intra_4x4_mode_t pred, mode;
+  int32_t pred_x, pred_y;
+  uint32_t i;
+
+  if (enc->I_encoding == TRUE)
+  {
+    if (mb->intra_type == INTRA_4x4)
+    {
+      // [ pred (1bit) | code (3bits) ], see p264_write_intra_4x4
+      for (i=0;i<BLOCK_SIZE2;i++)
+      {
+        pred = p264_x86_predicted_4x4_mode(enc, mb_index, i, state->intra_4x4_mode);
+        mode = state->intra_4x4_mode[i];
+        if (mode == pred)
+          mb->intra_4x4_mode[i] = (intra_4x4_mode_t)0;
+        else
+          mb->intra_4x4_mode[i] = (intra_4x4_mode_t)(0x08 | (mode < pred ? mode : mode-1));
+      }
+    }
+  }
+  else
+  {
+    p264_x86_predicted_mv(enc, mb_index, &pred_x, &pred_y);
+    mb->inter_MV[0].x = (int8_t)(state->mv.x - pred_x);
+    mb->inter_MV[0].y = (int8_t)(state->mv.y - pred_y);
+  }
+}
+
+////////////// macroblock encoding ////////////////
+
+static bool_t p264_x86_intra_4x4_available(intra_4x4_mode_t mode, uint32_t x, uint32_t y)
+{
+  switch (mode)
+  {
+    case VERTICAL_4x4_MODE :
+    case DIAGONAL_DL_4x4_MODE :
+    case VERTICAL_LEFT_4x4_MODE :
+      return (y > 0);
+    case HORIZONTAL_4x4_MODE :
+    case HORIZONTAL_UP_4x4_MODE :
+      return (x > 0);
+    case DC_4x4_MODE :
+      return TRUE;
+    default :
+      return (x > 0 && y > 0);
+  }
+}
+
+// modes are ordered the same way for 16x16 luma and 8x8 chroma availability : DC, vertical (B), horizontal (A), plane (A&B)
+static bool_t p264_x86_intra_16x16_available(intra_16x16_luma_mode_t mode, uint32_t x, uint32_t y)
+{
+  switch (mode)
+  {
+    case VERTICAL_16x16_LUMA_MODE :
+      return (y > 0);
+    case HORIZONTAL_16x16_LUMA_MODE :
+      return (x > 0);
+    case DC_16x16_LUMA_MODE :
+      return TRUE;
+    default :
+      return (x > 0 && y > 0);
+  }
+}
+
+static bool_t p264_x86_intra_chroma_available(intra_8x8_chroma_mode_t mode, uint32_t x, uint32_t y)
+{
+  switch (mode)
+  {
+    case VERTICAL_8x8_CHROMA_MODE :
+      return (y > 0);
+    case HORIZONTAL_8x8_CHROMA_MODE :
+      return (x > 0);
+    case DC_8x8_CHROMA_MODE :
+      return TRUE;
+    default :
+      return (x > 0 && y > 0);
+  }
+}
+
+// choose, encode and reconstruct a 4x4 luma block, returns its cost
+static uint32_t p264_x86_encode_intra_4x4_block(video_p264_x86_t* enc, uint32_t x, uint32_t y, intra_4x4_mode_t pred_mode, intra_4x4_mode_t* mode_out, int16_t* AC)
+{
+  uint8_t* rec_Y = enc->rec_frame;
+  uint32_t linesize = enc->width;
+  const uint8_t* src = enc->src_Y + y*enc->src_Y_linesize + x;
+  uint8_t* pred = rec_Y + y*linesize + x;
+  int32_t coeff[BLOCK_SIZE2];
+  int16_t tmp_block_4x4[BLOCK_SIZE2];
+  int16_t itransform_block_4x4[BLOCK_SIZE2];
+  intra_4x4_mode_t mode, best_mode = DC_4x4_MODE, last_mode = DC_4x4_MODE;
+  uint32_t cost, best_cost = 0xFFFFFFFF;
+
+  for (mode=VERTICAL_4x4_MODE;mode<=HORIZONTAL_UP_4x4_MODE;mode++)
+  {
+    if (p264_x86_intra_4x4_available(mode, x, y) == FALSE)
+      continue;
+    p264_intra_4x4_luma(mode, rec_Y, enc->width, x, y, linesize);
+    last_mode = mode;
+    cost = video_p264_x86_sad_4x4(src, enc->src_Y_linesize, pred, linesize) + enc->lambda*(mode == pred_mode ? 1 : 4);
+    if (cost < best_cost)
+    {
+      best_cost = cost;
+      best_mode = mode;
+    }
+  }
+  if (best_mode != last_mode)
+    p264_intra_4x4_luma(best_mode, rec_Y, enc->width, x, y, linesize);
+
+  p264_x86_forward_4x4(src, enc->src_Y_linesize, pred, linesize, coeff);
+  p264_x86_quant_4x4(coeff, AC, enc->qp, TRUE);
+
+  // reconstruct as video_p264_decode_intra_luma_4x4_MB
+  zagzig_4x4(AC, tmp_block_4x4);
+  p264_4x4_residual_scale(tmp_block_4x4, tmp_block_4x4, enc->qp);
+  p264_inverse_4x4(tmp_block_4x4, itransform_block_4x4);
+  p264_merge_4x4(itransform_block_4x4, rec_Y, x, y, linesize);
+
+  *mode_out = best_mode;
+  return best_cost;
+}
+
+static void p264_x86_encode_intra_chroma(video_p264_x86_t* enc, uint32_t mb_x, uint32_t mb_y, video_macroblock_t* mb, int16_t* DC_U, int16_t* AC_U, int16_t* DC_V, int16_t* AC_V)
+{
+  uint32_t linesize = enc->width>>1;
+  uint8_t* rec_Cb = enc->rec_frame + enc->width*enc->height;
+  uint8_t* rec_Cr = rec_Cb + (enc->width*enc->height>>2);
+  uint32_t x = mb_x*MB_HEIGHT_C;
+  uint32_t y = mb_y*MB_HEIGHT_C;
+  const uint8_t* src_Cb = enc->src_Cb + y*enc->src_C_linesize + x;
+  const uint8_t* src_Cr = enc->src_Cr + y*enc->src_C_linesize + x;
+  intra_8x8_chroma_mode_t mode, best_mode = DC_8x8_CHROMA_MODE, last_mode = DC_8x8_CHROMA_MODE;
+  uint32_t cost, best_cost = 0xFFFFFFFF;
+
+  for (mode=DC_8x8_CHROMA_MODE;mode<=PLANE_8x8_CHROMA_MODE;mode++)
+  {
+    if (p264_x86_intra_chroma_available(mode, x, y) == FALSE)
+      continue;
+    p264_intra_8x8_chroma(mode, rec_Cb, x, y, linesize);
+    p264_intra_8x8_chroma(mode, rec_Cr, x, y, linesize);
+    last_mode = mode;
+    cost = video_p264_x86_sad_8x8(src_Cb, enc->src_C_linesize, rec_Cb+y*linesize+x, linesize) +
+           video_p264_x86_sad_8x8(src_Cr, enc->src_C_linesize, rec_Cr+y*linesize+x, linesize);
+    if (cost < best_cost)
+    {
+      best_cost = cost;
+      best_mode = mode;
+    }
+  }
+  if (best_mode != last_mode)
+  {
+    p264_intra_8x8_chroma(best_mode, rec_Cb, x, y, linesize);
+    p264_intra_8x8_chroma(best_mode, rec_Cr, x, y, linesize);
+  }
+  mb->intra_chroma_8x8_mode = best_mode;
+
+  p264_x86_encode_chroma_8x8(src_Cb, enc->src_C_linesize, rec_Cb+y*linesize+x, linesize, DC_U, AC_U, enc->qp, TRUE);
+  p264_x86_encode_chroma_8x8(src_Cr, enc->src_C_linesize, rec_Cr+y*linesize+x, linesize, DC_V, AC_V, enc->qp, TRUE);
+
+  video_p264_decode_intra_chroma_8x8_MB(DC_U, AC_U, rec_Cb, x, y, linesize, best_mode, enc->qp);
+  video_p264_decode_intra_chroma_8x8_MB(DC_V, AC_V, rec_Cr, x, y, linesize, best_mode, enc->qp);
+}
+
+static void p264_x86_encode_intra_MB(video_p264_x86_t* enc, uint32_t mb_index)
+{
+  video_macroblock_t* mb = &enc->macroblocks[mb_index];
+  video_p264_x86_mb_t* state = &enc->mbs[mb_index];
+  MB_p264_t* data = (MB_p264_t*)mb->data;
+  uint8_t* rec_Y = enc->rec_frame;
+  uint32_t linesize = enc->width;
+  uint32_t x = (mb_index % enc->mb_width)*MB_HEIGHT_Y;
+  uint32_t y = (mb_index / enc->mb_width)*MB_HEIGHT_Y;
+  const uint8_t* src = enc->src_Y + y*enc->src_Y_linesize + x;
+  intra_16x16_luma_mode_t mode, best_mode = DC_16x16_LUMA_MODE;
+  uint32_t cost, best_cost = 0xFFFFFFFF;
+  uint32_t i;
+
+  vp_os_memset(data, 0, sizeof(MB_p264_t));
+
+  // intra 16x16 cost
+  for (mode=VERTICAL_16x16_LUMA_MODE;mode<=PLANE_16x16_LUMA_MODE;mode++)
+  {
+    if (p264_x86_intra_16x16_available(mode, x, y) == FALSE)
+      continue;
+    p264_intra_16x16_luma(mode, rec_Y, x, y, linesize);
+    cost = video_p264_x86_sad_16x16(src, enc->src_Y_linesize, rec_Y+y*linesize+x, linesize);
+    if (cost < best_cost)
+    {
+      best_cost = cost;
+      best_mode = mode;
+    }
+  }
+
+  // intra 4x4 cost (16 mode codes and AC DC coefficients), given up as soon as 16x16 is cheaper
+  cost = 24*enc->lambda;
+  for (i=0;i<BLOCK_SIZE2 && cost<best_cost;i++)
+  {
+    cost += p264_x86_encode_intra_4x4_block(enc, x+block_4x4_order[i][0], y+block_4x4_order[i][1],
+                                            p264_x86_predicted_4x4_mode(enc, mb_index, i, state->intra_4x4_mode),
+                                            &state->intra_4x4_mode[i], &data->intra_4x4.AC_Y[i*BLOCK_SIZE2]);
+  }
+
+  if (cost < best_cost)
+  {
+    mb->intra_type = INTRA_4x4;
+    p264_x86_encode_intra_chroma(enc, x>>4, y>>4, mb, data->intra_4x4.DC_U, data->intra_4x4.AC_U, data->intra_4x4.DC_V, data->intra_4x4.AC_V);
+  }
+  else
+  {
+    // rec MB is overwritten by the 16x16 prediction
+    mb->intra_type = INTRA_16x16;
+    mb->intra_luma_16x16_mode = best_mode;
+    p264_intra_16x16_luma(best_mode, rec_Y, x, y, linesize);
+    p264_x86_encode_luma_16x16(src, enc->src_Y_linesize, rec_Y+y*linesize+x, linesize, data->intra_16x16.DC_Y, data->intra_16x16.AC_Y, enc->qp);
+    video_p264_decode_intra_luma_16x16_MB(data->intra_16x16.DC_Y, data->intra_16x16.AC_Y, rec_Y, x, y, linesize, best_mode, enc->qp);
+    p264_x86_encode_intra_chroma(enc, x>>4, y>>4, mb, data->intra_16x16.DC_U, data->intra_16x16.AC_U, data->intra_16x16.DC_V, data->intra_16x16.AC_V);
+  }
+
+  state->mv.x = 0;
+  state->mv.y = 0;
+
+#ifdef H264_X86_DEBUG
+  PRINT ("MB %d intra %s cost %d/%d\n",mb_index,mb->intra_type == INTRA_4x4 ? "4x4" : "16x16",cost,best_cost);
+#endif
+}
+
+static uint32_t p264_x86_mv_cost(video_p264_x86_t* enc, int32_t mv_x, int32_t mv_y, MV_XY_t pred)
+{
+  return enc->lambda * (P264_X86_ABS(mv_x - pred.x) + P264_X86_ABS(mv_y - pred.y));
+}
+
+// integer pel motion search : best of (0,0), left and co-located vectors, then full search around it
+static MV_XY_t p264_x86_motion_search(video_p264_x86_t* enc, uint32_t x, uint32_t y, MV_XY_t left, MV_XY_t colocated)
+{
+  const uint8_t* src = enc->src_Y + y*enc->src_Y_linesize + x;
+  const uint8_t* ref = enc->ref_frame + y*enc->width + x;
+  int32_t linesize = enc->width;
+  // keep reference block inside the picture
+  int32_t min_x = P264_X86_MAX(-(int32_t)x, -P264_X86_MV_MAX);
+  int32_t max_x = P264_X86_MIN((int32_t)(enc->width-MB_HEIGHT_Y-x), P264_X86_MV_MAX);
+  int32_t min_y = P264_X86_MAX(-(int32_t)y, -P264_X86_MV_MAX);
+  int32_t max_y = P264_X86_MIN((int32_t)(enc->height-MB_HEIGHT_Y-y), P264_X86_MV_MAX);
+  MV_XY_t candidates[3];
+  MV_XY_t best;
+  int32_t center_x, center_y, mv_x, mv_y;
+  uint32_t cost, best_cost = 0xFFFFFFFF;
+  uint32_t i;
+
+  candidates[0].x = 0;
+  candidates[0].y = 0;
+  candidates[1] = left;
+  candidates[2] = colocated;
+
+  best.x = 0;
+  best.y = 0;
+  for (i=0;i<3;i++)
+  {
+    mv_x = P264_X86_MIN(P264_X86_MAX(candidates[i].x, min_x), max_x);
+    mv_y = P264_X86_MIN(P264_X86_MAX(candidates[i].y, min_y), max_y);
+    cost = video_p264_x86_sad_16x16(src, enc->src_Y_linesize, ref+mv_y*linesize+mv_x, linesize) + p264_x86_mv_cost(enc, mv_x, mv_y, left);
+    if (cost < best_cost)
+    {
+      best_cost = cost;
+      best.x = mv_x;
+      best.y = mv_y;
+    }
+  }
+
+  center_x = best.x;
+  center_y = best.y;
+  for (mv_y=P264_X86_MAX(center_y-P264_X86_SEARCH_RANGE,min_y);mv_y<=P264_X86_MIN(center_y+P264_X86_SEARCH_RANGE,max_y);mv_y++)
+  {
+    for (mv_x=P264_X86_MAX(center_x-P264_X86_SEARCH_RANGE,min_x);mv_x<=P264_X86_MIN(center_x+P264_X86_SEARCH_RANGE,max_x);mv_x++)
+    {
+      cost = video_p264_x86_sad_16x16(src, enc->src_Y_linesize, ref+mv_y*linesize+mv_x, linesize) + p264_x86_mv_cost(enc, mv_x, mv_y, left);
+      if (cost < best_cost)
+      {
+        best_cost = cost;
+        best.x = mv_x;
+        best.y = mv_y;
+      }
+    }
+  }
+
+  return best;
+}
+
+static void p264_x86_encode_inter_MB(video_p264_x86_t* enc, uint32_t mb_index)
+{
+  video_macroblock_t* mb = &enc->macroblocks[mb_index];
+  video_p264_x86_mb_t* state = &enc->mbs[mb_index];
+  MB_p264_t* data = (MB_p264_t*)mb->data;
+  uint32_t width = enc->width;
+  uint32_t height = enc->height;
+  uint8_t* rec_Y = enc->rec_frame;
+  uint8_t* rec_Cb = rec_Y + width*height;
+  uint8_t* rec_Cr = rec_Cb + (width*height>>2);
+  uint8_t* ref_Y = enc->ref_frame;
+  uint8_t* ref_Cb = ref_Y + width*height;
+  uint8_t* ref_Cr = ref_Cb + (width*height>>2);
+  uint32_t x = (mb_index % enc->mb_width)*MB_HEIGHT_Y;
+  uint32_t y = (mb_index / enc->mb_width)*MB_HEIGHT_Y;
+  int32_t coeff[BLOCK_SIZE2];
+  MV_XY_t left;
+  uint32_t bx,by,i;
+
+  vp_os_memset(data, 0, sizeof(MB_p264_t));
+
+  left.x = 0;
+  left.y = 0;
+  if (x > 0)
+    left = enc->mbs[mb_index-1].mv;
+
+  // state->mv still holds the vector of the previous frame
+  state->mv = p264_x86_motion_search(enc, x, y, left, state->mv);
+  mb->nb_partition = 1;
+  mb->inter_partition_mode[0] = INTER_PART_16x16;
+
+  // luma
+  p264_inter_mc_luma(INTER_PART_16x16, state->mv, ref_Y, rec_Y, x, y, width, height, width);
+  for (i=0;i<BLOCK_SIZE2;i++)
+  {
+    bx = x + block_4x4_order[i][0];
+    by = y + block_4x4_order[i][1];
+    p264_x86_forward_4x4(enc->src_Y + by*enc->src_Y_linesize + bx, enc->src_Y_linesize, rec_Y + by*width + bx, width, coeff);
+    p264_x86_quant_4x4(coeff, &data->inter.AC_Y[i*BLOCK_SIZE2], enc->qp, FALSE);
+  }
+
+  // chroma
+  x >>= 1;
+  y >>= 1;
+  p264_inter_mc_chroma(INTER_PART_16x16, state->mv, ref_Cb, rec_Cb, x, y, width>>1, height>>1, width>>1);
+  p264_inter_mc_chroma(INTER_PART_16x16, state->mv, ref_Cr, rec_Cr, x, y, width>>1, height>>1, width>>1);
+  p264_x86_encode_chroma_8x8(enc->src_Cb + y*enc->src_C_linesize + x, enc->src_C_linesize, rec_Cb + y*(width>>1) + x, width>>1,
+                             data->inter.DC_U, data->inter.AC_U, enc->qp, FALSE);
+  p264_x86_encode_chroma_8x8(enc->src_Cr + y*enc->src_C_linesize + x, enc->src_C_linesize, rec_Cr + y*(width>>1) + x, width>>1,
+                             data->inter.DC_V, data->inter.AC_V, enc->qp, FALSE);
+
+  // reconstruct as the decoder
+  video_p264_decode_inter_luma_MB(ref_Y, rec_Y, x<<1, y<<1, width, height, width,
+                                  &state->mv, mb->inter_partition_mode, 1, data->inter.AC_Y, enc->qp);
+  video_p264_decode_inter_chroma_MB(ref_Cb, rec_Cb, x, y, width>>1, height>>1, width>>1,
+                                    &state->mv, mb->inter_partition_mode, 1, data->inter.DC_U, data->inter.AC_U, enc->qp);
+  video_p264_decode_inter_chroma_MB(ref_Cr, rec_Cr, x, y, width>>1, height>>1, width>>1,
+                                    &state->mv, mb->inter_partition_mode, 1, data->inter.DC_V, data->inter.AC_V, enc->qp);
+}
+
+////////////// encoding threads ////////////////
+
+static void p264_x86_encode_row(video_p264_x86_t* enc, int32_t row)
+{
+  int32_t mb_width = (int32_t)enc->mb_width;
+  int32_t col;
+
+  for (col=0;col<mb_width;col++)
+  {
+    if (enc->I_encoding == TRUE)
+    {
+      // intra prediction uses the up and up-right reconstructed MB
+      if (row > 0)
+      {
+        vp_os_mutex_lock(&enc->mutex);
+        while (enc->row_progress[row-1] < P264_X86_MIN(col+2, mb_width))
+          vp_os_cond_wait(&enc->cond);
+        vp_os_mutex_unlock(&enc->mutex);
+      }
+      p264_x86_encode_intra_MB(enc, row*mb_width+col);
+    }
+    else
+    {
+      p264_x86_encode_inter_MB(enc, row*mb_width+col);
+    }
+
+    vp_os_mutex_lock(&enc->mutex);
+    enc->row_progress[row]++;
+    vp_os_cond_broadcast(&enc->cond);
+    vp_os_mutex_unlock(&enc->mutex);
+  }
+}
+
+DEFINE_THREAD_ROUTINE( video_p264_x86_worker, data )
+{
+  video_p264_x86_t* enc = (video_p264_x86_t*)data;
+  int32_t row;
+
+  vp_os_mutex_lock(&enc->mutex);
+  while (enc->running == TRUE)
+  {
+    if (enc->next_row < enc->num_rows)
+    {
+      // rows are handed out in order : a row only waits for rows already being encoded
+      row = enc->next_row++;
+      vp_os_mutex_unlock(&enc->mutex);
+
+      p264_x86_encode_row(enc, row);
+
+      vp_os_mutex_lock(&enc->mutex);
+      enc->rows_done++;
+      vp_os_cond_broadcast(&enc->cond);
+    }
+    else
+    {
+      vp_os_cond_wait(&enc->cond);
+    }
+  }
+  vp_os_mutex_unlock(&enc->mutex);
+
+  THREAD_RETURN(0);
+}
+
+////////////// encoder API ////////////////
+
+static video_p264_x86_t* p264_x86_get(video_controller_t* controller)
+{
+  p264_codec_t* p264_codec = (p264_codec_t*)controller->video_codec;
+
+  return (p264_codec != NULL) ? (video_p264_x86_t*)p264_codec->encoder : NULL;
+}
+
+C_RESULT video_p264_x86_init(video_controller_t* controller)
+{
+  p264_codec_t* p264_codec = (p264_codec_t*)controller->video_codec;
+  video_p264_x86_t* enc;
+
+  if (p264_codec == NULL || p264_codec->encoder != NULL)
+    return C_OK;
+
+  enc = (video_p264_x86_t*)vp_os_malloc(sizeof(video_p264_x86_t));
+  if (enc == NULL)
+    return C_FAIL;
+
+  vp_os_memset(enc, 0, sizeof(video_p264_x86_t));
+  vp_os_mutex_init(&enc->mutex);
+  vp_os_cond_init(&enc->cond, &enc->mutex);
+  p264_codec->encoder = enc;
+
+  return C_OK;
+}
+
+C_RESULT video_p264_prepare_slice ( video_controller_t* controller, const vp_api_picture_t* blockline)
+{
+  video_p264_x86_t* enc = p264_x86_get(controller);
+  uint32_t i;
+
+  if (enc == NULL)
+    return C_FAIL;
+
+  // threads are only started by encoders
+  if (enc->running == FALSE)
+  {
+    enc->running = TRUE;
+    for (i=0;i<P264_X86_NUM_THREADS;i++)
+      vp_os_thread_create(thread_video_p264_x86_worker, (THREAD_PARAMS)enc, &enc->threads[i]);
+  }
+
+  // last frame has to be completed before buffers are swapped
+  vp_os_mutex_lock(&enc->mutex);
+  while (enc->rows_done < enc->num_rows)
+    vp_os_cond_wait(&enc->cond);
+  enc->num_rows = 0;
+  enc->next_row = 0;
+  enc->rows_done = 0;
+  vp_os_mutex_unlock(&enc->mutex);
+
+  // picture dimensions change ?
+  if ((uint32_t)controller->width != enc->width || (uint32_t)controller->height != enc->height)
+  {
+    enc->width = controller->width;
+    enc->height = controller->height;
+    enc->mb_width = enc->width>>4;
+    enc->mb_height = enc->height>>4;
+
+    // realloc YUV 4:2:0 reference frames
+    enc->rec_frame = (uint8_t*)vp_os_realloc(enc->rec_frame, enc->width*enc->height*3/2);
+    enc->ref_frame = (uint8_t*)vp_os_realloc(enc->ref_frame, enc->width*enc->height*3/2);
+    enc->mbs = (video_p264_x86_mb_t*)vp_os_realloc(enc->mbs, enc->mb_width*enc->mb_height*sizeof(video_p264_x86_mb_t));
+    enc->row_progress = (int32_t*)vp_os_realloc(enc->row_progress, enc->mb_height*sizeof(int32_t));
+    if (enc->rec_frame == NULL || enc->ref_frame == NULL || enc->mbs == NULL || enc->row_progress == NULL)
+    {
+      PRINT("p264 x86 encoder realloc failed\n");
+      enc->width = 0;
+      enc->height = 0;
+      return C_FAIL;
+    }
+    vp_os_memset(enc->rec_frame, 0, enc->width*enc->height*3/2);
+    vp_os_memset(enc->ref_frame, 0, enc->width*enc->height*3/2);
+    vp_os_memset(enc->mbs, 0, enc->mb_width*enc->mb_height*sizeof(video_p264_x86_mb_t));
+
+#ifdef H264_X86_DEBUG
+    PRINT ("H264 x86 : new frame dimensions %dx%d\n",enc->width,enc->height);
+#endif
+  }
+
+  // swap decoded and reference frames
+  uint8_t* p_tmp;
+  p_tmp = enc->rec_frame;
+  enc->rec_frame = enc->ref_frame;
+  enc->ref_frame = p_tmp;
+
+  if (controller->picture_type == VIDEO_PICTURE_INTRA)
+    enc->I_encoding = TRUE;
+  else
+    enc->I_encoding = FALSE;
+
+  // retrieve picture pointers
+  enc->src_Y = blockline->y_buf;
+  enc->src_Cb = blockline->cb_buf;
+  enc->src_Cr = blockline->cr_buf;
+  enc->src_Y_linesize = blockline->y_line_size;
+  enc->src_C_linesize = blockline->cb_line_size;
+
+  return C_OK;
+}
+
+// encode num_macro_blocks MB
+C_RESULT video_p264_encode_MB(video_controller_t* controller, uint32_t num_macro_blocks, video_macroblock_t* macroblock ,int32_t qp)
+{
+  video_p264_x86_t* enc = p264_x86_get(controller);
+
+  if (enc != NULL && num_macro_blocks > 0 && enc->running == TRUE && enc->mb_width > 0)
+  {
+    if (qp < 0)
+      qp = 0;
+    else if (qp > 51)
+      qp = 51;
+
+    vp_os_mutex_lock(&enc->mutex);
+    enc->qp = qp;
+    enc->lambda = lambda_table[qp];
+    enc->macroblocks = macroblock;
+    vp_os_memset(enc->row_progress, 0, enc->mb_height*sizeof(int32_t));
+    enc->num_rows = P264_X86_MIN(num_macro_blocks/enc->mb_width, enc->mb_height);
+    enc->next_row = 0;
+    enc->rows_done = 0;
+    vp_os_cond_broadcast(&enc->cond);
+    vp_os_mutex_unlock(&enc->mutex);
+
+    return C_OK;
+  }
+  else
+    return C_FAIL;
+}
+
+// get encoded num_macro_blocks MB
+int32_t video_p264_get_encoded_MB(video_controller_t* controller, uint32_t num_macro_blocks, video_macroblock_t* macroblock)
+{
+  video_p264_x86_t* enc = p264_x86_get(controller);
+  int32_t index, row, col, ready, i;
+
+  if (enc == NULL || enc->macroblocks == NULL || macroblock < enc->macroblocks)
+    return C_FAIL;
+
+  index = macroblock - enc->macroblocks;
+  row = index / enc->mb_width;
+  col = index % enc->mb_width;
+  if (row >= enc->num_rows)
+    return C_FAIL;
+
+  // wait for at least one MB
+  vp_os_mutex_lock(&enc->mutex);
+  while (enc->row_progress[row] <= col)
+    vp_os_cond_wait(&enc->cond);
+  ready = enc->row_progress[row] - col;
+  vp_os_mutex_unlock(&enc->mutex);
+
+  if (ready > (int32_t)num_macro_blocks)
+    ready = num_macro_blocks;
+
+  // coded modes and vectors depend on the MB above, already returned
+  for (i=0;i<ready;i++)
+    p264_x86_code_MB(enc, index+i);
+
+  return ready;
+}
+
+C_RESULT video_p264_x86_close(video_controller_t* controller)
+{
+  p264_codec_t* p264_codec = (p264_codec_t*)controller->video_codec;
+  video_p264_x86_t* enc = p264_x86_get(controller);
+  uint32_t i;
+
+  if (enc == NULL)
+    return C_OK;
+
+  if (enc->running == TRUE)
+  {
+    vp_os_mutex_lock(&enc->mutex);
+    enc->running = FALSE;
+    vp_os_cond_broadcast(&enc->cond);
+    vp_os_mutex_unlock(&enc->mutex);
+
+    for (i=0;i<P264_X86_NUM_THREADS;i++)
+      vp_os_thread_join(enc->threads[i]);
+  }
+
+  if (enc->rec_frame != NULL)
+    vp_os_free(enc->rec_frame);
+  if (enc->ref_frame != NULL)
+    vp_os_free(enc->ref_frame);
+  if (enc->mbs != NULL)
+    vp_os_free(enc->mbs);
+  if (enc->row_progress != NULL)
+    vp_os_free(enc->row_progress);
+
+  vp_os_cond_destroy(&enc->cond);
+  vp_os_mutex_destroy(&enc->mutex);
+  vp_os_free(enc);
+  p264_codec->encoder = NULL;
+
+  return C_OK;
+}
+
+#endif // HAS_P264_FTRANSFORM
@@ -0,0 +1,34 @@
+#ifndef _VIDEO_P264_X86_H_
+#define _VIDEO_P264_X86_H_
+
+#include <VP_Os/vp_os_types.h>
+#include <VLIB/video_macroblock.h>
+#include <VLIB/video_controller.h>
+
+// number of threads encoding macroblock rows (wavefront on I frames)
+#define P264_X86_NUM_THREADS    4
+
+// full search window around the best motion vector candidate (in pixels)
+#define P264_X86_SEARCH_RANGE   6
+
+// software encoder of a P264 controller, its threads are started by the first encoded frame
+C_RESULT video_p264_x86_init(video_controller_t* controller);
+
+// prepare encoder to encode a new frame
+C_RESULT video_p264_prepare_slice ( video_controller_t* controller, const vp_api_picture_t* blockline);
+
+// launch encoding of num_macro_blocks MB (a whole frame)
+C_RESULT video_p264_encode_MB(video_controller_t* controller, uint32_t num_macro_blocks, video_macroblock_t* next_macroblock ,int32_t qp);
+
+// wait for encoded MB, returns the number of MB ready starting at next_macroblock
+int32_t video_p264_get_encoded_MB(video_controller_t* controller, uint32_t num_macro_blocks, video_macroblock_t* next_macroblock);
+
+// stop encoding threads and release encoder
+C_RESULT video_p264_x86_close(video_controller_t* controller);
+
+// sum of absolute differences (SSE2/AVX2 when available at compile time)
+uint32_t video_p264_x86_sad_16x16(const uint8_t* a, int32_t a_stride, const uint8_t* b, int32_t b_stride);
+uint32_t video_p264_x86_sad_8x8(const uint8_t* a, int32_t a_stride, const uint8_t* b, int32_t b_stride);
+uint32_t video_p264_x86_sad_4x4(const uint8_t* a, int32_t a_stride, const uint8_t* b, int32_t b_stride);
+
+#endif // _VIDEO_P264_X86_H_
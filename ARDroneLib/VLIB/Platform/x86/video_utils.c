@@ -1,9 +1,14 @@
 #include <VP_Os/vp_os_types.h>
 
 #include <VLIB/video_controller.h>
+#include <VLIB/video_codec.h>
 
 #include "video_utils.h"
 
+#ifdef HAS_P264_FTRANSFORM
+#include "video_p264_x86.h"
+#endif
+
 #if TARGET_CPU_X86 == 1 || defined (_WIN32)
 
 static uint32_t num_references = 0;
@@ -14,6 +19,11 @@ C_RESULT video_utils_init( video_controller_t* controller )
   {
   }
 
+#ifdef HAS_P264_FTRANSFORM
+  if( controller->codec_type == P264_CODEC )
+    video_p264_x86_init( controller );
+#endif
+
   num_references ++;
 
   return C_OK;
@@ -26,6 +36,11 @@ C_RESULT video_utils_close( video_controller_t* controller )
     num_references --;
   }
 
+#ifdef HAS_P264_FTRANSFORM
+  if( controller->codec_type == P264_CODEC )
+    video_p264_x86_close( controller );
+#endif
+
   return C_OK;
 }
 
@@ -3,4 +3,10 @@
 
 // #define HAS_UVLC_DECODE_BLOCKLINE
 
+// software p264 encoder (video_p264_x86.c, built by the linux makefiles)
+#ifdef __linux__
+#define HAS_P264_FTRANSFORM
+#define HAS_P264_X86_ENCODER
+#endif
+
 #endif // _X86_VIDEO_UTILS_H_
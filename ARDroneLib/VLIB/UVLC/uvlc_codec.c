@@ -269,7 +269,8 @@ C_RESULT uvlc_encode_blockline( video_controller_t* controller, const vp_api_pic
 
   if( stream->used*2 >= stream->size )
   {
-	uint32_t add = 32 - clz(stream->used/controller->blockline); 	    // estimate the log2 size of a blockline in the stream
+	// controller->blockline is still the last blockline written : 0 when the first one filled half of the stream
+	uint32_t add = 32 - clz(stream->used/(controller->blockline+1));  // estimate the log2 size of a blockline in the stream
 	add = 1<<(add+1);												    // major and compute addition buffer size
     stream->bytes = vp_os_realloc( stream->bytes, stream->size + add ); // Add some byte to internal stream
     stream->size += add;
@@ -0,0 +1,395 @@
+/**
+ * @file ATcodec_Parser.c
+ * @date 2026/10/18
+ */
+
+#include <VP_Os/vp_os_types.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+
+#include <ATcodec/ATcodec_Parser.h>
+
+
+#define ATCODEC_PARSER_FNV_BASIS    2166136261U
+#define ATCODEC_PARSER_FNV_PRIME    16777619U
+#define ATCODEC_PARSER_MAX_SEEDS    (1 << 16)
+
+// Characters classes, so that the scanning loops test one table entry per character
+#define ATCODEC_PARSER_END          1   // '\0', '\n', '\r'
+#define ATCODEC_PARSER_COMMA        2
+#define ATCODEC_PARSER_QUOTE        4
+#define ATCODEC_PARSER_EQUAL        8
+
+#define ATCODEC_PARSER_CLASS(c)     (atcodec_parser_classes[(uint8_t)(c)])
+#define ATCODEC_PARSER_IS_END(c)    (ATCODEC_PARSER_CLASS(c) & ATCODEC_PARSER_END)
+
+static const uint8_t atcodec_parser_classes[256] =
+{
+  1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0,   // '\0' '\n' '\r'
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0,   // '"' ','
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 0, 0,   // '='
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+
+static uint32_t
+ATcodec_Parser_Hash(const char *name, int32_t length)
+{
+  uint32_t hash = ATCODEC_PARSER_FNV_BASIS;
+
+  while(length--)
+    hash = (hash ^ (uint8_t)*name++) * ATCODEC_PARSER_FNV_PRIME;
+
+  return hash;
+}
+
+
+// Places all the commands in a table of 1 << bits slots, without collision
+static ATCODEC_RET
+ATcodec_Parser_Fill(ATcodec_Parser_t *parser, uint32_t bits, uint32_t seed)
+{
+  int32_t i;
+
+  vp_os_memset(parser->table, -1, sizeof(parser->table));
+
+  for(i = 0 ; i < parser->nb_defs ; i++)
+  {
+    uint32_t slot = (ATcodec_Parser_Hash(parser->defs[i].name, parser->name_length[i]) * seed) >> (32 - bits);
+
+    if(parser->table[slot] != -1)
+      return ATCODEC_FALSE;
+
+    parser->table[slot] = (int8_t)i;
+  }
+
+  return ATCODEC_TRUE;
+}
+
+
+ATCODEC_RET
+ATcodec_Parser_Init(ATcodec_Parser_t *parser, const ATcodec_Command_Def_t *defs, int32_t nb_defs, ATcodec_Command_Received unknown)
+{
+  uint32_t bits, seed;
+  int32_t i, j;
+
+  vp_os_memset(parser, 0, sizeof(*parser));
+  parser->defs    = defs;
+  parser->nb_defs = nb_defs;
+  parser->unknown = unknown;
+
+  if(nb_defs > ATCODEC_PARSER_MAX_COMMANDS)
+  {
+    PRINT("ATcodec parser : %d commands, %d at most\n", nb_defs, ATCODEC_PARSER_MAX_COMMANDS);
+    return ATCODEC_FALSE;
+  }
+
+  for(i = 0 ; i < nb_defs ; i++)
+  {
+    parser->name_length[i] = (uint8_t)strlen(defs[i].name);
+
+    for(j = 0 ; j < i ; j++)
+    {
+      if(strcmp(defs[i].name, defs[j].name) == 0)
+      {
+        PRINT("ATcodec parser : command %s defined twice\n", defs[i].name);
+        return ATCODEC_FALSE;
+      }
+    }
+  }
+
+  // Smallest table with at least twice as many slots as commands, larger ones if no seed is found
+  for(bits = 1 ; bits < ATCODEC_PARSER_TABLE_BITS && (1 << bits) < 2 * nb_defs ; bits++);
+
+  for( ; bits <= ATCODEC_PARSER_TABLE_BITS ; bits++)
+  {
+    for(seed = 1 ; seed < 2 * ATCODEC_PARSER_MAX_SEEDS ; seed += 2)
+    {
+      if(ATcodec_Parser_Fill(parser, bits, seed) == ATCODEC_TRUE)
+      {
+        parser->seed  = seed;
+        parser->shift = 32 - bits;
+        return ATCODEC_TRUE;
+      }
+    }
+  }
+
+  PRINT("ATcodec parser : no perfect hash found for %d commands\n", nb_defs);
+  return ATCODEC_FALSE;
+}
+
+
+int32_t
+ATcodec_Parser_Process(ATcodec_Parser_t *parser, const char *buffer, int32_t size, void *user_data)
+{
+  ATcodec_Command_t command;
+  const char *line = buffer;
+  const char *last = buffer + size;
+
+  // Only the complete commands are parsed
+  while(last > buffer && !ATCODEC_PARSER_IS_END(last[-1]))
+    last--;
+
+  while(line < last)
+  {
+    const char *ptr = line;
+    uint32_t hash = ATCODEC_PARSER_FNV_BASIS;
+    bool_t valid;
+
+    if(ATCODEC_PARSER_IS_END(*ptr))
+    {
+      line++;
+      continue;
+    }
+
+    valid = (last - ptr > 3) && ptr[0] == 'A' && ptr[1] == 'T' && ptr[2] == '*';
+    command.nb_fields = 0;
+
+    if(valid)
+    {
+      // Name, hashed while it is scanned
+      ptr += 3;
+      command.name = ptr;
+      while(!(ATCODEC_PARSER_CLASS(*ptr) & (ATCODEC_PARSER_END | ATCODEC_PARSER_EQUAL)))
+      {
+        hash = (hash ^ (uint8_t)*ptr) * ATCODEC_PARSER_FNV_PRIME;
+        ptr++;
+      }
+      command.name_length = (int32_t)(ptr - command.name);
+
+      // Arguments, split on the ',' which are not in a string
+      if(*ptr == '=')
+      {
+        const char *field = ++ptr;
+        bool_t in_string = FALSE;
+
+        for( ; ; ptr++)
+        {
+          uint8_t c;
+
+          while(!((c = ATCODEC_PARSER_CLASS(*ptr)) & (ATCODEC_PARSER_END | ATCODEC_PARSER_COMMA | ATCODEC_PARSER_QUOTE)))
+            ptr++;
+
+          if(c & ATCODEC_PARSER_QUOTE)
+          {
+            in_string = !in_string;
+          }
+          else if((c & ATCODEC_PARSER_END) || !in_string)
+          {
+            if(command.nb_fields < ATCODEC_PARSER_MAX_FIELDS)
+            {
+              command.fields[command.nb_fields].start  = field;
+              command.fields[command.nb_fields].length = (int32_t)(ptr - field);
+              command.nb_fields++;
+            }
+            else
+            {
+              valid = FALSE;
+            }
+
+            if(c & ATCODEC_PARSER_END)
+              break;
+
+            field = ptr + 1;
+          }
+        }
+      }
+    }
+
+    while(!ATCODEC_PARSER_IS_END(*ptr))
+      ptr++;
+    line = ptr + 1;
+
+    if(!valid)
+    {
+      parser->nb_malformed++;
+      continue;
+    }
+
+    command.id = parser->table[(hash * parser->seed) >> parser->shift];
+    if(command.id >= 0 &&
+       (parser->name_length[command.id] != command.name_length ||
+        memcmp(parser->defs[command.id].name, command.name, command.name_length) != 0))
+    {
+      command.id = -1;
+    }
+
+    parser->nb_commands++;
+    if(command.id >= 0)
+    {
+      if(parser->defs[command.id].callback != NULL)
+        parser->defs[command.id].callback(&command, user_data);
+    }
+    else
+    {
+      parser->nb_unknown++;
+      if(parser->unknown != NULL)
+        parser->unknown(&command, user_data);
+    }
+  }
+
+  return (int32_t)(last - buffer);
+}
+
+
+ATCODEC_RET
+ATcodec_Field_Int(const ATcodec_Field_t *field, int32_t *value)
+{
+  const char *ptr = field->start;
+  const char *end = ptr + field->length;
+  bool_t negative = FALSE;
+  uint64_t result = 0;
+
+  if(ptr < end && (*ptr == '-' || *ptr == '+'))
+    negative = (*ptr++ == '-');
+
+  if(ptr == end || end - ptr > 10)
+    return ATCODEC_FALSE;
+
+  for( ; ptr < end ; ptr++)
+  {
+    uint32_t digit = (uint8_t)*ptr - '0';
+    if(digit > 9)
+      return ATCODEC_FALSE;
+    result = result * 10 + digit;
+  }
+
+  if(result > (negative ? 2147483648ULL : 4294967295ULL))
+    return ATCODEC_FALSE;
+
+  *value = (int32_t)(negative ? 0U - (uint32_t)result : (uint32_t)result);
+
+  return ATCODEC_TRUE;
+}
+
+
+ATCODEC_RET
+ATcodec_Field_Float(const ATcodec_Field_t *field, float32_t *value)
+{
+  static const double powers[] = { 1e1, 1e2, 1e4, 1e8, 1e16, 1e32, 1e64, 1e128, 1e256 };
+  const char *ptr = field->start;
+  const char *end = ptr + field->length;
+  bool_t negative = FALSE;
+  uint64_t mantissa = 0;
+  int32_t significant = 0, digits = 0, exponent = 0;
+  double result, scale = 1.0;
+  int32_t i, e;
+
+  if(ptr < end && (*ptr == '-' || *ptr == '+'))
+    negative = (*ptr++ == '-');
+
+  // Only the first 19 significant digits fit in the mantissa
+  for( ; ptr < end && (uint8_t)(*ptr - '0') <= 9 ; ptr++, digits++)
+  {
+    if(significant < 19)
+    {
+      mantissa = mantissa * 10 + (*ptr - '0');
+      significant += (mantissa != 0);
+    }
+    else
+    {
+      exponent++;
+    }
+  }
+
+  if(ptr < end && *ptr == '.')
+  {
+    for(ptr++ ; ptr < end && (uint8_t)(*ptr - '0') <= 9 ; ptr++, digits++)
+    {
+      if(significant < 19)
+      {
+        mantissa = mantissa * 10 + (*ptr - '0');
+        significant += (mantissa != 0);
+        exponent--;
+      }
+    }
+  }
+
+  if(digits == 0)
+    return ATCODEC_FALSE;
+
+  if(ptr < end && (*ptr == 'e' || *ptr == 'E'))
+  {
+    bool_t negative_exponent = FALSE;
+    int32_t value_exponent = 0;
+
+    ptr++;
+    if(ptr < end && (*ptr == '-' || *ptr == '+'))
+      negative_exponent = (*ptr++ == '-');
+
+    if(ptr == end)
+      return ATCODEC_FALSE;
+
+    for( ; ptr < end && (uint8_t)(*ptr - '0') <= 9 ; ptr++)
+    {
+      if(value_exponent < 10000)
+        value_exponent = value_exponent * 10 + (*ptr - '0');
+    }
+
+    exponent += negative_exponent ? -value_exponent : value_exponent;
+  }
+
+  if(ptr != end)
+    return ATCODEC_FALSE;
+
+  result = (double)mantissa;
+  if(result != 0.0)
+  {
+    e = (exponent < 0) ? -exponent : exponent;
+    if(e >= 512)
+    {
+      result = (exponent < 0) ? 0.0 : result * 1e256 * 1e256;
+    }
+    else
+    {
+      for(i = 0 ; e != 0 ; i++, e >>= 1)
+      {
+        if(e & 1)
+          scale *= powers[i];
+      }
+      result = (exponent < 0) ? result / scale : result * scale;
+    }
+  }
+
+  *value = (float32_t)(negative ? -result : result);
+
+  return ATCODEC_TRUE;
+}
+
+
+ATCODEC_RET
+ATcodec_Field_Float_Bits(const ATcodec_Field_t *field, float32_t *value)
+{
+  int32_t bits;
+
+  if(ATcodec_Field_Int(field, &bits) != ATCODEC_TRUE)
+    return ATCODEC_FALSE;
+
+  vp_os_memcpy(value, &bits, sizeof(*value));
+
+  return ATCODEC_TRUE;
+}
+
+
+ATCODEC_RET
+ATcodec_Field_String(const ATcodec_Field_t *field, const char **str, int32_t *length)
+{
+  if(field->length < 2 || field->start[0] != '"' || field->start[field->length - 1] != '"')
+    return ATCODEC_FALSE;
+
+  *str    = field->start + 1;
+  *length = field->length - 2;
+
+  return ATCODEC_TRUE;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file ATcodec_Parser.h
+ * @date 2026/10/18
+ *
+ * Receive side AT commands parser working on a whole buffer.
+ *
+ * Unlike the messages tree, commands are not matched character by character
+ * against a format string : the name between "AT*" and '=' is hashed while it
+ * is scanned, and looked up in a perfect hash table built once from the
+ * commands definitions. The arguments are only split on ',' (outside quoted
+ * strings), and given to the callback as pointers into the received buffer,
+ * without any copy. They are decoded on demand with ATcodec_Field_*.
+ */
+
+#ifndef _AT_CODEC_PARSER_INCLUDE_
+#define _AT_CODEC_PARSER_INCLUDE_
+
+
+#include <VP_Os/vp_os_types.h>
+
+#include <ATcodec/ATcodec.h>
+
+
+#define ATCODEC_PARSER_MAX_FIELDS     16
+#define ATCODEC_PARSER_TABLE_BITS     8  // Up to 1 << ATCODEC_PARSER_TABLE_BITS hash slots
+#define ATCODEC_PARSER_MAX_COMMANDS   64
+
+
+// One argument, in the received buffer. Quotes of strings are included.
+typedef struct _ATcodec_Field_
+{
+  const char *start;
+  int32_t     length;
+}
+ATcodec_Field_t;
+
+typedef struct _ATcodec_Command_
+{
+  int32_t          id;          // Index of the definition, -1 if the command is unknown
+  const char      *name;        // After "AT*", not terminated
+  int32_t          name_length;
+  ATcodec_Field_t  fields[ATCODEC_PARSER_MAX_FIELDS];
+  int32_t          nb_fields;
+}
+ATcodec_Command_t;
+
+typedef void (*ATcodec_Command_Received)(const ATcodec_Command_t *command, void *user_data);
+
+typedef struct _ATcodec_Command_Def_
+{
+  const char               *name;      // Without "AT*" nor '=', "PCMD" for example
+  ATcodec_Command_Received  callback;
+}
+ATcodec_Command_Def_t;
+
+typedef struct _ATcodec_Parser_
+{
+  const ATcodec_Command_Def_t *defs;
+  int32_t                      nb_defs;
+  ATcodec_Command_Received     unknown;    // Called for commands without definition, can be NULL
+
+  // Statistics
+  uint32_t nb_commands;
+  uint32_t nb_unknown;
+  uint32_t nb_malformed;
+
+  // private
+  uint32_t seed;
+  uint32_t shift;
+  uint8_t  name_length[ATCODEC_PARSER_MAX_COMMANDS];
+  int8_t   table[1 << ATCODEC_PARSER_TABLE_BITS];
+}
+ATcodec_Parser_t;
+
+
+/**
+ * Builds the hash table of the commands. defs must stay valid while the parser is used.
+ *
+ * @param  unknown                 Callback of the commands without definition, can be NULL
+ *
+ * @retVal ATCODEC_FALSE           If there are too many commands, or the same name twice
+ */
+ATCODEC_RET
+ATcodec_Parser_Init(ATcodec_Parser_t *parser, const ATcodec_Command_Def_t *defs, int32_t nb_defs, ATcodec_Command_Received unknown);
+
+/**
+ * Calls the callback of each complete command of buffer. Commands end with '\r', '\n' or '\0'.
+ * Lines which do not start with "AT*", or with more than ATCODEC_PARSER_MAX_FIELDS arguments, are skipped.
+ *
+ * @return Number of bytes used : the end of buffer after the last complete command is not,
+ *         it has to be given again with the next data of a stream.
+ */
+int32_t
+ATcodec_Parser_Process(ATcodec_Parser_t *parser, const char *buffer, int32_t size, void *user_data);
+
+/**
+ * Decimal integer, from -2^31 to 2^32-1 : unsigned values are given as their int32_t bits.
+ */
+ATCODEC_RET
+ATcodec_Field_Int(const ATcodec_Field_t *field, int32_t *value);
+
+/**
+ * Decimal float, with an optional fraction and exponent : "-1.5", "2e-3"
+ */
+ATCODEC_RET
+ATcodec_Field_Float(const ATcodec_Field_t *field, float32_t *value);
+
+/**
+ * Float sent as the integer of its bits, like the arguments of AT*PCMD
+ */
+ATCODEC_RET
+ATcodec_Field_Float_Bits(const ATcodec_Field_t *field, float32_t *value);
+
+/**
+ * Quoted string : str points after the opening quote, in the received buffer
+ */
+ATCODEC_RET
+ATcodec_Field_String(const ATcodec_Field_t *field, const char **str, int32_t *length);
+
+
+#endif // ! _AT_CODEC_PARSER_INCLUDE_
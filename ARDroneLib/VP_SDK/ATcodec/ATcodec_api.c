@@ -12,6 +12,7 @@
 #include <VP_Os/vp_os_malloc.h>
 #include <VP_Os/vp_os_signal.h>
 #include <VP_Os/vp_os_print.h>
+#include <VP_Os/vp_os_trace.h>
 
 #if !defined(TARGET_OS_IPHONE) && !defined(TARGET_IPHONE_SIMULATOR)
 # include <VP_Api/vp_api_thread_helper.h>
@@ -700,16 +701,19 @@ ATcodec_Send_Messages()
   if(!atcodec_lib_init_ok)
     return ATCODEC_FALSE;
 	
+  VP_OS_TRACE_BEGIN_EVENT("ATcodec_Send_Messages");
   vp_os_mutex_lock(&ATcodec_cond_mutex);
   if(ATcodec_Message_len > INTERNAL_BUFFER_SIZE)
 	  PRINT("ATcodec_Send_Messages : buf=%s, len=%d\n", &ATcodec_Message_Buffer[0], ATcodec_Message_len);
 	
+  VP_OS_TRACE_COUNTER_EVENT("at_bytes", ATcodec_Message_len);
   if(ATcodec_Message_len && func_ptrs.write((uint8_t*)&ATcodec_Message_Buffer[0], (int32_t*)&ATcodec_Message_len) != AT_CODEC_WRITE_OK)
     res = ATCODEC_FALSE;
 	
   ATcodec_Message_len = 0;
 	
   vp_os_mutex_unlock(&ATcodec_cond_mutex);
+  VP_OS_TRACE_END_EVENT("ATcodec_Send_Messages");
 	
   return res;
 }
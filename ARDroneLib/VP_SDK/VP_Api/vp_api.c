@@ -20,6 +20,7 @@
 #include <VP_Os/vp_os_malloc.h>
 #include <VP_Os/vp_os_assert.h>
 #include <VP_Os/vp_os_print.h>
+#include <VP_Os/vp_os_trace.h>
 #ifdef USE_ELINUX
 #include <VP_Os/elinux/vp_os_ltt.h>
 #endif
@@ -207,6 +208,25 @@ vp_api_close(vp_api_io_pipeline_t *pipeline, PIPELINE_HANDLE *handle)
   return res;
 }
 
+#ifdef VP_OS_TRACE_SUPPORTED
+// Trace events keep a pointer to their name, unnamed stages get a static one
+static const char *
+vp_api_stage_trace_name(vp_api_io_pipeline_t *pipeline, vp_api_io_stage_t* stage)
+{
+  static const char * const stage_names[] =
+  {
+    "stage 0", "stage 1", "stage 2", "stage 3", "stage 4", "stage 5", "stage 6", "stage 7",
+    "stage 8", "stage 9", "stage 10", "stage 11", "stage 12", "stage 13", "stage 14", "stage 15"
+  };
+  uint32_t index = (uint32_t)(stage - pipeline->stages);
+
+  if(stage->name != NULL)
+    return stage->name;
+
+  return (index < sizeof(stage_names) / sizeof(stage_names[0])) ? stage_names[index] : "stage";
+}
+#endif
+
 static C_RESULT
 vp_api_iteration(vp_api_io_pipeline_t *pipeline, vp_api_io_stage_t* previousStage, vp_api_io_stage_t* stage)
 {
@@ -230,7 +250,16 @@ vp_api_iteration(vp_api_io_pipeline_t *pipeline, vp_api_io_stage_t* previousStag
   }
   else
 #endif
+#ifdef VP_OS_TRACE_SUPPORTED
+  {
+    const char *name = vp_api_stage_trace_name(pipeline, stage);
+    VP_OS_TRACE_BEGIN_EVENT(name);
+    res = stage->funcs.transform(stage->cfg, previousData, &stage->data);
+    VP_OS_TRACE_END_EVENT(name);
+  }
+#else
   res = stage->funcs.transform(stage->cfg, previousData, &stage->data);
+#endif
 #ifdef USE_ELINUX
   if(stage->name != NULL)
     LTT_WRITEF("stage %s <-",stage->name);
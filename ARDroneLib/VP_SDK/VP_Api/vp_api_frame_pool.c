@@ -0,0 +1,443 @@
+/**
+ *  @file     vp_api_frame_pool.c
+ *  @brief    VP Api. Shared pool of reference counted picture buffers
+ */
+
+// Same PixelFormat values as vp_api_picture.c
+#ifdef FFMPEG_SUPPORT
+#undef FFMPEG_SUPPORT
+#endif
+
+#include <VP_Api/vp_api_frame_pool.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_signal.h>
+#include <VP_Os/vp_os_print.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Frame header (and a magic word) is stored in front of its data, in the same allocation
+#define VP_API_FRAME_HEADER_SIZE  ((sizeof(vp_api_frame_t) + sizeof(uint32_t) + VP_API_FRAME_ALIGN - 1) & ~(VP_API_FRAME_ALIGN - 1))
+#define VP_API_FRAME_MAGIC        0x46524D45 // 'FRME'
+
+typedef struct _vp_api_frame_pool_t
+{
+  vp_api_frame_t*           free_list;
+  uint32_t                  num_free;
+  vp_api_frame_t*           used_list;
+  vp_api_frame_pool_stats_t stats;
+} vp_api_frame_pool_t;
+
+static vp_api_frame_pool_t frame_pool;
+
+#ifdef PTHREAD_MUTEX_INITIALIZER
+static vp_os_mutex_t frame_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define frame_pool_init()
+#else
+static vp_os_mutex_t frame_pool_mutex;
+static bool_t frame_pool_mutex_init = FALSE;
+static void frame_pool_init( void )
+{
+  if( frame_pool_mutex_init == FALSE )
+  {
+    vp_os_mutex_init( &frame_pool_mutex );
+    frame_pool_mutex_init = TRUE;
+  }
+}
+#endif
+
+static uint32_t frame_pool_picture_size( uint32_t width, uint32_t height, enum PixelFormat format )
+{
+  switch( format )
+  {
+    case PIX_FMT_YUV420P:
+      return (width * height * 3) / 2;
+
+    case PIX_FMT_YUV422:
+    case PIX_FMT_UYVY422:
+    case PIX_FMT_VYUY422:
+    case PIX_FMT_RGB565:
+      return width * height * 2;
+
+    case PIX_FMT_RGB24:
+    case PIX_FMT_BGR24:
+      return width * height * 3;
+
+    case PIX_FMT_RGBA32:
+      return width * height * 4;
+
+    case PIX_FMT_GRAY8:
+      return width * height;
+
+    default:
+      return 0;
+  }
+}
+
+static void frame_pool_setup_picture( vp_api_frame_t* frame, uint32_t width, uint32_t height, enum PixelFormat format )
+{
+  vp_api_picture_t* pic = &frame->picture;
+
+  vp_os_memset( pic, 0, sizeof(*pic) );
+
+  pic->format   = format;
+  pic->width    = width;
+  pic->height   = height;
+  pic->complete = 1;
+
+  switch( format )
+  {
+    case PIX_FMT_YUV420P:
+      pic->y_line_size  = width;
+      pic->cb_line_size = width / 2;
+      pic->cr_line_size = width / 2;
+      break;
+
+    case PIX_FMT_YUV422:
+    case PIX_FMT_UYVY422:
+    case PIX_FMT_VYUY422:
+    case PIX_FMT_RGB565:
+      pic->y_line_size  = width * 2;
+      break;
+
+    case PIX_FMT_RGB24:
+    case PIX_FMT_BGR24:
+      pic->y_line_size  = width * 3;
+      break;
+
+    case PIX_FMT_RGBA32:
+      pic->y_line_size  = width * 4;
+      break;
+
+    default:
+      pic->y_line_size  = width;
+      break;
+  }
+
+  pic->raw = frame->data;
+  if( vp_api_picture_format_to_buf_address( pic ) == 0 )
+    pic->y_buf = frame->data;
+}
+
+static void frame_pool_list_remove( vp_api_frame_t** list, vp_api_frame_t* frame )
+{
+  if( frame->prev != NULL )
+    frame->prev->next = frame->next;
+  else
+    *list = frame->next;
+
+  if( frame->next != NULL )
+    frame->next->prev = frame->prev;
+
+  frame->next = NULL;
+  frame->prev = NULL;
+}
+
+static void frame_pool_list_add( vp_api_frame_t** list, vp_api_frame_t* frame )
+{
+  frame->prev = NULL;
+  frame->next = *list;
+  if( *list != NULL )
+    (*list)->prev = frame;
+  *list = frame;
+}
+
+static vp_api_frame_t* frame_pool_new( uint32_t size )
+{
+  vp_api_frame_t* frame = NULL;
+  uint32_t block_size = VP_API_FRAME_HEADER_SIZE + size;
+  uint32_t flags = 0;
+  uint8_t* block = NULL;
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+  // Large frames are backed by huge pages when the system has some reserved
+  if( block_size >= VP_API_FRAME_HUGEPAGE_SIZE )
+  {
+    uint32_t mapped_size = (block_size + VP_API_FRAME_HUGEPAGE_SIZE - 1) & ~(VP_API_FRAME_HUGEPAGE_SIZE - 1);
+    void* map = mmap( NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+
+    if( map != MAP_FAILED )
+    {
+      block       = (uint8_t*)map;
+      block_size  = mapped_size;
+      flags       = VP_API_FRAME_FLAG_HUGEPAGE | VP_API_FRAME_FLAG_MMAP;
+    }
+  }
+#endif
+
+  if( block == NULL )
+  {
+    block = (uint8_t*)vp_os_aligned_malloc( block_size, VP_API_FRAME_ALIGN );
+    if( block == NULL )
+      return NULL;
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    // Otherwise ask for transparent huge pages on the page aligned part
+    if( block_size >= VP_API_FRAME_HUGEPAGE_SIZE )
+    {
+      uintptr_t start = ((uintptr_t)block + 4095) & ~(uintptr_t)4095;
+      uintptr_t end   = ((uintptr_t)block + block_size) & ~(uintptr_t)4095;
+      if( end > start )
+        madvise( (void*)start, end - start, MADV_HUGEPAGE );
+    }
+#endif
+  }
+
+  frame = (vp_api_frame_t*)block;
+  vp_os_memset( frame, 0, sizeof(*frame) );
+  frame->data     = block + VP_API_FRAME_HEADER_SIZE;
+  frame->capacity = block_size - VP_API_FRAME_HEADER_SIZE;
+  frame->flags    = flags;
+  // Magic word just before data lets vp_api_frame_from_data detect overwritten headers
+  ((uint32_t*)frame->data)[-1] = VP_API_FRAME_MAGIC;
+
+  frame_pool.stats.frames++;
+  frame_pool.stats.bytes += block_size;
+  if( frame_pool.stats.bytes > frame_pool.stats.bytes_high_water )
+    frame_pool.stats.bytes_high_water = frame_pool.stats.bytes;
+  if( flags & VP_API_FRAME_FLAG_HUGEPAGE )
+    frame_pool.stats.hugepage_frames++;
+
+  return frame;
+}
+
+static void frame_pool_delete( vp_api_frame_t* frame )
+{
+  uint32_t block_size = VP_API_FRAME_HEADER_SIZE + frame->capacity;
+
+  frame_pool.stats.frames--;
+  frame_pool.stats.bytes -= block_size;
+  if( frame->flags & VP_API_FRAME_FLAG_HUGEPAGE )
+    frame_pool.stats.hugepage_frames--;
+
+  ((uint32_t*)frame->data)[-1] = 0;
+
+#ifdef __linux__
+  if( frame->flags & VP_API_FRAME_FLAG_MMAP )
+  {
+    munmap( frame, block_size );
+    return;
+  }
+#endif
+
+  vp_os_aligned_free( frame );
+}
+
+vp_api_frame_t* vp_api_frame_acquire( uint32_t width, uint32_t height, enum PixelFormat format, const char* owner )
+{
+  vp_api_frame_t* frame;
+  vp_api_frame_t* best = NULL;
+  uint32_t size = frame_pool_picture_size( width, height, format );
+
+  if( size == 0 )
+  {
+    PRINT("%s:%d - Unsupported picture format %d\n", __FUNCTION__, __LINE__, format);
+    return NULL;
+  }
+
+  frame_pool_init();
+  vp_os_mutex_lock( &frame_pool_mutex );
+
+  frame_pool.stats.acquires++;
+
+  // Smallest free frame big enough, without wasting more than half of it
+  for( frame = frame_pool.free_list; frame != NULL; frame = frame->next )
+  {
+    if( frame->capacity >= size && frame->capacity / 2 <= size )
+    {
+      if( best == NULL || frame->capacity < best->capacity )
+        best = frame;
+    }
+  }
+
+  if( best != NULL )
+  {
+    frame_pool_list_remove( &frame_pool.free_list, best );
+    frame_pool.num_free--;
+    frame_pool.stats.reuses++;
+  }
+  else
+  {
+    best = frame_pool_new( size );
+  }
+
+  if( best != NULL )
+  {
+    best->refcount  = 1;
+    best->size      = size;
+    best->owner     = owner;
+    frame_pool_list_add( &frame_pool.used_list, best );
+
+    frame_pool.stats.frames_in_use++;
+    if( frame_pool.stats.frames_in_use > frame_pool.stats.frames_high_water )
+      frame_pool.stats.frames_high_water = frame_pool.stats.frames_in_use;
+  }
+
+  vp_os_mutex_unlock( &frame_pool_mutex );
+
+  if( best != NULL )
+    frame_pool_setup_picture( best, width, height, format );
+
+  return best;
+}
+
+vp_api_frame_t* vp_api_frame_ref( vp_api_frame_t* frame )
+{
+  if( frame != NULL )
+  {
+    vp_os_mutex_lock( &frame_pool_mutex );
+    frame->refcount++;
+    vp_os_mutex_unlock( &frame_pool_mutex );
+  }
+
+  return frame;
+}
+
+void vp_api_frame_unref( vp_api_frame_t* frame )
+{
+  if( frame == NULL )
+    return;
+
+  vp_os_mutex_lock( &frame_pool_mutex );
+
+  if( frame->refcount <= 0 )
+  {
+    PRINT("%s:%d - Frame %p released twice\n", __FUNCTION__, __LINE__, frame);
+  }
+  else if( --frame->refcount == 0 )
+  {
+    frame_pool_list_remove( &frame_pool.used_list, frame );
+    frame_pool.stats.frames_in_use--;
+    frame->owner = NULL;
+
+    if( frame_pool.num_free < VP_API_FRAME_POOL_MAX_FREE )
+    {
+      frame_pool_list_add( &frame_pool.free_list, frame );
+      frame_pool.num_free++;
+    }
+    else
+    {
+      frame_pool_delete( frame );
+    }
+  }
+
+  vp_os_mutex_unlock( &frame_pool_mutex );
+}
+
+vp_api_frame_t* vp_api_frame_make_writable( vp_api_frame_t* frame, const char* owner )
+{
+  vp_api_frame_t* copy;
+  int32_t refcount;
+
+  if( frame == NULL )
+    return NULL;
+
+  vp_os_mutex_lock( &frame_pool_mutex );
+  refcount = frame->refcount;
+  vp_os_mutex_unlock( &frame_pool_mutex );
+
+  // Only holders can take references, a sole owner can not be raced
+  if( refcount == 1 )
+    return frame;
+
+  copy = vp_api_frame_acquire( frame->picture.width, frame->picture.height, frame->picture.format, owner );
+  if( copy == NULL )
+    return NULL;
+
+  vp_os_memcpy( copy->data, frame->data, frame->size );
+  vp_api_frame_unref( frame );
+
+  return copy;
+}
+
+vp_api_frame_t* vp_api_frame_from_data( void* data )
+{
+  vp_api_frame_t* frame;
+
+  if( data == NULL || ((uintptr_t)data & (VP_API_FRAME_ALIGN - 1)) != 0 )
+    return NULL;
+
+  // Only look for data among frames in use : reading in front of a buffer
+  // which does not come from the pool could fall outside of its allocation
+  frame_pool_init();
+  vp_os_mutex_lock( &frame_pool_mutex );
+  for( frame = frame_pool.used_list; frame != NULL && frame->data != data; frame = frame->next );
+  vp_os_mutex_unlock( &frame_pool_mutex );
+
+  if( frame != NULL && ((uint32_t*)data)[-1] != VP_API_FRAME_MAGIC )
+  {
+    PRINT("%s:%d - Frame %p header is corrupted\n", __FUNCTION__, __LINE__, frame);
+    return NULL;
+  }
+
+  return frame;
+}
+
+C_RESULT vp_api_frame_pool_get_stats( vp_api_frame_pool_stats_t* stats )
+{
+  if( stats == NULL )
+    return C_FAIL;
+
+  frame_pool_init();
+  vp_os_mutex_lock( &frame_pool_mutex );
+  vp_os_memcpy( stats, &frame_pool.stats, sizeof(*stats) );
+  vp_os_mutex_unlock( &frame_pool_mutex );
+
+  return C_OK;
+}
+
+C_RESULT vp_api_frame_pool_trim( void )
+{
+  vp_api_frame_t* frame;
+
+  frame_pool_init();
+  vp_os_mutex_lock( &frame_pool_mutex );
+
+  while( frame_pool.free_list != NULL )
+  {
+    frame = frame_pool.free_list;
+    frame_pool_list_remove( &frame_pool.free_list, frame );
+    frame_pool_delete( frame );
+  }
+  frame_pool.num_free = 0;
+
+  vp_os_mutex_unlock( &frame_pool_mutex );
+
+  return C_OK;
+}
+
+int32_t vp_api_frame_pool_print_leaks( void )
+{
+  vp_api_frame_t* frame;
+  int32_t count = 0;
+
+  frame_pool_init();
+  vp_os_mutex_lock( &frame_pool_mutex );
+
+  for( frame = frame_pool.used_list; frame != NULL; frame = frame->next )
+  {
+    PRINT("Frame %p : %dx%d %s, %d bytes, refcount %d, owner %s\n",
+          frame->data,
+          frame->picture.width,
+          frame->picture.height,
+          vp_api_picture_get_pixelformat_name( frame->picture.format ),
+          frame->size,
+          frame->refcount,
+          frame->owner != NULL ? frame->owner : "?");
+    count++;
+  }
+
+  PRINT("Frame pool : %d frames in use (high water %d), %d bytes held (high water %d), %d huge page frames, %d/%d acquires reused\n",
+        frame_pool.stats.frames_in_use,
+        frame_pool.stats.frames_high_water,
+        frame_pool.stats.bytes,
+        frame_pool.stats.bytes_high_water,
+        frame_pool.stats.hugepage_frames,
+        frame_pool.stats.reuses,
+        frame_pool.stats.acquires);
+
+  vp_os_mutex_unlock( &frame_pool_mutex );
+
+  return count;
+}
@@ -0,0 +1,83 @@
+/**
+ *  @file     vp_api_frame_pool.h
+ *  @brief    VP Api. Shared pool of reference counted picture buffers
+ *
+ *  Frames are 64 bytes aligned (huge page backed on Linux when large enough)
+ *  and recycled instead of being freed, so that stages can hand the same
+ *  buffer to several consumers (display, recording, vision) by taking a
+ *  reference instead of copying it.
+ */
+
+#ifndef _VP_API_FRAME_POOL_H_
+#define _VP_API_FRAME_POOL_H_
+
+#include <VP_Os/vp_os_types.h>
+#include <VP_Api/vp_api_picture.h>
+
+#ifdef USE_ELINUX
+#define VP_API_FRAME_ALIGN            256      // P6 DMA
+#else
+#define VP_API_FRAME_ALIGN            64
+#endif
+#define VP_API_FRAME_POOL_MAX_FREE    16       // Free frames kept for reuse, others are released
+#define VP_API_FRAME_HUGEPAGE_SIZE    (2*1024*1024)
+
+#define VP_API_FRAME_FLAG_HUGEPAGE    0x01     // Data mapped with MAP_HUGETLB
+#define VP_API_FRAME_FLAG_MMAP        0x02     // Frame must be released with munmap
+
+typedef struct _vp_api_frame_t
+{
+  vp_api_picture_t          picture;    // Buffers point into data
+  uint8_t*                  data;       // VP_API_FRAME_ALIGN aligned
+  uint32_t                  capacity;   // Usable bytes in data
+  uint32_t                  size;       // Bytes used by picture
+  int32_t                   refcount;   // 0 : frame is in the free list
+  uint32_t                  flags;
+  const char*               owner;      // Requester, for leak reports
+  struct _vp_api_frame_t*   next;       // Free list or in use list
+  struct _vp_api_frame_t*   prev;
+} vp_api_frame_t;
+
+typedef struct _vp_api_frame_pool_stats_t
+{
+  uint32_t  frames;             // Frames backed by memory (in use + free)
+  uint32_t  frames_in_use;
+  uint32_t  frames_high_water;  // Max frames_in_use
+  uint32_t  bytes;              // Memory held by the pool
+  uint32_t  bytes_high_water;
+  uint32_t  hugepage_frames;
+  uint32_t  acquires;
+  uint32_t  reuses;             // Acquires served from the free list
+} vp_api_frame_pool_stats_t;
+
+/**
+ * Get a frame able to hold a width x height picture, refcount is 1.
+ * owner is kept (not copied) for vp_api_frame_pool_print_leaks.
+ */
+vp_api_frame_t* vp_api_frame_acquire( uint32_t width, uint32_t height, enum PixelFormat format, const char* owner );
+
+/** Take one more reference on frame */
+vp_api_frame_t* vp_api_frame_ref( vp_api_frame_t* frame );
+
+/** Drop a reference, frame goes back to the pool with the last one */
+void vp_api_frame_unref( vp_api_frame_t* frame );
+
+/**
+ * Frame that the caller may modify : frame itself when the caller holds the only
+ * reference, otherwise a copy, and the caller's reference on frame is dropped.
+ * Returns NULL (frame still referenced) if the copy could not be allocated.
+ */
+vp_api_frame_t* vp_api_frame_make_writable( vp_api_frame_t* frame, const char* owner );
+
+/** Frame owning a buffer returned in vp_api_frame_t.data / picture.raw, NULL if not from the pool */
+vp_api_frame_t* vp_api_frame_from_data( void* data );
+
+C_RESULT vp_api_frame_pool_get_stats( vp_api_frame_pool_stats_t* stats );
+
+/** Release free frames */
+C_RESULT vp_api_frame_pool_trim( void );
+
+/** Print frames still referenced, returns their count */
+int32_t vp_api_frame_pool_print_leaks( void );
+
+#endif // _VP_API_FRAME_POOL_H_
@@ -17,6 +17,7 @@
 
 #include <VP_Api/vp_api.h>
 #include <VP_Api/vp_api_picture.h>
+#include <VP_Api/vp_api_frame_pool.h>
 #include <VP_Os/vp_os_malloc.h>
 #include <stdio.h>
 
@@ -28,82 +29,33 @@ static inline int roundUp(int x,int m)
 }
 
 
-typedef struct{
-	int width,height;
-	char requester[128];
-	void * address;
-	int size;
-}vp_api_picture_allocation_log_t;
-
-static vp_api_picture_allocation_log_t picturelog[128];
-static int log_size = 0;
-
 C_RESULT vp_api_picture_print_allocator_log()
 {
-	int i;
-	for (i=0;i<log_size;i++){
-		printf("Allocated vp_api_picture #%d : %dx%d address %p size %d \n",
-				i,
-				picturelog[i].width,
-				picturelog[i].height,
-				picturelog[i].address,
-				picturelog[i].size);
-	}
-	
+	/* Pictures are allocated in the shared frame pool, which tracks them */
+	vp_api_frame_pool_print_leaks();
+
 	return C_OK;
 }
 
 C_RESULT vp_api_picture_alloc(vp_api_picture_t * pic,const int width,const int height,enum PixelFormat format)
 {
-	int picture_size;
+	vp_api_frame_t * frame;
 
 	/* Params check */
 		if (NULL==pic) { return C_OK; }
 
 		vp_os_memset(pic,0,sizeof(*pic));
 
-	/* Fill deprecated useless stuff */
-		pic->blockline = 0;
-		pic->complete = 1;
-		pic->y_pad = 0;
-		pic->c_pad = 0;
-
-	/* Basic information */
-		pic->format = format;
-		pic->width = width;
-		pic->height = height;
-
 	/* Buffers informations and allocation */
 		switch(format)
 		{
 		case PIX_FMT_YUV422:
 		case PIX_FMT_UYVY422:
 		case PIX_FMT_VYUY422:
-			pic->y_line_size = 2*width;
-			pic->cb_line_size = 0;
-			pic->cr_line_size = 0;
-			picture_size = pic->y_line_size*(roundUp(pic->height,ROUNDUP));
-
-			#ifdef USE_ELINUX
-				pic->raw = vp_os_aligned_malloc(picture_size,256);
-			#else
-				pic->raw  = vp_os_malloc(picture_size);
-			#endif
-		break;
-
 		case PIX_FMT_YUV420P:
-			pic->y_line_size = width;
-			pic->cb_line_size = width/2;
-			pic->cr_line_size = width/2;
-			picture_size = (pic->y_line_size  * (roundUp(pic->height,ROUNDUP))) +
-						   (pic->cb_line_size * (roundUp(pic->height,ROUNDUP))/2) +
-						   (pic->cr_line_size * (roundUp(pic->height,ROUNDUP))/2);
-
-			#ifdef USE_ELINUX
-				pic->raw = vp_os_aligned_malloc(picture_size,256);
-			#else
-				pic->raw = vp_os_malloc(picture_size);
-			#endif
+			/* Frame pool buffers are VP_API_FRAME_ALIGN aligned */
+			frame = vp_api_frame_acquire(width,roundUp(height,ROUNDUP),format,"vp_api_picture_alloc");
+			if (NULL==frame) { return C_FAIL; }
 		break;
 
 		default:
@@ -111,14 +63,17 @@ C_RESULT vp_api_picture_alloc(vp_api_picture_t * pic,const int width,const int h
 			return C_FAIL;
 		}
 
-		vp_api_picture_format_to_buf_address(pic);
+	/* Basic information, line sizes come from the pool */
+		vp_os_memcpy(pic,&frame->picture,sizeof(*pic));
+		pic->height = height;
 
-		/* Keep track of allocated pictures for debugging */
-		picturelog[log_size].width  = width;
-		picturelog[log_size].height = height;
-		picturelog[log_size].address = pic->raw;
-		picturelog[log_size].size = picture_size;
-		log_size++;
+	/* Fill deprecated useless stuff */
+		pic->blockline = 0;
+		pic->complete = 1;
+		pic->y_pad = 0;
+		pic->c_pad = 0;
+
+		vp_api_picture_format_to_buf_address(pic);
 
 #if 0
 		vp_api_picture_print_allocator_log();
@@ -127,6 +82,28 @@ C_RESULT vp_api_picture_alloc(vp_api_picture_t * pic,const int width,const int h
 	return C_OK;
 }
 
+C_RESULT vp_api_picture_free(vp_api_picture_t * pic)
+{
+	vp_api_frame_t * frame;
+
+	if (NULL==pic || NULL==pic->raw) { return C_OK; }
+
+	frame = vp_api_frame_from_data(pic->raw);
+	if (NULL==frame) {
+		printf("%s:%d - Picture %p was not allocated by vp_api_picture_alloc.\n",__FUNCTION__,__LINE__,pic->raw);
+		return C_FAIL;
+	}
+
+	vp_api_frame_unref(frame);
+
+	pic->raw    = NULL;
+	pic->y_buf  = NULL;
+	pic->cb_buf = NULL;
+	pic->cr_buf = NULL;
+
+	return C_OK;
+}
+
 int vp_api_picture_get_buffer_size(const vp_api_picture_t * pic)
 {
 	if(NULL==pic) { return 0; }
@@ -167,6 +167,7 @@ vp_api_picture_t;
 
 C_RESULT vp_api_picture_print_allocator_log();
 C_RESULT vp_api_picture_alloc(vp_api_picture_t * pic,const int width,const int height,enum PixelFormat format);
+C_RESULT vp_api_picture_free(vp_api_picture_t * pic);
 int vp_api_picture_get_buffer_size(const vp_api_picture_t * pic);
 const char * vp_api_picture_get_filename_extension(const vp_api_picture_t * pic);
 const char * vp_api_picture_get_pixelformat_name(enum PixelFormat fmt);
@@ -20,6 +20,7 @@
 #include <VP_Stages/vp_stages_yuv2rgb.h>
 #include <VP_Stages/vp_stages_buffer_to_picture.h>
 #include <VP_Stages/vp_stages_frame_pipe.h>
+#include <VP_Stages/vp_stages_frame_broadcast.h>
 
 ///////////////////////////////////////////////
 // USEFULL FUNCTIONS
@@ -98,6 +99,22 @@ const vp_api_stage_funcs_t vp_stages_frame_pipe_fetch_funcs =
   (vp_api_stage_close_t) vp_stages_frame_pipe_fetch_close
 };
 
+const vp_api_stage_funcs_t vp_stages_frame_broadcast_sender_funcs =
+{
+  NULL,
+  (vp_api_stage_open_t) vp_stages_frame_broadcast_sender_open,
+  (vp_api_stage_transform_t) vp_stages_frame_broadcast_sender_transform,
+  (vp_api_stage_close_t) vp_stages_frame_broadcast_sender_close
+};
+
+const vp_api_stage_funcs_t vp_stages_frame_broadcast_receiver_funcs =
+{
+  NULL,
+  (vp_api_stage_open_t) vp_stages_frame_broadcast_receiver_open,
+  (vp_api_stage_transform_t) vp_stages_frame_broadcast_receiver_transform,
+  (vp_api_stage_close_t) vp_stages_frame_broadcast_receiver_close
+};
+
 const vp_api_stage_funcs_t vp_stages_buffer_to_picture_funcs =
 {
   NULL,
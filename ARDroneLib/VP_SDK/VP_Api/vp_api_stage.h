@@ -78,6 +78,9 @@ extern const vp_api_stage_funcs_t vp_stages_frame_pipe_sender_funcs;
 extern const vp_api_stage_funcs_t vp_stages_frame_pipe_receiver_funcs;
 extern const vp_api_stage_funcs_t vp_stages_frame_pipe_fetch_funcs;
 
+extern const vp_api_stage_funcs_t vp_stages_frame_broadcast_sender_funcs;
+extern const vp_api_stage_funcs_t vp_stages_frame_broadcast_receiver_funcs;
+
 extern const vp_api_stage_funcs_t vp_stages_video_mixer_funcs;
 
 extern const vp_api_stage_funcs_t vp_stages_buffer_to_picture_funcs;
@@ -217,11 +217,18 @@ typedef struct _vp_com_socket_t
   uint32_t                  is_multicast;                     /// tells if the socket is in multicast mode or not
   uint32_t                  multicast_base_addr;              /// base address used to compute multicast address to use
 
+  uint32_t                  rcv_buffer_size;                  /// SO_RCVBUF applied at opening (0 : system default)
+  uint32_t                  snd_buffer_size;                  /// SO_SNDBUF applied at opening (0 : system default)
+  uint32_t                  timestamps;                       /// 1 : udp reads report the kernel reception time (rx_timestamp)
+  uint32_t                  reuse_address;                    /// 1 : SO_REUSEADDR applied at opening (port shared with a local drone simulator)
+
   /// Private data
   void*                     priv;                             /// socket number
   VP_COM_SOCKET_STATE       is_disable;                       /// tells if the socket is enable or not
   struct _vp_com_socket_t*  server;                           /// Param only used when socket is client
   uint32_t                  queue_length;                     /// only for server socket
+  uint32_t                  rx_timestamp_sec;                 /// Kernel reception time of the last udp datagram read
+  uint32_t                  rx_timestamp_nsec;                /// (0 if timestamps are disabled or not supported)
 
 } vp_com_socket_t;
 
@@ -0,0 +1,449 @@
+#include <VP_Com/vp_com_reactor.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#if defined(__linux__) || defined (__elinux__) || defined(TARGET_OS_ANDROID)
+#include <sys/epoll.h>
+#define VP_COM_REACTOR_EPOLL 1
+#else
+#include <poll.h>
+#endif
+
+#define VP_COM_REACTOR_FIRST_TIMER_ID (-2)
+
+static uint32_t vp_com_reactor_time_ms( void )
+{
+  struct timeval tv;
+  gettimeofday( &tv, NULL );
+  return (uint32_t)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+}
+
+static vp_com_reactor_source_t* vp_com_reactor_find( vp_com_reactor_t* reactor, int32_t fd )
+{
+  int32_t i;
+
+  for( i = 0; i < VP_COM_REACTOR_MAX_SOURCES; i++ )
+  {
+    if( reactor->sources[i].used && reactor->sources[i].fd == fd )
+      return &reactor->sources[i];
+  }
+
+  return NULL;
+}
+
+static vp_com_reactor_source_t* vp_com_reactor_alloc( vp_com_reactor_t* reactor )
+{
+  int32_t i;
+
+  for( i = 0; i < VP_COM_REACTOR_MAX_SOURCES; i++ )
+  {
+    if( !reactor->sources[i].used )
+    {
+      reactor->sources[i].used = TRUE;
+      reactor->sources[i].generation++;
+      return &reactor->sources[i];
+    }
+  }
+
+  return NULL;
+}
+
+static void vp_com_reactor_wakeup( vp_com_reactor_t* reactor )
+{
+  char c = 0;
+
+  if( write( reactor->wakeup[1], &c, 1 ) < 0 && errno != EAGAIN )
+  {
+    DEBUG_PRINT_SDK( "vp_com_reactor : wakeup failed (%d)\n", errno );
+  }
+}
+
+#ifdef VP_COM_REACTOR_EPOLL
+static uint32_t vp_com_reactor_epoll_events( uint32_t events )
+{
+  return ((events & VP_COM_REACTOR_READ) ? EPOLLIN : 0) | ((events & VP_COM_REACTOR_WRITE) ? EPOLLOUT : 0);
+}
+
+static int32_t vp_com_reactor_epoll_ctl( vp_com_reactor_t* reactor, int32_t op, vp_com_reactor_source_t* source )
+{
+  struct epoll_event ev;
+
+  vp_os_memset( &ev, 0, sizeof(ev) );
+  ev.events   = vp_com_reactor_epoll_events( source->events );
+  // Slot and generation : events of a removed source are recognized and ignored
+  ev.data.u64 = ((uint64_t)source->generation << 32) | (uint32_t)(source - &reactor->sources[0]);
+
+  return epoll_ctl( reactor->poll_fd, op, source->fd, &ev );
+}
+#endif // VP_COM_REACTOR_EPOLL
+
+C_RESULT vp_com_reactor_init( vp_com_reactor_t* reactor )
+{
+  vp_os_memset( reactor, 0, sizeof(vp_com_reactor_t) );
+  reactor->poll_fd        = -1;
+  reactor->next_timer_id  = VP_COM_REACTOR_FIRST_TIMER_ID;
+  reactor->running        = TRUE;
+
+  if( pipe( reactor->wakeup ) < 0 )
+    return C_FAIL;
+
+  fcntl( reactor->wakeup[0], F_SETFL, fcntl( reactor->wakeup[0], F_GETFL, 0 ) | O_NONBLOCK );
+  fcntl( reactor->wakeup[1], F_SETFL, fcntl( reactor->wakeup[1], F_GETFL, 0 ) | O_NONBLOCK );
+
+#ifdef VP_COM_REACTOR_EPOLL
+  {
+    struct epoll_event ev;
+
+    reactor->poll_fd = epoll_create( VP_COM_REACTOR_MAX_SOURCES );
+    if( reactor->poll_fd < 0 )
+    {
+      close( reactor->wakeup[0] );
+      close( reactor->wakeup[1] );
+      return C_FAIL;
+    }
+
+    vp_os_memset( &ev, 0, sizeof(ev) );
+    ev.events   = EPOLLIN;
+    ev.data.u64 = (uint64_t)-1;
+    epoll_ctl( reactor->poll_fd, EPOLL_CTL_ADD, reactor->wakeup[0], &ev );
+  }
+#endif // VP_COM_REACTOR_EPOLL
+
+  vp_os_mutex_init( &reactor->mutex );
+
+  return C_OK;
+}
+
+C_RESULT vp_com_reactor_shutdown( vp_com_reactor_t* reactor )
+{
+  if( reactor->poll_fd >= 0 )
+    close( reactor->poll_fd );
+
+  close( reactor->wakeup[0] );
+  close( reactor->wakeup[1] );
+  vp_os_mutex_destroy( &reactor->mutex );
+
+  return C_OK;
+}
+
+C_RESULT vp_com_reactor_add( vp_com_reactor_t* reactor, int32_t fd, uint32_t events, vp_com_reactor_handler_t handler, void* data )
+{
+  vp_com_reactor_source_t* source;
+  C_RESULT res = C_OK;
+
+  if( fd < 0 || handler == NULL )
+    return C_FAIL;
+
+  vp_os_mutex_lock( &reactor->mutex );
+
+  source = vp_com_reactor_find( reactor, fd ) == NULL ? vp_com_reactor_alloc( reactor ) : NULL;
+  if( source != NULL )
+  {
+    source->fd        = fd;
+    source->events    = events;
+    source->is_timer  = FALSE;
+    source->handler   = handler;
+    source->data      = data;
+
+#ifdef VP_COM_REACTOR_EPOLL
+    if( vp_com_reactor_epoll_ctl( reactor, EPOLL_CTL_ADD, source ) < 0 )
+    {
+      source->used = FALSE;
+      res = C_FAIL;
+    }
+#endif // VP_COM_REACTOR_EPOLL
+  }
+  else
+  {
+    res = C_FAIL;
+  }
+
+  vp_os_mutex_unlock( &reactor->mutex );
+
+  vp_com_reactor_wakeup( reactor );
+
+  return res;
+}
+
+C_RESULT vp_com_reactor_modify( vp_com_reactor_t* reactor, int32_t fd, uint32_t events )
+{
+  vp_com_reactor_source_t* source;
+  C_RESULT res = C_FAIL;
+
+  vp_os_mutex_lock( &reactor->mutex );
+
+  source = vp_com_reactor_find( reactor, fd );
+  if( source != NULL && !source->is_timer )
+  {
+    source->events = events;
+    res = C_OK;
+
+#ifdef VP_COM_REACTOR_EPOLL
+    if( vp_com_reactor_epoll_ctl( reactor, EPOLL_CTL_MOD, source ) < 0 )
+      res = C_FAIL;
+#endif // VP_COM_REACTOR_EPOLL
+  }
+
+  vp_os_mutex_unlock( &reactor->mutex );
+
+  return res;
+}
+
+C_RESULT vp_com_reactor_remove( vp_com_reactor_t* reactor, int32_t fd )
+{
+  vp_com_reactor_source_t* source;
+  C_RESULT res = C_FAIL;
+
+  vp_os_mutex_lock( &reactor->mutex );
+
+  source = vp_com_reactor_find( reactor, fd );
+  if( source != NULL )
+  {
+#ifdef VP_COM_REACTOR_EPOLL
+    if( !source->is_timer )
+    {
+      struct epoll_event ev; // Ignored, but must not be NULL on kernels before 2.6.9
+      epoll_ctl( reactor->poll_fd, EPOLL_CTL_DEL, source->fd, &ev );
+    }
+#endif // VP_COM_REACTOR_EPOLL
+
+    source->used = FALSE;
+    res = C_OK;
+  }
+
+  vp_os_mutex_unlock( &reactor->mutex );
+
+  return res;
+}
+
+C_RESULT vp_com_reactor_add_timer( vp_com_reactor_t* reactor, uint32_t period_ms, vp_com_reactor_handler_t handler, void* data, int32_t* timer_id )
+{
+  vp_com_reactor_source_t* source;
+  C_RESULT res = C_FAIL;
+
+  if( period_ms == 0 || handler == NULL )
+    return C_FAIL;
+
+  vp_os_mutex_lock( &reactor->mutex );
+
+  source = vp_com_reactor_alloc( reactor );
+  if( source != NULL )
+  {
+    source->fd        = reactor->next_timer_id--;
+    source->events    = VP_COM_REACTOR_TIMER;
+    source->is_timer  = TRUE;
+    source->period    = period_ms;
+    source->deadline  = vp_com_reactor_time_ms() + period_ms;
+    source->handler   = handler;
+    source->data      = data;
+
+    if( timer_id != NULL )
+      *timer_id = source->fd;
+
+    res = C_OK;
+  }
+
+  vp_os_mutex_unlock( &reactor->mutex );
+
+  vp_com_reactor_wakeup( reactor );
+
+  return res;
+}
+
+/**
+ * Calls the handler of a source if it is still registered with the same generation.
+ * Called without the reactor mutex so that handlers can modify the sources.
+ */
+static void vp_com_reactor_dispatch( vp_com_reactor_t* reactor, int32_t slot, uint32_t generation, uint32_t events )
+{
+  vp_com_reactor_source_t* source = &reactor->sources[slot];
+  vp_com_reactor_handler_t handler = NULL;
+  void* data = NULL;
+  int32_t fd = -1;
+
+  vp_os_mutex_lock( &reactor->mutex );
+  if( source->used && source->generation == generation )
+  {
+    handler = source->handler;
+    data    = source->data;
+    fd      = source->fd;
+  }
+  vp_os_mutex_unlock( &reactor->mutex );
+
+  if( handler != NULL && VP_FAILED( handler( fd, events, data ) ) )
+  {
+    vp_os_mutex_lock( &reactor->mutex );
+    if( source->used && source->generation == generation )
+    {
+      vp_os_mutex_unlock( &reactor->mutex );
+      vp_com_reactor_remove( reactor, fd );
+    }
+    else
+    {
+      vp_os_mutex_unlock( &reactor->mutex );
+    }
+  }
+}
+
+static void vp_com_reactor_dispatch_timers( vp_com_reactor_t* reactor )
+{
+  uint32_t now = vp_com_reactor_time_ms();
+  uint32_t generation;
+  bool_t expired;
+  int32_t i;
+
+  for( i = 0; i < VP_COM_REACTOR_MAX_SOURCES; i++ )
+  {
+    vp_os_mutex_lock( &reactor->mutex );
+    expired     = FALSE;
+    generation  = reactor->sources[i].generation;
+    if( reactor->sources[i].used && reactor->sources[i].is_timer && (int32_t)(now - reactor->sources[i].deadline) >= 0 )
+    {
+      expired = TRUE;
+      reactor->sources[i].deadline += reactor->sources[i].period;
+      // Late by more than one period : do not try to catch up
+      if( (int32_t)(now - reactor->sources[i].deadline) >= 0 )
+        reactor->sources[i].deadline = now + reactor->sources[i].period;
+    }
+    vp_os_mutex_unlock( &reactor->mutex );
+
+    if( expired )
+      vp_com_reactor_dispatch( reactor, i, generation, VP_COM_REACTOR_TIMER );
+  }
+}
+
+static int32_t vp_com_reactor_timeout( vp_com_reactor_t* reactor, int32_t timeout_ms )
+{
+  uint32_t now = vp_com_reactor_time_ms();
+  int32_t i, delay;
+
+  vp_os_mutex_lock( &reactor->mutex );
+  for( i = 0; i < VP_COM_REACTOR_MAX_SOURCES; i++ )
+  {
+    if( reactor->sources[i].used && reactor->sources[i].is_timer )
+    {
+      delay = (int32_t)(reactor->sources[i].deadline - now);
+      if( delay < 0 )
+        delay = 0;
+      if( timeout_ms < 0 || delay < timeout_ms )
+        timeout_ms = delay;
+    }
+  }
+  vp_os_mutex_unlock( &reactor->mutex );
+
+  return timeout_ms;
+}
+
+static void vp_com_reactor_drain_wakeup( vp_com_reactor_t* reactor )
+{
+  char buffer[64];
+
+  while( read( reactor->wakeup[0], buffer, sizeof(buffer) ) > 0 );
+}
+
+C_RESULT vp_com_reactor_run_once( vp_com_reactor_t* reactor, int32_t timeout_ms )
+{
+  int32_t i, num_events;
+
+  timeout_ms = vp_com_reactor_timeout( reactor, timeout_ms );
+
+#ifdef VP_COM_REACTOR_EPOLL
+  {
+    struct epoll_event events[VP_COM_REACTOR_MAX_SOURCES + 1];
+    uint32_t ev;
+
+    num_events = epoll_wait( reactor->poll_fd, events, VP_COM_REACTOR_MAX_SOURCES + 1, timeout_ms );
+    if( num_events < 0 && errno != EINTR )
+      return C_FAIL;
+
+    for( i = 0; i < num_events; i++ )
+    {
+      if( events[i].data.u64 == (uint64_t)-1 )
+      {
+        vp_com_reactor_drain_wakeup( reactor );
+        continue;
+      }
+
+      ev  = (events[i].events & EPOLLIN) ? VP_COM_REACTOR_READ : 0;
+      ev |= (events[i].events & EPOLLOUT) ? VP_COM_REACTOR_WRITE : 0;
+      ev |= (events[i].events & (EPOLLERR | EPOLLHUP)) ? VP_COM_REACTOR_ERROR : 0;
+
+      vp_com_reactor_dispatch( reactor, (int32_t)(events[i].data.u64 & 0xFFFFFFFF), (uint32_t)(events[i].data.u64 >> 32), ev );
+    }
+  }
+#else
+  {
+    struct pollfd fds[VP_COM_REACTOR_MAX_SOURCES + 1];
+    int32_t slots[VP_COM_REACTOR_MAX_SOURCES + 1];
+    uint32_t generations[VP_COM_REACTOR_MAX_SOURCES + 1];
+    int32_t num_fds = 1;
+    uint32_t ev;
+
+    fds[0].fd     = reactor->wakeup[0];
+    fds[0].events = POLLIN;
+
+    vp_os_mutex_lock( &reactor->mutex );
+    for( i = 0; i < VP_COM_REACTOR_MAX_SOURCES; i++ )
+    {
+      if( reactor->sources[i].used && !reactor->sources[i].is_timer )
+      {
+        fds[num_fds].fd       = reactor->sources[i].fd;
+        fds[num_fds].events   = ((reactor->sources[i].events & VP_COM_REACTOR_READ) ? POLLIN : 0)
+                              | ((reactor->sources[i].events & VP_COM_REACTOR_WRITE) ? POLLOUT : 0);
+        fds[num_fds].revents  = 0;
+        slots[num_fds]        = i;
+        generations[num_fds]  = reactor->sources[i].generation;
+        num_fds++;
+      }
+    }
+    vp_os_mutex_unlock( &reactor->mutex );
+
+    num_events = poll( fds, num_fds, timeout_ms );
+    if( num_events < 0 && errno != EINTR )
+      return C_FAIL;
+
+    if( num_events > 0 && (fds[0].revents & POLLIN) )
+      vp_com_reactor_drain_wakeup( reactor );
+
+    for( i = 1; num_events > 0 && i < num_fds; i++ )
+    {
+      if( fds[i].revents == 0 )
+        continue;
+
+      ev  = (fds[i].revents & POLLIN) ? VP_COM_REACTOR_READ : 0;
+      ev |= (fds[i].revents & POLLOUT) ? VP_COM_REACTOR_WRITE : 0;
+      ev |= (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) ? VP_COM_REACTOR_ERROR : 0;
+
+      vp_com_reactor_dispatch( reactor, slots[i], generations[i], ev );
+    }
+  }
+#endif // VP_COM_REACTOR_EPOLL
+
+  vp_com_reactor_dispatch_timers( reactor );
+
+  return C_OK;
+}
+
+C_RESULT vp_com_reactor_run( vp_com_reactor_t* reactor )
+{
+  C_RESULT res = C_OK;
+
+  while( reactor->running && VP_SUCCEEDED(res) )
+    res = vp_com_reactor_run_once( reactor, -1 );
+
+  return res;
+}
+
+C_RESULT vp_com_reactor_stop( vp_com_reactor_t* reactor )
+{
+  reactor->running = FALSE;
+  vp_com_reactor_wakeup( reactor );
+
+  return C_OK;
+}
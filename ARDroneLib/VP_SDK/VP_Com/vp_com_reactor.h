@@ -0,0 +1,76 @@
+/**
+ * @file vp_com_reactor.h
+ * @date 2026/10/18
+ *
+ * Single thread event loop : file descriptors and periodic timers are
+ * registered with a handler, vp_com_reactor_run() waits for all of them at
+ * once (epoll on Linux, poll elsewhere) and calls the handlers from the
+ * calling thread.
+ *
+ * Handlers may add, modify or remove any source, including their own.
+ * Other threads may add or remove sources and stop the reactor at any time.
+ */
+
+#ifndef _VP_COM_REACTOR_H_
+#define _VP_COM_REACTOR_H_
+
+#include <VP_Os/vp_os_types.h>
+#include <VP_Os/vp_os_signal.h>
+
+#define VP_COM_REACTOR_MAX_SOURCES  (64)
+
+typedef enum _VP_COM_REACTOR_EVENTS
+{
+  VP_COM_REACTOR_READ   = 1 << 0,
+  VP_COM_REACTOR_WRITE  = 1 << 1,
+  VP_COM_REACTOR_ERROR  = 1 << 2,   // Only reported to handlers (error or hang up)
+  VP_COM_REACTOR_TIMER  = 1 << 3    // Only reported to handlers
+} VP_COM_REACTOR_EVENTS;
+
+/**
+ * For timers, fd is the identifier returned by vp_com_reactor_add_timer.
+ * Returning C_FAIL removes the source (a timer is freed, a file descriptor is not closed).
+ */
+typedef C_RESULT (*vp_com_reactor_handler_t)( int32_t fd, uint32_t events, void* data );
+
+typedef struct _vp_com_reactor_source_t
+{
+  int32_t                   fd;
+  uint32_t                  events;
+  uint32_t                  generation;   // Detects sources removed while their events are pending
+  bool_t                    used;
+  bool_t                    is_timer;
+  uint32_t                  period;       // Timers only (ms)
+  uint32_t                  deadline;     // Timers only (ms)
+  vp_com_reactor_handler_t  handler;
+  void*                     data;
+} vp_com_reactor_source_t;
+
+typedef struct _vp_com_reactor_t
+{
+  int32_t                   poll_fd;      // epoll instance (-1 with the poll backend)
+  int32_t                   wakeup[2];    // Pipe used to interrupt the wait from other threads
+  volatile bool_t           running;
+  int32_t                   next_timer_id;
+  vp_os_mutex_t             mutex;
+  vp_com_reactor_source_t   sources[VP_COM_REACTOR_MAX_SOURCES];
+} vp_com_reactor_t;
+
+C_RESULT vp_com_reactor_init( vp_com_reactor_t* reactor );
+C_RESULT vp_com_reactor_shutdown( vp_com_reactor_t* reactor );
+
+C_RESULT vp_com_reactor_add( vp_com_reactor_t* reactor, int32_t fd, uint32_t events, vp_com_reactor_handler_t handler, void* data );
+C_RESULT vp_com_reactor_modify( vp_com_reactor_t* reactor, int32_t fd, uint32_t events );
+C_RESULT vp_com_reactor_remove( vp_com_reactor_t* reactor, int32_t fd );
+
+/// Periodic timer, first expiration after period_ms. *timer_id can be given to vp_com_reactor_remove.
+C_RESULT vp_com_reactor_add_timer( vp_com_reactor_t* reactor, uint32_t period_ms, vp_com_reactor_handler_t handler, void* data, int32_t* timer_id );
+
+/// Waits at most timeout_ms (-1 : up to the next timer) then dispatches ready sources
+C_RESULT vp_com_reactor_run_once( vp_com_reactor_t* reactor, int32_t timeout_ms );
+
+/// Dispatches until vp_com_reactor_stop is called (a stopped reactor must be initialized again)
+C_RESULT vp_com_reactor_run( vp_com_reactor_t* reactor );
+C_RESULT vp_com_reactor_stop( vp_com_reactor_t* reactor );
+
+#endif // _VP_COM_REACTOR_H_
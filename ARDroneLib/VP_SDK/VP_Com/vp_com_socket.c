@@ -38,6 +38,51 @@ extern int inet_addr(const char *);
 
 
 
+/// Applies the buffer sizes, timestamping and address reuse requested in sck
+static void vp_com_socket_set_options( int s, vp_com_socket_t* sck )
+{
+  int value;
+  socklen_t len;
+
+  if( sck->rcv_buffer_size > 0 )
+  {
+    value = sck->rcv_buffer_size;
+#ifdef SO_RCVBUFFORCE
+    // Goes beyond net.core.rmem_max when the process is allowed to
+    if( setsockopt( s, SOL_SOCKET, SO_RCVBUFFORCE, (char*)&value, sizeof(value) ) < 0 )
+#endif
+    setsockopt( s, SOL_SOCKET, SO_RCVBUF, (char*)&value, sizeof(value) );
+
+    len = sizeof(value);
+    if( getsockopt( s, SOL_SOCKET, SO_RCVBUF, (char*)&value, &len ) == 0 && (uint32_t)value < sck->rcv_buffer_size )
+      PRINT("Socket receive buffer limited to %d bytes (%d requested)\n", value, sck->rcv_buffer_size);
+  }
+
+  if( sck->snd_buffer_size > 0 )
+  {
+    value = sck->snd_buffer_size;
+#ifdef SO_SNDBUFFORCE
+    if( setsockopt( s, SOL_SOCKET, SO_SNDBUFFORCE, (char*)&value, sizeof(value) ) < 0 )
+#endif
+    setsockopt( s, SOL_SOCKET, SO_SNDBUF, (char*)&value, sizeof(value) );
+  }
+
+  if( sck->timestamps )
+  {
+#ifdef SO_TIMESTAMPNS
+    value = 1;
+    if( setsockopt( s, SOL_SOCKET, SO_TIMESTAMPNS, (char*)&value, sizeof(value) ) < 0 )
+#endif
+      PRINT("Kernel reception timestamps are not available on this socket\n");
+  }
+
+  if( sck->reuse_address )
+  {
+    value = 1;
+    setsockopt( s, SOL_SOCKET, SO_REUSEADDR, (char*)&value, sizeof(value) );
+  }
+}
+
 C_RESULT vp_com_open_socket(vp_com_socket_t* sck, Read* read, Write* write)
 {
   C_RESULT res = VP_COM_OK;
@@ -73,6 +118,9 @@ C_RESULT vp_com_open_socket(vp_com_socket_t* sck, Read* read, Write* write)
 
   VP_COM_CHECK( res );
 
+  // Before connect/bind so that the TCP window scale takes the receive buffer into account
+  vp_com_socket_set_options( s, sck );
+
   name.sin_family = AF_INET;
   name.sin_port   = htons( sck->port );
   switch( type )
@@ -259,84 +307,232 @@ C_RESULT vp_com_sockopt_ip(vp_com_t* vp_com, vp_com_socket_t* socket, VP_COM_SOC
 
 #ifdef CYGPKG_NET
 
-C_RESULT vp_com_read_udp_socket(vp_com_socket_t* sck, int8_t* buffer, int32_t* size)
+/// Converts the error of a failed udp read. *size is set to 0 for timeouts and interruptions.
+static C_RESULT vp_com_read_udp_error(int32_t* size)
+{
+  C_RESULT res = VP_COM_OK;
+
+#ifdef USE_MINGW32
+  switch( WSAGetLastError() )
+  {
+    case WSAEOPNOTSUPP:
+      PRINT("MSG_NOSIGNAL is not supported on this platform\n");
+      res = VP_COM_ERROR;
+      break;
+
+    case WSAEINTR:
+      *size = 0;
+      break;
+
+    case WSAENETDOWN:
+    case WSAETIMEDOUT:
+    case WSAECONNRESET:
+      PRINT("Connection with peer is not enabled\n");
+      res = VP_COM_ERROR;
+      break;
+  }
+#else
+  switch( errno )
+  {
+    case EAGAIN:
+    case EINTR:
+      *size = 0;
+      break;
+
+    case EOPNOTSUPP:
+      PRINT("MSG_NOSIGNAL is not supported on this platform\n");
+      res = VP_COM_ERROR;
+      break;
+
+    case EPIPE:
+    case ENOTCONN:
+    case ECONNRESET:
+      PRINT("Connection with peer is not enabled\n");
+      res = VP_COM_ERROR;
+      break;
+
+    default:
+      PRINT("recvfrom fails with error: %s\n", strerror(errno));
+      res = VP_COM_ERROR;
+      break;
+  }
+#endif // USE_MINGW32
+
+  return res;
+}
+
+#ifndef USE_MINGW32
+static void vp_com_udp_msghdr(struct msghdr* msg, struct iovec* iov, struct sockaddr_in* from, char* control, int32_t control_size)
+{
+  vp_os_memset( msg, 0, sizeof(struct msghdr) );
+  msg->msg_name       = from;
+  msg->msg_namelen    = sizeof(struct sockaddr_in);
+  msg->msg_iov        = iov;
+  msg->msg_iovlen     = 1;
+  msg->msg_control    = control;
+  msg->msg_controllen = control_size;
+}
+
+static void vp_com_udp_timestamp(struct msghdr* msg, uint32_t* sec, uint32_t* nsec)
+{
+  struct cmsghdr* cmsg;
+
+  *sec  = 0;
+  *nsec = 0;
+
+  for( cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg) )
+  {
+#ifdef SCM_TIMESTAMPNS
+    if( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS )
+    {
+      struct timespec ts;
+      vp_os_memcpy( &ts, CMSG_DATA(cmsg), sizeof(ts) );
+      *sec  = (uint32_t) ts.tv_sec;
+      *nsec = (uint32_t) ts.tv_nsec;
+    }
+#endif
+  }
+}
+#endif // USE_MINGW32
+
+#define VP_COM_UDP_CONTROL_SIZE 64
+
+/* Reads one datagram with the given recv flags, sck->block is not used */
+static C_RESULT vp_com_read_udp_socket_flags(vp_com_socket_t* sck, int8_t* buffer, int32_t* size, int flags)
 {
   C_RESULT res;
   int s = (int) sck->priv;
   struct sockaddr_in from;
 
-  socklen_t from_len = sizeof(from);
+  if(s >= 0)
+  {
+    res = VP_COM_OK;
+#ifdef USE_MINGW32
+    {
+      socklen_t from_len = sizeof(from);
+      *size = recvfrom(s, (char*)buffer, *size, flags, (struct sockaddr*)&from, &from_len );
+    }
+#else
+    {
+      struct iovec iov = { buffer, *size };
+      struct msghdr msg;
+      char control[VP_COM_UDP_CONTROL_SIZE];
+
+      vp_com_udp_msghdr( &msg, &iov, &from, control, sck->timestamps ? sizeof(control) : 0 );
+      *size = recvmsg(s, &msg, flags);
+      if( *size >= 0 && sck->timestamps )
+        vp_com_udp_timestamp( &msg, &sck->rx_timestamp_sec, &sck->rx_timestamp_nsec );
+    }
+#endif // USE_MINGW32
+
+    if(*size < 0)
+    {
+      res = vp_com_read_udp_error(size);
+    }
+    else
+    {
+      sck->scn   = from.sin_addr.s_addr;
+      sck->port  = ntohs(from.sin_port);
+    }
+  }
+  else
+  {
+    res = VP_COM_ERROR;
+  }
+
+  return res;
+}
 
+C_RESULT vp_com_read_udp_socket(vp_com_socket_t* sck, int8_t* buffer, int32_t* size)
+{
   int flags = MSG_NOSIGNAL;
   if (VP_COM_DONTWAIT == sck->block)
     flags |= MSG_DONTWAIT;
   else if (VP_COM_WAITALL == sck->block)
     flags |= MSG_WAITALL;
-    
 
-  if(s >= 0)
-  {
-    res = VP_COM_OK;
-    *size = recvfrom(s, (char*)buffer, *size, flags, (struct sockaddr*)&from, &from_len );
+  return vp_com_read_udp_socket_flags(sck, buffer, size, flags);
+}
 
-    if(*size < 0)
-    {
+C_RESULT vp_com_read_udp_socket_batch(vp_com_socket_t* sck, vp_com_datagram_t* datagrams, int32_t* count)
+{
+  C_RESULT res = VP_COM_OK;
+  int s = (int) sck->priv;
+  int32_t i, max = *count;
+  struct sockaddr_in from;
 
-#ifdef USE_MINGW32
-      switch( WSAGetLastError() )
-      {
-        case WSAEOPNOTSUPP:
-          PRINT("MSG_NOSIGNAL is not supported on this platform\n");
-          res = VP_COM_ERROR;
-          break;
+  int flags = MSG_NOSIGNAL;
+  if (VP_COM_DONTWAIT == sck->block)
+    flags |= MSG_DONTWAIT;
 
-        case WSAEINTR:
-          *size = 0;
-          break;
+  *count = 0;
 
-        case WSAENETDOWN:
-        case WSAETIMEDOUT:
-        case WSAECONNRESET:
-          PRINT("Connection with peer is not enabled\n");
-          res = VP_COM_ERROR;
-          break;
-      }
-#else
-      switch( errno )
-      {
-        case EAGAIN:
-        case EINTR:
-          *size = 0;
-          break;
+  if( s < 0 )
+    return VP_COM_ERROR;
 
-        case EOPNOTSUPP:
-          PRINT("MSG_NOSIGNAL is not supported on this platform\n");
-          res = VP_COM_ERROR;
-          break;
+  if( max > VP_COM_UDP_BATCH_MAX )
+    max = VP_COM_UDP_BATCH_MAX;
 
-        case EPIPE:
-        case ENOTCONN:
-        case ECONNRESET:
-          PRINT("Connection with peer is not enabled\n");
-          res = VP_COM_ERROR;
-          break;
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+  {
+    struct mmsghdr msgs[VP_COM_UDP_BATCH_MAX];
+    struct iovec iovs[VP_COM_UDP_BATCH_MAX];
+    struct sockaddr_in froms[VP_COM_UDP_BATCH_MAX];
+    char controls[VP_COM_UDP_BATCH_MAX][VP_COM_UDP_CONTROL_SIZE];
+    int32_t n, size;
 
-        default:
-          PRINT("recvfrom fails with error: %s\n", strerror(errno));
-          res = VP_COM_ERROR;
-          break;
-      }
-#endif // USE_MINGW32
+    for( i = 0; i < max; i++ )
+    {
+      iovs[i].iov_base  = datagrams[i].buffer;
+      iovs[i].iov_len   = datagrams[i].size;
+      vp_com_udp_msghdr( &msgs[i].msg_hdr, &iovs[i], &froms[i], controls[i], sck->timestamps ? VP_COM_UDP_CONTROL_SIZE : 0 );
+      msgs[i].msg_len   = 0;
     }
-    else
+
+    // Blocks (if allowed) for the first datagram only
+    n = recvmmsg( s, msgs, max, flags | MSG_WAITFORONE, NULL );
+    if( n < 0 )
     {
-      sck->scn   = from.sin_addr.s_addr;
-      sck->port  = ntohs(from.sin_port);
+      size = n;
+      return vp_com_read_udp_error( &size );
+    }
+
+    for( i = 0; i < n; i++ )
+    {
+      datagrams[i].size = msgs[i].msg_len;
+      vp_com_udp_timestamp( &msgs[i].msg_hdr, &datagrams[i].timestamp_sec, &datagrams[i].timestamp_nsec );
     }
+    if( n > 0 )
+      from = froms[n-1];
+    *count = n;
   }
-  else
+#else
+  for( i = 0; i < max; i++ )
   {
-    res = VP_COM_ERROR;
+    int32_t size = datagrams[i].size;
+
+    res = vp_com_read_udp_socket_flags( sck, datagrams[i].buffer, &size, flags );
+    if( VP_FAILED(res) || size <= 0 )
+      break;
+
+    datagrams[i].size           = size;
+    datagrams[i].timestamp_sec  = sck->rx_timestamp_sec;
+    datagrams[i].timestamp_nsec = sck->rx_timestamp_nsec;
+    (*count)++;
+
+    // Never wait for the following datagrams
+    flags |= MSG_DONTWAIT;
+  }
+  from.sin_addr.s_addr = sck->scn;
+  from.sin_port        = htons(sck->port);
+#endif
+
+  if( *count > 0 )
+  {
+    sck->scn               = from.sin_addr.s_addr;
+    sck->port              = ntohs(from.sin_port);
+    sck->rx_timestamp_sec  = datagrams[*count-1].timestamp_sec;
+    sck->rx_timestamp_nsec = datagrams[*count-1].timestamp_nsec;
   }
 
   return res;
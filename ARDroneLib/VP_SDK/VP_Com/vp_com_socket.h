@@ -16,6 +16,21 @@ C_RESULT vp_com_make_udp_target( vp_com_socket_t* sck );
 C_RESULT vp_com_read_udp_socket(vp_com_socket_t* sck, int8_t* buffer, int32_t* size);
 C_RESULT vp_com_write_udp_socket(vp_com_socket_t* sck, const int8_t* buffer, int32_t* size);
 
+#define VP_COM_UDP_BATCH_MAX 32
+
+typedef struct _vp_com_datagram_t
+{
+  int8_t*   buffer;           /// in : where to store the datagram
+  int32_t   size;             /// in : size of buffer, out : size of the datagram
+  uint32_t  timestamp_sec;    /// out : kernel reception time when sck->timestamps is set
+  uint32_t  timestamp_nsec;
+} vp_com_datagram_t;
+
+/// Reads up to *count queued datagrams in one call (recvmmsg when available).
+/// Waits for the first one according to sck->block, never for the following ones.
+/// *count is set to the number of datagrams read (0 on timeout).
+C_RESULT vp_com_read_udp_socket_batch(vp_com_socket_t* sck, vp_com_datagram_t* datagrams, int32_t* count);
+
 /// Read / Write functions that vp_com will return when you open a tcp socket
 C_RESULT vp_com_read_socket( vp_com_socket_t* socket, int8_t* buffer, int32_t* size );
 C_RESULT vp_com_write_socket( vp_com_socket_t* socket, const int8_t* buffer, int32_t* size );
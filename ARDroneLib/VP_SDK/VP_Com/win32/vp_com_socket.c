@@ -62,6 +62,17 @@ C_RESULT vp_com_open_socket(vp_com_socket_t* sck, Read* read, Write* write)
  // res_setsockopt = setsockopt(s,SOL_SOCKET,SO_REUSEADDR,(char*)&reuseaddroption,sizeof(reuseaddroption));
   res_setsockopt = setsockopt(s,SOL_SOCKET,SO_EXCLUSIVEADDRUSE,(char*)&exclusiveaddroption,sizeof(exclusiveaddroption));
 
+  if ( sck->rcv_buffer_size > 0 )
+  {
+    int size = sck->rcv_buffer_size;
+    setsockopt(s,SOL_SOCKET,SO_RCVBUF,(char*)&size,sizeof(size));
+  }
+  if ( sck->snd_buffer_size > 0 )
+  {
+    int size = sck->snd_buffer_size;
+    setsockopt(s,SOL_SOCKET,SO_SNDBUF,(char*)&size,sizeof(size));
+  }
+
   name.sin_family = AF_INET;
   name.sin_port   = htons( sck->port );
   switch( sck->type )
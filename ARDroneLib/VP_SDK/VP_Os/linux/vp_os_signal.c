@@ -5,6 +5,7 @@
  */
 
 #include "VP_Os/vp_os_signal.h"
+#include "VP_Os/vp_os_trace.h"
 
 #ifndef __USE_GNU
 #define __USE_GNU
@@ -31,6 +32,19 @@ vp_os_mutex_destroy(vp_os_mutex_t *mutex)
 void
 vp_os_mutex_lock(vp_os_mutex_t *mutex)
 {
+#ifdef VP_OS_TRACE_SUPPORTED
+  // Only contended locks show up in the trace
+  if(vp_os_trace_enabled)
+  {
+    if(pthread_mutex_trylock((pthread_mutex_t *)mutex) != 0)
+    {
+      VP_OS_TRACE_BEGIN_EVENT("mutex wait");
+      pthread_mutex_lock((pthread_mutex_t *)mutex);
+      VP_OS_TRACE_END_EVENT("mutex wait");
+    }
+    return;
+  }
+#endif
   pthread_mutex_lock((pthread_mutex_t *)mutex);
 }
 
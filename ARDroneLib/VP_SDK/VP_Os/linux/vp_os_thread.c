@@ -125,19 +125,20 @@ vp_os_thread_create(THREAD_ROUTINE f, THREAD_PARAMS parameters, THREAD_HANDLE *h
 void
 vp_os_thread_join(THREAD_HANDLE handle)
 {
+  void *res;
+
   vp_os_mutex_lock(&thread_mutex);
 
   pthread_data_t* freeSlot = findThread( handle );
 
   if( freeSlot != NULL )
-  {
-    void *res;
-
     vp_os_memset(freeSlot, 0, sizeof(pthread_data_t));
-    pthread_join( handle, &res);
-  }
 
   vp_os_mutex_unlock(&thread_mutex);
+
+  // Not under thread_mutex : the joined thread may itself create or join threads
+  if( freeSlot != NULL )
+    pthread_join( handle, &res);
 }
 
 THREAD_HANDLE
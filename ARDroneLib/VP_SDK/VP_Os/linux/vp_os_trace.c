@@ -0,0 +1,325 @@
+/**
+ *  \brief    VP Os trace recorder, see vp_os_trace.h
+ */
+
+#include <VP_Os/vp_os_types.h>
+#include <VP_Os/vp_os_trace.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+
+#ifdef VP_OS_TRACE_SUPPORTED
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+typedef struct _vp_os_trace_event_t
+{
+  uint64_t      time_ns;
+  const char   *name;
+  int64_t       value;
+  uint32_t      type;
+}
+vp_os_trace_event_t;
+
+typedef struct _vp_os_trace_ring_t
+{
+  vp_os_trace_event_t  events[VP_OS_TRACE_RING_SIZE];
+  volatile uint32_t    head;        // Free running, written by the owner thread only
+  volatile uint32_t    start;       // First event after the last clear, written by the owner thread only
+  volatile uint32_t    epoch;       // Last clear applied to the ring, written by the owner thread only
+  uint32_t             tid;
+  char                 name[32];
+  bool_t               exited;      // No owner thread anymore, the ring can be given to a new thread
+  uint32_t             exit_order;
+}
+vp_os_trace_ring_t;
+
+volatile int vp_os_trace_enabled = 0;
+
+// Rings are only added or given to another thread with vp_os_trace_mutex locked
+static vp_os_trace_ring_t *vp_os_trace_rings[VP_OS_TRACE_MAX_THREADS];
+static volatile uint32_t vp_os_trace_num_rings = 0;
+static uint32_t vp_os_trace_num_exits = 0;
+static volatile uint32_t vp_os_trace_epoch = 0;
+static __thread vp_os_trace_ring_t *vp_os_trace_thread_ring = NULL;
+static pthread_mutex_t vp_os_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t vp_os_trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t vp_os_trace_key;
+static uint64_t vp_os_trace_origin_ns = 0;
+
+// Given to a thread which must not record : out of rings, or exiting
+#define VP_OS_TRACE_NO_RING ((vp_os_trace_ring_t *) -1)
+
+const char * const vp_os_rtmon_uevent_names[32] =
+{
+  "non_linear_fusion", "vlib_encode", "vlib_blockline_to_mb", "vlib_quantize",
+  "vlib_doquantize", "vlib_packet", "vlib_dct_compute", "vlib_dct_wait",
+  "iphone_acceleros", "uevent_09", "bcm43xx_10", "bcm43xx_11",
+  "opponent_detection", "me_compute", "picture_reduction", "tracking_prepare",
+  "tracking_compute", "tracking_update", "translation_estimation", "tracker_replace",
+  "sdio_p5p_20", "sdio_p5p_21", "sdio_p5p_22", "sdio_p5p_23",
+  "sdio_p5p_24", "uevent_25", "vision_loop_led_detect", "vision_test_detect",
+  "uevent_28", "uevent_29", "uevent_30", "vp_api_iteration"
+};
+
+const char * const vp_os_rtmon_uval_names[32] =
+{
+  "uval_00", "uval_01", "uval_02", "vision_num_angles",
+  "uval_04", "uval_05", "uval_06", "uval_07",
+  "uval_08", "uval_09", "bcm43xx_10", "bcm43xx_11",
+  "bcm43xx_12", "uval_13", "uval_14", "uval_15",
+  "uval_16", "uval_17", "sdk_stage_index", "uval_19",
+  "sdio_p5p_20", "icamif_server_blockline", "icamif_client_blockline", "icamif_blockline",
+  "camif_consume", "camif_blockline", "camif_lines", "captured_blockline",
+  "captured_picture", "nb_trackers_defined", "encoded_blockline_size", "encoded_picture"
+};
+
+static uint64_t vp_os_trace_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Thread exit : its events are kept until the ring is given to a new thread */
+static void vp_os_trace_thread_exit(void *data)
+{
+  vp_os_trace_ring_t *ring = (vp_os_trace_ring_t *) data;
+
+  pthread_mutex_lock(&vp_os_trace_mutex);
+  ring->exited     = TRUE;
+  ring->exit_order = vp_os_trace_num_exits++;
+  pthread_mutex_unlock(&vp_os_trace_mutex);
+
+  // Destructors which run after this one must not write into the ring
+  vp_os_trace_thread_ring = VP_OS_TRACE_NO_RING;
+}
+
+static void vp_os_trace_init_key(void)
+{
+  pthread_key_create(&vp_os_trace_key, vp_os_trace_thread_exit);
+}
+
+/* Called with vp_os_trace_mutex locked : a new ring, or the ring of the thread which exited first */
+static vp_os_trace_ring_t *vp_os_trace_new_ring(void)
+{
+  vp_os_trace_ring_t *ring = NULL;
+  uint32_t i;
+
+  if(vp_os_trace_num_rings < VP_OS_TRACE_MAX_THREADS)
+  {
+    ring = (vp_os_trace_ring_t *) vp_os_calloc(1, sizeof(vp_os_trace_ring_t));
+    if(ring != NULL)
+      vp_os_trace_rings[vp_os_trace_num_rings++] = ring;
+    return ring;
+  }
+
+  for(i = 0; i < vp_os_trace_num_rings; i++)
+  {
+    if(vp_os_trace_rings[i]->exited &&
+       (ring == NULL || (int32_t)(vp_os_trace_rings[i]->exit_order - ring->exit_order) < 0))
+    {
+      ring = vp_os_trace_rings[i];
+    }
+  }
+
+  if(ring != NULL)
+  {
+    // No thread writes into an exited ring
+    ring->head   = 0;
+    ring->start  = 0;
+    ring->exited = FALSE;
+  }
+
+  return ring;
+}
+
+static vp_os_trace_ring_t *vp_os_trace_get_ring(void)
+{
+  vp_os_trace_ring_t *ring = vp_os_trace_thread_ring;
+
+  if(ring == NULL)
+  {
+    pthread_once(&vp_os_trace_once, vp_os_trace_init_key);
+
+    pthread_mutex_lock(&vp_os_trace_mutex);
+    ring = vp_os_trace_new_ring();
+    if(ring != NULL)
+    {
+      ring->tid   = (uint32_t) syscall(SYS_gettid);
+      ring->epoch = vp_os_trace_epoch;
+      snprintf(ring->name, sizeof(ring->name), "thread %u", ring->tid);
+    }
+    pthread_mutex_unlock(&vp_os_trace_mutex);
+
+    if(ring == NULL)
+    {
+      // Out of rings, do not retry on every event
+      vp_os_trace_thread_ring = VP_OS_TRACE_NO_RING;
+    }
+    else
+    {
+      vp_os_trace_thread_ring = ring;
+      pthread_setspecific(vp_os_trace_key, ring);
+    }
+  }
+
+  return (ring == VP_OS_TRACE_NO_RING) ? NULL : ring;
+}
+
+void vp_os_trace_event(VP_OS_TRACE_EVENT_TYPE type, const char *name, long long value)
+{
+  vp_os_trace_ring_t *ring = vp_os_trace_get_ring();
+  vp_os_trace_event_t *event;
+  uint32_t head, epoch;
+
+  if(ring == NULL)
+    return;
+
+  head = ring->head;
+
+  // vp_os_trace_clear only asks, the owner thread drops its events itself
+  epoch = __atomic_load_n(&vp_os_trace_epoch, __ATOMIC_RELAXED);
+  if(ring->epoch != epoch)
+  {
+    ring->start = head;
+    __sync_synchronize();
+    ring->epoch = epoch;
+  }
+
+  event = &ring->events[head & (VP_OS_TRACE_RING_SIZE - 1)];
+  event->time_ns = vp_os_trace_now_ns();
+  event->name    = name;
+  event->value   = value;
+  event->type    = type;
+
+  // The dump must not see the index before the event
+  __sync_synchronize();
+  ring->head = head + 1;
+}
+
+void vp_os_trace_enable(int enable)
+{
+  if(enable && vp_os_trace_origin_ns == 0)
+    vp_os_trace_origin_ns = vp_os_trace_now_ns();
+
+  vp_os_trace_enabled = enable ? 1 : 0;
+}
+
+void vp_os_trace_set_thread_name(const char *name)
+{
+  vp_os_trace_ring_t *ring = vp_os_trace_get_ring();
+
+  if(ring != NULL)
+  {
+    strncpy(ring->name, name, sizeof(ring->name) - 1);
+    ring->name[sizeof(ring->name) - 1] = '\0';
+  }
+}
+
+void vp_os_trace_clear(void)
+{
+  uint32_t i;
+
+  pthread_mutex_lock(&vp_os_trace_mutex);
+  __atomic_add_fetch(&vp_os_trace_epoch, 1, __ATOMIC_RELAXED);
+
+  // Nobody else writes into the rings of exited threads
+  for(i = 0; i < vp_os_trace_num_rings; i++)
+  {
+    if(vp_os_trace_rings[i]->exited)
+    {
+      vp_os_trace_rings[i]->start = vp_os_trace_rings[i]->head;
+      vp_os_trace_rings[i]->epoch = vp_os_trace_epoch;
+    }
+  }
+  pthread_mutex_unlock(&vp_os_trace_mutex);
+}
+
+static void vp_os_trace_write_string(FILE *f, const char *str)
+{
+  fputc('"', f);
+  for(; *str != '\0'; str++)
+  {
+    if(*str == '"' || *str == '\\')
+      fputc('\\', f);
+    if((unsigned char)*str >= 0x20)
+      fputc(*str, f);
+  }
+  fputc('"', f);
+}
+
+int vp_os_trace_dump(const char *path)
+{
+  static const char phases[] = { 'B', 'E', 'C', 'i' };
+  uint32_t i, j, head, start, first;
+  bool_t first_event = TRUE;
+  FILE *f;
+
+  f = fopen(path, "w");
+  if(f == NULL)
+  {
+    PRINT("Unable to open trace file %s\n", path);
+    return C_FAIL;
+  }
+
+  fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  pthread_mutex_lock(&vp_os_trace_mutex);
+  for(i = 0; i < vp_os_trace_num_rings; i++)
+  {
+    vp_os_trace_ring_t *ring = vp_os_trace_rings[i];
+
+    fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":",
+            first_event ? "" : ",\n", (int) getpid(), ring->tid);
+    vp_os_trace_write_string(f, ring->name);
+    fprintf(f, "}}");
+    first_event = FALSE;
+
+    // A ring which did not apply the last clear yet is empty
+    if(ring->epoch != vp_os_trace_epoch)
+      continue;
+
+    head  = ring->head;
+    start = ring->start;
+    __sync_synchronize();
+    first = (head - start > VP_OS_TRACE_RING_SIZE) ? head - VP_OS_TRACE_RING_SIZE : start;
+
+    for(j = first; j < head; j++)
+    {
+      vp_os_trace_event_t *event = &ring->events[j & (VP_OS_TRACE_RING_SIZE - 1)];
+      uint64_t time_ns = (event->time_ns > vp_os_trace_origin_ns) ? event->time_ns - vp_os_trace_origin_ns : 0;
+
+      if(event->name == NULL || event->type > VP_OS_TRACE_INSTANT)
+        continue;
+
+      fprintf(f, ",\n{\"name\":");
+      vp_os_trace_write_string(f, event->name);
+      fprintf(f, ",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%u",
+              phases[event->type], (unsigned long long)(time_ns / 1000), (unsigned)(time_ns % 1000),
+              (int) getpid(), ring->tid);
+
+      if(event->type == VP_OS_TRACE_COUNTER)
+      {
+        fprintf(f, ",\"args\":{\"value\":%lld}", (long long) event->value);
+      }
+      else if(event->type == VP_OS_TRACE_INSTANT)
+      {
+        fprintf(f, ",\"s\":\"t\"");
+      }
+      fprintf(f, "}");
+    }
+  }
+  pthread_mutex_unlock(&vp_os_trace_mutex);
+
+  fprintf(f, "\n]}\n");
+  fclose(f);
+
+  return C_OK;
+}
+
+#endif // VP_OS_TRACE_SUPPORTED
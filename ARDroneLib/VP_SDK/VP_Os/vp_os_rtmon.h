@@ -8,7 +8,21 @@
 #ifndef _OS_RTMON_H_
 #define _OS_RTMON_H_
 
+#include <VP_Os/vp_os_trace.h>
+
+#ifdef VP_OS_TRACE_SUPPORTED
+// Linux hosts : user events go to the trace recorder
+extern const char * const vp_os_rtmon_uevent_names[32];
+extern const char * const vp_os_rtmon_uval_names[32];
+# define RTMON_START(cfg)         vp_os_trace_enable(TRUE)
+# define RTMON_STOP()             vp_os_trace_enable(FALSE)
+# define RTMON_FLUSH(...)         do{}while(0)
+# define RTMON_USTART(id)         VP_OS_TRACE_BEGIN_EVENT(vp_os_rtmon_uevent_names[(id) & 31])
+# define RTMON_USTOP(id)          VP_OS_TRACE_END_EVENT(vp_os_rtmon_uevent_names[(id) & 31])
+# define RTMON_UVAL(id,value)     VP_OS_TRACE_COUNTER_EVENT(vp_os_rtmon_uval_names[(id) & 31], (value))
+#else
 # define RTMON_NEED_DEFINITIONS
+#endif
 
 #ifdef RTMON_NEED_DEFINITIONS
 # define RTMON_START(cfg)         do{}while(0)
@@ -0,0 +1,86 @@
+/**
+ *  \brief    VP Os trace recorder.
+ *
+ *  Records begin / end and counter events in one ring buffer per thread,
+ *  without lock : each ring is only written by its own thread. Recording is
+ *  off until vp_os_trace_enable( TRUE ), each probe then costs a clock read
+ *  and a few stores. The oldest events of a thread are overwritten when its
+ *  ring is full. The events of an exited thread are kept until its ring is
+ *  given to a new thread.
+ *
+ *  vp_os_trace_dump writes all rings in the Chrome trace event format (JSON),
+ *  which chrome://tracing and the Perfetto UI both load.
+ *
+ *  RTMON_* macros are routed to the recorder on Linux hosts. Elsewhere the
+ *  probes compile to nothing.
+ */
+
+#ifndef _VP_OS_TRACE_H_
+#define _VP_OS_TRACE_H_
+
+
+#define VP_OS_TRACE_MAX_THREADS     64      // Recording at the same time, the ring of an exited thread goes to the next new thread
+#define VP_OS_TRACE_RING_SIZE       16384   // Events per thread, power of two
+
+typedef enum _VP_OS_TRACE_EVENT_TYPE_
+{
+  VP_OS_TRACE_BEGIN = 0,
+  VP_OS_TRACE_END,
+  VP_OS_TRACE_COUNTER,
+  VP_OS_TRACE_INSTANT
+}
+VP_OS_TRACE_EVENT_TYPE;
+
+#if defined(USE_LINUX) && !defined(NO_VP_OS_TRACE)
+
+#define VP_OS_TRACE_SUPPORTED
+
+// Pulled in by vp_os_rtmon.h before any system header or VP Os type : builtin types only
+
+extern volatile int vp_os_trace_enabled;
+
+// name must stay valid until the dump : use string literals or static strings
+void vp_os_trace_event(VP_OS_TRACE_EVENT_TYPE type, const char *name, long long value);
+
+/**
+ * Starts / stops recording. Rings are kept when recording stops.
+ */
+void vp_os_trace_enable(int enable);
+
+/**
+ * Names the calling thread in the dump.
+ */
+void vp_os_trace_set_thread_name(const char *name);
+
+/**
+ * Empties all rings. Each thread drops its events itself at its next event,
+ * its ring is dumped empty until then.
+ */
+void vp_os_trace_clear(void);
+
+/**
+ * Writes all recorded events to path as Chrome trace JSON.
+ * Stop recording first to get a consistent dump. Returns C_OK or C_FAIL.
+ */
+int vp_os_trace_dump(const char *path);
+
+# define VP_OS_TRACE_BEGIN_EVENT(name)        do { if(vp_os_trace_enabled) vp_os_trace_event(VP_OS_TRACE_BEGIN, (name), 0); } while(0)
+# define VP_OS_TRACE_END_EVENT(name)          do { if(vp_os_trace_enabled) vp_os_trace_event(VP_OS_TRACE_END, (name), 0); } while(0)
+# define VP_OS_TRACE_COUNTER_EVENT(name,val)  do { if(vp_os_trace_enabled) vp_os_trace_event(VP_OS_TRACE_COUNTER, (name), (long long)(val)); } while(0)
+# define VP_OS_TRACE_INSTANT_EVENT(name)      do { if(vp_os_trace_enabled) vp_os_trace_event(VP_OS_TRACE_INSTANT, (name), 0); } while(0)
+
+#else
+
+# define vp_os_trace_enable(enable)           do{}while(0)
+# define vp_os_trace_set_thread_name(name)    do{}while(0)
+# define vp_os_trace_clear()                  do{}while(0)
+# define vp_os_trace_dump(path)               (C_FAIL)
+
+# define VP_OS_TRACE_BEGIN_EVENT(name)        do{}while(0)
+# define VP_OS_TRACE_END_EVENT(name)          do{}while(0)
+# define VP_OS_TRACE_COUNTER_EVENT(name,val)  do{}while(0)
+# define VP_OS_TRACE_INSTANT_EVENT(name)      do{}while(0)
+
+#endif
+
+#endif // _VP_OS_TRACE_H_
@@ -0,0 +1,382 @@
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+#include <VP_Stages/vp_stages_frame_broadcast.h>
+
+// Called with sub->mutex locked
+static void frame_subscriber_flush(vp_stages_frame_subscriber_t *sub)
+{
+  while (sub->count > 0)
+  {
+    vp_api_frame_unref(sub->frames[sub->head]);
+    sub->frames[sub->head] = NULL;
+    sub->head = (sub->head + 1) % VP_FRAME_SUBSCRIBER_MAX_DEPTH;
+    sub->count--;
+  }
+  sub->head = 0;
+}
+
+// Called with sub->mutex locked, drops the oldest queued frame
+static void frame_subscriber_drop(vp_stages_frame_subscriber_t *sub)
+{
+  vp_api_frame_unref(sub->frames[sub->head]);
+  sub->frames[sub->head] = NULL;
+  sub->head = (sub->head + 1) % VP_FRAME_SUBSCRIBER_MAX_DEPTH;
+  sub->count--;
+  sub->dropped++;
+}
+
+// generation is the one read with the target list : if the slot was left, and
+// maybe taken again, since then, the frame was meant for a gone subscriber
+static void frame_subscriber_publish(vp_stages_frame_subscriber_t *sub, uint32_t generation, vp_api_frame_t *frame)
+{
+  vp_os_mutex_lock(&sub->mutex);
+
+  if (sub->policy == VP_FRAME_SUBSCRIBER_BLOCKING)
+  {
+    // the subscriber paces the sender, unless it leaves
+    while (sub->count >= sub->depth && !sub->closed && sub->generation == generation)
+      vp_os_cond_wait(&sub->frame_taken);
+  }
+  else if (sub->generation == generation)
+  {
+    while (sub->count >= sub->depth)
+      frame_subscriber_drop(sub);
+  }
+
+  if (!sub->closed && sub->generation == generation)
+  {
+    sub->frames[(sub->head + sub->count) % VP_FRAME_SUBSCRIBER_MAX_DEPTH] = vp_api_frame_ref(frame);
+    sub->count++;
+    sub->received++;
+    vp_os_cond_signal(&sub->frame_ready);
+  }
+
+  vp_os_mutex_unlock(&sub->mutex);
+}
+
+// Points picture to a new pool frame of the same size, the caller gets the
+// reference the picture held on frame. FALSE if no frame could be allocated
+static bool_t frame_broadcast_renew(vp_api_picture_t *picture, vp_api_frame_t *frame)
+{
+  vp_api_frame_t *next = vp_api_frame_acquire(frame->picture.width, frame->picture.height, frame->picture.format, "vp_stages_frame_broadcast");
+
+  if (next == NULL)
+    return FALSE;
+
+  picture->raw    = next->picture.raw;
+  picture->y_buf  = next->picture.y_buf;
+  picture->cb_buf = next->picture.cb_buf;
+  picture->cr_buf = next->picture.cr_buf;
+
+  return TRUE;
+}
+
+static void frame_broadcast_end(vp_stages_frame_broadcast_config_t *cfg, bool_t ended)
+{
+  int i;
+
+  vp_os_mutex_lock(&cfg->mutex);
+  for (i = 0; i < VP_FRAME_BROADCAST_MAX_SUBSCRIBERS; i++)
+  {
+    vp_stages_frame_subscriber_t *sub = &cfg->subscribers[i];
+
+    vp_os_mutex_lock(&sub->mutex);
+    sub->ended = ended;
+    vp_os_cond_broadcast(&sub->frame_ready);
+    vp_os_mutex_unlock(&sub->mutex);
+  }
+  vp_os_mutex_unlock(&cfg->mutex);
+}
+
+C_RESULT
+vp_stages_frame_broadcast_init(vp_stages_frame_broadcast_config_t *cfg)
+{
+  int i;
+
+  vp_os_memset(cfg->subscribers, 0, sizeof(cfg->subscribers));
+  cfg->published = 0;
+  cfg->copies = 0;
+
+  vp_os_mutex_init(&cfg->mutex);
+  for (i = 0; i < VP_FRAME_BROADCAST_MAX_SUBSCRIBERS; i++)
+  {
+    vp_stages_frame_subscriber_t *sub = &cfg->subscribers[i];
+
+    vp_os_mutex_init(&sub->mutex);
+    vp_os_cond_init(&sub->frame_ready, &sub->mutex);
+    vp_os_cond_init(&sub->frame_taken, &sub->mutex);
+  }
+
+  return C_OK;
+}
+
+C_RESULT
+vp_stages_frame_broadcast_destroy(vp_stages_frame_broadcast_config_t *cfg)
+{
+  int i;
+
+  for (i = 0; i < VP_FRAME_BROADCAST_MAX_SUBSCRIBERS; i++)
+  {
+    vp_stages_frame_subscriber_t *sub = &cfg->subscribers[i];
+
+    if (sub->used)
+      PRINT("%s:%d subscriber %s still registered\n", __FILE__, __LINE__, sub->name);
+
+    frame_subscriber_flush(sub);
+    vp_os_cond_destroy(&sub->frame_ready);
+    vp_os_cond_destroy(&sub->frame_taken);
+    vp_os_mutex_destroy(&sub->mutex);
+  }
+  vp_os_mutex_destroy(&cfg->mutex);
+
+  return C_OK;
+}
+
+vp_stages_frame_subscriber_t*
+vp_stages_frame_broadcast_subscribe(vp_stages_frame_broadcast_config_t *cfg, const char *name, VP_FRAME_SUBSCRIBER_POLICY policy, uint32_t depth)
+{
+  vp_stages_frame_subscriber_t *sub = NULL;
+  int i;
+
+  if (policy == VP_FRAME_SUBSCRIBER_LATEST || depth == 0)
+    depth = 1;
+  else if (depth > VP_FRAME_SUBSCRIBER_MAX_DEPTH)
+    depth = VP_FRAME_SUBSCRIBER_MAX_DEPTH;
+
+  vp_os_mutex_lock(&cfg->mutex);
+  for (i = 0; i < VP_FRAME_BROADCAST_MAX_SUBSCRIBERS && sub == NULL; i++)
+  {
+    if (!cfg->subscribers[i].used)
+      sub = &cfg->subscribers[i];
+  }
+
+  if (sub != NULL)
+  {
+    vp_os_mutex_lock(&sub->mutex);
+    sub->name     = name;
+    sub->policy   = policy;
+    sub->depth    = depth;
+    sub->received = 0;
+    sub->dropped  = 0;
+    sub->head     = 0;
+    sub->count    = 0;
+    sub->closed   = FALSE;
+    sub->used     = TRUE;
+    sub->generation++;
+    vp_os_mutex_unlock(&sub->mutex);
+  }
+  vp_os_mutex_unlock(&cfg->mutex);
+
+  if (sub == NULL)
+    PRINT("%s:%d no subscriber slot left for %s\n", __FILE__, __LINE__, name);
+
+  return sub;
+}
+
+C_RESULT
+vp_stages_frame_broadcast_unsubscribe(vp_stages_frame_broadcast_config_t *cfg, vp_stages_frame_subscriber_t *sub)
+{
+  if (sub == NULL)
+    return C_FAIL;
+
+  // wake up a sender blocked on this subscriber, publish checks closed
+  vp_os_mutex_lock(&sub->mutex);
+  sub->closed = TRUE;
+  frame_subscriber_flush(sub);
+  vp_os_cond_broadcast(&sub->frame_taken);
+  vp_os_cond_broadcast(&sub->frame_ready);
+  vp_os_mutex_unlock(&sub->mutex);
+
+  vp_os_mutex_lock(&cfg->mutex);
+  sub->used = FALSE;
+  vp_os_mutex_unlock(&cfg->mutex);
+
+  return C_OK;
+}
+
+vp_api_frame_t*
+vp_stages_frame_broadcast_get(vp_stages_frame_subscriber_t *sub, bool_t wait)
+{
+  vp_api_frame_t *frame = NULL;
+
+  vp_os_mutex_lock(&sub->mutex);
+
+  while (wait && sub->count == 0 && !sub->ended && !sub->closed)
+    vp_os_cond_wait(&sub->frame_ready);
+
+  if (sub->count > 0)
+  {
+    frame = sub->frames[sub->head];
+    sub->frames[sub->head] = NULL;
+    sub->head = (sub->head + 1) % VP_FRAME_SUBSCRIBER_MAX_DEPTH;
+    sub->count--;
+    vp_os_cond_signal(&sub->frame_taken);
+  }
+
+  vp_os_mutex_unlock(&sub->mutex);
+
+  return frame;
+}
+
+// Sender function
+C_RESULT
+vp_stages_frame_broadcast_sender_open(vp_stages_frame_broadcast_config_t *cfg)
+{
+  if (cfg->inPicture == NULL)
+    return C_FAIL;
+
+  frame_broadcast_end(cfg, FALSE);
+
+  return C_OK;
+}
+
+C_RESULT
+vp_stages_frame_broadcast_sender_transform(vp_stages_frame_broadcast_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out)
+{
+  vp_stages_frame_subscriber_t *targets[VP_FRAME_BROADCAST_MAX_SUBSCRIBERS];
+  uint32_t generations[VP_FRAME_BROADCAST_MAX_SUBSCRIBERS];
+  vp_api_frame_t *frame = NULL;
+  int i, nb_targets = 0;
+
+  vp_os_mutex_lock(&out->lock);
+
+  if (in->status == VP_API_STATUS_ERROR)
+  {
+    // previous stage gave an error, resume waiting subscribers
+    frame_broadcast_end(cfg, TRUE);
+    PRINT("%s:%d sender error, close stage\n", __FILE__, __LINE__);
+  }
+  else if (in->size > 0 && cfg->inPicture->raw != NULL)
+  {
+    vp_os_mutex_lock(&cfg->mutex);
+    for (i = 0; i < VP_FRAME_BROADCAST_MAX_SUBSCRIBERS; i++)
+    {
+      if (cfg->subscribers[i].used)
+      {
+        generations[nb_targets] = cfg->subscribers[i].generation;
+        targets[nb_targets++] = &cfg->subscribers[i];
+      }
+    }
+    cfg->published++;
+    vp_os_mutex_unlock(&cfg->mutex);
+
+    if (nb_targets > 0)
+    {
+      frame = (cfg->copy) ? NULL : vp_api_frame_from_data(cfg->inPicture->raw);
+
+      // the producer writes its next picture in a new frame, this one goes to the subscribers
+      if (frame != NULL && !frame_broadcast_renew(cfg->inPicture, frame))
+        frame = NULL;
+
+      if (frame == NULL)
+      {
+        // the producer will write its next picture in this buffer, copy it once for everybody
+        frame = vp_api_frame_acquire(cfg->inPicture->width, cfg->inPicture->height, cfg->inPicture->format, "vp_stages_frame_broadcast");
+        if (frame != NULL)
+        {
+          vp_os_memcpy(frame->data, cfg->inPicture->raw, vp_api_picture_get_buffer_size(cfg->inPicture));
+          cfg->copies++;
+        }
+      }
+    }
+
+    if (frame != NULL)
+    {
+      // without cfg->mutex : a blocking subscriber may wait for its reader here,
+      // others must still be able to subscribe or leave meanwhile
+      for (i = 0; i < nb_targets; i++)
+        frame_subscriber_publish(targets[i], generations[i], frame);
+
+      vp_api_frame_unref(frame);
+    }
+  }
+
+  /* wire in to out */
+  vp_os_memcpy(out, in, sizeof(vp_api_io_data_t));
+
+  vp_os_mutex_unlock(&out->lock);
+
+  return C_OK;
+}
+
+C_RESULT
+vp_stages_frame_broadcast_sender_close(vp_stages_frame_broadcast_config_t *cfg)
+{
+  frame_broadcast_end(cfg, TRUE);
+
+  return C_OK;
+}
+
+// Receiver function
+// Outputs the frames of one subscriber as pictures, each one stays referenced
+// until the next call so following stages can read it without copy
+C_RESULT
+vp_stages_frame_broadcast_receiver_open(vp_stages_frame_receiver_config_t *cfg)
+{
+  if (cfg->subscriber == NULL)
+    return C_FAIL;
+
+  cfg->frame = NULL;
+
+  return C_OK;
+}
+
+C_RESULT
+vp_stages_frame_broadcast_receiver_transform(vp_stages_frame_receiver_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out)
+{
+  vp_api_frame_t *frame;
+
+  vp_os_mutex_lock(&out->lock);
+
+  if (out->status == VP_API_STATUS_INIT)
+  {
+    out->numBuffers = 1;
+    out->indexBuffer = 0;
+    out->status = VP_API_STATUS_PROCESSING;
+  }
+
+  if (out->status == VP_API_STATUS_PROCESSING)
+  {
+    vp_api_frame_unref(cfg->frame);
+    cfg->frame = NULL;
+
+    frame = vp_stages_frame_broadcast_get(cfg->subscriber, TRUE);
+
+    if (frame != NULL && cfg->writable)
+    {
+      // copy only if another subscriber still reads this frame
+      vp_api_frame_t *writable = vp_api_frame_make_writable(frame, "vp_stages_frame_broadcast_receiver");
+      if (writable == NULL)
+        vp_api_frame_unref(frame);
+      frame = writable;
+    }
+
+    if (frame != NULL)
+    {
+      cfg->frame = frame;
+      cfg->outPicture = frame->picture;
+      cfg->outBuffer = frame->data;
+      out->buffers = &cfg->outBuffer;
+      out->size = frame->size;
+    }
+    else
+    {
+      // sender closed
+      out->size = 0;
+      out->status = VP_API_STATUS_ENDED;
+    }
+  }
+
+  vp_os_mutex_unlock(&out->lock);
+
+  return C_OK;
+}
+
+C_RESULT
+vp_stages_frame_broadcast_receiver_close(vp_stages_frame_receiver_config_t *cfg)
+{
+  vp_api_frame_unref(cfg->frame);
+  cfg->frame = NULL;
+
+  return C_OK;
+}
@@ -0,0 +1,132 @@
+#ifndef _VP_STAGES_FRAME_BROADCAST_H_
+#define _VP_STAGES_FRAME_BROADCAST_H_
+
+#include <VP_Api/vp_api.h>
+#include <VP_Api/vp_api_picture.h>
+#include <VP_Api/vp_api_frame_pool.h>
+#include <VP_Os/vp_os_signal.h>
+
+///////////////////////////////////////////////
+// DEFINES
+
+#define VP_FRAME_BROADCAST_MAX_SUBSCRIBERS  8
+#define VP_FRAME_SUBSCRIBER_MAX_DEPTH       8
+
+///////////////////////////////////////////////
+// TYPEDEFS
+
+typedef enum {
+  VP_FRAME_SUBSCRIBER_LATEST = 0, /* only the last published frame is kept, older ones are dropped */
+  VP_FRAME_SUBSCRIBER_QUEUE,      /* up to depth frames are kept, the oldest is dropped when full */
+  VP_FRAME_SUBSCRIBER_BLOCKING    /* up to depth frames are kept, the sender waits when full */
+} VP_FRAME_SUBSCRIBER_POLICY;
+
+typedef struct _vp_stages_frame_subscriber_
+{
+  // public (read only)
+  const char*                 name;
+  VP_FRAME_SUBSCRIBER_POLICY  policy;
+  uint32_t                    depth;
+  uint32_t                    received;   // frames published to this subscriber
+  uint32_t                    dropped;    // frames released before being read
+
+  // private
+  bool_t                      used;
+  bool_t                      closed;
+  bool_t                      ended;      // sender closed, no more frames
+  uint32_t                    generation; // changes with each subscription of the slot
+  vp_os_mutex_t               mutex;
+  vp_os_cond_t                frame_ready;
+  vp_os_cond_t                frame_taken;
+  vp_api_frame_t*             frames[VP_FRAME_SUBSCRIBER_MAX_DEPTH];
+  uint32_t                    head;
+  uint32_t                    count;
+}
+vp_stages_frame_subscriber_t;
+
+/**
+ * \typedef broadcast parameters definition
+ *
+ * Frames handed to the sender stage are published as vp_api_frame_t references.
+ * A picture allocated with vp_api_picture_alloc is shared as is : the sender hands
+ * its frame to the subscribers and points inPicture to a new pool frame, in which
+ * the producer writes its next picture. Subscribers which modify their frames get
+ * a copy from the receiver stage (writable), only if it is still shared.
+ * A producer which keeps its own pointers in the buffer, or reads back its previous
+ * picture, sets copy : each picture is then copied once in a pool frame, whatever
+ * the number of subscribers. Pictures not allocated in the pool are always copied.
+ */
+typedef struct _vp_stages_frame_broadcast_config_
+{
+  // public
+  vp_api_picture_t* inPicture;
+  bool_t            copy;       // inPicture buffer stays the producer's one, published pictures are copied
+
+  // private
+  vp_os_mutex_t                 mutex;
+  vp_stages_frame_subscriber_t  subscribers[VP_FRAME_BROADCAST_MAX_SUBSCRIBERS];
+  uint32_t                      published;
+  uint32_t                      copies;
+}
+vp_stages_frame_broadcast_config_t;
+
+/**
+ * \typedef broadcast receiver stage parameters definition
+ */
+typedef struct _vp_stages_frame_receiver_config_
+{
+  // public
+  vp_stages_frame_subscriber_t* subscriber;
+  bool_t                        writable;   // stage output may be modified by following stages
+
+  // private
+  vp_api_frame_t*               frame;      // reference held until the next transform
+  vp_api_picture_t              outPicture;
+  uint8_t*                      outBuffer;  // out->buffers points here, outPicture is packed
+}
+vp_stages_frame_receiver_config_t;
+
+///////////////////////////////////////////////
+// FUNCTIONS
+
+// Must be called before any subscription and before the pipeline starts
+C_RESULT
+vp_stages_frame_broadcast_init(vp_stages_frame_broadcast_config_t *cfg);
+
+// Releases queued frames, every subscriber must be gone
+C_RESULT
+vp_stages_frame_broadcast_destroy(vp_stages_frame_broadcast_config_t *cfg);
+
+// depth is ignored for VP_FRAME_SUBSCRIBER_LATEST, returns NULL if all slots are taken
+vp_stages_frame_subscriber_t*
+vp_stages_frame_broadcast_subscribe(vp_stages_frame_broadcast_config_t *cfg, const char *name, VP_FRAME_SUBSCRIBER_POLICY policy, uint32_t depth);
+
+C_RESULT
+vp_stages_frame_broadcast_unsubscribe(vp_stages_frame_broadcast_config_t *cfg, vp_stages_frame_subscriber_t *sub);
+
+// Next frame for sub, the caller owns the returned reference (vp_api_frame_unref)
+// Returns NULL when nothing is queued and wait is FALSE, or when the sender is closed
+vp_api_frame_t*
+vp_stages_frame_broadcast_get(vp_stages_frame_subscriber_t *sub, bool_t wait);
+
+// Sender function
+C_RESULT
+vp_stages_frame_broadcast_sender_open(vp_stages_frame_broadcast_config_t *cfg);
+
+C_RESULT
+vp_stages_frame_broadcast_sender_transform(vp_stages_frame_broadcast_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out);
+
+C_RESULT
+vp_stages_frame_broadcast_sender_close(vp_stages_frame_broadcast_config_t *cfg);
+
+// Receiver function
+C_RESULT
+vp_stages_frame_broadcast_receiver_open(vp_stages_frame_receiver_config_t *cfg);
+
+C_RESULT
+vp_stages_frame_broadcast_receiver_transform(vp_stages_frame_receiver_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out);
+
+C_RESULT
+vp_stages_frame_broadcast_receiver_close(vp_stages_frame_receiver_config_t *cfg);
+
+#endif
@@ -22,7 +22,8 @@ vp_stages_frame_pipe_sender_transform(vp_stages_frame_pipe_config_t *cfg, vp_api
   if(out->status == VP_API_STATUS_INIT)
   {
 	  /* Allocate an array to store pointers to the output buffers */
-	  cfg->output_buffers = vp_os_malloc(cfg->nb_buffers*sizeof(*cfg->output_buffers));
+	  /* Last entry keeps the buffer allocated for outPicture : the receiver swaps it in FAST mode */
+	  cfg->output_buffers = vp_os_malloc((cfg->nb_buffers+1)*sizeof(*cfg->output_buffers));
 	  /* Point to the first buffer */
 	  cfg->index_buffer = 0;
 
@@ -36,6 +37,7 @@ vp_stages_frame_pipe_sender_transform(vp_stages_frame_pipe_config_t *cfg, vp_api
         cfg->inPicture->width,
         cfg->inPicture->height,
         cfg->inPicture->format );
+	cfg->output_buffers[cfg->nb_buffers]=cfg->outPicture.raw;
 
     /* fast mode uses a double buffer, allocate it if necessary */
     if (cfg->mode == FAST)
@@ -181,7 +183,25 @@ vp_stages_frame_pipe_receiver_transform(vp_stages_frame_pipe_config_t *cfg, vp_a
 C_RESULT
 vp_stages_frame_pipe_receiver_close(vp_stages_frame_pipe_config_t *cfg)
 {
-  vp_os_free (cfg->outPicture.raw);
+  vp_api_picture_t picture = cfg->outPicture;
+  int i;
+
+  /* Give back every picture allocated by the sender, wherever the FAST mode swaps left them */
+  if (cfg->output_buffers != NULL)
+  {
+    vp_api_picture_point_to_buf_address(&picture,cfg->output_buffers[cfg->nb_buffers]);
+    vp_api_picture_free(&picture);
+    if (cfg->mode == FAST)
+    {
+      for (i=0;i<cfg->nb_buffers;i++)
+      {
+        vp_api_picture_point_to_buf_address(&picture,cfg->output_buffers[i]);
+        vp_api_picture_free(&picture);
+      }
+    }
+    vp_os_free (cfg->output_buffers);
+    cfg->output_buffers = NULL;
+  }
   cfg->outPicture.raw = NULL;
   vp_os_cond_destroy (&(cfg->buffer_sent));
   vp_os_mutex_destroy (&(cfg->pipe_mut));
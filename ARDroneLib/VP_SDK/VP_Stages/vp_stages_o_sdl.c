@@ -23,8 +23,11 @@
 #include <VP_Api/vp_api_thread_helper.h>
 
 
-static int pipeline_opened = 0;
+static volatile int pipeline_opened = 0;
 static vp_os_mutex_t xlib_mutex;
+static vp_os_mutex_t escape_mutex;
+static vp_os_cond_t escape_cond;
+static int escape_requested = 0;
 
 #if defined(_CK4215_) && defined(WIN32)
 static void * main_windows;
@@ -108,45 +111,41 @@ const vp_api_stage_funcs_t vp_stages_output_sdl_funcs =
   (vp_api_stage_close_t) vp_stages_output_sdl_stage_close
 };
 
-PROTO_THREAD_ROUTINE(escaper,nomParams)
+/* Called from SDL_PumpEvents while the display holds xlib_mutex. Events are dropped from the queue */
+static int
+vp_stages_output_sdl_event_filter(const SDL_Event *event)
 {
-  SDL_Event event;
+  if(event->type == SDL_KEYDOWN && event->key.keysym.sym == SDLK_ESCAPE)
+    {
+      vp_os_mutex_lock(&escape_mutex);
+      escape_requested = 1;
+      vp_os_cond_signal(&escape_cond);
+      vp_os_mutex_unlock(&escape_mutex);
+    }
 
+  return 0;
+}
+
+PROTO_THREAD_ROUTINE(escaper,nomParams)
+{
   while(!pipeline_opened)
     {
       vp_os_delay(100);
     }
 
-  while(pipeline_opened)
+  // Woken up by the event filter, or when the pipeline ends
+  vp_os_mutex_lock(&escape_mutex);
+  while(pipeline_opened && !escape_requested)
     {
-      vp_os_mutex_lock(&xlib_mutex);
-      if(SDL_PollEvent(&event))
-	{
-	  vp_os_mutex_unlock(&xlib_mutex);
-	  switch(event.type)
-	    {
-	    case SDL_KEYDOWN:
-	    case SDL_KEYUP:
-	      {
-		SDL_KeyboardEvent *kb_event = (SDL_KeyboardEvent *)&event;
-		switch(kb_event->keysym.sym)
-		  {
-		  case SDLK_ESCAPE:
-		    exit(1);
-		    break;
-		  default:
-		    break;
-		  }
-	      }
-	    default:
-	      break;
-	    }
-	}
-      else
-	{
-	  vp_os_mutex_unlock(&xlib_mutex);
-	}
+      vp_os_cond_wait(&escape_cond);
     }
+  vp_os_mutex_unlock(&escape_mutex);
+
+  if(escape_requested)
+    {
+      exit(1);
+    }
+
   return (THREAD_RET)0;
 }
 
@@ -228,6 +227,9 @@ vp_stages_display_frame(vp_stages_output_sdl_config_t *cfg, vp_api_picture_t *pi
 
     vp_stages_buffer_to_overlay(cfg->overlay, cfg, picture);
     SDL_DisplayYUVOverlay(cfg->overlay, &dstrect);
+#if !(defined(_CK4215_) && defined(WIN32))
+    SDL_PumpEvents();
+#endif
 
     vp_os_mutex_unlock(&xlib_mutex);
   }
@@ -240,12 +242,17 @@ C_RESULT
 vp_stages_output_sdl_stage_open(vp_stages_output_sdl_config_t *cfg)
 {
   vp_os_mutex_init(&xlib_mutex);
+  vp_os_mutex_init(&escape_mutex);
+  vp_os_cond_init(&escape_cond, &escape_mutex);
 
   if(SDL_Init(SDL_INIT_TIMER|SDL_INIT_VIDEO))
     {
       PRINT("Error initializing SDL\n");
       return (VP_FAILURE);
     }
+#if !(defined(_CK4215_) && defined(WIN32))
+  SDL_SetEventFilter(vp_stages_output_sdl_event_filter);
+#endif
 #if defined(_CK4215_) && defined(WIN32)
 	child_windows = NULL;
 	exit_pipeline = FALSE;
@@ -356,7 +363,10 @@ vp_stages_output_sdl_stage_transform(vp_stages_output_sdl_config_t *cfg, vp_api_
   // not managed
   if(in->status == VP_API_STATUS_ENDED)
   {
+      vp_os_mutex_lock(&escape_mutex);
       pipeline_opened = 0;
+      vp_os_cond_signal(&escape_cond);
+      vp_os_mutex_unlock(&escape_mutex);
       vp_os_free(out->buffers);
       out->buffers = NULL;
   }
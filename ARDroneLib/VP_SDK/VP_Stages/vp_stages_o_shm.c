@@ -0,0 +1,257 @@
+/**
+ *  \brief    VP Stages. Output shared memory stage declaration
+ */
+
+///////////////////////////////////////////////
+// INCLUDES
+
+#include <VP_Stages/vp_stages_o_shm.h>
+#include <VP_Api/vp_api_picture.h>
+#include <VP_Api/vp_api_error.h>
+#include <VP_Os/vp_os_print.h>
+#include <VP_Os/vp_os_malloc.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define VP_STAGES_OUTPUT_SHM_ALIGN(x)   (((x) + 63) & ~63U)
+
+const vp_api_stage_funcs_t vp_stages_output_shm_funcs =
+{
+  (vp_api_stage_handle_msg_t) NULL,
+  (vp_api_stage_open_t) vp_stages_output_shm_stage_open,
+  (vp_api_stage_transform_t) vp_stages_output_shm_stage_transform,
+  (vp_api_stage_close_t) vp_stages_output_shm_stage_close
+};
+
+
+static const char *
+vp_stages_output_shm_name(vp_stages_output_shm_config_t *cfg)
+{
+  return cfg->name[0] != '\0' ? cfg->name : VP_STAGES_OUTPUT_SHM_DEFAULT_NAME;
+}
+
+static void
+vp_stages_output_shm_lock(vp_stages_output_shm_header_t *header)
+{
+  // A reader died holding the mutex, the header it protects is still valid
+  if(pthread_mutex_lock(&header->mutex) == EOWNERDEAD)
+    pthread_mutex_consistent(&header->mutex);
+}
+
+static C_RESULT
+vp_stages_output_shm_create(vp_stages_output_shm_config_t *cfg, uint32_t width, uint32_t height)
+{
+  vp_stages_output_shm_header_t *header;
+  pthread_mutexattr_t mutex_attr;
+  pthread_condattr_t cond_attr;
+  uint32_t header_size, buffer_size;
+
+  header_size = VP_STAGES_OUTPUT_SHM_ALIGN(sizeof(vp_stages_output_shm_header_t));
+  buffer_size = VP_STAGES_OUTPUT_SHM_ALIGN(width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2));
+
+  cfg->map_size = header_size + VP_STAGES_OUTPUT_SHM_BUFFERS * buffer_size;
+  cfg->fd = shm_open(vp_stages_output_shm_name(cfg), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(cfg->fd < 0)
+  {
+    PRINT("Unable to create shared memory %s\n", vp_stages_output_shm_name(cfg));
+    return VP_FAILURE;
+  }
+
+  header = NULL;
+  if(ftruncate(cfg->fd, cfg->map_size) == 0)
+  {
+    header = (vp_stages_output_shm_header_t *) mmap(NULL, cfg->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, cfg->fd, 0);
+  }
+
+  if(header == NULL || header == MAP_FAILED)
+  {
+    PRINT("Unable to map %u bytes of shared memory %s\n", cfg->map_size, vp_stages_output_shm_name(cfg));
+    close(cfg->fd);
+    cfg->fd = -1;
+    shm_unlink(vp_stages_output_shm_name(cfg));
+    return VP_FAILURE;
+  }
+
+  // The object is new and zeroed by ftruncate
+  header->header_size = header_size;
+  header->buffer_size = buffer_size;
+  header->max_width   = width;
+  header->max_height  = height;
+
+  pthread_mutexattr_init(&mutex_attr);
+  pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&mutex_attr, PTHREAD_MUTEX_ROBUST);
+  pthread_mutex_init(&header->mutex, &mutex_attr);
+  pthread_mutexattr_destroy(&mutex_attr);
+
+  pthread_condattr_init(&cond_attr);
+  pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+  pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&header->cond, &cond_attr);
+  pthread_condattr_destroy(&cond_attr);
+
+  // Readers check the magic before anything else
+  __sync_synchronize();
+  header->magic = VP_STAGES_OUTPUT_SHM_MAGIC;
+
+  cfg->header = header;
+
+  return VP_SUCCESS;
+}
+
+static void
+vp_stages_output_shm_copy_plane(uint8_t *dst, uint32_t dst_line_size, const uint8_t *src, uint32_t src_line_size, uint32_t width, uint32_t height)
+{
+  uint32_t i;
+
+  if(src_line_size == dst_line_size)
+  {
+    vp_os_memcpy(dst, src, dst_line_size * height);
+  }
+  else
+  {
+    for(i = 0; i < height; i++)
+    {
+      vp_os_memcpy(dst, src, width);
+      dst += dst_line_size;
+      src += src_line_size;
+    }
+  }
+}
+
+static void
+vp_stages_output_shm_publish(vp_stages_output_shm_config_t *cfg, vp_api_picture_t *picture)
+{
+  vp_stages_output_shm_header_t *header = cfg->header;
+  vp_stages_output_shm_frame_t *frame;
+  struct timespec ts;
+  uint32_t back, sequence;
+  uint32_t c_width, c_height;
+  uint8_t *buffer;
+
+  if(picture->width > header->max_width || picture->height > header->max_height)
+  {
+    cfg->dropped_frames++;
+    return;
+  }
+
+  // Only the stage writes sequence and front
+  back     = header->front ^ 1;
+  sequence = header->sequence + 1;
+  frame    = &header->frames[back];
+  buffer   = (uint8_t *) header + header->header_size + back * header->buffer_size;
+  c_width  = (picture->width + 1) / 2;
+  c_height = (picture->height + 1) / 2;
+
+  // Tells a late reader of this buffer that it is being overwritten
+  frame->sequence = 0;
+  __sync_synchronize();
+
+  frame->width       = picture->width;
+  frame->height      = picture->height;
+  frame->y_line_size = picture->width;
+  frame->c_line_size = c_width;
+  frame->y_offset    = 0;
+  frame->cb_offset   = frame->y_line_size * picture->height;
+  frame->cr_offset   = frame->cb_offset + c_width * c_height;
+
+  vp_stages_output_shm_copy_plane(buffer + frame->y_offset,  frame->y_line_size, picture->y_buf,  picture->y_line_size,  picture->width, picture->height);
+  vp_stages_output_shm_copy_plane(buffer + frame->cb_offset, frame->c_line_size, picture->cb_buf, picture->cb_line_size, c_width, c_height);
+  vp_stages_output_shm_copy_plane(buffer + frame->cr_offset, frame->c_line_size, picture->cr_buf, picture->cr_line_size, c_width, c_height);
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  frame->timestamp_us = (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+  __sync_synchronize();
+  frame->sequence = sequence;
+
+  vp_stages_output_shm_lock(header);
+  header->front    = back;
+  header->sequence = sequence;
+  pthread_cond_broadcast(&header->cond);
+  pthread_mutex_unlock(&header->mutex);
+
+  cfg->published_frames++;
+}
+
+
+C_RESULT
+vp_stages_output_shm_stage_open(vp_stages_output_shm_config_t *cfg)
+{
+  cfg->fd       = -1;
+  cfg->header   = NULL;
+  cfg->map_size = 0;
+  cfg->published_frames = 0;
+  cfg->dropped_frames   = 0;
+
+  return (VP_SUCCESS);
+}
+
+
+C_RESULT
+vp_stages_output_shm_stage_transform(vp_stages_output_shm_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out)
+{
+  vp_api_picture_t *picture = (vp_api_picture_t *) in->buffers;
+  C_RESULT res = VP_SUCCESS;
+
+  vp_os_mutex_lock(&out->lock);
+
+  if(in->size > 0 && picture != NULL && cfg->header == NULL)
+  {
+    // The buffers are sized once, readers keep their mapping for the whole session
+    res = vp_stages_output_shm_create(cfg,
+                                      cfg->max_width  ? cfg->max_width  : picture->width,
+                                      cfg->max_height ? cfg->max_height : picture->height);
+  }
+
+  out->status = (in->status == VP_API_STATUS_STILL_RUNNING ? VP_API_STATUS_PROCESSING : in->status);
+
+  if(VP_SUCCEEDED(res) && cfg->header != NULL && out->status == VP_API_STATUS_PROCESSING && in->size > 0)
+  {
+    vp_stages_output_shm_publish(cfg, picture);
+  }
+
+  // Pictures go on to the next stage without a copy
+  out->numBuffers  = in->numBuffers;
+  out->indexBuffer = in->indexBuffer;
+  out->buffers     = in->buffers;
+  out->lineSize    = in->lineSize;
+  out->size        = in->size;
+
+  vp_os_mutex_unlock(&out->lock);
+
+  return res;
+}
+
+
+C_RESULT
+vp_stages_output_shm_stage_close(vp_stages_output_shm_config_t *cfg)
+{
+  vp_stages_output_shm_header_t *header = cfg->header;
+
+  if(header != NULL)
+  {
+    vp_stages_output_shm_lock(header);
+    header->closed = 1;
+    pthread_cond_broadcast(&header->cond);
+    pthread_mutex_unlock(&header->mutex);
+
+    munmap(header, cfg->map_size);
+    cfg->header = NULL;
+  }
+
+  if(cfg->fd >= 0)
+  {
+    close(cfg->fd);
+    cfg->fd = -1;
+    // Mapped readers keep the memory until they unmap it
+    shm_unlink(vp_stages_output_shm_name(cfg));
+  }
+
+  return (VP_SUCCESS);
+}
@@ -0,0 +1,159 @@
+/**
+ *  \brief    VP Stages. Output shared memory stage declaration
+ */
+
+#ifndef _VP_STAGES_O_SHM_H_
+#define _VP_STAGES_O_SHM_H_
+
+/**
+ * @defgroup VP_SDK
+ * @{ */
+
+/**
+ * @defgroup VP_Stages
+ * @{ */
+
+/**
+ * @defgroup vp_stages_o_shm output shared memory stage
+ *
+ * Headless display : YUV-4:2:0p pictures are published in a POSIX shared
+ * memory object (/dev/shm) for a viewer running in another process.
+ *
+ * The object starts with a vp_stages_output_shm_header_t, followed by two
+ * picture buffers. The stage writes the next picture in the buffer which is
+ * not the front one, then makes it the front one and wakes up the readers :
+ * \code
+   pthread_mutex_lock(&header->mutex);
+   while(header->sequence == last && !header->closed)
+     pthread_cond_wait(&header->cond, &header->mutex);
+   last  = header->sequence;
+   front = header->front;
+   frame = header->frames[front];
+   pthread_mutex_unlock(&header->mutex);
+
+   // Use the picture at (uint8_t*)header + header->header_size + front * header->buffer_size
+
+   if(header->frames[front].sequence != last)
+     ; // Overwritten while in use, one frame behind : drop it
+ * \endcode
+ * The stage does not wait for the readers, a reader one frame late sees its
+ * buffer sequence change.
+ * @{ */
+
+///////////////////////////////////////////////
+// INCLUDES
+
+#include <VP_Api/vp_api.h>
+
+#include <pthread.h>
+
+///////////////////////////////////////////////
+// DEFINES
+
+#define VP_STAGES_OUTPUT_SHM_MAGIC          0x4D485356  // "VSHM"
+#define VP_STAGES_OUTPUT_SHM_BUFFERS        2
+#define VP_STAGES_OUTPUT_SHM_DEFAULT_NAME   "/ardrone_video"
+#define VP_STAGES_OUTPUT_SHM_NAME_LENGTH    64
+
+///////////////////////////////////////////////
+// TYEPDEFS
+
+/** Picture stored in a buffer, planes offsets are from the start of the buffer
+ */
+typedef struct _vp_stages_output_shm_frame_
+{
+  volatile uint32_t sequence;       // Sequence of the picture, 0 while it is written
+  uint32_t width;
+  uint32_t height;
+  uint32_t y_line_size;
+  uint32_t c_line_size;
+  uint32_t y_offset;
+  uint32_t cb_offset;
+  uint32_t cr_offset;
+  uint64_t timestamp_us;            // CLOCK_MONOTONIC when published
+} vp_stages_output_shm_frame_t;
+
+typedef struct _vp_stages_output_shm_header_
+{
+  uint32_t magic;                   // VP_STAGES_OUTPUT_SHM_MAGIC
+  uint32_t header_size;             // Offset of the first buffer
+  uint32_t buffer_size;             // Offset between two buffers
+  uint32_t max_width;               // Largest picture the buffers hold
+  uint32_t max_height;
+
+  pthread_mutex_t mutex;            // Process shared, robust
+  pthread_cond_t  cond;             // Broadcast on each picture and on close
+
+  volatile uint32_t sequence;       // Pictures published, 0 : none yet
+  volatile uint32_t front;          // Buffer of the last picture
+  volatile uint32_t closed;         // Set when the stage is closed
+  vp_stages_output_shm_frame_t frames[VP_STAGES_OUTPUT_SHM_BUFFERS];
+} vp_stages_output_shm_header_t;
+
+typedef struct _vp_stages_output_shm_config_
+{
+  char     name[VP_STAGES_OUTPUT_SHM_NAME_LENGTH]; // in, shm_open name. Empty : VP_STAGES_OUTPUT_SHM_DEFAULT_NAME
+  uint32_t max_width;               // in, 0 : size of the first picture
+  uint32_t max_height;              // in
+
+  // Statistics, read only
+  uint32_t published_frames;
+  uint32_t dropped_frames;          // Pictures larger than the buffers
+
+  // private
+
+  int32_t  fd;
+  uint32_t map_size;
+  vp_stages_output_shm_header_t *header;
+
+} vp_stages_output_shm_config_t;
+
+
+///////////////////////////////////////////////
+// FUNCTIONS
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @fn      Open the output shared memory stage
+ * @param   vp_stages_output_shm_config_t *cfg
+ * @return  VP_SUCCESS
+ */
+C_RESULT
+vp_stages_output_shm_stage_open(vp_stages_output_shm_config_t *cfg);
+
+/**
+ * @fn      Publish the input picture, which is passed as is to the next stage
+ * @param   vp_stages_output_shm_config_t *cfg
+ * @param   vp_api_io_data_t *in
+ * @param   vp_api_io_data_t *out
+ * @return  VP_SUCCESS or VP_FAILURE when the shared memory cannot be created
+ */
+C_RESULT
+vp_stages_output_shm_stage_transform(vp_stages_output_shm_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out);
+
+/**
+ * @fn      Close the output shared memory stage, readers are woken up and the object unlinked
+ * @param   vp_stages_output_shm_config_t *cfg
+ * @return  VP_SUCCESS
+ */
+C_RESULT
+vp_stages_output_shm_stage_close(vp_stages_output_shm_config_t *cfg);
+
+extern const vp_api_stage_funcs_t vp_stages_output_shm_funcs;
+
+#ifdef __cplusplus
+}
+#endif
+
+// vp_stages_o_shm
+/** @} */
+// VP_Stages
+/** @} */
+// VP_SDK
+/** @} */
+
+#endif // _VP_STAGES_O_SHM_H_
@@ -0,0 +1,237 @@
+/**
+ *  \brief    VP Stages. Output SDL2 texture stage declaration
+ */
+
+///////////////////////////////////////////////
+// INCLUDES
+
+#include <VP_Stages/vp_stages_o_texture.h>
+#include <VP_Api/vp_api_picture.h>
+#include <VP_Api/vp_api_error.h>
+#include <VP_Os/vp_os_print.h>
+#include <VP_Os/vp_os_malloc.h>
+
+const vp_api_stage_funcs_t vp_stages_output_texture_funcs =
+{
+  (vp_api_stage_handle_msg_t) NULL,
+  (vp_api_stage_open_t) vp_stages_output_texture_stage_open,
+  (vp_api_stage_transform_t) vp_stages_output_texture_stage_transform,
+  (vp_api_stage_close_t) vp_stages_output_texture_stage_close
+};
+
+
+/* Called from SDL_PumpEvents for each event, in the stage thread. Events are dropped from the queue */
+static int
+vp_stages_output_texture_event_filter(void *userdata, SDL_Event *event)
+{
+  vp_stages_output_texture_config_t *cfg = (vp_stages_output_texture_config_t *) userdata;
+
+  switch(event->type)
+  {
+    case SDL_QUIT:
+      cfg->quit = TRUE;
+      break;
+
+    case SDL_KEYDOWN:
+      if(event->key.keysym.sym == SDLK_ESCAPE)
+        cfg->quit = TRUE;
+      break;
+
+    default:
+      break;
+  }
+
+  return 0;
+}
+
+static void
+vp_stages_output_texture_free_textures(vp_stages_output_texture_config_t *cfg)
+{
+  uint32_t i;
+
+  for(i = 0; i < VP_STAGES_OUTPUT_TEXTURE_BUFFERS; i++)
+  {
+    if(cfg->textures[i] != NULL)
+    {
+      SDL_DestroyTexture(cfg->textures[i]);
+      cfg->textures[i] = NULL;
+    }
+  }
+}
+
+/* Window and renderer are made by the thread which draws */
+static C_RESULT
+vp_stages_output_texture_create(vp_stages_output_texture_config_t *cfg, vp_api_picture_t *picture)
+{
+  uint32_t i;
+
+  if(cfg->window == NULL)
+  {
+    cfg->window = SDL_CreateWindow(cfg->title != NULL ? cfg->title : "",
+                                   SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                   cfg->window_width  ? cfg->window_width  : picture->width,
+                                   cfg->window_height ? cfg->window_height : picture->height,
+                                   SDL_WINDOW_RESIZABLE);
+    if(cfg->window == NULL)
+    {
+      PRINT("Unable to create SDL window : %s\n", SDL_GetError());
+      return VP_FAILURE;
+    }
+
+    cfg->renderer = SDL_CreateRenderer(cfg->window, -1, SDL_RENDERER_ACCELERATED | (cfg->vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
+    if(cfg->renderer == NULL)
+    {
+      PRINT("Unable to create SDL renderer : %s\n", SDL_GetError());
+      return VP_FAILURE;
+    }
+
+    SDL_ShowCursor(SDL_DISABLE);
+  }
+
+  // Textures are only made again when the picture size changes
+  if(cfg->texture_width != picture->width || cfg->texture_height != picture->height)
+  {
+    vp_stages_output_texture_free_textures(cfg);
+
+    for(i = 0; i < VP_STAGES_OUTPUT_TEXTURE_BUFFERS; i++)
+    {
+      cfg->textures[i] = SDL_CreateTexture(cfg->renderer, SDL_PIXELFORMAT_IYUV, SDL_TEXTUREACCESS_STREAMING, picture->width, picture->height);
+      if(cfg->textures[i] == NULL)
+      {
+        PRINT("Unable to create %dx%d YUV texture : %s\n", picture->width, picture->height, SDL_GetError());
+        vp_stages_output_texture_free_textures(cfg);
+        cfg->texture_width  = 0;
+        cfg->texture_height = 0;
+        return VP_FAILURE;
+      }
+    }
+
+    cfg->texture_width  = picture->width;
+    cfg->texture_height = picture->height;
+    cfg->current        = 0;
+  }
+
+  return VP_SUCCESS;
+}
+
+static C_RESULT
+vp_stages_output_texture_display(vp_stages_output_texture_config_t *cfg, vp_api_picture_t *picture)
+{
+  SDL_Texture *texture;
+  Uint64 start, latency;
+
+  start = SDL_GetPerformanceCounter();
+
+  if(VP_FAILED(vp_stages_output_texture_create(cfg, picture)))
+    return VP_FAILURE;
+
+  texture = cfg->textures[cfg->current];
+  cfg->current = (cfg->current + 1) % VP_STAGES_OUTPUT_TEXTURE_BUFFERS;
+
+  if(SDL_UpdateYUVTexture(texture, NULL,
+                          picture->y_buf,  picture->y_line_size,
+                          picture->cb_buf, picture->cb_line_size,
+                          picture->cr_buf, picture->cr_line_size) != 0)
+  {
+    PRINT("Unable to upload picture : %s\n", SDL_GetError());
+    return VP_FAILURE;
+  }
+
+  SDL_RenderClear(cfg->renderer);
+  SDL_RenderCopy(cfg->renderer, texture, NULL, NULL);
+  SDL_RenderPresent(cfg->renderer);
+
+  latency = (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+  cfg->latency_us = (uint32_t) latency;
+  if(cfg->latency_us > cfg->max_latency_us)
+    cfg->max_latency_us = cfg->latency_us;
+  cfg->presented_frames++;
+
+  return VP_SUCCESS;
+}
+
+
+C_RESULT
+vp_stages_output_texture_stage_open(vp_stages_output_texture_config_t *cfg)
+{
+  if(SDL_InitSubSystem(SDL_INIT_VIDEO))
+  {
+    PRINT("Error initializing SDL : %s\n", SDL_GetError());
+    return (VP_FAILURE);
+  }
+
+  cfg->window           = NULL;
+  cfg->renderer         = NULL;
+  vp_os_memset(cfg->textures, 0, sizeof(cfg->textures));
+  cfg->current          = 0;
+  cfg->texture_width    = 0;
+  cfg->texture_height   = 0;
+  cfg->quit             = FALSE;
+  cfg->presented_frames = 0;
+  cfg->latency_us       = 0;
+  cfg->max_latency_us   = 0;
+
+  SDL_SetEventFilter(vp_stages_output_texture_event_filter, cfg);
+
+  return (VP_SUCCESS);
+}
+
+
+C_RESULT
+vp_stages_output_texture_stage_transform(vp_stages_output_texture_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out)
+{
+  C_RESULT res = VP_SUCCESS;
+
+  vp_os_mutex_lock(&out->lock);
+
+  out->status = (in->status == VP_API_STATUS_STILL_RUNNING ? VP_API_STATUS_PROCESSING : in->status);
+
+  if(out->status == VP_API_STATUS_PROCESSING && in->size > 0)
+  {
+    res = vp_stages_output_texture_display(cfg, (vp_api_picture_t *) in->buffers);
+  }
+
+  // Runs the event filter on what arrived since the last picture
+  SDL_PumpEvents();
+  if(cfg->quit)
+  {
+    out->status = VP_API_STATUS_ENDED;
+  }
+
+  // Pictures go on to the next stage without a copy
+  out->numBuffers  = in->numBuffers;
+  out->indexBuffer = in->indexBuffer;
+  out->buffers     = in->buffers;
+  out->lineSize    = in->lineSize;
+  out->size        = in->size;
+
+  vp_os_mutex_unlock(&out->lock);
+
+  return res;
+}
+
+
+C_RESULT
+vp_stages_output_texture_stage_close(vp_stages_output_texture_config_t *cfg)
+{
+  SDL_SetEventFilter(NULL, NULL);
+
+  vp_stages_output_texture_free_textures(cfg);
+
+  if(cfg->renderer != NULL)
+  {
+    SDL_DestroyRenderer(cfg->renderer);
+    cfg->renderer = NULL;
+  }
+
+  if(cfg->window != NULL)
+  {
+    SDL_ShowCursor(SDL_ENABLE);
+    SDL_DestroyWindow(cfg->window);
+    cfg->window = NULL;
+  }
+
+  SDL_QuitSubSystem(SDL_INIT_VIDEO);
+
+  return (VP_SUCCESS);
+}
@@ -0,0 +1,117 @@
+/**
+ *  \brief    VP Stages. Output SDL2 texture stage declaration
+ */
+
+#ifndef _VP_STAGES_O_TEXTURE_H_
+#define _VP_STAGES_O_TEXTURE_H_
+
+/**
+ * @defgroup VP_SDK
+ * @{ */
+
+/**
+ * @defgroup VP_Stages
+ * @{ */
+
+/**
+ * @defgroup vp_stages_o_texture output SDL2 texture stage
+ *
+ * Displays YUV-4:2:0p pictures like vp_stages_o_sdl, without the copy into
+ * an SDL_Overlay : the planes are uploaded from the picture buffers into a
+ * streaming IYUV texture, the scaling and the color conversion are done by
+ * the renderer. Two textures are used in turn, so that a picture is uploaded
+ * while the previous one may still be drawn.
+ *
+ * Window events are handled through an SDL event filter, called when the
+ * stage pumps the events after each picture : no thread polls for them.
+ * Escape or closing the window ends the pipeline.
+ * @{ */
+
+///////////////////////////////////////////////
+// INCLUDES
+
+#include <VP_Api/vp_api.h>
+
+#include <SDL2/SDL.h>
+
+///////////////////////////////////////////////
+// DEFINES
+
+#define VP_STAGES_OUTPUT_TEXTURE_BUFFERS  2
+
+///////////////////////////////////////////////
+// TYEPDEFS
+
+typedef struct _vp_stages_output_texture_config_
+{
+  uint32_t window_width;    // in, 0 : size of the first picture
+  uint32_t window_height;   // in
+  const char *title;        // in, NULL : no title
+  bool_t   vsync;           // in, waits for the vertical retrace to present
+
+  // Statistics, read only
+  uint32_t presented_frames;
+  uint32_t latency_us;      // Time from the picture received to presented, last picture
+  uint32_t max_latency_us;
+
+  // private
+
+  SDL_Window   *window;
+  SDL_Renderer *renderer;
+  SDL_Texture  *textures[VP_STAGES_OUTPUT_TEXTURE_BUFFERS];
+  uint32_t      current;
+  uint32_t      texture_width;
+  uint32_t      texture_height;
+  volatile bool_t quit;
+
+} vp_stages_output_texture_config_t;
+
+
+///////////////////////////////////////////////
+// FUNCTIONS
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @fn      Open the output texture stage
+ * @param   vp_stages_output_texture_config_t *cfg
+ * @return  VP_SUCCESS or VP_FAILURE
+ */
+C_RESULT
+vp_stages_output_texture_stage_open(vp_stages_output_texture_config_t *cfg);
+
+/**
+ * @fn      Display the input picture, which is passed as is to the next stage
+ * @param   vp_stages_output_texture_config_t *cfg
+ * @param   vp_api_io_data_t *in
+ * @param   vp_api_io_data_t *out
+ * @return  VP_SUCCESS or VP_FAILURE
+ */
+C_RESULT
+vp_stages_output_texture_stage_transform(vp_stages_output_texture_config_t *cfg, vp_api_io_data_t *in, vp_api_io_data_t *out);
+
+/**
+ * @fn      Close the output texture stage
+ * @param   vp_stages_output_texture_config_t *cfg
+ * @return  VP_SUCCESS
+ */
+C_RESULT
+vp_stages_output_texture_stage_close(vp_stages_output_texture_config_t *cfg);
+
+extern const vp_api_stage_funcs_t vp_stages_output_texture_funcs;
+
+#ifdef __cplusplus
+}
+#endif
+
+// vp_stages_o_texture
+/** @} */
+// VP_Stages
+/** @} */
+// VP_SDK
+/** @} */
+
+#endif // _VP_STAGES_O_TEXTURE_H_
@@ -10,6 +10,7 @@
 // INCLUDES
 
 #include <VP_Stages/vp_stages_yuv2rgb.h>
+#include <VP_Stages/vp_stages_yuv2rgb_simd.h>
 #include <VP_Api/vp_api_config.h>
 #include <VP_Api/vp_api_picture.h>
 #include <VP_Os/vp_os_print.h>
@@ -109,7 +110,9 @@ static vp_stages_YUV_to_RGB_t vp_stages_YUV_to_RGB;
  */
   static void vp_stages_YUV420P_to_RGB565(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
   static void vp_stages_YUV420P_to_RGB24(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
+  static void vp_stages_YUV420P_to_BGR24(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
   static void vp_stages_YUV420P_to_ARGB32(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
+  static void vp_stages_YUV420P_to_RGB_rows(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
 #else // ! QCIF_TO_QVGA
 /** YUV to RGB conversion + resizing
  */
@@ -117,11 +120,17 @@ static vp_stages_YUV_to_RGB_t vp_stages_YUV_to_RGB;
   static void vp_stages_YUV420P_to_RGB565_QCIF_to_QVGA_stretch(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
 #else  // ! USE_YUV2RGB_STRETCH
   static void vp_stages_YUV420P_to_RGB565_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
+#endif  // < USE_YUV2RGB_STRETCH
   static void vp_stages_YUV420P_to_RGB24_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
+  static void vp_stages_YUV420P_to_BGR24_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
   static void vp_stages_YUV420P_to_ARGB32_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
-#endif  // < USE_YUV2RGB_STRETCH
+  static void vp_stages_YUV420P_to_RGB_QCIF_to_QVGA_rows(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes);
 #endif // < QCIF_TO_QVGA
 
+/** SIMD line converter used by vp_stages_YUV420P_to_RGB_rows and vp_stages_YUV420P_to_RGB_QCIF_to_QVGA_rows
+ */
+static vp_stages_yuv2rgb_row_t vp_stages_YUV_to_RGB_row;
+
 
 #ifndef QCIF_TO_QVGA
 static void vp_stages_YUV420P_to_RGB565(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes)
@@ -192,7 +201,8 @@ static void vp_stages_YUV420P_to_RGB565(vp_stages_yuv2rgb_config_t *cfg, vp_api_
 
 
 #ifndef QCIF_TO_QVGA
-static void vp_stages_YUV420P_to_RGB24(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes)
+/* red : offset of the red byte of a pixel, 0 for RGB24 and 2 for BGR24 */
+static void vp_stages_YUV420P_to_RGB24_order(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes, int32_t red)
 {
   uint32_t width, height;
   int32_t line, col, linewidth;
@@ -230,12 +240,10 @@ static void vp_stages_YUV420P_to_RGB24(vp_stages_yuv2rgb_config_t *cfg, vp_api_p
 	  VP_STAGES_YUV2ARGB_LIMIT(g, y - ug - vg);
 	  VP_STAGES_YUV2ARGB_LIMIT(b, y + ub     );
 
-	  *dst = r;
-	  dst++;
-	  *dst = g;
-	  dst++;
-	  *dst = b;
-	  dst++;
+	  dst[red]     = r;
+	  dst[1]       = g;
+	  dst[2 - red] = b;
+	  dst += 3;
 
 	  py--;
 
@@ -278,12 +286,10 @@ static void vp_stages_YUV420P_to_RGB24(vp_stages_yuv2rgb_config_t *cfg, vp_api_p
 	  VP_STAGES_YUV2ARGB_LIMIT(g, y - ug - vg);
 	  VP_STAGES_YUV2ARGB_LIMIT(b, y + ub     );
 
-	  *dst = r;
-	  dst++;
-	  *dst = g;
-	  dst++;
-	  *dst = b;
-	  dst++;
+	  dst[red]     = r;
+	  dst[1]       = g;
+	  dst[2 - red] = b;
+	  dst += 3;
 
 	  py++;
 
@@ -306,6 +312,41 @@ static void vp_stages_YUV420P_to_RGB24(vp_stages_yuv2rgb_config_t *cfg, vp_api_p
       }
     }
 }
+
+static void vp_stages_YUV420P_to_RGB24(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes)
+{
+  vp_stages_YUV420P_to_RGB24_order(cfg, picture, dst, dst_rbytes, 0);
+}
+
+static void vp_stages_YUV420P_to_BGR24(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes)
+{
+  vp_stages_YUV420P_to_RGB24_order(cfg, picture, dst, dst_rbytes, 2);
+}
+
+/**
+ *  Converts the picture line by line with vp_stages_YUV_to_RGB_row.
+ *  RGB-565 goes by pairs of lines and pixels like vp_stages_YUV420P_to_RGB565.
+ */
+static void vp_stages_YUV420P_to_RGB_rows(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes)
+{
+  uint32_t width  = picture->width;
+  uint32_t height = picture->height;
+  uint32_t line;
+
+  if (cfg->rgb_format == VP_STAGES_RGB_FORMAT_RGB565)
+  {
+    width  &= ~1U;
+    height &= ~1U;
+  }
+
+  for (line = 0; line < height; line++)
+  {
+    vp_stages_YUV_to_RGB_row(picture->y_buf  + line * picture->y_line_size,
+                             picture->cb_buf + (line >> 1) * picture->cb_line_size,
+                             picture->cr_buf + (line >> 1) * picture->cr_line_size,
+                             dst + line * dst_rbytes, width, line);
+  }
+}
 #endif // < QCIF_TO_QVGA
 
 
@@ -483,16 +524,87 @@ static void vp_stages_YUV420P_to_RGB565_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t
 
 
 #ifdef QCIF_TO_QVGA
-#ifndef USE_YUV2RGB_STRETCH
+/* red : offset of the red byte of a pixel, 0 for RGB24 and 2 for BGR24 */
+static void vp_stages_YUV420P_to_RGB24_order_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes, int32_t red)
+{
+  int32_t line, col;
+  int32_t y, u, v, r, g, b;
+  int32_t vr, ug, vg, ub;
+  uint8_t *py, *pu, *pv;
+
+  py = picture->y_buf;
+  pu = picture->cb_buf;
+  pv = picture->cr_buf;
+
+  for (line = 0; line < (QVGA_HEIGHT >> 1); line++) {
+    for (col = 0; col < (QVGA_WIDTH >> 1); col++) {
+      y   = py[col];
+      y   = y << 8;
+      u   = pu[col >> 1] - 128;
+      ug  = 88 * u;
+      ub  = 454 * u;
+      v   = pv[col >> 1] - 128;
+      vg  = 183 * v;
+      vr  = 359 * v;
+
+      VP_STAGES_YUV2ARGB_LIMIT(r, y +      vr);
+      VP_STAGES_YUV2ARGB_LIMIT(g, y - ug - vg);
+      VP_STAGES_YUV2ARGB_LIMIT(b, y + ub     );
+
+      dst[red]     = r;
+      dst[1]       = g;
+      dst[2 - red] = b;
+      dst[3 + red] = r;
+      dst[4]       = g;
+      dst[5 - red] = b;
+      dst += 6;
+    }
+
+    if (line & 1)
+    {
+      pu += picture->cb_line_size;
+      pv += picture->cr_line_size;
+    } // No else
+    py += picture->y_line_size;
+
+    vp_os_memcpy(dst, dst - dst_rbytes, dst_rbytes);
+    dst += dst_rbytes;
+  }
+}
+
 static void vp_stages_YUV420P_to_RGB24_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes)
 {
+  vp_stages_YUV420P_to_RGB24_order_QCIF_to_QVGA(cfg, picture, dst, dst_rbytes, 0);
+}
+
+static void vp_stages_YUV420P_to_BGR24_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes)
+{
+  vp_stages_YUV420P_to_RGB24_order_QCIF_to_QVGA(cfg, picture, dst, dst_rbytes, 2);
+}
+
+/**
+ *  Converts each source line with vp_stages_YUV_to_RGB_row, which writes every pixel twice,
+ *  and copies it on the next line.
+ */
+static void vp_stages_YUV420P_to_RGB_QCIF_to_QVGA_rows(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes)
+{
+  uint32_t line;
+  uint8_t *d;
+
+  for (line = 0; line < (QVGA_HEIGHT >> 1); line++)
+  {
+    d = dst + 2 * line * dst_rbytes;
+    vp_stages_YUV_to_RGB_row(picture->y_buf  + line * picture->y_line_size,
+                             picture->cb_buf + (line >> 1) * picture->cb_line_size,
+                             picture->cr_buf + (line >> 1) * picture->cr_line_size,
+                             d, QVGA_WIDTH >> 1, line);
+    vp_os_memcpy(d + dst_rbytes, d, dst_rbytes);
+  }
 }
-#endif  // < USE_YUV2RGB_STRETCH
 #endif  // <  QCIF_TO_QVGA
 
 
 #ifdef QCIF_TO_QVGA
-#ifndef USE_YUV2RGB_STRETCH
 static void vp_stages_YUV420P_to_ARGB32_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t *cfg, vp_api_picture_t *picture, uint8_t *dst, uint32_t dst_rbytes)
 {
   uint32_t width, height;
@@ -565,7 +677,6 @@ static void vp_stages_YUV420P_to_ARGB32_QCIF_to_QVGA(vp_stages_yuv2rgb_config_t
     dst += (QVGA_WIDTH<<2);
   }
 }
-#endif  // < USE_YUV2RGB_STRETCH
 #endif  // <  QCIF_TO_QVGA
 
 
@@ -883,6 +994,11 @@ static void vp_stages_yuv2rgb_flushline_565(vp_stages_yuv2rgb_config_t *cfg, vp_
     even ^= 6;
     odd ^= 6;
   }
+  if (vp_stages_yuv2rgb_simd_flushline_565(s, d, DST_WIDTH, even, odd))
+  {
+    vp_os_memset(s, 0, DST_WIDTH * sizeof(uint32_t));
+    return;
+  }
   for (i = 0; i < DST_WIDTH; i += 2)
   {
     int32_t   ycc;
@@ -986,6 +1102,15 @@ C_RESULT vp_stages_yuv2rgb_stage_transform(vp_stages_yuv2rgb_config_t *cfg, vp_a
 #endif  // <  QCIF_TO_QVGA
           break;
 
+        case VP_STAGES_RGB_FORMAT_BGR24:
+          bytesPerPixel = 3;
+#ifndef QCIF_TO_QVGA
+          vp_stages_YUV_to_RGB = vp_stages_YUV420P_to_BGR24;
+#else   // QCIF_TO_QVGA
+          vp_stages_YUV_to_RGB = vp_stages_YUV420P_to_BGR24_QCIF_to_QVGA;
+#endif  // <  QCIF_TO_QVGA
+          break;
+
         case VP_STAGES_RGB_FORMAT_ARGB32:
           bytesPerPixel = 4;
 #ifndef QCIF_TO_QVGA
@@ -1000,6 +1125,26 @@ C_RESULT vp_stages_yuv2rgb_stage_transform(vp_stages_yuv2rgb_config_t *cfg, vp_a
           break;
       }
 
+#ifndef QCIF_TO_QVGA
+      // Same results from the SIMD line converters, the scalar ones keep odd widths and upside down pictures
+      vp_stages_YUV_to_RGB_row = vp_stages_yuv2rgb_simd_row(cfg->rgb_format);
+      if (vp_stages_YUV_to_RGB != NULL && vp_stages_YUV_to_RGB_row != NULL && (width & 1) == 0 &&
+          !(bytesPerPixel == 3 && cfg->mode == VP_STAGES_YUV2RGB_MODE_UPSIDE_DOWN))
+      {
+        vp_stages_YUV_to_RGB = vp_stages_YUV420P_to_RGB_rows;
+      }
+#else   // QCIF_TO_QVGA
+      // Same results from the SIMD line converters, the RGB-565 stretch has its own SIMD flush
+      vp_stages_YUV_to_RGB_row = vp_stages_yuv2rgb_simd_row_x2(cfg->rgb_format);
+      if (vp_stages_YUV_to_RGB != NULL && vp_stages_YUV_to_RGB_row != NULL)
+      {
+# ifdef USE_YUV2RGB_STRETCH
+        if (cfg->rgb_format != VP_STAGES_RGB_FORMAT_RGB565)
+# endif  // <  USE_YUV2RGB_STRETCH
+          vp_stages_YUV_to_RGB = vp_stages_YUV420P_to_RGB_QCIF_to_QVGA_rows;
+      }
+#endif  // <  QCIF_TO_QVGA
+
       VP_OS_ASSERT(vp_stages_YUV_to_RGB != NULL);
       VP_OS_ASSERT(bytesPerPixel != 0);
 
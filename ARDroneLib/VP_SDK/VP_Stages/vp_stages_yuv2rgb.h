@@ -19,7 +19,7 @@
  * \section Brief
  * \code
  Gets in input a frame which type is vp_api_picture_t and format is planar YUV-4:2:0.
- Converts it into RGB format : RGB-565 (16 bits), RGB24 or Alpha-RGB (32 bits)
+ Converts it into RGB format : RGB-565 (16 bits), RGB24, BGR24 or Alpha-RGB (32 bits)
  Stores the result frame into the output buffer.
  * \endcode
  *
@@ -41,6 +41,7 @@ typedef enum _VP_STAGES_RGB_FORMAT
   VP_STAGES_RGB_FORMAT_RGB565       = 0,
   VP_STAGES_RGB_FORMAT_RGB24,
   VP_STAGES_RGB_FORMAT_ARGB32,
+  VP_STAGES_RGB_FORMAT_BGR24,       //!< RGB24 with blue first
   VP_STAGES_RGB_FORMAT_MARKER_END
 } VP_STAGES_RGB_FORMAT;
 
@@ -0,0 +1,712 @@
+/**
+ *  @file   vp_stages_yuv2rgb_simd.c
+ *  @brief  VP Stages. SIMD line converters for the YUV to RGB converter stage
+ *
+ *  The scalar converters compute, with Y on 8 bits and (U, V) centered on 0 :
+ *    R = (256*Y + 359*V)          >> 8
+ *    G = (256*Y - 88*U - 183*V)   >> 8
+ *    B = (256*Y + 454*U)          >> 8
+ *  and RGB-565 shifts by 11 or 10 instead of 8, after adding a dither which
+ *  is a multiple of 256. 256*Y and the dither are exact multiples of 256, so
+ *  each component is Y + (chroma term >> 8) (+ dither / 256) shifted by 0, 3
+ *  or 2 : chroma terms are computed on 32 bits, everything else fits 16 bits
+ *  lanes and saturating packs give the same clamping as the scalar code.
+ */
+
+#include <VP_Stages/vp_stages_yuv2rgb_simd.h>
+
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__) && !defined(NO_VP_STAGES_YUV2RGB_SIMD)
+# define VP_STAGES_YUV2RGB_X86
+# include <string.h>
+# include <immintrin.h>
+#endif
+
+/* Chroma terms, V and U weights of a (U, V) pair for pmaddwd */
+#define YUV2RGB_CR_V    359
+#define YUV2RGB_CG_U    -88
+#define YUV2RGB_CG_V    -183
+#define YUV2RGB_CB_U    454
+
+/* RGB-565 dither of the scalar converter, divided by 256 (red and blue, green is half of it) */
+#define YUV2RGB_DITHER_EVEN_LINE_0  0
+#define YUV2RGB_DITHER_EVEN_LINE_1  4
+#define YUV2RGB_DITHER_ODD_LINE_0   6
+#define YUV2RGB_DITHER_ODD_LINE_1   2
+
+#ifdef VP_STAGES_YUV2RGB_X86
+
+static inline uint8_t vp_stages_yuv2rgb_clamp8(int32_t x)
+{
+  return (uint8_t) (x < 0 ? 0 : (x > 0xFF ? 0xFF : x));
+}
+
+static inline uint16_t vp_stages_yuv2rgb_pack565(int32_t r, int32_t g, int32_t b)
+{
+  r >>= 3;  r = r < 0 ? 0 : (r > 0x1F ? 0x1F : r);
+  g >>= 2;  g = g < 0 ? 0 : (g > 0x3F ? 0x3F : g);
+  b >>= 3;  b = b < 0 ? 0 : (b > 0x1F ? 0x1F : b);
+  return (uint16_t) ((r << 11) | (g << 5) | b);
+}
+
+/******************************************************************************/
+/* Generic lines, used for the last pixels of a line                          */
+/******************************************************************************/
+
+/* bytes : 3 (RGB24 / BGR24) or 4 (ARGB32, alpha byte set to 0), first : offset of red */
+static inline void vp_stages_yuv2rgb_row_c(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t bytes, uint32_t first)
+{
+  uint32_t x;
+
+  for (x = 0; x < width; x++)
+  {
+    int32_t u = (int32_t) cb[x >> 1] - 128;
+    int32_t v = (int32_t) cr[x >> 1] - 128;
+
+    dst[first]     = vp_stages_yuv2rgb_clamp8(y[x] + ((YUV2RGB_CR_V * v) >> 8));
+    dst[1]         = vp_stages_yuv2rgb_clamp8(y[x] + ((YUV2RGB_CG_U * u + YUV2RGB_CG_V * v) >> 8));
+    dst[2 - first] = vp_stages_yuv2rgb_clamp8(y[x] + ((YUV2RGB_CB_U * u) >> 8));
+    if (bytes == 4)
+      dst[3] = 0;
+    dst += bytes;
+  }
+}
+
+static void vp_stages_yuv2rgb_row_argb32_c(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  vp_stages_yuv2rgb_row_c(y, cb, cr, dst, width, 4, 2);
+}
+
+/* Pixels go by pairs, a last odd pixel is left untouched like in the scalar converter */
+static void vp_stages_yuv2rgb_row_rgb565_c(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  int32_t d0 = (line & 1) ? YUV2RGB_DITHER_ODD_LINE_0 : YUV2RGB_DITHER_EVEN_LINE_0;
+  int32_t d1 = (line & 1) ? YUV2RGB_DITHER_ODD_LINE_1 : YUV2RGB_DITHER_EVEN_LINE_1;
+  uint16_t *d = (uint16_t *) dst;
+  uint32_t x;
+
+  for (x = 0; x + 1 < width; x += 2)
+  {
+    int32_t u   = (int32_t) cb[x >> 1] - 128;
+    int32_t v   = (int32_t) cr[x >> 1] - 128;
+    int32_t c_r = (YUV2RGB_CR_V * v) >> 8;
+    int32_t c_g = (YUV2RGB_CG_U * u + YUV2RGB_CG_V * v) >> 8;
+    int32_t c_b = (YUV2RGB_CB_U * u) >> 8;
+
+    d[x]     = vp_stages_yuv2rgb_pack565(y[x] + c_r + d0,     y[x] + c_g + (d0 >> 1),     y[x] + c_b + d0);
+    d[x + 1] = vp_stages_yuv2rgb_pack565(y[x + 1] + c_r + d1, y[x + 1] + c_g + (d1 >> 1), y[x + 1] + c_b + d1);
+  }
+}
+
+/******************************************************************************/
+/* SSE2 / SSSE3 : 16 pixels per iteration                                     */
+/******************************************************************************/
+
+#define YUV2RGB_PAIR(u, v)   ((int32_t) (((uint32_t) (uint16_t) (v) << 16) | (uint16_t) (u)))
+
+/* 8 chroma samples to 8 R, G, B terms on 16 bits */
+static inline __attribute__((target("sse2"))) void vp_stages_yuv2rgb_chroma_sse2(const uint8_t *cb, const uint8_t *cr, __m128i *c_r, __m128i *c_g, __m128i *c_b)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bias = _mm_set1_epi16(128);
+  const __m128i k_r  = _mm_set1_epi32(YUV2RGB_PAIR(0, YUV2RGB_CR_V));
+  const __m128i k_g  = _mm_set1_epi32(YUV2RGB_PAIR(YUV2RGB_CG_U, YUV2RGB_CG_V));
+  const __m128i k_b  = _mm_set1_epi32(YUV2RGB_PAIR(YUV2RGB_CB_U, 0));
+  __m128i u  = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) cb), zero), bias);
+  __m128i v  = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) cr), zero), bias);
+  __m128i lo = _mm_unpacklo_epi16(u, v);
+  __m128i hi = _mm_unpackhi_epi16(u, v);
+
+  *c_r = _mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(lo, k_r), 8), _mm_srai_epi32(_mm_madd_epi16(hi, k_r), 8));
+  *c_g = _mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(lo, k_g), 8), _mm_srai_epi32(_mm_madd_epi16(hi, k_g), 8));
+  *c_b = _mm_packs_epi32(_mm_srai_epi32(_mm_madd_epi16(lo, k_b), 8), _mm_srai_epi32(_mm_madd_epi16(hi, k_b), 8));
+}
+
+/* 16 pixels to 4 vectors of 4 pixels, first, second and third bytes set from c0, c1, c2, fourth byte to 0 */
+static inline __attribute__((target("sse2"))) void vp_stages_yuv2rgb_pixels_sse2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, bool_t bgr, __m128i px[4])
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i c_r, c_g, c_b, c, y0, y1, r, g, b, c0, c1, c2, p01, p2;
+
+  vp_stages_yuv2rgb_chroma_sse2(cb, cr, &c_r, &c_g, &c_b);
+  c  = _mm_loadu_si128((const __m128i *) y);
+  y0 = _mm_unpacklo_epi8(c, zero);
+  y1 = _mm_unpackhi_epi8(c, zero);
+
+  r = _mm_packus_epi16(_mm_add_epi16(y0, _mm_unpacklo_epi16(c_r, c_r)), _mm_add_epi16(y1, _mm_unpackhi_epi16(c_r, c_r)));
+  g = _mm_packus_epi16(_mm_add_epi16(y0, _mm_unpacklo_epi16(c_g, c_g)), _mm_add_epi16(y1, _mm_unpackhi_epi16(c_g, c_g)));
+  b = _mm_packus_epi16(_mm_add_epi16(y0, _mm_unpacklo_epi16(c_b, c_b)), _mm_add_epi16(y1, _mm_unpackhi_epi16(c_b, c_b)));
+
+  c0 = bgr ? b : r;
+  c1 = g;
+  c2 = bgr ? r : b;
+
+  p01 = _mm_unpacklo_epi8(c0, c1);
+  p2  = _mm_unpacklo_epi8(c2, zero);
+  px[0] = _mm_unpacklo_epi16(p01, p2);
+  px[1] = _mm_unpackhi_epi16(p01, p2);
+  p01 = _mm_unpackhi_epi8(c0, c1);
+  p2  = _mm_unpackhi_epi8(c2, zero);
+  px[2] = _mm_unpacklo_epi16(p01, p2);
+  px[3] = _mm_unpackhi_epi16(p01, p2);
+}
+
+static __attribute__((target("sse2"))) void vp_stages_yuv2rgb_row_argb32_sse2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  uint32_t x;
+  __m128i px[4];
+
+  for (x = 0; x + 16 <= width; x += 16)
+  {
+    vp_stages_yuv2rgb_pixels_sse2(y + x, cb + (x >> 1), cr + (x >> 1), TRUE, px);
+    _mm_storeu_si128((__m128i *) (dst + 4 * x),      px[0]);
+    _mm_storeu_si128((__m128i *) (dst + 4 * x + 16), px[1]);
+    _mm_storeu_si128((__m128i *) (dst + 4 * x + 32), px[2]);
+    _mm_storeu_si128((__m128i *) (dst + 4 * x + 48), px[3]);
+  }
+
+  vp_stages_yuv2rgb_row_argb32_c(y + x, cb + (x >> 1), cr + (x >> 1), dst + 4 * x, width - x, line);
+}
+
+/* No byte shuffle in SSE2 : three bytes of each pixel are copied */
+static inline __attribute__((target("sse2"))) void vp_stages_yuv2rgb_row24_sse2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, bool_t bgr)
+{
+  uint32_t pixels[16];
+  uint32_t x, i;
+  __m128i px[4];
+
+  for (x = 0; x + 16 <= width; x += 16)
+  {
+    vp_stages_yuv2rgb_pixels_sse2(y + x, cb + (x >> 1), cr + (x >> 1), bgr, px);
+    _mm_storeu_si128((__m128i *) &pixels[0],  px[0]);
+    _mm_storeu_si128((__m128i *) &pixels[4],  px[1]);
+    _mm_storeu_si128((__m128i *) &pixels[8],  px[2]);
+    _mm_storeu_si128((__m128i *) &pixels[12], px[3]);
+    for (i = 0; i < 16; i++)
+      memcpy(dst + 3 * (x + i), &pixels[i], 3);
+  }
+
+  vp_stages_yuv2rgb_row_c(y + x, cb + (x >> 1), cr + (x >> 1), dst + 3 * x, width - x, 3, bgr ? 2 : 0);
+}
+
+static __attribute__((target("sse2"))) void vp_stages_yuv2rgb_row_rgb24_sse2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  vp_stages_yuv2rgb_row24_sse2(y, cb, cr, dst, width, FALSE);
+}
+
+static __attribute__((target("sse2"))) void vp_stages_yuv2rgb_row_bgr24_sse2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  vp_stages_yuv2rgb_row24_sse2(y, cb, cr, dst, width, TRUE);
+}
+
+/* Lower 12 bytes of a vector */
+static inline __attribute__((target("sse2"))) void vp_stages_yuv2rgb_store12_sse2(uint8_t *dst, __m128i v)
+{
+  int32_t last = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+
+  _mm_storel_epi64((__m128i *) dst, v);
+  memcpy(dst + 8, &last, 4);
+}
+
+static inline __attribute__((target("ssse3"))) void vp_stages_yuv2rgb_row24_ssse3(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, bool_t bgr)
+{
+  const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  uint32_t x;
+  __m128i px[4];
+
+  for (x = 0; x + 16 <= width; x += 16)
+  {
+    uint8_t *d = dst + 3 * x;
+
+    vp_stages_yuv2rgb_pixels_sse2(y + x, cb + (x >> 1), cr + (x >> 1), bgr, px);
+
+    // Each store writes 4 bytes too many, overwritten by the next one
+    _mm_storeu_si128((__m128i *) (d),      _mm_shuffle_epi8(px[0], pack));
+    _mm_storeu_si128((__m128i *) (d + 12), _mm_shuffle_epi8(px[1], pack));
+    _mm_storeu_si128((__m128i *) (d + 24), _mm_shuffle_epi8(px[2], pack));
+    vp_stages_yuv2rgb_store12_sse2(d + 36, _mm_shuffle_epi8(px[3], pack));
+  }
+
+  vp_stages_yuv2rgb_row_c(y + x, cb + (x >> 1), cr + (x >> 1), dst + 3 * x, width - x, 3, bgr ? 2 : 0);
+}
+
+static __attribute__((target("ssse3"))) void vp_stages_yuv2rgb_row_rgb24_ssse3(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  vp_stages_yuv2rgb_row24_ssse3(y, cb, cr, dst, width, FALSE);
+}
+
+static __attribute__((target("ssse3"))) void vp_stages_yuv2rgb_row_bgr24_ssse3(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  vp_stages_yuv2rgb_row24_ssse3(y, cb, cr, dst, width, TRUE);
+}
+
+/* One component of 8 RGB-565 pixels : (y + c + dither) >> shift, saturated to max */
+static inline __attribute__((target("sse2"))) __m128i vp_stages_yuv2rgb_565_sse2(__m128i y, __m128i c, __m128i dither, int shift, int16_t max)
+{
+  __m128i v = _mm_add_epi16(_mm_add_epi16(y, c), dither);
+
+  v = (shift == 3) ? _mm_srai_epi16(v, 3) : _mm_srai_epi16(v, 2);
+  return _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), _mm_set1_epi16(max));
+}
+
+static __attribute__((target("sse2"))) void vp_stages_yuv2rgb_row_rgb565_sse2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  const __m128i zero = _mm_setzero_si128();
+  int16_t d0 = (line & 1) ? YUV2RGB_DITHER_ODD_LINE_0 : YUV2RGB_DITHER_EVEN_LINE_0;
+  int16_t d1 = (line & 1) ? YUV2RGB_DITHER_ODD_LINE_1 : YUV2RGB_DITHER_EVEN_LINE_1;
+  const __m128i dither   = _mm_setr_epi16(d0, d1, d0, d1, d0, d1, d0, d1);
+  const __m128i dither_g = _mm_srai_epi16(dither, 1);
+  uint16_t *d = (uint16_t *) dst;
+  uint32_t x;
+
+  for (x = 0; x + 16 <= width; x += 16)
+  {
+    __m128i c_r, c_g, c_b, c, yy, r, g, b;
+    int half;
+
+    vp_stages_yuv2rgb_chroma_sse2(cb + (x >> 1), cr + (x >> 1), &c_r, &c_g, &c_b);
+    c = _mm_loadu_si128((const __m128i *) (y + x));
+
+    for (half = 0; half < 2; half++)
+    {
+      __m128i h_r = half ? _mm_unpackhi_epi16(c_r, c_r) : _mm_unpacklo_epi16(c_r, c_r);
+      __m128i h_g = half ? _mm_unpackhi_epi16(c_g, c_g) : _mm_unpacklo_epi16(c_g, c_g);
+      __m128i h_b = half ? _mm_unpackhi_epi16(c_b, c_b) : _mm_unpacklo_epi16(c_b, c_b);
+
+      yy = half ? _mm_unpackhi_epi8(c, zero) : _mm_unpacklo_epi8(c, zero);
+      r  = vp_stages_yuv2rgb_565_sse2(yy, h_r, dither,   3, 0x1F);
+      g  = vp_stages_yuv2rgb_565_sse2(yy, h_g, dither_g, 2, 0x3F);
+      b  = vp_stages_yuv2rgb_565_sse2(yy, h_b, dither,   3, 0x1F);
+
+      _mm_storeu_si128((__m128i *) (d + x + 8 * half),
+                       _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b));
+    }
+  }
+
+  vp_stages_yuv2rgb_row_rgb565_c(y + x, cb + (x >> 1), cr + (x >> 1), (uint8_t *) (d + x), width - x, line);
+}
+
+/******************************************************************************/
+/* AVX2 : 32 pixels per iteration                                             */
+/******************************************************************************/
+
+/* 16 chroma samples to 2 x 16 R, G, B terms on 16 bits, one per pixel */
+static inline __attribute__((target("avx2"))) void vp_stages_yuv2rgb_chroma_avx2(const uint8_t *cb, const uint8_t *cr, __m256i c_r[2], __m256i c_g[2], __m256i c_b[2])
+{
+  const __m256i bias = _mm256_set1_epi16(128);
+  const __m256i k_r  = _mm256_set1_epi32(YUV2RGB_PAIR(0, YUV2RGB_CR_V));
+  const __m256i k_g  = _mm256_set1_epi32(YUV2RGB_PAIR(YUV2RGB_CG_U, YUV2RGB_CG_V));
+  const __m256i k_b  = _mm256_set1_epi32(YUV2RGB_PAIR(YUV2RGB_CB_U, 0));
+  __m256i u  = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) cb)), bias);
+  __m256i v  = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) cr)), bias);
+  // unpack and pack work within 128 bits lanes : packing back restores the order
+  __m256i lo = _mm256_unpacklo_epi16(u, v);
+  __m256i hi = _mm256_unpackhi_epi16(u, v);
+  __m256i t, tlo, thi;
+
+#define YUV2RGB_CHROMA_AVX2(k, out)                                                                             \
+  t   = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_madd_epi16(lo, k), 8), _mm256_srai_epi32(_mm256_madd_epi16(hi, k), 8)); \
+  tlo = _mm256_unpacklo_epi16(t, t);                                                                            \
+  thi = _mm256_unpackhi_epi16(t, t);                                                                            \
+  out[0] = _mm256_permute2x128_si256(tlo, thi, 0x20);                                                           \
+  out[1] = _mm256_permute2x128_si256(tlo, thi, 0x31);
+
+  YUV2RGB_CHROMA_AVX2(k_r, c_r)
+  YUV2RGB_CHROMA_AVX2(k_g, c_g)
+  YUV2RGB_CHROMA_AVX2(k_b, c_b)
+
+#undef YUV2RGB_CHROMA_AVX2
+}
+
+static inline __attribute__((target("avx2"))) __m256i vp_stages_yuv2rgb_clamp8_avx2(__m256i v)
+{
+  return _mm256_min_epi16(_mm256_max_epi16(v, _mm256_setzero_si256()), _mm256_set1_epi16(0xFF));
+}
+
+/* 32 pixels to 4 vectors of 8 pixels, first, second and third bytes set from c0, c1, c2, fourth byte to 0 */
+static inline __attribute__((target("avx2"))) void vp_stages_yuv2rgb_pixels_avx2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, bool_t bgr, __m256i px[4])
+{
+  __m256i c_r[2], c_g[2], c_b[2];
+  int half;
+
+  vp_stages_yuv2rgb_chroma_avx2(cb, cr, c_r, c_g, c_b);
+
+  for (half = 0; half < 2; half++)
+  {
+    __m256i yy = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (y + 16 * half)));
+    __m256i r  = vp_stages_yuv2rgb_clamp8_avx2(_mm256_add_epi16(yy, c_r[half]));
+    __m256i g  = vp_stages_yuv2rgb_clamp8_avx2(_mm256_add_epi16(yy, c_g[half]));
+    __m256i b  = vp_stages_yuv2rgb_clamp8_avx2(_mm256_add_epi16(yy, c_b[half]));
+    __m256i c01 = _mm256_or_si256(bgr ? b : r, _mm256_slli_epi16(g, 8));
+    __m256i c2  = bgr ? r : b;
+    __m256i lo  = _mm256_unpacklo_epi16(c01, c2);
+    __m256i hi  = _mm256_unpackhi_epi16(c01, c2);
+
+    px[2 * half]     = _mm256_permute2x128_si256(lo, hi, 0x20);
+    px[2 * half + 1] = _mm256_permute2x128_si256(lo, hi, 0x31);
+  }
+}
+
+static __attribute__((target("avx2"))) void vp_stages_yuv2rgb_row_argb32_avx2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  uint32_t x;
+  __m256i px[4];
+
+  for (x = 0; x + 32 <= width; x += 32)
+  {
+    vp_stages_yuv2rgb_pixels_avx2(y + x, cb + (x >> 1), cr + (x >> 1), TRUE, px);
+    _mm256_storeu_si256((__m256i *) (dst + 4 * x),      px[0]);
+    _mm256_storeu_si256((__m256i *) (dst + 4 * x + 32), px[1]);
+    _mm256_storeu_si256((__m256i *) (dst + 4 * x + 64), px[2]);
+    _mm256_storeu_si256((__m256i *) (dst + 4 * x + 96), px[3]);
+  }
+
+  vp_stages_yuv2rgb_row_argb32_sse2(y + x, cb + (x >> 1), cr + (x >> 1), dst + 4 * x, width - x, line);
+}
+
+static inline __attribute__((target("avx2"))) void vp_stages_yuv2rgb_row24_avx2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, bool_t bgr)
+{
+  const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  uint32_t x;
+  int i;
+  __m256i px[4];
+
+  for (x = 0; x + 32 <= width; x += 32)
+  {
+    uint8_t *d = dst + 3 * x;
+
+    vp_stages_yuv2rgb_pixels_avx2(y + x, cb + (x >> 1), cr + (x >> 1), bgr, px);
+
+    // 12 bytes per 128 bits lane, each store but the last writes 4 bytes overwritten by the next one
+    for (i = 0; i < 4; i++)
+    {
+      __m256i p = _mm256_shuffle_epi8(px[i], pack);
+
+      _mm_storeu_si128((__m128i *) (d + 24 * i), _mm256_castsi256_si128(p));
+      if (i < 3)
+        _mm_storeu_si128((__m128i *) (d + 24 * i + 12), _mm256_extracti128_si256(p, 1));
+      else
+        vp_stages_yuv2rgb_store12_sse2(d + 24 * i + 12, _mm256_extracti128_si256(p, 1));
+    }
+  }
+
+  vp_stages_yuv2rgb_row24_ssse3(y + x, cb + (x >> 1), cr + (x >> 1), dst + 3 * x, width - x, bgr);
+}
+
+static __attribute__((target("avx2"))) void vp_stages_yuv2rgb_row_rgb24_avx2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  vp_stages_yuv2rgb_row24_avx2(y, cb, cr, dst, width, FALSE);
+}
+
+static __attribute__((target("avx2"))) void vp_stages_yuv2rgb_row_bgr24_avx2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  vp_stages_yuv2rgb_row24_avx2(y, cb, cr, dst, width, TRUE);
+}
+
+static __attribute__((target("avx2"))) void vp_stages_yuv2rgb_row_rgb565_avx2(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line)
+{
+  int16_t d0 = (line & 1) ? YUV2RGB_DITHER_ODD_LINE_0 : YUV2RGB_DITHER_EVEN_LINE_0;
+  int16_t d1 = (line & 1) ? YUV2RGB_DITHER_ODD_LINE_1 : YUV2RGB_DITHER_EVEN_LINE_1;
+  const __m256i dither   = _mm256_setr_epi16(d0, d1, d0, d1, d0, d1, d0, d1, d0, d1, d0, d1, d0, d1, d0, d1);
+  const __m256i dither_g = _mm256_srai_epi16(dither, 1);
+  const __m256i zero     = _mm256_setzero_si256();
+  const __m256i max5     = _mm256_set1_epi16(0x1F);
+  const __m256i max6     = _mm256_set1_epi16(0x3F);
+  uint16_t *d = (uint16_t *) dst;
+  uint32_t x;
+
+  for (x = 0; x + 32 <= width; x += 32)
+  {
+    __m256i c_r[2], c_g[2], c_b[2];
+    int half;
+
+    vp_stages_yuv2rgb_chroma_avx2(cb + (x >> 1), cr + (x >> 1), c_r, c_g, c_b);
+
+    for (half = 0; half < 2; half++)
+    {
+      __m256i yy = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (y + x + 16 * half)));
+      __m256i r  = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(yy, c_r[half]), dither),   3);
+      __m256i g  = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(yy, c_g[half]), dither_g), 2);
+      __m256i b  = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(yy, c_b[half]), dither),   3);
+
+      r = _mm256_min_epi16(_mm256_max_epi16(r, zero), max5);
+      g = _mm256_min_epi16(_mm256_max_epi16(g, zero), max6);
+      b = _mm256_min_epi16(_mm256_max_epi16(b, zero), max5);
+
+      _mm256_storeu_si256((__m256i *) (d + x + 16 * half),
+                          _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi16(r, 11), _mm256_slli_epi16(g, 5)), b));
+    }
+  }
+
+  vp_stages_yuv2rgb_row_rgb565_sse2(y + x, cb + (x >> 1), cr + (x >> 1), (uint8_t *) (d + x), width - x, line);
+}
+
+/******************************************************************************/
+/* QCIF to QVGA stretch                                                       */
+/******************************************************************************/
+
+/* Same fields and dither as vp_stages_yuv2rgb_flushline_565 : Y on bits 31-24, Cr, Cg and Cb on 9 bits below */
+static __attribute__((target("sse2"))) void vp_stages_yuv2rgb_flushline_565_sse2(const uint32_t *src, uint16_t *dst, uint32_t width, int32_t even, int32_t odd)
+{
+  const __m128i dither   = _mm_setr_epi32(even, odd, even, odd);
+  const __m128i dither_g = _mm_srai_epi32(dither, 1);
+  const __m128i off_r    = _mm_set1_epi32(180);
+  const __m128i off_g    = _mm_set1_epi32(135);
+  const __m128i off_b    = _mm_set1_epi32(227);
+  const __m128i zero     = _mm_setzero_si128();
+  uint32_t i;
+
+  for (i = 0; i + 8 <= width; i += 8)
+  {
+    __m128i r[2], g[2], b[2];
+    int k;
+
+    for (k = 0; k < 2; k++)
+    {
+      __m128i ycc = _mm_loadu_si128((const __m128i *) (src + i + 4 * k));
+      __m128i yy  = _mm_srli_epi32(ycc, 24);
+      __m128i c_r = _mm_sub_epi32(_mm_srli_epi32(_mm_slli_epi32(ycc, 8),  23), off_r);
+      __m128i c_g = _mm_sub_epi32(_mm_srli_epi32(_mm_slli_epi32(ycc, 16), 23), off_g);
+      __m128i c_b = _mm_sub_epi32(_mm_srli_epi32(_mm_slli_epi32(ycc, 24), 23), off_b);
+
+      r[k] = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(dither, yy), c_r), 3);
+      g[k] = _mm_srai_epi32(_mm_sub_epi32(_mm_add_epi32(dither_g, yy), c_g), 2);
+      b[k] = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(dither, yy), c_b), 3);
+    }
+
+    r[0] = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(r[0], r[1]), zero), _mm_set1_epi16(0x1F));
+    g[0] = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(g[0], g[1]), zero), _mm_set1_epi16(0x3F));
+    b[0] = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(b[0], b[1]), zero), _mm_set1_epi16(0x1F));
+
+    _mm_storeu_si128((__m128i *) (dst + i), _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r[0], 11), _mm_slli_epi16(g[0], 5)), b[0]));
+  }
+}
+
+/******************************************************************************/
+/* QCIF to QVGA : each pixel written twice                                    */
+/******************************************************************************/
+
+#define YUV2RGB_X2_CHUNK    256     // Pixels converted at a time, even for the chroma
+
+static void vp_stages_yuv2rgb_twice24_c(const uint8_t *src, uint8_t *dst, uint32_t pixels)
+{
+  uint32_t x;
+
+  for (x = 0; x < pixels; x++)
+  {
+    memcpy(dst + 6 * x,     src + 3 * x, 3);
+    memcpy(dst + 6 * x + 3, src + 3 * x, 3);
+  }
+}
+
+static __attribute__((target("sse2"))) void vp_stages_yuv2rgb_twice16_sse2(const uint8_t *src, uint8_t *dst, uint32_t pixels)
+{
+  uint32_t x;
+
+  for (x = 0; x + 8 <= pixels; x += 8)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *) (src + 2 * x));
+    _mm_storeu_si128((__m128i *) (dst + 4 * x),      _mm_unpacklo_epi16(v, v));
+    _mm_storeu_si128((__m128i *) (dst + 4 * x + 16), _mm_unpackhi_epi16(v, v));
+  }
+
+  for (; x < pixels; x++)
+  {
+    memcpy(dst + 4 * x,     src + 2 * x, 2);
+    memcpy(dst + 4 * x + 2, src + 2 * x, 2);
+  }
+}
+
+static __attribute__((target("sse2"))) void vp_stages_yuv2rgb_twice32_sse2(const uint8_t *src, uint8_t *dst, uint32_t pixels)
+{
+  uint32_t x;
+
+  for (x = 0; x + 4 <= pixels; x += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *) (src + 4 * x));
+    _mm_storeu_si128((__m128i *) (dst + 8 * x),      _mm_unpacklo_epi32(v, v));
+    _mm_storeu_si128((__m128i *) (dst + 8 * x + 16), _mm_unpackhi_epi32(v, v));
+  }
+
+  for (; x < pixels; x++)
+  {
+    memcpy(dst + 8 * x,     src + 4 * x, 4);
+    memcpy(dst + 8 * x + 4, src + 4 * x, 4);
+  }
+}
+
+/* 4 pixels (12 bytes) to 24 bytes, the 16 bytes load stays inside the line while 6 pixels are left */
+static __attribute__((target("ssse3"))) void vp_stages_yuv2rgb_twice24_ssse3(const uint8_t *src, uint8_t *dst, uint32_t pixels)
+{
+  const __m128i lo = _mm_setr_epi8(0, 1, 2, 0, 1, 2, 3, 4, 5, 3, 4, 5, 6, 7, 8, 6);
+  const __m128i hi = _mm_setr_epi8(7, 8, 9, 10, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1);
+  uint32_t x;
+
+  for (x = 0; x + 6 <= pixels; x += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *) (src + 3 * x));
+    _mm_storeu_si128((__m128i *) (dst + 6 * x),      _mm_shuffle_epi8(v, lo));
+    _mm_storel_epi64((__m128i *) (dst + 6 * x + 16), _mm_shuffle_epi8(v, hi));
+  }
+
+  vp_stages_yuv2rgb_twice24_c(src + 3 * x, dst + 6 * x, pixels - x);
+}
+
+/* row converts a chunk in a line buffer, twice writes each of its pixels two times in dst */
+#define YUV2RGB_ROW_X2(name, row, bytes, twice)                                                                  \
+static void name(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line) \
+{                                                                                                                \
+  uint8_t  buffer[YUV2RGB_X2_CHUNK * 4];                                                                         \
+  uint32_t x, n;                                                                                                 \
+                                                                                                                 \
+  for (x = 0; x < width; x += n)                                                                                 \
+  {                                                                                                              \
+    n = (width - x < YUV2RGB_X2_CHUNK) ? width - x : YUV2RGB_X2_CHUNK;                                          \
+    row(y + x, cb + (x >> 1), cr + (x >> 1), buffer, n, line);                                                   \
+    twice(buffer, dst + 2 * (bytes) * x, n);                                                                     \
+  }                                                                                                              \
+}
+
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_rgb565_sse2,  vp_stages_yuv2rgb_row_rgb565_sse2,  2, vp_stages_yuv2rgb_twice16_sse2)
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_rgb24_sse2,   vp_stages_yuv2rgb_row_rgb24_sse2,   3, vp_stages_yuv2rgb_twice24_c)
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_bgr24_sse2,   vp_stages_yuv2rgb_row_bgr24_sse2,   3, vp_stages_yuv2rgb_twice24_c)
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_argb32_sse2,  vp_stages_yuv2rgb_row_argb32_sse2,  4, vp_stages_yuv2rgb_twice32_sse2)
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_rgb24_ssse3,  vp_stages_yuv2rgb_row_rgb24_ssse3,  3, vp_stages_yuv2rgb_twice24_ssse3)
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_bgr24_ssse3,  vp_stages_yuv2rgb_row_bgr24_ssse3,  3, vp_stages_yuv2rgb_twice24_ssse3)
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_rgb565_avx2,  vp_stages_yuv2rgb_row_rgb565_avx2,  2, vp_stages_yuv2rgb_twice16_sse2)
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_rgb24_avx2,   vp_stages_yuv2rgb_row_rgb24_avx2,   3, vp_stages_yuv2rgb_twice24_ssse3)
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_bgr24_avx2,   vp_stages_yuv2rgb_row_bgr24_avx2,   3, vp_stages_yuv2rgb_twice24_ssse3)
+YUV2RGB_ROW_X2(vp_stages_yuv2rgb_row_x2_argb32_avx2,  vp_stages_yuv2rgb_row_argb32_avx2,  4, vp_stages_yuv2rgb_twice32_sse2)
+
+#endif // VP_STAGES_YUV2RGB_X86
+
+/******************************************************************************/
+/* Dispatch                                                                   */
+/******************************************************************************/
+
+static int32_t vp_stages_yuv2rgb_simd_level = -1;
+
+static VP_STAGES_YUV2RGB_SIMD_LEVEL vp_stages_yuv2rgb_simd_supported(void)
+{
+#ifdef VP_STAGES_YUV2RGB_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return VP_STAGES_YUV2RGB_SIMD_AVX2;
+  if (__builtin_cpu_supports("ssse3"))
+    return VP_STAGES_YUV2RGB_SIMD_SSSE3;
+  if (__builtin_cpu_supports("sse2"))
+    return VP_STAGES_YUV2RGB_SIMD_SSE2;
+#endif
+  return VP_STAGES_YUV2RGB_SIMD_NONE;
+}
+
+VP_STAGES_YUV2RGB_SIMD_LEVEL vp_stages_yuv2rgb_simd_level_set(VP_STAGES_YUV2RGB_SIMD_LEVEL level)
+{
+  VP_STAGES_YUV2RGB_SIMD_LEVEL supported = vp_stages_yuv2rgb_simd_supported();
+
+  vp_stages_yuv2rgb_simd_level = (level > supported) ? supported : level;
+
+  return (VP_STAGES_YUV2RGB_SIMD_LEVEL) vp_stages_yuv2rgb_simd_level;
+}
+
+VP_STAGES_YUV2RGB_SIMD_LEVEL vp_stages_yuv2rgb_simd_level_get(void)
+{
+  if (vp_stages_yuv2rgb_simd_level < 0)
+    vp_stages_yuv2rgb_simd_level_set(VP_STAGES_YUV2RGB_SIMD_BEST);
+
+  return (VP_STAGES_YUV2RGB_SIMD_LEVEL) vp_stages_yuv2rgb_simd_level;
+}
+
+vp_stages_yuv2rgb_row_t vp_stages_yuv2rgb_simd_row(VP_STAGES_RGB_FORMAT format)
+{
+  switch (vp_stages_yuv2rgb_simd_level_get())
+  {
+#ifdef VP_STAGES_YUV2RGB_X86
+    case VP_STAGES_YUV2RGB_SIMD_AVX2:
+      switch (format)
+      {
+        case VP_STAGES_RGB_FORMAT_RGB565: return vp_stages_yuv2rgb_row_rgb565_avx2;
+        case VP_STAGES_RGB_FORMAT_RGB24:  return vp_stages_yuv2rgb_row_rgb24_avx2;
+        case VP_STAGES_RGB_FORMAT_BGR24:  return vp_stages_yuv2rgb_row_bgr24_avx2;
+        case VP_STAGES_RGB_FORMAT_ARGB32: return vp_stages_yuv2rgb_row_argb32_avx2;
+        default:                          return NULL;
+      }
+
+    case VP_STAGES_YUV2RGB_SIMD_SSSE3:
+      switch (format)
+      {
+        case VP_STAGES_RGB_FORMAT_RGB565: return vp_stages_yuv2rgb_row_rgb565_sse2;
+        case VP_STAGES_RGB_FORMAT_RGB24:  return vp_stages_yuv2rgb_row_rgb24_ssse3;
+        case VP_STAGES_RGB_FORMAT_BGR24:  return vp_stages_yuv2rgb_row_bgr24_ssse3;
+        case VP_STAGES_RGB_FORMAT_ARGB32: return vp_stages_yuv2rgb_row_argb32_sse2;
+        default:                          return NULL;
+      }
+
+    case VP_STAGES_YUV2RGB_SIMD_SSE2:
+      switch (format)
+      {
+        case VP_STAGES_RGB_FORMAT_RGB565: return vp_stages_yuv2rgb_row_rgb565_sse2;
+        case VP_STAGES_RGB_FORMAT_RGB24:  return vp_stages_yuv2rgb_row_rgb24_sse2;
+        case VP_STAGES_RGB_FORMAT_BGR24:  return vp_stages_yuv2rgb_row_bgr24_sse2;
+        case VP_STAGES_RGB_FORMAT_ARGB32: return vp_stages_yuv2rgb_row_argb32_sse2;
+        default:                          return NULL;
+      }
+#endif // VP_STAGES_YUV2RGB_X86
+
+    default:
+      return NULL;
+  }
+}
+
+vp_stages_yuv2rgb_row_t vp_stages_yuv2rgb_simd_row_x2(VP_STAGES_RGB_FORMAT format)
+{
+  switch (vp_stages_yuv2rgb_simd_level_get())
+  {
+#ifdef VP_STAGES_YUV2RGB_X86
+    case VP_STAGES_YUV2RGB_SIMD_AVX2:
+      switch (format)
+      {
+        case VP_STAGES_RGB_FORMAT_RGB565: return vp_stages_yuv2rgb_row_x2_rgb565_avx2;
+        case VP_STAGES_RGB_FORMAT_RGB24:  return vp_stages_yuv2rgb_row_x2_rgb24_avx2;
+        case VP_STAGES_RGB_FORMAT_BGR24:  return vp_stages_yuv2rgb_row_x2_bgr24_avx2;
+        case VP_STAGES_RGB_FORMAT_ARGB32: return vp_stages_yuv2rgb_row_x2_argb32_avx2;
+        default:                          return NULL;
+      }
+
+    case VP_STAGES_YUV2RGB_SIMD_SSSE3:
+      switch (format)
+      {
+        case VP_STAGES_RGB_FORMAT_RGB565: return vp_stages_yuv2rgb_row_x2_rgb565_sse2;
+        case VP_STAGES_RGB_FORMAT_RGB24:  return vp_stages_yuv2rgb_row_x2_rgb24_ssse3;
+        case VP_STAGES_RGB_FORMAT_BGR24:  return vp_stages_yuv2rgb_row_x2_bgr24_ssse3;
+        case VP_STAGES_RGB_FORMAT_ARGB32: return vp_stages_yuv2rgb_row_x2_argb32_sse2;
+        default:                          return NULL;
+      }
+
+    case VP_STAGES_YUV2RGB_SIMD_SSE2:
+      switch (format)
+      {
+        case VP_STAGES_RGB_FORMAT_RGB565: return vp_stages_yuv2rgb_row_x2_rgb565_sse2;
+        case VP_STAGES_RGB_FORMAT_RGB24:  return vp_stages_yuv2rgb_row_x2_rgb24_sse2;
+        case VP_STAGES_RGB_FORMAT_BGR24:  return vp_stages_yuv2rgb_row_x2_bgr24_sse2;
+        case VP_STAGES_RGB_FORMAT_ARGB32: return vp_stages_yuv2rgb_row_x2_argb32_sse2;
+        default:                          return NULL;
+      }
+#endif // VP_STAGES_YUV2RGB_X86
+
+    default:
+      return NULL;
+  }
+}
+
+bool_t vp_stages_yuv2rgb_simd_flushline_565(const uint32_t *src, uint16_t *dst, uint32_t width, int32_t even, int32_t odd)
+{
+#ifdef VP_STAGES_YUV2RGB_X86
+  if (vp_stages_yuv2rgb_simd_level_get() != VP_STAGES_YUV2RGB_SIMD_NONE && (width & 7) == 0)
+  {
+    vp_stages_yuv2rgb_flushline_565_sse2(src, dst, width, even, odd);
+    return TRUE;
+  }
+#endif
+  return FALSE;
+}
@@ -0,0 +1,84 @@
+/**
+ *  @file   vp_stages_yuv2rgb_simd.h
+ *  @brief  VP Stages. SIMD line converters for the YUV to RGB converter stage
+ */
+
+#ifndef _VP_STAGES_YUV2RGB_SIMD_INCLUDE_
+#define _VP_STAGES_YUV2RGB_SIMD_INCLUDE_
+
+/**
+ * @addtogroup vp_stages_yuv2rgb
+ * @{ */
+
+/**
+ * \section Brief
+ * \code
+ One YUV-4:2:0p line is converted at a time, with the same integer arithmetic
+ as the scalar converters of vp_stages_yuv2rgb.c : the results are bit exact.
+ The instruction set is chosen at run time from what the CPU supports, x86
+ (SSE2, SSSE3, AVX2) only. Other targets keep the scalar converters.
+ * \endcode
+ */
+
+#include <VP_Stages/vp_stages_yuv2rgb.h>
+
+///////////////////////////////////////////////
+// TYPEDEFS
+
+typedef enum _VP_STAGES_YUV2RGB_SIMD_LEVEL
+{
+  VP_STAGES_YUV2RGB_SIMD_NONE = 0,  //!< Scalar converters of vp_stages_yuv2rgb.c
+  VP_STAGES_YUV2RGB_SIMD_SSE2,
+  VP_STAGES_YUV2RGB_SIMD_SSSE3,
+  VP_STAGES_YUV2RGB_SIMD_AVX2,
+  VP_STAGES_YUV2RGB_SIMD_BEST       //!< Highest level supported by the CPU
+} VP_STAGES_YUV2RGB_SIMD_LEVEL;
+
+/**
+ *  @var     vp_stages_yuv2rgb_row_t
+ *  @brief   Converts one line of width pixels. line parity selects the RGB-565 dither
+ */
+typedef void (*vp_stages_yuv2rgb_row_t)(const uint8_t *y, const uint8_t *cb, const uint8_t *cr, uint8_t *dst, uint32_t width, uint32_t line);
+
+///////////////////////////////////////////////
+// FUNCTIONS
+
+/**
+ *  @fn      vp_stages_yuv2rgb_simd_level_set(VP_STAGES_YUV2RGB_SIMD_LEVEL)
+ *  @brief   Selects the instruction set, lowered to what the CPU supports.
+ *
+ *  Takes effect when a converter stage is (re)initialized.
+ *  @return  Level in use
+ */
+VP_STAGES_YUV2RGB_SIMD_LEVEL vp_stages_yuv2rgb_simd_level_set(VP_STAGES_YUV2RGB_SIMD_LEVEL level);
+
+/**
+ *  @fn      vp_stages_yuv2rgb_simd_level_get(void)
+ *  @return  Level in use, VP_STAGES_YUV2RGB_SIMD_BEST by default
+ */
+VP_STAGES_YUV2RGB_SIMD_LEVEL vp_stages_yuv2rgb_simd_level_get(void);
+
+/**
+ *  @fn      vp_stages_yuv2rgb_simd_row(VP_STAGES_RGB_FORMAT)
+ *  @return  Line converter for format at the current level, NULL at VP_STAGES_YUV2RGB_SIMD_NONE
+ */
+vp_stages_yuv2rgb_row_t vp_stages_yuv2rgb_simd_row(VP_STAGES_RGB_FORMAT format);
+
+/**
+ *  @fn      vp_stages_yuv2rgb_simd_row_x2(VP_STAGES_RGB_FORMAT)
+ *  @brief   Same as vp_stages_yuv2rgb_simd_row, each pixel being written twice : dst gets 2 * width pixels (QCIF to QVGA)
+ *  @return  Line converter for format at the current level, NULL at VP_STAGES_YUV2RGB_SIMD_NONE
+ */
+vp_stages_yuv2rgb_row_t vp_stages_yuv2rgb_simd_row_x2(VP_STAGES_RGB_FORMAT format);
+
+/**
+ *  @fn      vp_stages_yuv2rgb_simd_flushline_565(const uint32_t *, uint16_t *, uint32_t, int32_t, int32_t)
+ *  @brief   Converts a packed YCbCr line of the QCIF to QVGA stretch to RGB-565
+ *  @return  FALSE if no SIMD version is available, nothing is converted then
+ */
+bool_t vp_stages_yuv2rgb_simd_flushline_565(const uint32_t *src, uint16_t *dst, uint32_t width, int32_t even, int32_t odd);
+
+// vp_stages_yuv2rgb
+/** @} */
+
+#endif // ! _VP_STAGES_YUV2RGB_SIMD_INCLUDE_
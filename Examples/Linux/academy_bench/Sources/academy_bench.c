@@ -0,0 +1,573 @@
+/**
+ * @file academy_bench.c
+ * @date 2026/10/18
+ *
+ * Speed of the academy flight directory index (academy_index.c) against a
+ * walk of the directory, and of the parsed FTP listings against scans of the
+ * listing text (academy_get_next_item_with_prefix).
+ *
+ * The flight directory is a synthetic tree of flight_<n> directories holding
+ * media files, 10000 files by default. The files are sparse : their sizes are
+ * known, so that the bytes of each case are checked against the expected total.
+ *
+ * Index cases :
+ *  - ftw_walk           : sum of the file sizes with ftw, as without the index
+ *  - index_open_cold    : academy_index_open without saved index
+ *  - index_save         : academy_index_save of the whole tree
+ *  - index_open_warm    : academy_index_open with the saved index
+ *  - flight_bytes       : academy_index_flight_bytes, per query
+ *  - oldest_flight      : academy_index_oldest_flight, per query
+ *  - update_change      : a downloading flight created and a file removed
+ *  - update_rename      : the downloading flight renamed to flight_
+ *  - remove_oldest      : academy_index_remove_dir of the oldest flight
+ *  - open_offline       : a file created while the index is closed
+ *
+ * Listing cases, on the listing of a flight with as many media files, best
+ * time of the runs :
+ *  - listing_text_lookup / listing_parse_lookup : one prefix lookup, the parse
+ *    being counted in the parsed case
+ *  - listing_text_download / listing_parse_download : the lookups of
+ *    academy_download for a flight (userbox, count of the pictures, then
+ *    each picture)
+ *  - listing_parse_shuffled : listing_parse_download, the listing being in
+ *    a random order
+ *  - listing_next_item  : academy_listing_next_item, per query
+ *
+ * A case giving other bytes, names or counts than expected is "mismatch",
+ * a case which could not run is "failed", and the exit code is not zero.
+ *
+ * Results are written with -o as JSON, one object per line.
+ *
+ * Usage : ./linux_academy_bench [-n files] [-f files per flight] [-q queries] [-r runs] [-d directory] [-o results.json]
+ */
+
+#define _XOPEN_SOURCE 600  // nftw
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <VP_Os/vp_os_malloc.h>
+
+#include <ardrone_tool/Academy/academy_index.h>
+#include <ardrone_tool/Academy/academy_download.h>
+
+#include <bench.h>
+
+#define ACADEMY_BENCH_FILES         10000
+#define ACADEMY_BENCH_FLIGHT_FILES  100
+#define ACADEMY_BENCH_QUERIES       1000000
+#define ACADEMY_BENCH_RUNS          20
+#define ACADEMY_BENCH_PATH_SIZE     512
+#define ACADEMY_BENCH_NAME_SIZE     64
+#define ACADEMY_BENCH_LINE_SIZE     128
+#define ACADEMY_BENCH_FILE_SIZE(f)  (1000 + (f))
+#define ACADEMY_BENCH_NEW_FLIGHT    "flight_20261018_999999"
+#define ACADEMY_BENCH_NEW_SIZE      5000
+#define ACADEMY_BENCH_OFFLINE_SIZE  7
+
+typedef enum _ACADEMY_BENCH_STATUS_ {
+    ACADEMY_BENCH_OK = 0,
+    ACADEMY_BENCH_MISMATCH,     // other bytes, names or counts than expected
+    ACADEMY_BENCH_FAILED        // case could not run
+} ACADEMY_BENCH_STATUS;
+
+static const char *academy_bench_status_names[] = { "ok", "mismatch", "failed" };
+
+static int nb_files = ACADEMY_BENCH_FILES;
+static int flight_files = ACADEMY_BENCH_FLIGHT_FILES;
+static int nb_queries = ACADEMY_BENCH_QUERIES;
+static int nb_runs = ACADEMY_BENCH_RUNS;
+static const char *directory = "/tmp/academy_bench";
+
+static uint64_t walk_bytes;
+
+/********************************************************************
+ * Tree and listing
+ ********************************************************************/
+
+static void academy_bench_flight_name (char *name, int flight)
+{
+    snprintf (name, ACADEMY_BENCH_NAME_SIZE, "flight_20261018_%06d", flight);
+}
+
+static C_RESULT academy_bench_file (const char *path, uint32_t size)
+{
+    int fd = open (path, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    C_RESULT res = C_OK;
+
+    if (0 > fd)
+        return C_FAIL;
+    if (0 != ftruncate (fd, size))
+        res = C_FAIL;
+    close (fd);
+    return res;
+}
+
+static int academy_bench_remove_path (const char *path, const struct stat *sb, int typeflag, struct FTW *ftwbuf)
+{
+    remove (path);
+    return 0;
+}
+
+static void academy_bench_clean (void)
+{
+    nftw (directory, academy_bench_remove_path, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/* Flights of flight_files files, the last one holding the rest : total bytes, 0 if failed */
+static uint64_t academy_bench_tree (void)
+{
+    char path[ACADEMY_BENCH_PATH_SIZE], name[ACADEMY_BENCH_NAME_SIZE];
+    uint64_t bytes = 0;
+    int file;
+
+    academy_bench_clean ();
+    if (0 != mkdir (directory, 0755))
+        return 0;
+
+    for (file = 0; file < nb_files; file++)
+    {
+        int f = file % flight_files;
+
+        academy_bench_flight_name (name, file / flight_files);
+        snprintf (path, sizeof (path), "%s/%s", directory, name);
+        if (0 == f && 0 != mkdir (path, 0755))
+            return 0;
+
+        snprintf (path, sizeof (path), "%s/%s/picture_%04d.jpg", directory, name, f);
+        if (C_OK != academy_bench_file (path, ACADEMY_BENCH_FILE_SIZE (f)))
+            return 0;
+        bytes += ACADEMY_BENCH_FILE_SIZE (f);
+    }
+
+    return bytes;
+}
+
+/* FTP listing of a flight with nb_files pictures and its userbox, like the drone gives it */
+static char *academy_bench_listing (bool_t shuffled)
+{
+    char *list = (char *)vp_os_malloc ((size_t)(nb_files + 1) * ACADEMY_BENCH_LINE_SIZE + 1);
+    char (*lines)[ACADEMY_BENCH_LINE_SIZE];
+    size_t length = 0;
+    int i;
+
+    lines = vp_os_malloc ((size_t)(nb_files + 1) * ACADEMY_BENCH_LINE_SIZE);
+    if (NULL == list || NULL == lines)
+    {
+        vp_os_free (list);
+        vp_os_free (lines);
+        return NULL;
+    }
+
+    for (i = 0; i < nb_files; i++)
+        snprintf (lines[i], ACADEMY_BENCH_LINE_SIZE, "-rw-r--r--    1 0        0            %5d Oct 18 12:00 picture_20261018_120000_%05d.jpg\r\n", ACADEMY_BENCH_FILE_SIZE (i % flight_files), i);
+    snprintf (lines[nb_files], ACADEMY_BENCH_LINE_SIZE, "-rw-r--r--    1 0        0            12345 Oct 18 12:00 userbox_20261018_120000\r\n");
+
+    if (shuffled)
+    {
+        srand (46);
+        for (i = nb_files; i > 0; i--)
+        {
+            char line[ACADEMY_BENCH_LINE_SIZE];
+            int j = rand () % (i + 1);
+            memcpy (line, lines[i], ACADEMY_BENCH_LINE_SIZE);
+            memcpy (lines[i], lines[j], ACADEMY_BENCH_LINE_SIZE);
+            memcpy (lines[j], line, ACADEMY_BENCH_LINE_SIZE);
+        }
+    }
+
+    for (i = 0; i <= nb_files; i++)
+    {
+        strcpy (list + length, lines[i]);
+        length += strlen (lines[i]);
+    }
+
+    vp_os_free (lines);
+    return list;
+}
+
+/********************************************************************
+ * Cases
+ ********************************************************************/
+
+static void academy_bench_report (const char *name, uint64_t ns, int queries, uint64_t bytes, ACADEMY_BENCH_STATUS status)
+{
+    bench_result_t *result = bench_report (name, status);
+
+    if (0 < queries)
+    {
+        printf ("%-24s %10.1f ns/query %11s  %s\n", name, (double)ns / queries, "", academy_bench_status_names[status]);
+        bench_set (result, "queries", "%d", queries);
+        bench_set (result, "ns_per_query", "%.2f", (double)ns / queries);
+    }
+    else if (0 < bytes)
+    {
+        printf ("%-24s %10.3f ms %11llu bytes  %s\n", name, ns / 1e6, (unsigned long long)bytes, academy_bench_status_names[status]);
+        bench_set (result, "ms", "%.3f", ns / 1e6);
+    }
+    else
+    {
+        printf ("%-24s %10.3f ms %17s  %s\n", name, ns / 1e6, "", academy_bench_status_names[status]);
+        bench_set (result, "ms", "%.3f", ns / 1e6);
+    }
+
+    if (0 < bytes)
+        bench_set (result, "bytes", "%llu", (unsigned long long)bytes);
+}
+
+static ACADEMY_BENCH_STATUS academy_bench_check (uint64_t bytes, uint64_t expected)
+{
+    if (bytes != expected)
+    {
+        printf ("%llu bytes instead of %llu\n", (unsigned long long)bytes, (unsigned long long)expected);
+        return ACADEMY_BENCH_MISMATCH;
+    }
+    return ACADEMY_BENCH_OK;
+}
+
+static int academy_bench_walk (const char *path, const struct stat *sb, int typeflag)
+{
+    if (FTW_F == typeflag)
+        walk_bytes += sb->st_size;
+    return 0;
+}
+
+static void academy_bench_ftw (uint64_t expected)
+{
+    uint64_t start = bench_now ();
+
+    walk_bytes = 0;
+    ftw (directory, academy_bench_walk, ACADEMY_MAX_FD_FOR_FTW);
+    academy_bench_report ("ftw_walk", bench_now () - start, 0, walk_bytes, academy_bench_check (walk_bytes, expected));
+}
+
+static C_RESULT academy_bench_open (academy_index_t *index, const char *name, uint64_t expected)
+{
+    uint64_t start = bench_now ();
+
+    if (C_OK != academy_index_open (index, directory))
+    {
+        academy_bench_report (name, 0, 0, 0, ACADEMY_BENCH_FAILED);
+        return C_FAIL;
+    }
+
+    academy_bench_report (name, bench_now () - start, 0, academy_index_flight_bytes (index),
+                          academy_bench_check (academy_index_flight_bytes (index), expected));
+    return C_OK;
+}
+
+static void academy_bench_queries (academy_index_t *index)
+{
+    const academy_index_dir_t *oldest = NULL;
+    volatile uint64_t bytes = 0;
+    char name[ACADEMY_BENCH_NAME_SIZE];
+    uint64_t start;
+    int i;
+
+    start = bench_now ();
+    for (i = 0; i < nb_queries; i++)
+        bytes += academy_index_flight_bytes (index);
+    academy_bench_report ("flight_bytes", bench_now () - start, nb_queries, 0, ACADEMY_BENCH_OK);
+
+    start = bench_now ();
+    for (i = 0; i < nb_queries; i++)
+        oldest = academy_index_oldest_flight (index);
+    academy_bench_flight_name (name, 0);
+    academy_bench_report ("oldest_flight", bench_now () - start, nb_queries, 0,
+                          (NULL != oldest && 0 == strcmp (oldest->name, name)) ? ACADEMY_BENCH_OK : ACADEMY_BENCH_MISMATCH);
+}
+
+/* Changes of a download, applied with academy_index_update : expected bytes after them */
+static uint64_t academy_bench_updates (academy_index_t *index, uint64_t expected)
+{
+    char path[ACADEMY_BENCH_PATH_SIZE], new_path[ACADEMY_BENCH_PATH_SIZE], name[ACADEMY_BENCH_NAME_SIZE];
+    ACADEMY_BENCH_STATUS status = ACADEMY_BENCH_OK;
+    const academy_index_dir_t *oldest;
+    uint64_t start;
+    int f;
+
+    // Downloading flight, not counted until renamed, and a picture removed from the last flight
+    snprintf (path, sizeof (path), "%s/downloading_%s", directory, ACADEMY_BENCH_NEW_FLIGHT);
+    if (0 != mkdir (path, 0755))
+        status = ACADEMY_BENCH_FAILED;
+    snprintf (path, sizeof (path), "%s/downloading_%s/picture_0000.jpg", directory, ACADEMY_BENCH_NEW_FLIGHT);
+    if (C_OK != academy_bench_file (path, ACADEMY_BENCH_NEW_SIZE))
+        status = ACADEMY_BENCH_FAILED;
+    academy_bench_flight_name (name, (nb_files - 1) / flight_files);
+    snprintf (path, sizeof (path), "%s/%s/picture_0000.jpg", directory, name);
+    if (0 != unlink (path))
+        status = ACADEMY_BENCH_FAILED;
+    expected -= ACADEMY_BENCH_FILE_SIZE (0);
+
+    start = bench_now ();
+    academy_index_update (index);
+    academy_bench_report ("update_change", bench_now () - start, 0, academy_index_flight_bytes (index),
+                          (ACADEMY_BENCH_OK != status) ? status : academy_bench_check (academy_index_flight_bytes (index), expected));
+
+    snprintf (path, sizeof (path), "%s/downloading_%s", directory, ACADEMY_BENCH_NEW_FLIGHT);
+    snprintf (new_path, sizeof (new_path), "%s/%s", directory, ACADEMY_BENCH_NEW_FLIGHT);
+    status = (0 == rename (path, new_path)) ? ACADEMY_BENCH_OK : ACADEMY_BENCH_FAILED;
+    expected += ACADEMY_BENCH_NEW_SIZE;
+
+    start = bench_now ();
+    academy_index_update (index);
+    academy_bench_report ("update_rename", bench_now () - start, 0, academy_index_flight_bytes (index),
+                          (ACADEMY_BENCH_OK != status) ? status : academy_bench_check (academy_index_flight_bytes (index), expected));
+
+    // Oldest flight removed, as when the flight directory is full
+    academy_bench_flight_name (name, 0);
+    start = bench_now ();
+    status = (C_OK == academy_index_remove_dir (index, name)) ? ACADEMY_BENCH_OK : ACADEMY_BENCH_FAILED;
+    for (f = 0; f < flight_files && f < nb_files; f++)
+        expected -= ACADEMY_BENCH_FILE_SIZE (f);
+    oldest = academy_index_oldest_flight (index);
+    academy_bench_flight_name (name, 1);
+    if (ACADEMY_BENCH_OK == status && (NULL == oldest || 0 != strcmp (oldest->name, (nb_files > flight_files) ? name : ACADEMY_BENCH_NEW_FLIGHT)))
+        status = ACADEMY_BENCH_MISMATCH;
+    academy_bench_report ("remove_oldest", bench_now () - start, 0, academy_index_flight_bytes (index),
+                          (ACADEMY_BENCH_OK != status) ? status : academy_bench_check (academy_index_flight_bytes (index), expected));
+
+    return expected;
+}
+
+/* A file created while the index is closed, seen when opened again */
+static void academy_bench_offline (academy_index_t *index, uint64_t expected)
+{
+    char path[ACADEMY_BENCH_PATH_SIZE];
+
+    academy_index_update (index);
+    academy_index_save (index);
+    academy_index_close (index);
+
+    snprintf (path, sizeof (path), "%s/%s/extra.jpg", directory, ACADEMY_BENCH_NEW_FLIGHT);
+    if (C_OK != academy_bench_file (path, ACADEMY_BENCH_OFFLINE_SIZE))
+    {
+        academy_bench_report ("open_offline", 0, 0, 0, ACADEMY_BENCH_FAILED);
+        return;
+    }
+
+    if (C_OK == academy_bench_open (index, "open_offline", expected + ACADEMY_BENCH_OFFLINE_SIZE))
+        academy_index_close (index);
+}
+
+static void academy_bench_index (void)
+{
+    ACADEMY_BENCH_STATUS status;
+    academy_index_t index;
+    uint64_t expected, start;
+
+    printf ("Creating %d files in %s\n", nb_files, directory);
+    expected = academy_bench_tree ();
+    if (0 == expected)
+    {
+        printf ("Unable to create the tree in %s\n", directory);
+        academy_bench_report ("index", 0, 0, 0, ACADEMY_BENCH_FAILED);
+        return;
+    }
+
+    academy_bench_ftw (expected);
+
+    if (C_OK != academy_bench_open (&index, "index_open_cold", expected))
+        return;
+
+    start = bench_now ();
+    status = (C_OK == academy_index_save (&index)) ? ACADEMY_BENCH_OK : ACADEMY_BENCH_FAILED;
+    academy_bench_report ("index_save", bench_now () - start, 0, 0, status);
+    academy_index_close (&index);
+
+    if (C_OK != academy_bench_open (&index, "index_open_warm", expected))
+        return;
+
+    academy_bench_queries (&index);
+    expected = academy_bench_updates (&index, expected);
+    academy_bench_offline (&index, expected);
+}
+
+/* Lookups of academy_download for a flight, text scans : number of pictures, -1 if no userbox */
+/* Lookups of the listing cases : number of names found, -1 if failed */
+typedef int (*academy_bench_lookups_t) (const char *list);
+
+/* The userbox is the last line : the text scan reads all the listing */
+static int academy_bench_text_lookup (const char *list)
+{
+    char *next = NULL;
+
+    return (NULL != academy_get_next_item_with_prefix (list, &next, "userbox_", FALSE)) ? 1 : 0;
+}
+
+static int academy_bench_parse_lookup (const char *list)
+{
+    academy_listing_t listing;
+    int32_t next = -1;
+    int found;
+
+    if (C_OK != academy_listing_parse (&listing, list))
+        return -1;
+
+    found = (NULL != academy_listing_next_item (&listing, &next, "userbox_", FALSE)) ? 1 : 0;
+    academy_listing_free (&listing);
+    return found;
+}
+
+/* Lookups of academy_download for a flight : the userbox, then the pictures counted, then each picture */
+static int academy_bench_text_download (const char *list)
+{
+    char *next = NULL;
+    int pictures = 0, i;
+
+    if (NULL == academy_get_next_item_with_prefix (list, &next, "userbox_", FALSE))
+        return 0;
+
+    next = NULL;
+    while (academy_get_next_item_with_prefix (list, &next, "picture_", FALSE))
+        pictures++;
+
+    next = NULL;
+    for (i = 0; i < pictures && academy_get_next_item_with_prefix (list, &next, "picture_", FALSE); i++);
+    return 1 + i;
+}
+
+static int academy_bench_parse_download (const char *list)
+{
+    academy_listing_t listing;
+    int32_t next = -1;
+    int pictures = 0, i;
+
+    if (C_OK != academy_listing_parse (&listing, list))
+        return -1;
+
+    if (NULL == academy_listing_next_item (&listing, &next, "userbox_", FALSE))
+    {
+        academy_listing_free (&listing);
+        return 0;
+    }
+
+    next = -1;
+    while (academy_listing_next_item (&listing, &next, "picture_", FALSE))
+        pictures++;
+
+    next = -1;
+    for (i = 0; i < pictures && academy_listing_next_item (&listing, &next, "picture_", FALSE); i++);
+
+    academy_listing_free (&listing);
+    return 1 + i;
+}
+
+/* Best time of nb_runs */
+static void academy_bench_listing_case (const char *name, academy_bench_lookups_t lookups, const char *list, int expected)
+{
+    ACADEMY_BENCH_STATUS status = ACADEMY_BENCH_OK;
+    uint64_t best = 0;
+    int run;
+
+    for (run = 0; run < nb_runs && ACADEMY_BENCH_OK == status; run++)
+    {
+        uint64_t start = bench_now ();
+        int found = lookups (list);
+        uint64_t ns = bench_now () - start;
+
+        if (0 > found)
+            status = ACADEMY_BENCH_FAILED;
+        else if (found != expected)
+            status = ACADEMY_BENCH_MISMATCH;
+        if (0 == run || ns < best)
+            best = ns;
+    }
+
+    academy_bench_report (name, best, 0, 0, status);
+}
+
+static void academy_bench_listing_cases (void)
+{
+    char *list = academy_bench_listing (FALSE);
+    char *shuffled = academy_bench_listing (TRUE);
+    academy_listing_t listing;
+    const char *name = NULL;
+    int32_t item;
+    uint64_t start;
+    int i;
+
+    if (NULL == list || NULL == shuffled || C_OK != academy_listing_parse (&listing, list))
+    {
+        academy_bench_report ("listing", 0, 0, 0, ACADEMY_BENCH_FAILED);
+        vp_os_free (list);
+        vp_os_free (shuffled);
+        return;
+    }
+
+    academy_bench_listing_case ("listing_text_lookup", academy_bench_text_lookup, list, 1);
+    academy_bench_listing_case ("listing_parse_lookup", academy_bench_parse_lookup, list, 1);
+    academy_bench_listing_case ("listing_text_download", academy_bench_text_download, list, 1 + nb_files);
+    academy_bench_listing_case ("listing_parse_download", academy_bench_parse_download, list, 1 + nb_files);
+    academy_bench_listing_case ("listing_parse_shuffled", academy_bench_parse_download, shuffled, 1 + nb_files);
+
+    start = bench_now ();
+    for (i = 0; i < nb_queries; i++)
+    {
+        item = -1;
+        name = academy_listing_next_item (&listing, &item, "userbox_", FALSE);
+    }
+    academy_bench_report ("listing_next_item", bench_now () - start, nb_queries, 0,
+                          (NULL != name) ? ACADEMY_BENCH_OK : ACADEMY_BENCH_MISMATCH);
+
+    academy_listing_free (&listing);
+    vp_os_free (list);
+    vp_os_free (shuffled);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *output = NULL;
+    int option;
+
+    while (-1 != (option = getopt (argc, argv, "n:f:q:r:d:o:")))
+    {
+        switch (option)
+        {
+        case 'n':
+            nb_files = atoi (optarg);
+            break;
+        case 'f':
+            flight_files = atoi (optarg);
+            break;
+        case 'q':
+            nb_queries = atoi (optarg);
+            break;
+        case 'r':
+            nb_runs = atoi (optarg);
+            break;
+        case 'd':
+            directory = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            printf ("Usage : %s [-n files] [-f files per flight] [-q queries] [-r runs] [-d directory] [-o results.json]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (nb_files < 1 || flight_files < 1 || flight_files > 10000 || nb_queries < 1 || nb_runs < 1)
+    {
+        printf ("At least 1 file, 1 to 10000 files per flight, 1 query and 1 run\n");
+        return -1;
+    }
+
+    bench_init (academy_bench_status_names, sizeof (academy_bench_status_names) / sizeof (academy_bench_status_names[0]));
+
+    academy_bench_index ();
+    academy_bench_clean ();
+    academy_bench_listing_cases ();
+
+    if (NULL != output)
+        bench_write (output, "\"academy_bench\":1,\"files\":%d,\"flight_files\":%d", nb_files, flight_files);
+
+    return (bench_nb_results () == bench_count (ACADEMY_BENCH_OK)) ? 0 : 1;
+}
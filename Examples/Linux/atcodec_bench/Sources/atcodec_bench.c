@@ -0,0 +1,450 @@
+/**
+ * @file atcodec_bench.c
+ * @date 2026/10/18
+ *
+ * Throughput of the AT commands receive paths, in commands per second.
+ *
+ * Every case receives the same datagram, like ardrone_tool sends them :
+ * REF + PCMD + COMWDG + CONFIG + PCMD_MAG + CTRL, each datagram being first
+ * copied into the receive buffer as a socket read would do.
+ *
+ * Cases :
+ *  - atcodec_tree          : ATcodec_Commands_Server thread in packets mode, its
+ *                            read callback giving the datagrams, commands of at_msgs.h
+ *  - sim_strtol            : strtol / strcmp parsing of the drone simulator before
+ *                            ATcodec_Parser, which writes into the buffer
+ *  - atcodec_parser        : ATcodec_Parser_Process on each datagram
+ *  - atcodec_parser_stream : ATcodec_Parser_Process on a stream of the datagrams
+ *                            read by chunks of ATCODEC_BENCH_CHUNK_SIZE bytes, the
+ *                            incomplete command of a chunk being kept for the next one
+ *
+ * The strtol and parser cases decode all the arguments, and sum the integers
+ * and the lengths of the strings. A case which does not receive every command,
+ * or which gets another sum than sim_strtol, is reported as "mismatch" and the
+ * exit code is not zero.
+ *
+ * Results are written with -o as JSON, one object per line.
+ *
+ * Usage : ./linux_atcodec_bench [-n datagrams] [-r runs] [-o results.json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <VP_Api/vp_api_thread_helper.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_thread.h>
+
+#include <ATcodec/ATcodec_api.h>
+#include <ATcodec/ATcodec_Parser.h>
+
+#include <bench.h>
+
+#define ATCODEC_BENCH_DATAGRAMS     200000
+#define ATCODEC_BENCH_RUNS          3       // the fastest run is kept
+#define ATCODEC_BENCH_DATAGRAM_SIZE 512
+#define ATCODEC_BENCH_CHUNK_SIZE    1460    // TCP segment payload
+#define ATCODEC_BENCH_STREAM_COPIES 16      // datagrams in the stream buffer, at least a chunk
+
+typedef enum _ATCODEC_BENCH_STATUS_ {
+    ATCODEC_BENCH_OK = 0,
+    ATCODEC_BENCH_MISMATCH      // commands missing, or decoded to other values
+} ATCODEC_BENCH_STATUS;
+
+static const char *atcodec_bench_status_names[] = { "ok", "mismatch" };
+
+static uint32_t nb_datagrams = ATCODEC_BENCH_DATAGRAMS;
+static int nb_runs = ATCODEC_BENCH_RUNS;
+
+static char datagram[ATCODEC_BENCH_DATAGRAM_SIZE];
+static int32_t datagram_size = 0;
+static uint32_t datagram_commands = 0;
+
+// Received by the running case
+static uint32_t received = 0;
+static int64_t checksum = 0;
+
+static void atcodec_bench_datagram (void)
+{
+    int32_t sequence = 1;
+    const char *ptr;
+
+    datagram_size = snprintf (datagram, sizeof (datagram),
+                              "AT*REF=%d,290718208\r"
+                              "AT*PCMD=%d,1,-1085485875,1045220557,0,-1102263091\r"
+                              "AT*COMWDG=%d\r"
+                              "AT*CONFIG=%d,\"general:navdata_demo\",\"TRUE\"\r"
+                              "AT*PCMD_MAG=%d,1,0,1045220557,0,-1102263091,-1082130432,1065353216\r"
+                              "AT*CTRL=%d,5,0\r",
+                              sequence, sequence + 1, sequence + 2, sequence + 3, sequence + 4, sequence + 5);
+
+    for (ptr = datagram, datagram_commands = 0; '\0' != *ptr; ptr++)
+    {
+        datagram_commands += ('\r' == *ptr);
+    }
+}
+
+/********************************************************************
+ * ATcodec tree
+ ********************************************************************/
+
+static uint32_t tree_datagrams = 0;
+
+static AT_CODEC_ERROR_CODE atcodec_bench_tree_received (ATcodec_Memory_t *input, ATcodec_Memory_t *output, AT_CODEC_MSG_ID *id)
+{
+    received++;
+    return AT_CODEC_GENERAL_OK;
+}
+
+static AT_CODEC_ERROR_CODE atcodec_bench_tree_init (void)
+{
+#define ATCODEC_DEFINE_AT_CMD(ID,Str,From,Cb,Prio)                                              \
+    if (-1 == ATcodec_Add_Hashed_Message (Str, From, atcodec_bench_tree_received, Prio))       \
+    {                                                                                           \
+        return AT_CODEC_INIT_ERROR;                                                             \
+    }
+#define ATCODEC_DEFINE_AT_RESU(ID,Str,From,Cb)
+
+#include <at_msgs.h>
+
+#undef ATCODEC_DEFINE_AT_CMD
+#undef ATCODEC_DEFINE_AT_RESU
+
+    return AT_CODEC_INIT_OK;
+}
+
+static AT_CODEC_ERROR_CODE atcodec_bench_tree_shutdown (void) { return AT_CODEC_SHUTDOWN_OK; }
+static AT_CODEC_ERROR_CODE atcodec_bench_tree_enable (void)   { return AT_CODEC_ENABLE_OK; }
+static AT_CODEC_ERROR_CODE atcodec_bench_tree_open (void)     { return AT_CODEC_OPEN_OK; }
+
+// The server thread stops when the connection cannot be closed
+static AT_CODEC_ERROR_CODE atcodec_bench_tree_close (void)    { return AT_CODEC_CLOSE_ERROR; }
+
+static AT_CODEC_ERROR_CODE atcodec_bench_tree_write (uint8_t *buffer, int32_t *len)
+{
+    return AT_CODEC_WRITE_OK;
+}
+
+// Gives the datagrams, then fails so that the server thread closes the connection
+static AT_CODEC_ERROR_CODE atcodec_bench_tree_read (uint8_t *buffer, int32_t *len)
+{
+    if (tree_datagrams >= nb_datagrams || *len < datagram_size)
+    {
+        return AT_CODEC_READ_ERROR;
+    }
+
+    vp_os_memcpy (buffer, datagram, datagram_size);
+    *len = datagram_size;
+    tree_datagrams++;
+
+    return AT_CODEC_READ_OK;
+}
+
+static ATCODEC_BENCH_STATUS atcodec_bench_tree (void)
+{
+    static AT_CODEC_FUNCTIONS_PTRS funcs =
+    {
+        atcodec_bench_tree_init,
+        atcodec_bench_tree_shutdown,
+        atcodec_bench_tree_enable,
+        atcodec_bench_tree_open,
+        atcodec_bench_tree_close,
+        atcodec_bench_tree_write,
+        atcodec_bench_tree_read,
+    };
+    static bool_t initialized = FALSE;
+    THREAD_HANDLE handle;
+
+    if (!initialized)
+    {
+        ATcodec_Init_Library (&funcs);
+        ATcodec_Set_Reading_Mode (ATCODEC_READ_FROM_PACKETS);
+        initialized = TRUE;
+    }
+
+    tree_datagrams = 0;
+    vp_os_thread_create (thread_ATcodec_Commands_Server, (THREAD_PARAMS)NULL, &handle);
+    vp_os_thread_join (handle);
+
+    return ATCODEC_BENCH_OK;
+}
+
+/********************************************************************
+ * Simulator strtol parsing
+ ********************************************************************/
+
+static void atcodec_bench_strtol_command (char *name, char *args)
+{
+    int32_t values[8] = { 0 };
+    int32_t numValues = 0, i;
+    char *ptr = args;
+    char *key, *value;
+
+    checksum += (int32_t)strtol (ptr, &ptr, 10);
+    received++;
+
+    if (0 == strcmp (name, "CONFIG"))
+    {
+        key = strchr (ptr, '"');
+        value = (NULL != key) ? strchr (key + 1, '"') : NULL;
+        if (NULL != value)
+        {
+            *value = '\0';
+            checksum += value - key - 1;
+            key = strchr (value + 1, '"');
+            value = (NULL != key) ? strchr (key + 1, '"') : NULL;
+            if (NULL != value)
+            {
+                *value = '\0';
+                checksum += value - key - 1;
+            }
+        }
+        return;
+    }
+
+    while (',' == *ptr && numValues < 8)
+    {
+        values[numValues++] = (int32_t)strtol (ptr + 1, &ptr, 10);
+    }
+
+    if (0 == strcmp (name, "REF") || 0 == strcmp (name, "PCMD") || 0 == strcmp (name, "PCMD_MAG") ||
+        0 == strcmp (name, "CTRL") || 0 == strcmp (name, "COMWDG"))
+    {
+        for (i = 0; i < numValues; i++)
+        {
+            checksum += values[i];
+        }
+    }
+}
+
+static void atcodec_bench_strtol_process (char *buffer, int32_t size)
+{
+    char *command = buffer;
+    char *end = buffer + size;
+    char *next, *args;
+
+    while (command < end)
+    {
+        next = command;
+        while (next < end && '\r' != *next && '\n' != *next && '\0' != *next)
+        {
+            next++;
+        }
+        *next = '\0';
+
+        if (0 == strncmp (command, "AT*", 3))
+        {
+            args = strchr (command, '=');
+            if (NULL != args)
+            {
+                *args++ = '\0';
+                atcodec_bench_strtol_command (command + 3, args);
+            }
+        }
+        command = next + 1;
+    }
+}
+
+static ATCODEC_BENCH_STATUS atcodec_bench_strtol (void)
+{
+    // One more byte : the last terminator is overwritten by '\0'
+    char buffer[ATCODEC_BENCH_DATAGRAM_SIZE + 1];
+    uint32_t i;
+
+    for (i = 0; i < nb_datagrams; i++)
+    {
+        vp_os_memcpy (buffer, datagram, datagram_size);
+        atcodec_bench_strtol_process (buffer, datagram_size);
+    }
+
+    return ATCODEC_BENCH_OK;
+}
+
+/********************************************************************
+ * ATcodec parser
+ ********************************************************************/
+
+static ATcodec_Parser_t parser;
+
+// All the arguments are decoded, as integers or strings
+static void atcodec_bench_parser_received (const ATcodec_Command_t *command, void *data)
+{
+    const char *str;
+    int32_t i, value, length;
+
+    received++;
+    for (i = 0; i < command->nb_fields; i++)
+    {
+        if (ATCODEC_TRUE == ATcodec_Field_Int (&command->fields[i], &value))
+        {
+            checksum += value;
+        }
+        else if (ATCODEC_TRUE == ATcodec_Field_String (&command->fields[i], &str, &length))
+        {
+            checksum += length;
+        }
+    }
+}
+
+static const ATcodec_Command_Def_t atcodec_bench_commands[] =
+{
+    { "REF",      atcodec_bench_parser_received },
+    { "PCMD",     atcodec_bench_parser_received },
+    { "PCMD_MAG", atcodec_bench_parser_received },
+    { "CTRL",     atcodec_bench_parser_received },
+    { "COMWDG",   atcodec_bench_parser_received },
+    { "CONFIG",   atcodec_bench_parser_received },
+};
+
+static ATCODEC_BENCH_STATUS atcodec_bench_parser (void)
+{
+    char buffer[ATCODEC_BENCH_DATAGRAM_SIZE];
+    uint32_t i;
+
+    for (i = 0; i < nb_datagrams; i++)
+    {
+        vp_os_memcpy (buffer, datagram, datagram_size);
+        if (datagram_size != ATcodec_Parser_Process (&parser, buffer, datagram_size, NULL))
+        {
+            return ATCODEC_BENCH_MISMATCH;
+        }
+    }
+
+    return ATCODEC_BENCH_OK;
+}
+
+static ATCODEC_BENCH_STATUS atcodec_bench_parser_stream (void)
+{
+    static char stream[2 * ATCODEC_BENCH_STREAM_COPIES * ATCODEC_BENCH_DATAGRAM_SIZE];
+    char buffer[ATCODEC_BENCH_CHUNK_SIZE + ATCODEC_BENCH_DATAGRAM_SIZE];
+    int32_t period = ATCODEC_BENCH_STREAM_COPIES * datagram_size;
+    int32_t left = 0, chunk, used, i;
+    uint64_t sent, total = (uint64_t)nb_datagrams * datagram_size;
+
+    // Twice the period, so that a chunk is always contiguous
+    for (i = 0; i < 2 * ATCODEC_BENCH_STREAM_COPIES; i++)
+    {
+        vp_os_memcpy (stream + i * datagram_size, datagram, datagram_size);
+    }
+
+    for (sent = 0; sent < total; sent += chunk)
+    {
+        chunk = (total - sent < ATCODEC_BENCH_CHUNK_SIZE) ? (int32_t)(total - sent) : ATCODEC_BENCH_CHUNK_SIZE;
+        vp_os_memcpy (buffer + left, stream + sent % period, chunk);
+        left += chunk;
+
+        used = ATcodec_Parser_Process (&parser, buffer, left, NULL);
+        left -= used;
+        memmove (buffer, buffer + used, left);
+    }
+
+    return (0 == left) ? ATCODEC_BENCH_OK : ATCODEC_BENCH_MISMATCH;
+}
+
+/********************************************************************
+ * Cases
+ ********************************************************************/
+
+/**
+ * Runs a case nb_runs times, and reports the fastest run
+ * @param expected  Checksum of all the datagrams, 0 if the case does not decode the arguments
+ * @return Checksum of the case
+ */
+static int64_t atcodec_bench_run (const char *name, ATCODEC_BENCH_STATUS (*run) (void), int64_t expected)
+{
+    bench_result_t *result;
+    ATCODEC_BENCH_STATUS status = ATCODEC_BENCH_OK;
+    uint64_t start, ns, best = 0;
+    double seconds, commands_per_second;
+    int i;
+
+    for (i = 0; i < nb_runs && ATCODEC_BENCH_OK == status; i++)
+    {
+        received = 0;
+        checksum = 0;
+
+        start = bench_now ();
+        status = run ();
+        ns = bench_now () - start;
+
+        if (ATCODEC_BENCH_OK == status && (received != nb_datagrams * datagram_commands || (0 != expected && checksum != expected)))
+        {
+            printf ("%s : %u commands received, %u sent, checksum %lld instead of %lld\n", name, received,
+                    nb_datagrams * datagram_commands, (long long)checksum, (long long)expected);
+            status = ATCODEC_BENCH_MISMATCH;
+        }
+        if (0 == i || ns < best)
+        {
+            best = ns;
+        }
+    }
+
+    seconds = best / 1e9;
+    commands_per_second = (0 < best) ? received / seconds : 0.0;
+    printf ("%-24s %8u datagrams %9u commands %8.3f s %7.2f Mcmd/s  %s\n", name, nb_datagrams, received,
+            seconds, commands_per_second / 1e6, atcodec_bench_status_names[status]);
+
+    result = bench_report (name, status);
+    bench_set (result, "datagrams", "%u", nb_datagrams);
+    bench_set (result, "commands", "%u", received);
+    bench_set (result, "seconds", "%.4f", seconds);
+    bench_set (result, "commands_per_second", "%.0f", commands_per_second);
+
+    return checksum;
+}
+
+int main (int argc, char *argv[])
+{
+    const char *output = NULL;
+    int64_t expected;
+    int option;
+
+    while (-1 != (option = getopt (argc, argv, "n:r:o:")))
+    {
+        switch (option)
+        {
+        case 'n':
+            nb_datagrams = (uint32_t)atoi (optarg);
+            break;
+        case 'r':
+            nb_runs = atoi (optarg);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            printf ("Usage : %s [-n datagrams] [-r runs] [-o results.json]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (nb_datagrams < 1 || nb_runs < 1)
+    {
+        printf ("At least one datagram and one run\n");
+        return -1;
+    }
+
+    bench_init (atcodec_bench_status_names, sizeof (atcodec_bench_status_names) / sizeof (atcodec_bench_status_names[0]));
+    atcodec_bench_datagram ();
+    if (ATCODEC_TRUE != ATcodec_Parser_Init (&parser, atcodec_bench_commands,
+                                             sizeof (atcodec_bench_commands) / sizeof (atcodec_bench_commands[0]), NULL))
+    {
+        return 1;
+    }
+
+    atcodec_bench_run ("atcodec_tree", atcodec_bench_tree, 0);
+    expected = atcodec_bench_run ("sim_strtol", atcodec_bench_strtol, 0);
+    atcodec_bench_run ("atcodec_parser", atcodec_bench_parser, expected);
+    atcodec_bench_run ("atcodec_parser_stream", atcodec_bench_parser_stream, expected);
+
+    if (NULL != output)
+    {
+        bench_write (output, "\"atcodec_bench\":1,\"datagrams\":%u,\"datagram_size\":%d,\"datagram_commands\":%u,\"runs\":%d",
+                     nb_datagrams, datagram_size, datagram_commands, nb_runs);
+    }
+
+    return (bench_nb_results () == bench_count (ATCODEC_BENCH_OK)) ? 0 : 1;
+}
@@ -0,0 +1,711 @@
+/**
+ * @file atcodec_fuzz.c
+ * @date 2026/10/18
+ *
+ * Fuzz target of the buffer level AT commands parser (ATcodec_Parser.c),
+ * with the commands of at_msgs.h.
+ *
+ * Each input is copied into an allocation of its exact size, so that an
+ * AddressSanitizer build reports any read past its end, then checked :
+ *  - the returned length ends on a terminator, and only the incomplete
+ *    command at the end of the input is left
+ *  - names and arguments of the commands are within the input, and the
+ *    arguments never contain a terminator
+ *  - the id of a command matches its name, and unknown names match no command
+ *  - ATcodec_Field_Int and ATcodec_Field_Float agree with strtoll and strtod
+ *  - the same commands are received when the input comes as a stream, cut
+ *    in two parts at a random offset
+ *
+ * Without input files, the inputs are random mutations (bytes changed,
+ * inserted or removed, datagrams spliced) of well formed datagrams, from a
+ * fixed seed. The first failing input is written to atcodec_fuzz_<n>.bin,
+ * and files given as arguments are replayed instead of the mutations.
+ *
+ * Built with -DATCODEC_FUZZ_LIBFUZZER, there is no main and the file is a
+ * libFuzzer target, linked with ../../bench/bench.c for the thread table :
+ *   clang -g -fsanitize=fuzzer,address -DATCODEC_FUZZ_LIBFUZZER ...
+ *
+ * Results are written with -o as JSON, one object per line.
+ *
+ * Usage : ./linux_atcodec_fuzz [-n inputs] [-s seed] [-o results.json] [input files]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <VP_Os/vp_os_malloc.h>
+
+#include <ATcodec/ATcodec_Parser.h>
+
+#include <bench.h>
+
+#define ATCODEC_FUZZ_INPUTS         1000000
+#define ATCODEC_FUZZ_SEED           1
+#define ATCODEC_FUZZ_MAX_SIZE       2048
+#define ATCODEC_FUZZ_MAX_MUTATIONS  16
+#define ATCODEC_FUZZ_NAME_SIZE      32
+#define ATCODEC_FUZZ_NUMBER_SIZE    128   // Longer fields are not compared with strtod
+
+typedef enum _ATCODEC_FUZZ_STATUS_ {
+    ATCODEC_FUZZ_OK = 0,
+    ATCODEC_FUZZ_FAILED         // an input broke a check
+} ATCODEC_FUZZ_STATUS;
+
+static const char *atcodec_fuzz_status_names[] = { "ok", "failed" };
+
+// Commands received by one ATcodec_Parser_Process pass
+typedef struct _atcodec_fuzz_pass_ {
+    const char *start;
+    const char *end;
+    uint32_t    hash;           // of the names and arguments, in order
+    uint32_t    commands;
+} atcodec_fuzz_pass_t;
+
+static ATcodec_Command_Def_t defs[ATCODEC_PARSER_MAX_COMMANDS];
+static char def_names[ATCODEC_PARSER_MAX_COMMANDS][ATCODEC_FUZZ_NAME_SIZE];
+static int32_t nb_defs = 0;
+
+static ATcodec_Parser_t parser;
+static atcodec_fuzz_pass_t *pass = NULL;
+static const char *failure = NULL;
+
+// Of the whole inputs, not of their parts
+static uint32_t nb_commands = 0;
+static uint32_t nb_unknown = 0;
+static uint32_t nb_malformed = 0;
+
+// Well formed datagrams, like ardrone_tool sends them
+static const char *atcodec_fuzz_datagrams[] =
+{
+    "AT*REF=1,290718208\rAT*PCMD=2,1,-1085485875,1045220557,0,-1102263091\rAT*COMWDG=3\r",
+    "AT*CONFIG=4,\"general:navdata_demo\",\"TRUE\"\r",
+    "AT*CONFIG_IDS=5,\"a1b2c3d4\",\"e5f6a7b8\",\"c9d0e1f2\"\rAT*CONFIG=6,\"control:altitude_max\",\"3000\"\r",
+    "AT*PCMD_MAG=7,1,0,1045220557,0,-1102263091,-1082130432,1065353216\r",
+    "AT*CTRL=8,4,0\rAT*FTRIM=9\rAT*CALIB=10,0\r",
+    "AT*LED=11,3,1073741824,2\rAT*ANIM=12,3,1000\r",
+    "AT*MISC=13,2,20,2000,3000\rAT*PMODE=14,2\rAT*REF=15,290717696\r",
+};
+
+#define ATCODEC_FUZZ_NB_DATAGRAMS   ((int)(sizeof (atcodec_fuzz_datagrams) / sizeof (atcodec_fuzz_datagrams[0])))
+
+// Bytes which have a meaning for the parser, more likely to find a bug than random ones
+static const char atcodec_fuzz_special[] = "\r\n\0,\"=*AT+-.eE0123456789";
+
+/********************************************************************
+ * Checks
+ ********************************************************************/
+
+static void atcodec_fuzz_fail (const char *what)
+{
+    if (NULL == failure)
+    {
+        failure = what;
+    }
+}
+
+static bool_t atcodec_fuzz_is_end (char c)
+{
+    return ('\0' == c || '\n' == c || '\r' == c) ? TRUE : FALSE;
+}
+
+static uint32_t atcodec_fuzz_hash (uint32_t hash, const void *data, int32_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    while (size--)
+    {
+        hash = (hash ^ *bytes++) * 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * Field_Int against strtoll : a sign, then 1 to 10 digits, from -2^31 to 2^32-1
+ */
+static void atcodec_fuzz_check_int (const ATcodec_Field_t *field)
+{
+    char number[ATCODEC_FUZZ_NUMBER_SIZE];
+    const char *digits = number;
+    int32_t value = 0;
+    bool_t expected = TRUE;
+    ATCODEC_RET res = ATcodec_Field_Int (field, &value);
+    long long reference = 0;
+
+    if (field->length > 11)
+    {
+        expected = FALSE;
+    }
+    else
+    {
+        vp_os_memcpy (number, field->start, field->length);
+        number[field->length] = '\0';
+        if ('-' == *digits || '+' == *digits)
+        {
+            digits++;
+        }
+        if ('\0' == *digits || 10 < strlen (digits) || strspn (digits, "0123456789") != strlen (digits))
+        {
+            expected = FALSE;
+        }
+        else
+        {
+            reference = strtoll (number, NULL, 10);
+            expected = (-2147483648LL <= reference && reference <= 4294967295LL) ? TRUE : FALSE;
+        }
+    }
+
+    if ((ATCODEC_TRUE == res) != expected)
+    {
+        atcodec_fuzz_fail ("ATcodec_Field_Int and strtoll do not accept the same integers");
+    }
+    else if (ATCODEC_TRUE == res && value != (int32_t)(uint32_t)reference)
+    {
+        atcodec_fuzz_fail ("ATcodec_Field_Int value differs from strtoll");
+    }
+}
+
+/**
+ * Field_Float against strtod, on the fields made of number characters only :
+ * strtod also reads "inf", "nan", hexadecimal floats and leading spaces.
+ * Both are rounded to float32_t, a difference of one unit in the last place is allowed.
+ */
+static void atcodec_fuzz_check_float (const ATcodec_Field_t *field)
+{
+    char number[ATCODEC_FUZZ_NUMBER_SIZE];
+    char *end;
+    float32_t value = 0.0f, reference;
+    ATCODEC_RET res = ATcodec_Field_Float (field, &value);
+    bool_t expected;
+
+    if (field->length >= ATCODEC_FUZZ_NUMBER_SIZE)
+    {
+        return;
+    }
+
+    vp_os_memcpy (number, field->start, field->length);
+    number[field->length] = '\0';
+    if (strspn (number, "0123456789+-.eE") != (size_t)field->length)
+    {
+        if (ATCODEC_TRUE == res)
+        {
+            atcodec_fuzz_fail ("ATcodec_Field_Float accepts a character which is not part of a number");
+        }
+        return;
+    }
+
+    reference = (float32_t)strtod (number, &end);
+    expected = (0 < field->length && '\0' == *end) ? TRUE : FALSE;
+
+    if ((ATCODEC_TRUE == res) != expected)
+    {
+        atcodec_fuzz_fail ("ATcodec_Field_Float and strtod do not accept the same numbers");
+    }
+    else if (ATCODEC_TRUE == res && value != reference && nextafterf (reference, value) != value)
+    {
+        atcodec_fuzz_fail ("ATcodec_Field_Float value differs from strtod");
+    }
+}
+
+static void atcodec_fuzz_check_field (const ATcodec_Field_t *field)
+{
+    const char *str;
+    int32_t length, i, bits;
+    float32_t value;
+
+    if (field->length < 0 || field->start < pass->start || field->start + field->length > pass->end)
+    {
+        atcodec_fuzz_fail ("argument out of the input");
+        return;
+    }
+    for (i = 0; i < field->length; i++)
+    {
+        if (atcodec_fuzz_is_end (field->start[i]))
+        {
+            atcodec_fuzz_fail ("argument with a terminator");
+            return;
+        }
+    }
+
+    atcodec_fuzz_check_int (field);
+    atcodec_fuzz_check_float (field);
+
+    if ((ATCODEC_TRUE == ATcodec_Field_Int (field, &bits)) != (ATCODEC_TRUE == ATcodec_Field_Float_Bits (field, &value)) ||
+        (ATCODEC_TRUE == ATcodec_Field_Int (field, &bits) && 0 != memcmp (&bits, &value, sizeof (value))))
+    {
+        atcodec_fuzz_fail ("ATcodec_Field_Float_Bits differs from ATcodec_Field_Int");
+    }
+
+    if (ATCODEC_TRUE == ATcodec_Field_String (field, &str, &length) &&
+        (2 > field->length || str != field->start + 1 || length != field->length - 2 ||
+         '"' != field->start[0] || '"' != field->start[field->length - 1]))
+    {
+        atcodec_fuzz_fail ("ATcodec_Field_String does not give the string between the quotes");
+    }
+}
+
+static void atcodec_fuzz_received (const ATcodec_Command_t *command, void *data)
+{
+    int32_t i;
+
+    pass->commands++;
+
+    if (command->name_length < 0 || command->name < pass->start + 3 || command->name + command->name_length > pass->end ||
+        0 != strncmp (command->name - 3, "AT*", 3))
+    {
+        atcodec_fuzz_fail ("command name out of the input");
+        return;
+    }
+    for (i = 0; i < command->name_length; i++)
+    {
+        if (atcodec_fuzz_is_end (command->name[i]) || '=' == command->name[i])
+        {
+            atcodec_fuzz_fail ("command name with a terminator or '='");
+            return;
+        }
+    }
+
+    if (0 <= command->id)
+    {
+        if (command->id >= nb_defs || (int32_t)strlen (defs[command->id].name) != command->name_length ||
+            0 != strncmp (defs[command->id].name, command->name, command->name_length))
+        {
+            atcodec_fuzz_fail ("command id does not match its name");
+        }
+    }
+    else
+    {
+        for (i = 0; i < nb_defs; i++)
+        {
+            if ((int32_t)strlen (defs[i].name) == command->name_length && 0 == strncmp (defs[i].name, command->name, command->name_length))
+            {
+                atcodec_fuzz_fail ("defined command received as unknown");
+            }
+        }
+    }
+
+    if (command->nb_fields < 0 || command->nb_fields > ATCODEC_PARSER_MAX_FIELDS)
+    {
+        atcodec_fuzz_fail ("wrong number of arguments");
+        return;
+    }
+
+    pass->hash = atcodec_fuzz_hash (pass->hash, &command->id, sizeof (command->id));
+    pass->hash = atcodec_fuzz_hash (pass->hash, command->name, command->name_length);
+    for (i = 0; i < command->nb_fields; i++)
+    {
+        atcodec_fuzz_check_field (&command->fields[i]);
+        pass->hash = atcodec_fuzz_hash (pass->hash, &command->fields[i].length, sizeof (command->fields[i].length));
+        pass->hash = atcodec_fuzz_hash (pass->hash, command->fields[i].start, command->fields[i].length);
+    }
+}
+
+/**
+ * Parses size bytes of data copied into an exact size allocation
+ * @return Number of bytes used, -1 if the checks of the returned length fail
+ */
+static int32_t atcodec_fuzz_process (atcodec_fuzz_pass_t *current, const char *data, int32_t size)
+{
+    char *input = vp_os_malloc (0 < size ? size : 1);
+    int32_t used, i;
+
+    vp_os_memcpy (input, data, size);
+    current->start = input;
+    current->end = input + size;
+    pass = current;
+
+    used = ATcodec_Parser_Process (&parser, input, size, NULL);
+
+    if (used < 0 || used > size || (0 < used && !atcodec_fuzz_is_end (input[used - 1])))
+    {
+        atcodec_fuzz_fail ("returned length does not end on a terminator");
+        used = -1;
+    }
+    else
+    {
+        for (i = used; i < size; i++)
+        {
+            if (atcodec_fuzz_is_end (input[i]))
+            {
+                atcodec_fuzz_fail ("complete command left after the returned length");
+                used = -1;
+                break;
+            }
+        }
+    }
+
+    pass = NULL;
+    vp_os_free (input);
+
+    return used;
+}
+
+/**
+ * Checks one input, then the same input as a stream cut at offset cut
+ */
+static C_RESULT atcodec_fuzz_one (const char *data, int32_t size, int32_t cut)
+{
+    atcodec_fuzz_pass_t whole, parts;
+    uint32_t malformed[3], unknown;
+    int32_t used, first, second;
+
+    vp_os_memset (&whole, 0, sizeof (whole));
+    vp_os_memset (&parts, 0, sizeof (parts));
+    failure = NULL;
+
+    malformed[0] = parser.nb_malformed;
+    unknown = parser.nb_unknown;
+    used = atcodec_fuzz_process (&whole, data, size);
+    malformed[1] = parser.nb_malformed;
+
+    nb_commands += whole.commands;
+    nb_unknown += parser.nb_unknown - unknown;
+    nb_malformed += malformed[1] - malformed[0];
+
+    if (0 <= used && 0 <= cut && cut <= size)
+    {
+        // The bytes which are not used by the first part start the second one
+        first = atcodec_fuzz_process (&parts, data, cut);
+        second = (0 <= first) ? atcodec_fuzz_process (&parts, data + first, size - first) : -1;
+        malformed[2] = parser.nb_malformed;
+
+        if (0 <= second && (first + second != used || parts.commands != whole.commands || parts.hash != whole.hash ||
+                            malformed[2] - malformed[1] != malformed[1] - malformed[0]))
+        {
+            atcodec_fuzz_fail ("commands received as a stream differ");
+        }
+    }
+
+    return (NULL == failure) ? C_OK : C_FAIL;
+}
+
+static C_RESULT atcodec_fuzz_init (void)
+{
+    const char *str, *equal;
+
+    nb_defs = 0;
+
+#define ATCODEC_DEFINE_AT_CMD(ID,Str,From,Cb,Prio)                                              \
+    str = Str;                                                                                  \
+    equal = strchr (str, '=');                                                                  \
+    if (NULL != equal && 0 == strncmp (str, "AT*", 3) && nb_defs < ATCODEC_PARSER_MAX_COMMANDS &&\
+        equal - str - 3 < ATCODEC_FUZZ_NAME_SIZE)                                               \
+    {                                                                                           \
+        vp_os_memcpy (def_names[nb_defs], str + 3, equal - str - 3);                           \
+        def_names[nb_defs][equal - str - 3] = '\0';                                             \
+        defs[nb_defs].name = def_names[nb_defs];                                                \
+        defs[nb_defs].callback = atcodec_fuzz_received;                                         \
+        nb_defs++;                                                                              \
+    }
+#define ATCODEC_DEFINE_AT_RESU(ID,Str,From,Cb)
+
+#include <at_msgs.h>
+
+#undef ATCODEC_DEFINE_AT_CMD
+#undef ATCODEC_DEFINE_AT_RESU
+
+    if (ATCODEC_TRUE != ATcodec_Parser_Init (&parser, defs, nb_defs, atcodec_fuzz_received))
+    {
+        printf ("Unable to build the parser of the %d commands of at_msgs.h\n", nb_defs);
+        return C_FAIL;
+    }
+
+    return C_OK;
+}
+
+#ifdef ATCODEC_FUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+    static int initialized = 0;
+
+    if (!initialized)
+    {
+        if (C_OK != atcodec_fuzz_init ())
+        {
+            abort ();
+        }
+        initialized = 1;
+    }
+
+    if (size > ATCODEC_FUZZ_MAX_SIZE)
+    {
+        return 0;
+    }
+    if (C_OK != atcodec_fuzz_one ((const char *)data, (int32_t)size, (0 < size) ? (int32_t)(data[0] % (size + 1)) : 0))
+    {
+        printf ("%s\n", failure);
+        abort ();
+    }
+
+    return 0;
+}
+
+#else // ! ATCODEC_FUZZ_LIBFUZZER
+
+/********************************************************************
+ * Standalone driver
+ ********************************************************************/
+
+static uint32_t random_state = ATCODEC_FUZZ_SEED;
+
+static uint32_t atcodec_fuzz_random (uint32_t range)
+{
+    // xorshift32 : the same inputs for a seed, on every system
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return (0 < range) ? random_state % range : 0;
+}
+
+static int32_t atcodec_fuzz_append (char *input, int32_t size, const char *data, int32_t length)
+{
+    if (length > ATCODEC_FUZZ_MAX_SIZE - size)
+    {
+        length = ATCODEC_FUZZ_MAX_SIZE - size;
+    }
+    vp_os_memcpy (input + size, data, length);
+    return size + length;
+}
+
+static int32_t atcodec_fuzz_mutate (char *input)
+{
+    const char *datagram;
+    int32_t size = 0, count, position, length;
+
+    // One to three datagrams, whole or from a random offset
+    count = 1 + atcodec_fuzz_random (3);
+    while (count--)
+    {
+        datagram = atcodec_fuzz_datagrams[atcodec_fuzz_random (ATCODEC_FUZZ_NB_DATAGRAMS)];
+        length = (int32_t)strlen (datagram);
+        position = (0 == atcodec_fuzz_random (4)) ? (int32_t)atcodec_fuzz_random (length) : 0;
+        size = atcodec_fuzz_append (input, size, datagram + position, length - position);
+    }
+
+    count = atcodec_fuzz_random (ATCODEC_FUZZ_MAX_MUTATIONS + 1);
+    while (count-- && 0 < size)
+    {
+        position = atcodec_fuzz_random (size);
+        switch (atcodec_fuzz_random (5))
+        {
+        case 0:
+            input[position] = atcodec_fuzz_special[atcodec_fuzz_random (sizeof (atcodec_fuzz_special) - 1)];
+            break;
+        case 1:
+            input[position] = (char)atcodec_fuzz_random (256);
+            break;
+        case 2:
+            if (size < ATCODEC_FUZZ_MAX_SIZE)
+            {
+                memmove (input + position + 1, input + position, size - position);
+                input[position] = atcodec_fuzz_special[atcodec_fuzz_random (sizeof (atcodec_fuzz_special) - 1)];
+                size++;
+            }
+            break;
+        case 3:
+            length = 1 + atcodec_fuzz_random (size - position);
+            memmove (input + position, input + position + length, size - position - length);
+            size -= length;
+            break;
+        default:
+            // Long numbers and names
+            length = 1 + atcodec_fuzz_random (32);
+            if (length <= ATCODEC_FUZZ_MAX_SIZE - size)
+            {
+                memmove (input + position + length, input + position, size - position);
+                vp_os_memset (input + position, '0' + atcodec_fuzz_random (10), length);
+                size += length;
+            }
+            break;
+        }
+    }
+
+    return size;
+}
+
+static void atcodec_fuzz_save (const char *data, int32_t size, long index)
+{
+    char path[64];
+    FILE *file;
+
+    snprintf (path, sizeof (path), "atcodec_fuzz_%ld.bin", index);
+    file = fopen (path, "wb");
+    if (NULL != file)
+    {
+        fwrite (data, 1, size, file);
+        fclose (file);
+        printf ("Input written to %s\n", path);
+    }
+}
+
+/**
+ * Well formed datagrams have to give only defined commands
+ */
+static C_RESULT atcodec_fuzz_datagrams_check (void)
+{
+    atcodec_fuzz_pass_t check;
+    const char *datagram;
+    uint32_t commands, unknown, malformed;
+    int32_t i, size, terminators;
+
+    for (i = 0; i < ATCODEC_FUZZ_NB_DATAGRAMS; i++)
+    {
+        datagram = atcodec_fuzz_datagrams[i];
+        size = (int32_t)strlen (datagram);
+        for (terminators = 0; '\0' != *datagram; datagram++)
+        {
+            terminators += ('\r' == *datagram);
+        }
+
+        commands = parser.nb_commands;
+        unknown = parser.nb_unknown;
+        malformed = parser.nb_malformed;
+        vp_os_memset (&check, 0, sizeof (check));
+        failure = NULL;
+        if (size != atcodec_fuzz_process (&check, atcodec_fuzz_datagrams[i], size) ||
+            (uint32_t)terminators != parser.nb_commands - commands || unknown != parser.nb_unknown || malformed != parser.nb_malformed ||
+            NULL != failure)
+        {
+            printf ("Datagram %d is not parsed as %d defined commands : %s\n", i, terminators, (NULL != failure) ? failure : "");
+            return C_FAIL;
+        }
+    }
+
+    return C_OK;
+}
+
+static long atcodec_fuzz_replay (int argc, char *argv[], uint64_t *bytes)
+{
+    static char input[ATCODEC_FUZZ_MAX_SIZE];
+    FILE *file;
+    int32_t size, cut;
+    uint32_t commands, unknown, malformed;
+    long inputs = 0;
+    int i;
+
+    for (i = 0; i < argc; i++)
+    {
+        file = fopen (argv[i], "rb");
+        if (NULL == file)
+        {
+            printf ("Unable to read %s\n", argv[i]);
+            return -1;
+        }
+        size = (int32_t)fread (input, 1, sizeof (input), file);
+        fclose (file);
+
+        // Every cut of a replayed input is checked, its commands are counted once
+        commands = nb_commands;
+        unknown = nb_unknown;
+        malformed = nb_malformed;
+        for (cut = 0; cut <= size; cut++)
+        {
+            if (C_OK != atcodec_fuzz_one (input, size, cut))
+            {
+                printf ("%s, cut at %d : %s\n", argv[i], cut, failure);
+                return -1;
+            }
+        }
+        nb_commands = commands + (nb_commands - commands) / (size + 1);
+        nb_unknown = unknown + (nb_unknown - unknown) / (size + 1);
+        nb_malformed = malformed + (nb_malformed - malformed) / (size + 1);
+        *bytes += size;
+        inputs++;
+    }
+
+    return inputs;
+}
+
+int main (int argc, char *argv[])
+{
+    static char input[ATCODEC_FUZZ_MAX_SIZE];
+    const char *output = NULL;
+    ATCODEC_FUZZ_STATUS status = ATCODEC_FUZZ_OK;
+    long nb_inputs = ATCODEC_FUZZ_INPUTS, inputs = 0;
+    uint32_t seed = ATCODEC_FUZZ_SEED;
+    uint64_t bytes = 0, start;
+    bench_result_t *result;
+    double seconds;
+    int32_t size;
+    int option;
+
+    while (-1 != (option = getopt (argc, argv, "n:s:o:")))
+    {
+        switch (option)
+        {
+        case 'n':
+            nb_inputs = atol (optarg);
+            break;
+        case 's':
+            seed = (uint32_t)strtoul (optarg, NULL, 10);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            printf ("Usage : %s [-n inputs] [-s seed] [-o results.json] [input files]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (0 == seed)
+    {
+        printf ("The seed cannot be 0\n");
+        return -1;
+    }
+    random_state = seed;
+    bench_init (atcodec_fuzz_status_names, sizeof (atcodec_fuzz_status_names) / sizeof (atcodec_fuzz_status_names[0]));
+
+    if (C_OK != atcodec_fuzz_init () || C_OK != atcodec_fuzz_datagrams_check ())
+        return 1;
+
+    start = bench_now ();
+
+    if (optind < argc)
+    {
+        inputs = atcodec_fuzz_replay (argc - optind, argv + optind, &bytes);
+        if (0 > inputs)
+        {
+            status = ATCODEC_FUZZ_FAILED;
+            inputs = 0;
+        }
+    }
+    else
+    {
+        for (inputs = 0; inputs < nb_inputs; inputs++)
+        {
+            size = atcodec_fuzz_mutate (input);
+            bytes += size;
+            if (C_OK != atcodec_fuzz_one (input, size, atcodec_fuzz_random (size + 1)))
+            {
+                printf ("Input %ld : %s\n", inputs, failure);
+                atcodec_fuzz_save (input, size, inputs);
+                status = ATCODEC_FUZZ_FAILED;
+                break;
+            }
+        }
+    }
+
+    seconds = (bench_now () - start) / 1e9;
+
+    printf ("%ld inputs, %llu bytes, %u commands (%u unknown), %u malformed lines, %.2f s  %s\n", inputs,
+            (unsigned long long)bytes, nb_commands, nb_unknown, nb_malformed, seconds, atcodec_fuzz_status_names[status]);
+
+    result = bench_report ("atcodec_parser_fuzz", status);
+    bench_set (result, "inputs", "%ld", inputs);
+    bench_set (result, "bytes", "%llu", (unsigned long long)bytes);
+    bench_set (result, "commands", "%u", nb_commands);
+    bench_set (result, "unknown", "%u", nb_unknown);
+    bench_set (result, "malformed", "%u", nb_malformed);
+    bench_set (result, "seconds", "%.3f", seconds);
+
+    if (NULL != output)
+        bench_write (output, "\"atcodec_fuzz\":1,\"seed\":%u,\"commands_defined\":%d", seed, nb_defs);
+
+    return (ATCODEC_FUZZ_OK == status) ? 0 : 1;
+}
+
+#endif // ! ATCODEC_FUZZ_LIBFUZZER
@@ -0,0 +1,228 @@
+/**
+ * @file bench.c
+ * @date 2026/10/18
+ *
+ * Clocks, memory and results shared by the benchmarks of Examples/Linux.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <VP_Api/vp_api_thread_helper.h>
+
+#include <bench.h>
+
+static bench_result_t results[BENCH_MAX_RESULTS];
+static int nb_results = 0;
+
+static const char *const *status_names = NULL;
+static int nb_status = 0;
+
+// FALSE if the kernel can't reset the peak : the peaks are the process one
+static bool_t peak_reset = FALSE;
+
+// ARDrone Tool is linked but not started : no thread
+BEGIN_THREAD_TABLE
+END_THREAD_TABLE
+
+/* Value in kB of a "Name:   value kB" line of /proc/self/status, -1 if missing */
+static long bench_status_kb (const char *name)
+{
+    FILE *file = fopen ("/proc/self/status", "r");
+    char line[128];
+    size_t length = strlen (name);
+    long value = -1;
+
+    if (NULL == file)
+        return -1;
+
+    while (NULL != fgets (line, sizeof (line), file))
+    {
+        if (0 == strncmp (line, name, length) && ':' == line[length])
+        {
+            sscanf (line + length + 1, "%ld", &value);
+            break;
+        }
+    }
+
+    fclose (file);
+    return value;
+}
+
+/* Resets VmHWM to the current resident size (Linux 4.0 and later) */
+static bool_t bench_peak_reset (void)
+{
+    FILE *file = fopen ("/proc/self/clear_refs", "w");
+    bool_t reset;
+
+    if (NULL == file)
+        return FALSE;
+
+    reset = (0 < fputs ("5", file));
+    reset = (0 == fclose (file)) && reset;
+    return reset;
+}
+
+void bench_init (const char *const *names, int count)
+{
+    status_names = names;
+    nb_status = count;
+    nb_results = 0;
+
+    peak_reset = bench_peak_reset ();
+    if (!peak_reset)
+        printf ("Peak memory can't be reset : the peak of each case is the peak of the process\n");
+}
+
+uint64_t bench_now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t bench_cpu_now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+long bench_rss_kb (void)
+{
+    return bench_status_kb ("VmRSS");
+}
+
+long bench_peak_kb (void)
+{
+    struct rusage usage;
+    long peak = bench_status_kb ("VmHWM");
+
+    if (0 > peak)
+    {
+        getrusage (RUSAGE_SELF, &usage);
+        peak = usage.ru_maxrss;
+    }
+
+    if (peak_reset)
+        bench_peak_reset ();
+    return peak;
+}
+
+bench_result_t *bench_report (const char *name, int status)
+{
+    bench_result_t *result;
+
+    if (BENCH_MAX_RESULTS <= nb_results)
+        return NULL;
+
+    result = &results[nb_results++];
+    memset (result, 0, sizeof (bench_result_t));
+    strncpy (result->name, name, sizeof (result->name) - 1);
+    result->status = status;
+    return result;
+}
+
+void bench_set (bench_result_t *result, const char *key, const char *format, ...)
+{
+    bench_field_t *field = NULL;
+    va_list args;
+    int i;
+
+    if (NULL == result)
+        return;
+
+    for (i = 0; i < result->nb_fields && NULL == field; i++)
+    {
+        if (0 == strcmp (result->fields[i].key, key))
+            field = &result->fields[i];
+    }
+
+    if (NULL == field)
+    {
+        if (BENCH_MAX_FIELDS <= result->nb_fields)
+        {
+            printf ("%s : more than %d fields, %s is not written\n", result->name, BENCH_MAX_FIELDS, key);
+            return;
+        }
+        field = &result->fields[result->nb_fields++];
+        strncpy (field->key, key, sizeof (field->key) - 1);
+    }
+
+    va_start (args, format);
+    vsnprintf (field->value, sizeof (field->value), format, args);
+    va_end (args);
+}
+
+const char *bench_get (const bench_result_t *result, const char *key)
+{
+    int i;
+
+    for (i = 0; i < result->nb_fields; i++)
+    {
+        if (0 == strcmp (result->fields[i].key, key))
+            return result->fields[i].value;
+    }
+    return NULL;
+}
+
+const char *bench_status_name (int status)
+{
+    return (0 <= status && status < nb_status) ? status_names[status] : "unknown";
+}
+
+int bench_nb_results (void)
+{
+    return nb_results;
+}
+
+bench_result_t *bench_result (int index)
+{
+    return (0 <= index && index < nb_results) ? &results[index] : NULL;
+}
+
+int bench_count (int status)
+{
+    int i, count = 0;
+
+    for (i = 0; i < nb_results; i++)
+    {
+        if (status == results[i].status)
+            count++;
+    }
+    return count;
+}
+
+C_RESULT bench_write (const char *path, const char *header_format, ...)
+{
+    FILE *file = fopen (path, "w");
+    va_list args;
+    int i, j;
+
+    if (NULL == file)
+    {
+        printf ("Unable to write %s\n", path);
+        return C_FAIL;
+    }
+
+    fputc ('{', file);
+    va_start (args, header_format);
+    vfprintf (file, header_format, args);
+    va_end (args);
+    fprintf (file, ",\"time\":%ld}\n", (long)time (NULL));
+
+    for (i = 0; i < nb_results; i++)
+    {
+        fprintf (file, "{\"name\":\"%s\"", results[i].name);
+        for (j = 0; j < results[i].nb_fields; j++)
+            fprintf (file, ",\"%s\":%s", results[i].fields[j].key, results[i].fields[j].value);
+        fprintf (file, ",\"status\":\"%s\"}\n", bench_status_name (results[i].status));
+    }
+
+    fclose (file);
+    return C_OK;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file bench.h
+ * @date 2026/10/18
+ *
+ * Shared by the benchmarks of Examples/Linux : clocks, memory, and the table
+ * of results with its JSON output.
+ *
+ * A result is a name, a status and fields, which are JSON values kept in the
+ * order they are first set. The results file has a header object, then one
+ * object per result :
+ *   {"name":"...",<fields>,"status":"..."}
+ * Status 0 is "ok", the status names are given to bench_init.
+ *
+ * The benchmarks link ARDrone Tool without starting it : bench.c defines
+ * their empty thread table.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+
+#include <VP_Os/vp_os_types.h>
+
+#define BENCH_MAX_RESULTS   128
+#define BENCH_MAX_FIELDS    16
+#define BENCH_NAME_SIZE     64
+#define BENCH_KEY_SIZE      24
+#define BENCH_VALUE_SIZE    32
+
+typedef struct _bench_field_ {
+    char key[BENCH_KEY_SIZE];
+    char value[BENCH_VALUE_SIZE];   // JSON, quoted by the caller for strings
+} bench_field_t;
+
+typedef struct _bench_result_ {
+    char name[BENCH_NAME_SIZE];
+    int  status;
+    int  nb_fields;
+    bench_field_t fields[BENCH_MAX_FIELDS];
+} bench_result_t;
+
+/* Names of the statuses, status_names[0] being "ok" */
+void bench_init (const char *const *status_names, int nb_status);
+
+/* Monotonic and process CPU clocks, in ns */
+uint64_t bench_now (void);
+uint64_t bench_cpu_now (void);
+
+/* Resident size of the process now, in kB */
+long bench_rss_kb (void);
+
+/*
+ * Peak resident size since the previous call (since bench_init for the first
+ * one), in kB : called once per case, it gives the peak of the case.
+ * Without /proc/self/clear_refs it is the peak of the process.
+ */
+long bench_peak_kb (void);
+
+/* New result without fields, NULL once the table is full */
+bench_result_t *bench_report (const char *name, int status);
+
+/* Sets a field to a JSON value, replacing its previous value */
+void bench_set (bench_result_t *result, const char *key, const char *format, ...) __attribute__ ((format (printf, 3, 4)));
+
+/* Value of a field, NULL if it is not set */
+const char *bench_get (const bench_result_t *result, const char *key);
+
+const char *bench_status_name (int status);
+
+int bench_nb_results (void);
+bench_result_t *bench_result (int index);
+
+/* Number of results with this status */
+int bench_count (int status);
+
+/* Writes the header object (format gives its members) then the results */
+C_RESULT bench_write (const char *path, const char *header_format, ...) __attribute__ ((format (printf, 2, 3)));
+
+#endif // _BENCH_H_
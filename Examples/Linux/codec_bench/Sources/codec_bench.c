@@ -0,0 +1,1042 @@
+/**
+ * @file codec_bench.c
+ * @date 2026/10/18
+ *
+ * Offline benchmark and regression check of the video decoders.
+ *
+ * No bitstream is bundled : a synthetic YUV 4:2:0 sequence (moving gradient,
+ * checkerboard and noise, integer only so that it is the same on every host)
+ * is encoded once per resolution, then each decoder runs on it several times :
+ *  - VLIB UVLC and P264 decoders (video_decode_blockline), at CIF / VGA sizes
+ *  - FFmpeg MPEG4 decoder through the ardrone_tool stage, on PaVE frames
+ *  - FFmpeg H264 decoder on a PaVE capture given with -p (no H264 encoder here)
+ *  - decoder kernels : video_idct_compute, p264_inter_mc_luma / chroma
+ *  - YUV to RGB stage, at each SIMD level the CPU supports, and a byte by byte
+ *    comparison with the scalar converter on full range pictures and widths
+ *    which are not a multiple of the SIMD loops
+ *
+ * For each case : frames per second, ns per 16x16 macroblock, peak RSS during
+ * the case, and a FNV-1a checksum of the decoded pictures (the exact checks
+ * are not timed). The checksum must not change between passes ("unstable"),
+ * between SIMD levels or against a baseline given with -c ("mismatch") :
+ * optimisations must stay bit exact.
+ *
+ * Results are written with -o as JSON, one object per line.
+ *
+ * Usage : ./linux_codec_bench [-q] [-n frames] [-r passes] [-p capture] [-o results.json] [-c baseline.json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Stages/vp_stages_yuv2rgb.h>
+#include <VP_Stages/vp_stages_yuv2rgb_simd.h>
+
+#include <VLIB/video_codec.h>
+#include <VLIB/video_controller.h>
+#include <VLIB/video_picture.h>
+#include <VLIB/video_dct.h>
+#include <VLIB/P264/p264_inter_mc.h>
+
+#include <bench.h>
+
+#ifdef FFMPEG_SUPPORT
+#include <ardrone_tool/Video/video_stage_ffmpeg_decoder.h>
+#include <video_encapsulation.h>
+#endif
+
+#define CODEC_BENCH_FRAMES          30
+#define CODEC_BENCH_PASSES          3
+#define CODEC_BENCH_STREAM_SIZE     (1 << 20)   // largest encoded frame
+#define CODEC_BENCH_FNV_BASIS       0x811C9DC5U
+#define CODEC_BENCH_FNV_PRIME       0x01000193U
+
+typedef enum _CODEC_BENCH_STATUS_ {
+    CODEC_BENCH_OK = 0,
+    CODEC_BENCH_UNSTABLE,       // checksum differs between two passes
+    CODEC_BENCH_MISMATCH,       // checksum differs from the reference (scalar level or baseline)
+    CODEC_BENCH_FAILED          // case could not run
+} CODEC_BENCH_STATUS;
+
+static const char *codec_bench_status_names[] = { "ok", "unstable", "mismatch", "failed" };
+
+// One encoded frame
+typedef struct _codec_bench_frame_ {
+    uint8_t  *data;
+    uint32_t size;
+    bool_t   key_frame;
+} codec_bench_frame_t;
+
+static int nb_frames = CODEC_BENCH_FRAMES;
+static int nb_passes = CODEC_BENCH_PASSES;
+
+// Drone streams : 360p MPEG4 / H264, 720p H264
+static const uint32_t resolutions[][2] = {
+    { 320, 240 },
+    { 640, 368 },
+    { 1280, 720 },
+};
+
+// The VLIB picture layer only describes the CIF and VGA formats
+static const uint32_t vlib_resolutions[][2] = {
+    { 176, 144 },
+    { 320, 240 },
+    { 640, 480 },
+};
+
+static uint32_t codec_bench_fnv1a (uint32_t hash, const uint8_t *data, uint32_t size)
+{
+    while (size--)
+    {
+        hash ^= *data++;
+        hash *= CODEC_BENCH_FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint32_t codec_bench_random (uint32_t *seed)
+{
+    *seed = *seed * 1664525U + 1013904223U;
+    return *seed >> 16;
+}
+
+static uint32_t codec_bench_checksum_picture (uint32_t hash, const vp_api_picture_t *picture)
+{
+    uint32_t i;
+
+    for (i = 0; i < picture->height; i++)
+        hash = codec_bench_fnv1a (hash, picture->y_buf + i * picture->y_line_size, picture->width);
+    for (i = 0; i < picture->height / 2; i++)
+    {
+        hash = codec_bench_fnv1a (hash, picture->cb_buf + i * picture->cb_line_size, picture->width / 2);
+        hash = codec_bench_fnv1a (hash, picture->cr_buf + i * picture->cr_line_size, picture->width / 2);
+    }
+    return hash;
+}
+
+static C_RESULT codec_bench_picture_alloc (vp_api_picture_t *picture, uint32_t width, uint32_t height)
+{
+    uint8_t *buffer = (uint8_t *)vp_os_malloc (width * height * 3 / 2);
+
+    vp_os_memset (picture, 0, sizeof (vp_api_picture_t));
+    if (NULL == buffer)
+        return C_FAIL;
+
+    vp_os_memset (buffer, 0, width * height * 3 / 2);
+    picture->format = PIX_FMT_YUV420P;
+    picture->width = width;
+    picture->height = height;
+    picture->framerate = 15;
+    picture->y_buf = buffer;
+    picture->cb_buf = buffer + width * height;
+    picture->cr_buf = buffer + width * height * 5 / 4;
+    picture->y_line_size = width;
+    picture->cb_line_size = width / 2;
+    picture->cr_line_size = width / 2;
+    picture->complete = 1;
+    picture->blockline = 0;
+    return C_OK;
+}
+
+static void codec_bench_picture_free (vp_api_picture_t *picture)
+{
+    vp_os_free (picture->y_buf);
+    picture->y_buf = picture->cb_buf = picture->cr_buf = NULL;
+}
+
+/**
+ * Frame t of the synthetic sequence : moving gradient and checkerboard, with
+ * some noise so that the encoders do not only code flat blocks.
+ */
+static void codec_bench_source (vp_api_picture_t *picture, uint32_t t)
+{
+    uint32_t seed = 0x1234 + t;
+    uint32_t i, j, value;
+
+    for (j = 0; j < picture->height; j++)
+    {
+        for (i = 0; i < picture->width; i++)
+        {
+            value = ((i + 2 * t) + (j + t)) / 4 & 0x7F;
+            if (((i + 3 * t) >> 4 ^ (j + t) >> 4) & 1)
+                value += 64;
+            value += codec_bench_random (&seed) & 0x0F;
+            picture->y_buf[j * picture->y_line_size + i] = (uint8_t)value;
+        }
+    }
+
+    for (j = 0; j < picture->height / 2; j++)
+    {
+        for (i = 0; i < picture->width / 2; i++)
+        {
+            picture->cb_buf[j * picture->cb_line_size + i] = (uint8_t)(96 + ((i + t) & 0x3F));
+            picture->cr_buf[j * picture->cr_line_size + i] = (uint8_t)(96 + ((j + 2 * t) & 0x3F));
+        }
+    }
+}
+
+/**
+ * Result of a case : frames decoded in ns by all the passes. Cases which are
+ * not timed (ns is 0 : correctness checks, failures) have no fps nor ns/MB.
+ * The memory is the peak resident size during the case.
+ */
+static bench_result_t *codec_bench_report (const char *name, uint32_t width, uint32_t height, uint32_t frames, uint64_t ns, uint32_t checksum, CODEC_BENCH_STATUS status)
+{
+    bench_result_t *result = bench_report (name, status);
+    double macroblocks = (double)(width / 16) * (height / 16) * frames;
+    long peak_kb = bench_peak_kb ();
+
+    bench_set (result, "width", "%u", width);
+    bench_set (result, "height", "%u", height);
+    bench_set (result, "frames", "%u", frames);
+    if (0 < ns)
+    {
+        bench_set (result, "fps", "%.2f", frames * 1e9 / ns);
+        bench_set (result, "ns_per_mb", "%.2f", (0 < macroblocks) ? ns / macroblocks : 0.0);
+        printf ("%-28s %4ux%-4u %9.1f fps %9.1f ns/MB %7ld kB  %08x  %s\n", name, width, height, frames * 1e9 / ns,
+                (0 < macroblocks) ? ns / macroblocks : 0.0, peak_kb, checksum, codec_bench_status_names[status]);
+    }
+    else
+    {
+        printf ("%-28s %4ux%-4u %29s %7ld kB  %08x  %s\n", name, width, height, "",
+                peak_kb, checksum, codec_bench_status_names[status]);
+    }
+    bench_set (result, "peak_kb", "%ld", peak_kb);
+    bench_set (result, "checksum", "\"%08x\"", checksum);
+
+    return result;
+}
+
+static void codec_bench_frames_free (codec_bench_frame_t *frames, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        vp_os_free (frames[i].data);
+        frames[i].data = NULL;
+    }
+}
+
+/********************************************************************
+ * VLIB
+ ********************************************************************/
+
+static C_RESULT codec_bench_vlib_encode (codec_type_t codec, uint32_t width, uint32_t height, codec_bench_frame_t *frames)
+{
+    video_controller_t controller;
+    vp_api_picture_t picture;
+    bool_t got_image;
+    int i;
+
+    vp_os_memset (&controller, 0, sizeof (controller));
+    if (C_OK != codec_bench_picture_alloc (&picture, width, height))
+        return C_FAIL;
+
+    video_codec_open (&controller, codec);
+    video_controller_set_mode (&controller, VIDEO_ENCODE);
+    video_controller_set_format (&controller, width, height);
+
+    for (i = 0; i < nb_frames; i++)
+    {
+        codec_bench_source (&picture, i);
+        picture.complete = 1;
+        got_image = FALSE;
+        video_encode_picture (&controller, &picture, &got_image);
+
+        frames[i].size = controller.in_stream.used;
+        frames[i].key_frame = (0 == i);
+        frames[i].data = (uint8_t *)vp_os_malloc ((frames[i].size + 3) & ~3);
+        if (NULL == frames[i].data || CODEC_BENCH_STREAM_SIZE < frames[i].size)
+        {
+            codec_bench_frames_free (frames, i + 1);
+            video_codec_close (&controller);
+            codec_bench_picture_free (&picture);
+            return C_FAIL;
+        }
+        vp_os_memcpy (frames[i].data, controller.in_stream.bytes, frames[i].size);
+    }
+
+    video_codec_close (&controller);
+    codec_bench_picture_free (&picture);
+    return C_OK;
+}
+
+static void codec_bench_vlib (codec_type_t codec, const char *name, uint32_t width, uint32_t height)
+{
+    codec_bench_frame_t *frames;
+    video_controller_t controller;
+    vp_api_picture_t picture;
+    CODEC_BENCH_STATUS status = CODEC_BENCH_OK;
+    uint32_t *stream, checksum, reference = 0;
+    uint64_t start, ns = 0;
+    bool_t got_image;
+    int pass, i;
+
+    frames = (codec_bench_frame_t *)vp_os_calloc (nb_frames, sizeof (codec_bench_frame_t));
+    stream = (uint32_t *)vp_os_malloc (CODEC_BENCH_STREAM_SIZE);
+    if (NULL == frames || NULL == stream || C_OK != codec_bench_vlib_encode (codec, width, height, frames))
+    {
+        codec_bench_report (name, width, height, 0, 0, 0, CODEC_BENCH_FAILED);
+        vp_os_free (stream);
+        vp_os_free (frames);
+        return;
+    }
+
+    codec_bench_picture_alloc (&picture, width, height);
+    vp_os_memset (&controller, 0, sizeof (controller));
+    video_codec_open (&controller, codec);
+    video_controller_set_mode (&controller, VIDEO_DECODE);
+
+    // The decoder reads the frames from our buffer
+    vp_os_free (controller.in_stream.bytes);
+
+    for (pass = 0; pass < nb_passes; pass++)
+    {
+        checksum = CODEC_BENCH_FNV_BASIS;
+        for (i = 0; i < nb_frames; i++)
+        {
+            vp_os_memcpy (stream, frames[i].data, frames[i].size);
+            controller.in_stream.bytes = stream;
+            controller.in_stream.used = frames[i].size;
+            controller.in_stream.size = frames[i].size;
+            controller.in_stream.index = 0;
+            controller.in_stream.length = 32;
+            controller.in_stream.code = 0;
+            picture.complete = 0;
+            picture.blockline = 0;
+            got_image = FALSE;
+
+            start = bench_now ();
+            video_decode_blockline (&controller, &picture, &got_image);
+            ns += bench_now () - start;
+
+            // A size the picture layer can't describe is decoded at another one
+            if (!got_image || (int32_t)width != controller.width || (int32_t)height != controller.height)
+                status = CODEC_BENCH_FAILED;
+            checksum = codec_bench_checksum_picture (checksum, &picture);
+        }
+
+        if (0 == pass)
+            reference = checksum;
+        else if (reference != checksum && CODEC_BENCH_OK == status)
+            status = CODEC_BENCH_UNSTABLE;
+    }
+
+    controller.in_stream.bytes = NULL;
+    video_codec_close (&controller);
+    codec_bench_picture_free (&picture);
+    codec_bench_frames_free (frames, nb_frames);
+    vp_os_free (frames);
+    vp_os_free (stream);
+
+    codec_bench_report (name, width, height, nb_frames * nb_passes, ns, reference, status);
+}
+
+/********************************************************************
+ * Decoder kernels
+ ********************************************************************/
+
+static void codec_bench_idct (uint32_t width, uint32_t height)
+{
+    int32_t nb_mb = (width / 16) * (height / 16);
+    int32_t nb_coeffs = nb_mb * 6 * MCU_BLOCK_SIZE;
+    int16_t *in, *out;
+    uint32_t seed = 0x5678, checksum = CODEC_BENCH_FNV_BASIS;
+    uint64_t start, ns = 0;
+    int32_t i;
+    int pass, frame;
+
+    in = (int16_t *)vp_os_aligned_malloc (nb_coeffs * sizeof (int16_t), 16);
+    out = (int16_t *)vp_os_aligned_malloc (nb_coeffs * sizeof (int16_t), 16);
+    if (NULL == in || NULL == out)
+    {
+        codec_bench_report ("idct", width, height, 0, 0, 0, CODEC_BENCH_FAILED);
+        vp_os_aligned_free (in);
+        vp_os_aligned_free (out);
+        return;
+    }
+
+    // Dequantized blocks : a DC and a few low frequencies, as in coded macroblocks
+    vp_os_memset (in, 0, nb_coeffs * sizeof (int16_t));
+    for (i = 0; i < nb_coeffs; i += MCU_BLOCK_SIZE)
+    {
+        in[i] = (int16_t)(codec_bench_random (&seed) & 0x7FF) - 0x400;
+        in[i + 1] = (int16_t)(codec_bench_random (&seed) & 0xFF) - 0x80;
+        in[i + 8] = (int16_t)(codec_bench_random (&seed) & 0xFF) - 0x80;
+        in[i + 9] = (int16_t)(codec_bench_random (&seed) & 0x3F) - 0x20;
+    }
+
+    for (pass = 0; pass < nb_passes; pass++)
+    {
+        for (frame = 0; frame < nb_frames; frame++)
+        {
+            start = bench_now ();
+            video_idct_compute (in, out, nb_mb);
+            ns += bench_now () - start;
+        }
+    }
+    checksum = codec_bench_fnv1a (checksum, (const uint8_t *)out, nb_coeffs * sizeof (int16_t));
+
+    vp_os_aligned_free (in);
+    vp_os_aligned_free (out);
+
+    codec_bench_report ("idct", width, height, nb_frames * nb_passes, ns, checksum, CODEC_BENCH_OK);
+}
+
+static void codec_bench_mc (uint32_t width, uint32_t height)
+{
+    vp_api_picture_t reference, picture;
+    CODEC_BENCH_STATUS status = CODEC_BENCH_OK;
+    uint32_t seed, checksum, first = 0;
+    uint64_t start, ns = 0;
+    uint32_t x, y;
+    MV_XY_t mv;
+    int pass, frame;
+
+    if (C_OK != codec_bench_picture_alloc (&reference, width, height) ||
+        C_OK != codec_bench_picture_alloc (&picture, width, height))
+    {
+        codec_bench_report ("p264_mc", width, height, 0, 0, 0, CODEC_BENCH_FAILED);
+        codec_bench_picture_free (&reference);
+        return;
+    }
+    codec_bench_source (&reference, 0);
+
+    for (pass = 0; pass < nb_passes; pass++)
+    {
+        seed = 0x9ABC;
+        checksum = CODEC_BENCH_FNV_BASIS;
+        for (frame = 0; frame < nb_frames; frame++)
+        {
+            start = bench_now ();
+            for (y = 0; y < height; y += 16)
+            {
+                for (x = 0; x < width; x += 16)
+                {
+                    // Integer luma vectors (all the decoder supports), half pel on chroma
+                    mv.x = (int8_t)(codec_bench_random (&seed) & 0x0F) - 8;
+                    mv.y = (int8_t)(codec_bench_random (&seed) & 0x0F) - 8;
+                    p264_inter_mc_luma (INTER_PART_16x16, mv, reference.y_buf, picture.y_buf, x, y, width, height, width);
+                    p264_inter_mc_chroma (INTER_PART_16x16, mv, reference.cb_buf, picture.cb_buf, x / 2, y / 2, width / 2, height / 2, width / 2);
+                    p264_inter_mc_chroma (INTER_PART_16x16, mv, reference.cr_buf, picture.cr_buf, x / 2, y / 2, width / 2, height / 2, width / 2);
+                }
+            }
+            ns += bench_now () - start;
+            checksum = codec_bench_checksum_picture (checksum, &picture);
+        }
+
+        if (0 == pass)
+            first = checksum;
+        else if (first != checksum)
+            status = CODEC_BENCH_UNSTABLE;
+    }
+
+    codec_bench_picture_free (&reference);
+    codec_bench_picture_free (&picture);
+
+    codec_bench_report ("p264_mc", width, height, nb_frames * nb_passes, ns, first, status);
+}
+
+/********************************************************************
+ * YUV to RGB stage
+ ********************************************************************/
+
+static const char *codec_bench_rgb_names[] = { "rgb565", "rgb24", "argb32", "bgr24" };
+static const char *codec_bench_simd_names[] = { "c", "sse2", "ssse3", "avx2" };
+
+static void codec_bench_yuv2rgb (uint32_t width, uint32_t height)
+{
+    vp_stages_yuv2rgb_config_t cfg;
+    vp_api_io_data_t in, out;
+    vp_api_picture_t picture;
+    void *source = &picture;
+    bench_result_t *result;
+    VP_STAGES_RGB_FORMAT format;
+    VP_STAGES_YUV2RGB_SIMD_LEVEL level;
+    uint32_t checksum, scalar = 0;
+    uint64_t start, ns;
+    char name[64];
+    int pass, frame;
+
+    if (C_OK != codec_bench_picture_alloc (&picture, width, height))
+        return;
+    codec_bench_source (&picture, 0);
+
+    for (format = VP_STAGES_RGB_FORMAT_RGB565; format < VP_STAGES_RGB_FORMAT_MARKER_END; format++)
+    {
+        for (level = VP_STAGES_YUV2RGB_SIMD_NONE; level < VP_STAGES_YUV2RGB_SIMD_BEST; level++)
+        {
+            // Level not supported by the CPU
+            if (level != vp_stages_yuv2rgb_simd_level_set (level))
+                continue;
+
+            vp_os_memset (&cfg, 0, sizeof (cfg));
+            vp_os_memset (&in, 0, sizeof (in));
+            vp_os_memset (&out, 0, sizeof (out));
+            cfg.rgb_format = format;
+            cfg.mode = VP_STAGES_YUV2RGB_MODE_NORMAL;
+            in.buffers = source; // the stage reads a vp_api_picture_t
+            in.size = 1;
+            in.status = VP_API_STATUS_PROCESSING;
+            vp_os_mutex_init (&out.lock);
+
+            // The stage chooses its converter when out is initialized
+            vp_stages_yuv2rgb_stage_open (&cfg);
+            ns = 0;
+            for (pass = 0; pass < nb_passes; pass++)
+            {
+                for (frame = 0; frame < nb_frames; frame++)
+                {
+                    start = bench_now ();
+                    vp_stages_yuv2rgb_stage_transform (&cfg, &in, &out);
+                    ns += bench_now () - start;
+                }
+            }
+            checksum = codec_bench_fnv1a (CODEC_BENCH_FNV_BASIS, out.buffers[out.indexBuffer], out.size);
+            vp_stages_yuv2rgb_stage_close (&cfg);
+            vp_os_free (out.buffers);
+            vp_os_free (out.lineSize);
+            vp_os_mutex_destroy (&out.lock);
+
+            snprintf (name, sizeof (name), "yuv2rgb_%s_%s", codec_bench_rgb_names[format], codec_bench_simd_names[level]);
+            result = codec_bench_report (name, width, height, nb_frames * nb_passes, ns, checksum, CODEC_BENCH_OK);
+
+            // The SIMD converters give the same pixels as the scalar ones
+            if (VP_STAGES_YUV2RGB_SIMD_NONE == level)
+                scalar = checksum;
+            else if (scalar != checksum && NULL != result)
+            {
+                result->status = CODEC_BENCH_MISMATCH;
+                printf ("  %s differs from the scalar converter\n", name);
+            }
+        }
+    }
+
+    vp_stages_yuv2rgb_simd_level_set (VP_STAGES_YUV2RGB_SIMD_BEST);
+    codec_bench_picture_free (&picture);
+}
+
+// Widths with a remainder after the 16 and 32 pixel SIMD loops
+static const uint32_t codec_bench_exact_widths[] = { 8, 18, 24, 40, 56, 344 };
+#define CODEC_BENCH_EXACT_HEIGHT    6
+
+/* One conversion by the stage at the current SIMD level, the RGB picture is returned in rgb */
+static C_RESULT codec_bench_yuv2rgb_convert (vp_api_picture_t *picture, VP_STAGES_RGB_FORMAT format, uint8_t **rgb, uint32_t *size)
+{
+    vp_stages_yuv2rgb_config_t cfg;
+    vp_api_io_data_t in, out;
+    void *source = picture;
+
+    vp_os_memset (&cfg, 0, sizeof (cfg));
+    vp_os_memset (&in, 0, sizeof (in));
+    vp_os_memset (&out, 0, sizeof (out));
+    cfg.rgb_format = format;
+    cfg.mode = VP_STAGES_YUV2RGB_MODE_NORMAL;
+    in.buffers = source; // the stage reads a vp_api_picture_t
+    in.size = 1;
+    in.status = VP_API_STATUS_PROCESSING;
+    vp_os_mutex_init (&out.lock);
+
+    vp_stages_yuv2rgb_stage_open (&cfg);
+    vp_stages_yuv2rgb_stage_transform (&cfg, &in, &out);
+
+    *size = out.size;
+    *rgb = (uint8_t *)vp_os_malloc (out.size);
+    if (NULL != *rgb && NULL != out.buffers)
+        vp_os_memcpy (*rgb, out.buffers[out.indexBuffer], out.size);
+
+    vp_stages_yuv2rgb_stage_close (&cfg);
+    vp_os_free (out.buffers);
+    vp_os_free (out.lineSize);
+    vp_os_mutex_destroy (&out.lock);
+
+    return (NULL != *rgb) ? C_OK : C_FAIL;
+}
+
+/**
+ * Bit exactness of the SIMD converters : full range Y, U and V, so that
+ * every component saturates at both ends, and widths which end in the
+ * scalar tail of the SIMD loops. Each byte is compared with the scalar
+ * converter output.
+ */
+static void codec_bench_yuv2rgb_exact (void)
+{
+    VP_STAGES_RGB_FORMAT format;
+    VP_STAGES_YUV2RGB_SIMD_LEVEL level;
+    vp_api_picture_t picture;
+    uint8_t *scalar, *rgb;
+    uint32_t scalar_size, size, seed, offset, i, w;
+    uint32_t checksum[VP_STAGES_YUV2RGB_SIMD_BEST];
+    int32_t first_diff[VP_STAGES_YUV2RGB_SIMD_BEST];
+    bool_t supported[VP_STAGES_YUV2RGB_SIMD_BEST];
+    char name[64];
+
+    for (format = VP_STAGES_RGB_FORMAT_RGB565; format < VP_STAGES_RGB_FORMAT_MARKER_END; format++)
+    {
+        for (level = VP_STAGES_YUV2RGB_SIMD_NONE; level < VP_STAGES_YUV2RGB_SIMD_BEST; level++)
+        {
+            checksum[level] = CODEC_BENCH_FNV_BASIS;
+            first_diff[level] = -1;
+            supported[level] = (level == vp_stages_yuv2rgb_simd_level_set (level));
+        }
+
+        for (w = 0; w < sizeof (codec_bench_exact_widths) / sizeof (codec_bench_exact_widths[0]); w++)
+        {
+            if (C_OK != codec_bench_picture_alloc (&picture, codec_bench_exact_widths[w], CODEC_BENCH_EXACT_HEIGHT))
+                return;
+
+            seed = 0x5678 + w;
+            for (i = 0; i < picture.width * picture.height * 3 / 2; i++)
+                picture.y_buf[i] = (uint8_t)codec_bench_random (&seed);
+
+            vp_stages_yuv2rgb_simd_level_set (VP_STAGES_YUV2RGB_SIMD_NONE);
+            if (C_OK != codec_bench_yuv2rgb_convert (&picture, format, &scalar, &scalar_size))
+            {
+                codec_bench_picture_free (&picture);
+                return;
+            }
+            checksum[VP_STAGES_YUV2RGB_SIMD_NONE] = codec_bench_fnv1a (checksum[VP_STAGES_YUV2RGB_SIMD_NONE], scalar, scalar_size);
+
+            for (level = VP_STAGES_YUV2RGB_SIMD_NONE + 1; level < VP_STAGES_YUV2RGB_SIMD_BEST; level++)
+            {
+                if (!supported[level])
+                    continue;
+
+                vp_stages_yuv2rgb_simd_level_set (level);
+                if (C_OK != codec_bench_yuv2rgb_convert (&picture, format, &rgb, &size))
+                    continue;
+
+                checksum[level] = codec_bench_fnv1a (checksum[level], rgb, size);
+                for (offset = 0; offset < size && offset < scalar_size && rgb[offset] == scalar[offset]; offset++)
+                    ;
+                if ((offset < size || size != scalar_size) && 0 > first_diff[level])
+                {
+                    first_diff[level] = offset;
+                    printf ("  yuv2rgb_exact_%s_%s : %ux%u differs from the scalar converter at byte %u\n",
+                            codec_bench_rgb_names[format], codec_bench_simd_names[level],
+                            picture.width, picture.height, offset);
+                }
+                vp_os_free (rgb);
+            }
+
+            vp_os_free (scalar);
+            codec_bench_picture_free (&picture);
+        }
+
+        for (level = VP_STAGES_YUV2RGB_SIMD_NONE; level < VP_STAGES_YUV2RGB_SIMD_BEST; level++)
+        {
+            if (!supported[level])
+                continue;
+
+            snprintf (name, sizeof (name), "yuv2rgb_exact_%s_%s", codec_bench_rgb_names[format], codec_bench_simd_names[level]);
+            codec_bench_report (name, codec_bench_exact_widths[w - 1], CODEC_BENCH_EXACT_HEIGHT, w, 0, checksum[level],
+                                (0 > first_diff[level]) ? CODEC_BENCH_OK : CODEC_BENCH_MISMATCH);
+        }
+    }
+
+    vp_stages_yuv2rgb_simd_level_set (VP_STAGES_YUV2RGB_SIMD_BEST);
+}
+
+/********************************************************************
+ * FFmpeg
+ ********************************************************************/
+
+#ifdef FFMPEG_SUPPORT
+
+static uint32_t codec_bench_pave_frame_number = 0;
+
+/**
+ * Decodes PaVE frames with the ardrone_tool stage.
+ * The stage removes the PaVE in place : each frame is copied before the call.
+ */
+static void codec_bench_ffmpeg_decode (const char *name, codec_bench_frame_t *frames, int count, uint32_t width, uint32_t height)
+{
+    ffmpeg_stage_decoding_config_t cfg;
+    vp_api_io_data_t in, out;
+    CODEC_BENCH_STATUS status = CODEC_BENCH_OK;
+    parrot_video_encapsulation_t *pave;
+    uint32_t checksum, reference = 0, max_size = 0;
+    uint32_t decoded = 0;
+    uint64_t start, ns = 0;
+    uint8_t *buffer;
+    int pass, i;
+
+    for (i = 0; i < count; i++)
+        max_size = (frames[i].size > max_size) ? frames[i].size : max_size;
+
+    buffer = (uint8_t *)vp_os_malloc (max_size + FF_INPUT_BUFFER_PADDING_SIZE);
+    vp_os_memset (&cfg, 0, sizeof (cfg));
+    cfg.dst_picture.format = PIX_FMT_YUV420P;
+    if (NULL == buffer || C_OK != ffmpeg_stage_decoding_open (&cfg))
+    {
+        codec_bench_report (name, width, height, 0, 0, 0, CODEC_BENCH_FAILED);
+        vp_os_free (buffer);
+        return;
+    }
+
+    vp_os_memset (&in, 0, sizeof (in));
+    vp_os_memset (&out, 0, sizeof (out));
+    in.buffers = &buffer;
+    in.status = VP_API_STATUS_PROCESSING;
+    vp_os_mutex_init (&out.lock);
+
+    for (pass = 0; pass < nb_passes; pass++)
+    {
+        checksum = CODEC_BENCH_FNV_BASIS;
+        for (i = 0; i < count; i++)
+        {
+            // Frame numbers keep increasing, or the stage waits for an I frame
+            vp_os_memcpy (buffer, frames[i].data, frames[i].size);
+            vp_os_memset (buffer + frames[i].size, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+            pave = (parrot_video_encapsulation_t *)buffer;
+            pave->frame_number = codec_bench_pave_frame_number++;
+            in.size = frames[i].size;
+            in.indexBuffer = 0;
+            out.size = 0;
+
+            start = bench_now ();
+            ffmpeg_stage_decoding_transform (&cfg, &in, &out);
+            ns += bench_now () - start;
+
+            if (0 < out.size && NULL != out.buffers)
+            {
+                checksum = codec_bench_fnv1a (checksum, out.buffers[out.indexBuffer], out.size);
+                decoded++;
+            }
+        }
+
+        if (0 == pass)
+            reference = checksum;
+        else if (reference != checksum)
+            status = CODEC_BENCH_UNSTABLE;
+    }
+
+    if (decoded != (uint32_t)(count * nb_passes) && CODEC_BENCH_OK == status)
+        status = CODEC_BENCH_FAILED;
+
+    ffmpeg_stage_decoding_close (&cfg);
+    vp_os_mutex_destroy (&out.lock);
+    vp_os_free (buffer);
+
+    codec_bench_report (name, width, height, decoded, ns, reference, status);
+}
+
+static void codec_bench_pave_init (parrot_video_encapsulation_t *pave, uint8_t codec, uint32_t width, uint32_t height, uint32_t size, bool_t key_frame)
+{
+    vp_os_memset (pave, 0, sizeof (parrot_video_encapsulation_t));
+    pave->signature[0] = 'P';
+    pave->signature[1] = 'a';
+    pave->signature[2] = 'V';
+    pave->signature[3] = 'E';
+    pave->version = PAVE_CURRENT_VERSION;
+    pave->video_codec = codec;
+    pave->header_size = sizeof (parrot_video_encapsulation_t);
+    pave->payload_size = size;
+    pave->encoded_stream_width = width;
+    pave->encoded_stream_height = height;
+    pave->display_width = width;
+    pave->display_height = height;
+    pave->frame_type = key_frame ? FRAME_TYPE_I_FRAME : FRAME_TYPE_P_FRAME;
+    pave->total_chuncks = 1;
+    pave->total_slices = 1;
+}
+
+static C_RESULT codec_bench_mpeg4_encode (uint32_t width, uint32_t height, codec_bench_frame_t *frames)
+{
+    AVCodec *codec;
+    AVCodecContext *context;
+    AVFrame *frame;
+    vp_api_picture_t picture;
+    uint8_t *buffer;
+    int size, i;
+    C_RESULT res = C_OK;
+
+    avcodec_init ();
+    avcodec_register_all ();
+
+    codec = avcodec_find_encoder (CODEC_ID_MPEG4);
+    context = avcodec_alloc_context ();
+    frame = avcodec_alloc_frame ();
+    buffer = (uint8_t *)vp_os_malloc (CODEC_BENCH_STREAM_SIZE);
+    if (NULL == codec || NULL == context || NULL == frame || NULL == buffer ||
+        C_OK != codec_bench_picture_alloc (&picture, width, height))
+    {
+        av_free (context);
+        av_free (frame);
+        vp_os_free (buffer);
+        return C_FAIL;
+    }
+
+    // Same GOP as the drone 360p stream
+    context->width = width;
+    context->height = height;
+    context->pix_fmt = PIX_FMT_YUV420P;
+    context->time_base.num = 1;
+    context->time_base.den = 15;
+    context->gop_size = 15;
+    context->bit_rate = width * height * 4;
+    context->thread_count = 1;
+
+    if (avcodec_open (context, codec) < 0)
+    {
+        av_free (context);
+        av_free (frame);
+        vp_os_free (buffer);
+        codec_bench_picture_free (&picture);
+        return C_FAIL;
+    }
+
+    frame->data[0] = picture.y_buf;
+    frame->data[1] = picture.cb_buf;
+    frame->data[2] = picture.cr_buf;
+    frame->linesize[0] = picture.y_line_size;
+    frame->linesize[1] = picture.cb_line_size;
+    frame->linesize[2] = picture.cr_line_size;
+
+    for (i = 0; i < nb_frames && C_OK == res; i++)
+    {
+        codec_bench_source (&picture, i);
+        frame->pts = i;
+        size = avcodec_encode_video (context, buffer, CODEC_BENCH_STREAM_SIZE, frame);
+        if (size <= 0)
+        {
+            res = C_FAIL;
+            break;
+        }
+
+        frames[i].key_frame = context->coded_frame->key_frame;
+        frames[i].size = sizeof (parrot_video_encapsulation_t) + size;
+        frames[i].data = (uint8_t *)vp_os_malloc (frames[i].size);
+        if (NULL == frames[i].data)
+        {
+            res = C_FAIL;
+            break;
+        }
+
+        codec_bench_pave_init ((parrot_video_encapsulation_t *)frames[i].data, CODEC_MPEG4_VISUAL, width, height, size, frames[i].key_frame);
+        vp_os_memcpy (frames[i].data + sizeof (parrot_video_encapsulation_t), buffer, size);
+    }
+
+    if (C_OK != res)
+        codec_bench_frames_free (frames, nb_frames);
+
+    avcodec_close (context);
+    av_free (context);
+    av_free (frame);
+    vp_os_free (buffer);
+    codec_bench_picture_free (&picture);
+    return res;
+}
+
+static void codec_bench_mpeg4 (uint32_t width, uint32_t height)
+{
+    codec_bench_frame_t *frames = (codec_bench_frame_t *)vp_os_calloc (nb_frames, sizeof (codec_bench_frame_t));
+
+    if (NULL == frames || C_OK != codec_bench_mpeg4_encode (width, height, frames))
+        codec_bench_report ("mpeg4_ffmpeg_decode", width, height, 0, 0, 0, CODEC_BENCH_FAILED);
+    else
+        codec_bench_ffmpeg_decode ("mpeg4_ffmpeg_decode", frames, nb_frames, width, height);
+
+    if (NULL != frames)
+        codec_bench_frames_free (frames, nb_frames);
+    vp_os_free (frames);
+}
+
+/**
+ * Capture of the video socket : PaVE frames one after the other.
+ * Frames of the first stream only, one PaVE per frame (slices merged).
+ */
+static void codec_bench_capture (const char *path)
+{
+    parrot_video_encapsulation_t pave, first;
+    codec_bench_frame_t *frames = NULL, *tmp;
+    FILE *file = fopen (path, "rb");
+    int count = 0, max = 0;
+    const char *name;
+
+    if (NULL == file)
+    {
+        printf ("Unable to open %s\n", path);
+        codec_bench_report ("capture_ffmpeg_decode", 0, 0, 0, 0, 0, CODEC_BENCH_FAILED);
+        return;
+    }
+
+    vp_os_memset (&first, 0, sizeof (first));
+    while (1 == fread (&pave, sizeof (pave), 1, file) && PAVE_CHECK (&pave))
+    {
+        if (0 == count)
+            first = pave;
+
+        if (count == max)
+        {
+            max = (0 == max) ? 64 : max * 2;
+            tmp = (codec_bench_frame_t *)vp_os_realloc (frames, max * sizeof (codec_bench_frame_t));
+            if (NULL == tmp)
+                break;
+            frames = tmp;
+        }
+
+        frames[count].size = pave.header_size + pave.payload_size;
+        frames[count].data = (uint8_t *)vp_os_malloc (frames[count].size);
+        frames[count].key_frame = (FRAME_TYPE_P_FRAME != pave.frame_type);
+        if (NULL == frames[count].data)
+            break;
+
+        vp_os_memcpy (frames[count].data, &pave, sizeof (pave));
+        if (pave.header_size < sizeof (pave) ||
+            1 != fread (frames[count].data + sizeof (pave), frames[count].size - sizeof (pave), 1, file))
+        {
+            vp_os_free (frames[count].data);
+            break;
+        }
+
+        if (pave.stream_id == first.stream_id && pave.video_codec == first.video_codec)
+            count++;
+        else
+            vp_os_free (frames[count].data);
+    }
+    fclose (file);
+
+    name = (CODEC_MPEG4_AVC == first.video_codec) ? "h264_ffmpeg_decode" : "capture_ffmpeg_decode";
+    if (0 == count)
+    {
+        printf ("No PaVE frame in %s\n", path);
+        codec_bench_report (name, 0, 0, 0, 0, 0, CODEC_BENCH_FAILED);
+    }
+    else
+    {
+        codec_bench_ffmpeg_decode (name, frames, count, first.display_width, first.display_height);
+    }
+
+    codec_bench_frames_free (frames, count);
+    vp_os_free (frames);
+}
+
+#endif // FFMPEG_SUPPORT
+
+/********************************************************************
+ * Results
+ ********************************************************************/
+
+/**
+ * Compares the checksums with a file written by -o.
+ * Cases which are not in the baseline are not compared.
+ * @return number of mismatches, -1 if the baseline can't be read
+ */
+static int codec_bench_compare (const char *path)
+{
+    FILE *file = fopen (path, "r");
+    char line[512], name[64];
+    char width[BENCH_VALUE_SIZE], height[BENCH_VALUE_SIZE], checksum[BENCH_VALUE_SIZE];
+    const char *field;
+    bench_result_t *result;
+    int i, mismatches = 0;
+
+    if (NULL == file)
+    {
+        printf ("Unable to read %s\n", path);
+        return -1;
+    }
+
+    while (NULL != fgets (line, sizeof (line), file))
+    {
+        if (3 != sscanf (line, "{\"name\":\"%63[^\"]\",\"width\":%31[0-9],\"height\":%31[0-9]", name, width, height) ||
+            NULL == (field = strstr (line, "\"checksum\":")) ||
+            1 != sscanf (field + strlen ("\"checksum\":"), "%31[^,}]", checksum))
+            continue;
+
+        for (i = 0; NULL != (result = bench_result (i)); i++)
+        {
+            if (0 == strcmp (result->name, name) && CODEC_BENCH_FAILED != result->status &&
+                0 == strcmp (bench_get (result, "width"), width) && 0 == strcmp (bench_get (result, "height"), height) &&
+                0 != strcmp (bench_get (result, "checksum"), checksum))
+            {
+                printf ("%s %sx%s : checksum %s, baseline %s\n", name, width, height, bench_get (result, "checksum"), checksum);
+                result->status = CODEC_BENCH_MISMATCH;
+                mismatches++;
+            }
+        }
+    }
+
+    fclose (file);
+    return mismatches;
+}
+
+int main (int argc, char *argv[])
+{
+    const char *output = NULL, *baseline = NULL, *capture = NULL;
+    int nb_resolutions = sizeof (resolutions) / sizeof (resolutions[0]);
+    int option, i, failures;
+
+    while (-1 != (option = getopt (argc, argv, "qn:r:p:o:c:")))
+    {
+        switch (option)
+        {
+        case 'q':
+            nb_resolutions = 1;
+            break;
+        case 'n':
+            nb_frames = atoi (optarg);
+            break;
+        case 'r':
+            nb_passes = atoi (optarg);
+            break;
+        case 'p':
+            capture = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'c':
+            baseline = optarg;
+            break;
+        default:
+            printf ("Usage : %s [-q] [-n frames] [-r passes] [-p capture] [-o results.json] [-c baseline.json]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (nb_frames < 1 || nb_passes < 1)
+    {
+        printf ("At least one frame and one pass\n");
+        return -1;
+    }
+
+    bench_init (codec_bench_status_names, sizeof (codec_bench_status_names) / sizeof (codec_bench_status_names[0]));
+    printf ("%-28s %-9s %13s %15s %10s  %-8s  %s\n", "case", "size", "fps", "ns/MB", "case peak", "checksum", "status");
+
+    for (i = 0; i < nb_resolutions; i++)
+    {
+        codec_bench_vlib (UVLC_CODEC, "uvlc_decode", vlib_resolutions[i][0], vlib_resolutions[i][1]);
+        codec_bench_vlib (P264_CODEC, "p264_decode", vlib_resolutions[i][0], vlib_resolutions[i][1]);
+#ifdef FFMPEG_SUPPORT
+        codec_bench_mpeg4 (resolutions[i][0], resolutions[i][1]);
+#endif
+        codec_bench_idct (resolutions[i][0], resolutions[i][1]);
+        codec_bench_mc (resolutions[i][0], resolutions[i][1]);
+        codec_bench_yuv2rgb (resolutions[i][0], resolutions[i][1]);
+    }
+    codec_bench_yuv2rgb_exact ();
+
+#ifdef FFMPEG_SUPPORT
+    if (NULL != capture)
+        codec_bench_capture (capture);
+#else
+    if (NULL != capture)
+        printf ("Built without FFMPEG_SUPPORT : %s is not decoded\n", capture);
+#endif
+
+    failures = (NULL != baseline && 0 > codec_bench_compare (baseline)) ? 1 : 0;
+
+    if (NULL != output)
+        bench_write (output, "\"codec_bench\":1,\"frames\":%d,\"passes\":%d", nb_frames, nb_passes);
+
+    failures += bench_nb_results () - bench_count (CODEC_BENCH_OK);
+
+    return (0 == failures) ? 0 : 1;
+}
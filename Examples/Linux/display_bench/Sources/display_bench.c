@@ -0,0 +1,249 @@
+/**
+ * @file display_bench.c
+ * @date 2026/10/18
+ *
+ * Frame to present latency and CPU load of a video output stage, see
+ * display_bench.h.
+ *
+ * A moving YUV-4:2:0p test picture is drawn before each frame, out of the
+ * measurement, then given to the stage transform at the frame rate. The
+ * latency of a frame is the time spent in the transform : upload of the
+ * picture, drawing and present. CPU load is the user and system time of the
+ * whole process, SDL threads included, over the wall clock time. A first
+ * picture, which makes the window, is displayed before the measurement.
+ *
+ * For each run : frames, mean, median, 99th percentile and max latency, CPU
+ * load, and the frames which missed their deadline (latency longer than the
+ * frame period). A stage error makes the run "failed", and the exit code is
+ * not zero.
+ *
+ * Without a display, SDL_VIDEODRIVER=dummy runs the stages without drawing.
+ *
+ * Results are written with -o as JSON, one object per line.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <VP_Api/vp_api_picture.h>
+#include <VP_Os/vp_os_malloc.h>
+
+#include <bench.h>
+
+#include "display_bench.h"
+
+#define DISPLAY_BENCH_WIDTH         1280
+#define DISPLAY_BENCH_HEIGHT        720
+#define DISPLAY_BENCH_FPS           30
+#define DISPLAY_BENCH_SECONDS       10
+#define DISPLAY_BENCH_MAX_FRAMES    (120 * 600)
+
+typedef enum _DISPLAY_BENCH_STATUS_ {
+    DISPLAY_BENCH_OK = 0,
+    DISPLAY_BENCH_FAILED        // stage error, or run could not start
+} DISPLAY_BENCH_STATUS;
+
+static const char *display_bench_status_names[] = { "ok", "failed" };
+
+typedef struct _display_bench_result_ {
+    uint32_t frames;
+    uint32_t late;              // latency longer than the frame period
+    double   mean_us;
+    double   median_us;
+    double   p99_us;
+    double   max_us;
+    double   cpu;               // percent of one CPU
+    DISPLAY_BENCH_STATUS status;
+} display_bench_result_t;
+
+static uint32_t width = DISPLAY_BENCH_WIDTH;
+static uint32_t height = DISPLAY_BENCH_HEIGHT;
+static uint32_t fps = DISPLAY_BENCH_FPS;
+static uint32_t seconds = DISPLAY_BENCH_SECONDS;
+static bool_t vsync = FALSE;
+
+static int display_bench_compare (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Diagonal bars moving by 4 pixels per frame, and a chroma ramp */
+static void display_bench_draw (vp_api_picture_t *picture, uint32_t frame)
+{
+    uint32_t x, y;
+
+    for (y = 0; y < picture->height; y++)
+    {
+        uint8_t *line = picture->y_buf + y * picture->y_line_size;
+        for (x = 0; x < picture->width; x++)
+            line[x] = (uint8_t)((x + y + 4 * frame) & 0xFF);
+    }
+    for (y = 0; y < picture->height / 2; y++)
+    {
+        vp_os_memset (picture->cb_buf + y * picture->cb_line_size, (uint8_t)(y + frame), picture->width / 2);
+        vp_os_memset (picture->cr_buf + y * picture->cr_line_size, (uint8_t)(255 - y), picture->width / 2);
+    }
+}
+
+static void display_bench_run (display_bench_stage_t *stage, display_bench_result_t *result)
+{
+    vp_api_picture_t picture;
+    vp_api_io_data_t in, out;
+    uint64_t *latencies, period, next, start, cpu, sum = 0;
+    uint32_t frames = fps * seconds, i;
+    struct timespec ts;
+    C_RESULT warmup;
+
+    vp_os_memset (result, 0, sizeof (*result));
+    result->status = DISPLAY_BENCH_FAILED;
+
+    latencies = (uint64_t *)vp_os_malloc (frames * sizeof (uint64_t));
+    if (NULL == latencies)
+        return;
+    if (C_OK != vp_api_picture_alloc (&picture, width, height, PIX_FMT_YUV420P))
+    {
+        vp_os_free (latencies);
+        return;
+    }
+
+    stage->setup (stage->cfg, width, height, vsync);
+    if (VP_FAILED (stage->funcs->open (stage->cfg)))
+    {
+        printf ("Unable to open the %s stage\n", stage->name);
+        vp_api_picture_free (&picture);
+        vp_os_free (latencies);
+        return;
+    }
+
+    vp_os_memset (&in, 0, sizeof (in));
+    vp_os_memset (&out, 0, sizeof (out));
+    vp_os_mutex_init (&out.lock);
+    in.status = VP_API_STATUS_PROCESSING;
+    in.numBuffers = 1;
+    in.buffers = (uint8_t **)&picture;
+    in.size = 1;
+    out.status = VP_API_STATUS_INIT;
+
+    // Window, overlay or textures are made with the first picture : not measured
+    display_bench_draw (&picture, 0);
+    warmup = stage->funcs->transform (stage->cfg, &in, &out);
+
+    period = 1000000000ULL / fps;
+    start = bench_now ();
+    cpu = bench_cpu_now ();
+    next = start;
+
+    for (i = 0; i < frames && VP_SUCCEEDED (warmup); i++)
+    {
+        uint64_t begin;
+
+        display_bench_draw (&picture, i);
+
+        next += period;
+        begin = bench_now ();
+        if (VP_FAILED (stage->funcs->transform (stage->cfg, &in, &out)) || VP_API_STATUS_ENDED == out.status)
+            break;
+        latencies[i] = bench_now () - begin;
+        sum += latencies[i];
+        if (latencies[i] > period)
+            result->late++;
+
+        ts.tv_sec = next / 1000000000ULL;
+        ts.tv_nsec = next % 1000000000ULL;
+        clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+
+    result->cpu = 100.0 * (double)(bench_cpu_now () - cpu) / (double)(bench_now () - start);
+    result->frames = i;
+    if (i == frames && VP_SUCCEEDED (warmup))
+        result->status = DISPLAY_BENCH_OK;
+
+    in.status = VP_API_STATUS_ENDED;
+    in.size = 0;
+    stage->funcs->transform (stage->cfg, &in, &out);
+    stage->funcs->close (stage->cfg);
+    vp_os_mutex_destroy (&out.lock);
+
+    if (0 < result->frames)
+    {
+        qsort (latencies, result->frames, sizeof (uint64_t), display_bench_compare);
+        result->mean_us = (double)sum / result->frames / 1000.0;
+        result->median_us = latencies[result->frames / 2] / 1000.0;
+        result->p99_us = latencies[(result->frames * 99) / 100] / 1000.0;
+        result->max_us = latencies[result->frames - 1] / 1000.0;
+    }
+
+    vp_api_picture_free (&picture);
+    vp_os_free (latencies);
+}
+
+static void display_bench_report (display_bench_stage_t *stage, const display_bench_result_t *result)
+{
+    bench_result_t *entry = bench_report (stage->name, result->status);
+
+    printf ("%-8s %ux%u %u fps : %u frames, %u late, latency mean %.1f us median %.1f us p99 %.1f us max %.1f us, cpu %.1f %% : %s\n",
+            stage->name, width, height, fps, result->frames, result->late, result->mean_us, result->median_us,
+            result->p99_us, result->max_us, result->cpu, display_bench_status_names[result->status]);
+
+    bench_set (entry, "frames", "%u", result->frames);
+    bench_set (entry, "late", "%u", result->late);
+    bench_set (entry, "mean_us", "%.1f", result->mean_us);
+    bench_set (entry, "median_us", "%.1f", result->median_us);
+    bench_set (entry, "p99_us", "%.1f", result->p99_us);
+    bench_set (entry, "max_us", "%.1f", result->max_us);
+    bench_set (entry, "cpu", "%.1f", result->cpu);
+}
+
+int display_bench_main (int argc, char *argv[], display_bench_stage_t *stage)
+{
+    display_bench_result_t result;
+    const char *output = NULL;
+    int option;
+
+    while (-1 != (option = getopt (argc, argv, "W:H:f:t:vo:")))
+    {
+        switch (option)
+        {
+        case 'W':
+            width = (uint32_t)atoi (optarg);
+            break;
+        case 'H':
+            height = (uint32_t)atoi (optarg);
+            break;
+        case 'f':
+            fps = (uint32_t)atoi (optarg);
+            break;
+        case 't':
+            seconds = (uint32_t)atoi (optarg);
+            break;
+        case 'v':
+            vsync = TRUE;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            printf ("Usage : %s [-W width] [-H height] [-f fps] [-t seconds] [-v] [-o results.json]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (width < 16 || height < 16 || (width & 1) || (height & 1) || fps < 1 || fps > 120 || seconds < 1 || fps * seconds > DISPLAY_BENCH_MAX_FRAMES)
+    {
+        printf ("Even sizes of at least 16, 1 to 120 fps, at most %d frames\n", DISPLAY_BENCH_MAX_FRAMES);
+        return -1;
+    }
+
+    bench_init (display_bench_status_names, sizeof (display_bench_status_names) / sizeof (display_bench_status_names[0]));
+    display_bench_run (stage, &result);
+    display_bench_report (stage, &result);
+
+    if (NULL != output)
+        bench_write (output, "\"display_bench\":1,\"width\":%u,\"height\":%u,\"fps\":%u,\"vsync\":%d", width, height, fps, vsync ? 1 : 0);
+
+    return (DISPLAY_BENCH_OK == result.status) ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file display_bench.h
+ * @date 2026/10/18
+ *
+ * Frame to present latency and CPU load of a video output stage.
+ *
+ * The same measurement runs for each output stage, each one being linked in
+ * its own program since vp_stages_o_sdl (SDL 1.2) and vp_stages_o_texture
+ * (SDL2) can not be linked together :
+ *  - linux_display_bench_sdl     : vp_stages_o_sdl, the picture is copied into an SDL_Overlay
+ *  - linux_display_bench_texture : vp_stages_o_texture, the picture is uploaded into a texture
+ */
+
+#ifndef _DISPLAY_BENCH_H_
+#define _DISPLAY_BENCH_H_
+
+#include <VP_Api/vp_api.h>
+
+typedef struct _display_bench_stage_ {
+    const char *name;
+    void *cfg;
+    const vp_api_stage_funcs_t *funcs;
+    // Fills cfg for pictures of width x height, before the stage is opened
+    void (*setup) (void *cfg, uint32_t width, uint32_t height, bool_t vsync);
+} display_bench_stage_t;
+
+/* Runs the measurement with the options of the command line, returns the exit code */
+int display_bench_main (int argc, char *argv[], display_bench_stage_t *stage);
+
+#endif // _DISPLAY_BENCH_H_
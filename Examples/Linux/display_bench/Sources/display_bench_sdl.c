@@ -0,0 +1,41 @@
+/**
+ * @file display_bench_sdl.c
+ * @date 2026/10/18
+ *
+ * display_bench of vp_stages_o_sdl.
+ *
+ * Usage : ./linux_display_bench_sdl [-W width] [-H height] [-f fps] [-t seconds] [-o results.json]
+ */
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Stages/vp_stages_o_sdl.h>
+
+#include "display_bench.h"
+
+static vp_stages_output_sdl_config_t sdl_config;
+
+static void display_bench_sdl_setup (void *cfg, uint32_t width, uint32_t height, bool_t vsync)
+{
+    vp_stages_output_sdl_config_t *config = (vp_stages_output_sdl_config_t *)cfg;
+
+    // SDL 1.2 overlays have no vsync setting
+    (void)vsync;
+
+    vp_os_memset (config, 0, sizeof (*config));
+    config->width = width;
+    config->height = height;
+    config->bpp = 16;
+    config->window_width = width;
+    config->window_height = height;
+    config->pic_width = width;
+    config->pic_height = height;
+    config->y_size = width * height;
+    config->c_size = (width * height) >> 2;
+}
+
+int main (int argc, char *argv[])
+{
+    display_bench_stage_t stage = { "sdl", &sdl_config, &vp_stages_output_sdl_funcs, display_bench_sdl_setup };
+
+    return display_bench_main (argc, argv, &stage);
+}
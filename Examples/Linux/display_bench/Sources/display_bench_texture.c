@@ -0,0 +1,33 @@
+/**
+ * @file display_bench_texture.c
+ * @date 2026/10/18
+ *
+ * display_bench of vp_stages_o_texture.
+ *
+ * Usage : ./linux_display_bench_texture [-W width] [-H height] [-f fps] [-t seconds] [-v] [-o results.json]
+ */
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Stages/vp_stages_o_texture.h>
+
+#include "display_bench.h"
+
+static vp_stages_output_texture_config_t texture_config;
+
+static void display_bench_texture_setup (void *cfg, uint32_t width, uint32_t height, bool_t vsync)
+{
+    vp_stages_output_texture_config_t *config = (vp_stages_output_texture_config_t *)cfg;
+
+    vp_os_memset (config, 0, sizeof (*config));
+    config->window_width = width;
+    config->window_height = height;
+    config->title = "display_bench";
+    config->vsync = vsync;
+}
+
+int main (int argc, char *argv[])
+{
+    display_bench_stage_t stage = { "texture", &texture_config, &vp_stages_output_texture_funcs, display_bench_texture_setup };
+
+    return display_bench_main (argc, argv, &stage);
+}
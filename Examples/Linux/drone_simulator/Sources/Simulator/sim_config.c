@@ -0,0 +1,221 @@
+/**
+ * @file sim_config.c
+ * @date 2026/10/18
+ */
+
+#include "sim_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+#include <ardrone_api.h>
+#include <iniparser3.0b/src/iniparser.h>
+#include <config_keys.h>
+
+/* List of all configuration keys, built from config_keys.h */
+typedef struct _sim_config_key_ {
+    const char *key;
+    int32_t iniType;
+} sim_config_key_t;
+
+#undef ARDRONE_CONFIG_KEY_IMM_a10
+#undef ARDRONE_CONFIG_KEY_STR_a10
+#undef ARDRONE_CONFIG_KEY_REF_a10
+#define ARDRONE_CONFIG_KEY_IMM_a10(KEY, NAME, INI_TYPE, C_TYPE, C_TYPE_PTR, RW, RW_CUSTOM, DEFAULT, CALLBACK, CATEGORY) { KEY ":" #NAME, INI_TYPE },
+#define ARDRONE_CONFIG_KEY_STR_a10(KEY, NAME, INI_TYPE, C_TYPE, C_TYPE_PTR, RW, RW_CUSTOM, DEFAULT, CALLBACK, CATEGORY) { KEY ":" #NAME, INI_TYPE },
+#define ARDRONE_CONFIG_KEY_REF_a10(KEY, NAME, INI_TYPE, C_TYPE, C_TYPE_PTR, RW, RW_CUSTOM, DEFAULT, CALLBACK, CATEGORY) { KEY ":" #NAME, INI_TYPE },
+
+static const sim_config_key_t sim_config_keys[] = {
+#include <config_keys.h>
+    { NULL, 0 }
+};
+
+/* Values that differ from the per-type zero default */
+static const char *sim_config_defaults[][2] = {
+    { "general:num_version_config", "1" },
+    { "general:num_version_mb",     "33" },
+    { "general:drone_serial",       "XXXXXXXXXXXX" },
+    { "general:ardrone_name",       "My ARDrone" },
+    { "general:com_watchdog",       "2" },
+    { "general:video_enable",       "TRUE" },
+    { "general:vision_enable",      "TRUE" },
+    { "general:vbat_min",           "9000" },
+    { "control:euler_angle_max",    "2.0943952e-01" },
+    { "control:altitude_max",       "3000" },
+    { "control:altitude_min",       "50" },
+    { "control:control_vz_max",     "7.0000000e+02" },
+    { "control:control_yaw",        "1.7453293e+00" },
+    { "control:flight_anim",        "0,0" },
+    { "network:ssid_single_player", "ardrone2_sim" },
+    { "network:ssid_multi_player",  "ardrone2_sim" },
+    { "network:owner_mac",          "00:00:00:00:00:00" },
+    { "video:camif_fps",            "30" },
+    { "video:codec_fps",            "30" },
+    { "video:video_codec",          "129" },
+    { "video:max_bitrate",          "4000" },
+    { "detect:enemy_colors",        "1" },
+    { "custom:application_id",      "00000000" },
+    { "custom:profile_id",          "00000000" },
+    { "custom:session_id",          "00000000" },
+    { NULL, NULL }
+};
+
+static const char *sim_config_type_default (int32_t iniType)
+{
+    switch (iniType)
+    {
+    case INI_BOOLEAN:
+        return "FALSE";
+    case INI_FLOAT:
+    case INI_DOUBLE:
+        return "0.0000000e+00";
+    case INI_VECTOR:
+        return "{ 0.0000000e+00 0.0000000e+00 0.0000000e+00 }";
+    case INI_VECTOR21:
+        return "{ 0.0000000e+00 0.0000000e+00 }";
+    case INI_MATRIX:
+        return "{ 1.0000000e+00 0.0000000e+00 0.0000000e+00 0.0000000e+00 1.0000000e+00 0.0000000e+00 0.0000000e+00 0.0000000e+00 1.0000000e+00 }";
+    case INI_STRING:
+        return "";
+    case INI_INT:
+    default:
+        return "0";
+    }
+}
+
+static sim_config_entry_t *sim_config_find (const sim_config_t *cfg, const char *key)
+{
+    int32_t i;
+    for (i = 0; i < cfg->numEntries; i++)
+    {
+        if (0 == strcmp (cfg->entries[i].key, key))
+        {
+            return (sim_config_entry_t *)&cfg->entries[i];
+        }
+    }
+    return NULL;
+}
+
+C_RESULT sim_config_init (sim_config_t *cfg, const char *version)
+{
+    int32_t i;
+    vp_os_memset (cfg, 0x0, sizeof (sim_config_t));
+
+    for (i = 0; NULL != sim_config_keys[i].key; i++)
+    {
+        sim_config_set (cfg, sim_config_keys[i].key, sim_config_type_default (sim_config_keys[i].iniType));
+    }
+    for (i = 0; NULL != sim_config_defaults[i][0]; i++)
+    {
+        sim_config_set (cfg, sim_config_defaults[i][0], sim_config_defaults[i][1]);
+    }
+    sim_config_set (cfg, "general:num_version_soft", version);
+    return C_OK;
+}
+
+C_RESULT sim_config_load (sim_config_t *cfg, const char *fileName)
+{
+    char line[SIM_CONFIG_KEY_SIZE + SIM_CONFIG_VALUE_SIZE + 8];
+    FILE *cfgFile = fopen (fileName, "r");
+    if (NULL == cfgFile)
+    {
+        PRINT ("Unable to open config file %s\n", fileName);
+        return C_FAIL;
+    }
+
+    while (NULL != fgets (line, sizeof (line), cfgFile))
+    {
+        char *key = line;
+        char *value = strchr (line, '=');
+        char *end;
+        if (NULL == value || '#' == line[0] || ';' == line[0])
+        {
+            continue;
+        }
+        *value++ = '\0';
+
+        // Trim both sides of key and value
+        while (' ' == *key || '\t' == *key) key++;
+        end = key + strlen (key);
+        while (end > key && (' ' == end[-1] || '\t' == end[-1])) *--end = '\0';
+        while (' ' == *value || '\t' == *value) value++;
+        end = value + strlen (value);
+        while (end > value && ('\n' == end[-1] || '\r' == end[-1] || ' ' == end[-1])) *--end = '\0';
+
+        if ('\0' != *key)
+        {
+            sim_config_set (cfg, key, value);
+        }
+    }
+    fclose (cfgFile);
+    return C_OK;
+}
+
+C_RESULT sim_config_set (sim_config_t *cfg, const char *key, const char *value)
+{
+    sim_config_entry_t *entry = sim_config_find (cfg, key);
+    if (NULL == entry)
+    {
+        if (SIM_CONFIG_MAX_KEYS <= cfg->numEntries || SIM_CONFIG_KEY_SIZE <= strlen (key))
+        {
+            return C_FAIL;
+        }
+        entry = &cfg->entries[cfg->numEntries++];
+        vp_os_memcpy (entry->key, key, strlen (key) + 1);
+    }
+    strncpy (entry->value, value, SIM_CONFIG_VALUE_SIZE - 1);
+    entry->value[SIM_CONFIG_VALUE_SIZE - 1] = '\0';
+    return C_OK;
+}
+
+const char *sim_config_get (const sim_config_t *cfg, const char *key)
+{
+    sim_config_entry_t *entry = sim_config_find (cfg, key);
+    return (NULL != entry) ? entry->value : NULL;
+}
+
+int32_t sim_config_get_int (const sim_config_t *cfg, const char *key, int32_t defaultValue)
+{
+    const char *value = sim_config_get (cfg, key);
+    return (NULL != value && '\0' != *value) ? (int32_t)strtol (value, NULL, 0) : defaultValue;
+}
+
+float32_t sim_config_get_float (const sim_config_t *cfg, const char *key, float32_t defaultValue)
+{
+    const char *value = sim_config_get (cfg, key);
+    return (NULL != value && '\0' != *value) ? (float32_t)strtod (value, NULL) : defaultValue;
+}
+
+bool_t sim_config_get_bool (const sim_config_t *cfg, const char *key, bool_t defaultValue)
+{
+    const char *value = sim_config_get (cfg, key);
+    if (NULL == value || '\0' == *value)
+    {
+        return defaultValue;
+    }
+    return (0 == strcasecmp (value, "TRUE") || 0 != atoi (value)) ? TRUE : FALSE;
+}
+
+int32_t sim_config_dump (const sim_config_t *cfg, char *buffer, int32_t size)
+{
+    int32_t i;
+    int32_t used = 0;
+    for (i = 0; i < cfg->numEntries; i++)
+    {
+        int32_t len = snprintf (&buffer[used], size - used, "%s = %s\n", cfg->entries[i].key, cfg->entries[i].value);
+        if (len >= size - used)
+        {
+            return -1;
+        }
+        used += len;
+    }
+    if (used >= size)
+    {
+        return -1;
+    }
+    buffer[used++] = '\0';
+    return used;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file sim_config.h
+ * @date 2026/10/18
+ *
+ * Configuration store of a simulated AR.Drone.
+ * Keys are the "category:name" strings of config_keys.h, values are kept
+ * as the strings the drone would send back on the control socket.
+ */
+
+#ifndef _SIM_CONFIG_H_
+#define _SIM_CONFIG_H_ (1)
+
+#include <VP_Os/vp_os_types.h>
+
+#define SIM_CONFIG_MAX_KEYS     (256)
+#define SIM_CONFIG_KEY_SIZE     (64)
+#define SIM_CONFIG_VALUE_SIZE   (128)
+
+typedef struct _sim_config_entry_ {
+    char key[SIM_CONFIG_KEY_SIZE];
+    char value[SIM_CONFIG_VALUE_SIZE];
+} sim_config_entry_t;
+
+typedef struct _sim_config_ {
+    int32_t numEntries;
+    sim_config_entry_t entries[SIM_CONFIG_MAX_KEYS];
+} sim_config_t;
+
+/**
+ * Fill the store with all keys known by config_keys.h and sensible defaults.
+ * @param version Software version reported in general:num_version_soft
+ */
+C_RESULT sim_config_init (sim_config_t *cfg, const char *version);
+
+/**
+ * Override values with a "key = value" file (e.g. a dump taken on a real drone).
+ * Unknown keys are added to the store.
+ */
+C_RESULT sim_config_load (sim_config_t *cfg, const char *fileName);
+
+C_RESULT sim_config_set (sim_config_t *cfg, const char *key, const char *value);
+const char *sim_config_get (const sim_config_t *cfg, const char *key);
+int32_t sim_config_get_int (const sim_config_t *cfg, const char *key, int32_t defaultValue);
+float32_t sim_config_get_float (const sim_config_t *cfg, const char *key, float32_t defaultValue);
+bool_t sim_config_get_bool (const sim_config_t *cfg, const char *key, bool_t defaultValue);
+
+/**
+ * Write the configuration as sent by CFG_GET_CONTROL_MODE : "key = value\n" lines
+ * followed by a '\0' terminator.
+ * @return Number of bytes written (terminator included), or -1 if the buffer is too small
+ */
+int32_t sim_config_dump (const sim_config_t *cfg, char *buffer, int32_t size);
+
+#endif // _SIM_CONFIG_H_
@@ -0,0 +1,832 @@
+/**
+ * @file sim_drone.c
+ * @date 2026/10/18
+ */
+
+#include "sim_drone.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+#include <VP_Api/vp_api_thread_helper.h>
+#include <control_states.h>
+
+#define SIM_AT_BUFFER_SIZE      (4096)
+#define SIM_CONFIG_DUMP_SIZE    (SIM_CONFIG_MAX_KEYS * (SIM_CONFIG_KEY_SIZE + SIM_CONFIG_VALUE_SIZE + 4))
+#define SIM_NAVDATA_DEMO_RATE   (15)
+#define SIM_NAVDATA_FULL_RATE   (200)
+#define SIM_LISTEN_BACKLOG      (4)
+
+#define SIM_PRINT(drone, ...)                                     \
+    do {                                                          \
+        if ((drone)->options->verbose)                            \
+        {                                                         \
+            printf ("[SIM %d] ", (drone)->index);                 \
+            printf (__VA_ARGS__);                                 \
+        }                                                         \
+    } while (0)
+
+PROTO_THREAD_ROUTINE (sim_drone_loop, data);
+
+uint32_t sim_get_time_ms (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/*
+ * Sockets
+ */
+
+static int sim_socket_open (const char *ip, int port, int type)
+{
+    struct sockaddr_in addr;
+    int reuse = 1;
+    int s = socket (AF_INET, type, 0);
+    if (0 > s)
+    {
+        return -1;
+    }
+
+    // The AR.Drone tool binds its UDP client sockets on the same ports (INADDR_ANY) :
+    // both sides set SO_REUSEADDR (see ARDRONE_TOOL_IS_SIMULATED_DRONE), the more
+    // specific drone address wins on reception.
+    setsockopt (s, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof (reuse));
+
+    vp_os_memset (&addr, 0x0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons (port);
+    addr.sin_addr.s_addr = inet_addr (ip);
+    if (0 > bind (s, (struct sockaddr *)&addr, sizeof (addr)) ||
+        (SOCK_STREAM == type && 0 > listen (s, SIM_LISTEN_BACKLOG)))
+    {
+        PRINT ("Unable to bind %s:%d (%s)\n", ip, port, strerror (errno));
+        close (s);
+        return -1;
+    }
+    fcntl (s, F_SETFL, fcntl (s, F_GETFL, 0) | O_NONBLOCK);
+    return s;
+}
+
+static void sim_close (int *s)
+{
+    if (0 <= *s)
+    {
+        close (*s);
+        *s = -1;
+    }
+}
+
+static void sim_tcp_close (sim_tcp_client_t *client)
+{
+    sim_close (&client->socket);
+    client->pendingSize = 0;
+    client->pendingIndex = 0;
+}
+
+/**
+ * Send data on a client socket without blocking the drone loop.
+ * @param queue If FALSE, data are dropped while previous data are still pending
+ * @return FALSE if data were dropped
+ */
+static bool_t sim_tcp_send (sim_tcp_client_t *client, const uint8_t *data, uint32_t size, bool_t queue)
+{
+    ssize_t sent = 0;
+    uint32_t remaining = client->pendingSize - client->pendingIndex;
+
+    if (0 > client->socket)
+    {
+        return FALSE;
+    }
+    if (0 < remaining && ! queue)
+    {
+        return FALSE;
+    }
+    if (0 == remaining)
+    {
+        client->pendingSize = 0;
+        client->pendingIndex = 0;
+        sent = send (client->socket, data, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (0 > sent)
+        {
+            if (EAGAIN != errno && EWOULDBLOCK != errno)
+            {
+                sim_tcp_close (client);
+                return FALSE;
+            }
+            sent = 0;
+        }
+    }
+    if ((uint32_t)sent < size)
+    {
+        // Keep the end of the data for the next writable event
+        uint32_t needed = client->pendingSize + size - sent;
+        uint8_t *pending = vp_os_realloc (client->pending, needed);
+        if (NULL == pending)
+        {
+            sim_tcp_close (client);
+            return FALSE;
+        }
+        client->pending = pending;
+        vp_os_memcpy (&client->pending[client->pendingSize], &data[sent], size - sent);
+        client->pendingSize = needed;
+    }
+    return TRUE;
+}
+
+static void sim_tcp_flush (sim_tcp_client_t *client)
+{
+    ssize_t sent;
+    if (0 > client->socket || client->pendingIndex >= client->pendingSize)
+    {
+        return;
+    }
+    sent = send (client->socket, &client->pending[client->pendingIndex], client->pendingSize - client->pendingIndex, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (0 > sent && EAGAIN != errno && EWOULDBLOCK != errno)
+    {
+        sim_tcp_close (client);
+    }
+    else if (0 < sent)
+    {
+        client->pendingIndex += sent;
+    }
+}
+
+/**
+ * Accept a new client. A real drone serves a single client per port : a new
+ * connection replaces the previous one (typical after a WiFi reconnection).
+ * @return TRUE if a client was accepted
+ */
+static bool_t sim_tcp_accept (sim_drone_t *drone, int listenSocket, sim_tcp_client_t *client, bool_t inOutage)
+{
+    int s = accept (listenSocket, NULL, NULL);
+    if (0 > s)
+    {
+        return FALSE;
+    }
+    if (inOutage)
+    {
+        close (s);
+        return FALSE;
+    }
+    sim_tcp_close (client);
+    client->socket = s;
+    drone->stats.connections++;
+    return TRUE;
+}
+
+static void sim_tcp_check_closed (sim_tcp_client_t *client)
+{
+    uint8_t dummy[256];
+    ssize_t bytes = recv (client->socket, dummy, sizeof (dummy), MSG_DONTWAIT);
+    if (0 == bytes || (0 > bytes && EAGAIN != errno && EWOULDBLOCK != errno))
+    {
+        sim_tcp_close (client);
+    }
+}
+
+/*
+ * AT commands
+ */
+
+static void sim_drone_set_config (sim_drone_t *drone, const char *key, const char *value)
+{
+    SIM_PRINT (drone, "CONFIG %s = %s\n", key, value);
+    sim_config_set (&drone->config, key, value);
+
+    if (0 == strcmp (key, "general:navdata_demo"))
+    {
+        if (sim_config_get_bool (&drone->config, key, FALSE))
+        {
+            drone->ardroneState |= ARDRONE_NAVDATA_DEMO_MASK;
+        }
+        else
+        {
+            drone->ardroneState &= ~ARDRONE_NAVDATA_DEMO_MASK;
+        }
+        drone->ardroneState &= ~ARDRONE_NAVDATA_BOOTSTRAP;
+    }
+    else if (0 == strcmp (key, "general:navdata_options"))
+    {
+        drone->navdataOptions = (uint32_t)sim_config_get_int (&drone->config, key, 0);
+    }
+    else if (0 == strcmp (key, "general:video_enable"))
+    {
+        if (sim_config_get_bool (&drone->config, key, TRUE))
+        {
+            drone->ardroneState |= ARDRONE_VIDEO_MASK;
+        }
+        else
+        {
+            drone->ardroneState &= ~ARDRONE_VIDEO_MASK;
+        }
+    }
+    // The drone acknowledges each configuration command with the command mask
+    drone->ardroneState |= ARDRONE_COMMAND_MASK;
+}
+
+static void sim_drone_control_mode (sim_drone_t *drone, int32_t mode)
+{
+    switch (mode)
+    {
+    case CFG_GET_CONTROL_MODE:
+    {
+        char *dump = vp_os_malloc (SIM_CONFIG_DUMP_SIZE);
+        int32_t size = (NULL != dump) ? sim_config_dump (&drone->config, dump, SIM_CONFIG_DUMP_SIZE) : -1;
+        if (0 < size && sim_tcp_send (&drone->control, (uint8_t *)dump, size, TRUE))
+        {
+            drone->stats.configDumps++;
+            drone->ardroneState |= ARDRONE_COMMAND_MASK;
+        }
+        vp_os_free (dump);
+        break;
+    }
+
+    case CUSTOM_CFG_GET_CONTROL_MODE:
+    {
+        // No custom configuration is stored on the simulated drone : empty list
+        uint8_t terminator = 0;
+        if (sim_tcp_send (&drone->control, &terminator, 1, TRUE))
+        {
+            drone->ardroneState |= ARDRONE_COMMAND_MASK;
+        }
+        break;
+    }
+
+    case ACK_CONTROL_MODE:
+        drone->ardroneState &= ~ARDRONE_COMMAND_MASK;
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void sim_drone_ref (sim_drone_t *drone, uint32_t input)
+{
+    uint32_t select = 1 << ARDRONE_UI_BIT_SELECT;
+
+    // Emergency is toggled on each rising edge of the select bit
+    if ((input & select) && ! (drone->lastRefInput & select))
+    {
+        if (drone->ardroneState & ARDRONE_EMERGENCY_MASK)
+        {
+            drone->ardroneState &= ~ARDRONE_EMERGENCY_MASK;
+        }
+        else if (drone->ardroneState & ARDRONE_FLY_MASK)
+        {
+            drone->ardroneState |= ARDRONE_EMERGENCY_MASK;
+        }
+    }
+    drone->lastRefInput = input;
+}
+
+/**
+ * Sequence number, first argument of every command : older commands are ignored
+ */
+static bool_t sim_at_sequence (sim_drone_t *drone, const ATcodec_Command_t *command)
+{
+    int32_t sequence;
+
+    if (1 > command->nb_fields || ATCODEC_TRUE != ATcodec_Field_Int (&command->fields[0], &sequence))
+    {
+        return FALSE;
+    }
+    if (1 != sequence && sequence <= drone->atSequence)
+    {
+        drone->stats.atOutOfSequence++;
+        return FALSE;
+    }
+    drone->atSequence = sequence;
+    drone->stats.atCommands++;
+    return TRUE;
+}
+
+/**
+ * Integer arguments following the sequence number
+ * @return FALSE if there are less than count
+ */
+static bool_t sim_at_ints (const ATcodec_Command_t *command, int32_t *values, int32_t count)
+{
+    int32_t i;
+
+    if (command->nb_fields < 1 + count)
+    {
+        return FALSE;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (ATCODEC_TRUE != ATcodec_Field_Int (&command->fields[1 + i], &values[i]))
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void sim_at_ref (const ATcodec_Command_t *command, void *data)
+{
+    sim_drone_t *drone = (sim_drone_t *)data;
+    int32_t input;
+
+    if (sim_at_sequence (drone, command) && sim_at_ints (command, &input, 1))
+    {
+        sim_drone_ref (drone, (uint32_t)input);
+    }
+}
+
+static void sim_at_pcmd (const ATcodec_Command_t *command, void *data)
+{
+    sim_drone_t *drone = (sim_drone_t *)data;
+    int32_t flag, i;
+    float32_t pcmd[4];
+
+    if (! sim_at_sequence (drone, command) || ! sim_at_ints (command, &flag, 1) || 6 > command->nb_fields)
+    {
+        return;
+    }
+    // roll, pitch, gaz, yaw are sent as the bits of floats
+    for (i = 0; i < 4; i++)
+    {
+        if (ATCODEC_TRUE != ATcodec_Field_Float_Bits (&command->fields[2 + i], &pcmd[i]))
+        {
+            return;
+        }
+    }
+    drone->pcmdEnabled = (flag & 1) ? TRUE : FALSE;
+    vp_os_memcpy (drone->pcmd, pcmd, sizeof (drone->pcmd));
+}
+
+static void sim_at_ctrl (const ATcodec_Command_t *command, void *data)
+{
+    sim_drone_t *drone = (sim_drone_t *)data;
+    int32_t mode;
+
+    if (sim_at_sequence (drone, command) && sim_at_ints (command, &mode, 1))
+    {
+        sim_drone_control_mode (drone, mode);
+    }
+}
+
+static void sim_at_comwdg (const ATcodec_Command_t *command, void *data)
+{
+    sim_drone_t *drone = (sim_drone_t *)data;
+
+    if (sim_at_sequence (drone, command))
+    {
+        drone->ardroneState &= ~ARDRONE_COM_WATCHDOG_MASK;
+    }
+}
+
+/**
+ * Copy a quoted string argument, sim_config_set needs terminated strings
+ */
+static bool_t sim_at_string (const ATcodec_Field_t *field, char *str, int32_t size)
+{
+    const char *start;
+    int32_t length;
+
+    if (ATCODEC_TRUE != ATcodec_Field_String (field, &start, &length) || length >= size)
+    {
+        return FALSE;
+    }
+    vp_os_memcpy (str, start, length);
+    str[length] = '\0';
+    return TRUE;
+}
+
+static void sim_at_config (const ATcodec_Command_t *command, void *data)
+{
+    sim_drone_t *drone = (sim_drone_t *)data;
+    char key[SIM_CONFIG_KEY_SIZE];
+    char value[SIM_CONFIG_VALUE_SIZE];
+
+    if (sim_at_sequence (drone, command) && 3 <= command->nb_fields &&
+        sim_at_string (&command->fields[1], key, sizeof (key)) &&
+        sim_at_string (&command->fields[2], value, sizeof (value)))
+    {
+        sim_drone_set_config (drone, key, value);
+    }
+}
+
+/**
+ * CONFIG_IDS, FTRIM, CALIB, LED, ANIM, PMODE, MISC ... are accepted and ignored
+ */
+static void sim_at_other (const ATcodec_Command_t *command, void *data)
+{
+    sim_at_sequence ((sim_drone_t *)data, command);
+}
+
+static const ATcodec_Command_Def_t sim_at_commands[] = {
+    { "REF",      sim_at_ref },
+    { "PCMD",     sim_at_pcmd },
+    { "PCMD_MAG", sim_at_pcmd },
+    { "CTRL",     sim_at_ctrl },
+    { "COMWDG",   sim_at_comwdg },
+    { "CONFIG",   sim_at_config },
+};
+
+void sim_drone_handle_at (sim_drone_t *drone, const char *buffer, int32_t size)
+{
+    drone->stats.atPackets++;
+    drone->lastAtTime = sim_get_time_ms ();
+
+    ATcodec_Parser_Process (&drone->atParser, buffer, size, drone);
+}
+
+/*
+ * Drone
+ */
+
+C_RESULT sim_drone_open (sim_drone_t *drone)
+{
+    const sim_options_t *options = drone->options;
+
+    drone->atSocket = sim_socket_open (drone->ip, AT_PORT, SOCK_DGRAM);
+    drone->navdataSocket = sim_socket_open (drone->ip, NAVDATA_PORT, SOCK_DGRAM);
+    drone->controlListen = sim_socket_open (drone->ip, CONTROL_PORT, SOCK_STREAM);
+    drone->videoListen = sim_socket_open (drone->ip, VIDEO_PORT, SOCK_STREAM);
+    drone->recorderListen = sim_socket_open (drone->ip, VIDEO_RECORDER_PORT, SOCK_STREAM);
+    drone->ftpListen = sim_socket_open (drone->ip, FTP_PORT, SOCK_STREAM);
+    drone->control.socket = -1;
+    drone->video.socket = -1;
+    drone->recorder.socket = -1;
+    drone->ftpClient = -1;
+    drone->ftpData = -1;
+
+    if (0 > drone->atSocket || 0 > drone->navdataSocket || 0 > drone->controlListen ||
+        0 > drone->videoListen || 0 > drone->recorderListen || 0 > drone->ftpListen)
+    {
+        sim_drone_close (drone);
+        return C_FAIL;
+    }
+
+    vp_os_memcpy (&drone->config, options->config, sizeof (sim_config_t));
+    vp_os_memset (&drone->navdata, 0x0, sizeof (navdata_unpacked_t));
+    vp_os_memset (&drone->stats, 0x0, sizeof (sim_stats_t));
+    drone->navdata.navdata_demo.ctrl_state = CTRL_LANDED << 16;
+    drone->navdata.navdata_demo.vbat_flying_percentage = 100;
+    drone->navdata.navdata_wifi.link_quality = 1;
+    drone->battery = 100.0f;
+    drone->ardroneState = ARDRONE_NAVDATA_BOOTSTRAP | ARDRONE_VIDEO_MASK | ARDRONE_CAMERA_MASK |
+                          ARDRONE_USB_MASK | ARDRONE_PIC_VERSION_MASK | ARDRONE_COM_WATCHDOG_MASK;
+    drone->navdataSequence = NAVDATA_SEQUENCE_DEFAULT;
+    drone->navdataOptions = (uint32_t)sim_config_get_int (&drone->config, "general:navdata_options", 0);
+    drone->navdataPeerValid = FALSE;
+    drone->atSequence = 0;
+    ATcodec_Parser_Init (&drone->atParser, sim_at_commands, sizeof (sim_at_commands) / sizeof (sim_at_commands[0]), sim_at_other);
+    drone->startTime = sim_get_time_ms ();
+    drone->lastAtTime = drone->startTime - 1000 * COM_INPUT_LANDING_TIME;
+    drone->outageEnd = drone->startTime;
+
+    drone->videoSource.file = options->videoFile;
+    drone->videoSource.gop = options->videoGop;
+    drone->videoSource.streamId = (uint16_t)drone->index;
+    drone->recorderSource = drone->videoSource;
+    if (VP_FAILED (sim_video_source_open (&drone->videoSource)) ||
+        VP_FAILED (sim_video_source_open (&drone->recorderSource)))
+    {
+        sim_drone_close (drone);
+        return C_FAIL;
+    }
+    return C_OK;
+}
+
+void sim_drone_close (sim_drone_t *drone)
+{
+    sim_close (&drone->atSocket);
+    sim_close (&drone->navdataSocket);
+    sim_close (&drone->controlListen);
+    sim_close (&drone->videoListen);
+    sim_close (&drone->recorderListen);
+    sim_close (&drone->ftpListen);
+    sim_close (&drone->ftpClient);
+    sim_close (&drone->ftpData);
+    sim_tcp_close (&drone->control);
+    sim_tcp_close (&drone->video);
+    sim_tcp_close (&drone->recorder);
+    vp_os_free (drone->control.pending);
+    vp_os_free (drone->video.pending);
+    vp_os_free (drone->recorder.pending);
+    drone->control.pending = NULL;
+    drone->video.pending = NULL;
+    drone->recorder.pending = NULL;
+    sim_video_source_close (&drone->videoSource);
+    sim_video_source_close (&drone->recorderSource);
+}
+
+C_RESULT sim_drone_start (sim_drone_t *drone)
+{
+    drone->running = TRUE;
+    vp_os_thread_create (thread_sim_drone_loop, (THREAD_PARAMS)drone, &drone->thread);
+    return C_OK;
+}
+
+void sim_drone_stop (sim_drone_t *drone)
+{
+    drone->running = FALSE;
+    vp_os_thread_join (drone->thread);
+}
+
+void sim_drone_outage (sim_drone_t *drone, uint32_t duration)
+{
+    // Only flag the outage here : sockets are owned by the drone thread
+    drone->outageEnd = sim_get_time_ms () + duration;
+}
+
+static void sim_drone_begin_outage (sim_drone_t *drone)
+{
+    SIM_PRINT (drone, "Link outage\n");
+    drone->stats.outages++;
+    sim_tcp_close (&drone->control);
+    sim_tcp_close (&drone->video);
+    sim_tcp_close (&drone->recorder);
+    sim_close (&drone->ftpClient);
+    sim_close (&drone->ftpData);
+    drone->navdataPeerValid = FALSE;
+}
+
+static uint32_t sim_drone_navdata_period (sim_drone_t *drone)
+{
+    int32_t rate = drone->options->navdataRate;
+    if (0 >= rate)
+    {
+        rate = (drone->ardroneState & (ARDRONE_NAVDATA_DEMO_MASK | ARDRONE_NAVDATA_BOOTSTRAP)) ? SIM_NAVDATA_DEMO_RATE : SIM_NAVDATA_FULL_RATE;
+    }
+    return (1000 + rate - 1) / rate;
+}
+
+static uint32_t sim_drone_video_period (sim_drone_t *drone)
+{
+    int32_t fps = drone->options->videoFps;
+    if (0 >= fps)
+    {
+        fps = sim_config_get_int (&drone->config, "video:codec_fps", 30);
+    }
+    return 1000 / ((0 < fps) ? fps : 30);
+}
+
+static void sim_drone_send_navdata (sim_drone_t *drone)
+{
+    uint8_t buffer[NAVDATA_MAX_SIZE];
+    int32_t size = sim_navdata_build (drone, buffer, sizeof (buffer));
+
+    if (rand () % 100 < drone->options->navdataLoss)
+    {
+        drone->stats.navdataDropped++;
+        return;
+    }
+    if (0 < sendto (drone->navdataSocket, buffer, size, 0, (struct sockaddr *)&drone->navdataPeer, sizeof (drone->navdataPeer)))
+    {
+        drone->stats.navdataSent++;
+    }
+}
+
+static void sim_drone_send_video (sim_drone_t *drone, sim_tcp_client_t *client, sim_video_source_t *source, uint32_t now)
+{
+    const uint8_t *frame;
+    uint32_t size;
+
+    if (0 > client->socket || ! (drone->ardroneState & ARDRONE_VIDEO_MASK))
+    {
+        return;
+    }
+    // Like the drone encoder, drop frames while the socket is congested
+    if (client->pendingIndex < client->pendingSize)
+    {
+        drone->stats.videoDropped++;
+        return;
+    }
+    size = sim_video_source_next (source, now - drone->startTime, &frame);
+    if (0 < size && sim_tcp_send (client, frame, size, FALSE))
+    {
+        drone->stats.videoFrames++;
+        drone->stats.videoBytes += size;
+    }
+}
+
+static void sim_drone_read_at (sim_drone_t *drone, bool_t inOutage)
+{
+    char buffer[SIM_AT_BUFFER_SIZE];
+    ssize_t bytes;
+    while (0 < (bytes = recv (drone->atSocket, buffer, sizeof (buffer) - 1, MSG_DONTWAIT)))
+    {
+        if (inOutage || rand () % 100 < drone->options->atLoss)
+        {
+            drone->stats.atDropped++;
+            continue;
+        }
+        // The terminator ends the last command of the datagram
+        buffer[bytes] = '\0';
+        sim_drone_handle_at (drone, buffer, (int32_t)bytes + 1);
+    }
+}
+
+static void sim_drone_read_navdata (sim_drone_t *drone, bool_t inOutage)
+{
+    uint8_t buffer[64];
+    struct sockaddr_in from;
+    socklen_t len = sizeof (from);
+
+    while (0 < recvfrom (drone->navdataSocket, buffer, sizeof (buffer), MSG_DONTWAIT, (struct sockaddr *)&from, &len))
+    {
+        if (inOutage)
+        {
+            continue;
+        }
+        // Any datagram on the navdata port (re)starts the navdata stream towards its sender
+        if (! drone->navdataPeerValid ||
+            from.sin_addr.s_addr != drone->navdataPeer.sin_addr.s_addr ||
+            from.sin_port != drone->navdataPeer.sin_port)
+        {
+            SIM_PRINT (drone, "Navdata client %s:%d\n", inet_ntoa (from.sin_addr), ntohs (from.sin_port));
+            drone->navdataSequence = NAVDATA_SEQUENCE_DEFAULT;
+        }
+        drone->navdataPeer = from;
+        drone->navdataPeerValid = TRUE;
+        len = sizeof (from);
+    }
+}
+
+#define SIM_FD_SET(fd, set, maxFd)   \
+    do {                             \
+        if (0 <= (fd))               \
+        {                            \
+            FD_SET ((fd), (set));    \
+            if ((fd) > (maxFd))      \
+                (maxFd) = (fd);      \
+        }                            \
+    } while (0)
+
+DEFINE_THREAD_ROUTINE (sim_drone_loop, data)
+{
+    sim_drone_t *drone = (sim_drone_t *)data;
+    uint32_t now = sim_get_time_ms ();
+    uint32_t lastUpdate = now;
+    uint32_t nextNavdata = now;
+    uint32_t nextVideo = now;
+    bool_t wasInOutage = FALSE;
+
+    PRINT ("Simulated drone %d listening on %s\n", drone->index, drone->ip);
+
+    while (drone->running)
+    {
+        fd_set readFds, writeFds;
+        struct timeval tv;
+        int maxFd = -1;
+        int32_t timeout;
+        bool_t inOutage;
+
+        now = sim_get_time_ms ();
+        inOutage = (0 < (int32_t)(drone->outageEnd - now)) ? TRUE : FALSE;
+        if (inOutage && ! wasInOutage)
+        {
+            sim_drone_begin_outage (drone);
+        }
+        wasInOutage = inOutage;
+
+        if (0 <= (int32_t)(now - nextNavdata))
+        {
+            uint32_t period = sim_drone_navdata_period (drone);
+            sim_navdata_update (drone, (now - lastUpdate) / 1000.0f);
+            lastUpdate = now;
+            if (drone->navdataPeerValid && ! inOutage)
+            {
+                sim_drone_send_navdata (drone);
+            }
+            nextNavdata += period;
+            if (0 < (int32_t)(now - nextNavdata))
+            {
+                // Late (machine overloaded) : do not send bursts to catch up
+                nextNavdata = now + period;
+            }
+        }
+
+        if (0 <= (int32_t)(now - nextVideo))
+        {
+            uint32_t period = sim_drone_video_period (drone);
+            sim_drone_send_video (drone, &drone->video, &drone->videoSource, now);
+            sim_drone_send_video (drone, &drone->recorder, &drone->recorderSource, now);
+            nextVideo += period;
+            if (0 < (int32_t)(now - nextVideo))
+            {
+                nextVideo = now + period;
+            }
+        }
+
+        FD_ZERO (&readFds);
+        FD_ZERO (&writeFds);
+        SIM_FD_SET (drone->atSocket, &readFds, maxFd);
+        SIM_FD_SET (drone->navdataSocket, &readFds, maxFd);
+        SIM_FD_SET (drone->controlListen, &readFds, maxFd);
+        SIM_FD_SET (drone->videoListen, &readFds, maxFd);
+        SIM_FD_SET (drone->recorderListen, &readFds, maxFd);
+        SIM_FD_SET (drone->ftpListen, &readFds, maxFd);
+        SIM_FD_SET (drone->ftpClient, &readFds, maxFd);
+        SIM_FD_SET (drone->control.socket, &readFds, maxFd);
+        SIM_FD_SET (drone->video.socket, &readFds, maxFd);
+        SIM_FD_SET (drone->recorder.socket, &readFds, maxFd);
+        if (drone->control.pendingIndex < drone->control.pendingSize)
+            SIM_FD_SET (drone->control.socket, &writeFds, maxFd);
+        if (drone->video.pendingIndex < drone->video.pendingSize)
+            SIM_FD_SET (drone->video.socket, &writeFds, maxFd);
+        if (drone->recorder.pendingIndex < drone->recorder.pendingSize)
+            SIM_FD_SET (drone->recorder.socket, &writeFds, maxFd);
+
+        timeout = (int32_t)(nextNavdata - now);
+        if ((int32_t)(nextVideo - now) < timeout)
+        {
+            timeout = (int32_t)(nextVideo - now);
+        }
+        if (0 > timeout)
+        {
+            timeout = 0;
+        }
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout % 1000) * 1000;
+
+        if (0 >= select (maxFd + 1, &readFds, &writeFds, NULL, &tv))
+        {
+            continue;
+        }
+
+        if (FD_ISSET (drone->atSocket, &readFds))
+        {
+            sim_drone_read_at (drone, inOutage);
+        }
+        if (FD_ISSET (drone->navdataSocket, &readFds))
+        {
+            sim_drone_read_navdata (drone, inOutage);
+        }
+
+        // Client sockets first : a listener may replace them below
+        if (0 <= drone->control.socket && FD_ISSET (drone->control.socket, &readFds))
+            sim_tcp_check_closed (&drone->control);
+        if (0 <= drone->video.socket && FD_ISSET (drone->video.socket, &readFds))
+            sim_tcp_check_closed (&drone->video);
+        if (0 <= drone->recorder.socket && FD_ISSET (drone->recorder.socket, &readFds))
+            sim_tcp_check_closed (&drone->recorder);
+        if (0 <= drone->control.socket && FD_ISSET (drone->control.socket, &writeFds))
+            sim_tcp_flush (&drone->control);
+        if (0 <= drone->video.socket && FD_ISSET (drone->video.socket, &writeFds))
+            sim_tcp_flush (&drone->video);
+        if (0 <= drone->recorder.socket && FD_ISSET (drone->recorder.socket, &writeFds))
+            sim_tcp_flush (&drone->recorder);
+
+        if (0 <= drone->ftpClient && FD_ISSET (drone->ftpClient, &readFds))
+        {
+            if (VP_FAILED (sim_ftp_process (drone)))
+            {
+                sim_close (&drone->ftpClient);
+                sim_close (&drone->ftpData);
+            }
+        }
+
+        if (FD_ISSET (drone->controlListen, &readFds))
+        {
+            sim_tcp_accept (drone, drone->controlListen, &drone->control, inOutage);
+        }
+        if (FD_ISSET (drone->videoListen, &readFds) &&
+            sim_tcp_accept (drone, drone->videoListen, &drone->video, inOutage))
+        {
+            sim_video_source_restart (&drone->videoSource);
+        }
+        if (FD_ISSET (drone->recorderListen, &readFds) &&
+            sim_tcp_accept (drone, drone->recorderListen, &drone->recorder, inOutage))
+        {
+            sim_video_source_restart (&drone->recorderSource);
+        }
+        if (FD_ISSET (drone->ftpListen, &readFds))
+        {
+            int s = accept (drone->ftpListen, NULL, NULL);
+            if (0 <= s && inOutage)
+            {
+                close (s);
+            }
+            else if (0 <= s)
+            {
+                struct timeval ftpTimeout = { 1, 0 };
+                sim_close (&drone->ftpClient);
+                sim_close (&drone->ftpData);
+                drone->ftpClient = s;
+                setsockopt (s, SOL_SOCKET, SO_RCVTIMEO, &ftpTimeout, sizeof (ftpTimeout));
+                send (s, "220 Simulated AR.Drone FTP\r\n", 28, MSG_NOSIGNAL);
+                drone->stats.connections++;
+            }
+        }
+    }
+
+    PRINT ("Simulated drone %d stopped\n", drone->index);
+    THREAD_RETURN (0);
+}
@@ -0,0 +1,154 @@
+/**
+ * @file sim_drone.h
+ * @date 2026/10/18
+ *
+ * One simulated AR.Drone : serves the AT (UDP 5556), navdata (UDP 5554),
+ * control (TCP 5559), video (TCP 5555), video recorder (TCP 5553) and
+ * FTP (TCP 5551) ports on its own IPv4 address, from a single thread.
+ */
+
+#ifndef _SIM_DRONE_H_
+#define _SIM_DRONE_H_ (1)
+
+#include <netinet/in.h>
+
+#include <VP_Os/vp_os_types.h>
+#include <VP_Os/vp_os_thread.h>
+#include <ATcodec/ATcodec_Parser.h>
+#include <ardrone_api.h>
+
+#include <Simulator/sim_config.h>
+#include <Simulator/sim_video.h>
+
+#define SIM_IP_SIZE (16)
+#define SIM_PATH_SIZE (256)
+
+/**
+ * Options shared by all simulated drones
+ */
+typedef struct _sim_options_ {
+    int32_t numDrones;
+    char baseIp[SIM_IP_SIZE];        /* Address of the first drone, next ones use the following addresses */
+    int32_t navdataRate;             /* Hz, 0 : 15Hz in navdata demo mode, 200Hz otherwise */
+    int32_t navdataLoss;             /* Percentage of navdata packets which are not sent */
+    int32_t atLoss;                  /* Percentage of AT datagrams which are ignored */
+    int32_t outagePeriod;            /* Seconds between two simulated link outages, 0 : never */
+    int32_t outageDuration;          /* Duration of an outage in ms */
+    int32_t videoFps;
+    int32_t videoGop;
+    int32_t verbose;
+    char version[32];                /* Content of version.txt / general:num_version_soft */
+    char ftpRoot[SIM_PATH_SIZE];     /* Directory served by the FTP port, empty : only version.txt */
+    const sim_video_file_t *videoFile; /* Recorded PaVE stream, NULL : synthetic stream */
+    const sim_config_t *config;      /* Initial configuration of each drone */
+} sim_options_t;
+
+typedef struct _sim_stats_ {
+    uint32_t atPackets;
+    uint32_t atCommands;
+    uint32_t atDropped;              /* Ignored because of the simulated loss */
+    uint32_t atOutOfSequence;
+    uint32_t navdataSent;
+    uint32_t navdataDropped;
+    uint32_t videoFrames;
+    uint32_t videoDropped;           /* Not sent because the TCP socket was full */
+    uint64_t videoBytes;
+    uint32_t connections;
+    uint32_t configDumps;
+    uint32_t outages;
+} sim_stats_t;
+
+typedef struct _sim_tcp_client_ {
+    int socket;
+    uint8_t *pending;                /* Data not accepted yet by the socket */
+    uint32_t pendingSize;
+    uint32_t pendingIndex;
+} sim_tcp_client_t;
+
+typedef struct _sim_drone_ {
+    // PARAM
+    int32_t index;
+    char ip[SIM_IP_SIZE];
+    const sim_options_t *options;
+    // SOCKETS
+    int atSocket;
+    int navdataSocket;
+    int controlListen;
+    int videoListen;
+    int recorderListen;
+    int ftpListen;
+    sim_tcp_client_t control;
+    sim_tcp_client_t video;
+    sim_tcp_client_t recorder;
+    int ftpClient;
+    int ftpData;
+    uint32_t ftpRestart;
+    struct sockaddr_in navdataPeer;
+    bool_t navdataPeerValid;
+    // STATE
+    sim_config_t config;
+    navdata_unpacked_t navdata;      /* Values sent in the navdata options */
+    uint32_t ardroneState;
+    uint32_t navdataSequence;
+    uint32_t navdataOptions;
+    int32_t atSequence;
+    ATcodec_Parser_t atParser;
+    uint32_t lastAtTime;
+    uint32_t lastRefInput;
+    float32_t pcmd[4];               /* roll, pitch, gaz, yaw in [-1;1] */
+    bool_t pcmdEnabled;
+    float32_t battery;               /* Percentage */
+    uint32_t startTime;
+    uint32_t outageEnd;
+    sim_video_source_t videoSource;
+    sim_video_source_t recorderSource;
+    sim_stats_t stats;
+    // THREAD
+    THREAD_HANDLE thread;
+    volatile bool_t running;
+} sim_drone_t;
+
+/**
+ * Current time in ms, from a monotonic clock
+ */
+uint32_t sim_get_time_ms (void);
+
+C_RESULT sim_drone_open (sim_drone_t *drone);
+void sim_drone_close (sim_drone_t *drone);
+
+/**
+ * Run the drone in its own thread
+ */
+C_RESULT sim_drone_start (sim_drone_t *drone);
+void sim_drone_stop (sim_drone_t *drone);
+
+/**
+ * Close all client connections and stop answering for duration ms.
+ * Used to simulate WiFi drops and generate reconnection storms.
+ */
+void sim_drone_outage (sim_drone_t *drone, uint32_t duration);
+
+/**
+ * Handle one AT datagram (several commands separated by '\r').
+ * A command which is not followed by '\r', '\n' or '\0' is ignored.
+ */
+void sim_drone_handle_at (sim_drone_t *drone, const char *buffer, int32_t size);
+
+/**
+ * Build the next navdata packet
+ * @return Size of the packet
+ */
+int32_t sim_navdata_build (sim_drone_t *drone, uint8_t *buffer, int32_t size);
+
+/**
+ * Advance the flight model by dt seconds
+ */
+void sim_navdata_update (sim_drone_t *drone, float32_t dt);
+
+/**
+ * Serve one command on the FTP control connection
+ * @return C_FAIL if the connection must be closed
+ */
+C_RESULT sim_ftp_process (sim_drone_t *drone);
+
+#endif // _SIM_DRONE_H_
@@ -0,0 +1,279 @@
+/**
+ * @file sim_ftp.c
+ * @date 2026/10/18
+ *
+ * Minimal passive mode FTP server, enough for ardrone_ftp.c clients :
+ * version.txt is always served, other files come from the optional FTP root.
+ */
+
+#include "sim_drone.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+
+#define SIM_FTP_LINE_SIZE     (512)
+#define SIM_FTP_CHUNK_SIZE    (32768)
+#define SIM_FTP_ACCEPT_TIMEOUT (2)  /* seconds */
+
+static void sim_ftp_reply (sim_drone_t *drone, const char *reply)
+{
+    if (0 > send (drone->ftpClient, reply, strlen (reply), MSG_NOSIGNAL))
+    {
+        DEBUG_PRINT_SDK ("[SIM %d] FTP reply failed (%s)\n", drone->index, strerror (errno));
+    }
+}
+
+static void sim_ftp_close_data (sim_drone_t *drone)
+{
+    if (0 <= drone->ftpData)
+    {
+        close (drone->ftpData);
+        drone->ftpData = -1;
+    }
+}
+
+/**
+ * Resolve a remote path. Fills either localPath (file of the FTP root) or
+ * content (virtual version.txt).
+ * @return Size of the file, -1 if it does not exist
+ */
+static int32_t sim_ftp_resolve (sim_drone_t *drone, const char *path, char *localPath, char *content, int32_t contentSize)
+{
+    FILE *f;
+    int32_t size = -1;
+
+    localPath[0] = '\0';
+    while ('/' == *path)
+    {
+        path++;
+    }
+    if ('\0' != drone->options->ftpRoot[0] && NULL == strstr (path, ".."))
+    {
+        int len = snprintf (localPath, SIM_PATH_SIZE, "%.*s/%s", SIM_PATH_SIZE / 2, drone->options->ftpRoot, path);
+        f = (len < SIM_PATH_SIZE) ? fopen (localPath, "rb") : NULL;
+        if (NULL != f)
+        {
+            fseek (f, 0, SEEK_END);
+            size = (int32_t)ftell (f);
+            fclose (f);
+            return size;
+        }
+        localPath[0] = '\0';
+    }
+    if (0 == strcmp (path, "version.txt"))
+    {
+        size = snprintf (content, contentSize, "%s\n", drone->options->version);
+    }
+    return size;
+}
+
+static C_RESULT sim_ftp_passive (sim_drone_t *drone)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof (addr);
+    char reply[SIM_FTP_LINE_SIZE];
+    uint32_t ip;
+
+    sim_ftp_close_data (drone);
+    drone->ftpData = socket (AF_INET, SOCK_STREAM, 0);
+    vp_os_memset (&addr, 0x0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr (drone->ip);
+    addr.sin_port = 0;
+    if (0 > drone->ftpData ||
+        0 > bind (drone->ftpData, (struct sockaddr *)&addr, sizeof (addr)) ||
+        0 > listen (drone->ftpData, 1) ||
+        0 > getsockname (drone->ftpData, (struct sockaddr *)&addr, &len))
+    {
+        sim_ftp_close_data (drone);
+        sim_ftp_reply (drone, "425 Can't open passive connection.\r\n");
+        return C_FAIL;
+    }
+    ip = ntohl (addr.sin_addr.s_addr);
+    snprintf (reply, sizeof (reply), "227 Entering Passive Mode (%u,%u,%u,%u,%u,%u).\r\n",
+              (ip >> 24) & 0xFF, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF,
+              ntohs (addr.sin_port) >> 8, ntohs (addr.sin_port) & 0xFF);
+    sim_ftp_reply (drone, reply);
+    return C_OK;
+}
+
+static void sim_ftp_retrieve (sim_drone_t *drone, const char *path)
+{
+    char localPath[SIM_PATH_SIZE];
+    char content[64];
+    char *chunk = NULL;
+    struct timeval tv = { SIM_FTP_ACCEPT_TIMEOUT, 0 };
+    fd_set fds;
+    int dataSocket = -1;
+    int32_t size = sim_ftp_resolve (drone, path, localPath, content, sizeof (content));
+    uint32_t offset = drone->ftpRestart;
+
+    drone->ftpRestart = 0;
+    if (0 > size || 0 > drone->ftpData)
+    {
+        sim_ftp_reply (drone, (0 > size) ? "550 Failed to open file.\r\n" : "425 Use PASV first.\r\n");
+        return;
+    }
+    sim_ftp_reply (drone, "150 Opening BINARY mode data connection.\r\n");
+
+    FD_ZERO (&fds);
+    FD_SET (drone->ftpData, &fds);
+    if (0 < select (drone->ftpData + 1, &fds, NULL, NULL, &tv))
+    {
+        dataSocket = accept (drone->ftpData, NULL, NULL);
+    }
+    sim_ftp_close_data (drone);
+    if (0 > dataSocket)
+    {
+        sim_ftp_reply (drone, "425 Failed to establish connection.\r\n");
+        return;
+    }
+
+    if ('\0' == localPath[0])
+    {
+        if (offset < (uint32_t)size)
+        {
+            send (dataSocket, &content[offset], size - offset, MSG_NOSIGNAL);
+        }
+    }
+    else
+    {
+        FILE *f = fopen (localPath, "rb");
+        chunk = vp_os_malloc (SIM_FTP_CHUNK_SIZE);
+        if (NULL != f && NULL != chunk && 0 == fseek (f, offset, SEEK_SET))
+        {
+            size_t bytes;
+            while (0 < (bytes = fread (chunk, 1, SIM_FTP_CHUNK_SIZE, f)))
+            {
+                if (0 > send (dataSocket, chunk, bytes, MSG_NOSIGNAL))
+                {
+                    break;
+                }
+            }
+        }
+        if (NULL != f)
+        {
+            fclose (f);
+        }
+        vp_os_free (chunk);
+    }
+    close (dataSocket);
+    sim_ftp_reply (drone, "226 Transfer complete.\r\n");
+}
+
+C_RESULT sim_ftp_process (sim_drone_t *drone)
+{
+    char line[SIM_FTP_LINE_SIZE];
+    char reply[SIM_FTP_LINE_SIZE];
+    char localPath[SIM_PATH_SIZE];
+    char content[64];
+    char *arg;
+    int32_t index = 0;
+
+    // Commands are short : read them byte by byte up to the end of line
+    while (index < SIM_FTP_LINE_SIZE - 1)
+    {
+        ssize_t bytes = recv (drone->ftpClient, &line[index], 1, 0);
+        if (0 >= bytes)
+        {
+            return C_FAIL;
+        }
+        if ('\n' == line[index])
+        {
+            break;
+        }
+        index++;
+    }
+    line[index] = '\0';
+    if (0 < index && '\r' == line[index - 1])
+    {
+        line[index - 1] = '\0';
+    }
+
+    arg = strchr (line, ' ');
+    if (NULL != arg)
+    {
+        *arg++ = '\0';
+    }
+    else
+    {
+        arg = &line[index];
+    }
+
+    if (0 == strcasecmp (line, "USER"))
+    {
+        sim_ftp_reply (drone, (0 == strcmp (arg, "anonymous")) ? "230 Login successful.\r\n" : "331 Please specify the password.\r\n");
+    }
+    else if (0 == strcasecmp (line, "PASS"))
+    {
+        sim_ftp_reply (drone, "230 Login successful.\r\n");
+    }
+    else if (0 == strcasecmp (line, "TYPE"))
+    {
+        sim_ftp_reply (drone, "200 Switching to Binary mode.\r\n");
+    }
+    else if (0 == strcasecmp (line, "PASV"))
+    {
+        sim_ftp_passive (drone);
+    }
+    else if (0 == strcasecmp (line, "SIZE"))
+    {
+        int32_t size = sim_ftp_resolve (drone, arg, localPath, content, sizeof (content));
+        if (0 > size)
+        {
+            sim_ftp_reply (drone, "550 Could not get file size.\r\n");
+        }
+        else
+        {
+            snprintf (reply, sizeof (reply), "213 %d\r\n", size);
+            sim_ftp_reply (drone, reply);
+        }
+    }
+    else if (0 == strcasecmp (line, "REST"))
+    {
+        drone->ftpRestart = (uint32_t)strtoul (arg, NULL, 10);
+        snprintf (reply, sizeof (reply), "350 Restart position accepted (%u).\r\n", drone->ftpRestart);
+        sim_ftp_reply (drone, reply);
+    }
+    else if (0 == strcasecmp (line, "RETR"))
+    {
+        sim_ftp_retrieve (drone, arg);
+    }
+    else if (0 == strcasecmp (line, "PWD"))
+    {
+        sim_ftp_reply (drone, "257 \"/\"\r\n");
+    }
+    else if (0 == strcasecmp (line, "CWD"))
+    {
+        sim_ftp_reply (drone, "250 Directory successfully changed.\r\n");
+    }
+    else if (0 == strcasecmp (line, "NOOP"))
+    {
+        sim_ftp_reply (drone, "200 NOOP ok.\r\n");
+    }
+    else if (0 == strcasecmp (line, "QUIT"))
+    {
+        sim_ftp_reply (drone, "221 Goodbye.\r\n");
+        return C_FAIL;
+    }
+    else if (0 == strcasecmp (line, "ABOR"))
+    {
+        sim_ftp_close_data (drone);
+        sim_ftp_reply (drone, "226 No transfer to ABOR.\r\n");
+    }
+    else
+    {
+        sim_ftp_reply (drone, "502 Command not implemented.\r\n");
+    }
+    return C_OK;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file sim_navdata.c
+ * @date 2026/10/18
+ *
+ * Navdata generation and very simple flight model of the simulated drone.
+ */
+
+#include "sim_drone.h"
+
+#include <math.h>
+#include <sys/time.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <control_states.h>
+
+#define SIM_TAKEOFF_ALTITUDE   (1000)   /* mm */
+#define SIM_TAKEOFF_SPEED      (600.0f) /* mm/s */
+#define SIM_LANDING_SPEED      (500.0f) /* mm/s */
+#define SIM_SPEED_PER_RADIAN   (4000.0f)
+#define SIM_BATTERY_DRAIN      (0.1f)   /* % per second of flight */
+#define SIM_BATTERY_LOW        (20)
+
+
+static void sim_set_ctrl_state (sim_drone_t *drone, uint32_t major)
+{
+    drone->navdata.navdata_demo.ctrl_state = major << 16;
+}
+
+static uint32_t sim_get_ctrl_state (sim_drone_t *drone)
+{
+    return drone->navdata.navdata_demo.ctrl_state >> 16;
+}
+
+void sim_navdata_update (sim_drone_t *drone, float32_t dt)
+{
+    navdata_demo_t *demo = &drone->navdata.navdata_demo;
+    const sim_config_t *cfg = &drone->config;
+    bool_t takeoffRequested = (drone->lastRefInput & (1 << ARDRONE_UI_BIT_START)) ? TRUE : FALSE;
+    float32_t altitude = (float32_t)demo->altitude * 10.0f;  /* demo->altitude is in cm */
+    float32_t theta = 0.0f, phi = 0.0f;
+    uint32_t now = sim_get_time_ms ();
+
+    // Communication lost : land as the real drone does
+    if ((now - drone->lastAtTime) > 250)
+    {
+        drone->ardroneState |= ARDRONE_COM_WATCHDOG_MASK;
+    }
+    if ((now - drone->lastAtTime) > (uint32_t)(1000 * sim_config_get_int (cfg, "general:com_watchdog", COM_INPUT_LANDING_TIME)))
+    {
+        drone->ardroneState |= ARDRONE_COM_LOST_MASK;
+        takeoffRequested = FALSE;
+        drone->pcmdEnabled = FALSE;
+    }
+    else
+    {
+        drone->ardroneState &= ~ARDRONE_COM_LOST_MASK;
+    }
+
+    if (drone->ardroneState & ARDRONE_EMERGENCY_MASK)
+    {
+        altitude = 0.0f;
+        sim_set_ctrl_state (drone, CTRL_DEFAULT);
+        drone->ardroneState &= ~ARDRONE_FLY_MASK;
+    }
+    else switch (sim_get_ctrl_state (drone))
+    {
+    case CTRL_DEFAULT:
+    case CTRL_INIT:
+    case CTRL_LANDED:
+        sim_set_ctrl_state (drone, CTRL_LANDED);
+        altitude = 0.0f;
+        if (takeoffRequested && SIM_BATTERY_LOW < demo->vbat_flying_percentage)
+        {
+            sim_set_ctrl_state (drone, CTRL_TRANS_TAKEOFF);
+            drone->ardroneState |= ARDRONE_FLY_MASK;
+        }
+        break;
+
+    case CTRL_TRANS_TAKEOFF:
+        altitude += SIM_TAKEOFF_SPEED * dt;
+        if (SIM_TAKEOFF_ALTITUDE <= altitude)
+        {
+            altitude = SIM_TAKEOFF_ALTITUDE;
+            sim_set_ctrl_state (drone, CTRL_HOVERING);
+        }
+        if (! takeoffRequested)
+        {
+            sim_set_ctrl_state (drone, CTRL_TRANS_LANDING);
+        }
+        break;
+
+    case CTRL_FLYING:
+    case CTRL_HOVERING:
+        if (! takeoffRequested)
+        {
+            sim_set_ctrl_state (drone, CTRL_TRANS_LANDING);
+            break;
+        }
+        if (drone->pcmdEnabled)
+        {
+            float32_t eulerMax = sim_config_get_float (cfg, "control:euler_angle_max", 0.21f);
+            float32_t vzMax = sim_config_get_float (cfg, "control:control_vz_max", 700.0f);
+            float32_t yawMax = sim_config_get_float (cfg, "control:control_yaw", 1.75f);
+            phi = drone->pcmd[0] * eulerMax;
+            theta = drone->pcmd[1] * eulerMax;
+            demo->vz = drone->pcmd[2] * vzMax;
+            demo->psi += drone->pcmd[3] * yawMax * dt * RAD_TO_MDEG;
+            if (demo->psi > 180000.0f) demo->psi -= 360000.0f;
+            if (demo->psi < -180000.0f) demo->psi += 360000.0f;
+            sim_set_ctrl_state (drone, CTRL_FLYING);
+        }
+        else
+        {
+            demo->vz = 0.0f;
+            sim_set_ctrl_state (drone, CTRL_HOVERING);
+        }
+        altitude += demo->vz * dt;
+        altitude = fmaxf (altitude, (float32_t)sim_config_get_int (cfg, "control:altitude_min", 50));
+        altitude = fminf (altitude, (float32_t)sim_config_get_int (cfg, "control:altitude_max", 3000));
+        break;
+
+    case CTRL_TRANS_LANDING:
+    default:
+        altitude -= SIM_LANDING_SPEED * dt;
+        if (0.0f >= altitude)
+        {
+            altitude = 0.0f;
+            sim_set_ctrl_state (drone, CTRL_LANDED);
+            drone->ardroneState &= ~ARDRONE_FLY_MASK;
+        }
+        else if (takeoffRequested)
+        {
+            sim_set_ctrl_state (drone, CTRL_HOVERING);
+        }
+        break;
+    }
+
+    demo->theta = theta * RAD_TO_MDEG;
+    demo->phi = phi * RAD_TO_MDEG;
+    demo->vx = -theta * SIM_SPEED_PER_RADIAN;
+    demo->vy = phi * SIM_SPEED_PER_RADIAN;
+    demo->altitude = (int32_t)(altitude / 10.0f);
+    drone->navdata.navdata_altitude.altitude_vision = (int32_t)altitude;
+    drone->navdata.navdata_altitude.altitude_vz = demo->vz;
+    drone->navdata.navdata_euler_angles.theta_a = demo->theta;
+    drone->navdata.navdata_euler_angles.phi_a = demo->phi;
+
+    if (drone->ardroneState & ARDRONE_FLY_MASK)
+    {
+        drone->battery = fmaxf (drone->battery - SIM_BATTERY_DRAIN * dt, 0.0f);
+        demo->vbat_flying_percentage = (uint32_t)drone->battery;
+    }
+    if (SIM_BATTERY_LOW >= demo->vbat_flying_percentage)
+    {
+        drone->ardroneState |= ARDRONE_VBAT_LOW;
+    }
+}
+
+int32_t sim_navdata_build (sim_drone_t *drone, uint8_t *buffer, int32_t size)
+{
+    navdata_t *navdata = (navdata_t *)buffer;
+    uint8_t *ptr = (uint8_t *)&navdata->options[0];
+    navdata_cks_t *cks;
+    uint32_t mask = NAVDATA_OPTION_FULL_MASK;
+    struct timeval tv;
+
+    if (drone->ardroneState & ARDRONE_NAVDATA_BOOTSTRAP)
+    {
+        mask = 0;
+    }
+    else if (drone->ardroneState & ARDRONE_NAVDATA_DEMO_MASK)
+    {
+        mask = drone->navdataOptions | NAVDATA_OPTION_MASK (NAVDATA_DEMO_TAG);
+    }
+
+    gettimeofday (&tv, NULL);
+    drone->navdata.navdata_time.time = ((tv.tv_sec & 0x7FF) << 21) | (tv.tv_usec & 0x1FFFFF);
+    drone->navdata.navdata_demo.num_frames = drone->videoSource.frameNumber;
+
+    navdata->header = NAVDATA_HEADER;
+    navdata->ardrone_state = drone->ardroneState;
+    navdata->sequence = drone->navdataSequence++;
+    navdata->vision_defined = 0;
+
+#define NAVDATA_OPTION_DEMO(STRUCTURE,NAME,TAG)  NAVDATA_OPTION(STRUCTURE,NAME,TAG)
+#define NAVDATA_OPTION(STRUCTURE,NAME,TAG)                                      \
+    if ((mask & NAVDATA_OPTION_MASK (TAG)) &&                                   \
+        ptr + sizeof (STRUCTURE) + sizeof (navdata_cks_t) <= buffer + size)     \
+    {                                                                           \
+        drone->navdata.NAME.tag = TAG;                                          \
+        drone->navdata.NAME.size = sizeof (STRUCTURE);                          \
+        vp_os_memcpy (ptr, &drone->navdata.NAME, sizeof (STRUCTURE));           \
+        ptr += sizeof (STRUCTURE);                                              \
+    }
+#define NAVDATA_OPTION_CKS(STRUCTURE,NAME,TAG)
+#include <navdata_keys.h>
+
+    cks = (navdata_cks_t *)ptr;
+    cks->tag = NAVDATA_CKS_TAG;
+    cks->size = sizeof (navdata_cks_t);
+    cks->cks = ardrone_navdata_compute_cks (buffer, (int32_t)(ptr - buffer));
+    return (int32_t)(ptr - buffer) + sizeof (navdata_cks_t);
+}
@@ -0,0 +1,426 @@
+/**
+ * @file sim_video.c
+ * @date 2026/10/18
+ */
+
+#include "sim_video.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+
+#define SIM_MB_WIDTH        (SIM_VIDEO_WIDTH / 16)
+#define SIM_MB_HEIGHT       (SIM_VIDEO_ENCODED_HEIGHT / 16)
+#define SIM_NUM_MB          (SIM_MB_WIDTH * SIM_MB_HEIGHT)
+#define SIM_PCM_MB_SIZE     (256 + 2 * 64)
+
+/* Worst case : every MB is I_PCM, plus emulation prevention bytes and headers */
+#define SIM_VIDEO_BUFFER_SIZE (sizeof (parrot_video_encapsulation_t) + (SIM_NUM_MB * (SIM_PCM_MB_SIZE + 4)) * 3 / 2 + 1024)
+
+#define H264_I_PCM_MB_TYPE  (25)
+#define H264_SLICE_TYPE_P   (5)  /* All slices of the picture are P slices */
+#define H264_SLICE_TYPE_I   (7)  /* All slices of the picture are I slices */
+#define H264_NAL_SLICE      (1)
+#define H264_NAL_IDR        (5)
+#define H264_NAL_SPS        (7)
+#define H264_NAL_PPS        (8)
+#define H264_LOG2_MAX_FRAME_NUM (4)
+
+/*
+ * Minimal H.264 bitstream writer
+ */
+typedef struct _sim_bitstream_ {
+    uint8_t *data;
+    uint32_t index;     /* Bytes written */
+    uint32_t bits;      /* Bits pending in cache */
+    uint32_t cache;
+} sim_bitstream_t;
+
+static void bs_init (sim_bitstream_t *bs, uint8_t *data)
+{
+    bs->data = data;
+    bs->index = 0;
+    bs->bits = 0;
+    bs->cache = 0;
+}
+
+static void bs_put_bits (sim_bitstream_t *bs, uint32_t value, uint32_t numBits)
+{
+    while (0 < numBits--)
+    {
+        bs->cache = (bs->cache << 1) | ((value >> numBits) & 1);
+        if (8 == ++bs->bits)
+        {
+            bs->data[bs->index++] = (uint8_t)bs->cache;
+            bs->bits = 0;
+            bs->cache = 0;
+        }
+    }
+}
+
+static void bs_put_ue (sim_bitstream_t *bs, uint32_t value)
+{
+    uint32_t codeNum = value + 1;
+    uint32_t len = 0;
+    while ((codeNum >> (len + 1)) != 0)
+    {
+        len++;
+    }
+    bs_put_bits (bs, 0, len);
+    bs_put_bits (bs, codeNum, len + 1);
+}
+
+static void bs_put_se (sim_bitstream_t *bs, int32_t value)
+{
+    bs_put_ue (bs, (0 < value) ? (uint32_t)(2 * value - 1) : (uint32_t)(-2 * value));
+}
+
+static void bs_align_zero (sim_bitstream_t *bs)
+{
+    if (0 != bs->bits)
+    {
+        bs_put_bits (bs, 0, 8 - bs->bits);
+    }
+}
+
+static void bs_trailing_bits (sim_bitstream_t *bs)
+{
+    bs_put_bits (bs, 1, 1);
+    bs_align_zero (bs);
+}
+
+/**
+ * Write a NAL unit (start code, header, emulation prevention) from an RBSP
+ * @return Number of bytes written
+ */
+static uint32_t sim_write_nal (uint8_t *dst, uint32_t nalRefIdc, uint32_t nalType, const uint8_t *rbsp, uint32_t rbspSize)
+{
+    uint32_t i, out = 0, zeros = 0;
+    dst[out++] = 0x00;
+    dst[out++] = 0x00;
+    dst[out++] = 0x00;
+    dst[out++] = 0x01;
+    dst[out++] = (uint8_t)((nalRefIdc << 5) | nalType);
+    for (i = 0; i < rbspSize; i++)
+    {
+        if (2 <= zeros && 3 >= rbsp[i])
+        {
+            dst[out++] = 0x03;
+            zeros = 0;
+        }
+        dst[out++] = rbsp[i];
+        zeros = (0 == rbsp[i]) ? zeros + 1 : 0;
+    }
+    return out;
+}
+
+static uint32_t sim_write_sps (uint8_t *dst, uint8_t *tmp)
+{
+    sim_bitstream_t bs;
+    bs_init (&bs, tmp);
+    bs_put_bits (&bs, 66, 8);           // profile_idc : baseline
+    bs_put_bits (&bs, 0xC0, 8);         // constraint_set0/1 flags
+    bs_put_bits (&bs, 30, 8);           // level_idc
+    bs_put_ue (&bs, 0);                 // seq_parameter_set_id
+    bs_put_ue (&bs, H264_LOG2_MAX_FRAME_NUM - 4);
+    bs_put_ue (&bs, 2);                 // pic_order_cnt_type
+    bs_put_ue (&bs, 1);                 // max_num_ref_frames
+    bs_put_bits (&bs, 0, 1);            // gaps_in_frame_num_value_allowed_flag
+    bs_put_ue (&bs, SIM_MB_WIDTH - 1);
+    bs_put_ue (&bs, SIM_MB_HEIGHT - 1);
+    bs_put_bits (&bs, 1, 1);            // frame_mbs_only_flag
+    bs_put_bits (&bs, 1, 1);            // direct_8x8_inference_flag
+    bs_put_bits (&bs, 1, 1);            // frame_cropping_flag
+    bs_put_ue (&bs, 0);
+    bs_put_ue (&bs, 0);
+    bs_put_ue (&bs, 0);
+    bs_put_ue (&bs, (SIM_VIDEO_ENCODED_HEIGHT - SIM_VIDEO_HEIGHT) / 2);
+    bs_put_bits (&bs, 0, 1);            // vui_parameters_present_flag
+    bs_trailing_bits (&bs);
+    return sim_write_nal (dst, 3, H264_NAL_SPS, tmp, bs.index);
+}
+
+static uint32_t sim_write_pps (uint8_t *dst, uint8_t *tmp)
+{
+    sim_bitstream_t bs;
+    bs_init (&bs, tmp);
+    bs_put_ue (&bs, 0);                 // pic_parameter_set_id
+    bs_put_ue (&bs, 0);                 // seq_parameter_set_id
+    bs_put_bits (&bs, 0, 1);            // entropy_coding_mode_flag : CAVLC
+    bs_put_bits (&bs, 0, 1);            // bottom_field_pic_order_in_frame_present_flag
+    bs_put_ue (&bs, 0);                 // num_slice_groups_minus1
+    bs_put_ue (&bs, 0);                 // num_ref_idx_l0_default_active_minus1
+    bs_put_ue (&bs, 0);                 // num_ref_idx_l1_default_active_minus1
+    bs_put_bits (&bs, 0, 1);            // weighted_pred_flag
+    bs_put_bits (&bs, 0, 2);            // weighted_bipred_idc
+    bs_put_se (&bs, 0);                 // pic_init_qp_minus26
+    bs_put_se (&bs, 0);                 // pic_init_qs_minus26
+    bs_put_se (&bs, 0);                 // chroma_qp_index_offset
+    bs_put_bits (&bs, 1, 1);            // deblocking_filter_control_present_flag
+    bs_put_bits (&bs, 0, 1);            // constrained_intra_pred_flag
+    bs_put_bits (&bs, 0, 1);            // redundant_pic_cnt_present_flag
+    bs_trailing_bits (&bs);
+    return sim_write_nal (dst, 3, H264_NAL_PPS, tmp, bs.index);
+}
+
+/**
+ * IDR picture made of I_PCM macroblocks : moving diagonal bars, the colors
+ * depend on the stream id so that each simulated drone is recognizable.
+ */
+static uint32_t sim_write_idr (uint8_t *dst, uint8_t *tmp, uint32_t frameNumber, uint16_t streamId)
+{
+    sim_bitstream_t bs;
+    uint32_t mbx, mby, x, y;
+    uint8_t cb = (uint8_t)(64 + (streamId * 53) % 128);
+    uint8_t cr = (uint8_t)(192 - (streamId * 37) % 128);
+
+    bs_init (&bs, tmp);
+    bs_put_ue (&bs, 0);                 // first_mb_in_slice
+    bs_put_ue (&bs, H264_SLICE_TYPE_I);
+    bs_put_ue (&bs, 0);                 // pic_parameter_set_id
+    bs_put_bits (&bs, 0, H264_LOG2_MAX_FRAME_NUM); // frame_num
+    bs_put_ue (&bs, frameNumber & 0xFFFF); // idr_pic_id
+    bs_put_bits (&bs, 0, 1);            // no_output_of_prior_pics_flag
+    bs_put_bits (&bs, 0, 1);            // long_term_reference_flag
+    bs_put_se (&bs, 0);                 // slice_qp_delta
+    bs_put_ue (&bs, 1);                 // disable_deblocking_filter_idc
+
+    for (mby = 0; mby < SIM_MB_HEIGHT; mby++)
+    {
+        for (mbx = 0; mbx < SIM_MB_WIDTH; mbx++)
+        {
+            bs_put_ue (&bs, H264_I_PCM_MB_TYPE);
+            bs_align_zero (&bs);
+            for (y = 0; y < 16; y++)
+            {
+                for (x = 0; x < 16; x++)
+                {
+                    uint32_t px = mbx * 16 + x;
+                    uint32_t py = mby * 16 + y;
+                    // Samples are kept in [16;235] : no zero byte inside PCM data
+                    bs.data[bs.index++] = (uint8_t)(16 + ((px + py + 8 * frameNumber) % 220));
+                }
+            }
+            for (y = 0; y < 64; y++)
+            {
+                bs.data[bs.index++] = (mbx & 1) ? cb : (uint8_t)(255 - cb);
+            }
+            for (y = 0; y < 64; y++)
+            {
+                bs.data[bs.index++] = (mby & 1) ? cr : (uint8_t)(255 - cr);
+            }
+        }
+    }
+    bs_trailing_bits (&bs);
+    return sim_write_nal (dst, 3, H264_NAL_IDR, tmp, bs.index);
+}
+
+/**
+ * P picture where every macroblock is skipped (repeats the reference picture)
+ */
+static uint32_t sim_write_p_skip (uint8_t *dst, uint8_t *tmp, uint32_t frameNum)
+{
+    sim_bitstream_t bs;
+    bs_init (&bs, tmp);
+    bs_put_ue (&bs, 0);                 // first_mb_in_slice
+    bs_put_ue (&bs, H264_SLICE_TYPE_P);
+    bs_put_ue (&bs, 0);                 // pic_parameter_set_id
+    bs_put_bits (&bs, frameNum & ((1 << H264_LOG2_MAX_FRAME_NUM) - 1), H264_LOG2_MAX_FRAME_NUM);
+    bs_put_bits (&bs, 0, 1);            // num_ref_idx_active_override_flag
+    bs_put_bits (&bs, 0, 1);            // ref_pic_list_modification_flag_l0
+    bs_put_bits (&bs, 0, 1);            // adaptive_ref_pic_marking_mode_flag
+    bs_put_se (&bs, 0);                 // slice_qp_delta
+    bs_put_ue (&bs, 1);                 // disable_deblocking_filter_idc
+    bs_put_ue (&bs, SIM_NUM_MB);        // mb_skip_run
+    bs_trailing_bits (&bs);
+    return sim_write_nal (dst, 2, H264_NAL_SLICE, tmp, bs.index);
+}
+
+C_RESULT sim_video_file_load (sim_video_file_t *file, const char *fileName)
+{
+    uint32_t offset, numFrames = 0;
+    long fileSize;
+    FILE *f = fopen (fileName, "rb");
+
+    vp_os_memset (file, 0x0, sizeof (sim_video_file_t));
+    if (NULL == f)
+    {
+        PRINT ("Unable to open video file %s\n", fileName);
+        return C_FAIL;
+    }
+    fseek (f, 0, SEEK_END);
+    fileSize = ftell (f);
+    fseek (f, 0, SEEK_SET);
+    if (0 >= fileSize)
+    {
+        fclose (f);
+        return C_FAIL;
+    }
+    file->data = vp_os_malloc (fileSize);
+    if (NULL == file->data || (size_t)fileSize != fread (file->data, 1, fileSize, f))
+    {
+        PRINT ("Unable to read video file %s\n", fileName);
+        fclose (f);
+        sim_video_file_release (file);
+        return C_FAIL;
+    }
+    fclose (f);
+    file->size = (uint32_t)fileSize;
+
+    // Two passes : count then index complete PaVE frames
+    for (offset = 0; offset + sizeof (parrot_video_encapsulation_t) <= file->size; )
+    {
+        parrot_video_encapsulation_t *PaVE = (parrot_video_encapsulation_t *)&file->data[offset];
+        if (! PAVE_CHECK (PaVE) || offset + PaVE->header_size + PaVE->payload_size > file->size)
+        {
+            break;
+        }
+        offset += PaVE->header_size + PaVE->payload_size;
+        numFrames++;
+    }
+    if (0 == numFrames)
+    {
+        PRINT ("No PaVE frame found in %s\n", fileName);
+        sim_video_file_release (file);
+        return C_FAIL;
+    }
+    file->frameOffsets = vp_os_malloc (numFrames * sizeof (uint32_t));
+    if (NULL == file->frameOffsets)
+    {
+        sim_video_file_release (file);
+        return C_FAIL;
+    }
+    for (offset = 0; file->numFrames < numFrames; file->numFrames++)
+    {
+        parrot_video_encapsulation_t *PaVE = (parrot_video_encapsulation_t *)&file->data[offset];
+        file->frameOffsets[file->numFrames] = offset;
+        offset += PaVE->header_size + PaVE->payload_size;
+    }
+    PRINT ("Loaded %u PaVE frames from %s\n", file->numFrames, fileName);
+    return C_OK;
+}
+
+void sim_video_file_release (sim_video_file_t *file)
+{
+    vp_os_free (file->data);
+    vp_os_free (file->frameOffsets);
+    vp_os_memset (file, 0x0, sizeof (sim_video_file_t));
+}
+
+C_RESULT sim_video_source_open (sim_video_source_t *src)
+{
+    src->frameNumber = 0;
+    src->fileIndex = 0;
+    src->bufferSize = SIM_VIDEO_BUFFER_SIZE;
+    if (NULL != src->file)
+    {
+        uint32_t i;
+        src->bufferSize = sizeof (parrot_video_encapsulation_t);
+        for (i = 0; i < src->file->numFrames; i++)
+        {
+            parrot_video_encapsulation_t *PaVE = (parrot_video_encapsulation_t *)&src->file->data[src->file->frameOffsets[i]];
+            if (src->bufferSize < PaVE->header_size + PaVE->payload_size)
+            {
+                src->bufferSize = PaVE->header_size + PaVE->payload_size;
+            }
+        }
+    }
+    if (0 >= src->gop)
+    {
+        src->gop = 30;
+    }
+    // Synthetic frames need a second buffer for the RBSP
+    src->buffer = vp_os_malloc ((NULL == src->file) ? 2 * src->bufferSize : src->bufferSize);
+    return (NULL != src->buffer) ? C_OK : C_FAIL;
+}
+
+void sim_video_source_close (sim_video_source_t *src)
+{
+    vp_os_free (src->buffer);
+    src->buffer = NULL;
+}
+
+void sim_video_source_restart (sim_video_source_t *src)
+{
+    if (NULL != src->file)
+    {
+        // Go back to the first IDR frame of the recording
+        uint32_t i;
+        src->fileIndex = 0;
+        for (i = 0; i < src->file->numFrames; i++)
+        {
+            parrot_video_encapsulation_t *PaVE = (parrot_video_encapsulation_t *)&src->file->data[src->file->frameOffsets[i]];
+            if (FRAME_TYPE_IDR_FRAME == PaVE->frame_type && 0 == PaVE->slice_index)
+            {
+                src->fileIndex = i;
+                break;
+            }
+        }
+    }
+    else
+    {
+        // Next synthetic frame will be an IDR frame
+        src->frameNumber += src->gop - (src->frameNumber % src->gop);
+    }
+}
+
+uint32_t sim_video_source_next (sim_video_source_t *src, uint32_t timestamp, const uint8_t **frame)
+{
+    parrot_video_encapsulation_t *PaVE = (parrot_video_encapsulation_t *)src->buffer;
+    uint32_t size;
+
+    if (NULL == src->buffer)
+    {
+        return 0;
+    }
+
+    if (NULL != src->file)
+    {
+        const parrot_video_encapsulation_t *recorded = (const parrot_video_encapsulation_t *)&src->file->data[src->file->frameOffsets[src->fileIndex]];
+        size = recorded->header_size + recorded->payload_size;
+        vp_os_memcpy (src->buffer, recorded, size);
+        src->fileIndex = (src->fileIndex + 1) % src->file->numFrames;
+    }
+    else
+    {
+        uint8_t *payload = &src->buffer[sizeof (parrot_video_encapsulation_t)];
+        uint8_t *tmp = &src->buffer[src->bufferSize];
+        uint32_t gopIndex = src->frameNumber % src->gop;
+
+        vp_os_memset (PaVE, 0x0, sizeof (parrot_video_encapsulation_t));
+        init_parrot_video_encapsulation_header (PaVE);
+        PaVE->video_codec = CODEC_MPEG4_AVC;
+        PaVE->header_size = sizeof (parrot_video_encapsulation_t);
+        PaVE->encoded_stream_width = SIM_VIDEO_WIDTH;
+        PaVE->encoded_stream_height = SIM_VIDEO_ENCODED_HEIGHT;
+        PaVE->display_width = SIM_VIDEO_WIDTH;
+        PaVE->display_height = SIM_VIDEO_HEIGHT;
+        PaVE->total_chuncks = 1;
+        PaVE->total_slices = 1;
+        PaVE->stream_id = src->streamId;
+
+        if (0 == gopIndex)
+        {
+            PaVE->frame_type = FRAME_TYPE_IDR_FRAME;
+            PaVE->header1_size = (uint8_t)sim_write_sps (payload, tmp);
+            PaVE->header2_size = (uint8_t)sim_write_pps (&payload[PaVE->header1_size], tmp);
+            size = PaVE->header1_size + PaVE->header2_size;
+            size += sim_write_idr (&payload[size], tmp, src->frameNumber / src->gop, src->streamId);
+        }
+        else
+        {
+            PaVE->frame_type = FRAME_TYPE_P_FRAME;
+            size = sim_write_p_skip (payload, tmp, gopIndex);
+        }
+        PaVE->payload_size = size;
+        size += PaVE->header_size;
+    }
+
+    // Renumber frames so that the stream stays monotonic when a recording loops
+    PaVE->frame_number = src->frameNumber++;
+    PaVE->timestamp = timestamp;
+    *frame = src->buffer;
+    return size;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file sim_video.h
+ * @date 2026/10/18
+ *
+ * PaVE encapsulated video source of the drone simulator.
+ * Frames come either from a recorded PaVE stream (as received on the video
+ * port of a real drone) or from a synthetic H.264 baseline stream made of
+ * I_PCM IDR frames followed by all-skip P frames.
+ */
+
+#ifndef _SIM_VIDEO_H_
+#define _SIM_VIDEO_H_ (1)
+
+#include <VP_Os/vp_os_types.h>
+#include <video_encapsulation.h>
+
+#define SIM_VIDEO_WIDTH          (640)
+#define SIM_VIDEO_HEIGHT         (360)
+#define SIM_VIDEO_ENCODED_HEIGHT (368)
+
+/**
+ * Recorded stream, loaded once and shared (read only) by all simulated drones
+ */
+typedef struct _sim_video_file_ {
+    uint8_t *data;
+    uint32_t size;
+    uint32_t numFrames;
+    uint32_t *frameOffsets;  /* Offset of each PaVE header inside data */
+} sim_video_file_t;
+
+typedef struct _sim_video_source_ {
+    // PARAM
+    const sim_video_file_t *file;   /* NULL : synthetic stream */
+    int32_t gop;                    /* Synthetic stream : IDR period in frames */
+    uint16_t streamId;
+    // INTERNAL
+    uint32_t frameNumber;
+    uint32_t fileIndex;
+    uint8_t *buffer;
+    uint32_t bufferSize;
+} sim_video_source_t;
+
+C_RESULT sim_video_file_load (sim_video_file_t *file, const char *fileName);
+void sim_video_file_release (sim_video_file_t *file);
+
+C_RESULT sim_video_source_open (sim_video_source_t *src);
+void sim_video_source_close (sim_video_source_t *src);
+
+/**
+ * Restart the stream on a key frame (used when a new client connects).
+ */
+void sim_video_source_restart (sim_video_source_t *src);
+
+/**
+ * Produce the next frame (PaVE header + payload).
+ * @param timestamp PaVE timestamp in milliseconds
+ * @param frame Pointer to the frame, valid until the next call
+ * @return Size of the frame, or 0 on error
+ */
+uint32_t sim_video_source_next (sim_video_source_t *src, uint32_t timestamp, const uint8_t **frame);
+
+#endif // _SIM_VIDEO_H_
@@ -0,0 +1,237 @@
+/**
+ * @file drone_simulator.c
+ * @date 2026/10/18
+ *
+ * Local AR.Drone 2.0 simulator : runs N simulated drones on consecutive
+ * loopback addresses (127.0.0.2, 127.0.0.3 ...) so that the video_demo /
+ * King of the Hill clients can be exercised without hardware.
+ *
+ * Usage example, with the client pointed to the first drone :
+ *   ./linux_drone_simulator -n 4 -navdata_loss 5 -outage 30,3000
+ *   ./linux_video_demo -ip 127.0.0.2
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+
+#include <Simulator/sim_drone.h>
+
+#define SIM_MAX_DRONES        (64)
+#define SIM_DEFAULT_IP        "127.0.0.2"
+#define SIM_DEFAULT_VERSION   "2.4.8"
+#define SIM_STATS_PERIOD      (5)   /* seconds */
+
+static volatile bool_t simExit = FALSE;
+
+static void sim_sigint_handler (int sig)
+{
+    simExit = TRUE;
+}
+
+static void sim_usage (const char *name)
+{
+    printf ("Usage : %s [options]\n", name);
+    printf ("   -n <num>                  Number of simulated drones (default 1, max %d)\n", SIM_MAX_DRONES);
+    printf ("   -ip <address>             Address of the first drone (default %s)\n", SIM_DEFAULT_IP);
+    printf ("   -rate <hz>                Navdata rate (default : 15Hz in demo mode, 200Hz otherwise)\n");
+    printf ("   -navdata_loss <percent>   Navdata packets loss\n");
+    printf ("   -at_loss <percent>        AT datagrams loss\n");
+    printf ("   -outage <period>,<ms>     Drop all links every <period> seconds for <ms> milliseconds\n");
+    printf ("   -video <file>             Replay a recorded PaVE stream (default : synthetic H264 stream)\n");
+    printf ("   -fps <fps>                Video frame rate (default : video:codec_fps)\n");
+    printf ("   -gop <frames>             Synthetic stream GOP size (default %d)\n", 15);
+    printf ("   -config <file>            Initial configuration (config.ini format)\n");
+    printf ("   -ftp_root <dir>           Directory served on the FTP port\n");
+    printf ("   -version <x.y.z>          Firmware version reported by the drones (default %s)\n", SIM_DEFAULT_VERSION);
+    printf ("   -v                        Verbose\n");
+}
+
+static void sim_print_stats (sim_drone_t *drones, int32_t numDrones, uint32_t elapsed)
+{
+    int32_t i;
+    PRINT ("--- %us ---\n", elapsed);
+    for (i = 0; i < numDrones; i++)
+    {
+        sim_stats_t *s = &drones[i].stats;
+        PRINT ("[%s] AT %u pkts %u cmds (%u lost, %u out of seq) | NAV %u (%u lost) | VIDEO %u frames %llu KB (%u dropped) | %u conn %u cfg %u outages\n",
+               drones[i].ip, s->atPackets, s->atCommands, s->atDropped, s->atOutOfSequence,
+               s->navdataSent, s->navdataDropped, s->videoFrames,
+               (unsigned long long)(s->videoBytes / 1024), s->videoDropped,
+               s->connections, s->configDumps, s->outages);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    static sim_options_t options;
+    static sim_config_t config;
+    static sim_video_file_t videoFile;
+    static sim_drone_t drones[SIM_MAX_DRONES];
+    const char *videoFileName = NULL;
+    const char *configFileName = NULL;
+    uint32_t startTime, nextOutage, nextStats;
+    int32_t numStarted = 0;
+    int32_t i;
+    int res = 0;
+
+    vp_os_memset (&options, 0x0, sizeof (options));
+    options.numDrones = 1;
+    options.videoGop = 15;
+    strncpy (options.baseIp, SIM_DEFAULT_IP, SIM_IP_SIZE - 1);
+    strncpy (options.version, SIM_DEFAULT_VERSION, sizeof (options.version) - 1);
+
+    for (i = 1; i < argc; i++)
+    {
+        bool_t hasArg = (i + 1 < argc) ? TRUE : FALSE;
+        if (0 == strcmp (argv[i], "-n") && hasArg)
+        {
+            options.numDrones = atoi (argv[++i]);
+        }
+        else if (0 == strcmp (argv[i], "-ip") && hasArg)
+        {
+            strncpy (options.baseIp, argv[++i], SIM_IP_SIZE - 1);
+        }
+        else if (0 == strcmp (argv[i], "-rate") && hasArg)
+        {
+            options.navdataRate = atoi (argv[++i]);
+        }
+        else if (0 == strcmp (argv[i], "-navdata_loss") && hasArg)
+        {
+            options.navdataLoss = atoi (argv[++i]);
+        }
+        else if (0 == strcmp (argv[i], "-at_loss") && hasArg)
+        {
+            options.atLoss = atoi (argv[++i]);
+        }
+        else if (0 == strcmp (argv[i], "-outage") && hasArg)
+        {
+            if (2 != sscanf (argv[++i], "%d,%d", &options.outagePeriod, &options.outageDuration))
+            {
+                sim_usage (argv[0]);
+                return -1;
+            }
+        }
+        else if (0 == strcmp (argv[i], "-video") && hasArg)
+        {
+            videoFileName = argv[++i];
+        }
+        else if (0 == strcmp (argv[i], "-fps") && hasArg)
+        {
+            options.videoFps = atoi (argv[++i]);
+        }
+        else if (0 == strcmp (argv[i], "-gop") && hasArg)
+        {
+            options.videoGop = atoi (argv[++i]);
+        }
+        else if (0 == strcmp (argv[i], "-config") && hasArg)
+        {
+            configFileName = argv[++i];
+        }
+        else if (0 == strcmp (argv[i], "-ftp_root") && hasArg)
+        {
+            strncpy (options.ftpRoot, argv[++i], SIM_PATH_SIZE - 1);
+        }
+        else if (0 == strcmp (argv[i], "-version") && hasArg)
+        {
+            strncpy (options.version, argv[++i], sizeof (options.version) - 1);
+        }
+        else if (0 == strcmp (argv[i], "-v"))
+        {
+            options.verbose = 1;
+        }
+        else
+        {
+            sim_usage (argv[0]);
+            return (0 == strcmp (argv[i], "-h")) ? 0 : -1;
+        }
+    }
+
+    if (0 >= options.numDrones || SIM_MAX_DRONES < options.numDrones || INADDR_NONE == inet_addr (options.baseIp))
+    {
+        sim_usage (argv[0]);
+        return -1;
+    }
+
+    sim_config_init (&config, options.version);
+    if (NULL != configFileName && VP_FAILED (sim_config_load (&config, configFileName)))
+    {
+        PRINT ("Unable to load configuration %s\n", configFileName);
+        return -1;
+    }
+    options.config = &config;
+
+    if (NULL != videoFileName)
+    {
+        if (VP_FAILED (sim_video_file_load (&videoFile, videoFileName)))
+        {
+            PRINT ("Unable to load video %s\n", videoFileName);
+            return -1;
+        }
+        options.videoFile = &videoFile;
+    }
+
+    signal (SIGINT, sim_sigint_handler);
+    signal (SIGTERM, sim_sigint_handler);
+    signal (SIGPIPE, SIG_IGN);
+
+    for (i = 0; i < options.numDrones; i++)
+    {
+        struct in_addr addr;
+        addr.s_addr = htonl (ntohl (inet_addr (options.baseIp)) + i);
+        drones[i].index = i;
+        drones[i].options = &options;
+        strncpy (drones[i].ip, inet_ntoa (addr), SIM_IP_SIZE - 1);
+        if (VP_FAILED (sim_drone_open (&drones[i])))
+        {
+            PRINT ("Unable to start drone %d on %s\n", i, drones[i].ip);
+            res = -1;
+            break;
+        }
+        sim_drone_start (&drones[i]);
+        numStarted++;
+    }
+
+    startTime = sim_get_time_ms ();
+    nextOutage = startTime + 1000 * options.outagePeriod;
+    nextStats = startTime + 1000 * SIM_STATS_PERIOD;
+    while (! simExit && 0 == res)
+    {
+        uint32_t now = sim_get_time_ms ();
+        // All drones drop at the same time to generate reconnection storms on the client
+        if (0 < options.outagePeriod && 0 <= (int32_t)(now - nextOutage))
+        {
+            for (i = 0; i < numStarted; i++)
+            {
+                sim_drone_outage (&drones[i], options.outageDuration);
+            }
+            nextOutage += 1000 * options.outagePeriod;
+        }
+        if (0 <= (int32_t)(now - nextStats))
+        {
+            sim_print_stats (drones, numStarted, (now - startTime) / 1000);
+            nextStats += 1000 * SIM_STATS_PERIOD;
+        }
+        usleep (100000);
+    }
+
+    for (i = 0; i < numStarted; i++)
+    {
+        sim_drone_stop (&drones[i]);
+    }
+    for (i = 0; i < numStarted; i++)
+    {
+        sim_drone_close (&drones[i]);
+    }
+    if (NULL != options.videoFile)
+    {
+        sim_video_file_release (&videoFile);
+    }
+    return res;
+}
@@ -0,0 +1,643 @@
+/**
+ * @file ftp_bench.c
+ * @date 2026/10/18
+ *
+ * Throughput test of the ardrone_ftp.c download paths against a local
+ * stand-in FTP server.
+ *
+ * The stand-in server runs in this process on 127.0.0.1 : passive mode, one
+ * thread per control connection, so that ftpGetQueue can open several of
+ * them like with the drone. Its files are virtual (file_<n>.bin, all of the
+ * same size), their bytes are computed from the file number and the offset
+ * so that every downloaded file is checked byte by byte.
+ *
+ * Cases :
+ *  - ftp_get            : ftpGet of each file, one control connection
+ *  - ftp_get_reconnect  : ftpConnect, ftpGet and ftpClose for each file
+ *  - ftp_get_queue_<n>  : ftpGetQueue of all the files with n connections
+ *  - ftp_get_resume     : ftpGet with useResume on files cut at half
+ *
+ * For each case : files, bytes received, time and throughput. A file with
+ * a wrong size or content makes the case "corrupt", a transfer error makes it
+ * "failed", and the exit code is not zero.
+ *
+ * Results are written with -o as JSON, one object per line.
+ *
+ * Usage : ./linux_ftp_bench [-n files] [-s kilobytes] [-d directory] [-o results.json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+
+#include <VP_Api/vp_api_thread_helper.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_thread.h>
+
+#include <utils/ardrone_ftp.h>
+
+#include <bench.h>
+
+#define FTP_BENCH_MAX_FILES         64
+#define FTP_BENCH_MAX_SESSIONS      (FTP_BENCH_MAX_FILES + 16)   // a connection per file in ftp_get_reconnect
+#define FTP_BENCH_FILES             8
+#define FTP_BENCH_FILE_KB           16384
+#define FTP_BENCH_LINE_SIZE         512
+#define FTP_BENCH_CHUNK_SIZE        65536
+#define FTP_BENCH_ACCEPT_TIMEOUT    2   // seconds
+#define FTP_BENCH_PATH_SIZE         256
+
+typedef enum _FTP_BENCH_STATUS_ {
+    FTP_BENCH_OK = 0,
+    FTP_BENCH_CORRUPT,          // a file has a wrong size or content
+    FTP_BENCH_FAILED            // transfer error, or case could not run
+} FTP_BENCH_STATUS;
+
+static const char *ftp_bench_status_names[] = { "ok", "corrupt", "failed" };
+
+static int nb_files = FTP_BENCH_FILES;
+static uint32_t file_size = FTP_BENCH_FILE_KB * 1024;
+static const char *directory = "/tmp/ftp_bench";
+
+/********************************************************************
+ * Stand-in server
+ ********************************************************************/
+
+typedef struct _ftp_bench_session_ {
+    int control;
+    int passive;                // listening data socket, -1 without PASV
+    uint32_t restart;
+    THREAD_HANDLE thread;
+} ftp_bench_session_t;
+
+static int server_socket = -1;
+static int server_port = 0;
+static volatile int server_stop = 0;
+static THREAD_HANDLE server_thread;
+static ftp_bench_session_t sessions[FTP_BENCH_MAX_SESSIONS];
+static int nb_sessions = 0;
+
+// Byte k of the pattern is k : file n at offset o starts at pattern[(n + o) & 0xFF]
+static uint8_t pattern[FTP_BENCH_CHUNK_SIZE + 256];
+
+PROTO_THREAD_ROUTINE (ftp_bench_server, data);
+PROTO_THREAD_ROUTINE (ftp_bench_session, data);
+
+static void ftp_bench_reply (ftp_bench_session_t *session, const char *reply)
+{
+    send (session->control, reply, strlen (reply), MSG_NOSIGNAL);
+}
+
+/* Number of file_<n>.bin, -1 for other names */
+static int ftp_bench_file_index (const char *name)
+{
+    int index;
+    char end;
+
+    while ('/' == *name)
+        name++;
+    if (2 != sscanf (name, "file_%d.bi%c", &index, &end) || 'n' != end || index < 0 || index >= nb_files)
+        return -1;
+    return index;
+}
+
+static void ftp_bench_passive (ftp_bench_session_t *session)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof (addr);
+    char reply[FTP_BENCH_LINE_SIZE];
+
+    if (0 <= session->passive)
+        close (session->passive);
+
+    session->passive = socket (AF_INET, SOCK_STREAM, 0);
+    vp_os_memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    if (0 > session->passive ||
+        0 > bind (session->passive, (struct sockaddr *)&addr, sizeof (addr)) ||
+        0 > listen (session->passive, 1) ||
+        0 > getsockname (session->passive, (struct sockaddr *)&addr, &len))
+    {
+        if (0 <= session->passive)
+            close (session->passive);
+        session->passive = -1;
+        ftp_bench_reply (session, "425 Can't open passive connection.\r\n");
+        return;
+    }
+
+    snprintf (reply, sizeof (reply), "227 Entering Passive Mode (127,0,0,1,%u,%u).\r\n",
+              ntohs (addr.sin_port) >> 8, ntohs (addr.sin_port) & 0xFF);
+    ftp_bench_reply (session, reply);
+}
+
+static void ftp_bench_retrieve (ftp_bench_session_t *session, const char *name)
+{
+    struct timeval tv = { FTP_BENCH_ACCEPT_TIMEOUT, 0 };
+    int index = ftp_bench_file_index (name);
+    uint32_t offset = session->restart;
+    int data = -1;
+    ssize_t sent;
+    fd_set fds;
+    uint32_t bytes;
+
+    session->restart = 0;
+    if (0 > index || 0 > session->passive)
+    {
+        ftp_bench_reply (session, (0 > index) ? "550 Failed to open file.\r\n" : "425 Use PASV first.\r\n");
+        return;
+    }
+    ftp_bench_reply (session, "150 Opening BINARY mode data connection.\r\n");
+
+    // The client connects before sending RETR
+    FD_ZERO (&fds);
+    FD_SET (session->passive, &fds);
+    if (0 < select (session->passive + 1, &fds, NULL, NULL, &tv))
+        data = accept (session->passive, NULL, NULL);
+    close (session->passive);
+    session->passive = -1;
+    if (0 > data)
+    {
+        ftp_bench_reply (session, "425 Failed to establish connection.\r\n");
+        return;
+    }
+
+    while (offset < file_size)
+    {
+        bytes = file_size - offset;
+        if (FTP_BENCH_CHUNK_SIZE < bytes)
+            bytes = FTP_BENCH_CHUNK_SIZE;
+        sent = send (data, &pattern[(index + offset) & 0xFF], bytes, MSG_NOSIGNAL);
+        if (0 >= sent)
+            break;
+        offset += sent;
+    }
+    close (data);
+
+    ftp_bench_reply (session, (offset == file_size) ? "226 Transfer complete.\r\n" : "426 Connection closed; transfer aborted.\r\n");
+}
+
+/* Returns C_FAIL when the session is over */
+static C_RESULT ftp_bench_command (ftp_bench_session_t *session)
+{
+    char line[FTP_BENCH_LINE_SIZE];
+    char reply[FTP_BENCH_LINE_SIZE];
+    char *arg;
+    int index = 0;
+
+    // Commands are short : read them byte by byte up to the end of line
+    while (index < FTP_BENCH_LINE_SIZE - 1)
+    {
+        if (0 >= recv (session->control, &line[index], 1, 0))
+            return C_FAIL;
+        if ('\n' == line[index])
+            break;
+        index++;
+    }
+    line[index] = '\0';
+    if (0 < index && '\r' == line[index - 1])
+        line[index - 1] = '\0';
+
+    arg = strchr (line, ' ');
+    if (NULL != arg)
+        *arg++ = '\0';
+    else
+        arg = &line[index];
+
+    if (0 == strcasecmp (line, "USER"))
+    {
+        ftp_bench_reply (session, (0 == strcmp (arg, "anonymous")) ? "230 Login successful.\r\n" : "331 Please specify the password.\r\n");
+    }
+    else if (0 == strcasecmp (line, "PASS"))
+    {
+        ftp_bench_reply (session, "230 Login successful.\r\n");
+    }
+    else if (0 == strcasecmp (line, "TYPE"))
+    {
+        ftp_bench_reply (session, "200 Switching to Binary mode.\r\n");
+    }
+    else if (0 == strcasecmp (line, "PASV"))
+    {
+        ftp_bench_passive (session);
+    }
+    else if (0 == strcasecmp (line, "SIZE"))
+    {
+        if (0 > ftp_bench_file_index (arg))
+        {
+            ftp_bench_reply (session, "550 Could not get file size.\r\n");
+        }
+        else
+        {
+            snprintf (reply, sizeof (reply), "213 %u\r\n", file_size);
+            ftp_bench_reply (session, reply);
+        }
+    }
+    else if (0 == strcasecmp (line, "REST"))
+    {
+        session->restart = (uint32_t)strtoul (arg, NULL, 10);
+        snprintf (reply, sizeof (reply), "350 Restart position accepted (%u).\r\n", session->restart);
+        ftp_bench_reply (session, reply);
+    }
+    else if (0 == strcasecmp (line, "RETR"))
+    {
+        ftp_bench_retrieve (session, arg);
+    }
+    else if (0 == strcasecmp (line, "PWD"))
+    {
+        ftp_bench_reply (session, "257 \"/\"\r\n");
+    }
+    else if (0 == strcasecmp (line, "CWD"))
+    {
+        ftp_bench_reply (session, "250 Directory successfully changed.\r\n");
+    }
+    else if (0 == strcasecmp (line, "NOOP"))
+    {
+        ftp_bench_reply (session, "200 NOOP ok.\r\n");
+    }
+    else if (0 == strcasecmp (line, "ABOR"))
+    {
+        ftp_bench_reply (session, "226 No transfer to ABOR.\r\n");
+    }
+    else if (0 == strcasecmp (line, "QUIT"))
+    {
+        ftp_bench_reply (session, "221 Goodbye.\r\n");
+        return C_FAIL;
+    }
+    else
+    {
+        ftp_bench_reply (session, "502 Command not implemented.\r\n");
+    }
+    return C_OK;
+}
+
+DEFINE_THREAD_ROUTINE (ftp_bench_session, data)
+{
+    ftp_bench_session_t *session = (ftp_bench_session_t *)data;
+    int one = 1;
+
+    // 150 and 226 go one after the other : no Nagle wait for the ACK of the first one
+    setsockopt (session->control, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+    ftp_bench_reply (session, "220 ftp_bench stand-in server.\r\n");
+    while (C_OK == ftp_bench_command (session))
+        ;
+
+    if (0 <= session->passive)
+        close (session->passive);
+    close (session->control);
+
+    THREAD_RETURN (0);
+}
+
+DEFINE_THREAD_ROUTINE (ftp_bench_server, data)
+{
+    ftp_bench_session_t *session;
+    int client;
+
+    while (!server_stop)
+    {
+        client = accept (server_socket, NULL, NULL);
+        if (0 > client)
+        {
+            if (EINTR == errno)
+                continue;
+            break;
+        }
+
+        if (FTP_BENCH_MAX_SESSIONS <= nb_sessions)
+        {
+            close (client);
+            continue;
+        }
+
+        session = &sessions[nb_sessions++];
+        session->control = client;
+        session->passive = -1;
+        session->restart = 0;
+        vp_os_thread_create (thread_ftp_bench_session, (THREAD_PARAMS)session, &session->thread);
+    }
+
+    THREAD_RETURN (0);
+}
+
+static C_RESULT ftp_bench_server_start (void)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof (addr);
+    int i;
+
+    for (i = 0; i < (int)sizeof (pattern); i++)
+        pattern[i] = (uint8_t)i;
+
+    server_socket = socket (AF_INET, SOCK_STREAM, 0);
+    vp_os_memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    if (0 > server_socket ||
+        0 > bind (server_socket, (struct sockaddr *)&addr, sizeof (addr)) ||
+        0 > listen (server_socket, FTP_BENCH_MAX_SESSIONS) ||
+        0 > getsockname (server_socket, (struct sockaddr *)&addr, &len))
+    {
+        printf ("Unable to start the stand-in server (%s)\n", strerror (errno));
+        return C_FAIL;
+    }
+    server_port = ntohs (addr.sin_port);
+
+    vp_os_thread_create (thread_ftp_bench_server, NULL, &server_thread);
+    return C_OK;
+}
+
+/* Clients have sent QUIT : sessions are over */
+static void ftp_bench_server_stop (void)
+{
+    int i;
+
+    server_stop = 1;
+    shutdown (server_socket, SHUT_RDWR);
+    vp_os_thread_join (server_thread);
+    close (server_socket);
+
+    for (i = 0; i < nb_sessions; i++)
+        vp_os_thread_join (sessions[i].thread);
+}
+
+/********************************************************************
+ * Cases
+ ********************************************************************/
+
+static void ftp_bench_report (const char *name, uint32_t files, uint64_t bytes, uint64_t ns, FTP_BENCH_STATUS status)
+{
+    bench_result_t *result = bench_report (name, status);
+    double seconds = ns / 1e9;
+    double mbps = (0 < ns) ? bytes / 1048576.0 / seconds : 0.0;    // MB/s
+
+    printf ("%-24s %4u files %11llu bytes %8.3f s %9.1f MB/s  %s\n", name, files,
+            (unsigned long long)bytes, seconds, mbps, ftp_bench_status_names[status]);
+
+    bench_set (result, "files", "%u", files);
+    bench_set (result, "bytes", "%llu", (unsigned long long)bytes);    // received by the client
+    bench_set (result, "seconds", "%.4f", seconds);
+    bench_set (result, "mbps", "%.2f", mbps);
+}
+
+static void ftp_bench_local_name (char *path, int index)
+{
+    snprintf (path, FTP_BENCH_PATH_SIZE, "%s/file_%d.bin", directory, index);
+}
+
+static void ftp_bench_remote_name (char *name, int index)
+{
+    snprintf (name, FTP_BENCH_PATH_SIZE, "file_%d.bin", index);
+}
+
+/* Checks the size and the bytes of a downloaded file */
+static FTP_BENCH_STATUS ftp_bench_check (int index)
+{
+    char path[FTP_BENCH_PATH_SIZE];
+    uint8_t *buffer;
+    uint32_t offset = 0;
+    ssize_t bytes;
+    int fd;
+    FTP_BENCH_STATUS status = FTP_BENCH_OK;
+
+    ftp_bench_local_name (path, index);
+    fd = open (path, O_RDONLY);
+    buffer = (uint8_t *)vp_os_malloc (FTP_BENCH_CHUNK_SIZE);
+    if (0 > fd || NULL == buffer)
+    {
+        if (0 <= fd)
+            close (fd);
+        vp_os_free (buffer);
+        return FTP_BENCH_CORRUPT;
+    }
+
+    while (FTP_BENCH_OK == status && 0 < (bytes = read (fd, buffer, FTP_BENCH_CHUNK_SIZE)))
+    {
+        if (offset + bytes > file_size || 0 != memcmp (buffer, &pattern[(index + offset) & 0xFF], bytes))
+            status = FTP_BENCH_CORRUPT;
+        offset += bytes;
+    }
+    if (offset != file_size)
+        status = FTP_BENCH_CORRUPT;
+
+    close (fd);
+    vp_os_free (buffer);
+    return status;
+}
+
+static FTP_BENCH_STATUS ftp_bench_check_all (FTP_BENCH_STATUS status)
+{
+    int i;
+
+    for (i = 0; i < nb_files && FTP_BENCH_OK == status; i++)
+        status = ftp_bench_check (i);
+    return status;
+}
+
+static void ftp_bench_clean (void)
+{
+    char path[FTP_BENCH_PATH_SIZE];
+    int i;
+
+    for (i = 0; i < nb_files; i++)
+    {
+        ftp_bench_local_name (path, i);
+        unlink (path);
+    }
+}
+
+static _ftp_t *ftp_bench_connect (void)
+{
+    _ftp_status status;
+    _ftp_t *ftp = ftpConnect ("127.0.0.1", server_port, "anonymous", "", &status);
+
+    if (NULL == ftp || FTP_FAILED (status))
+    {
+        printf ("Unable to connect to the stand-in server\n");
+        return NULL;
+    }
+    return ftp;
+}
+
+/* ftpGet of each file, on one connection, or on a new connection per file */
+static void ftp_bench_get (const char *name, bool_t reconnect)
+{
+    char local[FTP_BENCH_PATH_SIZE], remote[FTP_BENCH_PATH_SIZE];
+    FTP_BENCH_STATUS status = FTP_BENCH_OK;
+    _ftp_t *ftp = NULL;
+    uint64_t start;
+    int i;
+
+    ftp_bench_clean ();
+    start = bench_now ();
+    for (i = 0; i < nb_files && FTP_BENCH_OK == status; i++)
+    {
+        if (NULL == ftp)
+            ftp = ftp_bench_connect ();
+        if (NULL == ftp)
+        {
+            status = FTP_BENCH_FAILED;
+            break;
+        }
+
+        ftp_bench_local_name (local, i);
+        ftp_bench_remote_name (remote, i);
+        if (FTP_SUCCESS != ftpGet (ftp, remote, local, 0, NULL))
+            status = FTP_BENCH_FAILED;
+
+        if (reconnect)
+            ftpClose (&ftp);
+    }
+    if (NULL != ftp)
+        ftpClose (&ftp);
+
+    start = bench_now () - start;
+    ftp_bench_report (name, nb_files, (uint64_t)nb_files * file_size, start, ftp_bench_check_all (status));
+}
+
+static void ftp_bench_get_queue (int connections)
+{
+    _ftp_get_item items[FTP_BENCH_MAX_FILES];
+    char local[FTP_BENCH_MAX_FILES][FTP_BENCH_PATH_SIZE];
+    char remote[FTP_BENCH_MAX_FILES][FTP_BENCH_PATH_SIZE];
+    FTP_BENCH_STATUS status = FTP_BENCH_OK;
+    char name[64];
+    uint64_t start;
+    _ftp_t *ftp;
+    int i;
+
+    snprintf (name, sizeof (name), "ftp_get_queue_%d", connections);
+    ftp_bench_clean ();
+
+    vp_os_memset (items, 0, sizeof (items));
+    for (i = 0; i < nb_files; i++)
+    {
+        ftp_bench_local_name (local[i], i);
+        ftp_bench_remote_name (remote[i], i);
+        items[i].localName = local[i];
+        items[i].remoteName = remote[i];
+    }
+
+    ftp = ftp_bench_connect ();
+    if (NULL == ftp)
+    {
+        ftp_bench_report (name, 0, 0, 0, FTP_BENCH_FAILED);
+        return;
+    }
+
+    start = bench_now ();
+    if (FTP_SUCCESS != ftpGetQueue (ftp, items, nb_files, connections, 0, NULL))
+        status = FTP_BENCH_FAILED;
+    start = bench_now () - start;
+    ftpClose (&ftp);
+
+    ftp_bench_report (name, nb_files, (uint64_t)nb_files * file_size, start, ftp_bench_check_all (status));
+}
+
+/* Files downloaded then cut at half : only the second half is received again */
+static void ftp_bench_get_resume (void)
+{
+    char local[FTP_BENCH_PATH_SIZE], remote[FTP_BENCH_PATH_SIZE];
+    FTP_BENCH_STATUS status = FTP_BENCH_OK;
+    uint64_t start, bytes = 0;
+    _ftp_t *ftp;
+    int i;
+
+    ftp = ftp_bench_connect ();
+    if (NULL == ftp)
+    {
+        ftp_bench_report ("ftp_get_resume", 0, 0, 0, FTP_BENCH_FAILED);
+        return;
+    }
+
+    ftp_bench_clean ();
+    for (i = 0; i < nb_files && FTP_BENCH_OK == status; i++)
+    {
+        ftp_bench_local_name (local, i);
+        ftp_bench_remote_name (remote, i);
+        if (FTP_SUCCESS != ftpGet (ftp, remote, local, 0, NULL) || 0 != truncate (local, file_size / 2))
+            status = FTP_BENCH_FAILED;
+    }
+
+    start = bench_now ();
+    for (i = 0; i < nb_files && FTP_BENCH_OK == status; i++)
+    {
+        ftp_bench_local_name (local, i);
+        ftp_bench_remote_name (remote, i);
+        if (FTP_SUCCESS != ftpGet (ftp, remote, local, 1, NULL))
+            status = FTP_BENCH_FAILED;
+        bytes += file_size - file_size / 2;
+    }
+    start = bench_now () - start;
+    ftpClose (&ftp);
+
+    ftp_bench_report ("ftp_get_resume", nb_files, bytes, start, ftp_bench_check_all (status));
+}
+
+int main (int argc, char *argv[])
+{
+    const char *output = NULL;
+    int option;
+
+    while (-1 != (option = getopt (argc, argv, "n:s:d:o:")))
+    {
+        switch (option)
+        {
+        case 'n':
+            nb_files = atoi (optarg);
+            break;
+        case 's':
+            file_size = (uint32_t)atoi (optarg) * 1024;
+            break;
+        case 'd':
+            directory = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            printf ("Usage : %s [-n files] [-s kilobytes] [-d directory] [-o results.json]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (nb_files < 1 || nb_files > FTP_BENCH_MAX_FILES || file_size < 2)
+    {
+        printf ("1 to %d files of at least 1 kB\n", FTP_BENCH_MAX_FILES);
+        return -1;
+    }
+
+    if (0 != mkdir (directory, 0755) && EEXIST != errno)
+    {
+        printf ("Unable to create %s\n", directory);
+        return -1;
+    }
+
+    bench_init (ftp_bench_status_names, sizeof (ftp_bench_status_names) / sizeof (ftp_bench_status_names[0]));
+    if (C_OK != ftp_bench_server_start ())
+        return 1;
+
+    ftp_bench_get ("ftp_get", FALSE);
+    ftp_bench_get ("ftp_get_reconnect", TRUE);
+    ftp_bench_get_queue (1);
+    ftp_bench_get_queue (FTP_QUEUE_MAX_CONNECTIONS);
+    ftp_bench_get_resume ();
+
+    ftp_bench_server_stop ();
+    ftp_bench_clean ();
+
+    if (NULL != output)
+        bench_write (output, "\"ftp_bench\":1,\"files\":%d,\"file_size\":%u", nb_files, file_size);
+
+    return (bench_nb_results () == bench_count (FTP_BENCH_OK)) ? 0 : 1;
+}
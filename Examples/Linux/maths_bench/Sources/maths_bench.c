@@ -0,0 +1,629 @@
+/**
+ * @file maths_bench.c
+ * @date 2026/10/18
+ *
+ * Accuracy and speed of the batch maths functions (matrices_batch.c and
+ * filter_batch.c) against the functions of matrices.c and filter.c, at each
+ * instruction set level (maths_simd_level_set) : c, sse, avx.
+ *
+ * Accuracy cases, on random matrices and signals :
+ *  - mul, mul_transpose, add and sub of 6x6, 4x4, 4x6 and 6x4 matrices, and
+ *    filter_batch of order 1, 2 and 4 over ACCURACY_SAMPLES samples, have to
+ *    give the same bits as the scalar functions
+ *  - inv of symmetric positive definite 4x4 matrices has to be within
+ *    INV_TOLERANCE of inv_mat44, and a singular instance has to give the null matrix
+ *
+ * Speed cases :
+ *  - ekf_<level> : predict and update step of a 6 state, 4 measurement
+ *    Kalman filter for each drone, ekf_matrices being the matrices.c version.
+ *    The covariance after the last step has to be within EKF_TOLERANCE of the
+ *    matrices.c one.
+ *  - filter_<level> : a second order filter of each drone, filter_scalar being filter().
+ * The time of a step is compared with the navdata period, at NAVDATA_RATE_HZ.
+ *
+ * A level not supported by the CPU is "skipped". A case outside of its
+ * tolerance is reported as "mismatch", and the exit code is not zero.
+ *
+ * Results are written with -o as JSON, one object per line.
+ *
+ * Usage : ./linux_maths_bench [-n instances] [-d drones] [-i steps] [-o results.json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <VP_Os/vp_os_malloc.h>
+
+#include <Maths/matrices.h>
+#include <Maths/matrices_batch.h>
+#include <Maths/filter.h>
+#include <Maths/filter_batch.h>
+
+#include <bench.h>
+
+#define MATHS_BENCH_INSTANCES       13      // not a multiple of MATRIX_BATCH_LANES, to check the last lanes
+#define MATHS_BENCH_DRONES          16
+#define MATHS_BENCH_STEPS           20000
+#define MATHS_BENCH_MAX_INSTANCES   256
+#define ACCURACY_SAMPLES            10000
+#define INV_TOLERANCE               1e-4    // relative
+#define EKF_TOLERANCE               1e-3    // relative
+#define NAVDATA_RATE_HZ             200
+
+typedef enum _MATHS_BENCH_STATUS_ {
+    MATHS_BENCH_OK = 0,
+    MATHS_BENCH_MISMATCH,       // out of tolerance
+    MATHS_BENCH_SKIPPED         // level not supported by the CPU
+} MATHS_BENCH_STATUS;
+
+static const char *maths_bench_status_names[] = { "ok", "mismatch", "skipped" };
+static const char *maths_bench_level_names[] = { "c", "sse", "avx" };
+
+static uint32_t nb_instances = MATHS_BENCH_INSTANCES;
+static uint32_t nb_drones = MATHS_BENCH_DRONES;
+static uint32_t nb_steps = MATHS_BENCH_STEPS;
+
+static float32_t maths_bench_random (void)
+{
+    return (float32_t)rand () / RAND_MAX * 2.0f - 1.0f;
+}
+
+/**
+ * @param variant      Level name, or the scalar functions used
+ * @param differences  Elements which are not the same bits as the scalar function
+ * @param max_error    Relative
+ * @param us           Per step, speed cases only : 0.0 for the accuracy cases, which have no time
+ */
+static void maths_bench_report (const char *name, const char *variant, uint32_t instances, uint32_t differences,
+                                double max_error, double us, MATHS_BENCH_STATUS status)
+{
+    bench_result_t *result;
+    char full_name[BENCH_NAME_SIZE];
+
+    snprintf (full_name, sizeof (full_name), "%s_%s", name, variant);
+    result = bench_report (full_name, status);
+    bench_set (result, "instances", "%u", instances);
+    bench_set (result, "differences", "%u", differences);
+    bench_set (result, "max_error", "%g", max_error);
+
+    if (0.0 < us)
+    {
+        bench_set (result, "us", "%.3f", us);
+        printf ("%-28s %4u drones %10.2f us per step %6.2f %% of navdata period  max error %.2e  %s\n", full_name, instances,
+                us, us * NAVDATA_RATE_HZ / 1e4, max_error, maths_bench_status_names[status]);
+    }
+    else
+    {
+        printf ("%-28s %4u instances %6u differences  max error %.2e  %s\n", full_name, instances, differences,
+                max_error, maths_bench_status_names[status]);
+    }
+}
+
+/**
+ * Compares count values with the scalar results
+ * @return Number of values which are not the same bits, max_error being their largest relative error
+ */
+static uint32_t maths_bench_compare (const float32_t *values, const float32_t *reference, uint32_t count, double *max_error)
+{
+    uint32_t i, differences = 0;
+    double error;
+
+    for (i = 0; i < count; i++)
+    {
+        if (0 != memcmp (&values[i], &reference[i], sizeof (float32_t)))
+        {
+            differences++;
+            error = fabs ((double)values[i] - reference[i]) / (fabs (reference[i]) + 1e-6);
+            if (error > *max_error || isnan (error))
+            {
+                *max_error = isnan (error) ? INFINITY : error;
+            }
+        }
+    }
+
+    return differences;
+}
+
+/********************************************************************
+ * Accuracy
+ ********************************************************************/
+
+typedef enum _MATHS_BENCH_OP_ {
+    MATHS_BENCH_MUL = 0,
+    MATHS_BENCH_MUL_TRANSPOSE,
+    MATHS_BENCH_ADD,
+    MATHS_BENCH_SUB
+} MATHS_BENCH_OP;
+
+typedef struct _maths_bench_matrix_case_ {
+    const char     *name;
+    MATHS_BENCH_OP  op;
+    uint32_t        rows1, cols1, rows2, cols2;     // of m1 and m2, as given to the batch function
+} maths_bench_matrix_case_t;
+
+static const maths_bench_matrix_case_t matrix_cases[] =
+{
+    { "mul_mat66",           MATHS_BENCH_MUL,           6, 6, 6, 6 },
+    { "mul_mat44",           MATHS_BENCH_MUL,           4, 4, 4, 4 },
+    { "mulmat46mat66",       MATHS_BENCH_MUL,           4, 6, 6, 6 },
+    { "mulmat66mat64",       MATHS_BENCH_MUL,           6, 6, 6, 4 },
+    { "mulmat64mat44",       MATHS_BENCH_MUL,           6, 4, 4, 4 },
+    { "mul_transpose_mat66", MATHS_BENCH_MUL_TRANSPOSE, 6, 6, 6, 6 },
+    { "mul_transpose_mat46", MATHS_BENCH_MUL_TRANSPOSE, 4, 6, 4, 6 },
+    { "add_mat66",           MATHS_BENCH_ADD,           6, 6, 6, 6 },
+    { "sub_mat66",           MATHS_BENCH_SUB,           6, 6, 6, 6 },
+};
+
+/**
+ * The matrices.c function of a case, on row major matrices
+ */
+static void maths_bench_matrix_scalar (const maths_bench_matrix_case_t *c, float32_t *out, float32_t *m1, float32_t *m2)
+{
+    matrix66_t t66, n66;
+    matrix64_t t64;
+
+    switch (c->op)
+    {
+    case MATHS_BENCH_MUL:
+        if (6 == c->rows1 && 6 == c->cols1 && 6 == c->cols2)
+            mul_mat66 ((matrix66_t *)out, (matrix66_t *)m1, (matrix66_t *)m2);
+        else if (4 == c->rows1 && 4 == c->cols1)
+            mul_mat44 ((matrix44_t *)out, (matrix44_t *)m1, (matrix44_t *)m2);
+        else if (4 == c->rows1)
+            mulmat46mat66 ((matrix46_t *)out, (matrix46_t *)m1, (matrix66_t *)m2);
+        else if (6 == c->cols1)
+            mulmat66mat64 ((matrix64_t *)out, (matrix66_t *)m1, (matrix64_t *)m2);
+        else
+            mulmat64mat44 ((matrix64_t *)out, (matrix64_t *)m1, (matrix44_t *)m2);
+        break;
+    case MATHS_BENCH_MUL_TRANSPOSE:
+        if (6 == c->rows1)
+        {
+            transpose_mat66 (&t66, (matrix66_t *)m2);
+            mul_mat66 ((matrix66_t *)out, (matrix66_t *)m1, &t66);
+        }
+        else
+        {
+            transpose_mat46 (&t64, (matrix46_t *)m2);
+            mulmat46mat64 ((matrix44_t *)out, (matrix46_t *)m1, &t64);
+        }
+        break;
+    case MATHS_BENCH_ADD:
+        add_mat66 ((matrix66_t *)out, (matrix66_t *)m1, (matrix66_t *)m2);
+        break;
+    case MATHS_BENCH_SUB:
+        // a + (-b) is a - b
+        mulconst_mat66 (&n66, (matrix66_t *)m2, -1.0f);
+        add_mat66 ((matrix66_t *)out, (matrix66_t *)m1, &n66);
+        break;
+    }
+}
+
+static void maths_bench_matrix (const maths_bench_matrix_case_t *c, MATHS_SIMD_LEVEL level)
+{
+    matrix_batch_t m1, m2, out;
+    float32_t a[36], b[36], r[36], o[36];
+    uint32_t rows = c->rows1;
+    uint32_t cols = (MATHS_BENCH_MUL == c->op) ? c->cols2 : (MATHS_BENCH_MUL_TRANSPOSE == c->op) ? c->rows2 : c->cols1;
+    uint32_t k, i, differences = 0;
+    double max_error = 0.0;
+
+    matrix_batch_alloc (&m1, c->rows1, c->cols1, nb_instances);
+    matrix_batch_alloc (&m2, c->rows2, c->cols2, nb_instances);
+    matrix_batch_alloc (&out, rows, cols, nb_instances);
+
+    srand (1);
+    for (k = 0; k < nb_instances; k++)
+    {
+        for (i = 0; i < c->rows1 * c->cols1; i++)
+            a[i] = maths_bench_random ();
+        for (i = 0; i < c->rows2 * c->cols2; i++)
+            b[i] = maths_bench_random ();
+        matrix_batch_set (&m1, k, a);
+        matrix_batch_set (&m2, k, b);
+    }
+
+    switch (c->op)
+    {
+    case MATHS_BENCH_MUL:
+        matrix_batch_mul (&out, &m1, &m2);
+        break;
+    case MATHS_BENCH_MUL_TRANSPOSE:
+        matrix_batch_mul_transpose (&out, &m1, &m2);
+        break;
+    case MATHS_BENCH_ADD:
+        matrix_batch_add (&out, &m1, &m2);
+        break;
+    case MATHS_BENCH_SUB:
+        matrix_batch_sub (&out, &m1, &m2);
+        break;
+    }
+
+    for (k = 0; k < nb_instances; k++)
+    {
+        matrix_batch_get (&m1, k, a);
+        matrix_batch_get (&m2, k, b);
+        matrix_batch_get (&out, k, o);
+        maths_bench_matrix_scalar (c, r, a, b);
+        differences += maths_bench_compare (o, r, rows * cols, &max_error);
+    }
+
+    matrix_batch_free (&m1);
+    matrix_batch_free (&m2);
+    matrix_batch_free (&out);
+
+    maths_bench_report (c->name, maths_bench_level_names[level], nb_instances, differences, max_error, 0.0,
+                        (0 == differences) ? MATHS_BENCH_OK : MATHS_BENCH_MISMATCH);
+}
+
+/**
+ * Symmetric positive definite 4x4 matrices (m * transpose(m) + identity), the middle instance being singular
+ */
+static void maths_bench_inv (MATHS_SIMD_LEVEL level)
+{
+    matrix_batch_t s, si;
+    matrix44_t m, mt, spd, r, o;
+    uint32_t k, i, differences = 0, singular = nb_instances / 2;
+    double max_error = 0.0;
+    bool_t null_matrix = TRUE;
+
+    matrix_batch_alloc (&s, 4, 4, nb_instances);
+    matrix_batch_alloc (&si, 4, 4, nb_instances);
+
+    srand (2);
+    for (k = 0; k < nb_instances; k++)
+    {
+        for (i = 0; i < 16; i++)
+            ((float32_t *)&m)[i] = maths_bench_random ();
+        transpose_mat44 (&mt, &m);
+        mul_mat44 (&spd, &m, &mt);
+        add_mat44 (&spd, &spd, (matrix44_t *)&matrix_id4);
+        if (k == singular)
+            vp_os_memset (&spd, 0, sizeof (spd));
+        matrix_batch_set (&s, k, (float32_t *)&spd);
+    }
+
+    matrix_batch_inv (&si, &s);
+
+    for (k = 0; k < nb_instances; k++)
+    {
+        matrix_batch_get (&s, k, (float32_t *)&m);
+        matrix_batch_get (&si, k, (float32_t *)&o);
+        if (k == singular)
+        {
+            for (i = 0; i < 16; i++)
+                null_matrix &= (0.0f == ((float32_t *)&o)[i]);
+            continue;
+        }
+        inv_mat44 (&r, &m);
+        differences += maths_bench_compare ((float32_t *)&o, (float32_t *)&r, 16, &max_error);
+    }
+
+    matrix_batch_free (&s);
+    matrix_batch_free (&si);
+
+    if (!null_matrix)
+        printf ("inv_mat44_%s : the singular instance is not the null matrix\n", maths_bench_level_names[level]);
+
+    maths_bench_report ("inv_mat44", maths_bench_level_names[level], nb_instances, differences, max_error, 0.0,
+                        (null_matrix && INV_TOLERANCE >= max_error) ? MATHS_BENCH_OK : MATHS_BENCH_MISMATCH);
+}
+
+static void maths_bench_filter (uint32_t order, MATHS_SIMD_LEVEL level)
+{
+    // Butterworth low pass filters
+    static const float32_t b1[2] = { 0.1367f, 0.1367f };
+    static const float32_t a1[2] = { 1.0f, -0.7265f };
+    static const float32_t b2[3] = { 0.0675f, 0.135f, 0.0675f };
+    static const float32_t a2[3] = { 1.0f, -1.143f, 0.4128f };
+    static const float32_t b4[5] = { 0.00482f, 0.01929f, 0.02894f, 0.01929f, 0.00482f };
+    static const float32_t a4[5] = { 1.0f, -2.3695f, 2.314f, -1.0547f, 0.1874f };
+    const float32_t *b = (1 == order) ? b1 : (2 == order) ? b2 : b4;
+    const float32_t *a = (1 == order) ? a1 : (2 == order) ? a2 : a4;
+    float32_t old_inputs[MATHS_BENCH_MAX_INSTANCES][NB_FOURTH_ORDER];
+    float32_t old_outputs[MATHS_BENCH_MAX_INSTANCES][NB_FOURTH_ORDER];
+    float32_t initial[MATHS_BENCH_MAX_INSTANCES], input[MATHS_BENCH_MAX_INSTANCES];
+    float32_t output[MATHS_BENCH_MAX_INSTANCES], reference[MATHS_BENCH_MAX_INSTANCES];
+    filter_batch_t f;
+    uint32_t k, n, differences = 0;
+    double max_error = 0.0;
+    char name[32];
+
+    srand (3);
+    for (k = 0; k < nb_instances; k++)
+    {
+        initial[k] = maths_bench_random ();
+        filter_init (order, old_inputs[k], initial[k], old_outputs[k], 0.0f);
+    }
+    filter_batch_init (&f, order, nb_instances, initial, NULL);
+
+    for (n = 0; n < ACCURACY_SAMPLES; n++)
+    {
+        for (k = 0; k < nb_instances; k++)
+        {
+            input[k] = maths_bench_random ();
+            reference[k] = filter (order, b, a, input[k], old_inputs[k], old_outputs[k]);
+        }
+        filter_batch (&f, b, a, input, output);
+        differences += maths_bench_compare (output, reference, nb_instances, &max_error);
+    }
+
+    filter_batch_free (&f);
+
+    snprintf (name, sizeof (name), "filter_order%u", order);
+    maths_bench_report (name, maths_bench_level_names[level], nb_instances, differences, max_error, 0.0,
+                        (0 == differences) ? MATHS_BENCH_OK : MATHS_BENCH_MISMATCH);
+}
+
+/********************************************************************
+ * Speed
+ ********************************************************************/
+
+typedef struct _maths_bench_ekf_ {
+    matrix66_t P, F, Q;
+    matrix46_t H;
+    matrix44_t R;
+} maths_bench_ekf_t;
+
+typedef struct _maths_bench_ekf_batch_ {
+    matrix_batch_t P, F, Q, H, R;
+    matrix_batch_t FP, HP, S, PHt, K, KHP;
+} maths_bench_ekf_batch_t;
+
+/**
+ * Constant velocity model of the position : 3 positions and 3 speeds,
+ * at the navdata period. 4 measurements (positions and altitude again),
+ * with a noise different for each drone.
+ */
+static void maths_bench_ekf_init (maths_bench_ekf_t *ekf, uint32_t drone)
+{
+    ekf->P = matrix_id6;
+    mulconst_mat66 (&ekf->Q, (matrix66_t *)&matrix_id6, 0.01f);
+    ekf->F = matrix_id6;
+    ekf->F.m14 = ekf->F.m25 = ekf->F.m36 = 1.0f / NAVDATA_RATE_HZ;
+    vp_os_memset (&ekf->H, 0, sizeof (ekf->H));
+    ekf->H.m11 = ekf->H.m22 = ekf->H.m33 = ekf->H.m43 = 1.0f;
+    mulconst_mat44 (&ekf->R, (matrix44_t *)&matrix_id4, 0.1f + 0.01f * drone);
+}
+
+// P = F P Ft + Q, S = H P Ht + R, K = P Ht inv(S), P = P - K H P
+static void maths_bench_ekf_step (maths_bench_ekf_t *ekf)
+{
+    matrix66_t FP, Ft, FPFt, KHP, minus_KHP;
+    matrix64_t Ht, PHt, K;
+    matrix46_t HP;
+    matrix44_t HPHt, S, Si;
+
+    mul_mat66 (&FP, &ekf->F, &ekf->P);
+    transpose_mat66 (&Ft, &ekf->F);
+    mul_mat66 (&FPFt, &FP, &Ft);
+    add_mat66 (&ekf->P, &FPFt, &ekf->Q);
+
+    mulmat46mat66 (&HP, &ekf->H, &ekf->P);
+    transpose_mat46 (&Ht, &ekf->H);
+    mulmat46mat64 (&HPHt, &HP, &Ht);
+    add_mat44 (&S, &HPHt, &ekf->R);
+    inv_mat44 (&Si, &S);
+
+    mulmat66mat64 (&PHt, &ekf->P, &Ht);
+    mulmat64mat44 (&K, &PHt, &Si);
+    mulmat64mat46 (&KHP, &K, &HP);
+    mulconst_mat66 (&minus_KHP, &KHP, -1.0f);
+    add_mat66 (&ekf->P, &ekf->P, &minus_KHP);
+}
+
+static void maths_bench_ekf_batch_step (maths_bench_ekf_batch_t *ekf)
+{
+    matrix_batch_mul (&ekf->FP, &ekf->F, &ekf->P);
+    matrix_batch_mul_transpose (&ekf->P, &ekf->FP, &ekf->F);
+    matrix_batch_add (&ekf->P, &ekf->P, &ekf->Q);
+
+    matrix_batch_mul (&ekf->HP, &ekf->H, &ekf->P);
+    matrix_batch_mul_transpose (&ekf->S, &ekf->HP, &ekf->H);
+    matrix_batch_add (&ekf->S, &ekf->S, &ekf->R);
+    matrix_batch_inv (&ekf->S, &ekf->S);
+
+    matrix_batch_mul_transpose (&ekf->PHt, &ekf->P, &ekf->H);
+    matrix_batch_mul (&ekf->K, &ekf->PHt, &ekf->S);
+    matrix_batch_mul (&ekf->KHP, &ekf->K, &ekf->HP);
+    matrix_batch_sub (&ekf->P, &ekf->P, &ekf->KHP);
+}
+
+static maths_bench_ekf_t ekfs[MATHS_BENCH_MAX_INSTANCES];
+
+static void maths_bench_ekf_scalar (void)
+{
+    uint64_t start;
+    uint32_t k, n;
+
+    for (k = 0; k < nb_drones; k++)
+        maths_bench_ekf_init (&ekfs[k], k);
+
+    start = bench_now ();
+    for (n = 0; n < nb_steps; n++)
+    {
+        for (k = 0; k < nb_drones; k++)
+            maths_bench_ekf_step (&ekfs[k]);
+    }
+    start = bench_now () - start;
+
+    maths_bench_report ("ekf", "matrices", nb_drones, 0, 0.0, start / 1e3 / nb_steps, MATHS_BENCH_OK);
+}
+
+static void maths_bench_ekf_batch (MATHS_SIMD_LEVEL level)
+{
+    maths_bench_ekf_batch_t batch;
+    matrix_batch_t *matrices[] = { &batch.P, &batch.F, &batch.Q, &batch.H, &batch.R,
+                                   &batch.FP, &batch.HP, &batch.S, &batch.PHt, &batch.K, &batch.KHP };
+    static const uint32_t sizes[][2] = { { 6, 6 }, { 6, 6 }, { 6, 6 }, { 4, 6 }, { 4, 4 },
+                                         { 6, 6 }, { 4, 6 }, { 4, 4 }, { 6, 4 }, { 6, 4 }, { 6, 6 } };
+    maths_bench_ekf_t ekf;
+    float32_t P[36];
+    uint64_t start;
+    uint32_t i, k, n;
+    double max_error = 0.0;
+
+    for (i = 0; i < sizeof (matrices) / sizeof (matrices[0]); i++)
+        matrix_batch_alloc (matrices[i], sizes[i][0], sizes[i][1], nb_drones);
+
+    for (k = 0; k < nb_drones; k++)
+    {
+        maths_bench_ekf_init (&ekf, k);
+        matrix_batch_set (&batch.P, k, (float32_t *)&ekf.P);
+        matrix_batch_set (&batch.F, k, (float32_t *)&ekf.F);
+        matrix_batch_set (&batch.Q, k, (float32_t *)&ekf.Q);
+        matrix_batch_set (&batch.H, k, (float32_t *)&ekf.H);
+        matrix_batch_set (&batch.R, k, (float32_t *)&ekf.R);
+    }
+
+    start = bench_now ();
+    for (n = 0; n < nb_steps; n++)
+        maths_bench_ekf_batch_step (&batch);
+    start = bench_now () - start;
+
+    // Rounding differs from inv_mat44 : compared with a tolerance
+    for (k = 0; k < nb_drones; k++)
+    {
+        matrix_batch_get (&batch.P, k, P);
+        maths_bench_compare (P, (float32_t *)&ekfs[k].P, 36, &max_error);
+    }
+
+    for (i = 0; i < sizeof (matrices) / sizeof (matrices[0]); i++)
+        matrix_batch_free (matrices[i]);
+
+    maths_bench_report ("ekf", maths_bench_level_names[level], nb_drones, 0, max_error, start / 1e3 / nb_steps,
+                        (EKF_TOLERANCE >= max_error) ? MATHS_BENCH_OK : MATHS_BENCH_MISMATCH);
+}
+
+/**
+ * Second order filter of each drone, filter() when batch is FALSE
+ */
+static void maths_bench_filter_speed (MATHS_SIMD_LEVEL level, bool_t batch)
+{
+    static const float32_t b[3] = { 0.0675f, 0.135f, 0.0675f };
+    static const float32_t a[3] = { 1.0f, -1.143f, 0.4128f };
+    float32_t old_inputs[MATHS_BENCH_MAX_INSTANCES][NB_SECOND_ORDER];
+    float32_t old_outputs[MATHS_BENCH_MAX_INSTANCES][NB_SECOND_ORDER];
+    float32_t input[MATHS_BENCH_MAX_INSTANCES], output[MATHS_BENCH_MAX_INSTANCES];
+    filter_batch_t f;
+    uint64_t start;
+    uint32_t k, n;
+
+    for (k = 0; k < nb_drones; k++)
+    {
+        input[k] = maths_bench_random ();
+        filter_init (NB_SECOND_ORDER, old_inputs[k], 0.0f, old_outputs[k], 0.0f);
+    }
+    filter_batch_init (&f, NB_SECOND_ORDER, nb_drones, NULL, NULL);
+
+    start = bench_now ();
+    for (n = 0; n < nb_steps; n++)
+    {
+        if (batch)
+        {
+            filter_batch (&f, b, a, input, output);
+        }
+        else
+        {
+            for (k = 0; k < nb_drones; k++)
+                output[k] = filter (NB_SECOND_ORDER, b, a, input[k], old_inputs[k], old_outputs[k]);
+        }
+        // Next input depends on the output, so that the steps are not optimized out
+        input[n % nb_drones] = output[(n + 1) % nb_drones];
+    }
+    start = bench_now () - start;
+
+    filter_batch_free (&f);
+
+    maths_bench_report ("filter", batch ? maths_bench_level_names[level] : "scalar", nb_drones, 0, 0.0,
+                        start / 1e3 / nb_steps, MATHS_BENCH_OK);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *output = NULL;
+    MATHS_SIMD_LEVEL level;
+    uint32_t i;
+    int option;
+
+    while (-1 != (option = getopt (argc, argv, "n:d:i:o:")))
+    {
+        switch (option)
+        {
+        case 'n':
+            nb_instances = (uint32_t)atoi (optarg);
+            break;
+        case 'd':
+            nb_drones = (uint32_t)atoi (optarg);
+            break;
+        case 'i':
+            nb_steps = (uint32_t)atoi (optarg);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            printf ("Usage : %s [-n instances] [-d drones] [-i steps] [-o results.json]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (nb_instances < 1 || nb_instances > MATHS_BENCH_MAX_INSTANCES || nb_drones < 1 ||
+        nb_drones > MATHS_BENCH_MAX_INSTANCES || nb_steps < 1)
+    {
+        printf ("1 to %d instances and drones, at least one step\n", MATHS_BENCH_MAX_INSTANCES);
+        return -1;
+    }
+
+    bench_init (maths_bench_status_names, sizeof (maths_bench_status_names) / sizeof (maths_bench_status_names[0]));
+    for (level = MATHS_SIMD_NONE; level <= MATHS_SIMD_AVX; level++)
+    {
+        if (level != maths_simd_level_set (level))
+        {
+            maths_bench_report ("accuracy", maths_bench_level_names[level], 0, 0, 0.0, 0.0, MATHS_BENCH_SKIPPED);
+            continue;
+        }
+        for (i = 0; i < sizeof (matrix_cases) / sizeof (matrix_cases[0]); i++)
+            maths_bench_matrix (&matrix_cases[i], level);
+        maths_bench_inv (level);
+        maths_bench_filter (NB_FIRST_ORDER, level);
+        maths_bench_filter (NB_SECOND_ORDER, level);
+        maths_bench_filter (NB_FOURTH_ORDER, level);
+    }
+
+    maths_bench_ekf_scalar ();
+    for (level = MATHS_SIMD_NONE; level <= MATHS_SIMD_AVX; level++)
+    {
+        if (level != maths_simd_level_set (level))
+        {
+            maths_bench_report ("ekf", maths_bench_level_names[level], nb_drones, 0, 0.0, 0.0, MATHS_BENCH_SKIPPED);
+            continue;
+        }
+        maths_bench_ekf_batch (level);
+    }
+
+    maths_bench_filter_speed (MATHS_SIMD_NONE, FALSE);
+    for (level = MATHS_SIMD_NONE; level <= MATHS_SIMD_AVX; level++)
+    {
+        if (level != maths_simd_level_set (level))
+        {
+            maths_bench_report ("filter", maths_bench_level_names[level], nb_drones, 0, 0.0, 0.0, MATHS_BENCH_SKIPPED);
+            continue;
+        }
+        maths_bench_filter_speed (level, TRUE);
+    }
+
+    maths_simd_level_set (MATHS_SIMD_BEST);
+
+    if (NULL != output)
+    {
+        bench_write (output, "\"maths_bench\":1,\"instances\":%u,\"drones\":%u,\"steps\":%u,\"navdata_rate_hz\":%d",
+                     nb_instances, nb_drones, nb_steps, NAVDATA_RATE_HZ);
+    }
+
+    // Skipped levels are not failures
+    return (0 == bench_count (MATHS_BENCH_MISMATCH)) ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file navdata_convert.c
+ * @date 2026/10/18
+ *
+ * Offline converter from the binary navdata log (NAVDATA_FILE_FORMAT_BINARY)
+ * to the "VERSION 19c" CSV layout of ardrone_navdata_file.
+ *
+ * Usage : ./linux_navdata_convert mesures_YYYYMMDD_HHMMSS.bin [output.txt]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <VP_Api/vp_api_thread_helper.h>
+#include <ardrone_tool/Navdata/ardrone_navdata_file.h>
+
+// ARDrone Tool is linked but not started : no thread
+BEGIN_THREAD_TABLE
+END_THREAD_TABLE
+
+int main (int argc, char *argv[])
+{
+    char outputName[1024];
+    const char *ext;
+
+    if (2 > argc)
+    {
+        printf ("Usage : %s <binary navdata file> [csv file]\n", argv[0]);
+        return -1;
+    }
+
+    if (2 < argc)
+    {
+        strncpy (outputName, argv[2], sizeof (outputName) - 1);
+        outputName[sizeof (outputName) - 1] = '\0';
+    }
+    else
+    {
+        // mesures_xxx.bin -> mesures_xxx.txt
+        ext = strrchr (argv[1], '.');
+        snprintf (outputName, sizeof (outputName), "%.*s.txt",
+                  (int)((NULL != ext) ? (size_t)(ext - argv[1]) : strlen (argv[1])), argv[1]);
+    }
+
+    if (VP_FAILED (ardrone_navdata_file_convert (argv[1], outputName)))
+    {
+        return -1;
+    }
+    printf ("%s written\n", outputName);
+    return 0;
+}
@@ -0,0 +1,407 @@
+/**
+ * @file reactor_test.c
+ * @date 2026/10/18
+ *
+ * Test of the event loop of VP_Com (vp_com_reactor.h) : sources added,
+ * modified and removed while the reactor dispatches, from its handlers and
+ * from other threads.
+ *
+ * The file descriptors are pipes, made readable by writing one byte. Cases :
+ *  - stale        : a handler removes a source whose event is pending in the
+ *                   same wait and registers a new descriptor, which gets the
+ *                   same slot and the same fd number. The pending event must
+ *                   not reach the new source (generation tag).
+ *  - add          : a source added by a handler is dispatched by the next wait
+ *  - self_remove  : a handler removes its own source, it is not called again
+ *  - fail_remove  : a handler returning C_FAIL is removed, its fd stays open
+ *  - timer_remove : a timer removes another timer expired at the same time
+ *  - timer_period : a periodic timer keeps its period
+ *  - thread_add   : a source added by another thread wakes a reactor which
+ *                   waits without timeout
+ *  - stop         : vp_com_reactor_stop from another thread ends vp_com_reactor_run
+ *
+ * Each case prints ok or FAILED, the exit code is the number of failed cases.
+ *
+ * Usage : ./linux_reactor_test [-v]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include <VP_Api/vp_api_thread_helper.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Com/vp_com_reactor.h>
+
+#define REACTOR_TEST_TIMER_MS       20
+#define REACTOR_TEST_PERIODS        10
+#define REACTOR_TEST_THREAD_MS      50      // before the other thread acts
+#define REACTOR_TEST_WAKEUP_MS      500     // for the reactor to see it
+
+typedef struct _reactor_test_pipe_ {
+    int fds[2];
+    uint32_t calls;
+} reactor_test_pipe_t;
+
+static vp_com_reactor_t reactor;
+static int verbose = 0;
+
+// Stale case : the first of the pair to run replaces the other one
+static reactor_test_pipe_t pair[2];
+static reactor_test_pipe_t replacement;
+static int32_t replaced_slot = -1;
+
+// Timer cases
+static int32_t timer_ids[2];
+static uint32_t timer_calls[2];
+
+// No ARDrone Tool thread
+BEGIN_THREAD_TABLE
+END_THREAD_TABLE
+
+static uint32_t reactor_test_now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static bool_t reactor_test_open (reactor_test_pipe_t *p)
+{
+    p->calls = 0;
+    if (pipe (p->fds) < 0)
+        return FALSE;
+    fcntl (p->fds[0], F_SETFL, fcntl (p->fds[0], F_GETFL, 0) | O_NONBLOCK);
+    return TRUE;
+}
+
+static void reactor_test_close (reactor_test_pipe_t *p)
+{
+    close (p->fds[0]);
+    close (p->fds[1]);
+}
+
+static void reactor_test_signal (reactor_test_pipe_t *p)
+{
+    char c = 0;
+    if (write (p->fds[1], &c, 1) != 1)
+        perror ("write");
+}
+
+static void reactor_test_drain (int32_t fd)
+{
+    char buffer[16];
+    while (read (fd, buffer, sizeof (buffer)) > 0);
+}
+
+static int32_t reactor_test_slot (int32_t fd)
+{
+    int32_t i;
+
+    for (i = 0; i < VP_COM_REACTOR_MAX_SOURCES; i++)
+    {
+        if (reactor.sources[i].used && reactor.sources[i].fd == fd)
+            return i;
+    }
+    return -1;
+}
+
+static bool_t reactor_test_result (const char *name, bool_t ok)
+{
+    printf ("%-14s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+/* Counts and drains */
+static C_RESULT reactor_test_count (int32_t fd, uint32_t events, void *data)
+{
+    reactor_test_pipe_t *p = (reactor_test_pipe_t *)data;
+
+    p->calls++;
+    reactor_test_drain (fd);
+    return C_OK;
+}
+
+/* Removes and closes the other pipe of the pair, opens a replacement readable at once */
+static C_RESULT reactor_test_replace (int32_t fd, uint32_t events, void *data)
+{
+    reactor_test_pipe_t *p = (reactor_test_pipe_t *)data;
+    reactor_test_pipe_t *other = (p == &pair[0]) ? &pair[1] : &pair[0];
+    int32_t slot;
+
+    p->calls++;
+    reactor_test_drain (fd);
+
+    if (0 <= replaced_slot)
+        return C_OK;
+
+    slot = reactor_test_slot (other->fds[0]);
+    vp_com_reactor_remove (&reactor, other->fds[0]);
+    reactor_test_close (other);
+
+    if (reactor_test_open (&replacement))
+    {
+        reactor_test_signal (&replacement);
+        vp_com_reactor_add (&reactor, replacement.fds[0], VP_COM_REACTOR_READ, reactor_test_count, &replacement);
+        if (reactor_test_slot (replacement.fds[0]) == slot)
+            replaced_slot = slot;
+    }
+
+    if (verbose)
+        printf ("  slot %d fd %d replaced by fd %d in slot %d\n", slot, other->fds[0], replacement.fds[0], replaced_slot);
+
+    return C_OK;
+}
+
+static bool_t reactor_test_stale (void)
+{
+    bool_t ok;
+    int i;
+
+    replaced_slot = -1;
+    for (i = 0; i < 2; i++)
+    {
+        reactor_test_open (&pair[i]);
+        vp_com_reactor_add (&reactor, pair[i].fds[0], VP_COM_REACTOR_READ, reactor_test_replace, &pair[i]);
+        reactor_test_signal (&pair[i]);
+    }
+
+    // Both pipes are ready in the same wait : one of them is replaced before its event is dispatched
+    vp_com_reactor_run_once (&reactor, 0);
+    ok = (1 == pair[0].calls + pair[1].calls) && (0 <= replaced_slot) && (0 == replacement.calls);
+    if (verbose)
+        printf ("  calls %u %u replacement %u\n", pair[0].calls, pair[1].calls, replacement.calls);
+
+    // The replacement gets its own event
+    vp_com_reactor_run_once (&reactor, 0);
+    ok = ok && (1 == replacement.calls);
+
+    for (i = 0; i < 2; i++)
+    {
+        if (0 <= reactor_test_slot (pair[i].fds[0]) && pair[i].calls)
+        {
+            vp_com_reactor_remove (&reactor, pair[i].fds[0]);
+            reactor_test_close (&pair[i]);
+        }
+    }
+    vp_com_reactor_remove (&reactor, replacement.fds[0]);
+    reactor_test_close (&replacement);
+
+    return reactor_test_result ("stale", ok);
+}
+
+/* Adds the replacement pipe, readable */
+static C_RESULT reactor_test_add (int32_t fd, uint32_t events, void *data)
+{
+    reactor_test_count (fd, events, data);
+    if (reactor_test_open (&replacement))
+    {
+        reactor_test_signal (&replacement);
+        vp_com_reactor_add (&reactor, replacement.fds[0], VP_COM_REACTOR_READ, reactor_test_count, &replacement);
+    }
+    return C_FAIL;
+}
+
+static bool_t reactor_test_add_during_dispatch (void)
+{
+    reactor_test_pipe_t p;
+    bool_t ok;
+
+    reactor_test_open (&p);
+    vp_com_reactor_add (&reactor, p.fds[0], VP_COM_REACTOR_READ, reactor_test_add, &p);
+    reactor_test_signal (&p);
+
+    vp_com_reactor_run_once (&reactor, 0);
+    vp_com_reactor_run_once (&reactor, 0);
+    ok = (1 == p.calls) && (1 == replacement.calls);
+
+    vp_com_reactor_remove (&reactor, replacement.fds[0]);
+    reactor_test_close (&replacement);
+    reactor_test_close (&p);
+
+    return reactor_test_result ("add", ok);
+}
+
+static C_RESULT reactor_test_remove_self (int32_t fd, uint32_t events, void *data)
+{
+    reactor_test_count (fd, events, data);
+    vp_com_reactor_remove (&reactor, fd);
+    return C_OK;
+}
+
+static C_RESULT reactor_test_fail (int32_t fd, uint32_t events, void *data)
+{
+    reactor_test_count (fd, events, data);
+    return C_FAIL;
+}
+
+static bool_t reactor_test_removal (const char *name, vp_com_reactor_handler_t handler)
+{
+    reactor_test_pipe_t p;
+    bool_t ok;
+
+    reactor_test_open (&p);
+    vp_com_reactor_add (&reactor, p.fds[0], VP_COM_REACTOR_READ, handler, &p);
+    reactor_test_signal (&p);
+    vp_com_reactor_run_once (&reactor, 0);
+
+    // Not registered anymore, not called anymore, still open
+    reactor_test_signal (&p);
+    vp_com_reactor_run_once (&reactor, 0);
+    ok = (1 == p.calls) && (-1 == reactor_test_slot (p.fds[0])) && (0 <= fcntl (p.fds[0], F_GETFD));
+
+    reactor_test_close (&p);
+
+    return reactor_test_result (name, ok);
+}
+
+static C_RESULT reactor_test_timer (int32_t fd, uint32_t events, void *data)
+{
+    int i = (int)(intptr_t)data;
+
+    timer_calls[i]++;
+    if (0 == i)
+        vp_com_reactor_remove (&reactor, timer_ids[1]);
+    return C_OK;
+}
+
+static bool_t reactor_test_timer_remove (void)
+{
+    bool_t ok;
+
+    timer_calls[0] = timer_calls[1] = 0;
+    vp_com_reactor_add_timer (&reactor, REACTOR_TEST_TIMER_MS, reactor_test_timer, (void *)0, &timer_ids[0]);
+    vp_com_reactor_add_timer (&reactor, REACTOR_TEST_TIMER_MS, reactor_test_timer, (void *)1, &timer_ids[1]);
+
+    // Both expired when the timers are dispatched, the first one runs first
+    usleep (2 * REACTOR_TEST_TIMER_MS * 1000);
+    vp_com_reactor_run_once (&reactor, 0);
+    ok = (1 == timer_calls[0]) && (0 == timer_calls[1]) && (-1 == reactor_test_slot (timer_ids[1]));
+
+    vp_com_reactor_remove (&reactor, timer_ids[0]);
+
+    return reactor_test_result ("timer_remove", ok);
+}
+
+static C_RESULT reactor_test_tick (int32_t fd, uint32_t events, void *data)
+{
+    timer_calls[0]++;
+    return C_OK;
+}
+
+static bool_t reactor_test_timer_period (void)
+{
+    uint32_t start, elapsed;
+    bool_t ok;
+
+    timer_calls[0] = 0;
+    vp_com_reactor_add_timer (&reactor, REACTOR_TEST_TIMER_MS, reactor_test_tick, NULL, &timer_ids[0]);
+
+    start = reactor_test_now ();
+    while (timer_calls[0] < REACTOR_TEST_PERIODS)
+        vp_com_reactor_run_once (&reactor, -1);
+    elapsed = reactor_test_now () - start;
+
+    // Not early, and without too much drift
+    ok = (REACTOR_TEST_PERIODS * REACTOR_TEST_TIMER_MS <= elapsed + 1) && (elapsed < 2 * REACTOR_TEST_PERIODS * REACTOR_TEST_TIMER_MS);
+    if (verbose)
+        printf ("  %d periods of %d ms in %u ms\n", REACTOR_TEST_PERIODS, REACTOR_TEST_TIMER_MS, elapsed);
+
+    vp_com_reactor_remove (&reactor, timer_ids[0]);
+
+    return reactor_test_result ("timer_period", ok);
+}
+
+static void *reactor_test_adder (void *arg)
+{
+    reactor_test_pipe_t *p = (reactor_test_pipe_t *)arg;
+
+    usleep (REACTOR_TEST_THREAD_MS * 1000);
+    reactor_test_signal (p);
+    vp_com_reactor_add (&reactor, p->fds[0], VP_COM_REACTOR_READ, reactor_test_count, p);
+    return NULL;
+}
+
+static void *reactor_test_stopper (void *arg)
+{
+    usleep (REACTOR_TEST_THREAD_MS * 1000);
+    vp_com_reactor_stop (&reactor);
+    return NULL;
+}
+
+/* Waits without timeout : only the wakeup of the other thread returns */
+static bool_t reactor_test_thread (const char *name, void *(*routine) (void *), reactor_test_pipe_t *p)
+{
+    pthread_t thread;
+    uint32_t start, elapsed;
+    bool_t ok;
+
+    start = reactor_test_now ();
+    pthread_create (&thread, NULL, routine, p);
+    if (NULL != p)
+    {
+        // Woken up by the add, then the event of the new source
+        while (0 == p->calls && reactor_test_now () - start < REACTOR_TEST_WAKEUP_MS + REACTOR_TEST_THREAD_MS)
+            vp_com_reactor_run_once (&reactor, -1);
+        ok = (1 == p->calls);
+    }
+    else
+    {
+        ok = VP_SUCCEEDED (vp_com_reactor_run (&reactor));
+    }
+    elapsed = reactor_test_now () - start;
+    pthread_join (thread, NULL);
+
+    ok = ok && (elapsed < REACTOR_TEST_WAKEUP_MS + REACTOR_TEST_THREAD_MS);
+    if (verbose)
+        printf ("  returned after %u ms\n", elapsed);
+
+    return reactor_test_result (name, ok);
+}
+
+int main (int argc, char *argv[])
+{
+    reactor_test_pipe_t p;
+    int option, failures = 0;
+
+    while (-1 != (option = getopt (argc, argv, "v")))
+    {
+        switch (option)
+        {
+        case 'v':
+            verbose = 1;
+            break;
+        default:
+            printf ("Usage : %s [-v]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (VP_FAILED (vp_com_reactor_init (&reactor)))
+    {
+        printf ("vp_com_reactor_init failed\n");
+        return -1;
+    }
+
+    failures += !reactor_test_stale ();
+    failures += !reactor_test_add_during_dispatch ();
+    failures += !reactor_test_removal ("self_remove", reactor_test_remove_self);
+    failures += !reactor_test_removal ("fail_remove", reactor_test_fail);
+    failures += !reactor_test_timer_remove ();
+    failures += !reactor_test_timer_period ();
+
+    reactor_test_open (&p);
+    failures += !reactor_test_thread ("thread_add", reactor_test_adder, &p);
+    vp_com_reactor_remove (&reactor, p.fds[0]);
+    reactor_test_close (&p);
+
+    failures += !reactor_test_thread ("stop", reactor_test_stopper, NULL);
+
+    vp_com_reactor_shutdown (&reactor);
+
+    return failures;
+}
@@ -0,0 +1,596 @@
+/**
+ * @file recorder_bench.c
+ * @date 2026/10/18
+ *
+ * Offline benchmark of the recording stages.
+ *
+ * FFmpeg recorder (video_stage_ffmpeg_recorder) : synthetic YUV 4:2:0 frames
+ * are fed to the stage as fast as the pipeline would, once with each queue
+ * policy. The time spent in the stage transform is the latency the recorder
+ * adds to the stages before it (decoding, display). With the drop-oldest
+ * policy it must stay well below the encoding time of a frame, which is
+ * measured by the blocking policy where the pipeline is paced by the encoder.
+ *
+ * Stream copy (video_stage_ffmpeg_remux) : the H.264 frames of a PaVE capture
+ * given with -p are recorded twice. Once written as they are by the stream
+ * copy stage, once decoded by the FFmpeg decoder stage and encoded again by
+ * the recorder (blocking policy, every frame is encoded). The stream copy
+ * must use less CPU than the re-encoding path. The decoding time is given
+ * apart : the display decodes the stream anyway.
+ *
+ * For each case : frames fed, frames encoded (or written) and dropped,
+ * transform time (mean and max), encoding time per frame, process CPU time per
+ * frame (all threads), resident memory growth, size of the file written and
+ * disk throughput.
+ *
+ * A capture is what the drone sends on the video port : PaVE frames one after
+ * the other, e.g. a dump of the drone_simulator video socket.
+ *
+ * Results are written with -o as JSON, one object per line.
+ *
+ * Usage : ./linux_recorder_bench [-n frames] [-s WIDTHxHEIGHT] [-p capture] [-d directory] [-o results.json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <VP_Api/vp_api_picture.h>
+#include <VP_Os/vp_os_malloc.h>
+
+#include <ardrone_tool/Video/video_stage_ffmpeg_recorder.h>
+#include <ardrone_tool/Video/video_stage_ffmpeg_remux.h>
+#include <ardrone_tool/Video/video_stage_ffmpeg_decoder.h>
+#include <video_encapsulation.h>
+
+#include <bench.h>
+
+#define RECORDER_BENCH_FRAMES       120
+#define RECORDER_BENCH_WIDTH        1280
+#define RECORDER_BENCH_HEIGHT       720
+#define RECORDER_BENCH_FRAMERATE    30
+// Drop-oldest transform must cost less than this fraction of an encoded frame
+#define RECORDER_BENCH_MAX_LATENCY_RATIO  4
+
+typedef enum _RECORDER_BENCH_STATUS_ {
+    RECORDER_BENCH_OK = 0,
+    RECORDER_BENCH_SLOW,        // upstream latency follows the encoding time, or stream copy costs more than re-encoding
+    RECORDER_BENCH_FAILED       // case could not run, or nothing was written
+} RECORDER_BENCH_STATUS;
+
+static const char *recorder_bench_status_names[] = { "ok", "slow", "failed" };
+
+typedef struct _recorder_bench_result_ {
+    char     name[64];
+    uint32_t width;
+    uint32_t height;
+    uint32_t frames;            // fed to the stage
+    uint32_t encoded;
+    uint32_t dropped;
+    double   transform_us;      // mean time spent in the stage transform
+    double   transform_max_us;
+    double   encode_us;         // wall time per encoded frame, until the file is closed
+    double   decode_us;         // mean time spent in the decoder stage (re-encoding from a capture)
+    double   cpu_us;            // process CPU time per frame fed, all threads, until the file is closed
+    long     rss_kb;            // resident memory growth during the case
+    long     file_size;
+    double   disk_kbps;         // file size over the wall time of the case
+    RECORDER_BENCH_STATUS status;
+} recorder_bench_result_t;
+
+static int nb_frames = RECORDER_BENCH_FRAMES;
+static uint32_t width = RECORDER_BENCH_WIDTH;
+static uint32_t height = RECORDER_BENCH_HEIGHT;
+static const char *directory = "/tmp";
+
+static uint32_t recorder_bench_random (uint32_t *seed)
+{
+    *seed = *seed * 1664525U + 1013904223U;
+    return *seed >> 16;
+}
+
+// Moving gradient and noise : costly enough for the encoder to be the bottleneck
+static void recorder_bench_source (vp_api_picture_t *picture, uint32_t t)
+{
+    uint32_t seed = t * 2654435761U;
+    uint32_t x, y;
+
+    for (y = 0; y < picture->height; y++)
+    {
+        for (x = 0; x < picture->width; x++)
+        {
+            picture->y_buf[y * picture->y_line_size + x] = (uint8_t)(x + y + 4 * t + (recorder_bench_random (&seed) & 0x07));
+        }
+    }
+    for (y = 0; y < picture->height / 2; y++)
+    {
+        for (x = 0; x < picture->width / 2; x++)
+        {
+            picture->cb_buf[y * picture->cb_line_size + x] = (uint8_t)(128 + x - t);
+            picture->cr_buf[y * picture->cr_line_size + x] = (uint8_t)(128 + y + t);
+        }
+    }
+}
+
+typedef struct _recorder_bench_frame_ {
+    uint8_t *data;              // PaVE and payload
+    uint32_t size;
+} recorder_bench_frame_t;
+
+/* Case which has not run yet */
+static void recorder_bench_case (recorder_bench_result_t *result, const char *name)
+{
+    vp_os_memset (result, 0, sizeof (*result));
+    snprintf (result->name, sizeof (result->name), "%s", name);
+    result->width = width;
+    result->height = height;
+    result->status = RECORDER_BENCH_FAILED;
+}
+
+/* Prints a case and adds it to the results */
+static void recorder_bench_report (const recorder_bench_result_t *result)
+{
+    bench_result_t *entry = bench_report (result->name, result->status);
+
+    printf ("%-28s %4ux%-4u %4u frames %4u encoded %4u dropped  transform %8.1f us (max %8.1f)  encode %8.1f us/frame  decode %8.1f us  cpu %8.1f us/frame  rss %+7ld kB  %9ld bytes %8.1f kB/s  %s\n",
+            result->name, result->width, result->height, result->frames, result->encoded, result->dropped,
+            result->transform_us, result->transform_max_us, result->encode_us, result->decode_us, result->cpu_us,
+            result->rss_kb, result->file_size, result->disk_kbps, recorder_bench_status_names[result->status]);
+
+    bench_set (entry, "width", "%u", result->width);
+    bench_set (entry, "height", "%u", result->height);
+    bench_set (entry, "frames", "%u", result->frames);
+    bench_set (entry, "encoded", "%u", result->encoded);
+    bench_set (entry, "dropped", "%u", result->dropped);
+    bench_set (entry, "transform_us", "%.2f", result->transform_us);
+    bench_set (entry, "transform_max_us", "%.2f", result->transform_max_us);
+    bench_set (entry, "encode_us", "%.2f", result->encode_us);
+    bench_set (entry, "decode_us", "%.2f", result->decode_us);
+    bench_set (entry, "cpu_us", "%.2f", result->cpu_us);
+    bench_set (entry, "rss_kb", "%ld", result->rss_kb);
+    bench_set (entry, "file_size", "%ld", result->file_size);
+    bench_set (entry, "disk_kbps", "%.1f", result->disk_kbps);
+}
+
+/**
+ * Gives the picture of frame n to the recorder stage.
+ * Returns C_FAIL when there is no picture for this frame.
+ */
+typedef C_RESULT (*recorder_bench_source_t) (vp_api_picture_t *picture, int n, void *arg);
+
+/* Synthetic frames, drawn in the picture given as arg */
+static C_RESULT recorder_bench_synthetic_source (vp_api_picture_t *picture, int n, void *arg)
+{
+    vp_api_picture_t *synthetic = (vp_api_picture_t *)arg;
+
+    // A decoder would have written the picture before the recorder stage
+    recorder_bench_source (synthetic, n);
+    *picture = *synthetic;
+    return C_OK;
+}
+
+static void recorder_bench_ffmpeg_recorder (recorder_bench_result_t *result, const char *name, video_ffmpeg_recorder_queue_policy policy,
+                                            int count, recorder_bench_source_t source, void *arg)
+{
+    video_stage_ffmpeg_recorder_config_t cfg;
+    vp_api_io_data_t in, out;
+    vp_api_picture_t picture;
+    uint64_t start, cpu, before, elapsed, total = 0, max = 0;
+    long rss, rss_max, now;
+    struct stat st;
+    char path[sizeof (cfg.video_filename)];
+    void *buffers = &picture;
+    uint32_t fed = 0;
+    int n;
+
+    recorder_bench_case (result, name);
+
+    vp_os_memset (&cfg, 0, sizeof (cfg));
+    // The stage clears video_filename once the file is created
+    snprintf (path, sizeof (path), "%s/recorder_bench_%s.mp4", directory, name);
+    strcpy (cfg.video_filename, path);
+    cfg.queue_policy = policy;
+
+    vp_os_memset (&picture, 0, sizeof (picture));
+    vp_os_memset (&in, 0, sizeof (in));
+    vp_os_memset (&out, 0, sizeof (out));
+    vp_os_mutex_init (&out.lock);
+    out.status = VP_API_STATUS_INIT;
+    in.status = VP_API_STATUS_PROCESSING;
+    in.buffers = (uint8_t **)buffers;
+
+    unlink (path);
+    rss = rss_max = bench_rss_kb ();
+    if (C_OK != video_stage_ffmpeg_recorder_open (&cfg))
+    {
+        vp_os_mutex_destroy (&out.lock);
+        return;
+    }
+
+    // Same message as the application record button
+    video_stage_ffmpeg_recorder_handle (&cfg, PIPELINE_MSG_START, NULL, NULL);
+
+    start = bench_now ();
+    cpu = bench_cpu_now ();
+    for (n = 0; n < count; n++)
+    {
+        if (C_OK != source (&picture, n, arg))
+            continue;
+
+        picture.framerate = RECORDER_BENCH_FRAMERATE;
+        in.size = vp_api_picture_get_buffer_size (&picture);
+
+        before = bench_now ();
+        video_stage_ffmpeg_recorder_transform (&cfg, &in, &out);
+        elapsed = bench_now () - before;
+
+        total += elapsed;
+        if (elapsed > max)
+            max = elapsed;
+        fed++;
+
+        now = bench_rss_kb ();
+        if (now > rss_max)
+            rss_max = now;
+    }
+
+    // Queued frames are encoded and the file is closed before close returns
+    video_stage_ffmpeg_recorder_close (&cfg);
+    elapsed = bench_now () - start;
+    cpu = bench_cpu_now () - cpu;
+
+    result->width = picture.width;
+    result->height = picture.height;
+    result->frames = fed;
+    result->encoded = cfg.encoded_frames;
+    result->dropped = cfg.dropped_frames;
+    if (0 < fed)
+    {
+        result->transform_us = total / 1000.0 / fed;
+        result->cpu_us = cpu / 1000.0 / fed;
+    }
+    result->transform_max_us = max / 1000.0;
+    result->encode_us = (0 < cfg.encoded_frames) ? elapsed / 1000.0 / cfg.encoded_frames : 0.0;
+    result->rss_kb = rss_max - rss;
+    result->file_size = (0 == stat (path, &st)) ? (long)st.st_size : 0;
+    result->disk_kbps = result->file_size / 1024.0 / (elapsed / 1e9);
+    result->status = (0 < result->encoded && 0 < result->file_size) ? RECORDER_BENCH_OK : RECORDER_BENCH_FAILED;
+
+    vp_os_mutex_destroy (&out.lock);
+}
+
+static void recorder_bench_ffmpeg (void)
+{
+    recorder_bench_result_t drop, block;
+    vp_api_picture_t synthetic;
+
+    if (C_OK != vp_api_picture_alloc (&synthetic, width, height, PIX_FMT_YUV420P))
+    {
+        printf ("Unable to allocate a %ux%u picture\n", width, height);
+        recorder_bench_case (&block, "ffmpeg_recorder");
+        recorder_bench_report (&block);
+        return;
+    }
+
+    recorder_bench_ffmpeg_recorder (&block, "ffmpeg_recorder_block", VIDEO_FFMPEG_RECORDER_BLOCK,
+                                    nb_frames, recorder_bench_synthetic_source, &synthetic);
+    recorder_bench_ffmpeg_recorder (&drop, "ffmpeg_recorder_drop_oldest", VIDEO_FFMPEG_RECORDER_DROP_OLDEST,
+                                    nb_frames, recorder_bench_synthetic_source, &synthetic);
+    vp_api_picture_free (&synthetic);
+
+    // The blocking case paces the feeder at the encoder speed : its encode_us is the encoding time of a frame
+    if (RECORDER_BENCH_OK == drop.status && RECORDER_BENCH_OK == block.status &&
+        drop.transform_us * RECORDER_BENCH_MAX_LATENCY_RATIO > block.encode_us)
+    {
+        drop.status = RECORDER_BENCH_SLOW;
+    }
+
+    recorder_bench_report (&block);
+    recorder_bench_report (&drop);
+}
+
+/********************************************************************
+ * Stream copy against re-encoding, on a capture
+ ********************************************************************/
+
+typedef struct _recorder_bench_decoder_ {
+    ffmpeg_stage_decoding_config_t cfg;
+    vp_api_io_data_t in;
+    vp_api_io_data_t out;
+    recorder_bench_frame_t *frames;
+    uint8_t *buffer;
+    uint64_t ns;
+} recorder_bench_decoder_t;
+
+/**
+ * Decoded frames of the capture, like the video pipeline gives them to the recorder.
+ * The decoder stage removes the PaVE in place : each frame is copied before the call.
+ */
+static C_RESULT recorder_bench_decoder_source (vp_api_picture_t *picture, int n, void *arg)
+{
+    recorder_bench_decoder_t *decoder = (recorder_bench_decoder_t *)arg;
+    uint32_t width, height;
+    uint64_t start;
+
+    vp_os_memcpy (decoder->buffer, decoder->frames[n].data, decoder->frames[n].size);
+    vp_os_memset (decoder->buffer + decoder->frames[n].size, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+    decoder->in.size = decoder->frames[n].size;
+    decoder->in.indexBuffer = 0;
+    decoder->out.size = 0;
+
+    start = bench_now ();
+    ffmpeg_stage_decoding_transform (&decoder->cfg, &decoder->in, &decoder->out);
+    decoder->ns += bench_now () - start;
+
+    if (0 == decoder->out.size || NULL == decoder->out.buffers)
+        return C_FAIL;
+
+    // Contiguous YUV 4:2:0 picture
+    width = decoder->cfg.dst_picture.width;
+    height = decoder->cfg.dst_picture.height;
+    vp_os_memset (picture, 0, sizeof (*picture));
+    picture->format = PIX_FMT_YUV420P;
+    picture->width = width;
+    picture->height = height;
+    picture->y_buf = decoder->out.buffers[decoder->out.indexBuffer];
+    picture->cb_buf = picture->y_buf + width * height;
+    picture->cr_buf = picture->cb_buf + width * height / 4;
+    picture->y_line_size = width;
+    picture->cb_line_size = width / 2;
+    picture->cr_line_size = width / 2;
+    return C_OK;
+}
+
+static void recorder_bench_reencode (recorder_bench_result_t *result, recorder_bench_frame_t *frames, int count)
+{
+    recorder_bench_decoder_t decoder;
+    uint32_t max_size = 0;
+    int i;
+
+    for (i = 0; i < count; i++)
+        max_size = (frames[i].size > max_size) ? frames[i].size : max_size;
+
+    vp_os_memset (&decoder, 0, sizeof (decoder));
+    decoder.frames = frames;
+    decoder.buffer = (uint8_t *)vp_os_malloc (max_size + FF_INPUT_BUFFER_PADDING_SIZE);
+    decoder.cfg.dst_picture.format = PIX_FMT_YUV420P;
+    if (NULL == decoder.buffer || C_OK != ffmpeg_stage_decoding_open (&decoder.cfg))
+    {
+        vp_os_free (decoder.buffer);
+        recorder_bench_case (result, "ffmpeg_recorder_reencode");
+        return;
+    }
+
+    decoder.in.buffers = &decoder.buffer;
+    decoder.in.status = VP_API_STATUS_PROCESSING;
+    vp_os_mutex_init (&decoder.out.lock);
+
+    // Blocking policy : every decoded frame is encoded
+    recorder_bench_ffmpeg_recorder (result, "ffmpeg_recorder_reencode", VIDEO_FFMPEG_RECORDER_BLOCK,
+                                    count, recorder_bench_decoder_source, &decoder);
+    // Already counted in cpu_us : decoding is part of the re-encoding path
+    if (0 < result->frames)
+        result->decode_us = decoder.ns / 1000.0 / result->frames;
+
+    ffmpeg_stage_decoding_close (&decoder.cfg);
+    vp_os_mutex_destroy (&decoder.out.lock);
+    vp_os_free (decoder.buffer);
+}
+
+static void recorder_bench_remux (recorder_bench_result_t *result, recorder_bench_frame_t *frames, int count)
+{
+    video_stage_ffmpeg_remux_config_t cfg;
+    vp_api_io_data_t in, out;
+    parrot_video_encapsulation_t *pave;
+    uint64_t start, cpu, before, elapsed, total = 0, max = 0;
+    long rss, rss_max, now;
+    struct stat st;
+    char path[sizeof (cfg.video_filename)];
+    uint8_t *buffer;
+    int n;
+
+    recorder_bench_case (result, "ffmpeg_remux_stream_copy");
+
+    vp_os_memset (&cfg, 0, sizeof (cfg));
+    vp_os_memset (&in, 0, sizeof (in));
+    vp_os_memset (&out, 0, sizeof (out));
+    vp_os_mutex_init (&out.lock);
+    in.status = VP_API_STATUS_PROCESSING;
+    in.buffers = &buffer;
+
+    rss = rss_max = bench_rss_kb ();
+    if (C_OK != video_stage_ffmpeg_remux_open (&cfg))
+    {
+        vp_os_mutex_destroy (&out.lock);
+        return;
+    }
+
+    // The stage clears video_filename once the file is created
+    snprintf (path, sizeof (path), "%s/recorder_bench_ffmpeg_remux_stream_copy.mp4", directory);
+    strcpy (cfg.video_filename, path);
+    unlink (path);
+
+    // Same message as the application record button
+    video_stage_ffmpeg_remux_handle (&cfg, PIPELINE_MSG_START, NULL, NULL);
+
+    start = bench_now ();
+    cpu = bench_cpu_now ();
+    for (n = 0; n < count; n++)
+    {
+        // The stage only reads the frame : no copy
+        buffer = frames[n].data;
+        in.size = frames[n].size;
+
+        before = bench_now ();
+        video_stage_ffmpeg_remux_transform (&cfg, &in, &out);
+        elapsed = bench_now () - before;
+
+        total += elapsed;
+        if (elapsed > max)
+            max = elapsed;
+
+        now = bench_rss_kb ();
+        if (now > rss_max)
+            rss_max = now;
+    }
+
+    // Counters are reset by the next recording only
+    video_stage_ffmpeg_remux_close (&cfg);
+    elapsed = bench_now () - start;
+    cpu = bench_cpu_now () - cpu;
+
+    pave = (parrot_video_encapsulation_t *)frames[0].data;
+    result->width = pave->display_width;
+    result->height = pave->display_height;
+    result->frames = count;
+    result->encoded = cfg.written_frames;
+    result->dropped = cfg.skipped_frames;
+    result->transform_us = total / 1000.0 / count;
+    result->transform_max_us = max / 1000.0;
+    result->cpu_us = cpu / 1000.0 / count;
+    result->rss_kb = rss_max - rss;
+    result->file_size = (0 == stat (path, &st)) ? (long)st.st_size : 0;
+    result->disk_kbps = result->file_size / 1024.0 / (elapsed / 1e9);
+    result->status = (0 < result->encoded && 0 < result->file_size) ? RECORDER_BENCH_OK : RECORDER_BENCH_FAILED;
+
+    vp_os_mutex_destroy (&out.lock);
+}
+
+/**
+ * Capture of the video socket : PaVE frames one after the other.
+ * H.264 frames of the first stream only, one PaVE per frame (slices merged).
+ */
+static int recorder_bench_capture_load (const char *path, recorder_bench_frame_t **frames)
+{
+    parrot_video_encapsulation_t pave, first;
+    recorder_bench_frame_t *tmp;
+    FILE *file = fopen (path, "rb");
+    int count = 0, max = 0;
+
+    *frames = NULL;
+    if (NULL == file)
+    {
+        printf ("Unable to open %s\n", path);
+        return 0;
+    }
+
+    vp_os_memset (&first, 0, sizeof (first));
+    while (1 == fread (&pave, sizeof (pave), 1, file) && PAVE_CHECK (&pave))
+    {
+        if (0 == count)
+            first = pave;
+
+        if (count == max)
+        {
+            max = (0 == max) ? 64 : max * 2;
+            tmp = (recorder_bench_frame_t *)vp_os_realloc (*frames, max * sizeof (recorder_bench_frame_t));
+            if (NULL == tmp)
+                break;
+            *frames = tmp;
+        }
+
+        (*frames)[count].size = pave.header_size + pave.payload_size;
+        (*frames)[count].data = (uint8_t *)vp_os_malloc ((*frames)[count].size);
+        if (NULL == (*frames)[count].data)
+            break;
+
+        vp_os_memcpy ((*frames)[count].data, &pave, sizeof (pave));
+        if (pave.header_size < sizeof (pave) ||
+            1 != fread ((*frames)[count].data + sizeof (pave), (*frames)[count].size - sizeof (pave), 1, file))
+        {
+            vp_os_free ((*frames)[count].data);
+            break;
+        }
+
+        if (CODEC_MPEG4_AVC == pave.video_codec && pave.stream_id == first.stream_id && 1 >= pave.total_slices)
+            count++;
+        else
+            vp_os_free ((*frames)[count].data);
+    }
+    fclose (file);
+
+    return count;
+}
+
+static void recorder_bench_capture (const char *path)
+{
+    recorder_bench_result_t remux, reencode;
+    recorder_bench_frame_t *frames;
+    int count, i;
+
+    count = recorder_bench_capture_load (path, &frames);
+    if (0 == count)
+    {
+        printf ("No H.264 PaVE frame in %s\n", path);
+        recorder_bench_case (&remux, "ffmpeg_remux_stream_copy");
+        recorder_bench_report (&remux);
+        vp_os_free (frames);
+        return;
+    }
+
+    recorder_bench_remux (&remux, frames, count);
+    recorder_bench_reencode (&reencode, frames, count);
+
+    if (RECORDER_BENCH_OK == remux.status && RECORDER_BENCH_OK == reencode.status && remux.cpu_us >= reencode.cpu_us)
+        remux.status = RECORDER_BENCH_SLOW;
+
+    recorder_bench_report (&remux);
+    recorder_bench_report (&reencode);
+
+    for (i = 0; i < count; i++)
+        vp_os_free (frames[i].data);
+    vp_os_free (frames);
+}
+
+int main (int argc, char *argv[])
+{
+    const char *output = NULL, *capture = NULL;
+    int option;
+
+    while (-1 != (option = getopt (argc, argv, "n:s:p:d:o:")))
+    {
+        switch (option)
+        {
+        case 'n':
+            nb_frames = atoi (optarg);
+            break;
+        case 's':
+            if (2 != sscanf (optarg, "%ux%u", &width, &height))
+                width = height = 0;
+            break;
+        case 'p':
+            capture = optarg;
+            break;
+        case 'd':
+            directory = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            printf ("Usage : %s [-n frames] [-s WIDTHxHEIGHT] [-p capture] [-d directory] [-o results.json]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (nb_frames < 2 || 0 == width || 0 == height || 0 != (width % 16) || 0 != (height % 16))
+    {
+        printf ("At least two frames, sizes multiple of 16\n");
+        return -1;
+    }
+
+    bench_init (recorder_bench_status_names, sizeof (recorder_bench_status_names) / sizeof (recorder_bench_status_names[0]));
+    recorder_bench_ffmpeg ();
+
+    if (NULL != capture)
+        recorder_bench_capture (capture);
+    else
+        printf ("No capture given with -p : stream copy is not measured\n");
+
+    if (NULL != output)
+        bench_write (output, "\"recorder_bench\":1,\"frames\":%d", nb_frames);
+
+    return (bench_nb_results () == bench_count (RECORDER_BENCH_OK)) ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+/**
+ * @file recorder_stages.c
+ * @date 2026/10/18
+ *
+ * ardrone_tool is built with RECORD_FFMPEG_VIDEO=no by default (custom.makefile),
+ * which leaves the FFmpeg recorder and stream copy stages out of the library :
+ * they are built here for the benchmark instead.
+ */
+
+#ifndef RECORD_FFMPEG_VIDEO
+#define RECORD_FFMPEG_VIDEO
+#endif
+
+#include <ardrone_tool/Video/video_stage_ffmpeg_recorder.c>
+#include <ardrone_tool/Video/video_stage_ffmpeg_remux.c>
@@ -0,0 +1,343 @@
+/**
+ * @file session_test.c
+ * @date 2026/10/18
+ *
+ * End to end test of the multi-drone sessions (ardrone_session.h) against
+ * linux_drone_simulator.
+ *
+ * One simulator process is started per drone, on consecutive loopback
+ * addresses (127.0.0.2, 127.0.0.3 ...), and all the drones are driven by the
+ * sessions of one ardrone_session_manager_t. For each drone, the test checks :
+ *  - navdata : packets are received and unpacked, the battery is reported
+ *  - configuration : the bootstrap general:navdata_demo and two queued
+ *    AT*CONFIG are acknowledged, and applied by the drone (demo mode,
+ *    navdata_options : the time option is received)
+ *  - AT commands : the drone takes off after ardrone_session_at_takeoff
+ *  - video : frames reach the video callback, in increasing order
+ *
+ * A drone which does not pass all the checks before the timeout makes the
+ * test fail : the exit code is not zero.
+ *
+ * Usage : ./linux_session_test [-n drones] [-t seconds] [-s simulator]
+ *         (simulator : linux_drone_simulator of the directory of this program by default)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <VP_Api/vp_api_thread_helper.h>
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_signal.h>
+
+#include <control_states.h>
+#include <ardrone_tool/ardrone_session.h>
+
+#define SESSION_TEST_BASE_IP        "127.0.0.2"
+#define SESSION_TEST_DRONES         4
+#define SESSION_TEST_SECONDS        15
+#define SESSION_TEST_WORKERS        2
+#define SESSION_TEST_VIDEO_FRAMES   30      // to receive before the video check passes
+#define SESSION_TEST_CONFIG_ACKS    3       // navdata_demo at bootstrap, and the two of session_test_configure
+#define SESSION_TEST_READY_MS       5000    // for the simulators to open their ports
+#define SESSION_TEST_PATH_SIZE      256
+
+typedef struct _session_test_drone_ {
+    char ip[ARDRONE_IPADDRESS_SIZE];
+    pid_t simulator;
+    ardrone_session_t session;
+    vp_os_mutex_t mutex;
+    // Filled by the callbacks
+    uint32_t navdata;
+    uint32_t state;
+    uint32_t refresh;           // last_navdata_refresh of all the packets
+    uint32_t battery;
+    uint32_t ctrl_state;
+    uint32_t video_frames;
+    uint32_t video_bytes;
+    uint32_t video_disorder;    // frames not after the previous one
+    uint32_t frame_number;
+    // Checks, in ms from the start of the sessions, 0 : not passed
+    uint32_t config_time;
+    uint32_t fly_time;
+    uint32_t video_time;
+} session_test_drone_t;
+
+static session_test_drone_t drones[ARDRONE_SESSION_MAX];
+static int nb_drones = SESSION_TEST_DRONES;
+
+// ARDrone Tool is linked but not started : the sessions have their own threads
+BEGIN_THREAD_TABLE
+END_THREAD_TABLE
+
+static uint32_t session_test_now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static void session_test_navdata (ardrone_session_t *session, const navdata_unpacked_t *navdata, void *custom)
+{
+    session_test_drone_t *drone = (session_test_drone_t *)custom;
+
+    vp_os_mutex_lock (&drone->mutex);
+    drone->navdata++;
+    drone->state = navdata->ardrone_state;
+    drone->refresh |= navdata->last_navdata_refresh;
+    if (navdata->last_navdata_refresh & NAVDATA_OPTION_MASK (NAVDATA_DEMO_TAG))
+    {
+        drone->battery = navdata->navdata_demo.vbat_flying_percentage;
+        drone->ctrl_state = navdata->navdata_demo.ctrl_state >> 16;
+    }
+    vp_os_mutex_unlock (&drone->mutex);
+}
+
+static void session_test_video (ardrone_session_t *session, const parrot_video_encapsulation_t *pave, const uint8_t *frame, void *custom)
+{
+    session_test_drone_t *drone = (session_test_drone_t *)custom;
+
+    vp_os_mutex_lock (&drone->mutex);
+    if (0 < drone->video_frames && pave->frame_number <= drone->frame_number)
+        drone->video_disorder++;
+    drone->frame_number = pave->frame_number;
+    drone->video_frames++;
+    drone->video_bytes += pave->payload_size;
+    vp_os_mutex_unlock (&drone->mutex);
+}
+
+/* linux_drone_simulator -n 1 -ip <ip>, output discarded */
+static pid_t session_test_spawn (const char *simulator, const char *ip)
+{
+    pid_t pid = fork ();
+
+    if (0 == pid)
+    {
+        int null = open ("/dev/null", O_WRONLY);
+        if (0 <= null)
+        {
+            dup2 (null, STDOUT_FILENO);
+            close (null);
+        }
+        execlp (simulator, simulator, "-n", "1", "-ip", ip, (char *)NULL);
+        _exit (127);
+    }
+    return pid;
+}
+
+/* The simulator is ready when its control port accepts connections */
+static bool_t session_test_wait_ready (const char *ip)
+{
+    struct sockaddr_in addr;
+    uint32_t start = session_test_now ();
+    int s;
+
+    vp_os_memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr (ip);
+    addr.sin_port = htons (CONTROL_PORT);
+
+    while (session_test_now () - start < SESSION_TEST_READY_MS)
+    {
+        s = socket (AF_INET, SOCK_STREAM, 0);
+        if (0 <= s && 0 == connect (s, (struct sockaddr *)&addr, sizeof (addr)))
+        {
+            close (s);
+            return TRUE;
+        }
+        if (0 <= s)
+            close (s);
+        usleep (20000);
+    }
+    return FALSE;
+}
+
+static void session_test_stop_simulators (void)
+{
+    int i;
+
+    for (i = 0; i < nb_drones; i++)
+    {
+        if (0 < drones[i].simulator)
+        {
+            kill (drones[i].simulator, SIGTERM);
+            waitpid (drones[i].simulator, NULL, 0);
+            drones[i].simulator = 0;
+        }
+    }
+}
+
+/* Checks of one drone, done when all of them passed */
+static bool_t session_test_check (session_test_drone_t *drone, uint32_t elapsed)
+{
+    const uint32_t options = NAVDATA_OPTION_MASK (NAVDATA_DEMO_TAG) | NAVDATA_OPTION_MASK (NAVDATA_TIME_TAG);
+
+    vp_os_mutex_lock (&drone->mutex);
+
+    if (0 == drone->config_time && drone->session.stats.config_acks >= SESSION_TEST_CONFIG_ACKS &&
+        (drone->state & ARDRONE_NAVDATA_DEMO_MASK) && !(drone->state & ARDRONE_NAVDATA_BOOTSTRAP) &&
+        options == (drone->refresh & options) && 0 < drone->battery)
+    {
+        drone->config_time = elapsed;
+        ardrone_session_at_takeoff (&drone->session, TRUE);
+    }
+    if (0 != drone->config_time && 0 == drone->fly_time && (drone->state & ARDRONE_FLY_MASK) &&
+        (CTRL_HOVERING == drone->ctrl_state || CTRL_FLYING == drone->ctrl_state))
+    {
+        drone->fly_time = elapsed;
+    }
+    if (0 == drone->video_time && SESSION_TEST_VIDEO_FRAMES <= drone->video_frames)
+    {
+        drone->video_time = elapsed;
+    }
+
+    vp_os_mutex_unlock (&drone->mutex);
+
+    return (0 != drone->config_time && 0 != drone->fly_time && 0 != drone->video_time) ? TRUE : FALSE;
+}
+
+static void session_test_configure (session_test_drone_t *drone)
+{
+    char value[ARDRONE_SESSION_CONFIG_STRING_SIZE];
+
+    // Acknowledged one at a time after the bootstrap general:navdata_demo
+    snprintf (value, sizeof (value), "%u", NAVDATA_OPTION_MASK (NAVDATA_DEMO_TAG) | NAVDATA_OPTION_MASK (NAVDATA_TIME_TAG));
+    ardrone_session_at_config (&drone->session, "general:navdata_options", value);
+    ardrone_session_at_config (&drone->session, "control:altitude_max", "2500");
+}
+
+int main (int argc, char *argv[])
+{
+    static ardrone_session_manager_t manager;
+    char simulator[SESSION_TEST_PATH_SIZE];
+    ardrone_session_config_t config;
+    uint32_t seconds = SESSION_TEST_SECONDS, start, elapsed = 0;
+    int option, i, done = 0, failures = 0;
+    char *slash;
+
+    snprintf (simulator, sizeof (simulator), "linux_drone_simulator");
+    slash = strrchr (argv[0], '/');
+    if (NULL != slash)
+        snprintf (simulator, sizeof (simulator), "%.*s/linux_drone_simulator", (int)(slash - argv[0]), argv[0]);
+
+    while (-1 != (option = getopt (argc, argv, "n:t:s:")))
+    {
+        switch (option)
+        {
+        case 'n':
+            nb_drones = atoi (optarg);
+            break;
+        case 't':
+            seconds = (uint32_t)atoi (optarg);
+            break;
+        case 's':
+            snprintf (simulator, sizeof (simulator), "%s", optarg);
+            break;
+        default:
+            printf ("Usage : %s [-n drones] [-t seconds] [-s simulator]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (nb_drones < 1 || nb_drones > ARDRONE_SESSION_MAX || seconds < 1)
+    {
+        printf ("1 to %d drones, at least 1 second\n", ARDRONE_SESSION_MAX);
+        return -1;
+    }
+
+    signal (SIGPIPE, SIG_IGN);
+
+    for (i = 0; i < nb_drones; i++)
+    {
+        struct in_addr addr;
+        addr.s_addr = htonl (ntohl (inet_addr (SESSION_TEST_BASE_IP)) + i);
+        strncpy (drones[i].ip, inet_ntoa (addr), ARDRONE_IPADDRESS_SIZE - 1);
+        vp_os_mutex_init (&drones[i].mutex);
+        drones[i].simulator = session_test_spawn (simulator, drones[i].ip);
+        if (0 >= drones[i].simulator)
+        {
+            printf ("Unable to start %s\n", simulator);
+            session_test_stop_simulators ();
+            return 1;
+        }
+    }
+    for (i = 0; i < nb_drones; i++)
+    {
+        if (!session_test_wait_ready (drones[i].ip))
+        {
+            printf ("%s : %s does not answer\n", drones[i].ip, simulator);
+            session_test_stop_simulators ();
+            return 1;
+        }
+    }
+
+    ardrone_session_manager_init (&manager, SESSION_TEST_WORKERS);
+    for (i = 0; i < nb_drones; i++)
+    {
+        vp_os_memset (&config, 0, sizeof (config));
+        config.ip = drones[i].ip;
+        config.navdata_demo = TRUE;
+        config.video_enable = TRUE;
+        config.navdata_cb = session_test_navdata;
+        config.video_cb = session_test_video;
+        config.custom = &drones[i];
+        if (C_OK != ardrone_session_manager_add (&manager, &drones[i].session, &config))
+        {
+            printf ("%s : unable to add the session\n", drones[i].ip);
+            session_test_stop_simulators ();
+            return 1;
+        }
+        session_test_configure (&drones[i]);
+    }
+
+    start = session_test_now ();
+    if (C_OK != ardrone_session_manager_start (&manager))
+    {
+        printf ("Unable to start the sessions\n");
+        session_test_stop_simulators ();
+        return 1;
+    }
+
+    while (done < nb_drones && elapsed < seconds * 1000)
+    {
+        usleep (50000);
+        elapsed = session_test_now () - start;
+        for (i = 0, done = 0; i < nb_drones; i++)
+        {
+            if (session_test_check (&drones[i], elapsed))
+                done++;
+        }
+    }
+
+    for (i = 0; i < nb_drones; i++)
+        ardrone_session_at_takeoff (&drones[i].session, FALSE);
+    usleep (100000);
+
+    ardrone_session_manager_stop (&manager);
+    session_test_stop_simulators ();
+
+    for (i = 0; i < nb_drones; i++)
+    {
+        session_test_drone_t *drone = &drones[i];
+        ardrone_session_stats_t *stats = &drone->session.stats;
+        bool_t passed = (0 != drone->config_time && 0 != drone->fly_time && 0 != drone->video_time && 0 == drone->video_disorder) ? TRUE : FALSE;
+
+        printf ("%-10s navdata %u (%u timeouts) | config %u acks at %u ms | flying at %u ms | video %u frames %u KB (%u dropped, %u disordered) at %u ms : %s\n",
+                drone->ip, stats->navdata_packets, stats->navdata_timeouts, stats->config_acks, drone->config_time,
+                drone->fly_time, drone->video_frames, drone->video_bytes / 1024, stats->video_dropped,
+                drone->video_disorder, drone->video_time, passed ? "ok" : "failed");
+        if (!passed)
+            failures++;
+        vp_os_mutex_destroy (&drone->mutex);
+    }
+
+    return (0 == failures) ? 0 : 1;
+}
@@ -0,0 +1,387 @@
+/**
+ * @file wiimote_input.c
+ * @date 2026/10/18
+ */
+
+#include "wiimote_input.h"
+
+#include <VP_Os/vp_os_malloc.h>
+#include <VP_Os/vp_os_print.h>
+
+#ifndef WIIMOTE_INPUT_NO_CWIID
+#include <cwiid.h>
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define WIIMOTE_INPUT_READ_EVENTS 16
+
+// Only called by the loop thread
+static void wiimote_input_publish (wiimote_input_t *input, const wiimote_snapshot_t *snapshot)
+{
+    input->sequence++;
+    __sync_synchronize ();
+    input->snapshot = *snapshot;
+    __sync_synchronize ();
+    input->sequence++;
+}
+
+void wiimote_input_snapshot (wiimote_input_t *input, wiimote_snapshot_t *snapshot)
+{
+    uint32_t sequence;
+
+    do
+    {
+        sequence = input->sequence;
+        __sync_synchronize ();
+        *snapshot = input->snapshot;
+        __sync_synchronize ();
+    }
+    while ((sequence & 1) || (sequence != input->sequence));
+}
+
+static C_RESULT wiimote_input_push (wiimote_input_t *input, wiimote_event_t *event)
+{
+    clock_gettime (CLOCK_MONOTONIC, &event->time);
+
+    // Less than PIPE_BUF : the event is written in one piece, or not at all
+    if (write (input->event_pipe[1], event, sizeof (wiimote_event_t)) != sizeof (wiimote_event_t))
+    {
+        input->dropped++;
+        return C_FAIL;
+    }
+
+    return C_OK;
+}
+
+#ifndef WIIMOTE_INPUT_NO_CWIID
+
+// cwiid callbacks have no user data, only one Wiimote is used
+static wiimote_input_t *wiimote_input_cwiid = NULL;
+
+static void wiimote_input_cwiid_callback (cwiid_wiimote_t *wiimote, int mesg_count, union cwiid_mesg mesg[], struct timespec *timestamp)
+{
+    wiimote_input_t *input = wiimote_input_cwiid;
+    int i, j;
+
+    if (NULL == input)
+        return;
+
+    for (i = 0; i < mesg_count; i++)
+    {
+        wiimote_event_t event;
+        vp_os_memset (&event, 0, sizeof (event));
+
+        switch (mesg[i].type)
+        {
+        case CWIID_MESG_BTN:
+            event.type = WIIMOTE_EVENT_BUTTONS;
+            event.buttons = mesg[i].btn_mesg.buttons;
+            break;
+
+        case CWIID_MESG_IR:
+            // NOTE: the wiimote find false positive (sometimes 1led == 4leds), and is really sensitive to sun light
+            event.type = WIIMOTE_EVENT_IR;
+            for (j = 0; j < CWIID_IR_SRC_COUNT; j++)
+            {
+                if (mesg[i].ir_mesg.src[j].valid != 0)
+                    event.nb_leds++;
+            }
+            break;
+
+        case CWIID_MESG_ACC:
+            event.type = WIIMOTE_EVENT_ACC;
+            for (j = 0; j < 3; j++)
+                event.acc[j] = mesg[i].acc_mesg.acc[j];
+            break;
+
+        case CWIID_MESG_ERROR:
+            event.type = WIIMOTE_EVENT_ERROR;
+            break;
+
+        default:
+            continue;
+        }
+
+        wiimote_input_push (input, &event);
+    }
+}
+
+static C_RESULT wiimote_input_connect (wiimote_input_t *input)
+{
+    bdaddr_t bdaddr = {{0}}; // first Wiimote found
+    cwiid_wiimote_t *wiimote;
+    wiimote_snapshot_t snapshot;
+
+    // Waits for the Wiimote a few seconds
+    if (NULL == (wiimote = cwiid_open (&bdaddr, 0)))
+    {
+        PRINT ("Unable to connect to wiimote\n");
+        return C_FAIL;
+    }
+
+    PRINT ("Wiimote found\n");
+    input->wiimote = wiimote;
+    wiimote_input_cwiid = input;
+
+    cwiid_set_mesg_callback (wiimote, wiimote_input_cwiid_callback);
+    cwiid_enable (wiimote, CWIID_FLAG_MESG_IFC);
+    cwiid_command (wiimote, CWIID_CMD_LED, CWIID_LED1_ON|CWIID_LED2_ON|CWIID_LED3_ON|CWIID_LED4_ON);
+    cwiid_command (wiimote, CWIID_CMD_RPT_MODE, CWIID_RPT_IR|CWIID_RPT_BTN|CWIID_RPT_ACC);
+
+    snapshot = input->snapshot;
+    snapshot.connected = TRUE;
+    wiimote_input_publish (input, &snapshot);
+
+    return C_OK;
+}
+
+static void wiimote_input_device_rumble (wiimote_input_t *input, bool_t rumble)
+{
+    cwiid_command ((cwiid_wiimote_t *)input->wiimote, CWIID_CMD_RUMBLE, rumble ? 1 : 0);
+}
+
+static void wiimote_input_device_close (wiimote_input_t *input)
+{
+    cwiid_close ((cwiid_wiimote_t *)input->wiimote);
+    wiimote_input_cwiid = NULL;
+}
+
+#else // WIIMOTE_INPUT_NO_CWIID : fake backend only, input->wiimote stays NULL
+
+static C_RESULT wiimote_input_connect (wiimote_input_t *input)
+{
+    return C_FAIL;
+}
+
+static void wiimote_input_device_rumble (wiimote_input_t *input, bool_t rumble)
+{
+}
+
+static void wiimote_input_device_close (wiimote_input_t *input)
+{
+}
+
+#endif // WIIMOTE_INPUT_NO_CWIID
+
+static void wiimote_input_disconnect (wiimote_input_t *input)
+{
+    wiimote_snapshot_t snapshot;
+
+    if (NULL != input->wiimote)
+    {
+        wiimote_input_device_close (input);
+        input->wiimote = NULL;
+    }
+
+    snapshot = input->snapshot;
+    snapshot.connected = (WIIMOTE_BACKEND_FAKE == input->backend);
+    snapshot.rumble = FALSE;
+    snapshot.buttons = 0;
+    snapshot.pressed = 0;
+    wiimote_input_publish (input, &snapshot);
+}
+
+static void wiimote_input_arm (int fd, uint32_t duration_ms)
+{
+    struct itimerspec value;
+    vp_os_memset (&value, 0, sizeof (value));
+
+    value.it_value.tv_sec = duration_ms / 1000;
+    value.it_value.tv_nsec = (duration_ms % 1000) * 1000000;
+    if (0 == duration_ms)
+        value.it_value.tv_nsec = 1; // 0 would disarm the timer
+
+    timerfd_settime (fd, 0, &value, NULL);
+}
+
+static bool_t wiimote_input_expired (int fd)
+{
+    uint64_t expirations = 0;
+    return (read (fd, &expirations, sizeof (expirations)) == sizeof (expirations)) && (expirations > 0);
+}
+
+static void wiimote_input_set_rumble (wiimote_input_t *input, bool_t rumble)
+{
+    wiimote_snapshot_t snapshot = input->snapshot;
+
+    if (NULL != input->wiimote)
+        wiimote_input_device_rumble (input, rumble);
+
+    snapshot.rumble = rumble;
+    wiimote_input_publish (input, &snapshot);
+}
+
+void wiimote_input_rumble (wiimote_input_t *input, uint32_t duration_ms)
+{
+    wiimote_input_set_rumble (input, TRUE);
+    wiimote_input_arm (input->rumble_fd, duration_ms);
+}
+
+void wiimote_input_set_timer (wiimote_input_t *input, uint32_t duration_ms)
+{
+    wiimote_input_arm (input->timer_fd, duration_ms);
+}
+
+static void wiimote_input_report (wiimote_input_t *input, const wiimote_event_t *event)
+{
+    wiimote_snapshot_t snapshot = input->snapshot;
+
+    if (WIIMOTE_EVENT_ERROR == event->type)
+    {
+        PRINT ("Wiimote disconnected\n");
+        wiimote_input_disconnect (input);
+        return;
+    }
+
+    snapshot.reports++;
+    snapshot.time = event->time;
+    snapshot.pressed = 0;
+
+    switch (event->type)
+    {
+    case WIIMOTE_EVENT_BUTTONS:
+        snapshot.pressed = event->buttons & ~snapshot.buttons;
+        snapshot.buttons = event->buttons;
+        break;
+
+    case WIIMOTE_EVENT_IR:
+        snapshot.nb_leds = event->nb_leds;
+        break;
+
+    case WIIMOTE_EVENT_ACC:
+        vp_os_memcpy (snapshot.acc, event->acc, sizeof (snapshot.acc));
+        break;
+
+    default:
+        break;
+    }
+
+    wiimote_input_publish (input, &snapshot);
+
+    if (NULL != input->handler)
+        input->handler (input, WIIMOTE_INPUT_REPORT, &snapshot, input->user_data);
+}
+
+C_RESULT wiimote_input_open (wiimote_input_t *input, WIIMOTE_BACKEND backend, wiimote_input_handler_t handler, void *user_data)
+{
+    vp_os_memset (input, 0, sizeof (wiimote_input_t));
+    input->backend = backend;
+    input->handler = handler;
+    input->user_data = user_data;
+    input->event_pipe[0] = input->event_pipe[1] = input->rumble_fd = input->timer_fd = -1;
+
+#ifdef WIIMOTE_INPUT_NO_CWIID
+    if (WIIMOTE_BACKEND_CWIID == backend)
+    {
+        PRINT ("Built without cwiid, only the fake backend is available\n");
+        return C_FAIL;
+    }
+#endif
+
+    if (0 != pipe (input->event_pipe))
+        return C_FAIL;
+
+    // The backend never waits for a late loop
+    fcntl (input->event_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl (input->event_pipe[1], F_SETFL, O_NONBLOCK);
+
+    input->rumble_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK);
+    input->timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (input->rumble_fd < 0 || input->timer_fd < 0)
+    {
+        wiimote_input_close (input);
+        return C_FAIL;
+    }
+
+    input->snapshot.connected = (WIIMOTE_BACKEND_FAKE == backend);
+
+    return C_OK;
+}
+
+void wiimote_input_close (wiimote_input_t *input)
+{
+    if (NULL != input->wiimote)
+    {
+        wiimote_input_device_rumble (input, FALSE);
+        wiimote_input_disconnect (input);
+    }
+
+    if (input->event_pipe[0] >= 0)
+        close (input->event_pipe[0]);
+    if (input->event_pipe[1] >= 0)
+        close (input->event_pipe[1]);
+    if (input->rumble_fd >= 0)
+        close (input->rumble_fd);
+    if (input->timer_fd >= 0)
+        close (input->timer_fd);
+
+    input->event_pipe[0] = input->event_pipe[1] = input->rumble_fd = input->timer_fd = -1;
+}
+
+C_RESULT wiimote_input_run (wiimote_input_t *input, volatile int *active)
+{
+    wiimote_event_t events[WIIMOTE_INPUT_READ_EVENTS];
+    struct pollfd fds[3];
+    ssize_t size;
+    int i;
+
+    while (*active)
+    {
+        if (WIIMOTE_BACKEND_CWIID == input->backend && NULL == input->wiimote)
+        {
+            if (C_OK != wiimote_input_connect (input))
+                continue;
+        }
+
+        fds[0].fd = input->event_pipe[0];
+        fds[1].fd = input->rumble_fd;
+        fds[2].fd = input->timer_fd;
+        for (i = 0; i < 3; i++)
+        {
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+
+        if (poll (fds, 3, WIIMOTE_INPUT_POLL_MS) < 0)
+        {
+            if (EINTR == errno)
+                continue;
+            return C_FAIL;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            while ((size = read (input->event_pipe[0], events, sizeof (events))) > 0)
+            {
+                for (i = 0; i < size / (ssize_t)sizeof (wiimote_event_t); i++)
+                    wiimote_input_report (input, &events[i]);
+            }
+        }
+
+        if ((fds[1].revents & POLLIN) && wiimote_input_expired (input->rumble_fd))
+            wiimote_input_set_rumble (input, FALSE);
+
+        if ((fds[2].revents & POLLIN) && wiimote_input_expired (input->timer_fd) && (NULL != input->handler))
+        {
+            wiimote_snapshot_t snapshot = input->snapshot;
+            input->handler (input, WIIMOTE_INPUT_TIMER, &snapshot, input->user_data);
+        }
+    }
+
+    return C_OK;
+}
+
+C_RESULT wiimote_input_fake_push (wiimote_input_t *input, const wiimote_event_t *event)
+{
+    wiimote_event_t copy = *event;
+
+    if (WIIMOTE_BACKEND_FAKE != input->backend)
+        return C_FAIL;
+
+    return wiimote_input_push (input, &copy);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file wiimote_input.h
+ * @date 2026/10/18
+ *
+ * Event driven Wiimote input.
+ *
+ * The backend writes each report of the device in a pipe (from the cwiid
+ * thread, or from the caller of wiimote_input_fake_push). wiimote_input_run
+ * polls this pipe and two timerfds : nothing blocks between two reports,
+ * the rumble is stopped and the game timer expires from the same loop.
+ *
+ * After each report the input state is published as a timestamped snapshot.
+ * The loop is the only writer; any thread can read the last snapshot with
+ * wiimote_input_snapshot, without a mutex (seqlock).
+ *
+ * Built with WIIMOTE_INPUT_NO_CWIID, only the fake backend is available and
+ * cwiid is not needed (wiimote_test).
+ */
+
+#ifndef _WIIMOTE_INPUT_H_
+#define _WIIMOTE_INPUT_H_
+
+#include <VP_Os/vp_os_types.h>
+#include <time.h>
+
+#define WIIMOTE_INPUT_POLL_MS 100 // the loop checks its active flag at least this often
+
+typedef enum _WIIMOTE_BACKEND_ {
+    WIIMOTE_BACKEND_CWIID = 0,
+    WIIMOTE_BACKEND_FAKE         // reports are given by wiimote_input_fake_push, for tests without device
+} WIIMOTE_BACKEND;
+
+typedef enum _WIIMOTE_EVENT_TYPE_ {
+    WIIMOTE_EVENT_BUTTONS = 0,
+    WIIMOTE_EVENT_IR,
+    WIIMOTE_EVENT_ACC,
+    WIIMOTE_EVENT_ERROR          // the device is disconnected
+} WIIMOTE_EVENT_TYPE;
+
+// One report of the device
+typedef struct _wiimote_event_ {
+    uint32_t type;               // WIIMOTE_EVENT_TYPE
+    uint32_t buttons;            // CWIID_BTN_* held
+    int32_t  nb_leds;            // valid IR sources
+    uint8_t  acc[3];
+    struct timespec time;        // CLOCK_MONOTONIC, set when the report is received
+} wiimote_event_t;
+
+// Input state after the last report
+typedef struct _wiimote_snapshot_ {
+    uint32_t reports;            // 0 while no report was received
+    bool_t   connected;
+    bool_t   rumble;
+    uint32_t buttons;
+    uint32_t pressed;            // buttons pressed by the last report
+    int32_t  nb_leds;
+    uint8_t  acc[3];
+    struct timespec time;        // of the last report
+} wiimote_snapshot_t;
+
+typedef enum _WIIMOTE_INPUT_REASON_ {
+    WIIMOTE_INPUT_REPORT = 0,
+    WIIMOTE_INPUT_TIMER          // timer armed with wiimote_input_set_timer expired
+} WIIMOTE_INPUT_REASON;
+
+typedef struct _wiimote_input_ wiimote_input_t;
+
+// Called from the loop, after the snapshot is published
+typedef void (*wiimote_input_handler_t) (wiimote_input_t *input, WIIMOTE_INPUT_REASON reason, const wiimote_snapshot_t *snapshot, void *user_data);
+
+struct _wiimote_input_ {
+    WIIMOTE_BACKEND backend;
+    wiimote_input_handler_t handler;
+    void *user_data;
+    uint32_t dropped;            // reports lost because the loop was late
+
+    // INTERNAL
+    void *wiimote;               // cwiid_wiimote_t
+    int event_pipe[2];
+    int rumble_fd;
+    int timer_fd;
+    volatile uint32_t sequence;  // odd while the snapshot is written
+    wiimote_snapshot_t snapshot;
+};
+
+C_RESULT wiimote_input_open (wiimote_input_t *input, WIIMOTE_BACKEND backend, wiimote_input_handler_t handler, void *user_data);
+void wiimote_input_close (wiimote_input_t *input);
+
+/**
+ * Event loop, returns when *active becomes 0.
+ * With the cwiid backend, it connects (again) to the Wiimote when needed.
+ */
+C_RESULT wiimote_input_run (wiimote_input_t *input, volatile int *active);
+
+/**
+ * Starts the rumble for duration_ms, without blocking. Called from the handler.
+ */
+void wiimote_input_rumble (wiimote_input_t *input, uint32_t duration_ms);
+
+/**
+ * One shot timer : the handler is called with WIIMOTE_INPUT_TIMER after duration_ms.
+ * Arming it again replaces the previous duration.
+ */
+void wiimote_input_set_timer (wiimote_input_t *input, uint32_t duration_ms);
+
+/**
+ * Copy of the last snapshot, from any thread
+ */
+void wiimote_input_snapshot (wiimote_input_t *input, wiimote_snapshot_t *snapshot);
+
+/**
+ * Fake backend : gives a report to the loop. The time of the event is set here.
+ * @return C_FAIL if the loop is too late and the report is dropped
+ */
+C_RESULT wiimote_input_fake_push (wiimote_input_t *input, const wiimote_event_t *event);
+
+#endif // _WIIMOTE_INPUT_H_
@@ -49,6 +49,7 @@
 //King of the Hill
 #include "global_variables.h"
 #include <cwiid.h>
+#include <Wiimote/wiimote_input.h>
 //ardrone_api is needed for led animation
 #include <Soft/Common/ardrone_api.h>
 //ardrone_input is needed for drone movement
@@ -56,6 +57,9 @@
 
 int exit_program = 1;
 
+//Written by the wiimote_logic thread, snapshots can be read from any thread
+static wiimote_input_t wiimote_input;
+
 pre_stage_cfg_t precfg;
 display_stage_cfg_t dispCfg;
 
@@ -265,6 +269,7 @@ C_RESULT ardrone_tool_init_custom(void)
      *  - needSetPriority and priority are used to control the video thread priority
      *   -> if needSetPriority is set to 1, the thread will try to set its priority to "priority"
      *   -> if needSetPriority is set to 0, the thread will keep its default priority (best on PC)
+     *  - lowLatencyDecoding set to 1 decodes each H264 slice as soon as it is received
      */
     params->in_pic = in_picture;
     params->out_pic = out_picture;
@@ -272,6 +277,7 @@ C_RESULT ardrone_tool_init_custom(void)
     params->post_processing_stages_list = example_post_stages;
     params->needSetPriority = 0;
     params->priority = 0;
+    params->lowLatencyDecoding = 1;
     
     
     //set the tag detection
@@ -339,6 +345,7 @@ DEFINE_THREAD_ROUTINE(drone_logic, data){
     
     int emptiness_counter = 0;
     int shooting_counter = 0;
+    int wounded = 0;
     
     int hovering = 0; //0 hover, 1 move
     float phi = 0.0; //left/right angle. Between [-1.0,+1.0], with negatives being leftward movement
@@ -541,16 +548,16 @@ DEFINE_THREAD_ROUTINE(drone_logic, data){
             //NOTE: if the sleep remain under 2 secs it's ok. 
             //Only the hill recognition can have more, because the drone can't be hurt at that time.
             
-            //NOTE: I don't know why, but if I add this printf the condition below works
-            //printf("%d",drone_wounded);
-            
             //---BEING HIT---//
-            if(drone_wounded){
+            //NOTE: the flag is written by the score thread, it has to be read under the mutex
+            vp_os_mutex_lock(&drone_wound_mutex);
+                wounded = drone_wounded;
+                drone_wounded = 0;
+            vp_os_mutex_unlock(&drone_wound_mutex);
+            
+            if(wounded){
                 //TODO: make the drone move as if it was being shot
                 //maybe this should be moved in the flying thread
-                vp_os_mutex_lock(&drone_wound_mutex);
-                    drone_wounded = 0;
-                vp_os_mutex_unlock(&drone_wound_mutex);
                 
                 //TODO: you can choose between this animation, defined in Soft/Common/config.h
                 /*ARDRONE_ANIM_PHI_M30_DEG= 0,
@@ -577,6 +584,15 @@ DEFINE_THREAD_ROUTINE(drone_logic, data){
                 //anim_mayday_t param;
                 //ARDRONE_TOOL_CONFIGURATION_ADDEVENT (flight_anim, param, myCallback);
                 ardrone_at_set_led_animation(BLINK_GREEN_RED, 0.25, 4);
+                
+                if(debugging){
+                    //time from the wiimote report of the shot to the AT command
+                    wiimote_snapshot_t input;
+                    struct timespec now;
+                    wiimote_input_snapshot(&wiimote_input, &input);
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                    printf("INPUT TO AT LATENCY %.1f ms\n", (now.tv_sec - input.time.tv_sec) * 1000.0 + (now.tv_nsec - input.time.tv_nsec) / 1000000.0);
+                }
                 //TODO: freeze the drone for some time, also?
                 //nanosleep(&shot_rumble_time, NULL);
             }
@@ -600,159 +616,107 @@ DEFINE_THREAD_ROUTINE(field_finder, data){
     //interrupt the field searching when it's not done
 }
 
-DEFINE_THREAD_ROUTINE(wiimote_logic, data){
-    
-    //wiimote connection variables
-    static bdaddr_t bdaddr = {{0}};
-    static cwiid_wiimote_t *wiimote = NULL;
-    union cwiid_mesg *msg = NULL;
-    struct timespec timestamp;
-    
-    int wiimote_connected = 0;
-    
-    int drone_in_sight = 0;
-    int trigger_button = 0;
-    int number_of_led = 0;
-    int recharger_in_sight = 0;
-    int recharging_button = 0;
+//WIIMOTE LOGIC
+//Called by the wiimote input loop: it must not block, the rumble and the gun loading are timers
+typedef struct {
+    int bullets;
+    int gun_loaded; //0 while the gun is loading after a shot, or recharging
+    int recharging;
+    int shutdown;
+} wiimote_game_t;
+
+#define SHOT_RUMBLE_MS 1000
+#define SHOT_LOADING_MS 1000
+#define RECHARGING_MS 10000
+
+static void wiimote_game_handler(wiimote_input_t *input, WIIMOTE_INPUT_REASON reason, const wiimote_snapshot_t *snapshot, void *user_data){
+    wiimote_game_t *game = (wiimote_game_t *)user_data;
     
-    int bullets = magazine_capacity;
+    //--- TIMER: GUN LOADED OR RECHARGED ---//
+    if(reason == WIIMOTE_INPUT_TIMER){
+        if(game->recharging){
+            //TODO: How should I let the enemy know that the wiimote is full again?
+            game->bullets = magazine_capacity;
+            game->recharging = 0;
+        }
+        game->gun_loaded = 1;
+        return;
+    }
     
-    int i = 0;
-    int j = 0;
-    int msg_count = 0;
+    //TODO: this is here in case the ar.drone stop sending video update
+    if(snapshot->pressed & CWIID_BTN_HOME){
+        printf("The program will shutdown...\n");
+        
+        match_active = 0; //This tell the drone_logic thread to land the drone
+        game_active = 0; //This make all the threads exit the while loop, and the wiimote loop return
+        
+        exit_program = 0;  // Force ardrone_tool to close
+        game->shutdown = 1;
+        return;
+    }
     
-    struct timespec shot_rumble_time;
-    shot_rumble_time.tv_sec = 1;
-    shot_rumble_time.tv_nsec = 0000000;
-
-    struct timespec recharging_time;
-    recharging_time.tv_sec = 10;
-    recharging_time.tv_nsec = 0000000;
+    if(!match_active){
+        return;
+    }
     
-    while(game_active){
+    //--- WIIMOTE LOGIC ---//
+    //SHOOTING
+    if((snapshot->pressed & CWIID_BTN_B) && (game->bullets > 0) && game->gun_loaded){
+        printf("SHOOT\n");
         
-        //CONNECT TO THE WIIMOTE
-        if(wiimote_connected == 0) {
-            if( ! (wiimote = cwiid_open(&bdaddr, CWIID_FLAG_MESG_IFC)) ) {
-                printf("Unable to connect to wiimote\n");
-            } else {
-                wiimote_connected = 1;
-                printf("Wiimote found\n");
-                cwiid_command(wiimote, CWIID_CMD_LED, CWIID_LED1_ON|CWIID_LED2_ON|CWIID_LED3_ON|CWIID_LED4_ON);
-                cwiid_command(wiimote, CWIID_CMD_RPT_MODE, CWIID_RPT_IR|CWIID_RPT_BTN);
-            }
+        game->bullets--;
+        printf("lost one bullet\n");
+        
+        //haptic feedback
+        wiimote_input_rumble(input, SHOT_RUMBLE_MS);
+        
+        //NOTE: the drone is in sight if the last IR report had leds
+        if(snapshot->nb_leds > 0){
+            
+            vp_os_mutex_lock(&drone_score_mutex);
+                drone_lose_score = 1;
+            vp_os_mutex_unlock(&drone_score_mutex);
+            
+            printf("DRONE HIT\n");
             
-        //ALREADY CONNECTED
         } else {
-            if(match_active){
-                
-                //--- RESET VARIABLES ---//
-                number_of_led = 0;
-                drone_in_sight = 0;
-                recharger_in_sight = 0;
-                trigger_button = 0;
-                msg_count = 0;
-                
-                //--- GET INPUTS FROM THE WIIMOTE ---//
-                
-                //get messages (blocking)
-                cwiid_get_mesg(wiimote, &msg_count, &msg, &timestamp);
-                
-                //scan the messages for the event "pression of trigger_button" or "pression of recharging_button"
-                //and to count the number of IR leds found
-                //NOTE: the wiimote find false positive (sometimes 1led == 4leds :O)
-                //NOTE: the wiimote is REALLY sensitive to sun light
-                for(i = 0; i < msg_count; i++){
-                    
-                    if(msg[i].type == CWIID_MESG_BTN){
-                        
-                        //is button B pressed?
-                        if(msg[i].btn_mesg.buttons == CWIID_BTN_B){
-                            trigger_button = 1;
-                            printf("SHOOT\n");
-                        } else {
-                            trigger_button = 0;
-                        }
-                        
-                        //is button A pressed?
-                        if(msg[i].btn_mesg.buttons == CWIID_BTN_A){
-                            recharging_button = 1;
-                            printf("BUTTON A\n");
-                        } else {
-                            recharging_button = 0;
-                        }
-                        
-                        //TODO: this is here in case the ar.drone stop sending video update
-                        if(msg[i].btn_mesg.buttons == CWIID_BTN_HOME){
-                            printf("The program will shutdown...\n");
-                            
-                            match_active = 0; //This tell the drone_logic thread to land the drone
-                            game_active = 0; //This make all the threads exit the while loop
-                            
-                            exit_program = 0;  // Force ardrone_tool to close
-                            // Sometimes, ardrone_tool might not finish properly. 
-                            //This happens mainly because a thread is blocked on a syscall, in this case, wait 5 seconds then kill the app
-                            sleep(5);
-                            exit(0);
-                        }
-                        
-                    }
-                    
-                    //are there leds?
-                    if(msg[i].type == CWIID_MESG_IR){ 
-                        for(j = 0; j < CWIID_IR_SRC_COUNT; j++){
-                            if(msg[i].ir_mesg.src[j].valid != 0){
-                                number_of_led++;
-                            }
-                        }
-                        
-                        if(number_of_led > 0){
-                            printf("LEDS\n");
-                            drone_in_sight = 1;
-                        } else {
-                            drone_in_sight = 0;
-                        }
-                    }
-                }
-                
-                //--- WIIMOTE LOGIC ---//
-                //SHOOTING
-                if((bullets > 0) && trigger_button){
-                    
-                    bullets--;
-                    printf("lost one bullet\n");
-                    
-                    //haptic feedback
-                    cwiid_command(wiimote, CWIID_CMD_RUMBLE, 1);
-                    nanosleep(&shot_rumble_time, NULL);
-                    cwiid_command(wiimote, CWIID_CMD_RUMBLE, 0);
-                    
-                    if(drone_in_sight){
-                        
-                        vp_os_mutex_lock(&drone_score_mutex);
-                            drone_lose_score = 1;
-                        vp_os_mutex_unlock(&drone_score_mutex);
-                        
-                        printf("DRONE HIT\n");
-                        
-                    } else {
-                        printf("DRONE MISSED!!\n");
-                    }
-                    
-                    //This is to limit the frequency of shooting (i.e. the gun need to load)
-                    nanosleep(&shot_rumble_time, NULL);
-                    
-                //you can recharge only if you don't have bullets any more
-                } else if(bullets < 1){
-                    if(recharging_button){
-                        //TODO: How should I let the enemy know that the wiimote is full again?
-                        nanosleep(&recharging_time, NULL);
-                        bullets = magazine_capacity;
-                    }
-                }
-            }
+            printf("DRONE MISSED!!\n");
         }
+        
+        //This is to limit the frequency of shooting (i.e. the gun need to load)
+        game->gun_loaded = 0;
+        wiimote_input_set_timer(input, SHOT_LOADING_MS);
+        
+    //you can recharge only if you don't have bullets any more
+    } else if((snapshot->pressed & CWIID_BTN_A) && (game->bullets < 1) && !game->recharging){
+        printf("BUTTON A\n");
+        game->recharging = 1;
+        game->gun_loaded = 0;
+        wiimote_input_set_timer(input, RECHARGING_MS);
+    }
+}
+
+DEFINE_THREAD_ROUTINE(wiimote_logic, data){
+    
+    wiimote_game_t game;
+    game.bullets = magazine_capacity;
+    game.gun_loaded = 1;
+    game.recharging = 0;
+    game.shutdown = 0;
+    
+    if(wiimote_input_open(&wiimote_input, WIIMOTE_BACKEND_CWIID, wiimote_game_handler, &game) != C_OK){
+        printf("Unable to open the wiimote input\n");
+        return C_FAIL;
+    }
+    
+    //Returns when game_active is reset
+    wiimote_input_run(&wiimote_input, &game_active);
+    
+    if(game.shutdown){
+        // Sometimes, ardrone_tool might not finish properly. 
+        //This happens mainly because a thread is blocked on a syscall, in this case, wait 5 seconds then kill the app
+        sleep(5);
+        exit(0);
     }
     
     return C_OK;
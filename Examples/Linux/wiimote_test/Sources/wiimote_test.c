@@ -0,0 +1,459 @@
+/**
+ * @file wiimote_test.c
+ * @date 2026/10/18
+ *
+ * Test of the Wiimote input loop of video_demo (Wiimote/wiimote_input.h)
+ * with the fake backend, and latency from a button press to its AT command.
+ *
+ * A thread pushes presses of the B button, with accelerometer reports in
+ * between like a Wiimote in CWIID_RPT_ACC mode. For each press, the handler
+ * queues an AT*LED command, the press number being its duration, as
+ * drone_logic does when the drone is hit. The AT commands go through the
+ * AT codec of ARDrone Tool, its socket being opened by this test without
+ * the Wi-Fi setup of ardrone_tool_init. The drone is a UDP socket on the AT
+ * port of the address given with -a, which timestamps each AT*LED.
+ * The latency of a press is measured from the time of its report.
+ *
+ * Cases :
+ *  - at_refresh : the AT commands are sent every ARDRONE_REFRESH_MS by
+ *                 another thread, like ardrone_tool_update
+ *  - at_flush   : the handler sends the AT commands itself
+ *  - rumble     : a press starts the rumble, the reports are still handled
+ *                 while it is on and its timer stops it
+ * For the AT cases, every press has to reach the drone within
+ * WIIMOTE_TEST_TIMEOUT_MS and no report may be dropped. The latencies from
+ * the report to the handler and to the drone are printed (median, 99th
+ * percentile and max, in us).
+ *
+ * Each case prints ok or FAILED, the exit code is the number of failed cases.
+ *
+ * Usage : ./linux_wiimote_test [-n presses] [-p ms between presses] [-a drone address] [-v]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <VP_Api/vp_api_thread_helper.h>
+#include <VP_Os/vp_os_malloc.h>
+
+#include <ATcodec/ATcodec_api.h>
+
+#include <ardrone_api.h>
+#include <ardrone_tool/ardrone_tool.h>
+
+#include <Wiimote/wiimote_input.h>
+
+#define WIIMOTE_TEST_PRESSES        200
+#define WIIMOTE_TEST_MAX_PRESSES    10000
+#define WIIMOTE_TEST_PRESS_MS       10      // between two presses
+#define WIIMOTE_TEST_ACC_REPORTS    4       // between a press and its release, and after the release
+#define WIIMOTE_TEST_BUTTON         0x0004  // CWIID_BTN_B
+#define WIIMOTE_TEST_TIMEOUT_MS     500     // for the AT commands to reach the drone
+#define WIIMOTE_TEST_RUMBLE_MS      50
+#define WIIMOTE_TEST_DATAGRAM_SIZE  1024
+
+typedef struct _wiimote_test_case_ {
+    bool_t flush;               // the handler sends the AT commands
+    bool_t rumble;              // a press starts the rumble
+    uint32_t presses;           // handled
+    uint64_t report_ns[WIIMOTE_TEST_MAX_PRESSES];   // time of the report of each press
+    uint64_t handler_ns[WIIMOTE_TEST_MAX_PRESSES];
+    uint64_t at_ns[WIIMOTE_TEST_MAX_PRESSES];       // received by the drone, 0 until then
+} wiimote_test_case_t;
+
+static wiimote_input_t input;
+static wiimote_test_case_t test_case;
+static int nb_presses = WIIMOTE_TEST_PRESSES;
+static int press_ms = WIIMOTE_TEST_PRESS_MS;
+static const char *address = "127.0.0.1";
+static int verbose = 0;
+
+static int drone_socket = -1;
+static int at_socket = -1;
+static volatile int loop_active;
+static volatile int refresh_active;
+static volatile int drone_active;
+static volatile uint32_t drone_received;
+
+// No ARDrone Tool thread
+BEGIN_THREAD_TABLE
+END_THREAD_TABLE
+
+static uint64_t wiimote_test_ns (const struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * 1000000000ULL + ts->tv_nsec;
+}
+
+static uint64_t wiimote_test_now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return wiimote_test_ns (&ts);
+}
+
+static void wiimote_test_sleep_ms (int ms)
+{
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000;
+    nanosleep (&ts, NULL);
+}
+
+static bool_t wiimote_test_result (const char *name, bool_t ok)
+{
+    printf ("%-14s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+/********************************************************************
+ * Input loop
+ ********************************************************************/
+
+static void wiimote_test_handler (wiimote_input_t *in, WIIMOTE_INPUT_REASON reason, const wiimote_snapshot_t *snapshot, void *user_data)
+{
+    wiimote_test_case_t *c = (wiimote_test_case_t *)user_data;
+    uint32_t press = c->presses;
+
+    if (WIIMOTE_INPUT_REPORT != reason || !(snapshot->pressed & WIIMOTE_TEST_BUTTON) || WIIMOTE_TEST_MAX_PRESSES <= press)
+        return;
+
+    c->report_ns[press] = wiimote_test_ns (&snapshot->time);
+    c->handler_ns[press] = wiimote_test_now ();
+    c->presses++;
+
+    if (c->rumble)
+    {
+        wiimote_input_rumble (in, WIIMOTE_TEST_RUMBLE_MS);
+        return;
+    }
+
+    ardrone_at_set_led_animation (BLINK_GREEN_RED, 0.25, press);
+    if (c->flush)
+        ardrone_at_send ();
+}
+
+static void *wiimote_test_loop (void *arg)
+{
+    wiimote_input_run (&input, &loop_active);
+    return NULL;
+}
+
+/* Stand-in for ardrone_tool_update, which sends the queued AT commands every ARDRONE_REFRESH_MS */
+static void *wiimote_test_refresh (void *arg)
+{
+    while (refresh_active)
+    {
+        ardrone_at_send ();
+        wiimote_test_sleep_ms (ARDRONE_REFRESH_MS);
+    }
+    return NULL;
+}
+
+static void wiimote_test_push (uint32_t type, uint32_t buttons)
+{
+    wiimote_event_t event;
+
+    vp_os_memset (&event, 0, sizeof (event));
+    event.type = type;
+    event.buttons = buttons;
+    event.acc[0] = event.acc[1] = event.acc[2] = 0x80;
+    wiimote_input_fake_push (&input, &event);
+}
+
+/* Presses of the button, released after a few accelerometer reports */
+static void wiimote_test_presses (void)
+{
+    int i, j;
+
+    for (i = 0; i < nb_presses; i++)
+    {
+        wiimote_test_push (WIIMOTE_EVENT_BUTTONS, WIIMOTE_TEST_BUTTON);
+        for (j = 0; j < WIIMOTE_TEST_ACC_REPORTS; j++)
+            wiimote_test_push (WIIMOTE_EVENT_ACC, WIIMOTE_TEST_BUTTON);
+        wiimote_test_push (WIIMOTE_EVENT_BUTTONS, 0);
+        for (j = 0; j < WIIMOTE_TEST_ACC_REPORTS; j++)
+            wiimote_test_push (WIIMOTE_EVENT_ACC, 0);
+        wiimote_test_sleep_ms (press_ms);
+    }
+}
+
+/********************************************************************
+ * Drone
+ ********************************************************************/
+
+static bool_t wiimote_test_drone_open (void)
+{
+    struct sockaddr_in name;
+    struct timeval timeout = { 0, 10000 };
+
+    vp_os_memset (&name, 0, sizeof (name));
+    name.sin_family = AF_INET;
+    name.sin_port = htons (AT_PORT);
+    name.sin_addr.s_addr = inet_addr (address);
+
+    drone_socket = socket (AF_INET, SOCK_DGRAM, 0);
+    if (0 > drone_socket || 0 != bind (drone_socket, (struct sockaddr *)&name, sizeof (name)))
+    {
+        printf ("Unable to listen on %s:%d (%s)\n", address, AT_PORT, strerror (errno));
+        return FALSE;
+    }
+
+    setsockopt (drone_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+    return TRUE;
+}
+
+/* UDP socket of the AT codec, connected to the drone */
+static AT_CODEC_ERROR_CODE wiimote_test_at_open (void)
+{
+    struct sockaddr_in name;
+
+    vp_os_memset (&name, 0, sizeof (name));
+    name.sin_family = AF_INET;
+    name.sin_port = htons (AT_PORT);
+    name.sin_addr.s_addr = inet_addr (address);
+
+    at_socket = socket (AF_INET, SOCK_DGRAM, 0);
+    if (0 > at_socket || 0 != connect (at_socket, (struct sockaddr *)&name, sizeof (name)))
+        return AT_CODEC_OPEN_ERROR;
+    return AT_CODEC_OPEN_OK;
+}
+
+static AT_CODEC_ERROR_CODE wiimote_test_at_close (void)
+{
+    if (0 <= at_socket)
+        close (at_socket);
+    at_socket = -1;
+    return AT_CODEC_CLOSE_OK;
+}
+
+static AT_CODEC_ERROR_CODE wiimote_test_at_write (uint8_t *buffer, int32_t *len)
+{
+    return (send (at_socket, buffer, *len, 0) == *len) ? AT_CODEC_WRITE_OK : AT_CODEC_WRITE_ERROR;
+}
+
+/* Timestamps the AT*LED commands received, until drone_active is reset */
+static void *wiimote_test_drone (void *arg)
+{
+    char datagram[WIIMOTE_TEST_DATAGRAM_SIZE + 1];
+
+    while (drone_active)
+    {
+        ssize_t size = recv (drone_socket, datagram, WIIMOTE_TEST_DATAGRAM_SIZE, 0);
+        uint64_t now = wiimote_test_now ();
+        const char *ptr = datagram;
+        int sequence, anim, freq, press;
+
+        if (0 >= size)
+            continue;
+        datagram[size] = '\0';
+
+        while (NULL != (ptr = strstr (ptr, "AT*LED=")))
+        {
+            ptr += strlen ("AT*LED=");
+            if (4 == sscanf (ptr, "%d,%d,%d,%d", &sequence, &anim, &freq, &press) &&
+                0 <= press && press < nb_presses && 0 == test_case.at_ns[press])
+            {
+                test_case.at_ns[press] = now;
+                drone_received++;
+            }
+        }
+    }
+    return NULL;
+}
+
+/********************************************************************
+ * Cases
+ ********************************************************************/
+
+static int wiimote_test_compare (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Median, 99th percentile and max of the delays from the reports, in us */
+static void wiimote_test_print_latency (const char *name, const uint64_t *to_ns)
+{
+    uint64_t *delays = (uint64_t *)vp_os_malloc (nb_presses * sizeof (uint64_t));
+    int i;
+
+    if (NULL == delays)
+        return;
+
+    for (i = 0; i < nb_presses; i++)
+        delays[i] = to_ns[i] - test_case.report_ns[i];
+    qsort (delays, nb_presses, sizeof (uint64_t), wiimote_test_compare);
+
+    printf ("  %-10s median %8.1f us  p99 %8.1f us  max %8.1f us\n", name,
+            delays[nb_presses / 2] / 1e3, delays[(nb_presses * 99) / 100] / 1e3, delays[nb_presses - 1] / 1e3);
+    vp_os_free (delays);
+}
+
+static bool_t wiimote_test_at (const char *name, bool_t flush)
+{
+    pthread_t loop, refresh, drone;
+    uint64_t timeout;
+    uint32_t dropped;
+    bool_t ok;
+    int i, missing = 0;
+
+    vp_os_memset (&test_case, 0, sizeof (test_case));
+    test_case.flush = flush;
+    if (C_OK != wiimote_input_open (&input, WIIMOTE_BACKEND_FAKE, wiimote_test_handler, &test_case))
+        return wiimote_test_result (name, FALSE);
+
+    loop_active = 1;
+    refresh_active = !flush;
+    drone_active = 1;
+    drone_received = 0;
+    pthread_create (&drone, NULL, wiimote_test_drone, NULL);
+    pthread_create (&loop, NULL, wiimote_test_loop, NULL);
+    if (refresh_active)
+        pthread_create (&refresh, NULL, wiimote_test_refresh, NULL);
+
+    wiimote_test_presses ();
+
+    timeout = wiimote_test_now () + WIIMOTE_TEST_TIMEOUT_MS * 1000000ULL;
+    while (drone_received < (uint32_t)nb_presses && wiimote_test_now () < timeout)
+        wiimote_test_sleep_ms (1);
+    drone_active = 0;
+    pthread_join (drone, NULL);
+
+    loop_active = 0;
+    pthread_join (loop, NULL);
+    if (refresh_active)
+    {
+        refresh_active = 0;
+        pthread_join (refresh, NULL);
+    }
+    dropped = input.dropped;
+    wiimote_input_close (&input);
+
+    for (i = 0; i < nb_presses; i++)
+        missing += (0 == test_case.at_ns[i]) ? 1 : 0;
+
+    ok = (test_case.presses == (uint32_t)nb_presses) && (0 == missing) && (0 == dropped);
+    wiimote_test_result (name, ok);
+
+    if (ok)
+    {
+        wiimote_test_print_latency ("handler", test_case.handler_ns);
+        wiimote_test_print_latency ("drone", test_case.at_ns);
+    }
+    else
+    {
+        printf ("  %u presses handled of %d, %d not received by the drone, %u reports dropped\n",
+                test_case.presses, nb_presses, missing, dropped);
+    }
+
+    return ok;
+}
+
+static bool_t wiimote_test_rumble (void)
+{
+    wiimote_snapshot_t before, during, after;
+    pthread_t loop;
+    bool_t ok;
+    int i;
+
+    vp_os_memset (&test_case, 0, sizeof (test_case));
+    test_case.rumble = TRUE;
+    if (C_OK != wiimote_input_open (&input, WIIMOTE_BACKEND_FAKE, wiimote_test_handler, &test_case))
+        return wiimote_test_result ("rumble", FALSE);
+
+    loop_active = 1;
+    pthread_create (&loop, NULL, wiimote_test_loop, NULL);
+
+    wiimote_test_push (WIIMOTE_EVENT_BUTTONS, WIIMOTE_TEST_BUTTON);
+    wiimote_test_sleep_ms (WIIMOTE_TEST_RUMBLE_MS / 5);
+    wiimote_input_snapshot (&input, &before);
+
+    // Reports handled while the rumble is on
+    for (i = 0; i < WIIMOTE_TEST_ACC_REPORTS; i++)
+        wiimote_test_push (WIIMOTE_EVENT_ACC, WIIMOTE_TEST_BUTTON);
+    wiimote_test_sleep_ms (WIIMOTE_TEST_RUMBLE_MS / 5);
+    wiimote_input_snapshot (&input, &during);
+
+    wiimote_test_sleep_ms (WIIMOTE_TEST_RUMBLE_MS * 2);
+    wiimote_input_snapshot (&input, &after);
+
+    loop_active = 0;
+    pthread_join (loop, NULL);
+    wiimote_input_close (&input);
+
+    ok = before.rumble && during.rumble && !after.rumble &&
+         (during.reports == before.reports + WIIMOTE_TEST_ACC_REPORTS);
+    wiimote_test_result ("rumble", ok);
+
+    if (verbose || !ok)
+        printf ("  rumble %d %d %d, reports %u %u\n", before.rumble, during.rumble, after.rumble, before.reports, during.reports);
+
+    return ok;
+}
+
+int main (int argc, char *argv[])
+{
+    AT_CODEC_FUNCTIONS_PTRS at_funcs;
+    int option, failures = 0;
+
+    while (-1 != (option = getopt (argc, argv, "n:p:a:v")))
+    {
+        switch (option)
+        {
+        case 'n':
+            nb_presses = atoi (optarg);
+            break;
+        case 'p':
+            press_ms = atoi (optarg);
+            break;
+        case 'a':
+            address = optarg;
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        default:
+            printf ("Usage : %s [-n presses] [-p ms between presses] [-a drone address] [-v]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    if (nb_presses < 1 || nb_presses > WIIMOTE_TEST_MAX_PRESSES || press_ms < 0)
+    {
+        printf ("1 to %d presses\n", WIIMOTE_TEST_MAX_PRESSES);
+        return -1;
+    }
+
+    // The drone listens before the AT socket is connected to it
+    if (!wiimote_test_drone_open ())
+        return -1;
+
+    vp_os_memset (&at_funcs, 0, sizeof (at_funcs));
+    at_funcs.open = wiimote_test_at_open;
+    at_funcs.close = wiimote_test_at_close;
+    at_funcs.write = wiimote_test_at_write;
+
+    ardrone_at_init_with_funcs (address, strlen (address), &at_funcs);
+    if (ATCODEC_TRUE != ardrone_at_open ())
+    {
+        printf ("Unable to open the AT socket\n");
+        return -1;
+    }
+
+    failures += !wiimote_test_at ("at_refresh", FALSE);
+    failures += !wiimote_test_at ("at_flush", TRUE);
+    failures += !wiimote_test_rumble ();
+
+    wiimote_test_at_close ();
+    close (drone_socket);
+
+    return failures;
+}